@@ -1578,6 +1578,7 @@ static void cmd_serve_mg_uri_callback(struct mg_connection *conn, const struct m
 			mg_get_header(conn,"User-Agent"),
 			request_info->post_data_len,
             mg_get_header(conn,"From"),
+			NULL,
 			NULL,
 			&pRequestHandle,
 			&pResponseHandle);
@@ -1605,6 +1606,7 @@ static void cmd_serve_mg_uri_callback(struct mg_connection *conn, const struct m
 			mg_get_header(conn, "User-Agent"),
             mg_get_header(conn,"From"),
 			mg_get_header(conn,"If-Modified-Since"),
+			mg_get_header(conn,"If-None-Match"),
 			&pResponseHandle);
 	}
 
@@ -2968,6 +2970,10 @@ void do_cmd_blobcount(SG_context * pCtx, const char* psz_descriptor_name)
     SG_uint64 total_blob_size_all_full = 0;
     SG_uint64 total_blob_size_all_encoded = 0;
     SG_int_to_string_buffer buf;
+    SG_vhash* pvh_chain_depths = NULL;
+    SG_uint32 count_depths = 0;
+    SG_uint32 count_printed = 0;
+    SG_uint32 i;
 
 	SG_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, psz_descriptor_name, &pRepo)  );
 
@@ -2981,7 +2987,8 @@ void do_cmd_blobcount(SG_context * pCtx, const char* psz_descriptor_name)
                 &total_blob_size_zlib_full,
                 &total_blob_size_zlib_encoded,
                 &total_blob_size_vcdiff_full,
-                &total_blob_size_vcdiff_encoded)  );
+                &total_blob_size_vcdiff_encoded,
+                &pvh_chain_depths)  );
 
     printf("full\n");
     printf("%12s  %d\n", "count", count_blobs_full);
@@ -3019,9 +3026,29 @@ void do_cmd_blobcount(SG_context * pCtx, const char* psz_descriptor_name)
     printf("%12s  %12s\n", "encoded", SG_int64_to_sz(total_blob_size_all_encoded,buf));
     printf("%12s  %d%%\n", "saved", (int) ((total_blob_size_all_full - total_blob_size_all_encoded) / (double) total_blob_size_all_full * 100.0));
 
+    printf("chain depth\n");
+    SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_chain_depths, &count_depths)  );
+    /* the keys are depths, so walk them in numeric order */
+    for (i=0; count_printed < count_depths; i++)
+    {
+        char buf_depth[16];
+        SG_bool b_has = SG_FALSE;
+        SG_int64 count = 0;
+
+        SG_ERR_CHECK(  SG_sprintf(pCtx, buf_depth, sizeof(buf_depth), "%d", (int) i)  );
+        SG_ERR_CHECK(  SG_vhash__has(pCtx, pvh_chain_depths, buf_depth, &b_has)  );
+        if (b_has)
+        {
+            SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh_chain_depths, buf_depth, &count)  );
+            printf("%12s  %12s\n", buf_depth, SG_int64_to_sz(count, buf));
+            count_printed++;
+        }
+    }
+
     /* fall through */
 
 fail:
+    SG_VHASH_NULLFREE(pCtx, pvh_chain_depths);
     SG_REPO_NULLFREE(pCtx, pRepo);
 }
 
@@ -110,6 +110,9 @@ typedef struct _SG_jsonparser   SG_jsonparser;
 #include <sg_context_typedefs.h>
 #include <sg_dagnode_typedefs.h>
 #include <sg_dagfrag_typedefs.h>
+#include <sg_dagindex_typedefs.h>
+#include <sg_objcache_typedefs.h>
+#include <sg_fetch_pool_typedefs.h>
 #include <sg_zing_typedefs.h>
 #include <sg_dbrecord_typedefs.h>
 #include <sg_repo_typedefs.h>
@@ -134,6 +137,7 @@ typedef struct _SG_jsonparser   SG_jsonparser;
 #include <sg_lib_typedefs.h>
 #include <sg_utf8_typedefs.h>
 #include <sg_localsettings_typedefs.h>
+#include <sg_sqlite_typedefs.h>
 #include <sg_dag_sqlite3_typedefs.h>
 #include <sg_pendingdb_typedefs.h>
 #include <sg_dbndx_typedefs.h>
@@ -163,6 +167,8 @@ typedef struct _SG_jsonparser   SG_jsonparser;
 #include <sg_uridispatch_typedefs.h>
 #include <sg_xmlwriter_typedefs.h>
 #include <sg_mutex_typedefs.h>
+#include <sg_thread_typedefs.h>
+#include <sg_work_queue_typedefs.h>
 #include <sg_history.h>
 #include <sg_tag.h>
 #include <sg_version.h>
@@ -173,6 +179,8 @@ typedef struct _SG_jsonparser   SG_jsonparser;
 // headers that build upon basic types and/or reference opaque types.
 
 #include <sg_mutex_prototypes.h>
+#include <sg_thread_prototypes.h>
+#include <sg_work_queue_prototypes.h>
 #include <sg_error_prototypes.h>
 #include <sg_context_prototypes.h>
 #include <sg_jsglue_prototypes.h>
@@ -210,6 +218,9 @@ typedef struct _SG_jsonparser   SG_jsonparser;
 #include <sg_wd_plan_prototypes.h>
 #include <sg_sqlite_prototypes.h>
 #include <sg_dagfrag_prototypes.h>
+#include <sg_dagindex_prototypes.h>
+#include <sg_objcache_prototypes.h>
+#include <sg_fetch_pool_prototypes.h>
 #include <sg_daglca_prototypes.h>
 #include <sg_dagnode_prototypes.h>
 #include <sg_dagquery_prototypes.h>
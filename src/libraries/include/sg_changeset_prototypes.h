@@ -45,10 +45,18 @@ BEGIN_EXTERN_C;
 void SG_changeset__alloc__committing(SG_context * pCtx, SG_uint32 iDagNum, SG_changeset ** ppNew);
 
 /**
- * Free a Changeset from memory.
+ * Free a Changeset from memory.  If the Changeset is shared (see
+ * SG_changeset__addref()) this only drops your reference.
  */
 void SG_changeset__free(SG_context * pCtx, SG_changeset * pChangeset);
 
+/**
+ * Add a reference to a frozen Changeset.  Each reference is dropped with
+ * SG_changeset__free().  Changesets returned by SG_changeset__load_from_repo()
+ * may be shared with the repo's object cache.
+ */
+void SG_changeset__addref(SG_context * pCtx, SG_changeset * pChangeset);
+
 void SG_changeset__get_dagnum(SG_context * pCtx, const SG_changeset * pChangeset, SG_uint32 * piDagNum);
 
 //////////////////////////////////////////////////////////////////
@@ -365,6 +373,27 @@ void SG_changeset__get_treepaths(
     SG_vhash** ppvh
 	);
 
+/**
+ * Find the trail the blob-list normalization uses: a path back through
+ * the DAG from psz_csid_from to its ancestor psz_csid_to, listed starting
+ * next to psz_csid_to and ending with psz_csid_from.  Parents are tried
+ * in dagnode order, so this is the first such path in that order.
+ *
+ * pnr_expanded (optional) returns how many changesets had their parents
+ * walked, even when no trail is found; changesets at or below the
+ * generation of psz_csid_to never are.
+ *
+ * This is only exported for the tests.
+ */
+void SG_changeset_debug__find_dag_trail(
+        SG_context* pCtx,
+        SG_repo* pRepo,
+        const char* psz_csid_from,
+        const char* psz_csid_to,
+        SG_stringarray** ppsa,
+        SG_uint32* pnr_expanded
+        );
+
 END_EXTERN_C;
 
 #endif//H_SG_CHANGESET_PROTOTYPES_H
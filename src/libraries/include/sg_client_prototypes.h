@@ -50,6 +50,16 @@ void SG_client__push_add(
         SG_vhash** ppResult
         );
 
+// Like SG_client__push_add, but the fragball is sent as it is read from the stream, so it never
+// has to be written to disk on this side.  SG_client takes ownership of the stream.
+void SG_client__push_add__stream(
+		SG_context* pCtx,
+		SG_client * pClient,
+        SG_client_push_handle* pPush,
+        SG_fragball_stream** ppFragballStream,
+        SG_vhash** ppResult
+        );
+
 void SG_client__push_remove(
 		SG_context* pCtx,
 		SG_client * pClient,
@@ -88,6 +98,17 @@ void SG_client__pull_request_fragball(
 		SG_vhash** ppvhStatus
         );
 
+// Like SG_client__pull_request_fragball, but the fragball is written to pFragballStream as it
+// arrives, so it never has to be written out and read back on this side.  The caller still owns
+// the stream and closes it afterward.
+void SG_client__pull_request_fragball__stream(
+		SG_context* pCtx,
+		SG_client* pClient,
+		SG_vhash* pvhRequest,
+		SG_writestream* pFragballStream,
+		SG_vhash** ppvhStatus
+        );
+
 void SG_client__pull_clone(
 	SG_context* pCtx,
 	SG_client* pClient,
@@ -57,6 +57,16 @@ SG_error SG_context__err__generic(SG_context* pCtx, SG_error new_err, const char
 */
 SG_error SG_context__err_replace(SG_context* pCtx, SG_error new_err, const char * szFileName, int iLine);
 
+/**
+* Copy the error state (error code, description and stack trace) of pCtxSrc into pCtxDest.
+* This is how an error raised on a worker thread (which has its own context) is handed back
+* to the thread that is waiting for it.  Follow it with SG_ERR_RETHROW to add the current frame.
+* pCtxSrc must currently indicate an error state; pCtxDest must be non-null and NOT currently
+* indicate an error state.
+* The return code indicates the success or failure of copying the error state and should not be propagated.
+*/
+SG_error SG_context__err_copy(SG_context* pCtxDest, const SG_context* pCtxSrc);
+
 /**
 * Add information to an error state, printf-style.  This sets the same field as szDescription in SG_context__err.
 * This method exists primarily so error-handling  macros can have an argument that gets passed entirely to it,
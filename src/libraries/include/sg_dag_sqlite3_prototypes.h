@@ -35,9 +35,13 @@ void SG_dag_sqlite3__create(SG_context* pCtx, const SG_pathname* pPath, sqlite3*
 
 void SG_dag_sqlite3__nullclose(SG_context* pCtx, sqlite3** ppsql);
 
-void SG_dag_sqlite3__store_dagnode(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, const SG_dagnode * pDagnode);
+/**
+ * pCache is the prepared statement cache kept by the owner of psql.
+ * It may be NULL.
+ */
+void SG_dag_sqlite3__store_dagnode(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, SG_uint32 iDagNum, const SG_dagnode * pDagnode);
 
-void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, const char* pszidHidChangeset, SG_dagnode ** ppNewDagnode);
+void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, const char* pszidHidChangeset, SG_dagnode ** ppNewDagnode);
 
 void SG_dag_sqlite3__list_dags(SG_context* pCtx, sqlite3* psql, SG_uint32* piCount, SG_uint32** paDagNums);
 
@@ -59,6 +63,7 @@ void SG_dag_sqlite3__insert_frag(
 void SG_dag_sqlite3__check_frag(
     SG_context* pCtx,
 	sqlite3* psql,
+	sg_sqlite__stmt_cache* pCache,
     SG_dagfrag * pFrag,
 	SG_bool * pbConnected,
     SG_rbtree ** ppIdsetMissing,
@@ -79,6 +84,19 @@ void SG_dag_sqlite3__get_lca(
     SG_daglca ** ppDagLca
     );
 
+/**
+ * Load the shape of the entire DAG (every dagnode, its generation and
+ * its parent edges) into a frozen SG_dagindex.
+ *
+ * You must free the returned index.
+ */
+void SG_dag_sqlite3__get_dagindex(
+	SG_context* pCtx,
+	sqlite3* psql,
+    SG_uint32 iDagNum,
+    SG_dagindex ** ppIndex
+    );
+
 void SG_dag_sqlite3__find_by_prefix(SG_context* pCtx, sqlite3*, SG_uint32 iDagNum, const char* psz_hid_prefix, SG_rbtree** pprb);
 
 END_EXTERN_C;
@@ -0,0 +1,179 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_dagindex_prototypes.h
+ *
+ * @details
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_DAGINDEX_PROTOTYPES_H
+#define H_SG_DAGINDEX_PROTOTYPES_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate an empty DAGINDEX for the given DAGNUM.  The count is
+ * only a hint for how many dagnodes will be added.
+ *
+ * Populate it with __add_node() and __add_edge() and then call
+ * __freeze() before asking it any questions.
+ */
+void SG_dagindex__alloc(SG_context * pCtx,
+						SG_dagindex ** ppNew,
+						SG_uint32 iDagNum,
+						SG_uint32 count_nodes_hint);
+
+void SG_dagindex__free(SG_context * pCtx, SG_dagindex * pIndex);
+
+/**
+ * Add a dagnode.  It is not an error to add the same HID twice;
+ * the second add is ignored.
+ */
+void SG_dagindex__add_node(SG_context * pCtx,
+						   SG_dagindex * pIndex,
+						   const char * pszHid,
+						   SG_int32 generation);
+
+/**
+ * Add a child-->parent edge.  Both dagnodes must already have been added.
+ */
+void SG_dagindex__add_edge(SG_context * pCtx,
+						   SG_dagindex * pIndex,
+						   const char * pszHidChild,
+						   const char * pszHidParent);
+
+/**
+ * Fold the members of a DAGFRAG into the index.  This is how we keep
+ * an index coherent with the repo when new dagnodes are stored.  The
+ * index is re-frozen afterwards.
+ *
+ * Throws SG_ERR_NOT_FOUND if a member refers to a parent that is
+ * neither in the index nor in the fragment; the caller should then
+ * discard the index and rebuild it.
+ */
+void SG_dagindex__add_dagfrag(SG_context * pCtx,
+							  SG_dagindex * pIndex,
+							  SG_dagfrag * pFrag);
+
+/**
+ * Build the parent and child adjacency arrays from the edges that
+ * have been added.  This may be called again after more nodes/edges
+ * have been added.
+ */
+void SG_dagindex__freeze(SG_context * pCtx, SG_dagindex * pIndex);
+
+//////////////////////////////////////////////////////////////////
+
+void SG_dagindex__get_dagnum(SG_context * pCtx, const SG_dagindex * pIndex, SG_uint32 * piDagNum);
+
+void SG_dagindex__count(SG_context * pCtx, const SG_dagindex * pIndex, SG_uint32 * pCount);
+
+/**
+ * Map a HID to its integer id.  If the HID is not in the index,
+ * *pbFound is set to false.
+ */
+void SG_dagindex__lookup(SG_context * pCtx,
+						 const SG_dagindex * pIndex,
+						 const char * pszHid,
+						 SG_bool * pbFound,
+						 SG_uint32 * piNode);
+
+/**
+ * Get the HID of a node.  You do not own the returned string and
+ * it is only valid until the index is changed.
+ */
+void SG_dagindex__get_hid_ref(SG_context * pCtx,
+							  const SG_dagindex * pIndex,
+							  SG_uint32 iNode,
+							  const char ** ppszHid);
+
+void SG_dagindex__get_generation(SG_context * pCtx,
+								 const SG_dagindex * pIndex,
+								 SG_uint32 iNode,
+								 SG_int32 * pGen);
+
+/**
+ * Get the ids of the parents (or children) of a node.  You do not
+ * own the returned array and it is only valid until the index is changed.
+ */
+void SG_dagindex__get_parents(SG_context * pCtx,
+							  const SG_dagindex * pIndex,
+							  SG_uint32 iNode,
+							  SG_uint32 * pCount,
+							  const SG_uint32 ** paParents);
+
+void SG_dagindex__get_children(SG_context * pCtx,
+							   const SG_dagindex * pIndex,
+							   SG_uint32 iNode,
+							   SG_uint32 * pCount,
+							   const SG_uint32 ** paChildren);
+
+/**
+ * Is iAncestor a (proper or improper) ancestor of iDescendant?
+ *
+ * This walks parent edges back from iDescendant, but never below the
+ * generation of iAncestor.
+ *
+ * This and __find_descendant_leaves() share scratch space kept in the
+ * index, so neither may be called on an index that another thread is
+ * using.
+ */
+void SG_dagindex__is_ancestor(SG_context * pCtx,
+							  const SG_dagindex * pIndex,
+							  SG_uint32 iAncestor,
+							  SG_uint32 iDescendant,
+							  SG_bool * pbResult);
+
+/**
+ * Find the leaves (nodes without children) that are descendants of
+ * iStart (including iStart itself if it is a leaf).  The HIDs are
+ * added as keys to the given rbtree.
+ *
+ * If stop_after is non-zero, we stop as soon as more than that many
+ * leaves have been found.
+ */
+void SG_dagindex__find_descendant_leaves(SG_context * pCtx,
+										 const SG_dagindex * pIndex,
+										 SG_uint32 iStart,
+										 SG_uint32 stop_after,
+										 SG_rbtree * prbLeaves,
+										 SG_uint32 * pCountFound);
+
+/**
+ * Allocate a (frozen) dagnode for the given HID using only the
+ * information in the index.  Throws SG_ERR_NOT_FOUND if the HID is
+ * not in the index.
+ *
+ * This matches FN__sg_fetch_dagnode (with the index as the data
+ * pointer) so it can be handed to SG_daglca__alloc().
+ */
+void SG_dagindex__fetch_dagnode(SG_context * pCtx,
+								void * pVoidIndex,
+								const char * pszHid,
+								SG_dagnode ** ppNewDagnode);
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_DAGINDEX_PROTOTYPES_H
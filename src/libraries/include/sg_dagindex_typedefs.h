@@ -0,0 +1,45 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_dagindex_typedefs.h
+ *
+ * @details A DAGINDEX is a compact, read-mostly, in-memory copy of the
+ * shape of an entire DAG (one DAGNUM).  Each dagnode is given a dense
+ * integer id [0..count) and we keep the generation and the parent/child
+ * edges in flat arrays indexed by that id.  This lets the LCA code, the
+ * dagquery code and the dag walker answer questions without a SQL round
+ * trip (and a fresh SG_dagnode) for every node they touch.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_DAGINDEX_TYPEDEFS_H
+#define H_SG_DAGINDEX_TYPEDEFS_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+typedef struct _SG_dagindex SG_dagindex;
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_DAGINDEX_TYPEDEFS_H
@@ -79,10 +79,19 @@ BEGIN_EXTERN_C;
 void SG_dagnode__alloc(SG_context* pCtx, SG_dagnode ** ppNew, const char* pszidHidChangeset, SG_int32 generation);
 
 /**
- * Free a DAGNODE memory object.
+ * Free a DAGNODE memory object.  If the dagnode is shared (see
+ * SG_dagnode__addref()) this only drops your reference.
  */
 void SG_dagnode__free(SG_context * pCtx, SG_dagnode * pdn);
 
+/**
+ * Add a reference to a frozen DAGNODE.  Each reference is dropped
+ * with SG_dagnode__free().  Dagnodes returned by SG_repo__fetch_dagnode()
+ * may be shared with the repo's object cache, so they must not be
+ * modified.
+ */
+void SG_dagnode__addref(SG_context * pCtx, SG_dagnode * pdn);
+
 //////////////////////////////////////////////////////////////////
 
 /**
@@ -90,6 +90,11 @@ struct _SG_diff_functions
     void (*token_discard)(void * pDiffBaton, void * pToken);
 
     void (*token_discard_all)(void * pDiffBaton);
+
+    // Optional (but without it SG_diff degrades to comparing every new token
+    // against every distinct token seen so far).  Tokens that are equal
+    // according to token_compare must have the same hash.
+    SG_uint32 (*token_hash)(void * pDiffBaton, void * pToken);
 };
 typedef struct _SG_diff_functions SG_diff_functions; // Formerly "svn_diff_fns_t"
 
@@ -0,0 +1,109 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_fetch_pool_prototypes.h
+ *
+ * @details
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_FETCH_POOL_PROTOTYPES_H
+#define H_SG_FETCH_POOL_PROTOTYPES_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate a FETCH_POOL for the given repo.  Each worker opens its
+ * own instance of the repo.  On a machine with only one processor no
+ * threads are started and each file is written synchronously by
+ * SG_fetch_pool__add() using pRepo.
+ *
+ * pRepo must outlive the pool.
+ */
+void SG_fetch_pool__alloc(SG_context * pCtx,
+						  SG_repo * pRepo,
+						  SG_fetch_pool ** ppNew);
+
+/**
+ * Free the pool.  If SG_fetch_pool__finish() has not been called,
+ * the workers are told to stop after the file they are writing and
+ * the rest of the queue is abandoned.
+ */
+void SG_fetch_pool__free(SG_context * pCtx, SG_fetch_pool * pPool);
+
+/**
+ * Queue a file to be created at pPath (which must not already exist)
+ * with the contents of the given blob.  The file is preallocated to
+ * the length of the blob before it is written.
+ *
+ * With SG_FETCH_POOL_FLAGS__ATTRIBUTES, attrBits and pszHidXattrs
+ * (which may be NULL) are applied to the file once it is written.
+ * With SG_FETCH_POOL_FLAGS__TIMESTAMP, the file is stat'd at the end
+ * and the result is available from SG_fetch_pool__get_timestamp().
+ *
+ * *piItem (optional) is set to the index of this file in the pool.
+ */
+void SG_fetch_pool__add(SG_context * pCtx,
+						SG_fetch_pool * pPool,
+						const SG_pathname * pPath,
+						SG_fsobj_perms perms,
+						const char * pszHidBlob,
+						SG_fetch_pool_flags flags,
+						SG_int64 attrBits,
+						const char * pszHidXattrs,
+						SG_uint32 * piItem);
+
+/**
+ * Wait for the oldest file that hasn't been handed back yet to be
+ * written and return its index.  Files come back in the order they
+ * were added.  *pbFound is false when every file added so far has
+ * been handed back.  Throws the error of a file that failed.
+ *
+ * A caller that doesn't want the files can ignore this.
+ */
+void SG_fetch_pool__next_done(SG_context * pCtx,
+							  SG_fetch_pool * pPool,
+							  SG_uint32 * piItem,
+							  SG_bool * pbFound);
+
+/**
+ * Wait for every queued file to be written.  If any of them failed,
+ * this throws the first error seen (with its description and stack).
+ * Nothing may be added after this.
+ */
+void SG_fetch_pool__finish(SG_context * pCtx, SG_fetch_pool * pPool);
+
+/**
+ * After SG_fetch_pool__finish(), get the mtime of a file queued with
+ * SG_FETCH_POOL_FLAGS__TIMESTAMP and the clock when it was stat'd.
+ */
+void SG_fetch_pool__get_timestamp(SG_context * pCtx,
+								  const SG_fetch_pool * pPool,
+								  SG_uint32 iItem,
+								  SG_int64 * pMTime_ms,
+								  SG_int64 * pClock_ms);
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_FETCH_POOL_PROTOTYPES_H
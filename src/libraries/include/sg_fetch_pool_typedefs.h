@@ -0,0 +1,51 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_fetch_pool_typedefs.h
+ *
+ * @details A FETCH_POOL writes blobs from a repo into files on disk
+ * using a pool of worker threads.  Each worker has its own repo
+ * instance, so fetching, decoding (zlib/vcdiff) and writing happen
+ * in parallel while the caller's thread carries on queueing more
+ * files.  The caller's thread remains the only one that touches
+ * the pendingtree or anything else that isn't thread-safe.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_FETCH_POOL_TYPEDEFS_H
+#define H_SG_FETCH_POOL_TYPEDEFS_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+typedef struct _SG_fetch_pool SG_fetch_pool;
+
+typedef SG_uint32 SG_fetch_pool_flags;
+
+#define SG_FETCH_POOL_FLAGS__NONE			((SG_fetch_pool_flags)0x0000)
+#define SG_FETCH_POOL_FLAGS__ATTRIBUTES		((SG_fetch_pool_flags)0x0001)	// apply attrbits and xattrs once the file is written
+#define SG_FETCH_POOL_FLAGS__TIMESTAMP		((SG_fetch_pool_flags)0x0002)	// stat the file when done, for the timestamp cache
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_FETCH_POOL_TYPEDEFS_H
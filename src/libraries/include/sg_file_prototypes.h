@@ -44,6 +44,13 @@ void SG_file__seek_end(SG_context*, SG_file* pFile, SG_uint64 * piPos);  // seek
 
 void SG_file__truncate(SG_context*, SG_file* pFile);
 
+/**
+ * Ask the filesystem to reserve room for iLength bytes before we write
+ * them, so a large file comes out in fewer extents.  The file size is
+ * not changed.  Failure is not an error; this is only a hint.
+ */
+void SG_file__preallocate(SG_context*, SG_file* pFile, SG_uint64 iLength);
+
 void SG_file__tell(SG_context*, SG_file* pFile, SG_uint64* piPos);
 
 void SG_file__read(SG_context*, SG_file* pFile, SG_uint32 iNumBytesWanted, SG_byte* pBytes, SG_uint32* piNumBytesRetrieved /*optional*/);
@@ -69,6 +76,24 @@ void SG_file__fsync(SG_context*, SG_file* pFile);
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * Map iLength bytes of the file, starting at iOffset, read-only into
+ * memory.  *ppData points at the byte at iOffset and stays valid until
+ * the mapping is freed with SG_file__munmap().  The file handle may be
+ * closed while the mapping is still in use.
+ *
+ * The offset need not be page-aligned.  A zero length is an error.
+ */
+void SG_file__mmap(SG_context*, SG_file* pFile, SG_uint64 iOffset, SG_uint64 iLength, SG_file_mapping** ppMapping, const SG_byte** ppData);
+
+/**
+ * Unmap and free a mapping created by SG_file__mmap() and null the
+ * caller's copy.
+ */
+void SG_file__munmap(SG_context*, SG_file_mapping** ppMapping);
+
+//////////////////////////////////////////////////////////////////
+
 /**
  * Close the given file and null the pointer.
  *
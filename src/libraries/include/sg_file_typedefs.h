@@ -50,6 +50,11 @@ typedef SG_uint32 SG_file_flags;
 
 #define SG_FILE_LOCK			((SG_file_flags)0x0200)	// request a lock on the file
 
+//////////////////////////////////////////////////////////////////
+// a read-only memory mapping of part of a file.  see SG_file__mmap().
+
+typedef struct _SG_file_mapping SG_file_mapping;
+
 END_EXTERN_C;
 
 #endif//H_SG_FILE_TYPEDEFS_H
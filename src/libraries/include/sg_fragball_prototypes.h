@@ -58,6 +58,45 @@ void SG_fragball__free(SG_context* pCtx, SG_pathname* pPath_fragball);
 void SG_fragball_writer__alloc(SG_context * pCtx, SG_repo* pRepo, const SG_pathname* pPathFragball, SG_bool bCreateNewFile, SG_fragball_writer** ppResult);
 void SG_fragball_writer__free(SG_context * pCtx, SG_fragball_writer* pfb);
 
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate a fragball stream.  Add frags and blobs to it, then read
+ * it (directly or through an SG_readstream) to get the same bytes
+ * SG_fragball__create() and friends would have written to a file.
+ * Blob payloads are fetched from the repo only as they are read.
+ *
+ * Nothing may be added once reading has started.
+ */
+void SG_fragball_stream__alloc(SG_context * pCtx, SG_repo* pRepo, SG_fragball_stream** ppNew);
+void SG_fragball_stream__free(SG_context * pCtx, SG_fragball_stream* pfs);
+
+void SG_fragball_stream__add_frag(SG_context * pCtx, SG_fragball_stream* pfs, SG_dagfrag* pFrag);
+void SG_fragball_stream__add_dagnodes(SG_context * pCtx, SG_fragball_stream* pfs, SG_uint32 iDagNum, SG_rbtree* prb_ids);
+void SG_fragball_stream__add_blobs(SG_context * pCtx, SG_fragball_stream* pfs, const char* const* pasz_blob_hids, SG_uint32 countHids);
+
+/**
+ * The total number of bytes the stream will produce.
+ */
+void SG_fragball_stream__get_length(SG_context * pCtx, const SG_fragball_stream* pfs, SG_uint64* pLen);
+
+/**
+ * This is an SG_stream__func__read; pUnderlying is the SG_fragball_stream.
+ */
+void SG_fragball_stream__read(
+	SG_context * pCtx,
+	void* pUnderlying,
+	SG_uint32 iNumBytesWanted,
+	SG_byte* pBytes,
+	SG_uint32* piNumBytesRetrieved,
+	SG_bool* pb_done);
+
+/**
+ * Wrap a fragball stream in an SG_readstream.  The readstream takes
+ * ownership: closing it frees the fragball stream.
+ */
+void SG_fragball_stream__alloc_readstream(SG_context * pCtx, SG_fragball_stream** ppfs, SG_readstream** ppStream);
+
 END_EXTERN_C;
 
 #endif //H_SG_FRAGBALL_PROTOTYPES_H
@@ -27,6 +27,12 @@ BEGIN_EXTERN_C;
 
 typedef struct _sg_fragball_writer SG_fragball_writer;
 
+/**
+ * Produces the bytes of a fragball on demand, pulling blobs from
+ * the repo as they are read.  See SG_fragball_stream__alloc().
+ */
+typedef struct _sg_fragball_stream SG_fragball_stream;
+
 END_EXTERN_C;
 
 #endif//H_SG_FRAGBALL_TYPEDEFS_H
@@ -87,6 +87,13 @@ void SG_fsobj__rmdir_recursive__pathname(SG_context * pCtx, const SG_pathname *
 void SG_fsobj__chmod__pathname(SG_context * pCtx, const SG_pathname * pPathname, SG_fsobj_perms perms_sg);
 void SG_fsobj__move__pathname_pathname(SG_context * pCtx, const SG_pathname * pPathnameOld, const SG_pathname * pPathnameNew);
 
+/**
+ * Move a file to a new pathname, failing if anything already exists
+ * there (just like SG_file__open__pathname() with SG_FILE_CREATE_NEW).
+ * SG_fsobj__move__pathname_pathname() would silently replace it.
+ */
+void SG_fsobj__move_new_file__pathname_pathname(SG_context * pCtx, const SG_pathname * pPathnameOld, const SG_pathname * pPathnameNew);
+
 SG_bool		SG_fsobj__equivalent_perms(SG_fsobj_perms p1, SG_fsobj_perms p2);
 
 // TODO SG_fsobj__symlink() fails if the link already exists.  Should we have
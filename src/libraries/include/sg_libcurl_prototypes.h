@@ -55,12 +55,20 @@ void SG_curl__free_headers(SG_context* pCtx, struct curl_slist* pHeaderList);
 void SG_curl__state_file__alloc(SG_context* pCtx, SG_curl_state_file** ppState);
 void SG_curl__state_file__free(SG_context* pCtx, SG_curl_state_file* pState);
 
+void SG_curl__state_readstream__alloc(SG_context* pCtx, SG_curl_state_readstream** ppState);
+void SG_curl__state_readstream__free(SG_context* pCtx, SG_curl_state_readstream* pState);
+
+void SG_curl__state_writestream__alloc(SG_context* pCtx, SG_curl_state_writestream** ppState);
+void SG_curl__state_writestream__free(SG_context* pCtx, SG_curl_state_writestream* pState);
+
 void SG_curl__state_string__alloc(SG_context* pCtx, SG_curl_state_string** ppState);
 void SG_curl__state_string__alloc__reserve(SG_context* pCtx, SG_uint32 lenReserved, SG_curl_state_string** ppState);
 void SG_curl__state_string__free(SG_context* pCtx, SG_curl_state_string* pState);
 
 size_t SG_curl__send_file_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState);
+size_t SG_curl__send_readstream_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState);
 size_t SG_curl__receive_file_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState);
+size_t SG_curl__receive_writestream_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState);
 size_t SG_curl__receive_string_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState);
 
 void SG_curl__throw_on_non200(SG_context* pCtx, CURL* pCurl);
@@ -84,6 +92,16 @@ void SG_curl__perform(SG_context* pCtx, CURL* pCurl, SG_context* pRequestCtx, SG
 																SG_ASSERT(!SG_context__has_err(pCtx)); \
 																SG_context__pop_level(pCtx); p=NULL;  )
 
+#define SG_CURL_STATE_READSTREAM_NULLFREE(pCtx,p)	SG_STATEMENT(	SG_context__push_level(pCtx); \
+																SG_curl__state_readstream__free(pCtx,p); \
+																SG_ASSERT(!SG_context__has_err(pCtx)); \
+																SG_context__pop_level(pCtx); p=NULL;  )
+
+#define SG_CURL_STATE_WRITESTREAM_NULLFREE(pCtx,p)	SG_STATEMENT(	SG_context__push_level(pCtx); \
+																SG_curl__state_writestream__free(pCtx,p); \
+																SG_ASSERT(!SG_context__has_err(pCtx)); \
+																SG_context__pop_level(pCtx); p=NULL;  )
+
 #define SG_CURL_STATE_STRING_NULLFREE(pCtx,p)	SG_STATEMENT(	SG_context__push_level(pCtx); \
 																SG_curl__state_string__free(pCtx,p); \
 																SG_ASSERT(!SG_context__has_err(pCtx)); \
@@ -31,6 +31,18 @@ typedef struct
 	SG_file* pFile;
 } SG_curl_state_file;
 
+typedef struct
+{
+	SG_context* pCtx;
+	SG_readstream* pStream;
+} SG_curl_state_readstream;
+
+typedef struct
+{
+	SG_context* pCtx;
+	SG_writestream* pStream;	// not owned: the caller closes it
+} SG_curl_state_writestream;
+
 typedef struct
 {
 	SG_context* pCtx;
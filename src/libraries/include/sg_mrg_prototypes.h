@@ -116,6 +116,26 @@ void SG_mrg__preview(SG_context * pCtx, SG_mrg * pMrg,
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * Make the next SG_mrg__compute_merge() load the complete version control
+ * tree of every CSET rather than skipping the contents of directories that
+ * are identical in all of them.  The result should be the same either way;
+ * this lets the tests prove it.  Must be called before computing the merge.
+ */
+void SG_mrg_debug__set_load_entire_csets(SG_context * pCtx,
+										 SG_mrg * pMrg,
+										 SG_bool bLoadEntireCSets);
+
+/**
+ * Return the number of directories whose contents the merge did not load
+ * because they were identical in all of the CSETs.
+ */
+void SG_mrg_debug__get_nr_dirs_pruned(SG_context * pCtx,
+									  const SG_mrg * pMrg,
+									  SG_uint32 * pNrDirsPruned);
+
+//////////////////////////////////////////////////////////////////
+
 END_EXTERN_C;
 
 #endif//H_SG_MRG_PROTOTYPES_H
@@ -23,6 +23,7 @@ BEGIN_EXTERN_C
 #define SG_CHANGESET_NULLFREE(pCtx,p)             SG_STATEMENT(SG_context__push_level(pCtx);             SG_changeset__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_CLIENT_NULLFREE(pCtx,p)                SG_STATEMENT(SG_context__push_level(pCtx);          SG_client__close_free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_CONTEXT_NULLFREE(p)                    SG_STATEMENT(                                            SG_context__free(p);                                                                           p=NULL;)
+#define SG_DAGINDEX_NULLFREE(pCtx,p)              SG_STATEMENT(SG_context__push_level(pCtx);              SG_dagindex__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_DAGFRAG_NULLFREE(pCtx,p)               SG_STATEMENT(SG_context__push_level(pCtx);               SG_dagfrag__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_DAGLCA_NULLFREE(pCtx,p)                SG_STATEMENT(SG_context__push_level(pCtx);                SG_daglca__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_DAGLCA_ITERATOR_NULLFREE(pCtx,p)       SG_STATEMENT(SG_context__push_level(pCtx);      SG_daglca__iterator__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
@@ -32,6 +33,7 @@ BEGIN_EXTERN_C
 #define SG_DIFF_NULLFREE(pCtx,p)                  SG_STATEMENT(SG_context__push_level(pCtx);                  SG_diff__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_EXEC_ARGVEC_NULLFREE(pCtx,p)           SG_STATEMENT(SG_context__push_level(pCtx);           SG_exec_argvec__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_FRAGBALL_NULLFREE(pCtx, p)             SG_STATEMENT(SG_context__push_level(pCtx);              SG_fragball__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
+#define SG_FRAGBALL_STREAM_NULLFREE(pCtx, p)     SG_STATEMENT(SG_context__push_level(pCtx);              SG_fragball_stream__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_INV_DIRS_NULLFREE(pCtx,p)              SG_STATEMENT(SG_context__push_level(pCtx);              SG_inv_dirs__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_INV_ENTRY_NULLFREE(pCtx,p)             SG_STATEMENT(SG_context__push_level(pCtx);             SG_inv_entry__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_JSONPARSER_NULLFREE(pCtx,p)            SG_STATEMENT(SG_context__push_level(pCtx);            SG_jsonparser__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
@@ -39,6 +41,9 @@ BEGIN_EXTERN_C
 #define SG_JSONDB_NULLFREE(pCtx,p)                SG_STATEMENT(SG_context__push_level(pCtx);          SG_jsondb__close_free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_MRG_NULLFREE(pCtx,p)                   SG_STATEMENT(SG_context__push_level(pCtx);                   SG_mrg__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_NULLFREE(pCtx,p)                       SG_STATEMENT(SG_context__push_level(pCtx);                        SG_free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
+#define SG_OBJCACHE_NULLFREE(pCtx,p)              SG_STATEMENT(SG_context__push_level(pCtx);              SG_objcache__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
+#define SG_FETCH_POOL_NULLFREE(pCtx,p)            SG_STATEMENT(SG_context__push_level(pCtx);              SG_fetch_pool__free(pCtx, p); SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
+#define SG_WORK_QUEUE_NULLFREE(pCtx,p)            SG_STATEMENT(SG_context__push_level(pCtx);              SG_work_queue__free(pCtx, p); SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_PATHNAME_NULLFREE(pCtx,p)              SG_STATEMENT(SG_context__push_level(pCtx);              SG_pathname__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_PENDINGDB_NULLFREE(pCtx,p)             SG_STATEMENT(SG_context__push_level(pCtx);             SG_pendingdb__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_PENDINGTREE_NULLFREE(pCtx,p)           SG_STATEMENT(SG_context__push_level(pCtx);           SG_pendingtree__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
@@ -48,6 +53,7 @@ BEGIN_EXTERN_C
 #define SG_RBTREE_ITERATOR_NULLFREE(pCtx,p)       SG_STATEMENT(SG_context__push_level(pCtx);      SG_rbtree__iterator__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_REPO_NULLFREE(pCtx,p)                  SG_STATEMENT(SG_context__push_level(pCtx);                  SG_repo__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_SERVER_NULLFREE(pCtx,p)                SG_STATEMENT(SG_context__push_level(pCtx);                SG_server__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
+#define SG_SQLITE_STMT_CACHE_NULLFREE(pCtx,p)     SG_STATEMENT(SG_context__push_level(pCtx);                sg_sqlite__stmt_cache__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_STAGING_NULLFREE(pCtx,p)               SG_STATEMENT(SG_context__push_level(pCtx);               SG_staging__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_STRING_NULLFREE(pCtx,p)                SG_STATEMENT(SG_context__push_level(pCtx);                SG_string__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
 #define SG_STRINGARRAY_NULLFREE(pCtx,p)           SG_STATEMENT(SG_context__push_level(pCtx);           SG_stringarray__free(pCtx, p);   SG_ASSERT(!SG_context__has_err(pCtx));SG_context__pop_level(pCtx);p=NULL;)
@@ -0,0 +1,114 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_objcache_prototypes.h
+ *
+ * @details
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_OBJCACHE_PROTOTYPES_H
+#define H_SG_OBJCACHE_PROTOTYPES_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate an empty OBJCACHE.  When adding an object would take the
+ * cache over either limit, the least recently used objects are
+ * dropped.  The sizes are only estimates (we use the length of the
+ * serialized form) and are supplied by whoever adds the object.
+ */
+void SG_objcache__alloc(SG_context * pCtx,
+						SG_objcache ** ppNew,
+						SG_uint64 max_bytes,
+						SG_uint32 max_count);
+
+void SG_objcache__free(SG_context * pCtx, SG_objcache * pCache);
+
+/**
+ * Look up an object.  On a hit, *ppObj is set to the object and a
+ * reference is added for the caller, who should free it as usual.
+ * On a miss, *ppObj is set to NULL.
+ */
+void SG_objcache__lookup(SG_context * pCtx,
+						 SG_objcache * pCache,
+						 SG_objcache_type type,
+						 const char * pszHid,
+						 void ** ppObj);
+
+/**
+ * Add a frozen object to the cache.  The cache takes its own reference
+ * using pfnAddref and drops it with pfnFree when the object is evicted.
+ * The caller keeps their reference.  If the HID is already in the cache,
+ * nothing happens.
+ */
+void SG_objcache__add(SG_context * pCtx,
+					  SG_objcache * pCache,
+					  SG_objcache_type type,
+					  const char * pszHid,
+					  void * pObj,
+					  SG_uint32 size,
+					  SG_objcache__addref_callback * pfnAddref,
+					  SG_free_callback * pfnFree);
+
+/**
+ * Drop everything in the cache.  Objects that callers still hold
+ * are not affected.
+ */
+void SG_objcache__clear(SG_context * pCtx, SG_objcache * pCache);
+
+/**
+ * Get the hit/miss/eviction counts and the current size of the cache.
+ * You own the returned vhash.
+ */
+void SG_objcache__get_stats(SG_context * pCtx, SG_objcache * pCache, SG_vhash ** ppvhStats);
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Reference counting for shareable objects.
+ *
+ * A shareable object keeps a count of the references to it *beyond
+ * the first*, so a freshly allocated (zeroed) object has a count of
+ * zero and nothing changes for code that never shares it.  The
+ * object's __addref routine calls SG_objcache__share() and its __free
+ * routine calls SG_objcache__unshare() first and only frees the object
+ * when that returns false.
+ *
+ * The counts are protected by a single global lock, since an object
+ * may be freed by a different thread than the one which got it from
+ * the cache.
+ */
+void SG_objcache__share(SG_uint32 * pnShares);
+
+SG_bool SG_objcache__unshare(SG_uint32 * pnShares);
+
+/**
+ * Is anyone else holding a reference to this object?
+ */
+SG_bool SG_objcache__is_shared(const SG_uint32 * pnShares);
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_OBJCACHE_PROTOTYPES_H
@@ -0,0 +1,64 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_objcache_typedefs.h
+ *
+ * @details An OBJCACHE is a bounded, LRU cache of decoded, frozen
+ * objects (treenodes, changesets and dagnodes) keyed by their HID.
+ * Since these objects are immutable and content-addressed, the same
+ * memory-object can be handed to every caller that asks for it; they
+ * are reference counted so that each caller can still just free what
+ * they were given.  Each SG_repo has one.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_OBJCACHE_TYPEDEFS_H
+#define H_SG_OBJCACHE_TYPEDEFS_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+typedef struct _SG_objcache SG_objcache;
+
+/**
+ * The kinds of objects we cache.  A changeset and its dagnode have
+ * the same HID, so the type is part of the key.
+ */
+typedef enum
+{
+	SG_OBJCACHE_TYPE__TREENODE	= 't',
+	SG_OBJCACHE_TYPE__CHANGESET	= 'c',
+	SG_OBJCACHE_TYPE__DAGNODE	= 'd'
+} SG_objcache_type;
+
+/**
+ * Add a reference to a cached object.  This must not fail.  The
+ * object's free routine is expected to drop one reference and only
+ * really free the object when the last one goes away.  See
+ * SG_objcache__share().
+ */
+typedef void (SG_objcache__addref_callback)(SG_context * pCtx, void * pObj);
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_OBJCACHE_TYPEDEFS_H
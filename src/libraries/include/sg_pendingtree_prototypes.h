@@ -730,6 +730,38 @@ void SG_pendingtree__clear_wd_file_timestamp(SG_context * pCtx,
 											 SG_pendingtree * pPendingTree,
 											 const char * pszGid);
 
+//////////////////////////////////////////////////////////////////
+/**
+ * Set an individual directory timestamp in the cache.  This records
+ * the mtime of the directory on disk and a digest of what scan-dir
+ * knew about its contents when every entry on disk was accounted for.
+ * If some entries were only accounted for because the file-spec said
+ * to skip them, also give a digest of the file-spec.
+ * This updates the live in-memory vhash.
+ *
+ * You must do a SG_pendingtree__save() at some point after this.
+ */
+void SG_pendingtree__set_wd_dir_timestamp__dont_save_pendingtree(SG_context * pCtx,
+																 SG_pendingtree * pPendingTree,
+																 const char * pszGid,
+																 SG_int64 mtime_ms,
+																 const char * pszDigest,
+																 const char * pszSpecDigest);
+
+/**
+ * Does the directory cache have an entry for the given GID with
+ * the same digest and a (trustworthy) matching mtime, such that
+ * the set of entries on disk can't have changed since it was
+ * recorded?
+ */
+void SG_pendingtree__is_wd_dir_timestamp_valid(SG_context * pCtx,
+											   SG_pendingtree * pPendingTree,
+											   const char * pszGid,
+											   SG_int64 mtime_ms_observed_now,
+											   const char * pszDigest,
+											   const char * pszSpecDigest,
+											   SG_bool * pbResult);
+
 //////////////////////////////////////////////////////////////////
 
 /**
@@ -772,6 +804,16 @@ void SG_pendingtree_debug__export(SG_context * pCtx, SG_pathname * pPathWorkingD
  */
 void SG_pendingtree_debug__dump_existing_to_console(SG_context * pCtx, SG_pendingtree * pPendingTree);
 
+/**
+ * How many times has this pendingtree asked the directory cache
+ * (see SG_pendingtree__is_wd_dir_timestamp_valid()) about a directory,
+ * and how many times could it skip reading the directory?
+ */
+void SG_pendingtree_debug__get_dir_cache_stats(SG_context * pCtx,
+											   const SG_pendingtree * pPendingTree,
+											   SG_uint32 * pNrValid,
+											   SG_uint32 * pNrQueries);
+
 /**
  * Inspect the "wd.json" file.
  */
@@ -719,6 +719,79 @@ void SG_repo__get_dag_lca(
     SG_daglca ** ppDagLca
     );
 
+/**
+ * Get the in-memory index of the given dag.  The first call for a
+ * dagnum loads the whole dag from the repo; after that the index is
+ * kept on the SG_repo and updated as dagfrags are stored through it.
+ *
+ * Dagnodes stored by someone else (another process, or another SG_repo
+ * instance) don't show up in a cached index.  If you are about to look
+ * up a HID, pass it as pszHidWanted; if the cached index doesn't have
+ * it, the index is reloaded once.  (It is not an error for the HID to
+ * be missing from the reloaded index.)
+ *
+ * You do not own the returned index.  It is only valid until the
+ * next call that stores a dagfrag, aborts a tx or frees the repo.
+ */
+void SG_repo__get_dagindex(
+    SG_context* pCtx,
+    SG_repo* pRepo,
+    SG_uint32 iDagNum,
+    const char* pszHidWanted,
+    const SG_dagindex ** ppIndex
+    );
+
+/**
+ * Throw away all of the cached dag indexes.  They will be reloaded
+ * on next use.  This is for callers that keep an SG_repo open for a
+ * long time (such as the server) while other SG_repo instances may be
+ * storing dagnodes.
+ */
+void SG_repo__drop_dagindexes(
+    SG_context* pCtx,
+    SG_repo* pRepo
+    );
+
+/**
+ * Get the repo's cache of decoded objects.  Treenodes, changesets
+ * and dagnodes are immutable and named by their HID, so the
+ * __load_from_repo() routines and SG_repo__fetch_dagnode() keep the
+ * ones they decode here and hand out shared references to them.
+ *
+ * You do not own the returned cache.  It may be NULL.
+ */
+void SG_repo__get_objcache__ref(
+    SG_context* pCtx,
+    SG_repo* pRepo,
+    SG_objcache ** ppCache
+    );
+
+/**
+ * Get the counters of the cache of reconstructed VCDIFF reference
+ * blobs that this repo instance keeps: "hits", "misses", "count",
+ * "bytes_memory" and "bytes_disk".  This is mostly for the tests.
+ *
+ * You own the returned vhash.  Throws SG_ERR_NOTIMPLEMENTED if the
+ * storage implementation doesn't keep such a cache.
+ */
+void SG_repo__get_refcache_stats(
+    SG_context* pCtx,
+    SG_repo* pRepo,
+    SG_vhash ** ppvhStats
+    );
+
+/**
+ * Free the memory (and temp files) this repo instance uses for caches:
+ * the dag indexes and whatever the storage implementation keeps, such
+ * as fs3's reference cache.  The instance stays open and usable; the
+ * caches fill up again as needed.  The counters that
+ * SG_repo__get_refcache_stats() returns are not reset.
+ */
+void SG_repo__drop_caches(
+    SG_context* pCtx,
+    SG_repo* pRepo
+    );
+
 // TODO Consider also returning the strlen() of hashes computed with this hash-method.
 void SG_repo__get_hash_method(
 	    SG_context* pCtx,
@@ -1029,6 +1102,27 @@ void SG_repo__fetch_blob__chunk(
     SG_bool* pb_done
     );
 
+/**
+ * Like SG_repo__fetch_blob__chunk(), but lets the repo hand back the bytes
+ * in place instead of copying them into p_buf.  For a FULL blob (or the
+ * encoded bytes of any blob fetched without conversion) that lives in an
+ * fs2/fs3 data file, *pp_span points into a read-only mapping of that file.
+ * Otherwise the data is read into p_buf and *pp_span == p_buf.
+ *
+ * Either way, *pp_span holds *p_len_got bytes and is only valid until the
+ * next call on this handle.
+ */
+void SG_repo__fetch_blob__chunk__span(
+	SG_context* pCtx,
+    SG_repo * pRepo,
+    SG_repo_fetch_blob_handle* pHandle,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    );
+
 void SG_repo__fetch_blob__end(
     SG_context* pCtx,
     SG_repo * pRepo,
@@ -1048,6 +1142,15 @@ void SG_repo__fetch_repo__fragball(
 	char** ppszFragballName
 	);
 
+/**
+ * Counts and sizes of the blobs in the repo, by encoding.
+ *
+ * If ppvh_chain_depths is not NULL, it returns a histogram of vcdiff
+ * chain depths: each key is a depth (as a string) and each value is the
+ * number of blobs at that depth.  Depth 0 is a blob which isn't a delta.
+ * A delta has a depth one more than its reference, and reconstructing it
+ * means undeltifying that many times.  You own the vhash.
+ */
 void SG_repo__get_blob_stats(
     SG_context* pCtx,
     SG_repo * pRepo,
@@ -1060,7 +1163,8 @@ void SG_repo__get_blob_stats(
     SG_uint64* p_total_blob_size_zlib_full,
     SG_uint64* p_total_blob_size_zlib_encoded,
     SG_uint64* p_total_blob_size_vcdiff_full,
-    SG_uint64* p_total_blob_size_vcdiff_encoded
+    SG_uint64* p_total_blob_size_vcdiff_encoded,
+    SG_vhash** ppvh_chain_depths
     );
 
 void SG_repo__change_blob_encoding(
@@ -1070,17 +1174,50 @@ void SG_repo__change_blob_encoding(
     const char* psz_hid_blob,
     SG_blob_encoding blob_encoding_desired,
     const char* psz_hid_vcdiff_reference_desired,
+    const SG_vcdiff_options* pVcdiffOptions,  /**< NULL for the defaults */
     SG_blob_encoding* p_blob_encoding_new,
     char** ppsz_hid_vcdiff_reference,
     SG_uint64* p_len_encoded,
     SG_uint64* p_len_full
 );
 
+/**
+ * Replace the stored form of an existing blob with p_encoded, which the
+ * caller has already encoded as blob_encoding.  FULL means p_encoded is
+ * the raw contents.  For VCDIFF, the reference must already be in the
+ * repo.  The change becomes visible when pTx is committed.
+ */
+void SG_repo__replace_blob_encoding(
+    SG_context* pCtx,
+    SG_repo * pRepo,
+	SG_repo_tx_handle* pTx,
+    const char* psz_hid_blob,
+    SG_blob_encoding blob_encoding,
+    const char* psz_hid_vcdiff_reference,
+    SG_uint64 len_full,
+    SG_uint32 len_encoded,
+    const SG_byte* p_encoded
+);
+
+/**
+ * Deltify the repo with the default SG_repo_pack_policy.
+ */
 void SG_repo__pack__vcdiff(
     SG_context* pCtx,
     SG_repo * pRepo
     );
 
+/**
+ * Deltify the versions of every file in the history of every leaf
+ * according to pPolicy.  Blobs which the policy wants stored differently
+ * than they are now are re-encoded.
+ */
+void SG_repo__pack__vcdiff__policy(
+    SG_context* pCtx,
+    SG_repo * pRepo,
+    const SG_repo_pack_policy* pPolicy
+    );
+
 void SG_repo__pack__zlib(
 	SG_context* pCtx,
     SG_repo * pRepo
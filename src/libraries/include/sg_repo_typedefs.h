@@ -102,6 +102,34 @@ typedef struct _SG_repo         SG_repo;
 #define SG_REPO__QUESTION__BOOL__SUPPORTS_VCDIFF                         (SG_REPO__QUESTION__TYPE_2 | 0x006)
 #define SG_REPO__QUESTION__BOOL__SUPPORTS_DBNDX                          (SG_REPO__QUESTION__TYPE_2 | 0x007)
 #define SG_REPO__QUESTION__BOOL__SUPPORTS_TREEDX                         (SG_REPO__QUESTION__TYPE_2 | 0x008)
+#define SG_REPO__QUESTION__BOOL__SUPPORTS_CONCURRENT_TX                  (SG_REPO__QUESTION__TYPE_2 | 0x009)
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * How SG_repo__pack__vcdiff__policy() lays out the versions of each file.
+ *
+ * The versions are put in order (oldest first, or newest first when
+ * b_reverse is set) and each one is stored as a delta against the one
+ * before it.  A keyframe (a zlib snapshot) starts a new chain.  We make
+ * a keyframe at every keyframe_interval'th version, and whenever a delta
+ * would end up more than max_chain_depth hops from its keyframe.
+ *
+ * vcdiff_method says how each delta picks its source data (see
+ * SG_VCDIFF_METHOD__* in sg_vcdiff.h).
+ */
+typedef struct
+{
+    SG_uint32 max_chain_depth;      /**< at least 1 */
+    SG_uint32 keyframe_interval;    /**< 0 means only max_chain_depth decides */
+    SG_bool b_reverse;              /**< store the newest version as the keyframe */
+    SG_uint32 vcdiff_method;        /**< SG_VCDIFF_METHOD__* */
+} SG_repo_pack_policy;
+
+#define SG_REPO_PACK_POLICY__DEFAULT_MAX_CHAIN_DEPTH       16
+#define SG_REPO_PACK_POLICY__DEFAULT_KEYFRAME_INTERVAL     0
+#define SG_REPO_PACK_POLICY__DEFAULT_REVERSE               SG_TRUE
+#define SG_REPO_PACK_POLICY__DEFAULT_VCDIFF_METHOD         SG_VCDIFF_METHOD__WHOLE_SOURCE
 
 //////////////////////////////////////////////////////////////////
 
@@ -53,6 +53,18 @@ void SG_server__push_add(
 	SG_vhash** ppResult
 	);
 
+/**
+ * Like SG_server__push_add(), but the fragball is read from a stream
+ * and staged as it arrives rather than being handed over as a file.
+ */
+void SG_server__push_add__stream(
+	SG_context*,
+	SG_server * pServer,
+	const char* pPush,
+	SG_readstream* pFragballStream,
+	SG_vhash** ppResult
+	);
+
 void SG_server__push_remove(
 	SG_context*,
 	SG_server * pServer,
@@ -120,6 +132,20 @@ void SG_server__pull_request_fragball(
 	SG_vhash** pvhStatus
 	);
 
+/**
+ * Like SG_server__pull_request_fragball(), but the fragball comes back
+ * as a stream rather than a file.  Blobs are read from pRepo as the
+ * stream is read, so pRepo must outlive the stream.  Clone requests
+ * aren't supported.
+ */
+void SG_server__pull_request_fragball__stream(
+	SG_context* pCtx,
+	SG_repo* pRepo,
+	SG_vhash* pvhRequest,
+	SG_fragball_stream** ppFragballStream,
+	SG_vhash** ppvhStatus
+	);
+
 void SG_server__get_repo_info(SG_context* pCtx,
 							  SG_repo* pRepo,
 							  char** ppszRepoId,
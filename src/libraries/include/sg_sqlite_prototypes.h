@@ -63,6 +63,38 @@ void sg_sqlite__finalize(SG_context * pCtx, sqlite3_stmt* pStmt);
 
 void sg_sqlite__nullfinalize(SG_context * pCtx, sqlite3_stmt ** ppStmt);
 
+/**
+ * Get a prepared statement for the given SQL from the connection's
+ * statement cache, preparing it if necessary.  The SQL is used as-is
+ * (it is not a format string), so anything that varies from call to
+ * call must be bound as a parameter.
+ *
+ * pCache is the cache kept by the connection's owner.  If it is NULL,
+ * the statement is just prepared.
+ *
+ * The statement must be handed back with sg_sqlite__release(), not
+ * finalized, and must be released before the cache is freed.
+ */
+void sg_sqlite__prepare__cached(SG_context * pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, sqlite3_stmt** ppStmt, const char* pszSql);
+
+/**
+ * Return a statement obtained from sg_sqlite__prepare__cached() to the
+ * cache it came from.  It is reset and its bindings are cleared; a
+ * statement that isn't in pCache (or a NULL pCache) is finalized.
+ * Any error from the statement's last step is not reported again.
+ * *ppStmt is set to NULL; it is fine to call this with a NULL statement.
+ */
+void sg_sqlite__release(SG_context * pCtx, sg_sqlite__stmt_cache* pCache, sqlite3_stmt** ppStmt);
+
+void sg_sqlite__stmt_cache__alloc(SG_context * pCtx, sg_sqlite__stmt_cache** ppNew);
+
+/**
+ * Finalize every statement in a cache and free it.  This must be done
+ * before the connection is closed, or sqlite3_close() fails with
+ * SQLITE_BUSY.
+ */
+void sg_sqlite__stmt_cache__free(SG_context * pCtx, sg_sqlite__stmt_cache* pCache);
+
 void sg_sqlite__reset(SG_context * pCtx, sqlite3_stmt* pStmt);
 
 void sg_sqlite__step(
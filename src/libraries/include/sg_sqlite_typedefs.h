@@ -0,0 +1,38 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_sqlite_typedefs.h
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_SQLITE_TYPEDEFS_H
+#define H_SG_SQLITE_TYPEDEFS_H
+
+BEGIN_EXTERN_C;
+
+/**
+ * A cache of prepared statements for one sqlite connection.  It is
+ * kept by whatever owns the connection.  See sg_sqlite__prepare__cached().
+ */
+typedef struct _sg_sqlite__stmt_cache sg_sqlite__stmt_cache;
+
+END_EXTERN_C;
+
+#endif//H_SG_SQLITE_TYPEDEFS_H
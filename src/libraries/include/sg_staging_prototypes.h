@@ -50,7 +50,8 @@ BEGIN_EXTERN_C
  * Except:  The way to add a fragball to the staging area is to write
  * the fragball file into the staging area directory using a unique name
  * like a GID.  Then call slurp_fragball to tell the staging area to
- * take that fragball and make it its own.
+ * take that fragball and make it its own.  Or, if the fragball is
+ * arriving as a stream, write it to a fragball writestream.
  *
  */
 
@@ -105,6 +106,21 @@ void SG_staging__slurp_fragball(
 	const char* psz_filename
 	);
 
+/**
+ * Get a writestream which takes a fragball as it arrives.  It is
+ * written into the staging area and slurped at the same time, so the
+ * fragball is never read back.  Closing the stream makes the contents
+ * part of the staging area; this throws if the fragball was truncated,
+ * in which case none of it is kept.
+ *
+ * The staging handle must stay open until the stream is closed.
+ */
+void SG_staging__open_fragball_writestream(
+	SG_context* pCtx,
+	SG_staging* pStaging,
+	SG_writestream** ppStream
+	);
+
 /**
  * For each item in the staging area, provide information about
  * what would happen if the staging were committed right now.
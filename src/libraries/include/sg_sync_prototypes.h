@@ -47,11 +47,52 @@ void SG_sync__add_n_generations(SG_context* pCtx,
 										   SG_rbtree* prbDagnodeHids,
 										   SG_uint32 generations);
 
+/**
+ * Like SG_sync__add_n_generations(), but if genCommon is positive, keep
+ * walking down to that generation even when it is more than the
+ * requested number of generations away.  genCommon would usually come
+ * from SG_sync__get_common_generation().
+ */
+void SG_sync__add_generations(SG_context* pCtx,
+							  SG_repo* pRepo,
+							  const char* pszDagnodeHid,
+							  SG_rbtree* prbDagnodeHids,
+							  SG_uint32 generations,
+							  SG_int32 genCommon);
+
+/**
+ * For each dag listed as disconnected in the status vhash (under
+ * SG_SYNC_STATUS_KEY__DAGS), add a small sample of the HIDs in our copy
+ * of that dag under SG_SYNC_STATUS_KEY__SAMPLES.  The other side uses
+ * it to guess how far back the two dags meet, so it can send enough
+ * generations to connect in one round trip instead of creeping back a
+ * fixed number of generations at a time.
+ */
+void SG_sync__add_dag_samples_to_status(SG_context* pCtx,
+										SG_repo* pRepo,
+										SG_vhash* pvh_status);
+
+/**
+ * Look at the samples the other side put in the status vhash (see
+ * SG_sync__add_dag_samples_to_status()) and return the highest generation
+ * of any of them that we also have.  Returns 0 if there are no samples
+ * for the dag or we have none of them.
+ */
+void SG_sync__get_common_generation(SG_context* pCtx,
+									SG_repo* pRepo,
+									const SG_vhash* pvh_status,
+									const char* pszDagNum,
+									SG_int32* pGenCommon);
+
 void SG_sync__add_blobs_to_fragball(SG_context* pCtx,
 									SG_repo* pRepo,
 									SG_pathname* pPath_fragball,
 									SG_vhash* pvh_missing_blobs);
 
+void SG_sync__add_blobs_to_fragball_stream(SG_context* pCtx,
+										   SG_fragball_stream* pFragballStream,
+										   SG_vhash* pvh_missing_blobs);
+
 
 
 END_EXTERN_C
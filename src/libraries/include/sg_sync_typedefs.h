@@ -33,10 +33,20 @@ BEGIN_EXTERN_C;
 #define SG_SYNC_STATUS_KEY__BLOBS		"blobs"
 #define SG_SYNC_STATUS_KEY__LEAFD		"leafd"
 #define SG_SYNC_STATUS_KEY__NEW_NODES	"new-nodes"
+#define SG_SYNC_STATUS_KEY__SAMPLES		"samples"
 
 #define SG_SYNC_REQUEST_VALUE_TAG			"tag"
 #define SG_SYNC_REQUEST_VALUE_HID_PREFIX	"prefix"
 
+/**
+ * How many generations of dagnodes to add to a fragball per round trip
+ * while we're trying to connect a dag.  We start small (most syncs are
+ * only a few changesets apart) and double the window each time the
+ * other side is still disconnected.
+ */
+#define SG_SYNC__GENERATIONS_PER_ROUNDTRIP__INITIAL	100
+#define SG_SYNC__GENERATIONS_PER_ROUNDTRIP__MAX		12800
+
 END_EXTERN_C;
 
 #endif//H_SG_SYNC_TYPEDEFS_H
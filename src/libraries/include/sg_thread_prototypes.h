@@ -0,0 +1,65 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_thread_prototypes.h
+ *
+ * @details
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_THREAD_PROTOTYPES_H
+#define H_SG_THREAD_PROTOTYPES_H
+
+BEGIN_EXTERN_C;
+
+/**
+ * Start a thread running pfn(pArg).  The SG_thread is owned by the
+ * caller and must stay put until SG_thread__join() returns.
+ */
+void SG_thread__start(SG_context* pCtx, SG_thread* pThread, SG_thread__func* pfn, void* pArg);
+
+/**
+ * Wait for a thread started with SG_thread__start() to finish.
+ */
+void SG_thread__join(SG_context* pCtx, SG_thread* pThread);
+
+/**
+ * Return the number of processors available, or 1 if we can't tell.
+ */
+SG_uint32 SG_thread__count_processors(void);
+
+/**
+ * Condition variables.  These follow SG_mutex and return 0 or an
+ * errno-style code rather than using an SG_context.
+ *
+ * SG_cond__wait() atomically releases pm (which the caller holds),
+ * sleeps until signalled, and takes pm again before returning.  As
+ * with any condition variable, wakeups can be spurious, so callers
+ * must wait in a loop that rechecks their predicate.
+ */
+int SG_cond__init(SG_cond* pc);
+void SG_cond__destroy(SG_cond* pc);
+int SG_cond__wait(SG_cond* pc, SG_mutex* pm);
+int SG_cond__signal(SG_cond* pc);
+int SG_cond__broadcast(SG_cond* pc);
+
+END_EXTERN_C;
+
+#endif//H_SG_THREAD_PROTOTYPES_H
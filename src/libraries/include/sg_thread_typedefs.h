@@ -0,0 +1,74 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_thread_typedefs.h
+ *
+ * @details A minimal wrapper around platform threads.  Each thread
+ * that calls into the library must allocate and use its own SG_context.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_THREAD_TYPEDEFS_H
+#define H_SG_THREAD_TYPEDEFS_H
+
+BEGIN_EXTERN_C;
+
+typedef struct SG_thread SG_thread;
+
+typedef void (SG_thread__func)(void* pArg);
+
+/**
+ * A condition variable, always used together with an SG_mutex.
+ * The mutex must be locked (exactly once) by the thread that waits.
+ */
+typedef struct SG_cond SG_cond;
+
+#if defined(MAC) || defined(LINUX)
+#include <pthread.h>
+struct SG_thread
+{
+    pthread_t thr;
+    SG_thread__func* pfn;
+    void* pArg;
+};
+
+struct SG_cond
+{
+    pthread_cond_t cond;
+};
+#endif
+
+#if defined(WINDOWS)
+struct SG_thread
+{
+    HANDLE h;
+    SG_thread__func* pfn;
+    void* pArg;
+};
+
+struct SG_cond
+{
+    CONDITION_VARIABLE cv;
+};
+#endif
+
+END_EXTERN_C;
+
+#endif//H_SG_THREAD_TYPEDEFS_H
@@ -35,10 +35,18 @@ BEGIN_EXTERN_C;
 void SG_treenode__alloc(SG_context *, SG_treenode ** ppNew);
 
 /**
- * Feee a Treenode.
+ * Feee a Treenode.  If the Treenode is shared (see SG_treenode__addref())
+ * this only drops your reference.
  */
 void SG_treenode__free(SG_context * pCtx, SG_treenode * pTreenode);
 
+/**
+ * Add a reference to a frozen Treenode.  Each reference is dropped with
+ * SG_treenode__free().  Treenodes returned by SG_treenode__load_from_repo()
+ * may be shared with the repo's object cache; they cannot be unfrozen.
+ */
+void SG_treenode__addref(SG_context * pCtx, SG_treenode * pTreenode);
+
 //////////////////////////////////////////////////////////////////
 
 /**
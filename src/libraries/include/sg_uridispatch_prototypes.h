@@ -45,6 +45,7 @@ BEGIN_EXTERN_C;
 		const char * pUserAgent,
         const char * pFrom,
 		const char * pIfModifiedSince,
+		const char * pIfNoneMatch,
 
 		// Output parameter. Use this handle to get the response.
 		void ** ppResponseHandle
@@ -63,6 +64,7 @@ BEGIN_EXTERN_C;
 		SG_uint64 contentLength,
         const char * pFrom,
 		const char * pIfModifiedSince,
+		const char * pIfNoneMatch,
 
 		// One of these will get set to non-null and the other one set to null:
 		void ** ppRequestHandle,
@@ -114,6 +116,18 @@ BEGIN_EXTERN_C;
 		void ** ppResponseHandle);
 
 
+//////////////////////////////////////////////////////////////////
+
+
+// For the test suite:
+
+	// Counters of the repo handle pool: "hits", "misses", "discarded",
+	// "busy", "idle", "borrowed" and "max_borrowed".  You own the vhash.
+	void SG_uridispatch_debug__get_repo_pool_stats(
+		SG_context * pCtx,
+		SG_vhash ** ppvhStats);
+
+
 //////////////////////////////////////////////////////////////////
 
 END_EXTERN_C;
@@ -21,10 +21,50 @@ BEGIN_EXTERN_C
 
 typedef struct _sg_vcdiff_undeltify_state SG_vcdiff_undeltify_state;
 
+/**
+ * The biggest window the encoder may use.  The decoder refuses deltas
+ * whose windows (source segment plus target) are bigger than twice this.
+ */
+#define SG_VCDIFF_MAX_WINDOW_SIZE               (128*1024)
+
+/**
+ * How the encoder picks the source segment for each target window.
+ *
+ * WINDOW uses the part of the source at the same offset as the target
+ * window.  Content which moved further than a window never matches.
+ *
+ * WHOLE_SOURCE indexes the entire source with a rolling hash first and
+ * uses the part of the source the target window has the most blocks in
+ * common with.  The delta format is the same either way.
+ */
+#define SG_VCDIFF_METHOD__WINDOW                0
+#define SG_VCDIFF_METHOD__WHOLE_SOURCE          1
+
+#define SG_VCDIFF_DEFAULT_SLOTS_PER_BUCKET      4
+#define SG_VCDIFF_DEFAULT_BLOCK_SIZE            32
+#define SG_VCDIFF_DEFAULT_MAX_BLOCKS            (1024*1024)
+
+typedef struct
+{
+	SG_uint32 method;               /**< SG_VCDIFF_METHOD__* */
+	SG_uint32 window_size;          /**< at most SG_VCDIFF_MAX_WINDOW_SIZE */
+	SG_uint32 slots_per_bucket;     /**< match candidates kept per hash bucket within a window */
+	SG_uint32 block_size;           /**< WHOLE_SOURCE: bytes per indexed source block */
+	SG_uint32 max_blocks;           /**< WHOLE_SOURCE: bigger sources are indexed more sparsely */
+} SG_vcdiff_options;
+
+void	SG_vcdiff__options__init(SG_context* pCtx, SG_vcdiff_options* pOptions, SG_uint32 method);
 
 void	SG_vcdiff__deltify__files(SG_context* pCtx, SG_pathname* pPathSource, SG_pathname* pPathTarget, SG_pathname* pPathDelta);
 void	SG_vcdiff__deltify__streams(SG_context* pCtx, SG_seekreader* psrSource, SG_readstream* pstrmTarget, SG_writestream* pstrmDelta);
 
+/**
+ * Same as above, but with the given options.  NULL means the defaults
+ * for SG_VCDIFF_METHOD__WINDOW.
+ */
+void	SG_vcdiff__deltify__files__options(SG_context* pCtx, SG_pathname* pPathSource, SG_pathname* pPathTarget, SG_pathname* pPathDelta, const SG_vcdiff_options* pOptions);
+void	SG_vcdiff__deltify__streams__options(SG_context* pCtx, SG_seekreader* psrSource, SG_readstream* pstrmTarget, SG_writestream* pstrmDelta, const SG_vcdiff_options* pOptions);
+
 void	SG_vcdiff__undeltify__files(SG_context* pCtx, SG_pathname* pPathSource, SG_pathname* pPathTarget, SG_pathname* pPathDelta);
 void	SG_vcdiff__undeltify__streams(SG_context* pCtx, SG_seekreader* psrSource, SG_writestream* pstrmTarget, SG_readstream* pstrmDelta);
 
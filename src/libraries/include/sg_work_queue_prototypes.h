@@ -0,0 +1,114 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ *
+ * @file sg_work_queue_prototypes.h
+ *
+ * @details
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_WORK_QUEUE_PROTOTYPES_H
+#define H_SG_WORK_QUEUE_PROTOTYPES_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Allocate a WORK_QUEUE which will use up to nrMaxThreads workers
+ * (fewer if there aren't that many processors).  If that comes to
+ * less than 2, no threads are used and SG_work_queue__add() calls
+ * pfn itself before it returns.  The workers are started by the
+ * first SG_work_queue__add().
+ *
+ * SG_work_queue__add() blocks while nrMaxPending items are waiting
+ * for a worker.  Use 0 for no limit.
+ */
+void SG_work_queue__alloc(SG_context * pCtx,
+						  SG_uint32 nrMaxThreads,
+						  SG_uint32 nrMaxPending,
+						  SG_work_queue_flags flags,
+						  SG_work_queue__callback * pfn,
+						  void * pVoidData,
+						  SG_work_queue ** ppNew);
+
+/**
+ * Free the queue.  If SG_work_queue__finish() has not been called,
+ * the workers are told to stop after their current item and the
+ * rest of the queue is abandoned.  Items belong to the caller; the
+ * queue never frees them.
+ */
+void SG_work_queue__free(SG_context * pCtx, SG_work_queue * pQueue);
+
+/**
+ * Get the number of worker threads (0 if the work is being done on
+ * the caller's thread).
+ */
+void SG_work_queue__get_thread_count(SG_context * pCtx,
+									 const SG_work_queue * pQueue,
+									 SG_uint32 * pnrThreads);
+
+/**
+ * Queue an item.  This throws the error of any worker that has
+ * already failed.
+ *
+ * The callback may add items to its own queue (say, the entries of
+ * a directory it just read) as long as nrMaxPending is 0.
+ */
+void SG_work_queue__add(SG_context * pCtx,
+						SG_work_queue * pQueue,
+						void * pItem);
+
+/**
+ * With SG_WORK_QUEUE_FLAGS__COLLECT, wait for the oldest item not
+ * yet handed back to be finished and return it.  *ppItem is set to
+ * NULL when every item added so far has been handed back.  Throws
+ * the error of a worker that failed.
+ *
+ * The queue does not limit how many finished items it holds; the
+ * caller bounds that by how far it lets its adds run ahead of its
+ * calls to this.
+ */
+void SG_work_queue__next_done(SG_context * pCtx,
+							  SG_work_queue * pQueue,
+							  void ** ppItem);
+
+/**
+ * Wait until every item has been processed, including the ones the
+ * callback added while we waited.  The workers keep running, so more
+ * items can be added after this.  Throws the error of a worker that
+ * failed.
+ */
+void SG_work_queue__wait(SG_context * pCtx, SG_work_queue * pQueue);
+
+/**
+ * Wait for every queued item to be processed and stop the workers.
+ * If any of them failed, this throws the first error seen.  Nothing
+ * may be added after this.  (Finished items can still be taken with
+ * SG_work_queue__next_done().)
+ */
+void SG_work_queue__finish(SG_context * pCtx, SG_work_queue * pQueue);
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_WORK_QUEUE_PROTOTYPES_H
@@ -0,0 +1,73 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ *
+ * @file sg_work_queue_typedefs.h
+ *
+ * @details A WORK_QUEUE runs a callback on each of a series of items
+ * using a small pool of worker threads.  The caller's thread adds
+ * items (blocking when too many are waiting) and, if it asked for
+ * them, takes the finished items back in the order they were added.
+ * Nobody polls: both sides sleep on condition variables.
+ *
+ * The first error raised by the callback on any worker stops the
+ * queue, and is handed back to the caller (code, description and
+ * stack trace) by the next call it makes into the queue.
+ *
+ * This is the one place the library's thread pools are built on:
+ * staging, packing, the scan-dir pre-scan, the fetch pool and the
+ * automerge of conflicting files.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#ifndef H_SG_WORK_QUEUE_TYPEDEFS_H
+#define H_SG_WORK_QUEUE_TYPEDEFS_H
+
+BEGIN_EXTERN_C;
+
+//////////////////////////////////////////////////////////////////
+
+typedef struct _SG_work_queue SG_work_queue;
+
+/**
+ * Process one item.  This is called on a worker thread with that
+ * worker's own SG_context, or on the caller's thread (with the
+ * caller's context) when the queue has no threads.
+ *
+ * kThread identifies the worker, 0 <= kThread < max(1, nrThreads),
+ * so the caller can keep per-thread state (file handles, a repo
+ * instance) in an array.  A given kThread is only ever running one
+ * item at a time.
+ */
+typedef void (SG_work_queue__callback)(SG_context * pCtx,
+									   SG_uint32 kThread,
+									   void * pVoidData,
+									   void * pItem);
+
+typedef SG_uint32 SG_work_queue_flags;
+
+#define SG_WORK_QUEUE_FLAGS__NONE			((SG_work_queue_flags)0x0000)
+#define SG_WORK_QUEUE_FLAGS__COLLECT		((SG_work_queue_flags)0x0001)	// finished items are handed back, in order, by SG_work_queue__next_done()
+
+//////////////////////////////////////////////////////////////////
+
+END_EXTERN_C;
+
+#endif//H_SG_WORK_QUEUE_TYPEDEFS_H
@@ -147,6 +147,55 @@ SG_error SGHASH_update(SGHASH_handle * pHandle, const SG_byte * pBuf, SG_uint32
 	return SG_ERR_OK;
 }
 
+SG_error SGHASH_update_multi(SGHASH_handle ** apHandles,
+							 const SG_byte ** apBufs,
+							 const SG_uint32 * aLenBufs,
+							 SG_uint32 count)
+{
+	void * apAlgCtx[8];
+	const SGHASH_algorithm * pVTable;
+	SG_uint32 k, kBatch, nrBatch;
+
+	if (count == 0)
+		return SG_ERR_OK;
+	if (!apHandles || !apBufs || !aLenBufs)
+		return SG_ERR_INVALIDARG;
+
+	for (k=0; k<count; k++)
+		if (!apHandles[k])
+			return SG_ERR_INVALIDARG;
+
+	// the algorithm can only batch streams that it owns.  if the
+	// handles are mixed (or it can't batch at all) just do them one
+	// at a time.
+
+	pVTable = apHandles[0]->pVTable;
+	for (k=1; k<count; k++)
+		if (apHandles[k]->pVTable != pVTable)
+			pVTable = NULL;
+
+	if (!pVTable || !pVTable->fn_hash_update_multi)
+	{
+		for (k=0; k<count; k++)
+			(*apHandles[k]->pVTable->fn_hash_update)( (void *)apHandles[k]->variable, apBufs[k], aLenBufs[k]);
+		return SG_ERR_OK;
+	}
+
+	for (kBatch=0; kBatch<count; kBatch+=nrBatch)
+	{
+		nrBatch = count - kBatch;
+		if (nrBatch > SG_NrElements(apAlgCtx))
+			nrBatch = SG_NrElements(apAlgCtx);
+
+		for (k=0; k<nrBatch; k++)
+			apAlgCtx[k] = (void *)apHandles[kBatch+k]->variable;
+
+		(*pVTable->fn_hash_update_multi)(apAlgCtx, &apBufs[kBatch], &aLenBufs[kBatch], nrBatch);
+	}
+
+	return SG_ERR_OK;
+}
+
 SG_error SGHASH_final(SGHASH_handle ** ppHandle, char * pBufResult, SG_uint32 lenBuf)
 {
 	SGHASH_handle * pHandle;
@@ -107,6 +107,43 @@ SG_error SGHASH_final(SGHASH_handle ** ppHandle, char * pBufResult, SG_uint32 le
  */
 void SGHASH_abort(SGHASH_handle ** ppHandle);
 
+/**
+ * Add content to several independent hash computations at once.
+ * This is equivalent to calling SGHASH_update(apHandles[k], apBufs[k], aLenBufs[k])
+ * for each k, but when all of the handles use the same hash-method
+ * the algorithm may process the streams side by side (currently
+ * SHA2/256 does this with AVX2, 8 streams at a time).
+ *
+ * The handles must be distinct.  A zero length is allowed.
+ */
+SG_error SGHASH_update_multi(SGHASH_handle ** apHandles,
+							 const SG_byte ** apBufs,
+							 const SG_uint32 * aLenBufs,
+							 SG_uint32 count);
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Processor-specific kernels.  These are probed for and used
+ * automatically; the results are identical either way.
+ *
+ * SGHASH_set_kernels() restricts which ones may be used.  It is
+ * only intended for tests and benchmarks and is not thread-safe
+ * with respect to hash computations that are in progress.
+ */
+#define SGHASH_KERNELS__NONE		0x00000000
+#define SGHASH_KERNELS__SHA_NI		0x00000001
+#define SGHASH_KERNELS__AVX2		0x00000002
+#define SGHASH_KERNELS__ALL			0xffffffff
+
+void SGHASH_set_kernels(SG_uint32 mask);
+
+/**
+ * Return the names of the kernels in use (something like "SHA-NI AVX2"),
+ * or "portable" if none.  You do not own this string.
+ */
+const char * SGHASH_get_kernel_names(void);
+
 //////////////////////////////////////////////////////////////////
 
 END_EXTERN_C;
@@ -76,6 +76,13 @@ typedef void FN__hash_init  (void * pAlgCtx);
 typedef void FN__hash_update(void * pAlgCtx, const SG_byte * pBuf, SG_uint32 lenBuf);
 typedef void FN__hash_final (void * pAlgCtx, char * ppszResult);
 
+/**
+ * Optional.  Update several independent contexts (all of the same
+ * algorithm) at once.  An algorithm that leaves this NULL gets a
+ * simple loop over fn_hash_update.
+ */
+typedef void FN__hash_update_multi(void ** apAlgCtx, const SG_byte ** apBufs, const SG_uint32 * aLenBufs, SG_uint32 count);
+
 struct _sghash_algorithm
 {
 	const char *				pszHashMethod;			// hash-method name (something like "SHA1/160")
@@ -85,6 +92,8 @@ struct _sghash_algorithm
 	FN__hash_init * const		fn_hash_init;
 	FN__hash_update * const		fn_hash_update;
 	FN__hash_final * const		fn_hash_final;
+
+	FN__hash_update_multi * const	fn_hash_update_multi;
 };
 
 struct _sghash_handle
@@ -95,6 +104,38 @@ struct _sghash_handle
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * Block-transform kernels.  These take the raw chaining state (in
+ * host byte order, as kept in the algorithm's context) and some
+ * number of whole 64 byte blocks.  They are selected at runtime by
+ * sghash__get_kernels() based upon what the processor supports; a
+ * NULL member means "use the portable C code in the algorithm".
+ *
+ * The _x8 kernel hashes 8 independent streams in lock-step (one per
+ * SIMD lane); every stream must have nrBlocks available.
+ */
+typedef void FN__sha1_blocks     (SG_uint32 * pState, const SG_byte * pData, SG_uint32 nrBlocks);
+typedef void FN__sha256_blocks   (SG_uint32 * pState, const SG_byte * pData, SG_uint32 nrBlocks);
+typedef void FN__sha256_blocks_x8(SG_uint32 * apState[8], const SG_byte * apData[8], SG_uint32 nrBlocks);
+
+struct _sghash_kernels
+{
+	const char *				pszNames;				// something like "SHA-NI AVX2" or "portable"
+
+	FN__sha1_blocks *			fn_sha1_blocks;
+	FN__sha256_blocks *			fn_sha256_blocks;
+	FN__sha256_blocks_x8 *		fn_sha256_blocks_x8;
+};
+
+/**
+ * Return the kernels to use.  The processor is only probed once;
+ * the answer is cached in a static (racing threads will compute the
+ * same answer, so we don't bother with a lock).
+ */
+const struct _sghash_kernels * sghash__get_kernels(void);
+
+//////////////////////////////////////////////////////////////////
+
 END_EXTERN_C;
 
 #endif//H_SGHASH__PRIVATE_H
@@ -0,0 +1,483 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sghash_kernels.c
+ *
+ * @details Optional processor-specific block transforms for SHA1 and
+ * SHA2/256 and the runtime selection of them.
+ *
+ * The algorithms in sha1.c and sha2.c ask sghash__get_kernels() for
+ * a kernel before falling back to their own portable C transforms.
+ * We currently have:
+ *
+ *     SHA-NI  -- the x86 SHA extensions (Goldmont, Ice Lake, Zen and
+ *                later) for SHA1 and SHA2/256.
+ *     AVX2    -- an 8-lane SHA2/256 that hashes 8 independent streams
+ *                at once.  This is only used by SGHASH_update_multi()
+ *                and sha2.c only uses it when it doesn't have SHA-NI
+ *                (which is faster per stream than AVX2 is per 8).
+ *
+ * Everything here is compiled with per-function target attributes
+ * so that the rest of the library (and the program) can still run
+ * on processors without these instructions.  On other compilers
+ * and architectures we just report "portable".
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg_defines.h>
+#include <sg_stdint.h>
+#include <sg_error_typedefs.h>
+#include "sghash.h"
+#include "sghash__private.h"
+
+#if defined(WINDOWS)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+//////////////////////////////////////////////////////////////////
+
+#if (defined(__x86_64__) || defined(__i386__)) && ((defined(__GNUC__) && (__GNUC__ >= 5)) || defined(__clang__))
+#define SGHASH_HAVE_X86_KERNELS 1
+#include <cpuid.h>
+#include <immintrin.h>
+#define SGHASH_TARGET(t)		__attribute__((target(t)))
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER) && (_MSC_VER >= 1900)
+#define SGHASH_HAVE_X86_KERNELS 1
+#include <intrin.h>
+#include <immintrin.h>
+#define SGHASH_TARGET(t)
+#endif
+
+//////////////////////////////////////////////////////////////////
+
+#if defined(SGHASH_HAVE_X86_KERNELS)
+
+static void _cpuid(SG_uint32 leaf, SG_uint32 subleaf, SG_uint32 regs[4])
+{
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	regs[0] = (SG_uint32)r[0];  regs[1] = (SG_uint32)r[1];
+	regs[2] = (SG_uint32)r[2];  regs[3] = (SG_uint32)r[3];
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static SG_uint64 _xgetbv0(void)
+{
+#if defined(_MSC_VER)
+	return (SG_uint64)_xgetbv(0);
+#else
+	SG_uint32 eax, edx;
+	__asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((SG_uint64)edx << 32) | eax;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////
+// SHA1 using the SHA extensions.  This follows the round structure
+// in Intel's white paper ("New Instructions Supporting the Secure
+// Hash Algorithm on Intel Architecture Processors"): each sha1rnds4
+// does 4 rounds and the message schedule for the next group is
+// computed with sha1msg1/sha1msg2 while the current group runs.
+
+#define SHA1_RNDS4(g)															\
+	do {																		\
+		__m128i * pE    = (((g) & 1) ? &E1 : &E0);								\
+		__m128i * pEOld = (((g) & 1) ? &E0 : &E1);								\
+		*pE = _mm_sha1nexte_epu32(*pE, M[(g) & 3]);								\
+		*pEOld = ABCD;															\
+		if ((g) >= 3 && (g) <= 18)												\
+			M[((g)+1) & 3] = _mm_sha1msg2_epu32(M[((g)+1) & 3], M[(g) & 3]);	\
+		ABCD = _mm_sha1rnds4_epu32(ABCD, *pE, (g) / 5);							\
+		if ((g) >= 1 && (g) <= 16)												\
+			M[((g)-1) & 3] = _mm_sha1msg1_epu32(M[((g)-1) & 3], M[(g) & 3]);	\
+		if ((g) >= 2 && (g) <= 17)												\
+			M[((g)+2) & 3] = _mm_xor_si128(M[((g)+2) & 3], M[(g) & 3]);		\
+	} while (0)
+
+SGHASH_TARGET("sha,sse4.1,ssse3")
+static void _sha1_blocks__shani(SG_uint32 * pState, const SG_byte * pData, SG_uint32 nrBlocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+	__m128i ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+	__m128i M[4];
+
+	ABCD = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)pState), 0x1B);
+	E0 = _mm_set_epi32((int)pState[4], 0, 0, 0);
+	E1 = _mm_setzero_si128();
+
+	while (nrBlocks--)
+	{
+		ABCD_SAVE = ABCD;
+		E0_SAVE = E0;
+
+		M[0] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData +  0)), mask);
+		M[1] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData + 16)), mask);
+		M[2] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData + 32)), mask);
+		M[3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData + 48)), mask);
+
+		// rounds 0-3 are special: E is added directly rather than via sha1nexte.
+		E0 = _mm_add_epi32(E0, M[0]);
+		E1 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+
+		SHA1_RNDS4( 1);  SHA1_RNDS4( 2);  SHA1_RNDS4( 3);  SHA1_RNDS4( 4);
+		SHA1_RNDS4( 5);  SHA1_RNDS4( 6);  SHA1_RNDS4( 7);  SHA1_RNDS4( 8);
+		SHA1_RNDS4( 9);  SHA1_RNDS4(10);  SHA1_RNDS4(11);  SHA1_RNDS4(12);
+		SHA1_RNDS4(13);  SHA1_RNDS4(14);  SHA1_RNDS4(15);  SHA1_RNDS4(16);
+		SHA1_RNDS4(17);  SHA1_RNDS4(18);  SHA1_RNDS4(19);
+
+		// group 19 left its E in E1; fold the saved E into E0 for the next block.
+		E0 = _mm_sha1nexte_epu32(E0, E0_SAVE);
+		ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
+
+		pData += 64;
+	}
+
+	_mm_storeu_si128((__m128i *)pState, _mm_shuffle_epi32(ABCD, 0x1B));
+	pState[4] = (SG_uint32)_mm_extract_epi32(E0, 3);
+}
+
+#undef SHA1_RNDS4
+
+//////////////////////////////////////////////////////////////////
+
+static const SG_uint32 K256[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+//////////////////////////////////////////////////////////////////
+// SHA2/256 using the SHA extensions.  sha256rnds2 wants the state
+// split as ABEF/CDGH rather than ABCD/EFGH, so we shuffle on the
+// way in and out.  Group i does rounds 4i..4i+3.
+
+#define SHA256_RNDS4(i)																\
+	do {																			\
+		MSG = _mm_add_epi32(M[(i) & 3], _mm_loadu_si128((const __m128i *)&K256[4*(i)]));	\
+		STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG);						\
+		if ((i) >= 3 && (i) <= 14)													\
+		{																			\
+			TMP = _mm_alignr_epi8(M[(i) & 3], M[((i)-1) & 3], 4);					\
+			M[((i)+1) & 3] = _mm_add_epi32(M[((i)+1) & 3], TMP);					\
+			M[((i)+1) & 3] = _mm_sha256msg2_epu32(M[((i)+1) & 3], M[(i) & 3]);		\
+		}																			\
+		MSG = _mm_shuffle_epi32(MSG, 0x0E);											\
+		STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG);						\
+		if ((i) >= 1 && (i) <= 12)													\
+			M[((i)-1) & 3] = _mm_sha256msg1_epu32(M[((i)-1) & 3], M[(i) & 3]);		\
+	} while (0)
+
+SGHASH_TARGET("sha,sse4.1,ssse3")
+static void _sha256_blocks__shani(SG_uint32 * pState, const SG_byte * pData, SG_uint32 nrBlocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+	__m128i STATE0, STATE1, SAVE0, SAVE1, MSG, TMP;
+	__m128i M[4];
+
+	TMP    = _mm_loadu_si128((const __m128i *)&pState[0]);		// DCBA
+	STATE1 = _mm_loadu_si128((const __m128i *)&pState[4]);		// HGFE
+
+	TMP    = _mm_shuffle_epi32(TMP, 0xB1);						// CDAB
+	STATE1 = _mm_shuffle_epi32(STATE1, 0x1B);					// EFGH
+	STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);					// ABEF
+	STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);				// CDGH
+
+	while (nrBlocks--)
+	{
+		SAVE0 = STATE0;
+		SAVE1 = STATE1;
+
+		M[0] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData +  0)), mask);
+		M[1] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData + 16)), mask);
+		M[2] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData + 32)), mask);
+		M[3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(pData + 48)), mask);
+
+		SHA256_RNDS4( 0);  SHA256_RNDS4( 1);  SHA256_RNDS4( 2);  SHA256_RNDS4( 3);
+		SHA256_RNDS4( 4);  SHA256_RNDS4( 5);  SHA256_RNDS4( 6);  SHA256_RNDS4( 7);
+		SHA256_RNDS4( 8);  SHA256_RNDS4( 9);  SHA256_RNDS4(10);  SHA256_RNDS4(11);
+		SHA256_RNDS4(12);  SHA256_RNDS4(13);  SHA256_RNDS4(14);  SHA256_RNDS4(15);
+
+		STATE0 = _mm_add_epi32(STATE0, SAVE0);
+		STATE1 = _mm_add_epi32(STATE1, SAVE1);
+
+		pData += 64;
+	}
+
+	TMP    = _mm_shuffle_epi32(STATE0, 0x1B);					// FEBA
+	STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);					// DCHG
+	STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0);				// DCBA
+	STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);					// HGFE
+
+	_mm_storeu_si128((__m128i *)&pState[0], STATE0);
+	_mm_storeu_si128((__m128i *)&pState[4], STATE1);
+}
+
+#undef SHA256_RNDS4
+
+//////////////////////////////////////////////////////////////////
+// SHA2/256 on 8 independent streams using AVX2.  Lane j of each
+// vector belongs to stream j.  This is the straight-forward FIPS
+// 180 round function, just 8 wide; the only trick is transposing
+// the input so that vector t holds word t of all 8 blocks.
+
+#define V_ROTR(x,n)		_mm256_or_si256(_mm256_srli_epi32((x),(n)), _mm256_slli_epi32((x),32-(n)))
+#define V_ADD(a,b)		_mm256_add_epi32((a),(b))
+#define V_XOR3(a,b,c)	_mm256_xor_si256(_mm256_xor_si256((a),(b)),(c))
+
+#define V_S0(a)			V_XOR3(V_ROTR((a), 2), V_ROTR((a),13), V_ROTR((a),22))
+#define V_S1(e)			V_XOR3(V_ROTR((e), 6), V_ROTR((e),11), V_ROTR((e),25))
+#define V_s0(w)			V_XOR3(V_ROTR((w), 7), V_ROTR((w),18), _mm256_srli_epi32((w), 3))
+#define V_s1(w)			V_XOR3(V_ROTR((w),17), V_ROTR((w),19), _mm256_srli_epi32((w),10))
+#define V_CH(e,f,g)		_mm256_xor_si256(_mm256_and_si256((e),(f)), _mm256_andnot_si256((e),(g)))
+#define V_MAJ(a,b,c)	_mm256_or_si256(_mm256_and_si256(_mm256_or_si256((a),(b)),(c)), _mm256_and_si256((a),(b)))
+
+SGHASH_TARGET("avx2")
+static void _sha256_load_x8(__m256i * W, const SG_byte * apData[8], SG_uint32 offset)
+{
+	const __m256i bswap = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+										   3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+	__m256i r0, r1, r2, r3, r4, r5, r6, r7;
+	__m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+	r0 = _mm256_loadu_si256((const __m256i *)(apData[0] + offset));
+	r1 = _mm256_loadu_si256((const __m256i *)(apData[1] + offset));
+	r2 = _mm256_loadu_si256((const __m256i *)(apData[2] + offset));
+	r3 = _mm256_loadu_si256((const __m256i *)(apData[3] + offset));
+	r4 = _mm256_loadu_si256((const __m256i *)(apData[4] + offset));
+	r5 = _mm256_loadu_si256((const __m256i *)(apData[5] + offset));
+	r6 = _mm256_loadu_si256((const __m256i *)(apData[6] + offset));
+	r7 = _mm256_loadu_si256((const __m256i *)(apData[7] + offset));
+
+	t0 = _mm256_unpacklo_epi32(r0, r1);		t1 = _mm256_unpackhi_epi32(r0, r1);
+	t2 = _mm256_unpacklo_epi32(r2, r3);		t3 = _mm256_unpackhi_epi32(r2, r3);
+	t4 = _mm256_unpacklo_epi32(r4, r5);		t5 = _mm256_unpackhi_epi32(r4, r5);
+	t6 = _mm256_unpacklo_epi32(r6, r7);		t7 = _mm256_unpackhi_epi32(r6, r7);
+
+	r0 = _mm256_unpacklo_epi64(t0, t2);		r1 = _mm256_unpackhi_epi64(t0, t2);
+	r2 = _mm256_unpacklo_epi64(t1, t3);		r3 = _mm256_unpackhi_epi64(t1, t3);
+	r4 = _mm256_unpacklo_epi64(t4, t6);		r5 = _mm256_unpackhi_epi64(t4, t6);
+	r6 = _mm256_unpacklo_epi64(t5, t7);		r7 = _mm256_unpackhi_epi64(t5, t7);
+
+	W[0] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r0, r4, 0x20), bswap);
+	W[1] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r1, r5, 0x20), bswap);
+	W[2] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r2, r6, 0x20), bswap);
+	W[3] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r3, r7, 0x20), bswap);
+	W[4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r0, r4, 0x31), bswap);
+	W[5] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r1, r5, 0x31), bswap);
+	W[6] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r2, r6, 0x31), bswap);
+	W[7] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(r3, r7, 0x31), bswap);
+}
+
+SGHASH_TARGET("avx2")
+static void _sha256_blocks_x8__avx2(SG_uint32 * apState[8], const SG_byte * apData[8], SG_uint32 nrBlocks)
+{
+	const SG_byte * apCur[8];
+	__m256i S[8], W[16];
+	__m256i a, b, c, d, e, f, g, h, T1, T2;
+	SG_uint32 j, t;
+
+	for (j=0; j<8; j++)
+		apCur[j] = apData[j];
+
+	for (t=0; t<8; t++)
+		S[t] = _mm256_setr_epi32((int)apState[0][t], (int)apState[1][t], (int)apState[2][t], (int)apState[3][t],
+								 (int)apState[4][t], (int)apState[5][t], (int)apState[6][t], (int)apState[7][t]);
+
+	while (nrBlocks--)
+	{
+		_sha256_load_x8(&W[0], apCur, 0);
+		_sha256_load_x8(&W[8], apCur, 32);
+
+		a = S[0];  b = S[1];  c = S[2];  d = S[3];
+		e = S[4];  f = S[5];  g = S[6];  h = S[7];
+
+		for (t=0; t<64; t++)
+		{
+			if (t >= 16)
+				W[t & 15] = V_ADD(V_ADD(V_s1(W[(t-2) & 15]), W[(t-7) & 15]),
+								  V_ADD(V_s0(W[(t-15) & 15]), W[t & 15]));
+
+			T1 = V_ADD(V_ADD(h, V_S1(e)),
+					   V_ADD(V_CH(e,f,g), V_ADD(_mm256_set1_epi32((int)K256[t]), W[t & 15])));
+			T2 = V_ADD(V_S0(a), V_MAJ(a,b,c));
+			h = g;  g = f;  f = e;  e = V_ADD(d, T1);
+			d = c;  c = b;  b = a;  a = V_ADD(T1, T2);
+		}
+
+		S[0] = V_ADD(S[0], a);  S[1] = V_ADD(S[1], b);  S[2] = V_ADD(S[2], c);  S[3] = V_ADD(S[3], d);
+		S[4] = V_ADD(S[4], e);  S[5] = V_ADD(S[5], f);  S[6] = V_ADD(S[6], g);  S[7] = V_ADD(S[7], h);
+
+		for (j=0; j<8; j++)
+			apCur[j] += 64;
+	}
+
+	for (t=0; t<8; t++)
+	{
+		SG_uint32 lanes[8];
+
+		_mm256_storeu_si256((__m256i *)lanes, S[t]);
+		for (j=0; j<8; j++)
+			apState[j][t] = lanes[j];
+	}
+}
+
+#undef V_ROTR
+#undef V_ADD
+#undef V_XOR3
+#undef V_S0
+#undef V_S1
+#undef V_s0
+#undef V_s1
+#undef V_CH
+#undef V_MAJ
+
+#endif//SGHASH_HAVE_X86_KERNELS
+
+//////////////////////////////////////////////////////////////////
+
+static struct _sghash_kernels gs_kernels__available;	// everything the processor can do
+static struct _sghash_kernels gs_kernels__current;		// the subset allowed by gs_mask
+static char gs_bufNames[64];
+static SG_uint32 gs_mask = SGHASH_KERNELS__ALL;
+
+// Hashing is done on many threads at once (the work queues), so the
+// probe has to be done exactly once and be visible to all of them
+// before any of them looks at gs_kernels__current.
+#if defined(WINDOWS)
+static INIT_ONCE gs_once = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t gs_once = PTHREAD_ONCE_INIT;
+#endif
+
+static void _probe(struct _sghash_kernels * pk)
+{
+#if defined(SGHASH_HAVE_X86_KERNELS)
+	SG_uint32 r0[4], r1[4], r7[4];
+	int bSSSE3, bSSE41, bOSAVX;
+
+	_cpuid(0, 0, r0);
+	if (r0[0] < 7)
+		return;
+
+	_cpuid(1, 0, r1);
+	_cpuid(7, 0, r7);
+
+	bSSSE3 = ((r1[2] & (1u <<  9)) != 0);
+	bSSE41 = ((r1[2] & (1u << 19)) != 0);
+	bOSAVX = ((r1[2] & (1u << 27)) != 0) && ((r1[2] & (1u << 28)) != 0) && ((_xgetbv0() & 6) == 6);
+
+	if (bSSSE3 && bSSE41 && ((r7[1] & (1u << 29)) != 0))
+	{
+		pk->fn_sha1_blocks   = _sha1_blocks__shani;
+		pk->fn_sha256_blocks = _sha256_blocks__shani;
+	}
+
+	if (bOSAVX && ((r7[1] & (1u << 5)) != 0))
+		pk->fn_sha256_blocks_x8 = _sha256_blocks_x8__avx2;
+#else
+	SG_UNUSED(pk);
+#endif
+}
+
+static void _select(void)
+{
+	struct _sghash_kernels k;
+
+	memset(&k, 0, sizeof(k));
+	gs_bufNames[0] = 0;
+
+	if (gs_mask & SGHASH_KERNELS__SHA_NI)
+	{
+		k.fn_sha1_blocks   = gs_kernels__available.fn_sha1_blocks;
+		k.fn_sha256_blocks = gs_kernels__available.fn_sha256_blocks;
+		if (k.fn_sha256_blocks)
+			strcat(gs_bufNames, "SHA-NI ");
+	}
+
+	if (gs_mask & SGHASH_KERNELS__AVX2)
+	{
+		k.fn_sha256_blocks_x8 = gs_kernels__available.fn_sha256_blocks_x8;
+		if (k.fn_sha256_blocks_x8)
+			strcat(gs_bufNames, "AVX2 ");
+	}
+
+	if (gs_bufNames[0])
+		gs_bufNames[strlen(gs_bufNames) - 1] = 0;
+	else
+		strcat(gs_bufNames, "portable");
+
+	k.pszNames = gs_bufNames;
+	gs_kernels__current = k;
+}
+
+static void _probe_and_select(void)
+{
+	_probe(&gs_kernels__available);
+	_select();
+}
+
+#if defined(WINDOWS)
+static BOOL CALLBACK _init_once_cb(PINIT_ONCE pOnce, PVOID pParam, PVOID * ppContext)
+{
+	SG_UNUSED(pOnce);
+	SG_UNUSED(pParam);
+	SG_UNUSED(ppContext);
+
+	_probe_and_select();
+	return TRUE;
+}
+#endif
+
+const struct _sghash_kernels * sghash__get_kernels(void)
+{
+#if defined(WINDOWS)
+	(void)InitOnceExecuteOnce(&gs_once, _init_once_cb, NULL, NULL);
+#else
+	(void)pthread_once(&gs_once, _probe_and_select);
+#endif
+
+	return &gs_kernels__current;
+}
+
+//////////////////////////////////////////////////////////////////
+
+const char * SGHASH_get_kernel_names(void)
+{
+	return sghash__get_kernels()->pszNames;
+}
+
+void SGHASH_set_kernels(SG_uint32 mask)
+{
+	(void)sghash__get_kernels();
+
+	gs_mask = mask;
+	_select();
+}
@@ -27,6 +27,7 @@ limitations under the License.
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <sg_defines.h>
 #include <sg_stdint.h>
@@ -137,15 +138,273 @@ fail:
 	exit(1);
 }
 
+//////////////////////////////////////////////////////////////////
+// Check the processor-specific kernels (see sghash_kernels.c)
+// against the portable code.  Every combination of kernels that
+// this machine supports must give the same answers as "none" for
+// odd lengths, odd chunkings and batches of streams.
+
+static SG_uint32 gs_seed = 12345;
+
+static SG_uint32 _rand(void)
+{
+	gs_seed = gs_seed * 1103515245 + 12345;
+	return (gs_seed >> 8);
+}
+
+static const SG_uint32 gs_aMasks[] = { SGHASH_KERNELS__NONE,
+									   SGHASH_KERNELS__SHA_NI,
+									   SGHASH_KERNELS__AVX2,
+									   SGHASH_KERNELS__ALL };
+
+static void _hash_chunked(const char * pszHashMethod, const SG_byte * pBuf, SG_uint32 len, SG_uint32 seed, char * pBufResult)
+{
+	SGHASH_handle * pHandle = NULL;
+	SG_uint32 off = 0;
+
+	gs_seed = seed;
+	if (SGHASH_init(pszHashMethod, &pHandle) != SG_ERR_OK)
+		exit(1);
+	while (off < len)
+	{
+		SG_uint32 n = _rand() % 300;
+		if (n > len - off)
+			n = len - off;
+		SGHASH_update(pHandle, pBuf + off, n);
+		off += n;
+	}
+	if (SGHASH_final(&pHandle, pBufResult, 1000) != SG_ERR_OK)
+		exit(1);
+}
+
+static void _hash_multi(const char * pszHashMethod, const SG_byte * pBuf, const SG_uint32 * aLen, SG_uint32 count, SG_uint32 seed, char aResults[][1000])
+{
+	SGHASH_handle * apHandles[11];
+	const SG_byte * apBufs[11];
+	SG_uint32 aChunk[11];
+	SG_uint32 aOff[11];
+	SG_uint32 k, bMore;
+
+	gs_seed = seed;
+	for (k=0; k<count; k++)
+	{
+		if (SGHASH_init(pszHashMethod, &apHandles[k]) != SG_ERR_OK)
+			exit(1);
+		aOff[k] = 0;
+	}
+
+	do
+	{
+		bMore = 0;
+		for (k=0; k<count; k++)
+		{
+			aChunk[k] = ((_rand() & 3) ? 4096 : (_rand() % 200));
+			if (aChunk[k] > aLen[k] - aOff[k])
+				aChunk[k] = aLen[k] - aOff[k];
+			apBufs[k] = pBuf + k * 7 + aOff[k];
+		}
+		if (SGHASH_update_multi(apHandles, apBufs, aChunk, count) != SG_ERR_OK)
+			exit(1);
+		for (k=0; k<count; k++)
+		{
+			aOff[k] += aChunk[k];
+			if (aOff[k] < aLen[k])
+				bMore = 1;
+		}
+	} while (bMore);
+
+	for (k=0; k<count; k++)
+		if (SGHASH_final(&apHandles[k], aResults[k], 1000) != SG_ERR_OK)
+			exit(1);
+}
+
+static void _test_kernels(void)
+{
+	SG_uint32 lenBuf = 1024 * 1024;
+	SG_byte * pBuf = (SG_byte *)malloc(lenBuf);
+	char bufExpected[1000];
+	char bufResult[1000];
+	char aExpected[11][1000];
+	char aResults[11][1000];
+	SG_uint32 aLen[11];
+	SG_uint32 n, kMethod, kMask, kTrial, k;
+
+	for (k=0; k<lenBuf; k++)
+		pBuf[k] = (SG_byte)_rand();
+
+	fprintf(stderr, "Kernels available: %s\n", SGHASH_get_kernel_names());
+
+	for (kMethod=0; ; kMethod++)
+	{
+		char bufMethod[100];
+
+		if (SGHASH_get_nth_hash_method_name(kMethod, bufMethod, sizeof(bufMethod), NULL) != SG_ERR_OK)
+			break;
+
+		for (kTrial=0; kTrial<200; kTrial++)
+		{
+			n = ((kTrial < 150) ? kTrial * 7 : (_rand() % (lenBuf / 2)));
+
+			SGHASH_set_kernels(SGHASH_KERNELS__NONE);
+			_hash_chunked(bufMethod, pBuf, n, kTrial, bufExpected);
+
+			for (kMask=1; kMask<SG_NrElements(gs_aMasks); kMask++)
+			{
+				SGHASH_set_kernels(gs_aMasks[kMask]);
+				_hash_chunked(bufMethod, pBuf, n, kTrial + 1000, bufResult);
+				if (strcmp(bufResult, bufExpected) != 0)
+				{
+					fprintf(stderr, "%s [%s] length %u: received %s expected %s\n",
+							bufMethod, SGHASH_get_kernel_names(), n, bufResult, bufExpected);
+					exit(1);
+				}
+			}
+		}
+
+		for (kTrial=0; kTrial<40; kTrial++)
+		{
+			SG_uint32 count = 1 + (kTrial % SG_NrElements(aLen));
+
+			for (k=0; k<count; k++)
+				aLen[k] = ((kTrial & 1) ? 65536 : (_rand() % 70000));
+
+			SGHASH_set_kernels(SGHASH_KERNELS__NONE);
+			for (k=0; k<count; k++)
+				_hash_chunked(bufMethod, pBuf + k * 7, aLen[k], kTrial, aExpected[k]);
+
+			for (kMask=0; kMask<SG_NrElements(gs_aMasks); kMask++)
+			{
+				SGHASH_set_kernels(gs_aMasks[kMask]);
+				_hash_multi(bufMethod, pBuf, aLen, count, kTrial, aResults);
+				for (k=0; k<count; k++)
+				{
+					if (strcmp(aResults[k], aExpected[k]) != 0)
+					{
+						fprintf(stderr, "%s [%s] multi %u/%u length %u: received %s expected %s\n",
+								bufMethod, SGHASH_get_kernel_names(), k, count, aLen[k], aResults[k], aExpected[k]);
+						exit(1);
+					}
+				}
+			}
+		}
+	}
+
+	// the million 'a's vectors from FIPS 180-2 go through the block loops, not just final.
+
+	memset(pBuf, 'a', 1000000);
+	for (kMask=0; kMask<SG_NrElements(gs_aMasks); kMask++)
+	{
+		SGHASH_set_kernels(gs_aMasks[kMask]);
+		try_one__raw("SHA1/160", pBuf, 1000000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+		try_one__raw("SHA2/256", pBuf, 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+	}
+
+	SGHASH_set_kernels(SGHASH_KERNELS__ALL);
+	free(pBuf);
+}
+
+//////////////////////////////////////////////////////////////////
+// A simple throughput benchmark: MB/s for each hash-method with
+// and without the kernels, and for 8 streams at once through
+// SGHASH_update_multi().
+
+static double _bench_one(const char * pszHashMethod, const SG_byte * pBuf, SG_uint32 lenBuf, SG_uint32 nrStreams, SG_uint32 nrMB)
+{
+	SGHASH_handle * apHandles[8];
+	const SG_byte * apBufs[8];
+	SG_uint32 aLen[8];
+	char aResults[8][1000];
+	SG_uint32 chunk = 64 * 1024;
+	SG_uint32 nrChunks = (nrMB * 1024 * 1024) / (chunk * nrStreams);
+	SG_uint32 k, j;
+	clock_t t0, t1;
+	double secs;
+
+	for (k=0; k<nrStreams; k++)
+	{
+		SGHASH_init(pszHashMethod, &apHandles[k]);
+		aLen[k] = chunk;
+	}
+
+	t0 = clock();
+	for (j=0; j<nrChunks; j++)
+	{
+		for (k=0; k<nrStreams; k++)
+			apBufs[k] = pBuf + ((j * nrStreams + k) * chunk) % (lenBuf - chunk);
+		if (nrStreams == 1)
+			SGHASH_update(apHandles[0], apBufs[0], aLen[0]);
+		else
+			SGHASH_update_multi(apHandles, apBufs, aLen, nrStreams);
+	}
+	for (k=0; k<nrStreams; k++)
+		SGHASH_final(&apHandles[k], aResults[k], sizeof(aResults[k]));
+	t1 = clock();
+
+	secs = (double)(t1 - t0) / CLOCKS_PER_SEC;
+	if (secs <= 0.0)
+		secs = 1.0 / CLOCKS_PER_SEC;
+
+	return ((double)nrChunks * nrStreams * chunk) / (1024.0 * 1024.0) / secs;
+}
+
+static void _bench(SG_uint32 nrMB)
+{
+	SG_uint32 lenBuf = 4 * 1024 * 1024;
+	SG_byte * pBuf = (SG_byte *)malloc(lenBuf);
+	SG_uint32 k, kMethod, kMask;
+
+	for (k=0; k<lenBuf; k++)
+		pBuf[k] = (SG_byte)_rand();
+
+	printf("%-12s %-12s %10s %10s\n", "method", "kernels", "1 stream", "8 streams");
+	for (kMethod=0; ; kMethod++)
+	{
+		char bufMethod[100];
+
+		if (SGHASH_get_nth_hash_method_name(kMethod, bufMethod, sizeof(bufMethod), NULL) != SG_ERR_OK)
+			break;
+
+		// only SHA1 and SHA2/256 have kernels; the others just get one line.
+
+		for (kMask=0; kMask<SG_NrElements(gs_aMasks); kMask++)
+		{
+			double mbs1, mbs8;
+
+			if (kMask > 0 && strcmp(bufMethod, "SHA1/160") != 0 && strcmp(bufMethod, "SHA2/256") != 0)
+				break;
+
+			SGHASH_set_kernels(gs_aMasks[kMask]);
+			mbs1 = _bench_one(bufMethod, pBuf, lenBuf, 1, nrMB);
+			mbs8 = _bench_one(bufMethod, pBuf, lenBuf, 8, nrMB);
+			printf("%-12s %-12s %10.1f %10.1f  MB/s\n", bufMethod, SGHASH_get_kernel_names(), mbs1, mbs8);
+		}
+	}
+
+	SGHASH_set_kernels(SGHASH_KERNELS__ALL);
+	free(pBuf);
+}
+
+//////////////////////////////////////////////////////////////////
+
 int main(int argc, char ** argv)
 {
 	if (argc < 2)
 	{
 		fprintf(stderr,"Usage: sghash_test <hash-method>\n");
+		fprintf(stderr,"       sghash_test --kernels\n");
+		fprintf(stderr,"       sghash_test --bench [<megabytes>]\n");
 		exit(1);
 	}
 
-	if (strcmp(argv[1], "SHA1/160") == 0)
+	if (strcmp(argv[1], "--kernels") == 0)
+	{
+		_test_kernels();
+	}
+	else if (strcmp(argv[1], "--bench") == 0)
+	{
+		_bench((argc > 2) ? (SG_uint32)atoi(argv[2]) : 256);
+	}
+	else if (strcmp(argv[1], "SHA1/160") == 0)
 	{
 		// (on the mac at least) we can generate these test values using:
 		// echo -n "a" | shasum -a 1
@@ -160,6 +419,9 @@ int main(int argc, char ** argv)
 		try_one__sz(argv[1],
 					"",
 					"da39a3ee5e6b4b0d3255bfef95601890afd80709");
+		try_one__sz(argv[1],
+					"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+					"84983e441c3bd26ebaae4aa1f95129e5e54670f1");
 	}
 	else if (strcmp(argv[1], "SHA2/256") == 0)
 	{
@@ -175,6 +437,9 @@ int main(int argc, char ** argv)
 		try_one__sz(argv[1],
 					"",
 					"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+		try_one__sz(argv[1],
+					"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+					"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
 	}
 	else if (strcmp(argv[1], "SHA2/384") == 0)
 	{
@@ -93,7 +93,7 @@ static u_int32_t _K[] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
 static void sha1_step(struct sha1_ctxt *);
 
 static void
-sha1_step(
+sha1_step__portable(
 	struct sha1_ctxt *ctxt)
 {
 	u_int32_t	a, b, c, d, e;
@@ -175,6 +175,23 @@ sha1_step(
 	bzero(&ctxt->m.b8[0], 64);
 }
 
+/*
+ * Process the block in ctxt->m, with the processor's SHA instructions
+ * if it has them.  See sghash_kernels.c.
+ */
+static void
+sha1_step(
+	struct sha1_ctxt *ctxt)
+{
+	FN__sha1_blocks * fn_blocks = sghash__get_kernels()->fn_sha1_blocks;
+
+	if (fn_blocks) {
+		(*fn_blocks)(&H(0), &ctxt->m.b8[0], 1);
+		bzero(&ctxt->m.b8[0], 64);
+	} else
+		sha1_step__portable(ctxt);
+}
+
 /*------------------------------------------------------------*/
 
 static void
@@ -234,6 +251,8 @@ sha1_loop(
 	size_t gapstart;
 	size_t off;
 	size_t copysiz;
+	size_t nrblocks;
+	FN__sha1_blocks * fn_blocks = sghash__get_kernels()->fn_sha1_blocks;
 
 	off = 0;
 
@@ -241,6 +260,18 @@ sha1_loop(
 		gapstart = COUNT % 64;
 		gaplen = 64 - gapstart;
 
+		/*
+		 * When we have a kernel, hash whole blocks directly out of
+		 * the caller's buffer instead of copying them through m.
+		 */
+		if (fn_blocks && gapstart == 0 && len - off >= 64) {
+			nrblocks = (len - off) / 64;
+			(*fn_blocks)(&H(0), &input[off], (SG_uint32)nrblocks);
+			ctxt->c.b64[0] += (u_int64_t)nrblocks * 64 * 8;
+			off += nrblocks * 64;
+			continue;
+		}
+
 		copysiz = (gaplen < len - off) ? gaplen : len - off;
 		bcopy(&input[off], &ctxt->m.b8[gapstart], copysiz);
 		COUNT += copysiz;
@@ -321,5 +352,6 @@ const SGHASH_algorithm SGHASH_alg__sha1 = { "SHA1/160",
 											SHA1_RESULTLEN * 2,
 											sg__sha1_init,
 											sg__sha1_update,
-											sg__sha1_final 
+											sg__sha1_final,
+											NULL
 };
@@ -500,6 +500,26 @@ static void SHA256_Transform(SHA256_CTX* context, const sha2_word32* data) {
 
 #endif /* SHA2_UNROLL_TRANSFORM */
 
+/*
+ * Process some whole blocks, with the processor's SHA instructions
+ * if it has them (see sghash_kernels.c).  The portable transform
+ * uses context->buffer as scratch space, so it must not be given
+ * data that lives in the buffer other than the buffer itself.
+ */
+static void SHA256_Blocks(SHA256_CTX* context, const sha2_byte *data, size_t nrBlocks) {
+	FN__sha256_blocks *fn_blocks = sghash__get_kernels()->fn_sha256_blocks;
+
+	if (fn_blocks) {
+		(*fn_blocks)(context->state, data, (SG_uint32)nrBlocks);
+		return;
+	}
+
+	while (nrBlocks-- > 0) {
+		SHA256_Transform(context, (const sha2_word32*)data);
+		data += SHA256_BLOCK_LENGTH;
+	}
+}
+
 static void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len) {
 	unsigned int	freespace, usedspace;
 
@@ -522,7 +542,7 @@ static void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len
 			context->bitcount += freespace << 3;
 			len -= freespace;
 			data += freespace;
-			SHA256_Transform(context, (sha2_word32*)context->buffer);
+			SHA256_Blocks(context, context->buffer, 1);
 		} else {
 			/* The buffer is not yet full */
 			bcopy(data, &context->buffer[usedspace], len);
@@ -532,12 +552,14 @@ static void SHA256_Update(SHA256_CTX* context, const sha2_byte *data, size_t len
 			return;
 		}
 	}
-	while (len >= SHA256_BLOCK_LENGTH) {
+	if (len >= SHA256_BLOCK_LENGTH) {
 		/* Process as many complete blocks as we can */
-		SHA256_Transform(context, (const sha2_word32*)data);
-		context->bitcount += SHA256_BLOCK_LENGTH << 3;
-		len -= SHA256_BLOCK_LENGTH;
-		data += SHA256_BLOCK_LENGTH;
+		size_t nrBlocks = len / SHA256_BLOCK_LENGTH;
+
+		SHA256_Blocks(context, data, nrBlocks);
+		context->bitcount += (sha2_word64)nrBlocks * SHA256_BLOCK_LENGTH * 8;
+		len -= nrBlocks * SHA256_BLOCK_LENGTH;
+		data += nrBlocks * SHA256_BLOCK_LENGTH;
 	}
 	if (len > 0) {
 		/* There's left-overs, so save 'em */
@@ -574,7 +596,7 @@ static void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 					bzero(&context->buffer[usedspace], SHA256_BLOCK_LENGTH - usedspace);
 				}
 				/* Do second-to-last transform: */
-				SHA256_Transform(context, (sha2_word32*)context->buffer);
+				SHA256_Blocks(context, context->buffer, 1);
 
 				/* And set-up for the last transform: */
 				bzero(context->buffer, SHA256_SHORT_BLOCK_LENGTH);
@@ -590,7 +612,7 @@ static void SHA256_Final(sha2_byte digest[], SHA256_CTX* context) {
 		*(sha2_word64*)&context->buffer[SHA256_SHORT_BLOCK_LENGTH] = context->bitcount;
 
 		/* Final transform: */
-		SHA256_Transform(context, (sha2_word32*)context->buffer);
+		SHA256_Blocks(context, context->buffer, 1);
 
 #if BYTE_ORDER == LITTLE_ENDIAN
 		{
@@ -1063,12 +1085,105 @@ static void sg__sha2_256_final(void * pAlgCtx, char * pszResult)
 	(void)SHA256_End( (SHA256_CTX *)pAlgCtx, pszResult );
 }
 
+/**
+ * Don't bother with the 8-lane kernel unless at least this many
+ * streams have a whole block.  It costs the same no matter how many
+ * lanes are in use, so with fewer streams it is slower than doing
+ * them one at a time.
+ */
+#define SHA256_MULTI_MIN_LANES		3
+
+static void sg__sha2_256_update_multi(void ** apAlgCtx, const SG_byte ** apBufs, const SG_uint32 * aLenBufs, SG_uint32 count)
+{
+	FN__sha256_blocks_x8 * fn_x8 = sghash__get_kernels()->fn_sha256_blocks_x8;
+	SHA256_CTX * apCtx[8];
+	const sha2_byte * apData[8];
+	size_t aLen[8];
+	SG_uint32 * apStateLane[8];
+	const SG_byte * apDataLane[8];
+	SG_uint32 aStateUnused[8];
+	SG_uint32 aLane[8];
+	SG_uint32 k, nrLanes;
+	size_t nrBlocks, used, n;
+
+	assert(count <= 8);
+
+	/* The single stream SHA-NI kernel beats the 8-lane one, so prefer it. */
+	if (!fn_x8 || sghash__get_kernels()->fn_sha256_blocks || count < SHA256_MULTI_MIN_LANES) {
+		for (k = 0; k < count; k++)
+			SHA256_Update((SHA256_CTX *)apAlgCtx[k], (const sha2_byte *)apBufs[k], aLenBufs[k]);
+		return;
+	}
+
+	/* Top up any partially filled buffers so that every stream is block aligned. */
+	for (k = 0; k < count; k++) {
+		apCtx[k] = (SHA256_CTX *)apAlgCtx[k];
+		apData[k] = (const sha2_byte *)apBufs[k];
+		aLen[k] = aLenBufs[k];
+
+		used = (apCtx[k]->bitcount >> 3) % SHA256_BLOCK_LENGTH;
+		if (used > 0) {
+			n = SHA256_BLOCK_LENGTH - used;
+			if (n > aLen[k])
+				n = aLen[k];
+			SHA256_Update(apCtx[k], apData[k], n);
+			apData[k] += n;
+			aLen[k] -= n;
+		}
+	}
+
+	memset(aStateUnused, 0, sizeof(aStateUnused));
+
+	/*
+	 * Run the streams that have whole blocks side by side, for as many
+	 * blocks as the shortest of them has.  Unused lanes hash a copy of
+	 * lane 0's data into a throw-away state.
+	 */
+	for (;;) {
+		nrLanes = 0;
+		nrBlocks = 0;
+		for (k = 0; k < count; k++) {
+			if (aLen[k] >= SHA256_BLOCK_LENGTH) {
+				n = aLen[k] / SHA256_BLOCK_LENGTH;
+				if (nrLanes == 0 || n < nrBlocks)
+					nrBlocks = n;
+				aLane[nrLanes++] = k;
+			}
+		}
+		if (nrLanes < SHA256_MULTI_MIN_LANES)
+			break;
+
+		for (k = 0; k < 8; k++) {
+			if (k < nrLanes) {
+				apStateLane[k] = apCtx[aLane[k]]->state;
+				apDataLane[k] = apData[aLane[k]];
+			} else {
+				apStateLane[k] = aStateUnused;
+				apDataLane[k] = apData[aLane[0]];
+			}
+		}
+
+		(*fn_x8)(apStateLane, apDataLane, (SG_uint32)nrBlocks);
+
+		for (k = 0; k < nrLanes; k++) {
+			apCtx[aLane[k]]->bitcount += (sha2_word64)nrBlocks * SHA256_BLOCK_LENGTH * 8;
+			apData[aLane[k]] += nrBlocks * SHA256_BLOCK_LENGTH;
+			aLen[aLane[k]] -= nrBlocks * SHA256_BLOCK_LENGTH;
+		}
+	}
+
+	for (k = 0; k < count; k++)
+		if (aLen[k] > 0)
+			SHA256_Update(apCtx[k], apData[k], aLen[k]);
+}
+
 const SGHASH_algorithm SGHASH_alg__sha2_256 = { "SHA2/256",
 												(SG_uint32)sizeof(SHA256_CTX),
 												SHA256_DIGEST_LENGTH * 2,
 												sg__sha2_256_init,
 												sg__sha2_256_update,
-												sg__sha2_256_final 
+												sg__sha2_256_final,
+												sg__sha2_256_update_multi
 };
 
 //////////////////////////////////////////////////////////////////
@@ -1093,7 +1208,8 @@ const SGHASH_algorithm SGHASH_alg__sha2_384 = { "SHA2/384",
 												SHA384_DIGEST_LENGTH * 2,
 												sg__sha2_384_init,
 												sg__sha2_384_update,
-												sg__sha2_384_final 
+												sg__sha2_384_final,
+												NULL
 };
 
 //////////////////////////////////////////////////////////////////
@@ -1118,5 +1234,6 @@ const SGHASH_algorithm SGHASH_alg__sha2_512 = { "SHA2/512",
 												SHA512_DIGEST_LENGTH * 2,
 												sg__sha2_512_init,
 												sg__sha2_512_update,
-												sg__sha2_512_final 
+												sg__sha2_512_final,
+												NULL
 };
@@ -809,7 +809,8 @@ const SGHASH_algorithm SGHASH_alg__skein_256 = { "SKEIN/256",
 												 ((256 / 8) * 2),
 												 sg__skein_256_256_init,
 												 sg__skein_256_update,
-												 sg__skein_256_final
+												 sg__skein_256_final,
+												 NULL
 };
 
 //////////////////////////////////////////////////////////////////
@@ -849,7 +850,8 @@ const SGHASH_algorithm SGHASH_alg__skein_512 = { "SKEIN/512",
 												 ((512 / 8) * 2),
 												 sg__skein_512_512_init,
 												 sg__skein_512_update,
-												 sg__skein_512_final
+												 sg__skein_512_final,
+												 NULL
 };
 
 //////////////////////////////////////////////////////////////////
@@ -889,7 +891,8 @@ const SGHASH_algorithm SGHASH_alg__skein_1024 = { "SKEIN/1024",
 												 ((1024 / 8) * 2),
 												 sg__skein_1024_1024_init,
 												 sg__skein_1024_update,
-												 sg__skein_1024_final
+												 sg__skein_1024_final,
+												 NULL
 };
 
 //////////////////////////////////////////////////////////////////
@@ -905,7 +908,8 @@ const SGHASH_algorithm SGHASH_alg__skein_160 = { "SKEIN/160",
 												 ((160 / 8) * 2),
 												 sg__skein_256_160_init,
 												 sg__skein_256_update,
-												 sg__skein_256_final
+												 sg__skein_256_final,
+												 NULL
 };
 #endif
 
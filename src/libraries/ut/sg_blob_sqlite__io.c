@@ -955,7 +955,8 @@ static void _change_encoding_to_vcdiff(SG_context* pCtx,
 									   sqlite3* psql,
 									   SG_uint64 len_full,
 									   const char* psz_hid_blob,
-									   const char* psz_hid_vcdiff_reference)
+									   const char* psz_hid_vcdiff_reference,
+									   const SG_vcdiff_options* pVcdiffOptions)
 {
 	sg_blob_sqlite_handle_fetch* pfh;
 	blob_seekreader* psr_reference = NULL;
@@ -982,14 +983,15 @@ static void _change_encoding_to_vcdiff(SG_context* pCtx,
 	SG_ERR_CHECK(  SG_writestream__alloc(pCtx, pTempfile->pFile,
 		(SG_stream__func__write*)SG_file__write, NULL, &pstrmDelta)  );
 
-	SG_ERR_CHECK(  SG_vcdiff__deltify__streams(pCtx, psr_reference->pSeekreader, pstrmTarget, pstrmDelta)  );
+	SG_ERR_CHECK(  SG_vcdiff__deltify__streams__options(pCtx, psr_reference->pSeekreader, pstrmTarget, pstrmDelta, pVcdiffOptions)  );
 
 	SG_ERR_CHECK(  SG_writestream__get_count(pCtx, pstrmDelta, &len_encoded)  );
 
 	SG_ERR_CHECK(  SG_readstream__close(pCtx, pstrmTarget)  );
 	pstrmTarget = NULL;
-	SG_ERR_CHECK(  SG_writestream__close(pCtx, pstrmDelta)  );
+	SG_writestream__close(pCtx, pstrmDelta);
 	pstrmDelta = NULL;
+	SG_ERR_CHECK_CURRENT;
 
 	SG_ERR_IGNORE(  _blob_seekreader_nullfree(pCtx, &psr_reference)  );
 
@@ -1034,6 +1036,36 @@ fail:
 	}
 }
 
+void sg_blob_sqlite__replace_blob_encoding(SG_context* pCtx,
+										   sg_repo_tx_sqlite_handle* pTx,
+										   sqlite3* psql,
+										   const char* psz_hid_blob,
+										   SG_blob_encoding blob_encoding,
+										   const char* psz_hid_vcdiff_reference,
+										   SG_uint64 len_full,
+										   SG_uint32 len_encoded,
+										   const SG_byte* p_encoded)
+{
+	sg_blob_sqlite_handle_store* psh = NULL;
+
+	SG_NULLARGCHECK_RETURN(pTx);
+	SG_NULLARGCHECK_RETURN(psql);
+	SG_NULLARGCHECK_RETURN(psz_hid_blob);
+	SG_NULLARGCHECK_RETURN(p_encoded);
+
+	SG_ERR_CHECK(  sg_blob_sqlite__store_blob__begin(pCtx, pTx, psql, blob_encoding, psz_hid_vcdiff_reference,
+		len_full, SG_IS_BLOBENCODING_FULL(blob_encoding) ? 0 : len_encoded, psz_hid_blob, SG_FALSE, &psh)  );
+	psh->b_changing_encoding = SG_TRUE;
+
+	SG_ERR_CHECK(  sg_blob_sqlite__store_blob__chunk(pCtx, psh, len_encoded, p_encoded, NULL)  );
+	SG_ERR_CHECK(  sg_blob_sqlite__store_blob__end(pCtx, pTx, &psh, NULL)  );
+
+	return;
+
+fail:
+	if (psh)
+		SG_ERR_IGNORE(  sg_blob_sqlite__store_blob__abort(pCtx, pTx, &psh)  );
+}
 
 void sg_blob_sqlite__change_blob_encoding(SG_context* pCtx,
 										  sg_repo_tx_sqlite_handle* pTx,
@@ -1041,6 +1073,7 @@ void sg_blob_sqlite__change_blob_encoding(SG_context* pCtx,
 										  const char* psz_hid_blob,
 										  SG_blob_encoding blob_encoding_desired,
 										  const char* psz_hid_vcdiff_reference_desired,
+										  const SG_vcdiff_options* pVcdiffOptions,
 										  SG_blob_encoding* p_blob_encoding_new,
 										  char** ppsz_hid_vcdiff_reference,
 										  SG_uint64* p_len_encoded,
@@ -1096,7 +1129,7 @@ void sg_blob_sqlite__change_blob_encoding(SG_context* pCtx,
 			if (SG_BLOBENCODING__VCDIFF != blob_encoding_stored)
 			{
 				SG_ERR_CHECK(  _change_encoding_to_vcdiff(pCtx, pTx, psql, len_full_stored,
-					psz_hid_blob, (const char*)psz_hid_vcdiff_reference_desired)  );
+					psz_hid_blob, (const char*)psz_hid_vcdiff_reference_desired, pVcdiffOptions)  );
 			}
 			break;
 
@@ -72,6 +72,13 @@ struct SG_changeset
         SG_vhash* pvh;
         char* psz_hid;
     } frozen;
+
+    /**
+     * Changesets loaded from the repo are shared with the repo's
+     * object cache.  This counts the references beyond the first;
+     * see SG_objcache__share().
+     */
+    SG_uint32 nShares;
 };
 
 //////////////////////////////////////////////////////////////////
@@ -154,6 +161,11 @@ void SG_changeset__free(SG_context * pCtx, SG_changeset * pChangeset)
 		return;
     }
 
+    if (SG_objcache__unshare(&pChangeset->nShares))
+    {
+        return;
+    }
+
 	SG_VHASH_NULLFREE(pCtx, pChangeset->frozen.pvh);
 	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pChangeset->constructing.prb_bloblists, (SG_free_callback*) SG_rbtree__free);
 	SG_RBTREE_NULLFREE(pCtx, pChangeset->constructing.prb_parents);
@@ -164,6 +176,13 @@ void SG_changeset__free(SG_context * pCtx, SG_changeset * pChangeset)
 	SG_NULLFREE(pCtx, pChangeset);
 }
 
+void SG_changeset__addref(SG_context * pCtx, SG_changeset * pChangeset)
+{
+    SG_UNUSED(pCtx);
+
+    SG_objcache__share(&pChangeset->nShares);
+}
+
 void SG_changeset__get_bloblist_name(
         SG_context* pCtx,
         SG_uint16 iBlobRefType,
@@ -680,47 +699,34 @@ fail:
     SG_RBTREE_NULLFREE(pCtx, prb_alloc);
 }
 
-static void _sg_changeset__get_big_bloblist(SG_context * pCtx, SG_repo * pRepo, SG_stringarray* psa_trail, SG_rbtree** pprb)
+static void _sg_changeset__get_big_lists(
+        SG_context * pCtx,
+        SG_repo * pRepo,
+        SG_stringarray* psa_trail,
+        SG_bool b_treepaths,
+        SG_rbtree** pprb_blobs,
+        SG_rbtree** pprb_treepaths
+        )
 {
-    SG_changeset* pcs = NULL;
-    SG_rbtree* prb = NULL;
-    SG_vhash* pvh_lbl = NULL;
-    SG_uint32 count = 0;
-    SG_uint32 i = 0;
-
-    SG_ERR_CHECK(  SG_stringarray__count(pCtx, psa_trail, &count)  );
-    SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &prb)  );
-
-    for (i=0; i<count; i++)
-    {
-        const char* psz_csid = NULL;
-
-        SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psa_trail, i, &psz_csid)  );
-        SG_ERR_CHECK(  SG_changeset__load_from_repo(pCtx, pRepo, psz_csid, &pcs)  );
-        SG_ERR_CHECK(  SG_changeset__get_list_of_bloblists(pCtx, pcs, &pvh_lbl)  );
-        SG_ERR_CHECK(  _sg_changeset__add_to_big_bloblist(pCtx, prb, pvh_lbl)  );
-        SG_CHANGESET_NULLFREE(pCtx, pcs);
-    }
+    // load each changeset on the trail exactly once and fold it into
+    // both the big bloblist and (if wanted) the big treepath list.
 
-    *pprb = prb;
-    prb = NULL;
-
-fail:
-    SG_CHANGESET_NULLFREE(pCtx, pcs);
-    SG_RBTREE_NULLFREE(pCtx, prb);
-}
-
-static void _sg_changeset__get_big_treepathlist(SG_context * pCtx, SG_repo * pRepo, SG_stringarray* psa_trail, SG_rbtree** pprb)
-{
     SG_changeset* pcs = NULL;
-    SG_rbtree* prb = NULL;
+    SG_rbtree* prb_blobs = NULL;
+    SG_rbtree* prb_treepaths = NULL;
+    SG_vhash* pvh_lbl = NULL;
     SG_vhash* pvh_treepaths = NULL;
     SG_uint32 count = 0;
     SG_uint32 i = 0;
     SG_string* pstr = NULL;
 
     SG_ERR_CHECK(  SG_stringarray__count(pCtx, psa_trail, &count)  );
-    SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &prb)  );
+    SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &prb_blobs)  );
+    if (b_treepaths)
+    {
+        SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &prb_treepaths)  );
+        SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
+    }
 
     for (i=0; i<count; i++)
     {
@@ -728,290 +734,360 @@ static void _sg_changeset__get_big_treepathlist(SG_context * pCtx, SG_repo * pRe
 
         SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psa_trail, i, &psz_csid)  );
         SG_ERR_CHECK(  SG_changeset__load_from_repo(pCtx, pRepo, psz_csid, &pcs)  );
-        SG_ERR_CHECK(  SG_changeset__get_treepaths(pCtx, pcs, &pvh_treepaths)  );
-        if (pvh_treepaths)
-        {
-            SG_uint32 count_treepaths = 0;
-            SG_uint32 i = 0;
+        SG_ERR_CHECK(  SG_changeset__get_list_of_bloblists(pCtx, pcs, &pvh_lbl)  );
+        SG_ERR_CHECK(  _sg_changeset__add_to_big_bloblist(pCtx, prb_blobs, pvh_lbl)  );
 
-            SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_treepaths, &count_treepaths)  );
-            for (i=0; i<count_treepaths; i++)
+        if (b_treepaths)
+        {
+            SG_ERR_CHECK(  SG_changeset__get_treepaths(pCtx, pcs, &pvh_treepaths)  );
+            if (pvh_treepaths)
             {
-                const char* psz_gid = NULL;
-                const SG_variant* pv = NULL;
-                const char* psz_path = NULL;
+                SG_uint32 count_treepaths = 0;
+                SG_uint32 j = 0;
+
+                SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_treepaths, &count_treepaths)  );
+                for (j=0; j<count_treepaths; j++)
+                {
+                    const char* psz_gid = NULL;
+                    const SG_variant* pv = NULL;
+                    const char* psz_path = NULL;
 
-                SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_treepaths, i, &psz_gid, &pv)  );
-                SG_ERR_CHECK(  SG_variant__get__sz(pCtx, pv, &psz_path)  );
+                    SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_treepaths, j, &psz_gid, &pv)  );
+                    SG_ERR_CHECK(  SG_variant__get__sz(pCtx, pv, &psz_path)  );
 
-                SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
-                SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstr, "%s.%s", psz_gid, psz_path)  );
-                SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb, SG_string__sz(pstr))  );
-                SG_STRING_NULLFREE(pCtx, pstr);
+                    SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstr, "%s.%s", psz_gid, psz_path)  );
+                    SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb_treepaths, SG_string__sz(pstr))  );
+                }
             }
         }
         SG_CHANGESET_NULLFREE(pCtx, pcs);
     }
 
-    *pprb = prb;
-    prb = NULL;
+    *pprb_blobs = prb_blobs;
+    prb_blobs = NULL;
+    if (pprb_treepaths)
+    {
+        *pprb_treepaths = prb_treepaths;
+        prb_treepaths = NULL;
+    }
 
 fail:
     SG_STRING_NULLFREE(pCtx, pstr);
     SG_CHANGESET_NULLFREE(pCtx, pcs);
-    SG_RBTREE_NULLFREE(pCtx, prb);
+    SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, prb_blobs, (SG_free_callback*) SG_rbtree__free);
+    SG_RBTREE_NULLFREE(pCtx, prb_treepaths);
 }
 
-static void x_walk_back(
+typedef struct
+{
+    const char* psz_csid;       // owned by the frame below (or the caller)
+    SG_dagnode* pdn;
+    const char** paParents;
+    SG_uint32 count_parents;
+    SG_uint32 next_parent;
+    SG_bool b_expanded;
+} sg_changeset__trail_frame;
+
+static void x_find_dag_trail(
         SG_context* pCtx,
         SG_repo* pRepo,
-        const char* psz_csid_cur,
-        SG_dagnode* pdn_to,
-        SG_stringarray* psa,
-        SG_bool* pb_found
+        const char* psz_csid_from,
+        const char* psz_csid_to,
+        SG_stringarray** ppsa,
+        SG_uint32* pnr_expanded     // optional: how many changesets had their parents walked
         )
 {
-	SG_dagnode* pdn_cur = NULL;
-	SG_uint32 count_parents = 0;
-	SG_uint32 i = 0;
-	const char** paParents = NULL;
-    SG_bool b_found = SG_FALSE;
-    const char* psz_csid_to = NULL;
+    // Depth-first search from psz_csid_from back to psz_csid_to, trying
+    // parents in dagnode order.  This finds the same trail the old
+    // recursive walk did, but keeps an explicit stack (so long histories
+    // don't blow the C stack) and remembers every changeset which has
+    // already been shown not to lead to psz_csid_to.  Without that, a
+    // merge-heavy DAG gets re-walked once for every path through it.
+    //
+    // Changesets at or below the generation of psz_csid_to can never
+    // lead to it and are not expanded.
+
+    SG_stringarray* psa = NULL;
+    SG_dagnode* pdn_to = NULL;
     SG_int32 gen_to = 0;
-    SG_int32 gen_cur = 0;
+    SG_rbtree* prb_dead = NULL;
+    sg_changeset__trail_frame* a_frames = NULL;
+    sg_changeset__trail_frame* a_grown = NULL;
+    SG_uint32 space_frames = 0;
+    SG_uint32 count_frames = 0;
+    SG_bool b_found = SG_FALSE;
+    SG_uint32 nr_expanded = 0;
+    SG_uint32 i = 0;
 
-    SG_ERR_CHECK(  SG_dagnode__get_id_ref(pCtx, pdn_to, &psz_csid_to)  );
+    SG_ASSERT(psz_csid_to);
+    SG_ERR_CHECK(  SG_stringarray__alloc(pCtx, &psa, 5)  );
+    SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, psz_csid_to, &pdn_to)  );
     SG_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pdn_to, &gen_to)  );
+    SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb_dead)  );
 
-    if (0 == strcmp(psz_csid_cur, psz_csid_to))
-    {
-        b_found = SG_TRUE;
-    }
-    else
+    space_frames = 32;
+    SG_ERR_CHECK(  SG_allocN(pCtx, space_frames, a_frames)  );
+    a_frames[0].psz_csid = psz_csid_from;
+    count_frames = 1;
+
+    while (count_frames)
     {
-        SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, psz_csid_cur, &pdn_cur)  );
-        SG_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pdn_cur, &gen_cur)  );
-        if (gen_cur > gen_to)
+        sg_changeset__trail_frame* pf = &a_frames[count_frames - 1];
+
+        if (!pf->b_expanded)
         {
-            SG_ERR_CHECK(  SG_dagnode__get_parents(pCtx, pdn_cur, &count_parents, &paParents)  );
-            for (i=0; i<count_parents; i++)
+            SG_bool b_dead = SG_FALSE;
+
+            pf->b_expanded = SG_TRUE;
+
+            if (0 == strcmp(pf->psz_csid, psz_csid_to))
+            {
+                b_found = SG_TRUE;
+                break;
+            }
+
+            SG_ERR_CHECK(  SG_rbtree__find(pCtx, prb_dead, pf->psz_csid, &b_dead, NULL)  );
+            if (!b_dead)
             {
-                SG_bool b = SG_FALSE;
+                SG_int32 gen_cur = 0;
 
-                SG_ERR_CHECK(  x_walk_back(pCtx, pRepo, paParents[i], pdn_to, psa, &b)  );
-                if (b)
+                SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pf->psz_csid, &pf->pdn)  );
+                SG_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pf->pdn, &gen_cur)  );
+                if (gen_cur > gen_to)
                 {
-                    SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa, psz_csid_cur)  );
-                    b_found = SG_TRUE;
-                    break;
+                    SG_ERR_CHECK(  SG_dagnode__get_parents(pCtx, pf->pdn, &pf->count_parents, &pf->paParents)  );
+                    nr_expanded++;
                 }
             }
         }
-    }
-
-    *pb_found = b_found;
 
-fail:
-    SG_NULLFREE(pCtx, paParents);
-    SG_DAGNODE_NULLFREE(pCtx, pdn_cur);
-}
+        if (pf->next_parent < pf->count_parents)
+        {
+            const char* psz_parent = pf->paParents[pf->next_parent++];
 
-static void x_find_dag_trail(
-        SG_context* pCtx,
-        SG_repo* pRepo,
-        const char* psz_csid_from,
-        const char* psz_csid_to,
-        SG_stringarray** ppsa
-        )
-{
-    SG_stringarray* psa = NULL;
-    SG_dagnode* pdn_to = NULL;
-    SG_bool b_found = SG_FALSE;
+            if (count_frames == space_frames)
+            {
+                SG_ERR_CHECK(  SG_allocN(pCtx, 2 * space_frames, a_grown)  );
+                memcpy(a_grown, a_frames, space_frames * sizeof(sg_changeset__trail_frame));
+                SG_NULLFREE(pCtx, a_frames);
+                a_frames = a_grown;
+                a_grown = NULL;
+                space_frames *= 2;
+            }
 
-    SG_ERR_CHECK(  SG_stringarray__alloc(pCtx, &psa, 5)  );
+            a_frames[count_frames].psz_csid = psz_parent;
+            count_frames++;
+        }
+        else
+        {
+            // every way back from here has been tried
+            SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb_dead, pf->psz_csid)  );
+            SG_NULLFREE(pCtx, pf->paParents);
+            SG_DAGNODE_NULLFREE(pCtx, pf->pdn);
+            memset(pf, 0, sizeof(sg_changeset__trail_frame));
+            count_frames--;
+        }
+    }
 
-    SG_ASSERT(psz_csid_to);
-    SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, psz_csid_to, &pdn_to)  );
-    SG_ERR_CHECK(  x_walk_back(pCtx, pRepo, psz_csid_from, pdn_to, psa, &b_found)  );
+    if (pnr_expanded)
+        *pnr_expanded = nr_expanded;
 
     if (!b_found)
     {
         SG_ERR_THROW(  SG_ERR_NOTIMPLEMENTED  ); // TODO real error
     }
 
+    // the top of the stack is psz_csid_to itself.  the trail is everything
+    // below it, listed starting next to psz_csid_to.
+    for (i=count_frames - 1; i>0; i--)
+    {
+        SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa, a_frames[i - 1].psz_csid)  );
+    }
+
     *ppsa = psa;
     psa = NULL;
 
 fail:
+    if (a_frames)
+    {
+        for (i=0; i<count_frames; i++)
+        {
+            SG_NULLFREE(pCtx, a_frames[i].paParents);
+            SG_DAGNODE_NULLFREE(pCtx, a_frames[i].pdn);
+        }
+        SG_NULLFREE(pCtx, a_frames);
+    }
+    SG_NULLFREE(pCtx, a_grown);
+    SG_RBTREE_NULLFREE(pCtx, prb_dead);
     SG_STRINGARRAY_NULLFREE(pCtx, psa);
     SG_DAGNODE_NULLFREE(pCtx, pdn_to);
 }
 
-static void _sg_changeset__normalize_blob_lists(SG_context * pCtx, SG_changeset * pChangeset, SG_repo * pRepo)
+static void _sg_changeset__normalize_blob_lists(SG_context * pCtx, SG_changeset * pChangeset, SG_uint32 count_parents, SG_rbtree** a_prb_lists)
 {
-    SG_uint32 count_parents = 0;
     SG_uint32 i = 0;
-    SG_daglca* pDagLca = NULL;
-    const char* psz_temp = NULL;
-    char* psz_hid_cs_lca = NULL;
-    SG_rbtree** a_prb_lists = NULL;
     SG_rbtree_iterator* pit = NULL;
     SG_vhash* pvh_counts = NULL;
 	const SG_uint16* p_cur_reftype = NULL;
     SG_bool b = SG_FALSE;
     SG_rbtree* prb_lengths = NULL;
-    SG_stringarray* psa_trail = NULL;
 
-	SG_NULLARGCHECK_RETURN(pChangeset);
-	SG_NULLARGCHECK_RETURN(pRepo);
+    // init the counts
+    SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_counts)  );
+    p_cur_reftype = g_reftypes;
+    while (*p_cur_reftype)
+    {
+        const char* psz_key = NULL;
+        SG_vhash* pvh_dontcare = NULL;
 
-	FAIL_IF_FROZEN(pChangeset);
+        SG_ERR_CHECK(  SG_changeset__get_bloblist_name(pCtx, *p_cur_reftype, &psz_key)  );
+        SG_ERR_CHECK(  SG_vhash__addnew__vhash(pCtx, pvh_counts, psz_key, &pvh_dontcare)  );
+
+        p_cur_reftype++;
+    }
 
-    if (pChangeset->constructing.prb_parents)
+    // go through all the big blob lists and add them to the counts
+    SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &prb_lengths)  );
+    for (i=0; i<count_parents; i++)
     {
-        SG_ERR_CHECK(  SG_rbtree__count(pCtx, pChangeset->constructing.prb_parents, &count_parents)  );
-        if (count_parents > 1)
+        p_cur_reftype = g_reftypes;
+        while (*p_cur_reftype)
         {
-            const char* psz_hid_parent = NULL;
+            const char* psz_key = NULL;
+            const char* psz_len = NULL;
+            SG_rbtree* prb_one_from = NULL;
+            SG_vhash* pvh_one_counts = NULL;
+            const char* psz_hid_blob = NULL;
 
-            // find the LCA
+            SG_ERR_CHECK(  SG_changeset__get_bloblist_name(pCtx, *p_cur_reftype, &psz_key)  );
+            SG_ERR_CHECK(  SG_rbtree__find(pCtx, a_prb_lists[i], psz_key, &b, (void**) &prb_one_from)  );
 
-            SG_ERR_CHECK(  SG_repo__get_dag_lca(pCtx, pRepo, pChangeset->constructing.iDagNum, pChangeset->constructing.prb_parents, &pDagLca)  );
-            SG_ERR_CHECK(  SG_daglca__iterator__first(pCtx,
-                                                      NULL,
-                                                      pDagLca,SG_FALSE,
-                                                      &psz_temp,	// we do not own this
-                                                      NULL,NULL,NULL)  );
-
-            SG_ERR_CHECK(  SG_strdup(pCtx, psz_temp, &psz_hid_cs_lca)  );
-
-            // get a big bloblist for each parent
-            SG_ERR_CHECK(  SG_allocN(pCtx, count_parents, a_prb_lists)  );
-            b = SG_FALSE;
-            i = 0;
-            SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, pChangeset->constructing.prb_parents, &b, &psz_hid_parent, NULL)  );
-            while (b)
+            if (prb_one_from)
             {
-                SG_ERR_CHECK(  x_find_dag_trail(pCtx, pRepo, psz_hid_parent, psz_hid_cs_lca, &psa_trail)  );
-                SG_ERR_CHECK(  _sg_changeset__get_big_bloblist(pCtx, pRepo, psa_trail, &a_prb_lists[i++])  );
-                SG_STRINGARRAY_NULLFREE(pCtx, psa_trail);
+                SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh_counts, psz_key, &pvh_one_counts)  );
 
-                SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid_parent, NULL)  );
-            }
-            SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+                SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_one_from, &b, &psz_hid_blob, (void**) &psz_len)  );
+                while (b)
+                {
+                    SG_ERR_CHECK(  SG_rbtree__update__with_pooled_sz(pCtx, prb_lengths, psz_hid_blob, psz_len)  );
+                    SG_ERR_CHECK(  SG_vhash__addtoval__int64(pCtx, pvh_one_counts, psz_hid_blob, 1)  );
 
-            // init the counts
-            SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_counts)  );
-            p_cur_reftype = g_reftypes;
-            while (*p_cur_reftype)
-            {
-                const char* psz_key = NULL;
-                SG_vhash* pvh_dontcare = NULL;
+                    SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid_blob, (void**) &psz_len)  );
+                }
+                SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+            }
 
-                SG_ERR_CHECK(  SG_changeset__get_bloblist_name(pCtx, *p_cur_reftype, &psz_key)  );
-                SG_ERR_CHECK(  SG_vhash__addnew__vhash(pCtx, pvh_counts, psz_key, &pvh_dontcare)  );
+            p_cur_reftype++;
+        }
+    }
 
-                p_cur_reftype++;
-            }
+    // now find all the blobs with counts too low
+    p_cur_reftype = g_reftypes;
+    while (*p_cur_reftype)
+    {
+        const char* psz_key = NULL;
+        SG_vhash* pvh_one_counts = NULL;
+        SG_uint32 count_this_key = 0;
 
-            // go through all the big blob lists and add them to the counts
-            SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &prb_lengths)  );
-            for (i=0; i<count_parents; i++)
-            {
-                p_cur_reftype = g_reftypes;
-                while (*p_cur_reftype)
-                {
-                    const char* psz_key = NULL;
-                    const char* psz_len = NULL;
-                    SG_rbtree* prb_one_from = NULL;
-                    SG_vhash* pvh_one_counts = NULL;
-                    const char* psz_hid_blob = NULL;
-
-                    SG_ERR_CHECK(  SG_changeset__get_bloblist_name(pCtx, *p_cur_reftype, &psz_key)  );
-                    SG_ERR_CHECK(  SG_rbtree__find(pCtx, a_prb_lists[i], psz_key, &b, (void**) &prb_one_from)  );
-
-                    if (prb_one_from)
-                    {
-                        SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh_counts, psz_key, &pvh_one_counts)  );
-
-                        SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_one_from, &b, &psz_hid_blob, (void**) &psz_len)  );
-                        while (b)
-                        {
-                            SG_ERR_CHECK(  SG_rbtree__update__with_pooled_sz(pCtx, prb_lengths, psz_hid_blob, psz_len)  );
-                            SG_ERR_CHECK(  SG_vhash__addtoval__int64(pCtx, pvh_one_counts, psz_hid_blob, 1)  );
-
-                            SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid_blob, (void**) &psz_len)  );
-                        }
-                        SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
-                    }
-
-                    p_cur_reftype++;
-                }
-            }
+        SG_ERR_CHECK(  SG_changeset__get_bloblist_name(pCtx, *p_cur_reftype, &psz_key)  );
+        SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh_counts, psz_key, &pvh_one_counts)  );
+        SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_one_counts, &count_this_key)  );
+        for (i=0; i<count_this_key; i++)
+        {
+            const char* psz_hid_blob = NULL;
+            const SG_variant * pv = NULL;
+            SG_int64 val = 0;
 
-            // now find all the blobs with counts too low
-            p_cur_reftype = g_reftypes;
-            while (*p_cur_reftype)
+            SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_one_counts, i, &psz_hid_blob, &pv)  );
+            SG_ERR_CHECK(  SG_variant__get__int64(pCtx, pv, &val)  );
+            if (val < count_parents)
             {
-                const char* psz_key = NULL;
-                SG_vhash* pvh_one_counts = NULL;
-                SG_uint32 count_this_key = 0;
-                SG_uint32 i = 0;
-
-                SG_ERR_CHECK(  SG_changeset__get_bloblist_name(pCtx, *p_cur_reftype, &psz_key)  );
-                SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh_counts, psz_key, &pvh_one_counts)  );
-                SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_one_counts, &count_this_key)  );
-                for (i=0; i<count_this_key; i++)
-                {
-                    const char* psz_hid_blob = NULL;
-                    const SG_variant * pv = NULL;
-                    SG_int64 val = 0;
-
-                    SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_one_counts, i, &psz_hid_blob, &pv)  );
-                    SG_ERR_CHECK(  SG_variant__get__int64(pCtx, pv, &val)  );
-                    if (val < count_parents)
-                    {
-                        const char* psz_len = NULL;
-
-                        SG_ERR_CHECK(  SG_rbtree__find(pCtx, prb_lengths, psz_hid_blob, NULL, (void**) &psz_len)  );
-                        SG_ERR_CHECK(  sg_changeset__add_blob_to_list__named(pCtx, pChangeset, psz_hid_blob, psz_key, psz_len)  );
-                    }
-                }
+                const char* psz_len = NULL;
 
-                p_cur_reftype++;
+                SG_ERR_CHECK(  SG_rbtree__find(pCtx, prb_lengths, psz_hid_blob, NULL, (void**) &psz_len)  );
+                SG_ERR_CHECK(  sg_changeset__add_blob_to_list__named(pCtx, pChangeset, psz_hid_blob, psz_key, psz_len)  );
             }
         }
+
+        p_cur_reftype++;
     }
 
 fail:
-    SG_STRINGARRAY_NULLFREE(pCtx, psa_trail);
     SG_VHASH_NULLFREE(pCtx, pvh_counts);
     SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
     SG_RBTREE_NULLFREE(pCtx, prb_lengths);
-    SG_NULLFREE(pCtx, psz_hid_cs_lca);
-    SG_DAGLCA_NULLFREE(pCtx, pDagLca);
-    if (a_prb_lists)
+}
+
+static void _sg_changeset__normalize_treepaths(SG_context * pCtx, SG_changeset * pChangeset, SG_uint32 count_parents, SG_rbtree** a_prb_lists)
+{
+    SG_uint32 count_paths = 0;
+    SG_uint32 i = 0;
+    SG_rbtree_iterator* pit = NULL;
+    SG_vhash* pvh_counts = NULL;
+    SG_bool b = SG_FALSE;
+
+    // init the counts
+    SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_counts)  );
+
+    // go through all the big lists and add them to the counts
+    for (i=0; i<count_parents; i++)
     {
-        for (i=0; i<count_parents; i++)
+        const char* psz_pair = NULL;
+
+        SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, a_prb_lists[i], &b, &psz_pair, NULL)  );
+        while (b)
+        {
+            SG_ERR_CHECK(  SG_vhash__addtoval__int64(pCtx, pvh_counts, psz_pair, 1)  );
+
+            SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_pair, NULL)  );
+        }
+        SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+    }
+
+    // now find all the paths with counts too low
+    SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_counts, &count_paths)  );
+    for (i=0; i<count_paths; i++)
+    {
+        const char* psz_pair = NULL;
+        const SG_variant * pv = NULL;
+        SG_int64 val = 0;
+
+        SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_counts, i, &psz_pair, &pv)  );
+        SG_ERR_CHECK(  SG_variant__get__int64(pCtx, pv, &val)  );
+        if (val < count_parents)
         {
-            SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, a_prb_lists[i], (SG_free_callback*) SG_rbtree__free);
+            char buf_gid[SG_GID_BUFFER_LENGTH];
+
+            memcpy(buf_gid, psz_pair, SG_GID_BUFFER_LENGTH);
+            SG_ASSERT('.' == buf_gid[SG_GID_ACTUAL_LENGTH]);
+            buf_gid[SG_GID_ACTUAL_LENGTH] = 0;
+
+            SG_ERR_CHECK(  SG_changeset__add_treepath(pCtx, pChangeset, buf_gid, psz_pair + SG_GID_BUFFER_LENGTH)  );
         }
-        SG_NULLFREE(pCtx, a_prb_lists);
     }
+
+fail:
+    SG_VHASH_NULLFREE(pCtx, pvh_counts);
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
 }
 
-static void _sg_changeset__normalize_treepaths(SG_context * pCtx, SG_changeset * pChangeset, SG_repo * pRepo)
+static void _sg_changeset__normalize(SG_context * pCtx, SG_changeset * pChangeset, SG_repo * pRepo)
 {
-    SG_uint32 count_paths = 0;
+    // for a merge, the bloblists and treepaths only need to carry the
+    // entries which are not already on every trail from a parent back to
+    // the LCA.  the trails are found once and each changeset on them is
+    // loaded once, shared by both normalizations.
+
     SG_uint32 count_parents = 0;
     SG_uint32 i = 0;
     SG_daglca* pDagLca = NULL;
     const char* psz_temp = NULL;
     char* psz_hid_cs_lca = NULL;
-    SG_rbtree** a_prb_lists = NULL;
+    SG_rbtree** a_prb_blobs = NULL;
+    SG_rbtree** a_prb_treepaths = NULL;
     SG_rbtree_iterator* pit = NULL;
-    SG_vhash* pvh_counts = NULL;
     SG_bool b = SG_FALSE;
+    SG_bool b_treepaths = SG_FALSE;
     SG_stringarray* psa_trail = NULL;
 
 	SG_NULLARGCHECK_RETURN(pChangeset);
@@ -1019,94 +1095,76 @@ static void _sg_changeset__normalize_treepaths(SG_context * pCtx, SG_changeset *
 
 	FAIL_IF_FROZEN(pChangeset);
 
-    if (pChangeset->constructing.prb_parents)
+    if (!pChangeset->constructing.prb_parents)
     {
-        SG_ERR_CHECK(  SG_rbtree__count(pCtx, pChangeset->constructing.prb_parents, &count_parents)  );
-        if (count_parents > 1)
-        {
-            const char* psz_hid_parent = NULL;
-
-            // find the LCA
-
-            SG_ERR_CHECK(  SG_repo__get_dag_lca(pCtx, pRepo, pChangeset->constructing.iDagNum, pChangeset->constructing.prb_parents, &pDagLca)  );
-            SG_ERR_CHECK(  SG_daglca__iterator__first(pCtx,
-                                                      NULL,
-                                                      pDagLca,SG_FALSE,
-                                                      &psz_temp,	// we do not own this
-                                                      NULL,NULL,NULL)  );
-
-            SG_ERR_CHECK(  SG_strdup(pCtx, psz_temp, &psz_hid_cs_lca)  );
-
-            // get a big treepathlist for each parent
-            SG_ERR_CHECK(  SG_allocN(pCtx, count_parents, a_prb_lists)  );
-            b = SG_FALSE;
-            i = 0;
-            SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, pChangeset->constructing.prb_parents, &b, &psz_hid_parent, NULL)  );
-            while (b)
-            {
-                SG_ERR_CHECK(  x_find_dag_trail(pCtx, pRepo, psz_hid_parent, psz_hid_cs_lca, &psa_trail)  );
-                SG_ERR_CHECK(  _sg_changeset__get_big_treepathlist(pCtx, pRepo, psa_trail, &a_prb_lists[i++])  );
-                SG_STRINGARRAY_NULLFREE(pCtx, psa_trail);
-
-                SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid_parent, NULL)  );
-            }
-            SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+        return;
+    }
 
-            // init the counts
-            SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_counts)  );
+    SG_ERR_CHECK(  SG_rbtree__count(pCtx, pChangeset->constructing.prb_parents, &count_parents)  );
+    if (count_parents > 1)
+    {
+        const char* psz_hid_parent = NULL;
 
-            // go through all the big lists and add them to the counts
-            for (i=0; i<count_parents; i++)
-            {
-                const char* psz_pair = NULL;
+        b_treepaths = !SG_DAGNUM__IS_DB(pChangeset->constructing.iDagNum);
 
-                SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, a_prb_lists[i], &b, &psz_pair, NULL)  );
-                while (b)
-                {
-                    SG_ERR_CHECK(  SG_vhash__addtoval__int64(pCtx, pvh_counts, psz_pair, 1)  );
+        // find the LCA
 
-                    SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_pair, NULL)  );
-                }
-                SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
-            }
+        SG_ERR_CHECK(  SG_repo__get_dag_lca(pCtx, pRepo, pChangeset->constructing.iDagNum, pChangeset->constructing.prb_parents, &pDagLca)  );
+        SG_ERR_CHECK(  SG_daglca__iterator__first(pCtx,
+                                                  NULL,
+                                                  pDagLca,SG_FALSE,
+                                                  &psz_temp,	// we do not own this
+                                                  NULL,NULL,NULL)  );
 
-            // now find all the paths with counts too low
-            SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_counts, &count_paths)  );
-            for (i=0; i<count_paths; i++)
-            {
-                const char* psz_pair = NULL;
-                const SG_variant * pv = NULL;
-                SG_int64 val = 0;
+        SG_ERR_CHECK(  SG_strdup(pCtx, psz_temp, &psz_hid_cs_lca)  );
 
-                SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_counts, i, &psz_pair, &pv)  );
-                SG_ERR_CHECK(  SG_variant__get__int64(pCtx, pv, &val)  );
-                if (val < count_parents)
-                {
-                    char buf_gid[SG_GID_BUFFER_LENGTH];
+        // get the big lists for each parent
+        SG_ERR_CHECK(  SG_allocN(pCtx, count_parents, a_prb_blobs)  );
+        if (b_treepaths)
+        {
+            SG_ERR_CHECK(  SG_allocN(pCtx, count_parents, a_prb_treepaths)  );
+        }
+        b = SG_FALSE;
+        i = 0;
+        SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, pChangeset->constructing.prb_parents, &b, &psz_hid_parent, NULL)  );
+        while (b)
+        {
+            SG_ERR_CHECK(  x_find_dag_trail(pCtx, pRepo, psz_hid_parent, psz_hid_cs_lca, &psa_trail, NULL)  );
+            SG_ERR_CHECK(  _sg_changeset__get_big_lists(pCtx, pRepo, psa_trail, b_treepaths, &a_prb_blobs[i], a_prb_treepaths ? &a_prb_treepaths[i] : NULL)  );
+            i++;
+            SG_STRINGARRAY_NULLFREE(pCtx, psa_trail);
 
-                    memcpy(buf_gid, psz_pair, SG_GID_BUFFER_LENGTH);
-                    SG_ASSERT('.' == buf_gid[SG_GID_ACTUAL_LENGTH]);
-                    buf_gid[SG_GID_ACTUAL_LENGTH] = 0;
+            SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid_parent, NULL)  );
+        }
+        SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
 
-                    SG_ERR_CHECK(  SG_changeset__add_treepath(pCtx, pChangeset, buf_gid, psz_pair + SG_GID_BUFFER_LENGTH)  );
-                }
-            }
+        SG_ERR_CHECK(  _sg_changeset__normalize_blob_lists(pCtx, pChangeset, count_parents, a_prb_blobs)  );
+        if (b_treepaths)
+        {
+            SG_ERR_CHECK(  _sg_changeset__normalize_treepaths(pCtx, pChangeset, count_parents, a_prb_treepaths)  );
         }
     }
 
 fail:
     SG_STRINGARRAY_NULLFREE(pCtx, psa_trail);
-    SG_VHASH_NULLFREE(pCtx, pvh_counts);
     SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
     SG_NULLFREE(pCtx, psz_hid_cs_lca);
     SG_DAGLCA_NULLFREE(pCtx, pDagLca);
-    if (a_prb_lists)
+    if (a_prb_blobs)
     {
         for (i=0; i<count_parents; i++)
         {
-            SG_RBTREE_NULLFREE(pCtx, a_prb_lists[i]);
+            SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, a_prb_blobs[i], (SG_free_callback*) SG_rbtree__free);
         }
-        SG_NULLFREE(pCtx, a_prb_lists);
+        SG_NULLFREE(pCtx, a_prb_blobs);
+    }
+    if (a_prb_treepaths)
+    {
+        for (i=0; i<count_parents; i++)
+        {
+            SG_RBTREE_NULLFREE(pCtx, a_prb_treepaths[i]);
+        }
+        SG_NULLFREE(pCtx, a_prb_treepaths);
     }
 }
 
@@ -1448,11 +1506,7 @@ void SG_changeset__save_to_repo(
 
 	SG_ERR_CHECK(  _sg_changeset__compute_generation(pCtx, pChangeset, pRepo)  );
 
-	SG_ERR_CHECK(  _sg_changeset__normalize_blob_lists(pCtx, pChangeset, pRepo)  );
-    if (!SG_DAGNUM__IS_DB(pChangeset->constructing.iDagNum))
-    {
-        SG_ERR_CHECK(  _sg_changeset__normalize_treepaths(pCtx, pChangeset, pRepo)  );
-    }
+	SG_ERR_CHECK(  _sg_changeset__normalize(pCtx, pChangeset, pRepo)  );
 
 	// serialize changeset into JSON string.
 
@@ -1504,8 +1558,10 @@ void SG_changeset__load_from_repo(
 	// fetch contents of a Changeset-type blob and convert to a Changeset object.
 
 	SG_byte * pbuf = NULL;
+	SG_uint64 lenBuf = 0;
 	SG_changeset * pChangeset = NULL;
 	char* pszidHidCopy = NULL;
+	SG_objcache * pCache = NULL;
 
 	SG_NULLARGCHECK_RETURN(pRepo);
 	SG_NULLARGCHECK_RETURN(pszidHidBlob);
@@ -1513,10 +1569,21 @@ void SG_changeset__load_from_repo(
 
 	*ppChangesetReturned = NULL;
 
+	// changesets are immutable, so if we've already decoded this one
+	// we can just share it.
+
+	SG_ERR_CHECK(  SG_repo__get_objcache__ref(pCtx, pRepo, &pCache)  );
+	if (pCache)
+	{
+		SG_ERR_CHECK(  SG_objcache__lookup(pCtx, pCache, SG_OBJCACHE_TYPE__CHANGESET, pszidHidBlob, (void**)ppChangesetReturned)  );
+		if (*ppChangesetReturned)
+			return;
+	}
+
 	// fetch the Blob for the given HID and convert from a JSON stream into an
 	// allocated Changeset object.
 
-	SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, pszidHidBlob, &pbuf, NULL)  );
+	SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, pszidHidBlob, &pbuf, &lenBuf)  );
 	SG_ERR_CHECK(  my_parse_and_freeze(pCtx, (const char *)pbuf, pszidHidBlob, &pChangeset)  );
 	SG_NULLFREE(pCtx, pbuf);
 
@@ -1527,6 +1594,12 @@ void SG_changeset__load_from_repo(
 	SG_ERR_CHECK(  SG_strdup(pCtx, pszidHidBlob, &pszidHidCopy)  );
 	_sg_changeset__freeze(pCtx, pChangeset,&pszidHidCopy);
 
+	if (pCache)
+		SG_ERR_CHECK(  SG_objcache__add(pCtx, pCache, SG_OBJCACHE_TYPE__CHANGESET, pszidHidBlob, pChangeset,
+										(SG_uint32)lenBuf,
+										(SG_objcache__addref_callback*) SG_changeset__addref,
+										(SG_free_callback*) SG_changeset__free)  );
+
 	*ppChangesetReturned = pChangeset;
     pChangeset = NULL;
 
@@ -1757,5 +1830,19 @@ void SG_changeset__get_treepaths(
     }
 }
 
+void SG_changeset_debug__find_dag_trail(
+        SG_context* pCtx,
+        SG_repo* pRepo,
+        const char* psz_csid_from,
+        const char* psz_csid_to,
+        SG_stringarray** ppsa,
+        SG_uint32* pnr_expanded
+        )
+{
+    SG_NULLARGCHECK_RETURN(pRepo);
+    SG_NONEMPTYCHECK_RETURN(psz_csid_from);
+    SG_NONEMPTYCHECK_RETURN(psz_csid_to);
+    SG_NULLARGCHECK_RETURN(ppsa);
 
-
+    SG_ERR_CHECK_RETURN(  x_find_dag_trail(pCtx, pRepo, psz_csid_from, psz_csid_to, ppsa, pnr_expanded)  );
+}
@@ -97,6 +97,19 @@ void SG_client__push_add(
     SG_ERR_CHECK_RETURN(  pClient->p_vtable->push_add(pCtx, pClient, pPush, ppPath_fragball, ppResult)  );
 }
 
+void SG_client__push_add__stream(
+		SG_context* pCtx,
+        SG_client * pClient,
+        SG_client_push_handle* pPush,
+        SG_fragball_stream** ppFragballStream,
+        SG_vhash** ppResult
+        )
+{
+    VERIFY_VTABLE(pClient);
+
+    SG_ERR_CHECK_RETURN(  pClient->p_vtable->push_add__stream(pCtx, pClient, pPush, ppFragballStream, ppResult)  );
+}
+
 void SG_client__push_remove(
 		SG_context* pCtx,
 		SG_client * pClient,
@@ -145,6 +158,17 @@ void SG_client__pull_request_fragball(SG_context* pCtx,
     SG_ERR_CHECK_RETURN(  pClient->p_vtable->pull_request_fragball(pCtx, pClient, pvhRequest, pStagingPathname, ppszFragballName, ppvhStatus)  );
 }
 
+void SG_client__pull_request_fragball__stream(SG_context* pCtx,
+											  SG_client* pClient,
+											  SG_vhash* pvhRequest,
+											  SG_writestream* pFragballStream,
+											  SG_vhash** ppvhStatus)
+{
+    VERIFY_VTABLE(pClient);
+
+    SG_ERR_CHECK_RETURN(  pClient->p_vtable->pull_request_fragball__stream(pCtx, pClient, pvhRequest, pFragballStream, ppvhStatus)  );
+}
+
 void SG_client__pull_clone(
 	SG_context* pCtx,
 	SG_client* pClient,
@@ -69,6 +69,14 @@ typedef void FN__sg_client__push_add(
         SG_vhash** ppResult
         );
 
+typedef void FN__sg_client__push_add__stream(
+		SG_context* pCtx,
+		SG_client * pClient,
+        SG_client_push_handle* pPush,
+        SG_fragball_stream** ppFragballStream,
+        SG_vhash** ppResult
+        );
+
 typedef void FN__sg_client__push_remove(
 		SG_context* pCtx,
 		SG_client * pClient,
@@ -99,6 +107,14 @@ typedef void FN__sg_client__pull_request_fragball(
 		SG_vhash** ppvhStatus
         );
 
+typedef void FN__sg_client__pull_request_fragball__stream(
+		SG_context* pCtx,
+		SG_client* pClient,
+		SG_vhash* pvhRequest,
+		SG_writestream* pFragballStream,
+		SG_vhash** ppvhStatus
+        );
+
 typedef void FN__sg_client__pull_clone(
 	SG_context* pCtx,
 	SG_client* pClient,
@@ -129,10 +145,12 @@ struct _sg_client__vtable
 	FN__sg_client__list_repo_instances		* const	list_repo_instances;
 	FN__sg_client__push_begin				* const	push_begin;
 	FN__sg_client__push_add					* const	push_add;
+	FN__sg_client__push_add__stream			* const	push_add__stream;
 	FN__sg_client__push_remove				* const	push_remove;
 	FN__sg_client__push_commit				* const	push_commit;
 	FN__sg_client__push_end					* const	push_end;
 	FN__sg_client__pull_request_fragball	* const	pull_request_fragball;
+	FN__sg_client__pull_request_fragball__stream	* const	pull_request_fragball__stream;
 	FN__sg_client__pull_clone				* const pull_clone;
 	FN__sg_client__get_repo_info			* const	get_repo_info;
 	FN__sg_client__get_dagnode_info			* const get_dagnode_info;
@@ -150,10 +168,12 @@ typedef struct _sg_client__vtable sg_client__vtable;
 	FN__sg_client__list_repo_instances		sg_client__##name##__list_repo_instances;	\
 	FN__sg_client__push_begin				sg_client__##name##__push_begin;			\
 	FN__sg_client__push_add					sg_client__##name##__push_add;				\
+	FN__sg_client__push_add__stream			sg_client__##name##__push_add__stream;		\
 	FN__sg_client__push_remove				sg_client__##name##__push_remove;			\
 	FN__sg_client__push_commit				sg_client__##name##__push_commit;			\
 	FN__sg_client__push_end					sg_client__##name##__push_end;				\
 	FN__sg_client__pull_request_fragball	sg_client__##name##__pull_request_fragball;	\
+	FN__sg_client__pull_request_fragball__stream	sg_client__##name##__pull_request_fragball__stream;	\
 	FN__sg_client__pull_clone				sg_client__##name##__pull_clone;			\
 	FN__sg_client__get_repo_info			sg_client__##name##__get_repo_info;			\
 	FN__sg_client__get_dagnode_info			sg_client__##name##__get_dagnode_info;
@@ -169,10 +189,12 @@ typedef struct _sg_client__vtable sg_client__vtable;
 		sg_client__##name##__list_repo_instances,		\
 		sg_client__##name##__push_begin,				\
 		sg_client__##name##__push_add,					\
+		sg_client__##name##__push_add__stream,			\
 		sg_client__##name##__push_remove,				\
 		sg_client__##name##__push_commit,				\
 		sg_client__##name##__push_end,					\
 		sg_client__##name##__pull_request_fragball,		\
+		sg_client__##name##__pull_request_fragball__stream,	\
 		sg_client__##name##__pull_clone,				\
 		sg_client__##name##__get_repo_info,				\
 		sg_client__##name##__get_dagnode_info			\
@@ -177,6 +177,33 @@ fail:
 	SG_VHASH_NULLFREE(pCtx, pvhRepoDescriptor);
 }
 
+void sg_client__c__push_add__stream(SG_context* pCtx,
+									SG_client * pClient,
+									SG_client_push_handle* pPush,
+									SG_fragball_stream** ppFragballStream,
+									SG_vhash** ppResult)
+{
+	sg_client_c_instance_data* pMe = NULL;
+	sg_client_c_push_handle* pMyPush = (sg_client_c_push_handle*)pPush;
+	SG_readstream* pStream = NULL;
+
+	SG_NULLARGCHECK_RETURN(pClient);
+	SG_NULLARGCHECK_RETURN(pPush);
+	SG_NULL_PP_CHECK_RETURN(ppFragballStream);
+	SG_NULLARGCHECK_RETURN(ppResult);
+
+	pMe = (sg_client_c_instance_data*)pClient->p_vtable_instance_data;
+
+	/* The server reads straight from our repo into its staging area. */
+	SG_ERR_CHECK(  SG_fragball_stream__alloc_readstream(pCtx, ppFragballStream, &pStream)  );
+	SG_ERR_CHECK(  SG_server__push_add__stream(pCtx, pMe->pServer, pMyPush->pszPushId, pStream, ppResult)  );
+
+	/* fall through */
+fail:
+	if (pStream)
+		SG_ERR_IGNORE(  SG_readstream__close(pCtx, pStream)  );
+}
+
 void sg_client__c__push_remove(SG_context* pCtx,
 							   SG_client * pClient,
 							   SG_client_push_handle* pPush,
@@ -268,6 +295,47 @@ fail:
 	SG_VHASH_NULLFREE(pCtx, pvhStatus);
 }
 
+void sg_client__c__pull_request_fragball__stream(SG_context* pCtx,
+												 SG_client* pClient,
+												 SG_vhash* pvhRequest,
+												 SG_writestream* pFragballStream,
+												 SG_vhash** ppvhStatus)
+{
+	SG_repo* pRepo = NULL;
+	SG_fragball_stream* pfs = NULL;
+	SG_vhash* pvhStatus = NULL;
+	SG_byte* buf = NULL;
+	SG_bool b_done = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pClient);
+	SG_NULLARGCHECK_RETURN(pFragballStream);
+	SG_NULLARGCHECK_RETURN(ppvhStatus);
+
+	SG_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, pClient->psz_remote_repo_spec, &pRepo)  );
+
+	/* The other repo is local, so we read its fragball straight into the stream. */
+	SG_ERR_CHECK(  SG_server__pull_request_fragball__stream(pCtx, pRepo, pvhRequest, &pfs, &pvhStatus)  );
+
+	SG_ERR_CHECK(  SG_alloc(pCtx, SG_STREAMING_BUFFER_SIZE, 1, &buf)  );
+	while (!b_done)
+	{
+		SG_uint32 got = 0;
+
+		SG_ERR_CHECK(  SG_fragball_stream__read(pCtx, pfs, SG_STREAMING_BUFFER_SIZE, buf, &got, &b_done)  );
+		if (got)
+			SG_ERR_CHECK(  SG_writestream__write(pCtx, pFragballStream, got, buf, NULL)  );
+	}
+
+	SG_RETURN_AND_NULL(pvhStatus, ppvhStatus);
+
+	/* fall through */
+fail:
+	SG_NULLFREE(pCtx, buf);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pfs);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	SG_VHASH_NULLFREE(pCtx, pvhStatus);
+}
+
 void sg_client__c__pull_clone(
 	SG_context* pCtx,
 	SG_client* pClient,
@@ -265,6 +265,56 @@ fail:
 	SG_CURL_STATE_STRING_NULLFREE(pCtx, pResponseState);
 }
 
+void sg_client__http__push_add__stream(SG_context* pCtx,
+									   SG_client * pClient,
+									   SG_client_push_handle* pPush,
+									   SG_fragball_stream** ppFragballStream,
+									   SG_vhash** ppResult)
+{
+	sg_client_http_instance_data* pMe = NULL;
+	sg_client_http_push_handle* pMyPush = (sg_client_http_push_handle*)pPush;
+	SG_curl_state_readstream* pRequestState = NULL;
+	SG_curl_state_string* pResponseState = NULL;
+	char* pszUrl = NULL;
+	SG_uint64 lenFragball;
+
+	SG_NULLARGCHECK_RETURN(pClient);
+	SG_NULLARGCHECK_RETURN(pPush);
+	SG_NULL_PP_CHECK_RETURN(ppFragballStream);
+	SG_NULLARGCHECK_RETURN(ppResult);
+
+	pMe = (sg_client_http_instance_data*)pClient->p_vtable_instance_data;
+
+	SG_ERR_CHECK(  _get_sync_url(pCtx, pClient->psz_remote_repo_spec, SYNC_URL_SUFFIX, pMyPush->pszPushId, &pszUrl)  );
+	SG_ERR_CHECK(  SG_curl__easy_reset(pCtx, pMe->pCurl)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__sz(pCtx, pMe->pCurl, CURLOPT_URL, pszUrl)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__int32(pCtx, pMe->pCurl, CURLOPT_POST, 1)  );
+
+	/* The stream knows its length before any blob is read. */
+	SG_ERR_CHECK(  SG_fragball_stream__get_length(pCtx, *ppFragballStream, &lenFragball)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__int64(pCtx, pMe->pCurl, CURLOPT_POSTFIELDSIZE_LARGE, lenFragball)  );
+
+	SG_ERR_CHECK(  SG_curl__state_readstream__alloc(pCtx, &pRequestState)  );
+	SG_ERR_CHECK(  SG_fragball_stream__alloc_readstream(pCtx, ppFragballStream, &pRequestState->pStream)  );
+
+	SG_ERR_CHECK(  SG_curl__easy_setopt__pv(pCtx, pMe->pCurl, CURLOPT_READDATA, pRequestState)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__read_cb(pCtx, pMe->pCurl, CURLOPT_READFUNCTION, SG_curl__send_readstream_chunk)  );
+
+	SG_ERR_CHECK(  SG_curl__state_string__alloc(pCtx, &pResponseState)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__pv(pCtx, pMe->pCurl, CURLOPT_WRITEDATA, pResponseState)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__write_cb(pCtx, pMe->pCurl, CURLOPT_WRITEFUNCTION, SG_curl__receive_string_chunk)  );
+
+	SG_ERR_CHECK(  SG_curl__perform(pCtx, pMe->pCurl, pRequestState->pCtx, pResponseState->pCtx)  );
+
+	SG_ERR_CHECK(  SG_vhash__alloc__from_json(pCtx, ppResult, SG_string__sz(pResponseState->pstrResponse))  );
+
+	/* fall through */
+fail:
+	SG_NULLFREE(pCtx, pszUrl);
+	SG_CURL_STATE_READSTREAM_NULLFREE(pCtx, pRequestState);
+	SG_CURL_STATE_STRING_NULLFREE(pCtx, pResponseState);
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void sg_client__http__push_remove(SG_context* pCtx,
@@ -420,6 +470,63 @@ fail:
 	SG_CURL_HEADERS_NULLFREE(pCtx, pHeaderList);
 }
 
+void sg_client__http__pull_request_fragball__stream(SG_context* pCtx,
+													SG_client* pClient,
+													SG_vhash* pvhRequest,
+													SG_writestream* pFragballStream,
+													SG_vhash** ppvhStatus)
+{
+	sg_client_http_instance_data* pMe = NULL;
+	SG_curl_state_writestream* pReceiveState = NULL;
+	SG_string* pstrRequest = NULL;
+	char* pszUrl = NULL;
+	struct curl_slist* pHeaderList = NULL;
+
+	SG_NULLARGCHECK_RETURN(pClient);
+	SG_NULLARGCHECK_RETURN(pFragballStream);
+
+	SG_UNUSED(ppvhStatus); // TODO
+
+	pMe = (sg_client_http_instance_data*)pClient->p_vtable_instance_data;
+
+	SG_ERR_CHECK(  _get_sync_url(pCtx, pClient->psz_remote_repo_spec, SYNC_URL_SUFFIX, NULL, &pszUrl)  );
+
+	SG_ERR_CHECK(  SG_curl__easy_reset(pCtx, pMe->pCurl)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__int32(pCtx, pMe->pCurl, CURLOPT_POST, 1)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__sz(pCtx, pMe->pCurl, CURLOPT_URL, pszUrl)  );
+
+	SG_ERR_CHECK(  SG_curl__set_one_header(pCtx, pMe->pCurl, "Accept:application/fragball", &pHeaderList)  );
+
+	if (pvhRequest)
+	{
+		SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrRequest)  );
+		SG_ERR_CHECK(  SG_vhash__to_json(pCtx, pvhRequest, pstrRequest)  );
+
+		SG_ERR_CHECK(  SG_curl__easy_setopt__sz(pCtx, pMe->pCurl, CURLOPT_POSTFIELDS, SG_string__sz(pstrRequest))  );
+		SG_ERR_CHECK(  SG_curl__easy_setopt__int32(pCtx, pMe->pCurl, CURLOPT_POSTFIELDSIZE, SG_string__length_in_bytes(pstrRequest))  );
+	}
+	else
+	{
+		SG_ERR_CHECK(  SG_curl__easy_setopt__int32(pCtx, pMe->pCurl, CURLOPT_POSTFIELDSIZE, 0)  );
+	}
+
+	/* Hand the fragball to the caller's stream as it arrives. */
+	SG_ERR_CHECK(  SG_curl__state_writestream__alloc(pCtx, &pReceiveState)  );
+	pReceiveState->pStream = pFragballStream;
+
+	SG_ERR_CHECK(  SG_curl__easy_setopt__pv(pCtx, pMe->pCurl, CURLOPT_WRITEDATA, pReceiveState)  );
+	SG_ERR_CHECK(  SG_curl__easy_setopt__write_cb(pCtx, pMe->pCurl, CURLOPT_WRITEFUNCTION, SG_curl__receive_writestream_chunk)  );
+
+	SG_ERR_CHECK(  SG_curl__perform(pCtx, pMe->pCurl, NULL, pReceiveState->pCtx)  );
+
+	/* fall through */
+fail:
+	SG_CURL_STATE_WRITESTREAM_NULLFREE(pCtx, pReceiveState);
+	SG_NULLFREE(pCtx, pszUrl);
+	SG_STRING_NULLFREE(pCtx, pstrRequest);
+	SG_CURL_HEADERS_NULLFREE(pCtx, pHeaderList);
+}
+
 typedef struct _clone_progress_state
 {
 	SG_context* pCtx;
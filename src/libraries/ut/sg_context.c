@@ -145,6 +145,30 @@ SG_error SG_context__err_replace(SG_context* pCtx, SG_error new_err, const char
 	return SG_context__err_stackframe_add(pCtx, szFileName, iLine);
 }
 
+SG_error SG_context__err_copy(SG_context* pCtxDest, const SG_context* pCtxSrc)
+{
+	SG_ASSERT( pCtxDest );
+	SG_ASSERT( pCtxSrc );
+
+	if (SG_IS_OK(pCtxSrc->errValues[pCtxSrc->level]))
+		return SG_ERR_INVALIDARG;
+
+	SG_ASSERT( (SG_IS_OK(pCtxDest->errValues[pCtxDest->level])) );		// assume no previous unhandled error
+
+	pCtxDest->errValues[pCtxDest->level] = pCtxSrc->errValues[pCtxSrc->level];
+
+	if (pCtxDest->level > 0)	// when in an error-on-error (level > 0),
+		return SG_ERR_OK;		// we only take the error value.
+
+	memmove(pCtxDest->szDescription, pCtxSrc->szDescription, sizeof(pCtxDest->szDescription));
+
+	pCtxDest->lenStackTrace = pCtxSrc->lenStackTrace;
+	memmove(pCtxDest->szStackTrace, pCtxSrc->szStackTrace, pCtxSrc->lenStackTrace + 1);
+	pCtxDest->bStackTraceAtLimit = pCtxSrc->bStackTraceAtLimit;
+
+	return SG_ERR_OK;
+}
+
 SG_error SG_context__err_set_description(SG_context* pCtx, const char* szFormat, ...)
 {
 	SG_error err;
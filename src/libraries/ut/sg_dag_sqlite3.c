@@ -26,22 +26,6 @@ limitations under the License.
 
 #include <sg.h>
 
-// TODO move these to sg_dag_typedefs.h
-typedef struct SG_dag SG_dag;
-typedef struct SG_dn SG_dn;
-
-// TODO move these to sg_dag_prototypes.h
-void SG_dag_sqlite3__get_whole_dag(
-	SG_context* pCtx,
-    sqlite3* psql,
-    SG_uint32 iDagNum,
-	SG_dag** pp
-    );
-void SG_dag__free(SG_context* pCtx, SG_dag* pThis);
-
-// TODO move this to sg_nullfree.h
-#define SG_DAG_NULLFREE(pCtx,p)               SG_STATEMENT( SG_context__push_level(pCtx);              SG_dag__free(pCtx, p);    SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL; )
-
 //////////////////////////////////////////////////////////////////
 // sqlite3 has a way to spin and retry an operation if another
 // process has a table/db locked.  we use the keep trying for
@@ -226,7 +210,43 @@ void SG_dag_sqlite3__nullclose(SG_context* pCtx, sqlite3** ppsql)
 
 //////////////////////////////////////////////////////////////////
 
-static void _my_is_known(SG_context* pCtx, sqlite3* psql, const char * szHid, SG_bool * pbIsKnown, SG_int32 * pGen)
+#define MY_SQL__IS_KNOWN		"SELECT generation FROM dag_info WHERE child_id = ?"
+
+static void _my_is_known__stmt(SG_context* pCtx, sqlite3_stmt * pStmtInfo, const char * szHid, SG_bool * pbIsKnown, SG_int32 * pGen)
+{
+	// same as _my_is_known() but with a statement that the caller
+	// prepared (from MY_SQL__IS_KNOWN) and will reuse.
+
+	SG_int32 gen = -1;
+	SG_uint32 nrInfoRows = 0;
+	int rc;
+
+	SG_ERR_CHECK_RETURN(  sg_sqlite__reset(pCtx, pStmtInfo)  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__clear_bindings(pCtx, pStmtInfo)  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__bind_text(pCtx, pStmtInfo,1,szHid)  );
+
+	while ((rc=sqlite3_step(pStmtInfo)) == SQLITE_ROW)
+	{
+		if (nrInfoRows == 0)
+		{
+			gen = (SG_int32)sqlite3_column_int(pStmtInfo,0);
+			nrInfoRows++;
+		}
+		else			// this can't happen because of primary key.
+		{
+			SG_ERR_THROW_RETURN(SG_ERR_DAG_NOT_CONSISTENT);
+		}
+	}
+	if (rc != SQLITE_DONE)
+	{
+		SG_ERR_THROW_RETURN(SG_ERR_SQLITE(rc));
+	}
+
+	*pbIsKnown = (nrInfoRows == 1);
+	*pGen = gen;
+}
+
+static void _my_is_known(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, const char * szHid, SG_bool * pbIsKnown, SG_int32 * pGen)
 {
 	// search the DAG_INFO table and see if the given HID is known.
 	// this should be equivalent to searching for HID in the child_id column of DAG_EDGES.
@@ -236,8 +256,7 @@ static void _my_is_known(SG_context* pCtx, sqlite3* psql, const char * szHid, SG
 	SG_uint32 nrInfoRows = 0;
 	int rc;
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmtInfo,
-									  "SELECT generation FROM dag_info WHERE child_id = ?")  );
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmtInfo, MY_SQL__IS_KNOWN)  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmtInfo,1,szHid)  );
 
 	while ((rc=sqlite3_step(pStmtInfo)) == SQLITE_ROW)
@@ -257,7 +276,7 @@ static void _my_is_known(SG_context* pCtx, sqlite3* psql, const char * szHid, SG
 		SG_ERR_THROW(SG_ERR_SQLITE(rc));
 	}
 
-	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmtInfo)  );
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmtInfo)  );
 
 	*pbIsKnown = (nrInfoRows == 1);
 	*pGen = gen;
@@ -265,10 +284,10 @@ static void _my_is_known(SG_context* pCtx, sqlite3* psql, const char * szHid, SG
 	return;
 
 fail:
-	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmtInfo)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmtInfo)  );
 }
 
-static void _my_mark_as_not_leaf(SG_context* pCtx, sqlite3* psql, const char* pszidHid)
+static void _my_mark_as_not_leaf(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, const char* pszidHid)
 {
 	// delete HID from the DAG_LEAVES TABLE.  this marks a DAGNODE as NOT a LEAF.
 	// WE TRUST THE CALLER TO KNOW WHAT THEY'RE DOING.
@@ -278,19 +297,19 @@ static void _my_mark_as_not_leaf(SG_context* pCtx, sqlite3* psql, const char* ps
 
 	sqlite3_stmt * pStmt = NULL;
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql,&pStmt,
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt,
 									  "DELETE FROM dag_leaves WHERE child_id = ?")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,pszidHid)  );
 	SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt,SQLITE_DONE)  );
-	SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 
 	return;
 
 fail:
-	SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 }
 
-static void _my_mark_as_leaf(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, const char* pszidHid)
+static void _my_mark_as_leaf(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, SG_uint32 iDagNum, const char* pszidHid)
 {
 	// insert HID as a row in DAG_LEAVES TABLE.  this marks the DAGNODE as a LEAF.
 	// WE TRUST THE CALLER TO KNOW WHAT THEY'RE DOING.
@@ -299,41 +318,41 @@ static void _my_mark_as_leaf(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum,
 
 	sqlite3_stmt * pStmt = NULL;
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql,&pStmt,
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt,
 									  "INSERT OR IGNORE INTO dag_leaves (child_id,dagnum) VALUES (?,?)")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,pszidHid)  );
 	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt,2,(SG_int32) iDagNum)  );
 	SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt,SQLITE_DONE)  );
-	SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 
 	return;
 
 fail:
-	SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 }
 
-static void _my_store_edge(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, const char * szHidChild, const char * szHidParent)
+static void _my_store_edge(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, SG_uint32 iDagNum, const char * szHidChild, const char * szHidParent)
 {
 	sqlite3_stmt * pStmt = NULL;
 
 	// insert edge.  we expect either SQLITE_DONE (mapped to SG_ERR_OK)
 	// or an SQLITE_CONSTRAINT on a duplicate record.
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmt,
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt,
 									  "INSERT INTO dag_edges (child_id, parent_id, dagnum) VALUES (?, ?, ?)")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,szHidChild)  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,2,szHidParent)  );
 	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt,3,iDagNum)  );
 	SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt,SQLITE_DONE)  );
-	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 
 	return;
 
 fail:
-	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 }
 
-static void _my_store_info(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
+static void _my_store_info(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
 {
 	// add record to DAG_INFO table.
 
@@ -347,23 +366,23 @@ static void _my_store_info(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, c
 	// insert info.  we expect either SQLITE_DONE (mapped to SG_ERR_OK)
 	// or an SQLITE_CONTRAINT on a duplicate record.
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmt,
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt,
 									  "INSERT INTO dag_info (child_id, dagnum, generation) VALUES (?, ?, ?)")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,pszidHidChild)  );
 	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt,2,iDagNum)  );
 	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt,3,generation)  );
 	SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt,SQLITE_DONE)  );
-	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 
 	SG_NULLFREE(pCtx, pszidHidChild);
 	return;
 
 fail:
 	SG_NULLFREE(pCtx, pszidHidChild);
-	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
 }
 
-static void _my_store_initial_dagnode(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
+static void _my_store_initial_dagnode(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
 {
 	// special case for the initial CHANGESET/DAGNODE.
 	//
@@ -397,7 +416,7 @@ static void _my_store_initial_dagnode(SG_context* pCtx, sqlite3* psql, SG_uint32
 
 	// try to add record to DAG_INFO table.
 
-	_my_store_info(pCtx, psql,iDagNum,pDagnode);
+	_my_store_info(pCtx, psql, pCache,iDagNum,pDagnode);
 	if (SG_context__err_equals(pCtx, SG_ERR_SQLITE(SQLITE_CONSTRAINT)))
 	{
 		// duplicate row constraint in DAG_INFO.  the DB already had this
@@ -425,13 +444,13 @@ static void _my_store_initial_dagnode(SG_context* pCtx, sqlite3* psql, SG_uint32
 	// an actual error --or-- because of a constraint (duplicate key)
 	// error, something is wrong and we just give up.
 
-	SG_ERR_CHECK(  _my_store_edge(pCtx, psql,iDagNum,szHidChild,FAKE_PARENT)  );
+	SG_ERR_CHECK(  _my_store_edge(pCtx, psql, pCache,iDagNum,szHidChild,FAKE_PARENT)  );
 
 	// we juat added a *NEW* node to the DAG and, by definition,
 	// no other node in the graph references us, so therefore
 	// it is a leaf.
 
-	SG_ERR_CHECK(  _my_mark_as_leaf(pCtx, psql,iDagNum,szHidChild)  );
+	SG_ERR_CHECK(  _my_mark_as_leaf(pCtx, psql, pCache,iDagNum,szHidChild)  );
 
 	return;
 
@@ -439,7 +458,7 @@ fail:
 	return;
 }
 
-static void _my_store_dagnode_with_parents(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
+static void _my_store_dagnode_with_parents(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
 {
 	// store non-initial CHANGESET/DAGNODE.
 	//
@@ -456,7 +475,7 @@ static void _my_store_dagnode_with_parents(SG_context* pCtx, sqlite3* psql, SG_u
 
 	// try to add record to DAG_INFO table.
 
-	_my_store_info(pCtx, psql,iDagNum,pDagnode);
+	_my_store_info(pCtx, psql, pCache,iDagNum,pDagnode);
 	if (SG_context__err_equals(pCtx, SG_ERR_SQLITE(SQLITE_CONSTRAINT)))
 	{
 		// duplicate row constraint in DAG_INFO.  the DB already had this
@@ -494,7 +513,7 @@ static void _my_store_dagnode_with_parents(SG_context* pCtx, sqlite3* psql, SG_u
 		// having a sparse DAG, let's require that all of the parents already
 		// be in the DAG before we allow the dagnode to be added.
 
-		SG_ERR_CHECK(  _my_is_known(pCtx, psql,paParents[k],&bIsParentKnown,&genUnused)  );
+		SG_ERR_CHECK(  _my_is_known(pCtx, psql, pCache,paParents[k],&bIsParentKnown,&genUnused)  );
 		if (!bIsParentKnown)
 		{
 			SG_ERR_THROW(  SG_ERR_CANNOT_CREATE_SPARSE_DAG  );
@@ -504,18 +523,18 @@ static void _my_store_dagnode_with_parents(SG_context* pCtx, sqlite3* psql, SG_u
 		// an actual error --or-- because of a constraint (duplicate key)
 		// error, something is wrong and we just give up.
 
-		SG_ERR_CHECK(  _my_store_edge(pCtx, psql,iDagNum,szHidChild,paParents[k])  );
+		SG_ERR_CHECK(  _my_store_edge(pCtx, psql, pCache,iDagNum,szHidChild,paParents[k])  );
 
 		// we just added a *NEW* edge from child->parent to the DAG and, by
 		// definition, the parent node is no longer a leaf.
 
-		SG_ERR_CHECK(  _my_mark_as_not_leaf(pCtx, psql,paParents[k])  );
+		SG_ERR_CHECK(  _my_mark_as_not_leaf(pCtx, psql, pCache,paParents[k])  );
 	}
 
 	// we just added a *NEW* node to the DAG and, by definition, no other node
 	// in the graph references us, so therefore, it is a leaf.
 
-	SG_ERR_CHECK(  _my_mark_as_leaf(pCtx, psql,iDagNum,szHidChild)  );
+	SG_ERR_CHECK(  _my_mark_as_leaf(pCtx, psql, pCache,iDagNum,szHidChild)  );
 
 	SG_NULLFREE(pCtx, paParents);
 	paParents = NULL;
@@ -528,7 +547,7 @@ fail:
 
 //////////////////////////////////////////////////////////////////
 
-void SG_dag_sqlite3__store_dagnode(SG_context* pCtx, sqlite3* psql, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
+void SG_dag_sqlite3__store_dagnode(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, SG_uint32 iDagNum, const SG_dagnode * pDagnode)
 {
 	// Callers should have an open sqlite transaction and rollback if any error is returned.
 	// Ian TODO: Except SG_ERR_DAGNODE_ALREADY_EXISTS, which will go away?
@@ -542,11 +561,11 @@ void SG_dag_sqlite3__store_dagnode(SG_context* pCtx, sqlite3* psql, SG_uint32 iD
 
 	if (nrParents == 0)
     {
-		SG_ERR_CHECK(  _my_store_initial_dagnode(pCtx, psql,iDagNum,pDagnode)  );
+		SG_ERR_CHECK(  _my_store_initial_dagnode(pCtx, psql, pCache,iDagNum,pDagnode)  );
     }
 	else
     {
-		SG_ERR_CHECK(  _my_store_dagnode_with_parents(pCtx, psql,iDagNum,pDagnode)  );
+		SG_ERR_CHECK(  _my_store_dagnode_with_parents(pCtx, psql, pCache,iDagNum,pDagnode)  );
     }
 
 	return;
@@ -557,7 +576,7 @@ fail:
 
 //////////////////////////////////////////////////////////////////
 
-void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, const char* pszidHidChangeset, SG_dagnode ** ppNewDagnode)
+void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, const char* pszidHidChangeset, SG_dagnode ** ppNewDagnode)
 {
 	// fetch all rows in the DAG_EDGE table that have the
 	// given HID as the child_id field.  package up all
@@ -591,7 +610,7 @@ void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, const char*
 	//////////////////////////////////////////////////////////////////
 	// fetch info from the DAG_INFO table.
 
-	SG_ERR_CHECK(  _my_is_known(pCtx, psql,pszidHidChangeset,&bIsKnownInfo,&generation)  );
+	SG_ERR_CHECK(  _my_is_known(pCtx, psql, pCache,pszidHidChangeset,&bIsKnownInfo,&generation)  );
 	if (!bIsKnownInfo)
 	{
 		// we didn't find a row in the dag_info table.
@@ -610,7 +629,7 @@ void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, const char*
 	// we now use a rbtree to store the list of parents in memory and
 	// it will always be sorted.
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmtEdge,
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmtEdge,
 									  "SELECT parent_id FROM dag_edges WHERE child_id = ?")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmtEdge,1,pszidHidChangeset)  );
 
@@ -638,7 +657,7 @@ void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, const char*
 		SG_ERR_THROW(  SG_ERR_SQLITE(rc)  );
 	}
 
-	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmtEdge)  );
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmtEdge)  );
 
 	SG_ERR_CHECK(  SG_dagnode__freeze(pCtx, pNewDagnode)  );
 
@@ -676,7 +695,7 @@ void SG_dag_sqlite3__fetch_dagnode(SG_context* pCtx, sqlite3* psql, const char*
 
 fail:
 	SG_DAGNODE_NULLFREE(pCtx, pNewDagnode);
-	SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmtEdge)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmtEdge)  );
 	SG_ERR_REPLACE(SG_ERR_SQLITE(SQLITE_BUSY),SG_ERR_DB_BUSY);
 }
 
@@ -1118,6 +1137,7 @@ fail:
 struct _state_is_connected
 {
 	sqlite3* psql;
+	sqlite3_stmt * pStmtIsKnown;
     SG_uint32 iDagNum;
 	SG_bool bConnected;
 	SG_rbtree ** pprbMissing;
@@ -1131,7 +1151,7 @@ static void _my_foreach_end_fringe_callback__sqlite3(SG_context* pCtx, const cha
 	SG_bool bIsKnown;
 	struct _state_is_connected * pStateIsConnected = (struct _state_is_connected *)pStateVoid;
 
-	SG_ERR_CHECK_RETURN(  _my_is_known(pCtx, pStateIsConnected->psql,szHid,&bIsKnown,&genFetched)  );
+	SG_ERR_CHECK_RETURN(  _my_is_known__stmt(pCtx, pStateIsConnected->pStmtIsKnown,szHid,&bIsKnown,&genFetched)  );
 	if (bIsKnown)
 		return;
 
@@ -1177,6 +1197,7 @@ static void _my_is_connected(SG_context* pCtx,
 	//////////////////////////////////////////////////////////////////
 
 	state_is_connected.psql = psql;
+	state_is_connected.pStmtIsKnown = NULL;
     state_is_connected.iDagNum = iDagNum;
 	state_is_connected.pprbMissing = &prbMissing;
 	state_is_connected.bConnected = SG_TRUE; // Default to true. The callback only changes this to false
@@ -1184,9 +1205,11 @@ static void _my_is_connected(SG_context* pCtx,
 										   // frag disconnected.
 
 	// iterate over all end-fringe nodes in the fragment.  optionally build a list
-	// of unknown nodes.
+	// of unknown nodes.  every lookup is the same query, so prepare it once.
 
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &state_is_connected.pStmtIsKnown, MY_SQL__IS_KNOWN)  );
 	SG_ERR_CHECK(  SG_dagfrag__foreach_end_fringe(pCtx, pFrag,_my_foreach_end_fringe_callback__sqlite3,&state_is_connected)  );
+	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &state_is_connected.pStmtIsKnown)  );
 
 	if (!state_is_connected.bConnected)			// callback allocated a list to put at least one item
 	{
@@ -1210,12 +1233,14 @@ static void _my_is_connected(SG_context* pCtx,
 	return;
 
 fail:
+	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &state_is_connected.pStmtIsKnown)  );
 	SG_RBTREE_NULLFREE(pCtx, prbMissing);
 }
 
 struct _state_member
 {
 	sqlite3* psql;
+	sg_sqlite__stmt_cache* pCache;
     SG_uint32 iDagNum;
 	SG_stringarray ** ppsa_new;
     SG_bool b_not_really;
@@ -1241,7 +1266,7 @@ static void _my_insert_member_callback__sqlite3(SG_context* pCtx,
 
     if (pCtxMember->b_not_really)
     {
-        SG_ERR_CHECK_RETURN(  _my_is_known(pCtx, pCtxMember->psql,szHid,&bIsKnownInfo,&generation)  );
+        SG_ERR_CHECK_RETURN(  _my_is_known(pCtx, pCtxMember->psql, pCtxMember->pCache, szHid,&bIsKnownInfo,&generation)  );
         if (bIsKnownInfo)
         {
             // we didn't find a row in the dag_info table.
@@ -1251,7 +1276,7 @@ static void _my_insert_member_callback__sqlite3(SG_context* pCtx,
     }
     else
     {
-        SG_dag_sqlite3__store_dagnode(pCtx, pCtxMember->psql,pCtxMember->iDagNum,pDagnode);
+        SG_dag_sqlite3__store_dagnode(pCtx, pCtxMember->psql, pCtxMember->pCache, pCtxMember->iDagNum,pDagnode);
         if (SG_context__err_equals(pCtx, SG_ERR_DAGNODE_ALREADY_EXISTS))
         {
             // we cannot precompute the amount of overlap between the frag and our dag,
@@ -1314,10 +1339,235 @@ fail:
 	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
 }
 
+//////////////////////////////////////////////////////////////////
+// Batched insert of the members of a fragment.
+//
+// Storing one dagnode at a time (SG_dag_sqlite3__store_dagnode()) costs
+// several freshly prepared statements per node plus a DELETE/INSERT on
+// DAG_LEAVES for every node and parent.  When we are given a whole
+// fragment (clone, pull, commit of a big staging area) we instead:
+//
+// [] prepare each statement once and just rebind it for each row;
+// [] keep track of leaf changes for the whole batch in memory -- a node
+//    that gets a child later in the same batch never touches DAG_LEAVES;
+// [] write the net leaf changes once at the end.
+//
+// This must run inside a transaction; SG_dag_sqlite3__insert_frag()
+// opens one if the caller didn't.
+
+struct _state_batch
+{
+	sqlite3* psql;
+    SG_uint32 iDagNum;
+	SG_stringarray ** ppsa_new;
+
+	sqlite3_stmt * pStmtIsKnown;
+	sqlite3_stmt * pStmtInfo;
+	sqlite3_stmt * pStmtEdge;
+
+	SG_rbtree * prbNew;				// HIDs of nodes added by this batch
+	SG_rbtree * prbNewLeaves;		// subset of prbNew that has no children (yet)
+	SG_rbtree * prbOldNotLeaves;	// HIDs of nodes already in the db that got a child
+};
+
+static void _my_batch__store_edge(SG_context* pCtx, struct _state_batch * pBatch, const char * szHidChild, const char * szHidParent)
+{
+	SG_ERR_CHECK_RETURN(  sg_sqlite__reset(pCtx, pBatch->pStmtEdge)  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__clear_bindings(pCtx, pBatch->pStmtEdge)  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__bind_text(pCtx, pBatch->pStmtEdge,1,szHidChild)  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__bind_text(pCtx, pBatch->pStmtEdge,2,szHidParent)  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__bind_int(pCtx, pBatch->pStmtEdge,3,pBatch->iDagNum)  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__step(pCtx, pBatch->pStmtEdge,SQLITE_DONE)  );
+}
+
+static void _my_batch_member_callback__sqlite3(SG_context* pCtx,
+											   const SG_dagnode * pDagnode,
+											   SG_dagfrag_state qs,
+											   void * pCtxVoid)
+{
+	// a SG_dagfrag__foreach_member_callback.  members are presented in
+	// ancestor order, so parents are always stored before their children.
+
+	struct _state_batch * pBatch = (struct _state_batch *)pCtxVoid;
+	const char * szHid;
+	SG_int32 generation;
+	SG_rbtree * prbParents = NULL;
+	SG_rbtree_iterator * pit = NULL;
+	const char * pszParentHid;
+	SG_bool bFound;
+
+	SG_UNUSED(qs);
+
+	SG_ERR_CHECK(  SG_dagnode__get_id_ref(pCtx, pDagnode,&szHid)  );
+	SG_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pDagnode,&generation)  );
+
+	// add the DAG_INFO row.  if it's already there, we assume that the db
+	// already has the whole node (edges and all).  we cannot precompute the
+	// amount of overlap between the frag and our dag, so we expect this.
+
+	SG_ERR_CHECK(  sg_sqlite__reset(pCtx, pBatch->pStmtInfo)  );
+	SG_ERR_CHECK(  sg_sqlite__clear_bindings(pCtx, pBatch->pStmtInfo)  );
+	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pBatch->pStmtInfo,1,szHid)  );
+	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pBatch->pStmtInfo,2,pBatch->iDagNum)  );
+	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pBatch->pStmtInfo,3,generation)  );
+	SG_ERR_CHECK(  sg_sqlite__step(pCtx, pBatch->pStmtInfo,SQLITE_DONE)  );
+	if (sqlite3_changes(pBatch->psql) == 0)
+		return;
+
+	SG_ERR_CHECK(  SG_rbtree__add(pCtx, pBatch->prbNew, szHid)  );
+
+	SG_ERR_CHECK(  SG_dagnode__get_parents__rbtree_ref(pCtx, pDagnode, &prbParents)  );
+	if (!prbParents)
+	{
+		// the initial checkin.  see _my_store_initial_dagnode().
+
+		SG_ERR_CHECK(  _my_batch__store_edge(pCtx, pBatch, szHid, FAKE_PARENT)  );
+	}
+	else
+	{
+		SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prbParents, &bFound, &pszParentHid, NULL)  );
+		while (bFound)
+		{
+			SG_bool bParentIsNew = SG_FALSE;
+
+			SG_ERR_CHECK(  SG_rbtree__find(pCtx, pBatch->prbNew, pszParentHid, &bParentIsNew, NULL)  );
+			if (bParentIsNew)
+			{
+				// the parent came in with this batch.  it can't be a leaf now,
+				// and since it was never written to DAG_LEAVES, there's nothing
+				// to undo.
+
+				SG_ERR_CHECK(  SG_rbtree__find(pCtx, pBatch->prbNewLeaves, pszParentHid, &bFound, NULL)  );
+				if (bFound)
+					SG_ERR_CHECK(  SG_rbtree__remove(pCtx, pBatch->prbNewLeaves, pszParentHid)  );
+			}
+			else
+			{
+				SG_bool bIsParentKnown = SG_FALSE;
+				SG_int32 genUnused;
+
+				// see _my_store_dagnode_with_parents() -- all parents must already
+				// be in the dag.  this should not happen because we already checked
+				// the end-fringe and we assumed that we have a connected graph before
+				// we started.  therefore, we must be missing a node in the middle of
+				// the graph.
+
+				SG_ERR_CHECK(  _my_is_known__stmt(pCtx, pBatch->pStmtIsKnown, pszParentHid, &bIsParentKnown, &genUnused)  );
+				if (!bIsParentKnown)
+					SG_ERR_THROW(  SG_ERR_DAG_NOT_CONSISTENT  );
+
+				SG_ERR_CHECK(  SG_rbtree__update(pCtx, pBatch->prbOldNotLeaves, pszParentHid)  );
+			}
+
+			SG_ERR_CHECK(  _my_batch__store_edge(pCtx, pBatch, szHid, pszParentHid)  );
+
+			SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &bFound, &pszParentHid, NULL)  );
+		}
+		SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+	}
+
+	// nobody in the db references a brand new node, so for now it's a leaf.
+
+	SG_ERR_CHECK(  SG_rbtree__add(pCtx, pBatch->prbNewLeaves, szHid)  );
+
+	if (!*pBatch->ppsa_new)			// we deferred creating the list until we actually needed it.
+		SG_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, pBatch->ppsa_new, 10)  );
+	SG_ERR_CHECK(  SG_stringarray__add(pCtx, *pBatch->ppsa_new,szHid)  );
+
+	return;
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+}
+
+static void _my_batch__update_leaves(SG_context* pCtx, struct _state_batch * pBatch)
+{
+	// write the net change to DAG_LEAVES for the whole batch.
+
+	sqlite3_stmt * pStmt = NULL;
+	SG_rbtree_iterator * pit = NULL;
+	const char * pszHid;
+	SG_bool b;
+
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pBatch->psql, &pStmt,
+									  "DELETE FROM dag_leaves WHERE child_id = ?")  );
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, pBatch->prbOldNotLeaves, &b, &pszHid, NULL)  );
+	while (b)
+	{
+		SG_ERR_CHECK(  sg_sqlite__reset(pCtx, pStmt)  );
+		SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,pszHid)  );
+		SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt,SQLITE_DONE)  );
+
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &pszHid, NULL)  );
+	}
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pBatch->psql, &pStmt,
+									  "INSERT OR IGNORE INTO dag_leaves (child_id,dagnum) VALUES (?,?)")  );
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, pBatch->prbNewLeaves, &b, &pszHid, NULL)  );
+	while (b)
+	{
+		SG_ERR_CHECK(  sg_sqlite__reset(pCtx, pStmt)  );
+		SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,pszHid)  );
+		SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt,2,(SG_int32) pBatch->iDagNum)  );
+		SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt,SQLITE_DONE)  );
+
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &pszHid, NULL)  );
+	}
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+
+	return;
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+}
+
+static void _my_batch_store_members(SG_context* pCtx,
+									sqlite3* psql,
+									SG_uint32 iDagNum,
+									SG_dagfrag * pFrag,
+									SG_stringarray ** ppsa_new)
+{
+	struct _state_batch batch;
+
+	memset(&batch, 0, sizeof(batch));
+	batch.psql = psql;
+	batch.iDagNum = iDagNum;
+	batch.ppsa_new = ppsa_new;
+
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &batch.prbNew)  );
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &batch.prbNewLeaves)  );
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &batch.prbOldNotLeaves)  );
+
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &batch.pStmtIsKnown, MY_SQL__IS_KNOWN)  );
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &batch.pStmtInfo,
+									  "INSERT OR IGNORE INTO dag_info (child_id, dagnum, generation) VALUES (?, ?, ?)")  );
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &batch.pStmtEdge,
+									  "INSERT INTO dag_edges (child_id, parent_id, dagnum) VALUES (?, ?, ?)")  );
+
+	SG_ERR_CHECK(  SG_dagfrag__foreach_member(pCtx, pFrag, _my_batch_member_callback__sqlite3, (void *)&batch)  );
+
+	SG_ERR_CHECK(  _my_batch__update_leaves(pCtx, &batch)  );
+
+	/* fall thru */
+
+fail:
+	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &batch.pStmtIsKnown)  );
+	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &batch.pStmtInfo)  );
+	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &batch.pStmtEdge)  );
+	SG_RBTREE_NULLFREE(pCtx, batch.prbNew);
+	SG_RBTREE_NULLFREE(pCtx, batch.prbNewLeaves);
+	SG_RBTREE_NULLFREE(pCtx, batch.prbOldNotLeaves);
+}
+
 //////////////////////////////////////////////////////////////////
 
 void SG_dag_sqlite3__check_frag(SG_context* pCtx,
 								sqlite3* psql,
+								sg_sqlite__stmt_cache* pCache,
 								SG_dagfrag * pFrag,
 								SG_bool * pbConnected,
 								SG_rbtree ** ppIdsetMissing,
@@ -1343,6 +1593,7 @@ void SG_dag_sqlite3__check_frag(SG_context* pCtx,
 		return;
 
 	ctx_member.psql = psql;
+	ctx_member.pCache = pCache;
     ctx_member.iDagNum = iDagNum;
 	ctx_member.ppsa_new = ppsa_new;
     ctx_member.b_not_really = SG_TRUE;
@@ -1382,9 +1633,10 @@ void SG_dag_sqlite3__insert_frag(SG_context* pCtx,
 	//     that the resulting graph is completely connected (and we
 	//     assume that the current graph is completely connected before
 	//     we start).
-	// [2] add individual dagnodes in ancestor order.  these are done
-	//     with one TX for each dagnode so that we don't get funky
-	//     conflicts with other concurrent processes.
+	// [2] add the member dagnodes in ancestor order, as one batch
+	//     (see _my_batch_store_members()).  this should be within the
+	//     caller's TX; if there isn't one open, we open (and commit)
+	//     our own so the batch is still all-or-nothing.
 	//
 	// if [1] reports a disconnected graph, we return SG_ERR_CANNOT_CREATE_SPARSE_DAG
 	// and an rbtree of the nodes we are missing.
@@ -1393,13 +1645,13 @@ void SG_dag_sqlite3__insert_frag(SG_context* pCtx,
 	// and return that.
 	//
 	// if [2] fails, we stop wherever we are and return the actual error.
-	// because of the individual add TX's, you can get an error with a
-	// partial result.
+	// the caller must roll back its TX (we roll back ours); the list of
+	// new nodes may be partial.
 	//
 	// the caller must free both idsets.
 
-	struct _state_member state_member;
 	SG_bool bConnected = SG_FALSE;
+	SG_bool bInTx = SG_FALSE;
 
 	SG_NULLARGCHECK_RETURN(psql);
 	SG_NULLARGCHECK_RETURN(pFrag);
@@ -1413,13 +1665,26 @@ void SG_dag_sqlite3__insert_frag(SG_context* pCtx,
 	if (!bConnected)
 		SG_ERR_THROW_RETURN(SG_ERR_CANNOT_CREATE_SPARSE_DAG);
 
-	state_member.psql = psql;
-    state_member.iDagNum = iDagNum;
-	state_member.ppsa_new = ppsa_new;
-    state_member.b_not_really = SG_FALSE;
-	state_member.prbLeaves = NULL;
+	// sqlite is in autocommit mode exactly when no TX is open.
+	if (sqlite3_get_autocommit(psql))
+	{
+		SG_ERR_CHECK(  sg_sqlite__exec(pCtx, psql, "BEGIN TRANSACTION")  );
+		bInTx = SG_TRUE;
+	}
+
+	SG_ERR_CHECK(  _my_batch_store_members(pCtx, psql, iDagNum, pFrag, ppsa_new)  );
+
+	if (bInTx)
+	{
+		SG_ERR_CHECK(  sg_sqlite__exec(pCtx, psql, "COMMIT TRANSACTION")  );
+		bInTx = SG_FALSE;
+	}
+
+	return;
 
-	SG_dagfrag__foreach_member(pCtx, pFrag,_my_insert_member_callback__sqlite3,(void *)&state_member);
+fail:
+	if (bInTx)
+		SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, psql, "ROLLBACK TRANSACTION")  );
 }
 
 //////////////////////////////////////////////////////////////////
@@ -1428,7 +1693,7 @@ static FN__sg_fetch_dagnode my_fetch_dagnodes;
 
 static void my_fetch_dagnodes(SG_context* pCtx, void * pCtxFetchDagnode, const char * szHidDagnode, SG_dagnode ** ppDagnode)
 {
-	SG_dag_sqlite3__fetch_dagnode(pCtx, (sqlite3 *)pCtxFetchDagnode,szHidDagnode,ppDagnode);
+	SG_dag_sqlite3__fetch_dagnode(pCtx, (sqlite3 *)pCtxFetchDagnode, NULL, szHidDagnode,ppDagnode);
 }
 
 void SG_dag_sqlite3__get_lca(
@@ -1453,117 +1718,41 @@ fail:
 	SG_DAGLCA_NULLFREE(pCtx, pDagLca);
 }
 
-// The following code is a sample for how we might store an entire dag
-// into a reasonably memory efficient structure.  This is just the
-// sqlite version, which will work for the fs2 and sqlite implementations
-// of the repo API.
-//
-// This code grabs the whole dag.  Modifying it to grab only a range of
-// generations would be fairly straightforward, as long as a generation
-// number is available on all tables.  A join would work, but would be
-// more expensive.
-//
-// If this becomes real code, it will need to be properly added to
-// the repo API, which would touch a whole bunch of files, so I'm
-// just doing it here as a localized change for now.
-//
-
-// TODO move the structure definitions below here to sg_dag.c, probably
-
-struct SG_dn
-{
-    SG_uint32 num_parents;
-
-    const char** parents;  // points into the pool
-
-    SG_int32 generation;
-};
-
-struct SG_dag
-{
-    SG_rbtree* prb_id;
-    SG_rbtree* prb_user;
-    SG_uint32 count_leaves;
-    const char** leaves;
-    SG_strpool* pool;
-
-    // the rbtree uses the pool for all its keys
-    //
-    // in the rbtree the assoc is an SG_dn*, which is allocated in the pool
-    //
-    // SG_dn.parents is a buffer allocated in the pool.  The individual pts go
-    // into the pool as well.
-};
-
-// TODO add other SG_dag__ functions, like accessor calls to actually
-// retrieve the info from the dag, etc.
-
-void SG_dag__free(SG_context* pCtx, SG_dag* pThis)
-{
-    if (!pThis)
-    {
-        return;
-    }
-
-    SG_STRPOOL_NULLFREE(pCtx, pThis->pool);
-    SG_RBTREE_NULLFREE(pCtx, pThis->prb_id);
-    SG_RBTREE_NULLFREE(pCtx, pThis->prb_user);
-    SG_NULLFREE(pCtx, pThis);
-}
-
-void SG_dag_sqlite3__get_whole_dag(
+void SG_dag_sqlite3__get_dagindex(
 	SG_context* pCtx,
     sqlite3* psql,
     SG_uint32 iDagNum,
-	SG_dag** pp
+	SG_dagindex ** ppIndex
     )
 {
-    SG_dag* pd = NULL;
+    SG_dagindex* pIndex = NULL;
 	sqlite3_stmt * pStmt = NULL;
     int rc;
     SG_int32 count_dagnodes = 0;
 
-    // first count how many dagnodes we're going to have.  we can
-    // use this as an estimate for the size of the rbtree.
-
-    // TODO I'm not 100% sure this COUNT(*) call is worth the
-    // trouble.  It's expensive on sqlite.  Basically, it allows
-    // us to pass an accurate guess into the rbtree allocator,
-    // which means rbtree shouldn't need to grow its internal
-    // node pool.  But the cost of the COUNT(*) might be
-    // worse than just letting rbtree cope.
-    //
-	SG_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, psql, &count_dagnodes, "SELECT COUNT(*) FROM dag_info WHERE dagnum=%d", iDagNum)  );
-
-    // allocate our data structures
-    SG_ERR_CHECK(  SG_alloc1(pCtx, pd)  );
-    SG_ERR_CHECK(  SG_STRPOOL__ALLOC(pCtx, &pd->pool, 32768)  );
+	SG_NULLARGCHECK_RETURN(psql);
+	SG_NULLARGCHECK_RETURN(ppIndex);
 
-    // the main rbtree will use the pool we just created.  in fact,
-    // everything will go into that pool.
+    // the count lets the index size its arrays (and the rbtree) once
+    // rather than growing them as we go.
 
-    SG_ERR_CHECK(  SG_rbtree__alloc__params(pCtx, &pd->prb_id, count_dagnodes, pd->pool)  );
+	SG_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, psql, &count_dagnodes, "SELECT COUNT(*) FROM dag_info WHERE dagnum=%d", iDagNum)  );
 
-    // we also want an rbtree which indexes everything by user.  same
-    // pool.
+    SG_ERR_CHECK(  SG_dagindex__alloc(pCtx, &pIndex, iDagNum, (SG_uint32) count_dagnodes)  );
 
-    SG_ERR_CHECK(  SG_rbtree__alloc__params(pCtx, &pd->prb_user, 100, pd->pool)  );
+    // first, all the dagnodes and their generations.  we order by
+    // generation so that ids are assigned roughly oldest-first.
 
-    // first, let's setup SG_dn structs for all the dagnodes.  might
-    // as well fill in the generation value for each one too.
 	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmt,
-									  "SELECT child_id, generation FROM dag_info WHERE dagnum = ?")  );
+									  "SELECT child_id, generation FROM dag_info WHERE dagnum = ? ORDER BY generation")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 1, iDagNum)  );
 
 	while ((rc=sqlite3_step(pStmt)) == SQLITE_ROW)
 	{
 		const char * psz_id = (const char *)sqlite3_column_text(pStmt,0);
         SG_int32 gen = (SG_int32)sqlite3_column_int(pStmt,1);
-        SG_dn* pdn = NULL;
 
-        SG_ERR_CHECK(  SG_strpool__add__len(pCtx, pd->pool, sizeof(SG_dn), (const char**) &pdn)  );
-        pdn->generation = gen;
-        SG_ERR_CHECK(  SG_rbtree__add__with_assoc(pCtx, pd->prb_id, psz_id, pdn)  );
+        SG_ERR_CHECK(  SG_dagindex__add_node(pCtx, pIndex, psz_id, gen)  );
 	}
 	if (rc != SQLITE_DONE)
 	{
@@ -1571,7 +1760,9 @@ void SG_dag_sqlite3__get_whole_dag(
 	}
 	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
 
-    // now we grab all the parents.
+    // now we grab all the edges.  the initial checkin has a single edge
+    // to the FAKE_PARENT, which isn't a real dagnode.
+
 	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmt,
 									  "SELECT child_id, parent_id FROM dag_edges WHERE dagnum = ?")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 1, iDagNum)  );
@@ -1583,39 +1774,7 @@ void SG_dag_sqlite3__get_whole_dag(
 
         if (0 != strcmp(psz_parent_id, FAKE_PARENT))
         {
-            SG_dn* pdn = NULL;
-            const char** pnew = NULL;
-            SG_uint16 cur_num_parents = 0;
-            const char* pooled_parent_id = NULL;
-
-            SG_ERR_CHECK(  SG_rbtree__find(pCtx, pd->prb_id, psz_node_id, NULL, (void**) &pdn)  );
-
-            // we wish we could efficiently
-            // know how many parents each node will have in advance, but
-            // we can't.  So each dagnode's parents array is going to
-            // grow one parent at a time.  and the previous version of
-            // the array becomes wasted memory, which is exactly what
-            // we're trying to avoid.  we accept this for now because
-            // we believe the case of a dagnode with multiple parents
-            // is relatively rare.  the alternative would be to walk
-            // every row of this table twice, once to get accurate counts,
-            // and once to actually store all the parents info.
-
-            cur_num_parents = (SG_uint16) pdn->num_parents;
-
-            SG_ERR_CHECK(  SG_strpool__add__len(pCtx, pd->pool, sizeof(char*) * ( cur_num_parents + 1), (const char**) &pnew)  );
-            if (cur_num_parents)
-            {
-                memcpy((void*) pnew, pdn->parents, cur_num_parents * sizeof(char*));
-            }
-
-            SG_ERR_CHECK(  SG_rbtree__key(pCtx, pd->prb_id, psz_parent_id, &pooled_parent_id)  );
-            SG_ASSERT(pooled_parent_id);
-
-            pnew[cur_num_parents] = pooled_parent_id;
-            pdn->parents = pnew;
-            cur_num_parents++;
-            pdn->num_parents = cur_num_parents;
+            SG_ERR_CHECK(  SG_dagindex__add_edge(pCtx, pIndex, psz_node_id, psz_parent_id)  );
         }
 	}
 	if (rc != SQLITE_DONE)
@@ -1624,12 +1783,13 @@ void SG_dag_sqlite3__get_whole_dag(
 	}
 	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
 
-    *pp = pd;
-    pd = NULL;
+    SG_ERR_CHECK(  SG_dagindex__freeze(pCtx, pIndex)  );
+
+    *ppIndex = pIndex;
+    pIndex = NULL;
 
 fail:
-    SG_DAG_NULLFREE(pCtx, pd);
-	sg_sqlite__nullfinalize(pCtx, &pStmt);
+    SG_DAGINDEX_NULLFREE(pCtx, pIndex);
+	SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+	SG_ERR_REPLACE(SG_ERR_SQLITE(SQLITE_BUSY),SG_ERR_DB_BUSY);
 }
-
-
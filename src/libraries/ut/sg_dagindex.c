@@ -0,0 +1,634 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_dagindex.c
+ *
+ * @details An in-memory index of the shape of a whole DAG.
+ *
+ * Every dagnode gets a dense integer id in the order it was added.
+ * HIDs and generations live in arrays indexed by that id.  Edges are
+ * collected as (child,parent) id pairs and __freeze() turns them into
+ * compressed adjacency arrays in both directions: the parents of node
+ * k are aParents[ aParentStart[k] .. aParentStart[k+1] ) and likewise
+ * for the children.
+ *
+ * The only string lookup is the HID-->id rbtree, which is only needed
+ * at the edges of an operation (to turn the caller's HIDs into ids).
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg.h>
+
+//////////////////////////////////////////////////////////////////
+
+struct _SG_dagindex
+{
+	SG_uint32			iDagNum;
+
+	SG_strpool *		pPool;				// HID keys of prbIds and the SG_uint32 ids hung on them
+	SG_rbtree *			prbIds;				// HID --> (SG_uint32 *) id
+
+	SG_uint32			count_nodes;
+	SG_uint32			space_nodes;
+	const char **		aHids;				// [id] --> HID (owned by the pool)
+	SG_int32 *			aGens;				// [id] --> generation
+
+	SG_uint32			count_edges;
+	SG_uint32			space_edges;
+	SG_uint32 *			aEdgeChild;			// [edge] --> id of child
+	SG_uint32 *			aEdgeParent;		// [edge] --> id of parent
+
+	SG_bool				bFrozen;
+	SG_uint32 *			aParentStart;		// [count_nodes + 1]
+	SG_uint32 *			aParents;			// [count_edges]
+	SG_uint32 *			aChildStart;		// [count_nodes + 1]
+	SG_uint32 *			aChildren;			// [count_edges]
+
+	// scratch space for the walks, allocated by the first one after a
+	// freeze.  a node has been visited by the current walk when its
+	// aVisited[] entry equals visit_stamp, so a walk only has to bump
+	// the stamp rather than clear the array.
+	SG_uint32 *			aVisited;			// [count_nodes]
+	SG_uint32 *			aStack;				// [count_nodes]
+	SG_uint32			visit_stamp;
+};
+
+#define MY_MIN_SPACE		(64)
+
+//////////////////////////////////////////////////////////////////
+
+static void _sg_dagindex__grow(SG_context * pCtx,
+							   void ** ppArray,
+							   SG_uint32 count_used,
+							   SG_uint32 space_new,
+							   SG_uint32 size_elem)
+{
+	void * pNew = NULL;
+
+	SG_ERR_CHECK_RETURN(  SG_alloc(pCtx, space_new, size_elem, &pNew)  );
+	if (count_used)
+		memcpy(pNew, *ppArray, count_used * size_elem);
+
+	SG_NULLFREE(pCtx, *ppArray);
+	*ppArray = pNew;
+}
+
+static void _sg_dagindex__unfreeze(SG_context * pCtx, SG_dagindex * pIndex)
+{
+	SG_NULLFREE(pCtx, pIndex->aParentStart);
+	SG_NULLFREE(pCtx, pIndex->aParents);
+	SG_NULLFREE(pCtx, pIndex->aChildStart);
+	SG_NULLFREE(pCtx, pIndex->aChildren);
+	SG_NULLFREE(pCtx, pIndex->aVisited);
+	SG_NULLFREE(pCtx, pIndex->aStack);
+	pIndex->visit_stamp = 0;
+	pIndex->bFrozen = SG_FALSE;
+}
+
+//////////////////////////////////////////////////////////////////
+
+void SG_dagindex__alloc(SG_context * pCtx,
+						SG_dagindex ** ppNew,
+						SG_uint32 iDagNum,
+						SG_uint32 count_nodes_hint)
+{
+	SG_dagindex * pIndex = NULL;
+
+	SG_NULLARGCHECK_RETURN(ppNew);
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pIndex)  );
+	pIndex->iDagNum = iDagNum;
+
+	SG_ERR_CHECK(  SG_STRPOOL__ALLOC(pCtx, &pIndex->pPool, 32768)  );
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC__PARAMS(pCtx, &pIndex->prbIds, count_nodes_hint, pIndex->pPool)  );
+
+	pIndex->space_nodes = SG_MAX(count_nodes_hint, MY_MIN_SPACE);
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->space_nodes, pIndex->aHids)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->space_nodes, pIndex->aGens)  );
+
+	// most dagnodes have exactly one parent.
+
+	pIndex->space_edges = pIndex->space_nodes + (pIndex->space_nodes / 8);
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->space_edges, pIndex->aEdgeChild)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->space_edges, pIndex->aEdgeParent)  );
+
+	*ppNew = pIndex;
+	return;
+
+fail:
+	SG_DAGINDEX_NULLFREE(pCtx, pIndex);
+}
+
+void SG_dagindex__free(SG_context * pCtx, SG_dagindex * pIndex)
+{
+	if (!pIndex)
+		return;
+
+	SG_ERR_IGNORE(  _sg_dagindex__unfreeze(pCtx, pIndex)  );
+	SG_NULLFREE(pCtx, pIndex->aEdgeChild);
+	SG_NULLFREE(pCtx, pIndex->aEdgeParent);
+	SG_NULLFREE(pCtx, pIndex->aHids);
+	SG_NULLFREE(pCtx, pIndex->aGens);
+	SG_RBTREE_NULLFREE(pCtx, pIndex->prbIds);
+	SG_STRPOOL_NULLFREE(pCtx, pIndex->pPool);
+	SG_NULLFREE(pCtx, pIndex);
+}
+
+//////////////////////////////////////////////////////////////////
+
+void SG_dagindex__add_node(SG_context * pCtx,
+						   SG_dagindex * pIndex,
+						   const char * pszHid,
+						   SG_int32 generation)
+{
+	SG_uint32 * pId = NULL;
+	const char * pszPooledHid = NULL;
+	SG_bool bFound = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pIndex);
+	SG_NONEMPTYCHECK_RETURN(pszHid);
+
+	SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx, pIndex->prbIds, pszHid, &bFound, NULL)  );
+	if (bFound)
+		return;
+
+	if (pIndex->count_nodes == pIndex->space_nodes)
+	{
+		SG_uint32 space_new = pIndex->space_nodes * 2;
+
+		SG_ERR_CHECK_RETURN(  _sg_dagindex__grow(pCtx, (void **)&pIndex->aHids, pIndex->count_nodes, space_new, sizeof(const char *))  );
+		SG_ERR_CHECK_RETURN(  _sg_dagindex__grow(pCtx, (void **)&pIndex->aGens, pIndex->count_nodes, space_new, sizeof(SG_int32))  );
+		pIndex->space_nodes = space_new;
+	}
+
+	// the id is hung on the rbtree as its assoc data; put it in the
+	// pool with the key so that we don't have a malloc per node.
+
+	SG_ERR_CHECK_RETURN(  SG_strpool__add__len(pCtx, pIndex->pPool, sizeof(SG_uint32), (const char **)&pId)  );
+	*pId = pIndex->count_nodes;
+
+	SG_ERR_CHECK_RETURN(  SG_rbtree__add__with_assoc(pCtx, pIndex->prbIds, pszHid, pId)  );
+	SG_ERR_CHECK_RETURN(  SG_rbtree__key(pCtx, pIndex->prbIds, pszHid, &pszPooledHid)  );
+
+	pIndex->aHids[pIndex->count_nodes] = pszPooledHid;
+	pIndex->aGens[pIndex->count_nodes] = generation;
+	pIndex->count_nodes++;
+
+	pIndex->bFrozen = SG_FALSE;
+}
+
+void SG_dagindex__add_edge(SG_context * pCtx,
+						   SG_dagindex * pIndex,
+						   const char * pszHidChild,
+						   const char * pszHidParent)
+{
+	SG_uint32 iChild = 0;
+	SG_uint32 iParent = 0;
+	SG_bool bFound = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pIndex);
+
+	SG_ERR_CHECK_RETURN(  SG_dagindex__lookup(pCtx, pIndex, pszHidChild, &bFound, &iChild)  );
+	if (!bFound)
+		SG_ERR_THROW2_RETURN(  SG_ERR_NOT_FOUND, (pCtx, "Dagnode [%s] is not in the dagindex.", pszHidChild)  );
+
+	SG_ERR_CHECK_RETURN(  SG_dagindex__lookup(pCtx, pIndex, pszHidParent, &bFound, &iParent)  );
+	if (!bFound)
+		SG_ERR_THROW2_RETURN(  SG_ERR_NOT_FOUND, (pCtx, "Dagnode [%s] is not in the dagindex.", pszHidParent)  );
+
+	if (pIndex->count_edges == pIndex->space_edges)
+	{
+		SG_uint32 space_new = pIndex->space_edges * 2;
+
+		SG_ERR_CHECK_RETURN(  _sg_dagindex__grow(pCtx, (void **)&pIndex->aEdgeChild, pIndex->count_edges, space_new, sizeof(SG_uint32))  );
+		SG_ERR_CHECK_RETURN(  _sg_dagindex__grow(pCtx, (void **)&pIndex->aEdgeParent, pIndex->count_edges, space_new, sizeof(SG_uint32))  );
+		pIndex->space_edges = space_new;
+	}
+
+	pIndex->aEdgeChild[pIndex->count_edges] = iChild;
+	pIndex->aEdgeParent[pIndex->count_edges] = iParent;
+	pIndex->count_edges++;
+
+	pIndex->bFrozen = SG_FALSE;
+}
+
+//////////////////////////////////////////////////////////////////
+
+static SG_dagfrag__foreach_member_callback _sg_dagindex__add_member_cb;
+
+static void _sg_dagindex__add_member_cb(SG_context * pCtx,
+										const SG_dagnode * pDagnode,
+										SG_UNUSED_PARAM(SG_dagfrag_state qs),
+										void * pVoidIndex)
+{
+	// __foreach_member() presents ancestors before descendants, so the
+	// parents of this member are either already in the index or were
+	// added by an earlier call.
+
+	SG_dagindex * pIndex = (SG_dagindex *)pVoidIndex;
+	SG_rbtree * prbParents = NULL;
+	SG_rbtree_iterator * pIter = NULL;
+	const char * pszHid = NULL;
+	const char * pszHidParent = NULL;
+	SG_int32 gen = 0;
+	SG_bool bFound = SG_FALSE;
+
+	SG_UNUSED(qs);
+
+	SG_ERR_CHECK(  SG_dagnode__get_id_ref(pCtx, pDagnode, &pszHid)  );
+	SG_ERR_CHECK(  SG_rbtree__find(pCtx, pIndex->prbIds, pszHid, &bFound, NULL)  );
+	if (bFound)
+		return;
+
+	SG_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pDagnode, &gen)  );
+	SG_ERR_CHECK(  SG_dagindex__add_node(pCtx, pIndex, pszHid, gen)  );
+
+	SG_ERR_CHECK(  SG_dagnode__get_parents__rbtree_ref(pCtx, pDagnode, &prbParents)  );
+	if (prbParents)
+	{
+		SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, prbParents, &bFound, &pszHidParent, NULL)  );
+		while (bFound)
+		{
+			SG_ERR_CHECK(  SG_dagindex__add_edge(pCtx, pIndex, pszHid, pszHidParent)  );
+			SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &bFound, &pszHidParent, NULL)  );
+		}
+	}
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+}
+
+void SG_dagindex__add_dagfrag(SG_context * pCtx,
+							  SG_dagindex * pIndex,
+							  SG_dagfrag * pFrag)
+{
+	SG_uint32 iDagNum = 0;
+
+	SG_NULLARGCHECK_RETURN(pIndex);
+	SG_NULLARGCHECK_RETURN(pFrag);
+
+	SG_ERR_CHECK_RETURN(  SG_dagfrag__get_dagnum(pCtx, pFrag, &iDagNum)  );
+	if (iDagNum != pIndex->iDagNum)
+		SG_ERR_THROW_RETURN(  SG_ERR_INVALIDARG  );
+
+	SG_ERR_CHECK_RETURN(  SG_dagfrag__foreach_member(pCtx, pFrag, _sg_dagindex__add_member_cb, pIndex)  );
+	SG_ERR_CHECK_RETURN(  SG_dagindex__freeze(pCtx, pIndex)  );
+}
+
+//////////////////////////////////////////////////////////////////
+
+void SG_dagindex__freeze(SG_context * pCtx, SG_dagindex * pIndex)
+{
+	SG_uint32 * aCursor = NULL;
+	SG_uint32 k;
+
+	SG_NULLARGCHECK_RETURN(pIndex);
+
+	if (pIndex->bFrozen)
+		return;
+
+	SG_ERR_CHECK(  _sg_dagindex__unfreeze(pCtx, pIndex)  );
+
+	// SG_alloc() zeroes, so the start arrays begin as counts.
+
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->count_nodes + 1, pIndex->aParentStart)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->count_nodes + 1, pIndex->aChildStart)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->count_edges + 1, pIndex->aParents)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->count_edges + 1, pIndex->aChildren)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pIndex->count_nodes + 1, aCursor)  );
+
+	for (k=0; k<pIndex->count_edges; k++)
+	{
+		pIndex->aParentStart[ pIndex->aEdgeChild[k] + 1 ]++;
+		pIndex->aChildStart[ pIndex->aEdgeParent[k] + 1 ]++;
+	}
+	for (k=0; k<pIndex->count_nodes; k++)
+	{
+		pIndex->aParentStart[k+1] += pIndex->aParentStart[k];
+		pIndex->aChildStart[k+1] += pIndex->aChildStart[k];
+	}
+
+	memcpy(aCursor, pIndex->aParentStart, (pIndex->count_nodes + 1) * sizeof(SG_uint32));
+	for (k=0; k<pIndex->count_edges; k++)
+		pIndex->aParents[ aCursor[ pIndex->aEdgeChild[k] ]++ ] = pIndex->aEdgeParent[k];
+
+	memcpy(aCursor, pIndex->aChildStart, (pIndex->count_nodes + 1) * sizeof(SG_uint32));
+	for (k=0; k<pIndex->count_edges; k++)
+		pIndex->aChildren[ aCursor[ pIndex->aEdgeParent[k] ]++ ] = pIndex->aEdgeChild[k];
+
+	pIndex->bFrozen = SG_TRUE;
+
+	SG_NULLFREE(pCtx, aCursor);
+	return;
+
+fail:
+	SG_NULLFREE(pCtx, aCursor);
+	SG_ERR_IGNORE(  _sg_dagindex__unfreeze(pCtx, pIndex)  );
+}
+
+//////////////////////////////////////////////////////////////////
+
+#define MY_VERIFY_NODE(pIndex,iNode)										\
+	SG_STATEMENT(	SG_NULLARGCHECK_RETURN(pIndex);							\
+					if ((iNode) >= (pIndex)->count_nodes)					\
+						SG_ERR_THROW_RETURN(  SG_ERR_INVALIDARG  );			)
+
+#define MY_VERIFY_FROZEN(pIndex)											\
+	SG_STATEMENT(	if (!(pIndex)->bFrozen)									\
+						SG_ERR_THROW_RETURN(  SG_ERR_INVALID_UNLESS_FROZEN  );	)
+
+void SG_dagindex__get_dagnum(SG_context * pCtx, const SG_dagindex * pIndex, SG_uint32 * piDagNum)
+{
+	SG_NULLARGCHECK_RETURN(pIndex);
+	SG_NULLARGCHECK_RETURN(piDagNum);
+
+	*piDagNum = pIndex->iDagNum;
+}
+
+void SG_dagindex__count(SG_context * pCtx, const SG_dagindex * pIndex, SG_uint32 * pCount)
+{
+	SG_NULLARGCHECK_RETURN(pIndex);
+	SG_NULLARGCHECK_RETURN(pCount);
+
+	*pCount = pIndex->count_nodes;
+}
+
+void SG_dagindex__lookup(SG_context * pCtx,
+						 const SG_dagindex * pIndex,
+						 const char * pszHid,
+						 SG_bool * pbFound,
+						 SG_uint32 * piNode)
+{
+	SG_uint32 * pId = NULL;
+	SG_bool bFound = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pIndex);
+	SG_NONEMPTYCHECK_RETURN(pszHid);
+	SG_NULLARGCHECK_RETURN(pbFound);
+
+	SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx, pIndex->prbIds, pszHid, &bFound, (void **)&pId)  );
+
+	*pbFound = bFound;
+	if (piNode)
+		*piNode = ((bFound) ? *pId : 0);
+}
+
+void SG_dagindex__get_hid_ref(SG_context * pCtx,
+							  const SG_dagindex * pIndex,
+							  SG_uint32 iNode,
+							  const char ** ppszHid)
+{
+	MY_VERIFY_NODE(pIndex, iNode);
+	SG_NULLARGCHECK_RETURN(ppszHid);
+
+	*ppszHid = pIndex->aHids[iNode];
+}
+
+void SG_dagindex__get_generation(SG_context * pCtx,
+								 const SG_dagindex * pIndex,
+								 SG_uint32 iNode,
+								 SG_int32 * pGen)
+{
+	MY_VERIFY_NODE(pIndex, iNode);
+	SG_NULLARGCHECK_RETURN(pGen);
+
+	*pGen = pIndex->aGens[iNode];
+}
+
+void SG_dagindex__get_parents(SG_context * pCtx,
+							  const SG_dagindex * pIndex,
+							  SG_uint32 iNode,
+							  SG_uint32 * pCount,
+							  const SG_uint32 ** paParents)
+{
+	MY_VERIFY_NODE(pIndex, iNode);
+	MY_VERIFY_FROZEN(pIndex);
+	SG_NULLARGCHECK_RETURN(pCount);
+	SG_NULLARGCHECK_RETURN(paParents);
+
+	*pCount = pIndex->aParentStart[iNode + 1] - pIndex->aParentStart[iNode];
+	*paParents = &pIndex->aParents[ pIndex->aParentStart[iNode] ];
+}
+
+void SG_dagindex__get_children(SG_context * pCtx,
+							   const SG_dagindex * pIndex,
+							   SG_uint32 iNode,
+							   SG_uint32 * pCount,
+							   const SG_uint32 ** paChildren)
+{
+	MY_VERIFY_NODE(pIndex, iNode);
+	MY_VERIFY_FROZEN(pIndex);
+	SG_NULLARGCHECK_RETURN(pCount);
+	SG_NULLARGCHECK_RETURN(paChildren);
+
+	*pCount = pIndex->aChildStart[iNode + 1] - pIndex->aChildStart[iNode];
+	*paChildren = &pIndex->aChildren[ pIndex->aChildStart[iNode] ];
+}
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Get the scratch space ready for a walk and return the stamp that
+ * marks a node as visited by it.
+ *
+ * The scratch space isn't part of the value of the index, so we change
+ * it even though the walks take a const index.  An index belongs to a
+ * single repo instance and so is only used by one thread at a time.
+ */
+static void _sg_dagindex__begin_walk(SG_context * pCtx,
+									 const SG_dagindex * pConstIndex,
+									 SG_uint32 * piStamp)
+{
+	SG_dagindex * pIndex = (SG_dagindex *)pConstIndex;
+
+	if (!pIndex->aVisited)
+	{
+		SG_ERR_CHECK_RETURN(  SG_allocN(pCtx, pIndex->count_nodes, pIndex->aVisited)  );
+		SG_ERR_CHECK_RETURN(  SG_allocN(pCtx, pIndex->count_nodes, pIndex->aStack)  );
+		pIndex->visit_stamp = 0;
+	}
+
+	pIndex->visit_stamp++;
+	if (pIndex->visit_stamp == 0)
+	{
+		// the stamp wrapped; start over with a clean array.
+		memset(pIndex->aVisited, 0, pIndex->count_nodes * sizeof(SG_uint32));
+		pIndex->visit_stamp = 1;
+	}
+
+	*piStamp = pIndex->visit_stamp;
+}
+
+void SG_dagindex__is_ancestor(SG_context * pCtx,
+							  const SG_dagindex * pIndex,
+							  SG_uint32 iAncestor,
+							  SG_uint32 iDescendant,
+							  SG_bool * pbResult)
+{
+	SG_uint32 * aVisited;
+	SG_uint32 * aStack;
+	SG_uint32 stamp = 0;
+	SG_uint32 depth = 0;
+	SG_int32 genAncestor;
+	SG_bool bResult = SG_FALSE;
+
+	MY_VERIFY_NODE(pIndex, iAncestor);
+	MY_VERIFY_NODE(pIndex, iDescendant);
+	MY_VERIFY_FROZEN(pIndex);
+	SG_NULLARGCHECK_RETURN(pbResult);
+
+	if (iAncestor == iDescendant)
+	{
+		*pbResult = SG_TRUE;
+		return;
+	}
+
+	// an ancestor always has a smaller generation than all of its
+	// descendants, so we never need to look at a node whose generation
+	// is at or below that of the one we are looking for.
+
+	genAncestor = pIndex->aGens[iAncestor];
+	if (pIndex->aGens[iDescendant] <= genAncestor)
+	{
+		*pbResult = SG_FALSE;
+		return;
+	}
+
+	SG_ERR_CHECK_RETURN(  _sg_dagindex__begin_walk(pCtx, pIndex, &stamp)  );
+	aVisited = pIndex->aVisited;
+	aStack = pIndex->aStack;
+
+	aStack[depth++] = iDescendant;
+	aVisited[iDescendant] = stamp;
+
+	while (depth && !bResult)
+	{
+		SG_uint32 iNode = aStack[--depth];
+		SG_uint32 k;
+
+		for (k=pIndex->aParentStart[iNode]; k<pIndex->aParentStart[iNode+1]; k++)
+		{
+			SG_uint32 iParent = pIndex->aParents[k];
+
+			if (iParent == iAncestor)
+			{
+				bResult = SG_TRUE;
+				break;
+			}
+			if ((aVisited[iParent] != stamp) && (pIndex->aGens[iParent] > genAncestor))
+			{
+				aVisited[iParent] = stamp;
+				aStack[depth++] = iParent;
+			}
+		}
+	}
+
+	*pbResult = bResult;
+}
+
+void SG_dagindex__find_descendant_leaves(SG_context * pCtx,
+										 const SG_dagindex * pIndex,
+										 SG_uint32 iStart,
+										 SG_uint32 stop_after,
+										 SG_rbtree * prbLeaves,
+										 SG_uint32 * pCountFound)
+{
+	SG_uint32 * aVisited;
+	SG_uint32 * aStack;
+	SG_uint32 stamp = 0;
+	SG_uint32 depth = 0;
+	SG_uint32 nrFound = 0;
+
+	MY_VERIFY_NODE(pIndex, iStart);
+	MY_VERIFY_FROZEN(pIndex);
+	SG_NULLARGCHECK_RETURN(prbLeaves);
+
+	SG_ERR_CHECK_RETURN(  _sg_dagindex__begin_walk(pCtx, pIndex, &stamp)  );
+	aVisited = pIndex->aVisited;
+	aStack = pIndex->aStack;
+
+	aStack[depth++] = iStart;
+	aVisited[iStart] = stamp;
+
+	while (depth)
+	{
+		SG_uint32 iNode = aStack[--depth];
+		SG_uint32 k;
+
+		if (pIndex->aChildStart[iNode] == pIndex->aChildStart[iNode+1])
+		{
+			SG_ERR_CHECK(  SG_rbtree__update(pCtx, prbLeaves, pIndex->aHids[iNode])  );
+			nrFound++;
+			if (stop_after && (nrFound > stop_after))
+				break;
+			continue;
+		}
+
+		for (k=pIndex->aChildStart[iNode]; k<pIndex->aChildStart[iNode+1]; k++)
+		{
+			SG_uint32 iChild = pIndex->aChildren[k];
+
+			if (aVisited[iChild] != stamp)
+			{
+				aVisited[iChild] = stamp;
+				aStack[depth++] = iChild;
+			}
+		}
+	}
+
+	if (pCountFound)
+		*pCountFound = nrFound;
+
+fail:
+	return;
+}
+
+//////////////////////////////////////////////////////////////////
+
+void SG_dagindex__fetch_dagnode(SG_context * pCtx,
+								void * pVoidIndex,
+								const char * pszHid,
+								SG_dagnode ** ppNewDagnode)
+{
+	const SG_dagindex * pIndex = (const SG_dagindex *)pVoidIndex;
+	SG_dagnode * pNewDagnode = NULL;
+	SG_uint32 iNode = 0;
+	SG_uint32 k;
+	SG_bool bFound = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pIndex);
+	SG_NULLARGCHECK_RETURN(ppNewDagnode);
+	MY_VERIFY_FROZEN(pIndex);
+
+	SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHid, &bFound, &iNode)  );
+	if (!bFound)
+		SG_ERR_THROW(  SG_ERR_NOT_FOUND  );
+
+	SG_ERR_CHECK(  SG_dagnode__alloc(pCtx, &pNewDagnode, pszHid, pIndex->aGens[iNode])  );
+	for (k=pIndex->aParentStart[iNode]; k<pIndex->aParentStart[iNode+1]; k++)
+		SG_ERR_CHECK(  SG_dagnode__add_parent(pCtx, pNewDagnode, pIndex->aHids[ pIndex->aParents[k] ])  );
+	SG_ERR_CHECK(  SG_dagnode__freeze(pCtx, pNewDagnode)  );
+
+	*ppNewDagnode = pNewDagnode;
+	return;
+
+fail:
+	SG_DAGNODE_NULLFREE(pCtx, pNewDagnode);
+}
@@ -53,6 +53,7 @@ struct SG_dagnode
 	SG_rbtree *				m_prbtreeParents;	// rbtree containing parent HIDs
 	SG_int32				m_generation;	// the depth of the DAGNODE in the DAG (must be signed).
 	SG_bool					m_bIsFrozen;
+	SG_uint32				m_nShares;		// references beyond the first (see SG_objcache__share())
 };
 
 /*
@@ -142,11 +143,21 @@ void SG_dagnode__free(SG_context * pCtx, SG_dagnode * pdn)
 	if (!pdn)
 		return;
 
+	if (SG_objcache__unshare(&pdn->m_nShares))
+		return;
+
 	SG_RBTREE_NULLFREE(pCtx, pdn->m_prbtreeParents);
 
 	SG_NULLFREE(pCtx, pdn);
 }
 
+void SG_dagnode__addref(SG_context * pCtx, SG_dagnode * pdn)
+{
+	SG_UNUSED(pCtx);
+
+	SG_objcache__share(&pdn->m_nShares);
+}
+
 //////////////////////////////////////////////////////////////////
 
 void SG_dagnode__get_id(SG_context* pCtx, const SG_dagnode * pdn, char** ppszidHidChangeset)
@@ -36,10 +36,11 @@ void SG_dagquery__how_are_dagnodes_related(SG_context * pCtx,
 {
 	SG_changeset * pcs1 = NULL;
 	SG_changeset * pcs2 = NULL;
-	SG_dagfrag * pFrag = NULL;
+	const SG_dagindex * pIndex = NULL;
 	SG_dagquery_relationship dqRel = SG_DAGQUERY_RELATIONSHIP__UNKNOWN;
 	SG_uint32 iDagNum1, iDagNum2;
 	SG_int32 gen1, gen2;
+	SG_uint32 iNode1, iNode2;
 	SG_bool bFound;
 
 	SG_NULLARGCHECK_RETURN(pRepo);
@@ -93,23 +94,29 @@ void SG_dagquery__how_are_dagnodes_related(SG_context * pCtx,
 		goto cleanup;
 	}
 
-	// see if one is an ancestor of the other.  since we only have PARENT
-	// edges in our DAG, we start with the deeper one and walk backwards
-	// until we've visited all ancestors at the depth of the shallower one.
-	//
-	// i'm going to be lazy here and not reinvent a recursive-ish parent-edge
-	// graph walker.  instead, i'm going to create a DAGFRAG using the
-	// deeper one and request the generation difference as the "thickness".
-	// in theory, if we have an ancestor/descendant relationship, the
-	// shallower one should be in the END-FRINGE of the DAGFRAG.
+	// see if one is an ancestor of the other.  we use the in-memory dag
+	// index for this; it walks parent edges back from the deeper one
+	// (by integer id, without fetching any dagnodes) but never below
+	// the generation of the shallower one.
 	//
 	// i'm going to pick an arbitrary direction "cs1 is R of cs2".
+	//
+	// we ask for the index twice so that it gets reloaded if either
+	// node isn't in it yet.
+
+	SG_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, iDagNum1, pszHid1, &pIndex)  );
+	SG_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, iDagNum1, pszHid2, &pIndex)  );
+
+	SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHid1, &bFound, &iNode1)  );
+	if (!bFound)
+		SG_ERR_THROW2(  SG_ERR_DAG_NOT_CONSISTENT, (pCtx, "Changeset [%s] is not in the DAG.", pszHid1)  );
+	SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHid2, &bFound, &iNode2)  );
+	if (!bFound)
+		SG_ERR_THROW2(  SG_ERR_DAG_NOT_CONSISTENT, (pCtx, "Changeset [%s] is not in the DAG.", pszHid2)  );
 
-	SG_ERR_CHECK(  SG_dagfrag__alloc_transient(pCtx, &pFrag)  );
 	if (gen1 > gen2)
 	{
-		SG_ERR_CHECK(  SG_dagfrag__load_from_repo__one(pCtx, pFrag, pRepo, pszHid1, (gen1 - gen2))  );
-		SG_ERR_CHECK(  SG_dagfrag__query(pCtx, pFrag, pszHid2, NULL, NULL, &bFound, NULL)  );
+		SG_ERR_CHECK(  SG_dagindex__is_ancestor(pCtx, pIndex, iNode2, iNode1, &bFound)  );
 
 		if (bFound)			// pszHid2 is an ancestor of pszHid1.  READ pszHid1 is a descendent of pszHid2.
 			dqRel = SG_DAGQUERY_RELATIONSHIP__DESCENDANT;
@@ -119,8 +126,7 @@ void SG_dagquery__how_are_dagnodes_related(SG_context * pCtx,
 	}
 	else
 	{
-		SG_ERR_CHECK(  SG_dagfrag__load_from_repo__one(pCtx, pFrag, pRepo, pszHid2, (gen2 - gen1))  );
-		SG_ERR_CHECK(  SG_dagfrag__query(pCtx, pFrag, pszHid1, NULL, NULL, &bFound, NULL)  );
+		SG_ERR_CHECK(  SG_dagindex__is_ancestor(pCtx, pIndex, iNode1, iNode2, &bFound)  );
 
 		if (bFound)			// pszHid1 is an ancestor of pszHid2.
 			dqRel = SG_DAGQUERY_RELATIONSHIP__ANCESTOR;
@@ -137,7 +143,6 @@ cleanup:
 fail:
 	SG_CHANGESET_NULLFREE(pCtx, pcs1);
 	SG_CHANGESET_NULLFREE(pCtx, pcs2);
-	SG_DAGFRAG_NULLFREE(pCtx, pFrag);
 }
 
 //////////////////////////////////////////////////////////////////
@@ -153,12 +158,13 @@ void SG_dagquery__find_descendant_heads(SG_context * pCtx,
 	SG_rbtree * prbLeaves = NULL;
 	SG_rbtree * prbHeadsFound = NULL;
 	SG_rbtree_iterator * pIter = NULL;
+	const SG_dagindex * pIndex = NULL;
 	const char * pszKey_k;
 	SG_uint32 iDagNum;
+	SG_uint32 iNodeStart;
 	SG_bool b;
 	SG_dagquery_find_head_status dqfhs;
-	SG_dagquery_relationship dqRel;
-	SG_uint32 nrFound;
+	SG_uint32 nrFound = 0;
 
 	SG_NULLARGCHECK_RETURN(pRepo);
 	SG_NONEMPTYCHECK_RETURN(pszHidStart);
@@ -191,35 +197,39 @@ void SG_dagquery__find_descendant_heads(SG_context * pCtx,
 		goto done;
 	}
 
-	// inspect each leaf and qualify it; put the ones that pass
-	// into the list of actual heads.
+	// make sure the dag index is current: if every leaf in the repo is in
+	// it then so is every dagnode (every dagnode is an ancestor of some
+	// leaf and the index always has the full ancestry of its nodes).
 
-	nrFound = 0;
 	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, prbLeaves, &b, &pszKey_k, NULL)  );
 	while (b)
 	{
-		SG_ERR_CHECK(  SG_dagquery__how_are_dagnodes_related(pCtx, pRepo, pszKey_k, pszHidStart, &dqRel)  );
+		SG_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, iDagNum, pszKey_k, &pIndex)  );
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, &pszKey_k, NULL)  );
+	}
+	SG_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, iDagNum, pszHidStart, &pIndex)  );
 
-		if (dqRel == SG_DAGQUERY_RELATIONSHIP__DESCENDANT)
-		{
-			nrFound++;
+	SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHidStart, &b, &iNodeStart)  );
+	if (!b)
+		SG_ERR_THROW2(  SG_ERR_DAG_NOT_CONSISTENT, (pCtx, "Changeset [%s] is not in the DAG.", pszHidStart)  );
 
-			if (bStopIfMultiple && (nrFound > 1))
-			{
-				// they wanted a unique answer and we've found too many answers
-				// (which they won't be able to use anyway) so just stop and
-				// return the status.  (we delete prbHeadsFound because it is
-				// incomplete and so that they won't be tempted to use it.)
+	// walk child edges forward from the starting point and collect the
+	// leaves we reach.
 
-				SG_RBTREE_NULLFREE(pCtx, prbHeadsFound);
-				dqfhs = SG_DAGQUERY_FIND_HEAD_STATUS__MULTIPLE;
-				goto done;
-			}
+	SG_ERR_CHECK(  SG_dagindex__find_descendant_leaves(pCtx, pIndex, iNodeStart,
+													   ((bStopIfMultiple) ? 1 : 0),
+													   prbHeadsFound, &nrFound)  );
 
-			SG_ERR_CHECK(  SG_rbtree__add(pCtx, prbHeadsFound, pszKey_k)  );
-		}
+	if (bStopIfMultiple && (nrFound > 1))
+	{
+		// they wanted a unique answer and we've found too many answers
+		// (which they won't be able to use anyway) so just stop and
+		// return the status.  (we delete prbHeadsFound because it is
+		// incomplete and so that they won't be tempted to use it.)
 
-		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, &pszKey_k, NULL)  );
+		SG_RBTREE_NULLFREE(pCtx, prbHeadsFound);
+		dqfhs = SG_DAGQUERY_FIND_HEAD_STATUS__MULTIPLE;
+		goto done;
 	}
 
 	switch (nrFound)
@@ -119,8 +119,42 @@ static void _dw_work_queue__remove_first(SG_context * pCtx,
 	*ppData = ((bFound) ? pData : NULL);
 }
 
+static void _dw__get_dagnum(SG_context * pCtx,
+							SG_repo * pRepo,
+							const char * pszHid,
+							SG_uint32 * piDagNum)
+{
+	// the dagnode doesn't know which dag it belongs to, but the changeset does.
+
+	SG_changeset * pcs = NULL;
+
+	SG_ERR_CHECK(  SG_changeset__load_from_repo(pCtx, pRepo, pszHid, &pcs)  );
+	SG_ERR_CHECK(  SG_changeset__get_dagnum(pCtx, pcs, piDagNum)  );
+
+fail:
+	SG_CHANGESET_NULLFREE(pCtx, pcs);
+}
+
+static void _dw__fetch_dagnode(SG_context * pCtx,
+							   SG_repo * pRepo,
+							   SG_uint32 iDagNum,
+							   const char * pszHid,
+							   SG_dagnode ** ppDagnode)
+{
+	// build the dagnode from the repo's in-memory dag index rather than
+	// going to the repo for each one.  we ask for the index every time
+	// (it's just a lookup) because the callback is allowed to do things
+	// to the repo that replace it.
+
+	const SG_dagindex * pIndex = NULL;
+
+	SG_ERR_CHECK_RETURN(  SG_repo__get_dagindex(pCtx, pRepo, iDagNum, pszHid, &pIndex)  );
+	SG_ERR_CHECK_RETURN(  SG_dagindex__fetch_dagnode(pCtx, (void *)pIndex, pszHid, ppDagnode)  );
+}
+
 static void _walk_dag(SG_context* pCtx,
 					  SG_repo* pRepo,
+					  SG_uint32 iDagNum,
 					  SG_dag_walk_callback* callbackFunction,
 					  void* callbackData,
 					  SG_rbtree* prbtree_work_queue,
@@ -153,7 +187,7 @@ static void _walk_dag(SG_context* pCtx,
 					SG_ERR_CHECK(  SG_rbtree__find(pCtx, prbtree_dagnode_cache, parentHid, &bFoundInCache, NULL) );
 					if (bFoundInCache == SG_FALSE)
 					{
-						SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, parentHid, &pDagnode)  );
+						SG_ERR_CHECK(  _dw__fetch_dagnode(pCtx, pRepo, iDagNum, parentHid, &pDagnode)  );
 						SG_ERR_CHECK(  _dw_work_queue__insert(pCtx, prbtree_work_queue, pDagnode)  );
 						SG_ERR_CHECK(  _dw_cache__insert__dagnode(pCtx, prbtree_dagnode_cache, pDagnode)  );
 					}
@@ -189,16 +223,18 @@ void SG_dagwalker__walk_dag_single(SG_context* pCtx,
 	SG_dagnode* pdn = NULL;
 	SG_rbtree * prbtree_work_queue = NULL;
 	SG_rbtree * prbtree_dagnode_cache = NULL;
+	SG_uint32 iDagNum = 0;
 
 	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbtree_work_queue)  );
 	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbtree_dagnode_cache)  );
 
-	SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pszStartWithNodeHid, &pdn)  );
+	SG_ERR_CHECK(  _dw__get_dagnum(pCtx, pRepo, pszStartWithNodeHid, &iDagNum)  );
+	SG_ERR_CHECK(  _dw__fetch_dagnode(pCtx, pRepo, iDagNum, pszStartWithNodeHid, &pdn)  );
 	SG_ERR_CHECK(  _dw_work_queue__insert(pCtx, prbtree_work_queue, pdn)  );
 	SG_ERR_CHECK(  _dw_cache__insert__dagnode(pCtx, prbtree_dagnode_cache, pdn)  );
 	pdn = NULL;
 
-	SG_ERR_CHECK(  _walk_dag(pCtx, pRepo, callbackFunction, callbackData, prbtree_work_queue, prbtree_dagnode_cache)  );
+	SG_ERR_CHECK(  _walk_dag(pCtx, pRepo, iDagNum, callbackFunction, callbackData, prbtree_work_queue, prbtree_dagnode_cache)  );
 
 	/* fall through */
 fail:
@@ -215,6 +251,7 @@ void SG_dagwalker__walk_dag(SG_context * pCtx, SG_repo * pRepo, SG_stringarray *
 	SG_dagnode* pdn = NULL;
 	SG_rbtree * prbtree_work_queue = NULL;
 	SG_rbtree * prbtree_dagnode_cache = NULL;
+	SG_uint32 iDagNum = 0;
 
 	SG_ERR_CHECK(  SG_stringarray__count(pCtx, pStringArrayStartNodes, &SearchVectorCount )  );
 	if (SearchVectorCount == 0)
@@ -223,17 +260,21 @@ void SG_dagwalker__walk_dag(SG_context * pCtx, SG_repo * pRepo, SG_stringarray *
 	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbtree_work_queue)  );
 	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbtree_dagnode_cache)  );
 
+	//All of the start nodes are in the same dag.
+	SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, pStringArrayStartNodes, 0, &pStrCurrentDagNode)  );
+	SG_ERR_CHECK(  _dw__get_dagnum(pCtx, pRepo, pStrCurrentDagNode, &iDagNum)  );
+
 	//Look up the dagnodes for the start nodes.
 	for (SearchVectorIndex = 0; SearchVectorIndex < SearchVectorCount; SearchVectorIndex++)
 	{
 		SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, pStringArrayStartNodes, SearchVectorIndex, &pStrCurrentDagNode)  );
-		SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pStrCurrentDagNode, &pdn)  );
+		SG_ERR_CHECK(  _dw__fetch_dagnode(pCtx, pRepo, iDagNum, pStrCurrentDagNode, &pdn)  );
 		SG_ERR_CHECK(  _dw_work_queue__insert(pCtx, prbtree_work_queue, pdn)  );
 		SG_ERR_CHECK(  _dw_cache__insert__dagnode(pCtx, prbtree_dagnode_cache, pdn)  );
         pdn = NULL;
 	}
 
-	SG_ERR_CHECK(  _walk_dag(pCtx, pRepo, callbackFunction, callbackData, prbtree_work_queue, prbtree_dagnode_cache)  );
+	SG_ERR_CHECK(  _walk_dag(pCtx, pRepo, iDagNum, callbackFunction, callbackData, prbtree_work_queue, prbtree_dagnode_cache)  );
 
 	SG_RBTREE_NULLFREE(pCtx, prbtree_dagnode_cache);
 	SG_RBTREE_NULLFREE(pCtx, prbtree_work_queue);
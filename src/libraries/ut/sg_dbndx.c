@@ -29,11 +29,17 @@ struct _SG_dbndx
 	SG_pathname* pPath_db;  /* the sqlite db file */
 
     sqlite3* psql;
+    sg_sqlite__stmt_cache* pStmtCache;
 	SG_bool			bInTransaction;
 
     SG_bool bQueryOnly;
     char* psz_cur_state_csid;
     SG_int32 i_cur_state_generation;
+
+    SG_bool b_have_snapshots;
+
+    SG_bool b_have_typed_tables;
+    SG_vhash* pvh_typed;
 };
 
 struct SG_dbndx_qresult
@@ -87,6 +93,16 @@ static void sg_dbndx__create_db(
         SG_dbndx* pdbc
         );
 
+static void sg_dbndx__check_snapshot_tables(
+        SG_context* pCtx,
+        SG_dbndx* pdbc
+        );
+
+static void sg_dbndx__check_typed_tables(
+        SG_context* pCtx,
+        SG_dbndx* pdbc
+        );
+
 static void sg_dbndx__do_where(
         SG_context* pCtx,
         sqlite3* psql,
@@ -103,6 +119,15 @@ static void sg_dbndx__do_state_filter(
         SG_uint32* piCount
         );
 
+static void sg_dbndx__get_state_table(
+        SG_context* pCtx,
+        SG_dbndx* pndx,
+        const char* psz_csid,
+        char* buf_table,
+        SG_uint32 bufsize,
+        SG_bool* pb_temp_table
+        );
+
 //////////////////////////////////////////////////////////////////
 // All of the code in this file creates various temporary
 // tables using buffers defined with the following size.
@@ -216,6 +241,9 @@ void SG_dbndx__open(
         SG_ERR_CHECK(  sg_dbndx__create_db(pCtx, pdbc)  );
         SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pdbc->psql, "PRAGMA temp_store=2")  );
     }
+    SG_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pdbc->pStmtCache)  );
+    SG_ERR_CHECK(  sg_dbndx__check_snapshot_tables(pCtx, pdbc)  );
+    SG_ERR_CHECK(  sg_dbndx__check_typed_tables(pCtx, pdbc)  );
     SG_ERR_CHECK(  sg_dbndx__read_cur_state(pCtx, pdbc, &pdbc->psz_cur_state_csid, &pdbc->i_cur_state_generation)  );
 
 	*ppNew = pdbc;
@@ -232,9 +260,11 @@ void SG_dbndx__free(SG_context* pCtx, SG_dbndx* pdbc)
 	if (!pdbc)
 		return;
 
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pdbc->pStmtCache);
 	SG_ERR_IGNORE(  sg_sqlite__close(pCtx, pdbc->psql)  );
 
     SG_NULLFREE(pCtx, pdbc->psz_cur_state_csid);
+    SG_VHASH_NULLFREE(pCtx, pdbc->pvh_typed);
 	SG_PATHNAME_NULLFREE(pCtx, pdbc->pPath_db);
 
 	SG_NULLFREE(pCtx, pdbc);
@@ -459,7 +489,7 @@ static void sg_dbndx__add_record_to_history_table(
 
         SG_ERR_CHECK(  SG_dbrecord__get_hid__ref(pCtx, prec, &psz_hid)  );
 
-        SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "INSERT OR IGNORE INTO db_history (recid, hidrec, csid, generation) VALUES (?, ?, ?, ?)")  );
+        SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pdbc->psql, pdbc->pStmtCache, &pStmt, "INSERT OR IGNORE INTO db_history (recid, hidrec, csid, generation) VALUES (?, ?, ?, ?)")  );
 
 		SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_recid)  );
 		SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2, psz_hid)  );
@@ -470,10 +500,7 @@ static void sg_dbndx__add_record_to_history_table(
     }
 
 fail:
-	if (pStmt)
-	{
-		SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx,pStmt)  );
-	}
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt)  );
 }
 
 static void sg_dbndx__add_record_to_audits(SG_context* pCtx, SG_dbrecord* prec, SG_varray* pva_audits_for_one_dag)
@@ -496,6 +523,47 @@ fail:
     ;
 }
 
+/**
+ * The integer value we store for a field, so that numeric fields sort
+ * and compare as numbers.  A string field with a list of allowed
+ * values gets the index of its value in the list.
+ */
+static void sg_dbndx__get_intvalue(
+        SG_context* pCtx,
+        SG_zingfieldattributes* pzfa,
+        const char* psz_value,
+        SG_bool* pb_has_int,
+        SG_int64* pi
+        )
+{
+    if (
+            pzfa
+            && (
+                (pzfa->type == SG_ZING_TYPE__INT)
+                || (pzfa->type == SG_ZING_TYPE__BOOL)
+                || (pzfa->type == SG_ZING_TYPE__DATETIME)
+               )
+       )
+    {
+        SG_ERR_CHECK_RETURN(  SG_int64__parse__strict(pCtx, pi, psz_value)  );
+        *pb_has_int = SG_TRUE;
+    }
+    else if (
+            pzfa
+            && (pzfa->type == SG_ZING_TYPE__STRING)
+            && (pzfa->v._string.allowed)
+            )
+    {
+        SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pzfa->v._string.allowed, psz_value, pi)  );
+        *pb_has_int = SG_TRUE;
+    }
+    else
+    {
+        SG_context__err_reset(pCtx);
+        *pb_has_int = SG_FALSE;
+    }
+}
+
 static void sg_dbndx__add_record_to_pairs_table(
         SG_context* pCtx,
         SG_dbrecord* prec,
@@ -522,6 +590,8 @@ static void sg_dbndx__add_record_to_pairs_table(
 		const char* psz_name;
 		const char* psz_value;
         SG_zingfieldattributes* pzfa = NULL;
+        SG_bool b_has_int = SG_FALSE;
+        SG_int64 intvalue = 0;
 
 		SG_ERR_CHECK(  SG_dbrecord__get_nth_pair(pCtx, prec, i, &psz_name, &psz_value)  );
 
@@ -536,45 +606,913 @@ static void sg_dbndx__add_record_to_pairs_table(
         SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2, psz_name)  );
         SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 3, psz_value)  );
 
-        if (
-                pzfa
-                && (
+        SG_ERR_CHECK(  sg_dbndx__get_intvalue(pCtx, pzfa, psz_value, &b_has_int, &intvalue)  );
+        if (b_has_int)
+        {
+            SG_ERR_CHECK(  sg_sqlite__bind_int64(pCtx, pStmt, 4, intvalue)  );
+        }
+        else
+        {
+            SG_ERR_CHECK(  sg_sqlite__bind_null(pCtx, pStmt, 4)  );
+        }
+
+        SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+	}
+
+
+fail:
+    ;
+}
+
+//////////////////////////////////////////////////////////////////
+// Typed record tables.
+//
+// db_pairs stores one row per name-value pair, which is flexible but
+// means that every clause of a query is a scan of the name index
+// followed by an intersection of temp tables.  So we also store each
+// record in a table for its rectype, with one column per field:
+//
+//     zrt_tables  (rectype, tbl)              -- rectype --> zrt_N
+//     zrt_columns (rectype, field, col, ...)  -- field --> column number
+//
+// Field names can be anything the template allows, so they never
+// appear in the schema.  Field number c is stored in two columns, sc
+// (the string value, like db_pairs.strvalue) and ic (the integer
+// value, like db_pairs.intvalue).  Columns are added as new fields
+// show up.  A field marked "index" in the template gets an index on
+// the column it will be queried by.
+//
+// A query which is limited to one rectype (every zing query against a
+// template with more than one rectype; with only one, zing leaves the
+// rectype clause out) compiles to one SELECT against that table, with
+// the state filter and the sort in the same statement.  Anything else
+// still uses db_pairs.
+
+#define sg_DBNDX_TYPED__TBL     "tbl"
+#define sg_DBNDX_TYPED__COLS    "cols"
+#define sg_DBNDX_TYPED__NDX     "ndx"
+
+static void sg_dbndx__create_typed_tables(SG_context* pCtx, SG_dbndx* pdbc)
+{
+	SG_ERR_CHECK_RETURN(  sg_sqlite__exec(pCtx, pdbc->psql, "CREATE TABLE zrt_tables (rectype VARCHAR PRIMARY KEY NOT NULL, tbl VARCHAR NOT NULL)")  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__exec(pCtx, pdbc->psql, "CREATE TABLE zrt_columns (rectype VARCHAR NOT NULL, field VARCHAR NOT NULL, col INTEGER NOT NULL, indexed INTEGER NOT NULL, UNIQUE (rectype, field))")  );
+
+    pdbc->b_have_typed_tables = SG_TRUE;
+}
+
+/**
+ * Get the cached description of the typed table for psz_rectype,
+ * loading it from zrt_tables/zrt_columns if necessary.  If there is no
+ * table for this rectype yet, we create one if b_create, otherwise
+ * *ppvh comes back NULL.
+ */
+static void sg_dbndx__typed__get_table(
+        SG_context* pCtx,
+        SG_dbndx* pdbc,
+        const char* psz_rectype,
+        SG_bool b_create,
+        SG_vhash** ppvh
+        )
+{
+	sqlite3_stmt* pStmt = NULL;
+    SG_vhash* pvh_table = NULL;
+    SG_vhash* pvh_cols = NULL;
+    SG_vhash* pvh_ndx = NULL;
+    SG_bool b_has = SG_FALSE;
+    int rc = 0;
+
+    if (!pdbc->pvh_typed)
+    {
+        SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pdbc->pvh_typed)  );
+    }
+
+    SG_ERR_CHECK(  SG_vhash__check__vhash(pCtx, pdbc->pvh_typed, psz_rectype, &b_has, &pvh_table)  );
+    if (b_has)
+    {
+        *ppvh = pvh_table;
+        return;
+    }
+
+    SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT tbl FROM zrt_tables WHERE rectype=?")  );
+    SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_rectype)  );
+    rc = sqlite3_step(pStmt);
+    if (SQLITE_ROW == rc)
+    {
+        SG_ERR_CHECK(  SG_vhash__addnew__vhash(pCtx, pdbc->pvh_typed, psz_rectype, &pvh_table)  );
+        SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh_table, sg_DBNDX_TYPED__TBL, (const char*) sqlite3_column_text(pStmt, 0))  );
+    }
+    else if (SQLITE_DONE != rc)
+    {
+        SG_ERR_THROW(  SG_ERR_SQLITE(rc)  );
+    }
+    SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+    pStmt = NULL;
+
+    if (!pvh_table)
+    {
+        SG_int32 count_tables = 0;
+        char buf_tbl[32];
+
+        if (!b_create)
+        {
+            *ppvh = NULL;
+            return;
+        }
+
+        SG_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, pdbc->psql, &count_tables, "SELECT COUNT(*) FROM zrt_tables")  );
+        SG_ERR_CHECK(  SG_sprintf(pCtx, buf_tbl, sizeof(buf_tbl), "zrt_%d", count_tables + 1)  );
+        SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "CREATE TABLE %s (hidrec VARCHAR PRIMARY KEY NOT NULL)", buf_tbl)  );
+
+        SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "INSERT INTO zrt_tables (rectype, tbl) VALUES (?, ?)")  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_rectype)  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2, buf_tbl)  );
+        SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+        SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+        pStmt = NULL;
+
+        SG_ERR_CHECK(  SG_vhash__addnew__vhash(pCtx, pdbc->pvh_typed, psz_rectype, &pvh_table)  );
+        SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh_table, sg_DBNDX_TYPED__TBL, buf_tbl)  );
+    }
+
+    SG_ERR_CHECK(  SG_vhash__addnew__vhash(pCtx, pvh_table, sg_DBNDX_TYPED__COLS, &pvh_cols)  );
+    SG_ERR_CHECK(  SG_vhash__addnew__vhash(pCtx, pvh_table, sg_DBNDX_TYPED__NDX, &pvh_ndx)  );
+
+    SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT field, col, indexed FROM zrt_columns WHERE rectype=?")  );
+    SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_rectype)  );
+	while ((rc = sqlite3_step(pStmt)) == SQLITE_ROW)
+	{
+		const char* psz_field = (const char*) sqlite3_column_text(pStmt, 0);
+
+        SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh_cols, psz_field, sqlite3_column_int64(pStmt, 1))  );
+        if (sqlite3_column_int(pStmt, 2))
+        {
+            SG_ERR_CHECK(  SG_vhash__add__null(pCtx, pvh_ndx, psz_field)  );
+        }
+	}
+	if (rc != SQLITE_DONE)
+	{
+		SG_ERR_THROW(SG_ERR_SQLITE(rc));
+	}
+    SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+    pStmt = NULL;
+
+    *ppvh = pvh_table;
+
+fail:
+    if (pStmt)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+    }
+}
+
+/**
+ * Get the column number for a field in a typed table, adding the
+ * column if necessary.  If the template says the field should be
+ * indexed, make sure it is.
+ */
+static void sg_dbndx__typed__get_column(
+        SG_context* pCtx,
+        SG_dbndx* pdbc,
+        const char* psz_rectype,
+        SG_vhash* pvh_table,
+        const char* psz_field,
+        SG_zingfieldattributes* pzfa,
+        SG_int64* pi_col
+        )
+{
+	sqlite3_stmt* pStmt = NULL;
+    const char* psz_tbl = NULL;
+    SG_vhash* pvh_cols = NULL;
+    SG_vhash* pvh_ndx = NULL;
+    SG_bool b_has = SG_FALSE;
+    SG_int64 col = 0;
+
+    SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh_table, sg_DBNDX_TYPED__TBL, &psz_tbl)  );
+    SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh_table, sg_DBNDX_TYPED__COLS, &pvh_cols)  );
+    SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh_table, sg_DBNDX_TYPED__NDX, &pvh_ndx)  );
+
+    SG_ERR_CHECK(  SG_vhash__has(pCtx, pvh_cols, psz_field, &b_has)  );
+    if (b_has)
+    {
+        SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh_cols, psz_field, &col)  );
+    }
+    else
+    {
+        SG_uint32 count_cols = 0;
+
+        SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_cols, &count_cols)  );
+        col = count_cols + 1;
+
+        SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "ALTER TABLE %s ADD COLUMN s%d VARCHAR NULL", psz_tbl, (SG_int32) col)  );
+        SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "ALTER TABLE %s ADD COLUMN i%d INTEGER NULL", psz_tbl, (SG_int32) col)  );
+
+        SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "INSERT INTO zrt_columns (rectype, field, col, indexed) VALUES (?, ?, ?, 0)")  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_rectype)  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2, psz_field)  );
+        SG_ERR_CHECK(  sg_sqlite__bind_int64(pCtx, pStmt, 3, col)  );
+        SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+        SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+        pStmt = NULL;
+
+        SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh_cols, psz_field, col)  );
+    }
+
+    if (pzfa && pzfa->index)
+    {
+        SG_ERR_CHECK(  SG_vhash__has(pCtx, pvh_ndx, psz_field, &b_has)  );
+        if (!b_has)
+        {
+            // index the column this field gets queried by
+            const char* psz_prefix = "s";
+
+            if (
                     (pzfa->type == SG_ZING_TYPE__INT)
                     || (pzfa->type == SG_ZING_TYPE__BOOL)
                     || (pzfa->type == SG_ZING_TYPE__DATETIME)
-                   )
+               )
+            {
+                psz_prefix = "i";
+            }
+
+            SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "CREATE INDEX IF NOT EXISTS %s_%s%d ON %s (%s%d)", psz_tbl, psz_prefix, (SG_int32) col, psz_tbl, psz_prefix, (SG_int32) col)  );
+
+            SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "UPDATE zrt_columns SET indexed=1 WHERE rectype=? AND field=?")  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_rectype)  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2, psz_field)  );
+            SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+            SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+            pStmt = NULL;
+
+            SG_ERR_CHECK(  SG_vhash__add__null(pCtx, pvh_ndx, psz_field)  );
+        }
+    }
+
+    *pi_col = col;
+
+fail:
+    if (pStmt)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+    }
+}
+
+static void sg_dbndx__add_record_to_typed_table(
+        SG_context* pCtx,
+        SG_dbndx* pdbc,
+        SG_dbrecord* prec,
+        SG_zingtemplate* pzt
+        )
+{
+	sqlite3_stmt* pStmt = NULL;
+    SG_string* pstr_cols = NULL;
+    SG_string* pstr_values = NULL;
+    SG_string* pstr_sql = NULL;
+    SG_vhash* pvh_table = NULL;
+    const char* psz_tbl = NULL;
+    const char* psz_hid = NULL;
+    const char* psz_rectype = NULL;
+    SG_bool b_has_rectype = SG_FALSE;
+	SG_uint32 count = 0;
+	SG_uint32 i = 0;
+
+    // not every dbrecord has a rectype.  links don't.
+    SG_ERR_CHECK(  SG_dbrecord__check_value(pCtx, prec, SG_ZING_FIELD__RECTYPE, &b_has_rectype, &psz_rectype)  );
+    if (!b_has_rectype)
+    {
+        return;
+    }
+
+    SG_ERR_CHECK(  SG_dbrecord__get_hid__ref(pCtx, prec, &psz_hid)  );
+    SG_ERR_CHECK(  sg_dbndx__typed__get_table(pCtx, pdbc, psz_rectype, SG_TRUE, &pvh_table)  );
+    SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh_table, sg_DBNDX_TYPED__TBL, &psz_tbl)  );
+
+	SG_ERR_CHECK(  SG_dbrecord__count_pairs(pCtx, prec, &count)  );
+
+    // make sure all the columns exist before we prepare the insert
+    SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr_cols)  );
+    SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr_values)  );
+    SG_ERR_CHECK(  SG_string__append__sz(pCtx, pstr_cols, "hidrec")  );
+    SG_ERR_CHECK(  SG_string__append__sz(pCtx, pstr_values, "?")  );
+	for (i=0; i<count; i++)
+	{
+		const char* psz_name = NULL;
+		const char* psz_value = NULL;
+        SG_zingfieldattributes* pzfa = NULL;
+        SG_int64 col = 0;
+
+		SG_ERR_CHECK(  SG_dbrecord__get_nth_pair(pCtx, prec, i, &psz_name, &psz_value)  );
+        if (pzt)
+        {
+            SG_ERR_CHECK(  SG_zingtemplate__get_field_attributes(pCtx, pzt, psz_rectype, psz_name, &pzfa)  );
+        }
+        SG_ERR_CHECK(  sg_dbndx__typed__get_column(pCtx, pdbc, psz_rectype, pvh_table, psz_name, pzfa, &col)  );
+        SG_ERR_CHECK(  SG_string__append__format(pCtx, pstr_cols, ", s%d, i%d", (SG_int32) col, (SG_int32) col)  );
+        SG_ERR_CHECK(  SG_string__append__sz(pCtx, pstr_values, ", ?, ?")  );
+    }
+
+    // the same rectype usually comes with the same fields, so this
+    // statement is worth caching
+    SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr_sql)  );
+    SG_ERR_CHECK(  SG_string__append__format(pCtx, pstr_sql, "INSERT OR IGNORE INTO %s (%s) VALUES (%s)", psz_tbl, SG_string__sz(pstr_cols), SG_string__sz(pstr_values))  );
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pdbc->psql, pdbc->pStmtCache, &pStmt, SG_string__sz(pstr_sql))  );
+    SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_hid)  );
+	for (i=0; i<count; i++)
+	{
+		const char* psz_name = NULL;
+		const char* psz_value = NULL;
+        SG_zingfieldattributes* pzfa = NULL;
+        SG_bool b_has_int = SG_FALSE;
+        SG_int64 intvalue = 0;
+
+		SG_ERR_CHECK(  SG_dbrecord__get_nth_pair(pCtx, prec, i, &psz_name, &psz_value)  );
+        if (pzt)
+        {
+            SG_ERR_CHECK(  SG_zingtemplate__get_field_attributes(pCtx, pzt, psz_rectype, psz_name, &pzfa)  );
+        }
+        SG_ERR_CHECK(  sg_dbndx__get_intvalue(pCtx, pzfa, psz_value, &b_has_int, &intvalue)  );
+
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2 + 2*i, psz_value)  );
+        if (b_has_int)
+        {
+            SG_ERR_CHECK(  sg_sqlite__bind_int64(pCtx, pStmt, 3 + 2*i, intvalue)  );
+        }
+        else
+        {
+            SG_ERR_CHECK(  sg_sqlite__bind_null(pCtx, pStmt, 3 + 2*i)  );
+        }
+    }
+    SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+
+fail:
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt)  );
+    SG_STRING_NULLFREE(pCtx, pstr_cols);
+    SG_STRING_NULLFREE(pCtx, pstr_values);
+    SG_STRING_NULLFREE(pCtx, pstr_sql);
+}
+
+/**
+ * A dbndx created before the typed tables existed gets them here,
+ * filled from db_pairs.  We don't have the template at this point, so
+ * no indexes are created until records arrive with a template which
+ * asks for them.
+ */
+static void sg_dbndx__check_typed_tables(SG_context* pCtx, SG_dbndx* pdbc)
+{
+	sqlite3_stmt* pStmt = NULL;
+	sqlite3_stmt* pStmt_update = NULL;
+    SG_int32 count = 0;
+    int rc = 0;
+
+    SG_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, pdbc->psql, &count, "SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='zrt_tables'")  );
+    if (count || pdbc->bQueryOnly)
+    {
+        pdbc->b_have_typed_tables = (count > 0);
+        return;
+    }
+
+    SG_ERR_CHECK(  sg_sqlite__exec__retry(pCtx, pdbc->psql, "BEGIN EXCLUSIVE TRANSACTION", MY_SLEEP_MS, MY_TIMEOUT_MS)  );
+	pdbc->bInTransaction = SG_TRUE;
+
+    // somebody else may have beaten us to it
+    SG_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, pdbc->psql, &count, "SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='zrt_tables'")  );
+    if (!count)
+    {
+        SG_ERR_CHECK(  sg_dbndx__create_typed_tables(pCtx, pdbc)  );
+
+        SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT p.hidrec, r.strvalue, p.name, p.strvalue, p.intvalue FROM db_pairs p, db_pairs r WHERE r.hidrec=p.hidrec AND r.name='%s'", SG_ZING_FIELD__RECTYPE)  );
+        while ((rc = sqlite3_step(pStmt)) == SQLITE_ROW)
+        {
+            const char* psz_hid = (const char*) sqlite3_column_text(pStmt, 0);
+            const char* psz_rectype = (const char*) sqlite3_column_text(pStmt, 1);
+            const char* psz_name = (const char*) sqlite3_column_text(pStmt, 2);
+            const char* psz_value = (const char*) sqlite3_column_text(pStmt, 3);
+            SG_vhash* pvh_table = NULL;
+            const char* psz_tbl = NULL;
+            SG_int64 col = 0;
+
+            SG_ERR_CHECK(  sg_dbndx__typed__get_table(pCtx, pdbc, psz_rectype, SG_TRUE, &pvh_table)  );
+            SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh_table, sg_DBNDX_TYPED__TBL, &psz_tbl)  );
+            SG_ERR_CHECK(  sg_dbndx__typed__get_column(pCtx, pdbc, psz_rectype, pvh_table, psz_name, NULL, &col)  );
+
+            SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "INSERT OR IGNORE INTO %s (hidrec) VALUES ('%s')", psz_tbl, psz_hid)  );
+            SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt_update, "UPDATE %s SET s%d=?, i%d=? WHERE hidrec=?", psz_tbl, (SG_int32) col, (SG_int32) col)  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt_update, 1, psz_value)  );
+            if (SQLITE_NULL == sqlite3_column_type(pStmt, 4))
+            {
+                SG_ERR_CHECK(  sg_sqlite__bind_null(pCtx, pStmt_update, 2)  );
+            }
+            else
+            {
+                SG_ERR_CHECK(  sg_sqlite__bind_int64(pCtx, pStmt_update, 2, sqlite3_column_int64(pStmt, 4))  );
+            }
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt_update, 3, psz_hid)  );
+            SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt_update, SQLITE_DONE)  );
+            SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt_update)  );
+            pStmt_update = NULL;
+        }
+        if (rc != SQLITE_DONE)
+        {
+            SG_ERR_THROW(SG_ERR_SQLITE(rc));
+        }
+        SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+        pStmt = NULL;
+    }
+
+    SG_ERR_CHECK(  sg_sqlite__exec__retry(pCtx, pdbc->psql, "COMMIT TRANSACTION", MY_SLEEP_MS, MY_TIMEOUT_MS)  );
+	pdbc->bInTransaction = SG_FALSE;
+
+    pdbc->b_have_typed_tables = SG_TRUE;
+
+fail:
+    if (pStmt_update)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt_update)  );
+    }
+    if (pStmt)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+    }
+	if (pdbc->bInTransaction)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pdbc->psql, "ROLLBACK TRANSACTION")  );
+        pdbc->bInTransaction = SG_FALSE;
+        SG_VHASH_NULLFREE(pCtx, pdbc->pvh_typed);
+        pdbc->b_have_typed_tables = SG_FALSE;
+    }
+}
+
+//////////////////////////////////////////////////////////////////
+// Snapshots.
+//
+// The record set of a state is only stored as a delta against its
+// baseline, so to get the record set of an arbitrary state we have to
+// start from some state whose record set we have and walk deltas.
+// Originally the only such state was cur_filter (the most recently
+// added state), which makes old states (and the far side of a branch)
+// very expensive on a DAG with a lot of states.
+//
+// So we also keep complete copies of the record set (snapshot_members)
+// for:
+//
+//     -- enough states that no state is more than
+//        sg_DBNDX_SNAPSHOT_INTERVAL baseline-steps from one.  We
+//        decide this when the state is added (when cur_filter is
+//        exactly its record set, so the copy is cheap).
+//
+//     -- the leaves other than the current state (these have leaf=1
+//        in snapshot_states and go away once they get a child).
+//
+// Each snapshot is a full copy of a record set, so without a limit
+// the storage grows with (records x states / interval).  We keep at
+// most sg_DBNDX_SNAPSHOT_MAX_KEPT interval snapshots and drop the
+// oldest when we need room.  The history a long-lived dbndx is most
+// likely to be asked about is recent, and a state which ends up out
+// of reach of every snapshot is still found by walking from
+// cur_filter, just more slowly.
+//
+// A dbndx created before snapshots existed still works; its older
+// states just fall back to walking from cur_filter.
+
+#define sg_DBNDX_SNAPSHOT_INTERVAL      64
+#define sg_DBNDX_SNAPSHOT_MAX_WALK      (4 * sg_DBNDX_SNAPSHOT_INTERVAL)
+#define sg_DBNDX_SNAPSHOT_MAX_KEPT      32
+
+#define sg_DBNDX_START__NONE            0   // nothing within reach
+#define sg_DBNDX_START__EMPTY           1   // the chain reaches the root, start with nothing
+#define sg_DBNDX_START__SNAPSHOT        2   // start with a snapshot
+#define sg_DBNDX_START__CUR             3   // start with cur_filter
+
+static void sg_dbndx__create_snapshot_tables(SG_context* pCtx, SG_dbndx* pdbc)
+{
+	SG_ERR_CHECK_RETURN(  sg_sqlite__exec(pCtx, pdbc->psql, "CREATE TABLE IF NOT EXISTS snapshot_states (csid VARCHAR PRIMARY KEY NOT NULL, generation INTEGER NOT NULL, leaf INTEGER NOT NULL)")  );
+	SG_ERR_CHECK_RETURN(  sg_sqlite__exec(pCtx, pdbc->psql, "CREATE TABLE IF NOT EXISTS snapshot_members (csid VARCHAR NOT NULL, hidrec VARCHAR NOT NULL, UNIQUE (csid, hidrec))")  );
+
+    pdbc->b_have_snapshots = SG_TRUE;
+}
+
+static void sg_dbndx__check_snapshot_tables(SG_context* pCtx, SG_dbndx* pdbc)
+{
+    SG_int32 count = 0;
+
+    if (pdbc->bQueryOnly)
+    {
+        // we can't create them, but an older dbndx may not have them.
+        SG_ERR_CHECK_RETURN(  sg_sqlite__exec__va__int32(pCtx, pdbc->psql, &count, "SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='snapshot_states'")  );
+        pdbc->b_have_snapshots = (count > 0);
+    }
+    else
+    {
+        SG_ERR_CHECK_RETURN(  sg_dbndx__create_snapshot_tables(pCtx, pdbc)  );
+    }
+}
+
+/**
+ * Walk back along the baseline chain from psz_csid looking for a
+ * state whose record set we already have.  On return, *pi_kind says
+ * what we found and *ppsa_chain contains the states whose deltas must
+ * be applied (in forward order) to get from there to psz_csid, newest
+ * first.  *ppsz_start is the snapshot csid for sg_DBNDX_START__SNAPSHOT.
+ *
+ * If b_for_interval is true, we are deciding whether psz_csid needs
+ * an interval snapshot, so we don't stop at cur_filter (which *is*
+ * psz_csid at that point) and we ignore leaf snapshots, which will
+ * go away.
+ */
+static void sg_dbndx__find_snapshot_start(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    const char* psz_csid,
+    SG_bool b_for_interval,
+    SG_uint32 max_steps,
+    SG_stringarray** ppsa_chain,
+    char** ppsz_start,
+    SG_uint32* pi_kind
+    )
+{
+	sqlite3_stmt* pStmt = NULL;
+    SG_stringarray* psa_chain = NULL;
+    char* psz_cur = NULL;
+    SG_uint32 kind = sg_DBNDX_START__NONE;
+    SG_uint32 steps = 0;
+    int rc = 0;
+
+    SG_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psa_chain, 16)  );
+    SG_ERR_CHECK(  SG_strdup(pCtx, psz_csid, &psz_cur)  );
+
+    SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pndx->psql, &pStmt, "SELECT s.baseline, (SELECT COUNT(*) FROM snapshot_states p WHERE p.csid=s.csid%s) FROM states s WHERE s.csid=?", b_for_interval ? " AND p.leaf=0" : "")  );
+
+    while (steps <= max_steps)
+    {
+        const char* psz_baseline = NULL;
+        SG_bool b_snapshot = SG_FALSE;
+
+        if (
+                !b_for_interval
+                && pndx->psz_cur_state_csid
+                && (0 == strcmp(psz_cur, pndx->psz_cur_state_csid))
            )
         {
-            SG_int64 intvalue = 0;
+            kind = sg_DBNDX_START__CUR;
+            break;
+        }
 
-            SG_ERR_CHECK(  SG_int64__parse__strict(pCtx, &intvalue, psz_value)  );
-            SG_ERR_CHECK(  sg_sqlite__bind_int64(pCtx, pStmt, 4, intvalue)  );
+        SG_ERR_CHECK(  sg_sqlite__reset(pCtx, pStmt)  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_cur)  );
+        rc = sqlite3_step(pStmt);
+        if (SQLITE_DONE == rc)
+        {
+            SG_ERR_THROW2(  SG_ERR_NOT_FOUND, (pCtx, "state %s", psz_cur)  );
         }
-        else if (
-                pzfa
-                && (pzfa->type == SG_ZING_TYPE__STRING)
-                && (pzfa->v._string.allowed)
-                )
+        else if (SQLITE_ROW != rc)
         {
-            SG_int64 ndx = 0;
+            SG_ERR_THROW(  SG_ERR_SQLITE(rc)  );
+        }
 
-            SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pzfa->v._string.allowed, psz_value, &ndx)  );
-            SG_ERR_CHECK(  sg_sqlite__bind_int64(pCtx, pStmt, 4, ndx)  );
+        b_snapshot = (sqlite3_column_int(pStmt, 1) > 0);
+        if (b_snapshot)
+        {
+            kind = sg_DBNDX_START__SNAPSHOT;
+            break;
         }
-        else
+
+        SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa_chain, psz_cur)  );
+        steps++;
+
+        psz_baseline = (const char*) sqlite3_column_text(pStmt, 0);
+        if (0 == strcmp(psz_baseline, "none"))
         {
-            SG_context__err_reset(pCtx);
-            SG_ERR_CHECK(  sg_sqlite__bind_null(pCtx, pStmt, 4)  );
+            kind = sg_DBNDX_START__EMPTY;
+            break;
+        }
+
+        SG_NULLFREE(pCtx, psz_cur);
+        SG_ERR_CHECK(  SG_strdup(pCtx, psz_baseline, &psz_cur)  );
+    }
+
+    *pi_kind = kind;
+    *ppsa_chain = psa_chain;
+    psa_chain = NULL;
+    if (sg_DBNDX_START__SNAPSHOT == kind)
+    {
+        *ppsz_start = psz_cur;
+        psz_cur = NULL;
+    }
+
+fail:
+    if (pStmt)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+    }
+    SG_STRINGARRAY_NULLFREE(pCtx, psa_chain);
+    SG_NULLFREE(pCtx, psz_cur);
+}
+
+/**
+ * Run a cached statement which takes a csid as its only parameter and
+ * returns one integer.  There must be a row.
+ */
+static void sg_dbndx__exec__int32__csid(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    const char* psz_sql,
+    const char* psz_csid,
+    SG_int32* pi_result
+    )
+{
+	sqlite3_stmt* pStmt = NULL;
+    int rc = 0;
+
+    SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pndx->psql, pndx->pStmtCache, &pStmt, psz_sql)  );
+    SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+    rc = sqlite3_step(pStmt);
+    if (SQLITE_DONE == rc)
+    {
+        SG_ERR_THROW2(  SG_ERR_NOT_FOUND, (pCtx, "state %s", psz_csid)  );
+    }
+    else if (SQLITE_ROW != rc)
+    {
+        SG_ERR_THROW(  SG_ERR_SQLITE(rc)  );
+    }
+    *pi_result = sqlite3_column_int(pStmt, 0);
+
+fail:
+    SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+}
+
+/**
+ * Delete a snapshot, if there is one.  With b_only_leaf, an interval
+ * snapshot is left alone.
+ */
+static void sg_dbndx__drop_snapshot(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    const char* psz_csid,
+    SG_bool b_only_leaf
+    )
+{
+	sqlite3_stmt* pStmt = NULL;
+    SG_uint32 count = 0;
+
+    SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pndx->psql, pndx->pStmtCache, &pStmt,
+                b_only_leaf
+                ? "DELETE FROM snapshot_states WHERE csid=? AND leaf=1"
+                : "DELETE FROM snapshot_states WHERE csid=?")  );
+    SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+    SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+    SG_ERR_CHECK(  sg_sqlite__num_changes(pCtx, pndx->psql, &count)  );
+    SG_ERR_CHECK(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+
+    if (count)
+    {
+        SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pndx->psql, pndx->pStmtCache, &pStmt, "DELETE FROM snapshot_members WHERE csid=?")  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+        SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+        SG_ERR_CHECK(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+    }
+
+fail:
+    SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+}
+
+/**
+ * If there are more than sg_DBNDX_SNAPSHOT_MAX_KEPT interval
+ * snapshots, drop the oldest ones.
+ */
+static void sg_dbndx__trim_snapshots(
+    SG_context* pCtx,
+    SG_dbndx* pndx
+    )
+{
+	sqlite3_stmt* pStmt = NULL;
+    SG_stringarray* psa_drop = NULL;
+    SG_uint32 count = 0;
+    SG_uint32 i = 0;
+    int rc = 0;
+
+    SG_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psa_drop, 4)  );
+
+    SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pndx->psql, pndx->pStmtCache, &pStmt, "SELECT csid FROM snapshot_states WHERE leaf=0 ORDER BY generation DESC LIMIT -1 OFFSET ?")  );
+    SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 1, sg_DBNDX_SNAPSHOT_MAX_KEPT)  );
+    while ((rc = sqlite3_step(pStmt)) == SQLITE_ROW)
+    {
+        SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa_drop, (const char*) sqlite3_column_text(pStmt, 0))  );
+    }
+    if (rc != SQLITE_DONE)
+    {
+        SG_ERR_THROW(  SG_ERR_SQLITE(rc)  );
+    }
+    SG_ERR_CHECK(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+
+    SG_ERR_CHECK(  SG_stringarray__count(pCtx, psa_drop, &count)  );
+    for (i=0; i<count; i++)
+    {
+        const char* psz_csid = NULL;
+
+        SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psa_drop, i, &psz_csid)  );
+        SG_ERR_CHECK(  sg_dbndx__drop_snapshot(pCtx, pndx, psz_csid, SG_FALSE)  );
+    }
+
+fail:
+    SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+    SG_STRINGARRAY_NULLFREE(pCtx, psa_drop);
+}
+
+/**
+ * Copy the record set in psz_table_from into the snapshot for psz_csid.
+ */
+static void sg_dbndx__add_snapshot(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    const char* psz_csid,
+    SG_int32 i_generation,
+    SG_bool b_leaf,
+    const char* psz_table_from
+    )
+{
+	sqlite3_stmt* pStmt = NULL;
+
+    // the source table is usually a temp table with a new name every
+    // time, so this one can't come from the statement cache.
+    SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pndx->psql, &pStmt, "INSERT OR IGNORE INTO snapshot_members (csid, hidrec) SELECT ?, hidrec FROM %s", psz_table_from)  );
+    SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+    SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+    SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+
+    SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pndx->psql, pndx->pStmtCache, &pStmt, "INSERT OR REPLACE INTO snapshot_states (csid, generation, leaf) VALUES (?, ?, ?)")  );
+    SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+    SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 2, i_generation)  );
+    SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 3, b_leaf ? 1 : 0)  );
+    SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+    SG_ERR_CHECK(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+
+    if (!b_leaf)
+    {
+        SG_ERR_CHECK(  sg_dbndx__trim_snapshots(pCtx, pndx)  );
+    }
+
+fail:
+    // only one of the two can be left here, and release finalizes a
+    // statement the cache doesn't know.
+    SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pndx->pStmtCache, &pStmt)  );
+}
+
+/**
+ * psz_csid just got a child, so if it had a snapshot only because it
+ * was a leaf, that snapshot is no longer needed.
+ */
+static void sg_dbndx__drop_leaf_snapshot(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    const char* psz_csid
+    )
+{
+    SG_ERR_CHECK_RETURN(  sg_dbndx__drop_snapshot(pCtx, pndx, psz_csid, SG_TRUE)  );
+}
+
+/**
+ * pChangeset is being added, so none of its parents are leaves any more.
+ */
+static void sg_dbndx__forget_parent_leaves(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    SG_changeset* pChangeset,
+    SG_vhash* pvh_leaves
+    )
+{
+    SG_varray* pva_parents = NULL;
+    SG_uint32 count = 0;
+    SG_uint32 i = 0;
+
+    SG_ERR_CHECK_RETURN(  SG_changeset__get_parents(pCtx, pChangeset, &pva_parents)  );
+    if (!pva_parents)
+    {
+        return;
+    }
+
+    SG_ERR_CHECK_RETURN(  SG_varray__count(pCtx, pva_parents, &count)  );
+    for (i=0; i<count; i++)
+    {
+        const char* psz_parent = NULL;
+        SG_bool b_has = SG_FALSE;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pva_parents, i, &psz_parent)  );
+        SG_ERR_CHECK_RETURN(  sg_dbndx__drop_leaf_snapshot(pCtx, pndx, psz_parent)  );
+        SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pvh_leaves, psz_parent, &b_has)  );
+        if (b_has)
+        {
+            SG_ERR_CHECK_RETURN(  SG_vhash__remove(pCtx, pvh_leaves, psz_parent)  );
+        }
+    }
+}
+
+/**
+ * Called right after psz_csid has become the current state (so
+ * cur_filter is exactly its record set).  Take a snapshot if it is too
+ * far from any other.  pvh_dist remembers the distance of each state
+ * added in this batch so that we only have to walk the chain once.
+ */
+static void sg_dbndx__maybe_add_interval_snapshot(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    const char* psz_csid,
+    SG_int32 i_generation,
+    const char* psz_baseline,
+    SG_vhash* pvh_dist
+    )
+{
+    SG_stringarray* psa_chain = NULL;
+    char* psz_start = NULL;
+    SG_uint32 kind = sg_DBNDX_START__NONE;
+    SG_int64 dist = 0;
+    SG_bool b_known = SG_FALSE;
+
+    if (psz_baseline)
+    {
+        SG_ERR_CHECK(  SG_vhash__has(pCtx, pvh_dist, psz_baseline, &b_known)  );
+    }
+
+    if (b_known)
+    {
+        SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh_dist, psz_baseline, &dist)  );
+        dist++;
+    }
+    else
+    {
+        SG_uint32 count = 0;
+
+        SG_ERR_CHECK(  sg_dbndx__find_snapshot_start(pCtx, pndx, psz_csid, SG_TRUE, sg_DBNDX_SNAPSHOT_INTERVAL, &psa_chain, &psz_start, &kind)  );
+        SG_ERR_CHECK(  SG_stringarray__count(pCtx, psa_chain, &count)  );
+        dist = (sg_DBNDX_START__NONE == kind) ? sg_DBNDX_SNAPSHOT_INTERVAL : count;
+    }
+
+    if (dist >= sg_DBNDX_SNAPSHOT_INTERVAL)
+    {
+        SG_ERR_CHECK(  sg_dbndx__add_snapshot(pCtx, pndx, psz_csid, i_generation, SG_FALSE, "cur_filter")  );
+        dist = 0;
+    }
+
+    SG_ERR_CHECK(  SG_vhash__update__int64(pCtx, pvh_dist, psz_csid, dist)  );
+
+fail:
+    SG_STRINGARRAY_NULLFREE(pCtx, psa_chain);
+    SG_NULLFREE(pCtx, psz_start);
+}
+
+/**
+ * Make sure every leaf in pvh_leaves other than the current state has
+ * a snapshot.
+ */
+static void sg_dbndx__add_leaf_snapshots(
+    SG_context* pCtx,
+    SG_dbndx* pndx,
+    SG_vhash* pvh_leaves
+    )
+{
+    SG_uint32 count = 0;
+    SG_uint32 i = 0;
+    char buf_table[sg_DBNDX_TEMPTABLE_NAME_BUF_LENGTH];
+    SG_bool b_temp = SG_FALSE;
+
+    buf_table[0] = 0;
+
+    SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_leaves, &count)  );
+    for (i=0; i<count; i++)
+    {
+        const char* psz_csid = NULL;
+        SG_int32 i_have = 0;
+        SG_int32 i_generation = 0;
+
+        SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_leaves, i, &psz_csid, NULL)  );
+        if (0 == strcmp(psz_csid, pndx->psz_cur_state_csid))
+        {
+            continue;
         }
 
-        SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
-	}
+        SG_ERR_CHECK(  sg_dbndx__exec__int32__csid(pCtx, pndx, "SELECT COUNT(*) FROM snapshot_states WHERE csid=?", psz_csid, &i_have)  );
+        if (i_have)
+        {
+            continue;
+        }
 
+        SG_ERR_CHECK(  sg_dbndx__exec__int32__csid(pCtx, pndx, "SELECT generation FROM states WHERE csid=?", psz_csid, &i_generation)  );
+        SG_ERR_CHECK(  sg_dbndx__get_state_table(pCtx, pndx, psz_csid, buf_table, sizeof(buf_table), &b_temp)  );
+        SG_ERR_CHECK(  sg_dbndx__add_snapshot(pCtx, pndx, psz_csid, i_generation, SG_TRUE, buf_table)  );
+        if (b_temp)
+        {
+            SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pndx->psql, "DROP TABLE %s", buf_table)  );
+            b_temp = SG_FALSE;
+        }
+    }
 
 fail:
-    ;
+    if (b_temp)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__exec__va(pCtx, pndx->psql, "DROP TABLE %s", buf_table)  );
+    }
 }
 
+//////////////////////////////////////////////////////////////////
+
 static void sg_dbndx__create_db(SG_context* pCtx, SG_dbndx* pdbc)
 {
 	SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pdbc->psql, "CREATE TABLE db_audits (csid VARCHAR NOT NULL UNIQUE, userid VARCHAR NOT NULL, timestamp INTEGER NOT NULL)")  );
@@ -614,6 +1552,9 @@ static void sg_dbndx__create_db(SG_context* pCtx, SG_dbndx* pdbc)
 
 	SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pdbc->psql, "CREATE TABLE cur_state (csid VARCHAR NOT NULL, generation INTEGER NOT NULL)")  );
 
+    SG_ERR_CHECK(  sg_dbndx__create_snapshot_tables(pCtx, pdbc)  );
+    SG_ERR_CHECK(  sg_dbndx__create_typed_tables(pCtx, pdbc)  );
+
 fail:
     ;
 }
@@ -1309,6 +2250,9 @@ void SG_dbndx__update__multiple(SG_context* pCtx, SG_dbndx* pdbc, SG_stringarray
     const char* psz_csid = NULL;
     const char* psz_hid_template = NULL;
 	sqlite3_stmt* pStmt_pairs = NULL;
+	sqlite3_stmt* pStmt = NULL;
+    SG_vhash* pvh_dist = NULL;
+    SG_vhash* pvh_leaves = NULL;
 
 	SG_NULLARGCHECK_RETURN(pdbc);
 	SG_ARGCHECK_RETURN( pdbc->pRepo!=NULL , pdbc );
@@ -1324,7 +2268,17 @@ void SG_dbndx__update__multiple(SG_context* pCtx, SG_dbndx* pdbc, SG_stringarray
     SG_ERR_CHECK(  sg_sqlite__exec__retry(pCtx, pdbc->psql, "BEGIN EXCLUSIVE TRANSACTION", MY_SLEEP_MS, MY_TIMEOUT_MS)  );
 	pdbc->bInTransaction = SG_TRUE;
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt_pairs, "INSERT OR IGNORE INTO db_pairs (hidrec, name, strvalue, intvalue) VALUES (?, ?, ?, ?)")  );
+    // The states we add here which are leaves when we're done (other
+    // than the one which ends up in cur_filter) need a snapshot.  The
+    // old current state counts too, since it doesn't have one.
+    SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_dist)  );
+    SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_leaves)  );
+    if (pdbc->psz_cur_state_csid)
+    {
+        SG_ERR_CHECK(  SG_vhash__update__null(pCtx, pvh_leaves, pdbc->psz_cur_state_csid)  );
+    }
+
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pdbc->psql, pdbc->pStmtCache, &pStmt_pairs, "INSERT OR IGNORE INTO db_pairs (hidrec, name, strvalue, intvalue) VALUES (?, ?, ?, ?)")  );
     for (ics=0; ics<count_changesets; ics++)
     {
         SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psa, ics, &psz_csid)  );
@@ -1342,6 +2296,8 @@ void SG_dbndx__update__multiple(SG_context* pCtx, SG_dbndx* pdbc, SG_stringarray
 
         SG_ERR_CHECK(  SG_changeset__get_generation(pCtx, pChangeset, &generation)  );
 
+        SG_ERR_CHECK(  sg_dbndx__forget_parent_leaves(pCtx, pdbc, pChangeset, pvh_leaves)  );
+
         SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, pvh_delta, "add", &pva_record_adds)  );
         SG_ERR_CHECK(  SG_varray__count(pCtx, pva_record_adds, &count_adds)  );
         for (i=0; i<count_adds; i++)
@@ -1349,9 +2305,15 @@ void SG_dbndx__update__multiple(SG_context* pCtx, SG_dbndx* pdbc, SG_stringarray
             const char* psz_hid_rec = NULL;
 
             SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pva_record_adds, i, &psz_hid_rec)  );
-            SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "INSERT INTO delta_adds (csid, hidrec) VALUES ('%s', '%s')", psz_csid, psz_hid_rec)  );
+            SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pdbc->psql, pdbc->pStmtCache, &pStmt, "INSERT INTO delta_adds (csid, hidrec) VALUES (?, ?)")  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2, psz_hid_rec)  );
+            SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+            SG_ERR_CHECK(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt)  );
+
             SG_ERR_CHECK(  SG_dbrecord__load_from_repo(pCtx, pdbc->pRepo, psz_hid_rec, &pRec)  );
             SG_ERR_CHECK(  sg_dbndx__add_record_to_pairs_table(pCtx, pRec, pzt, pStmt_pairs)  );
+            SG_ERR_CHECK(  sg_dbndx__add_record_to_typed_table(pCtx, pdbc, pRec, pzt)  );
             SG_ERR_CHECK(  sg_dbndx__add_record_to_history_table(pCtx, pdbc, pRec, psz_csid, generation)  );
             SG_DBRECORD_NULLFREE(pCtx, pRec);
         }
@@ -1363,20 +2325,33 @@ void SG_dbndx__update__multiple(SG_context* pCtx, SG_dbndx* pdbc, SG_stringarray
             const char* psz_hid_rec = NULL;
 
             SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pva_record_removes, i, &psz_hid_rec)  );
-            SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "INSERT INTO delta_removes (csid, hidrec) VALUES ('%s', '%s')", psz_csid, psz_hid_rec)  );
+            SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pdbc->psql, pdbc->pStmtCache, &pStmt, "INSERT INTO delta_removes (csid, hidrec) VALUES (?, ?)")  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 2, psz_hid_rec)  );
+            SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+            SG_ERR_CHECK(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt)  );
         }
 
-        SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "INSERT INTO states (csid, generation, baseline) VALUES ('%s', %d, '%s')", psz_csid, generation, psz_baseline ? psz_baseline : "none")  );
+        SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pdbc->psql, pdbc->pStmtCache, &pStmt, "INSERT INTO states (csid, generation, baseline) VALUES (?, ?, ?)")  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_csid)  );
+        SG_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 2, generation)  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 3, psz_baseline ? psz_baseline : "none")  );
+        SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+        SG_ERR_CHECK(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt)  );
 
         // TODO on a clone, it is inefficient to update the cur_state filter every time
         SG_ERR_CHECK(  sg_dbndx__update_cur_state(pCtx, pdbc, psz_csid, generation, psz_baseline)  );
 
+        SG_ERR_CHECK(  sg_dbndx__maybe_add_interval_snapshot(pCtx, pdbc, psz_csid, generation, psz_baseline, pvh_dist)  );
+        SG_ERR_CHECK(  SG_vhash__update__null(pCtx, pvh_leaves, psz_csid)  );
+
         SG_VHASH_NULLFREE(pCtx, pvh_delta);
         SG_CHANGESET_NULLFREE(pCtx, pChangeset);
     }
 
-	SG_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt_pairs)  );
-    pStmt_pairs = NULL;
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt_pairs)  );
+
+    SG_ERR_CHECK(  sg_dbndx__add_leaf_snapshots(pCtx, pdbc, pvh_leaves)  );
 
     SG_ERR_CHECK(  sg_sqlite__exec__retry(pCtx, pdbc->psql, "COMMIT TRANSACTION", MY_SLEEP_MS, MY_TIMEOUT_MS)  );
 	pdbc->bInTransaction = SG_FALSE;
@@ -1385,16 +2360,19 @@ fail:
     SG_DBRECORD_NULLFREE(pCtx, pRec);
     SG_VHASH_NULLFREE(pCtx, pvh_delta);
     SG_CHANGESET_NULLFREE(pCtx, pChangeset);
+    SG_VHASH_NULLFREE(pCtx, pvh_dist);
+    SG_VHASH_NULLFREE(pCtx, pvh_leaves);
 
-    if (pStmt_pairs)
-    {
-        SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt_pairs)  );
-    }
+    SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt_pairs)  );
+    SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pdbc->pStmtCache, &pStmt)  );
 
 	if (pdbc->bInTransaction)
     {
         SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pdbc->psql, "ROLLBACK TRANSACTION")  );
         pdbc->bInTransaction = SG_FALSE;
+
+        // any typed tables or columns we added are gone now
+        SG_VHASH_NULLFREE(pCtx, pdbc->pvh_typed);
     }
 }
 
@@ -1461,16 +2439,81 @@ fail:
     SG_VARRAY_NULLFREE(pCtx, pva);
 }
 
+/**
+ * Build a temp table containing the record set of psz_csid, starting
+ * from the nearest snapshot (or from cur_filter, if that's nearer).
+ * Returns false in *pb_built if there is nothing within reach.
+ */
+static void sg_dbndx__build_state_from_snapshot(
+        SG_context* pCtx,
+        SG_dbndx* pndx,
+        const char* psz_csid,
+        const char* psz_table,
+        SG_bool* pb_built
+        )
+{
+	sqlite3_stmt* pStmt = NULL;
+    SG_stringarray* psa_chain = NULL;
+    char* psz_start = NULL;
+    SG_uint32 kind = sg_DBNDX_START__NONE;
+    SG_uint32 count = 0;
+    SG_uint32 i = 0;
+
+    SG_ERR_CHECK(  sg_dbndx__find_snapshot_start(pCtx, pndx, psz_csid, SG_FALSE, sg_DBNDX_SNAPSHOT_MAX_WALK, &psa_chain, &psz_start, &kind)  );
+    if (sg_DBNDX_START__NONE == kind)
+    {
+        *pb_built = SG_FALSE;
+        goto fail;
+    }
+
+    SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pndx->psql, "CREATE TEMP TABLE %s (hidrec VARCHAR UNIQUE NOT NULL)", psz_table)  );
+    if (sg_DBNDX_START__SNAPSHOT == kind)
+    {
+        SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pndx->psql, &pStmt, "INSERT INTO %s SELECT hidrec FROM snapshot_members WHERE csid=?", psz_table)  );
+        SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, 1, psz_start)  );
+        SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+        SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+    }
+    else if (sg_DBNDX_START__CUR == kind)
+    {
+        SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pndx->psql, "INSERT INTO %s SELECT hidrec FROM cur_filter", psz_table)  );
+    }
+
+    // the chain is newest first
+    SG_ERR_CHECK(  SG_stringarray__count(pCtx, psa_chain, &count)  );
+    for (i=count; i>0; i--)
+    {
+        const char* psz_step = NULL;
+
+        SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psa_chain, i-1, &psz_step)  );
+        SG_ERR_CHECK(  sg_dbndx__apply_one_delta(pCtx, pndx->psql, (char*) psz_table, psz_step, SG_FALSE)  );
+    }
+
+    *pb_built = SG_TRUE;
+
+fail:
+    SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+    SG_STRINGARRAY_NULLFREE(pCtx, psa_chain);
+    SG_NULLFREE(pCtx, psz_start);
+}
+
+/**
+ * Get the name of a table containing the record set of psz_csid.  If
+ * *pb_temp_table comes back true, that's a temp table which belongs to
+ * the caller (it may modify or drop it).  Otherwise it is cur_filter.
+ */
 static void sg_dbndx__get_state_table(
         SG_context* pCtx,
         SG_dbndx* pndx,
         const char* psz_csid,
         char* buf_table,
-        SG_uint32 bufsize
+        SG_uint32 bufsize,
+        SG_bool* pb_temp_table
         )
 {
     SG_string* pstr = NULL;
     SG_varray* pva_path = NULL;
+    SG_bool b_built = SG_FALSE;
 
     SG_NULLARGCHECK_RETURN(psz_csid);
 
@@ -1479,12 +2522,21 @@ static void sg_dbndx__get_state_table(
         // no need to create the temp table
         // just return cur_state as the table name
         SG_ERR_CHECK(  SG_strcpy(pCtx, buf_table, bufsize, "cur_filter")  );
+        *pb_temp_table = SG_FALSE;
+        goto fail;
     }
-    else
+
+    SG_ERR_CHECK(  sg_dbndx__sql__get_temptable_name(pCtx, buf_table)  );
+
+    if (pndx->b_have_snapshots)
+    {
+        SG_ERR_CHECK(  sg_dbndx__build_state_from_snapshot(pCtx, pndx, psz_csid, buf_table, &b_built)  );
+    }
+
+    if (!b_built)
     {
         SG_int64 gen64 = -1;
 
-        SG_ERR_CHECK(  sg_dbndx__sql__get_temptable_name(pCtx, buf_table)  );
         SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pndx->psql, "CREATE TEMP TABLE %s (hidrec VARCHAR UNIQUE NOT NULL)", buf_table)  );
         SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pndx->psql, "INSERT INTO %s SELECT hidrec FROM cur_filter", buf_table)  );
         SG_ERR_CHECK(  sg_sqlite__exec__va__int64(pCtx, pndx->psql, &gen64, "SELECT generation FROM states WHERE csid='%s'", psz_csid)  );
@@ -1505,13 +2557,13 @@ static void sg_dbndx__get_state_table(
                     pva_path,
                     buf_table
                     )  );
-
     }
 
+    *pb_temp_table = SG_TRUE;
+
 fail:
     SG_VARRAY_NULLFREE(pCtx, pva_path);
     SG_STRING_NULLFREE(pCtx, pstr);
-    // TODO drop the temp table?
 }
 
 void SG_dbndx__query_across_states(SG_context* pCtx, SG_dbndx* pdbc, const SG_varray* pcrit, SG_int32 gMin, SG_int32 gMax, SG_vhash** ppResults)
@@ -1522,6 +2574,11 @@ void SG_dbndx__query_across_states(SG_context* pCtx, SG_dbndx* pdbc, const SG_va
 	SG_vhash* pvhResults = NULL;
     int rc;
     SG_vhash* pvhOne = NULL;
+	char szStateTable[sg_DBNDX_TEMPTABLE_NAME_BUF_LENGTH];
+    SG_bool b_state_table_is_temp = SG_FALSE;
+    char* psz_prev_csid = NULL;
+
+    szStateTable[0] = 0;
 
 	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhResults)  );
 
@@ -1540,20 +2597,20 @@ void SG_dbndx__query_across_states(SG_context* pCtx, SG_dbndx* pdbc, const SG_va
 	{
 		if (gMax >= 0)
 		{
-			SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation FROM states WHERE generation >= %d AND generation <= %d ORDER BY generation ASC", gMin, gMax)  );
+			SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation, baseline FROM states WHERE generation >= %d AND generation <= %d ORDER BY generation ASC", gMin, gMax)  );
 		}
 		else
 		{
-			SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation FROM states WHERE generation >= %d ORDER BY generation ASC", gMin)  );
+			SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation, baseline FROM states WHERE generation >= %d ORDER BY generation ASC", gMin)  );
 		}
 	}
 	else if (gMax >= 0)
 	{
-		SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation FROM states WHERE generation <= %d ORDER BY generation ASC", gMax)  );
+		SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation, baseline FROM states WHERE generation <= %d ORDER BY generation ASC", gMax)  );
 	}
 	else
 	{
-		SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation FROM states ORDER BY generation ASC")  );
+		SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "SELECT csid, generation, baseline FROM states ORDER BY generation ASC")  );
 	}
 
 	/* For each state, count the number of matching records which are members of that state */
@@ -1564,23 +2621,34 @@ void SG_dbndx__query_across_states(SG_context* pCtx, SG_dbndx* pdbc, const SG_va
 	{
 		const char* pszStateID = (const char*) sqlite3_column_text(pStmt, 0);
 		SG_int32 generation = (SG_int32)sqlite3_column_int(pStmt,1);
-		SG_uint32 count_results_this_state = 0;
-
-		char szFilteredResultsTableName[sg_DBNDX_TEMPTABLE_NAME_BUF_LENGTH];
-		char szStateTable[sg_DBNDX_TEMPTABLE_NAME_BUF_LENGTH];
+		const char* psz_baseline = (const char*) sqlite3_column_text(pStmt, 2);
+		SG_int32 count_results_this_state = 0;
 
-		SG_ERR_CHECK(  sg_dbndx__get_state_table(pCtx, pdbc, pszStateID, szStateTable, sizeof(szStateTable))  );
-
-		SG_ERR_CHECK(  sg_dbndx__sql__get_temptable_name(pCtx, szFilteredResultsTableName)  );
-
-        // TODO do we need to insert these into a temptable just to count them?
-
-		SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "CREATE TEMP TABLE %s (hidrec VARCHAR UNIQUE)", szFilteredResultsTableName)  );
-        /* TODO do we need an index on this WHERE? */
-
-		SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "INSERT OR IGNORE INTO %s SELECT r.hidrec FROM %s r,%s s WHERE r.hidrec=s.hidrec", szFilteredResultsTableName, szMatchesTableName, szStateTable)  );
+        // States come out in generation order, so very often this
+        // state is the child of the previous one.  In that case we
+        // just apply its delta to the table we already have instead
+        // of building a new one.
+        if (
+                b_state_table_is_temp
+                && psz_prev_csid
+                && (0 == strcmp(psz_baseline, psz_prev_csid))
+           )
+        {
+            SG_ERR_CHECK(  sg_dbndx__apply_one_delta(pCtx, pdbc->psql, szStateTable, pszStateID, SG_FALSE)  );
+        }
+        else
+        {
+            if (b_state_table_is_temp)
+            {
+                SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "DROP TABLE %s", szStateTable)  );
+                b_state_table_is_temp = SG_FALSE;
+            }
+            SG_ERR_CHECK(  sg_dbndx__get_state_table(pCtx, pdbc, pszStateID, szStateTable, sizeof(szStateTable), &b_state_table_is_temp)  );
+        }
+        SG_NULLFREE(pCtx, psz_prev_csid);
+        SG_ERR_CHECK(  SG_strdup(pCtx, pszStateID, &psz_prev_csid)  );
 
-		SG_ERR_CHECK(  sg_sqlite__num_changes(pCtx, pdbc->psql, &count_results_this_state)  );
+		SG_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, pdbc->psql, &count_results_this_state, "SELECT COUNT(*) FROM %s r,%s s WHERE r.hidrec=s.hidrec", szMatchesTableName, szStateTable)  );
 
 		SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhOne)  );
 
@@ -1609,6 +2677,7 @@ fail:
 	}
     SG_VHASH_NULLFREE(pCtx, pvhOne);
     SG_VHASH_NULLFREE(pCtx, pvhResults);
+    SG_NULLFREE(pCtx, psz_prev_csid);
 
     SG_ERR_IGNORE(  sg_sqlite__exec__retry(pCtx, pdbc->psql, "ROLLBACK TRANSACTION", MY_SLEEP_MS, MY_TIMEOUT_MS)  );
 	pdbc->bInTransaction = SG_FALSE;
@@ -1645,8 +2714,9 @@ static void sg_dbndx__do_state_filter(SG_context* pCtx, SG_dbndx* pndx, const ch
     char szFilteredResultsTableName[sg_DBNDX_TEMPTABLE_NAME_BUF_LENGTH];
     char szStartingStateTableName[sg_DBNDX_TEMPTABLE_NAME_BUF_LENGTH];
     SG_uint32 count = 0;
+    SG_bool b_temp = SG_FALSE;
 
-    SG_ERR_CHECK(  sg_dbndx__get_state_table(pCtx, pndx, pidState, szStartingStateTableName, sizeof(szStartingStateTableName))  );
+    SG_ERR_CHECK(  sg_dbndx__get_state_table(pCtx, pndx, pidState, szStartingStateTableName, sizeof(szStartingStateTableName), &b_temp)  );
     SG_ERR_CHECK(  sg_dbndx__sql__get_temptable_name(pCtx, szFilteredResultsTableName)  );
     SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pndx->psql, "CREATE TEMP TABLE %s (ordnum INTEGER PRIMARY KEY AUTOINCREMENT, hidrec VARCHAR UNIQUE)", szFilteredResultsTableName)  );
     // TODO we do we want a sort here to serve as the default?
@@ -1765,7 +2835,8 @@ static void sg_dbndx__do_where(SG_context* pCtx, sqlite3* psql, const SG_varray*
 			}
 			else
 			{
-				SG_ERR_THROW_RETURN(SG_ERR_INVALIDARG); // TODO invalid crit
+				SG_ERR_THROW2_RETURN(  SG_ERR_INVALID_DBCRITERIA,
+									   (pCtx, "%s == needs an integer or string value", psz_left)  );
 			}
 		}
 		else if (
@@ -1919,7 +2990,8 @@ static void sg_dbndx__do_where(SG_context* pCtx, sqlite3* psql, const SG_varray*
 		}
 		else
 		{
-			SG_ERR_THROW_RETURN(SG_ERR_INVALIDARG); // TODO invalid crit
+			SG_ERR_THROW2_RETURN(  SG_ERR_INVALID_DBCRITERIA,
+								   (pCtx, "unknown operator: %s", psz_op)  );
 		}
 	}
 
@@ -2063,6 +3135,376 @@ fail:
     SG_STRING_NULLFREE(pCtx, pstrSQL);
 }
 
+//////////////////////////////////////////////////////////////////
+// Compiling a query against a typed table.
+
+/**
+ * If pcrit contains (at the top level of a chain of &&) a clause
+ * which says rectype == something, return that rectype.  Otherwise
+ * *ppsz_rectype comes back NULL.
+ */
+static void sg_dbndx__typed__find_rectype(
+        SG_context* pCtx,
+        const SG_varray* pcrit,
+        const char** ppsz_rectype
+        )
+{
+    const char* psz_op = NULL;
+    SG_uint16 t = 0;
+
+    *ppsz_rectype = NULL;
+
+    SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pcrit, SG_CRIT_NDX_OP, &psz_op)  );
+    if (0 == strcmp("&&", psz_op))
+    {
+        SG_varray* pcrit_sub = NULL;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__get__varray(pCtx, pcrit, SG_CRIT_NDX_LEFT, &pcrit_sub)  );
+        SG_ERR_CHECK_RETURN(  sg_dbndx__typed__find_rectype(pCtx, pcrit_sub, ppsz_rectype)  );
+        if (!*ppsz_rectype)
+        {
+            SG_ERR_CHECK_RETURN(  SG_varray__get__varray(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &pcrit_sub)  );
+            SG_ERR_CHECK_RETURN(  sg_dbndx__typed__find_rectype(pCtx, pcrit_sub, ppsz_rectype)  );
+        }
+    }
+    else if (0 == strcmp("==", psz_op))
+    {
+        const char* psz_left = NULL;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pcrit, SG_CRIT_NDX_LEFT, &psz_left)  );
+        SG_ERR_CHECK_RETURN(  SG_varray__typeof(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &t)  );
+        if (
+                (SG_VARIANT_TYPE_SZ == t)
+                && (0 == strcmp(psz_left, SG_ZING_FIELD__RECTYPE))
+           )
+        {
+            SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pcrit, SG_CRIT_NDX_RIGHT, ppsz_rectype)  );
+        }
+    }
+}
+
+/**
+ * Translate a crit into a SQL expression over the columns of a typed
+ * table (aliased as t).  Values are not put in the SQL.  They are
+ * appended to pva_binds, in order, to be bound to the ? placeholders.
+ *
+ * The semantics match sg_dbndx__do_where():  a record which doesn't
+ * have the field never matches a clause on that field.
+ */
+static void sg_dbndx__typed__compile_where(
+        SG_context* pCtx,
+        SG_vhash* pvh_cols,
+        const SG_varray* pcrit,
+        SG_string* pstr,
+        SG_varray* pva_binds
+        )
+{
+    const char* psz_op = NULL;
+    const char* psz_left = NULL;
+    SG_bool b_has = SG_FALSE;
+    SG_int64 col = 0;
+
+    SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pcrit, SG_CRIT_NDX_OP, &psz_op)  );
+
+    if (
+            (0 == strcmp("&&", psz_op))
+            || (0 == strcmp("||", psz_op))
+       )
+    {
+        SG_varray* pcrit_left = NULL;
+        SG_varray* pcrit_right = NULL;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__get__varray(pCtx, pcrit, SG_CRIT_NDX_LEFT, &pcrit_left)  );
+        SG_ERR_CHECK_RETURN(  SG_varray__get__varray(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &pcrit_right)  );
+
+        SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "(")  );
+        SG_ERR_CHECK_RETURN(  sg_dbndx__typed__compile_where(pCtx, pvh_cols, pcrit_left, pstr, pva_binds)  );
+        SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, (0 == strcmp("&&", psz_op)) ? " AND " : " OR ")  );
+        SG_ERR_CHECK_RETURN(  sg_dbndx__typed__compile_where(pCtx, pvh_cols, pcrit_right, pstr, pva_binds)  );
+        SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, ")")  );
+        return;
+    }
+
+    SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pcrit, SG_CRIT_NDX_LEFT, &psz_left)  );
+    SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pvh_cols, psz_left, &b_has)  );
+    if (b_has)
+    {
+        SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvh_cols, psz_left, &col)  );
+    }
+
+    if (
+            (0 == strcmp("<", psz_op))
+            || (0 == strcmp(">", psz_op))
+            || (0 == strcmp("<=", psz_op))
+            || (0 == strcmp(">=", psz_op))
+            || (0 == strcmp("!=", psz_op))
+       )
+    {
+        SG_int64 intvalue = 0;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__get__int64(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &intvalue)  );
+        if (b_has)
+        {
+            SG_ERR_CHECK_RETURN(  SG_string__append__format(pCtx, pstr, "(t.i%d %s ?)", (SG_int32) col, psz_op)  );
+            SG_ERR_CHECK_RETURN(  SG_varray__append__int64(pCtx, pva_binds, intvalue)  );
+        }
+        else
+        {
+            SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "0")  );
+        }
+    }
+    else if (0 == strcmp("==", psz_op))
+    {
+        SG_uint16 t = 0;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__typeof(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &t)  );
+        if (SG_VARIANT_TYPE_INT64 == t)
+        {
+            SG_int64 intvalue = 0;
+
+            SG_ERR_CHECK_RETURN(  SG_varray__get__int64(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &intvalue)  );
+            if (b_has)
+            {
+                SG_ERR_CHECK_RETURN(  SG_string__append__format(pCtx, pstr, "(t.i%d = ?)", (SG_int32) col)  );
+                SG_ERR_CHECK_RETURN(  SG_varray__append__int64(pCtx, pva_binds, intvalue)  );
+            }
+            else
+            {
+                SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "0")  );
+            }
+        }
+        else if (SG_VARIANT_TYPE_SZ == t)
+        {
+            const char* psz_right = NULL;
+
+            SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &psz_right)  );
+            if (b_has)
+            {
+                SG_ERR_CHECK_RETURN(  SG_string__append__format(pCtx, pstr, "(t.s%d = ?)", (SG_int32) col)  );
+                SG_ERR_CHECK_RETURN(  SG_varray__append__string__sz(pCtx, pva_binds, psz_right)  );
+            }
+            else
+            {
+                SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "0")  );
+            }
+        }
+        else
+        {
+            SG_ERR_THROW2_RETURN(  SG_ERR_INVALID_DBCRITERIA,
+                                   (pCtx, "%s == needs an integer or string value", psz_left)  );
+        }
+    }
+    else if (0 == strcmp("in", psz_op))
+    {
+        SG_varray* pva_right = NULL;
+        SG_uint32 count = 0;
+        SG_uint32 i = 0;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__get__varray(pCtx, pcrit, SG_CRIT_NDX_RIGHT, &pva_right)  );
+        SG_ERR_CHECK_RETURN(  SG_varray__count(pCtx, pva_right, &count)  );
+        if (b_has && count)
+        {
+            SG_ERR_CHECK_RETURN(  SG_string__append__format(pCtx, pstr, "(t.s%d IN (", (SG_int32) col)  );
+            for (i=0; i<count; i++)
+            {
+                const char* psz_val = NULL;
+
+                SG_ERR_CHECK_RETURN(  SG_varray__get__sz(pCtx, pva_right, i, &psz_val)  );
+                SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, i ? ", ?" : "?")  );
+                SG_ERR_CHECK_RETURN(  SG_varray__append__string__sz(pCtx, pva_binds, psz_val)  );
+            }
+            SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "))")  );
+        }
+        else
+        {
+            SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "0")  );
+        }
+    }
+    else if (0 == strcmp("exists", psz_op))
+    {
+        if (b_has)
+        {
+            SG_ERR_CHECK_RETURN(  SG_string__append__format(pCtx, pstr, "(t.s%d IS NOT NULL)", (SG_int32) col)  );
+        }
+        else
+        {
+            SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "0")  );
+        }
+    }
+    else
+    {
+        SG_ERR_THROW2_RETURN(  SG_ERR_INVALID_DBCRITERIA,
+                               (pCtx, "unknown operator: %s", psz_op)  );
+    }
+}
+
+static void sg_dbndx__typed__compile_sort(
+        SG_context* pCtx,
+        SG_vhash* pvh_cols,
+        const SG_varray* pSort,
+        SG_string* pstr
+        )
+{
+    SG_uint32 levels = 0;
+    SG_uint32 i = 0;
+    SG_bool b_any = SG_FALSE;
+
+    SG_ERR_CHECK_RETURN(  SG_varray__count(pCtx, pSort, &levels)  );
+    for (i=0; i<levels; i++)
+    {
+        SG_vhash* pvh_key = NULL;
+        const char* psz_name = NULL;
+        const char* psz_direction = NULL;
+        const char* psz_sort_type = NULL;
+        SG_bool b_desc = SG_FALSE;
+        SG_bool b_numeric = SG_FALSE;
+        SG_bool b_has = SG_FALSE;
+
+        SG_ERR_CHECK_RETURN(  SG_varray__get__vhash(pCtx, pSort, i, &pvh_key)  );
+        SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvh_key, SG_DBNDX_SORT__NAME, &psz_name)  );
+        SG_ERR_CHECK_RETURN(  SG_vhash__check__sz(pCtx, pvh_key, SG_DBNDX_SORT__DIRECTION, &b_has, &psz_direction)  );
+        b_desc = (b_has && (0 == strcmp(psz_direction, "desc")));
+        SG_ERR_CHECK_RETURN(  SG_vhash__check__sz(pCtx, pvh_key, SG_DBNDX_SORT__TYPE, &b_has, &psz_sort_type)  );
+        b_numeric = (b_has && (0 == strcmp(psz_sort_type, "numeric")));
+
+        if (0 == strcmp(psz_name, "#WHEN"))
+        {
+            SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, b_any ? ", " : " ORDER BY ")  );
+            SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, "(SELECT a.timestamp FROM db_history h, db_audits a WHERE h.hidrec=t.hidrec AND h.csid=a.csid)")  );
+        }
+        else
+        {
+            SG_int64 col = 0;
+
+            SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pvh_cols, psz_name, &b_has)  );
+            if (!b_has)
+            {
+                // no record of this rectype has the field, so it can't
+                // affect the order
+                continue;
+            }
+            SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvh_cols, psz_name, &col)  );
+            SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, b_any ? ", " : " ORDER BY ")  );
+            SG_ERR_CHECK_RETURN(  SG_string__append__format(pCtx, pstr, "t.%s%d", b_numeric ? "i" : "s", (SG_int32) col)  );
+        }
+
+        SG_ERR_CHECK_RETURN(  SG_string__append__sz(pCtx, pstr, b_desc ? " DESC" : " ASC")  );
+        b_any = SG_TRUE;
+    }
+}
+
+/**
+ * Do the where, the state filter and the sort as one statement against
+ * the typed table for the rectype the query is limited to.  If the
+ * query can't be done that way, *pb_done comes back false and nothing
+ * has happened.
+ */
+static void sg_dbndx__typed__query(
+        SG_context* pCtx,
+        SG_dbndx* pdbc,
+        const char* pidState,
+        const SG_varray* pcrit,
+        const SG_varray* pSort,
+        char* pszResultsTableName,
+        SG_uint32* piCount,
+        SG_bool* pb_done
+        )
+{
+	sqlite3_stmt* pStmt = NULL;
+    SG_string* pstr = NULL;
+    SG_varray* pva_binds = NULL;
+    const char* psz_rectype = NULL;
+    SG_vhash* pvh_table = NULL;
+    SG_vhash* pvh_cols = NULL;
+    const char* psz_tbl = NULL;
+    char szStateTable[sg_DBNDX_TEMPTABLE_NAME_BUF_LENGTH];
+    SG_bool b_temp = SG_FALSE;
+    SG_uint32 count_binds = 0;
+    SG_uint32 i = 0;
+
+    *pb_done = SG_FALSE;
+
+    if (!pdbc->b_have_typed_tables || !pcrit)
+    {
+        return;
+    }
+
+    SG_ERR_CHECK(  sg_dbndx__typed__find_rectype(pCtx, pcrit, &psz_rectype)  );
+    if (!psz_rectype)
+    {
+        return;
+    }
+
+    SG_ERR_CHECK(  sg_dbndx__typed__get_table(pCtx, pdbc, psz_rectype, SG_FALSE, &pvh_table)  );
+    if (!pvh_table)
+    {
+        // no records of this rectype
+        *piCount = 0;
+        pszResultsTableName[0] = 0;
+        *pb_done = SG_TRUE;
+        return;
+    }
+    SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh_table, sg_DBNDX_TYPED__TBL, &psz_tbl)  );
+    SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh_table, sg_DBNDX_TYPED__COLS, &pvh_cols)  );
+
+    SG_ERR_CHECK(  sg_dbndx__sql__get_temptable_name(pCtx, pszResultsTableName)  );
+    SG_ERR_CHECK(  sg_sqlite__exec__va(pCtx, pdbc->psql, "CREATE TEMP TABLE %s (ordnum INTEGER PRIMARY KEY AUTOINCREMENT, hidrec VARCHAR UNIQUE)", pszResultsTableName)  );
+
+    SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
+    SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pva_binds)  );
+
+    if (pidState)
+    {
+        SG_ERR_CHECK(  sg_dbndx__get_state_table(pCtx, pdbc, pidState, szStateTable, sizeof(szStateTable), &b_temp)  );
+        SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstr, "INSERT INTO %s (hidrec) SELECT t.hidrec FROM %s t, %s s WHERE t.hidrec=s.hidrec AND ", pszResultsTableName, psz_tbl, szStateTable)  );
+    }
+    else
+    {
+        SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstr, "INSERT INTO %s (hidrec) SELECT t.hidrec FROM %s t WHERE ", pszResultsTableName, psz_tbl)  );
+    }
+
+    SG_ERR_CHECK(  sg_dbndx__typed__compile_where(pCtx, pvh_cols, pcrit, pstr, pva_binds)  );
+    if (pSort)
+    {
+        SG_ERR_CHECK(  sg_dbndx__typed__compile_sort(pCtx, pvh_cols, pSort, pstr)  );
+    }
+
+    SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pdbc->psql, &pStmt, "%s", SG_string__sz(pstr))  );
+    SG_ERR_CHECK(  SG_varray__count(pCtx, pva_binds, &count_binds)  );
+    for (i=0; i<count_binds; i++)
+    {
+        SG_uint16 t = 0;
+
+        SG_ERR_CHECK(  SG_varray__typeof(pCtx, pva_binds, i, &t)  );
+        if (SG_VARIANT_TYPE_INT64 == t)
+        {
+            SG_int64 v = 0;
+
+            SG_ERR_CHECK(  SG_varray__get__int64(pCtx, pva_binds, i, &v)  );
+            SG_ERR_CHECK(  sg_sqlite__bind_int64(pCtx, pStmt, i+1, v)  );
+        }
+        else
+        {
+            const char* psz_v = NULL;
+
+            SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pva_binds, i, &psz_v)  );
+            SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt, i+1, psz_v)  );
+        }
+    }
+    SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
+    SG_ERR_CHECK(  sg_sqlite__num_changes(pCtx, pdbc->psql, piCount)  );
+
+    *pb_done = SG_TRUE;
+
+fail:
+    if (pStmt)
+    {
+        SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+    }
+    SG_STRING_NULLFREE(pCtx, pstr);
+    SG_VARRAY_NULLFREE(pCtx, pva_binds);
+}
+
 void SG_dbndx__query(
 	SG_context* pCtx,
 	SG_dbndx** ppndx,
@@ -2081,6 +3523,7 @@ void SG_dbndx__query(
     SG_varray* pva_rechid_sliced = NULL;
     SG_dbndx* pdbc = NULL;
     SG_dbndx_qresult* pqr = NULL;
+    SG_bool b_typed = SG_FALSE;
 
 	SG_NULLARGCHECK_RETURN(ppndx);
 	SG_NULLARGCHECK_RETURN(*ppndx);
@@ -2093,6 +3536,22 @@ void SG_dbndx__query(
     SG_ERR_CHECK(  sg_sqlite__exec__retry(pCtx, pdbc->psql, "BEGIN TRANSACTION", MY_SLEEP_MS, MY_TIMEOUT_MS)  );
 	pdbc->bInTransaction = SG_TRUE;
 
+    SG_ERR_CHECK(  sg_dbndx__typed__query(pCtx, pdbc, pidState, pcrit, pSort, szResultsTableName, &count_filtered, &b_typed)  );
+    if (b_typed)
+    {
+        if (0 == count_filtered)
+        {
+            *ppqr = NULL;
+            return;
+        }
+
+        SG_ERR_CHECK(  sg_dbndx_qresult__alloc(pCtx, ppndx, szResultsTableName, psa_slice_fields, count_filtered, &pqr)  );
+
+        *ppqr = pqr;
+        pqr = NULL;
+        goto fail;
+    }
+
 	SG_ERR_CHECK(  sg_dbndx__do_where(pCtx, pdbc->psql, pcrit, szResultsTableName, &count_where)  );
 
 	if (
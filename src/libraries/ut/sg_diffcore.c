@@ -56,32 +56,81 @@ struct _sg_diff_t // semi-public (outside SG_diffcore treat as "void")
 };
 
 
+// There is one node for each distinct token (line) in all of the
+// datasources.  Positions point at nodes, so two positions hold equal
+// tokens iff they point at the same node.
 typedef struct __sg_diff__node _sg_diff__node_t;
 struct __sg_diff__node
 {
-    _sg_diff__node_t * pParent;
-    _sg_diff__node_t * pLeft;
-    _sg_diff__node_t * pRight;
+    _sg_diff__node_t * pNext; // next node in the same hash bucket
+    SG_uint32 hash;
 
     void * pToken;
 };
 
-void _sg_diff__node__nullfree(_sg_diff__node_t ** ppNode)
+
+// A hash table of the nodes.  We compare the hashes first and only
+// call token_compare when they match.  (This used to be an unbalanced
+// binary tree, which went quadratic on sorted or repetitive input.)
+struct __sg_diff__token_table
+{
+    _sg_diff__node_t ** ppBuckets;
+    SG_uint32 nrBuckets; // always a power of 2
+    SG_uint32 nrNodes;
+};
+typedef struct __sg_diff__token_table _sg_diff__token_table_t;
+
+#define _SG_DIFF__TOKEN_TABLE__INITIAL_BUCKETS 1024
+
+void _sg_diff__token_table__free(_sg_diff__token_table_t * pTable)
 {
-    if(ppNode==NULL||*ppNode==NULL)
+    SG_uint32 k;
+
+    if(pTable==NULL||pTable->ppBuckets==NULL)
         return;
-    _sg_diff__node__nullfree(&(*ppNode)->pLeft);
-    _sg_diff__node__nullfree(&(*ppNode)->pRight);
-    SG_free__no_ctx(*ppNode);
-    *ppNode = NULL;
-}
 
+    for(k=0; k<pTable->nrBuckets; k++)
+    {
+        _sg_diff__node_t * pNode = pTable->ppBuckets[k];
+        while(pNode!=NULL)
+        {
+            _sg_diff__node_t * pNext = pNode->pNext;
+            SG_free__no_ctx(pNode);
+            pNode = pNext;
+        }
+    }
+    SG_free__no_ctx(pTable->ppBuckets);
+    pTable->ppBuckets = NULL;
+    pTable->nrBuckets = 0;
+    pTable->nrNodes = 0;
+}
 
-struct __sg_diff__tree
+static void _sg_diff__token_table__grow(SG_context * pCtx, _sg_diff__token_table_t * pTable)
 {
-    _sg_diff__node_t * pRoot;
-};
-typedef struct __sg_diff__tree _sg_diff__tree_t;
+    _sg_diff__node_t ** ppNewBuckets = NULL;
+    SG_uint32 nrNewBuckets;
+    SG_uint32 k;
+
+    nrNewBuckets = (pTable->nrBuckets==0) ? _SG_DIFF__TOKEN_TABLE__INITIAL_BUCKETS : 2*pTable->nrBuckets;
+    SG_ERR_CHECK_RETURN(  SG_allocN(pCtx, nrNewBuckets, ppNewBuckets)  );
+
+    for(k=0; k<pTable->nrBuckets; k++)
+    {
+        _sg_diff__node_t * pNode = pTable->ppBuckets[k];
+        while(pNode!=NULL)
+        {
+            _sg_diff__node_t * pNext = pNode->pNext;
+            SG_uint32 ndx = pNode->hash & (nrNewBuckets-1);
+            pNode->pNext = ppNewBuckets[ndx];
+            ppNewBuckets[ndx] = pNode;
+            pNode = pNext;
+        }
+    }
+
+    SG_free__no_ctx(pTable->ppBuckets);
+    pTable->ppBuckets = ppNewBuckets;
+    pTable->nrBuckets = nrNewBuckets;
+}
 
 
 typedef struct __sg_diff__position _sg_diff__position_t;
@@ -171,60 +220,55 @@ struct __sg_diff__snake_t
 typedef struct __sg_diff__snake_t _sg_diff__snake_t;
 
 
-void _sg_diff__tree_insert_token(
+void _sg_diff__token_table_insert_token(
     SG_context * pCtx,
-    _sg_diff__tree_t * pTree,
+    _sg_diff__token_table_t * pTable,
     const SG_diff_functions * pVtable,
     void * pDiffBaton,
     void * pToken,
     _sg_diff__node_t ** ppResult)
 {
-    _sg_diff__node_t * pParent = NULL;
-    _sg_diff__node_t ** ppNode = NULL;
+    _sg_diff__node_t * pNode = NULL;
     _sg_diff__node_t * pNewNode = NULL;
+    SG_uint32 hash = 0;
+    SG_uint32 ndx;
 
     SG_ASSERT(pCtx!=NULL);
-    SG_NULLARGCHECK_RETURN(pTree);
+    SG_NULLARGCHECK_RETURN(pTable);
     SG_NULLARGCHECK_RETURN(pVtable);
     SG_NULLARGCHECK_RETURN(ppResult);
 
-    ppNode = &pTree->pRoot;
-    while(*ppNode!=NULL)
+    // Without a token_hash everything lands in one bucket.  That works,
+    // but it's a linear search, so every vtable should provide one.
+    if (pVtable->token_hash != NULL)
+        hash = pVtable->token_hash(pDiffBaton, pToken);
+
+    if (pTable->nrNodes >= pTable->nrBuckets)
+        SG_ERR_CHECK(  _sg_diff__token_table__grow(pCtx, pTable)  );
+
+    ndx = hash & (pTable->nrBuckets-1);
+    for (pNode = pTable->ppBuckets[ndx]; pNode != NULL; pNode = pNode->pNext)
     {
-        SG_int32 rv;
-        rv = pVtable->token_compare(pDiffBaton, (*ppNode)->pToken, pToken);
-        if (rv == 0)
+        if (pNode->hash == hash && pVtable->token_compare(pDiffBaton, pNode->pToken, pToken) == 0)
         {
             // Discard the token
             if (pVtable->token_discard != NULL)
                 pVtable->token_discard(pDiffBaton, pToken);
 
-            *ppResult = *ppNode;
+            *ppResult = pNode;
             return;
         }
-        else if (rv > 0)
-        {
-            pParent = *ppNode;
-            ppNode = &pParent->pLeft;
-        }
-        else
-        {
-            pParent = *ppNode;
-            ppNode = &pParent->pRight;
-        }
     }
 
     // Create a new node
-    {
-        SG_ERR_CHECK(  SG_alloc1(pCtx, pNewNode)  );
-        pNewNode->pParent = pParent;
-        pNewNode->pLeft = NULL;
-        pNewNode->pRight = NULL;
-        pNewNode->pToken = pToken;
+    SG_ERR_CHECK(  SG_alloc1(pCtx, pNewNode)  );
+    pNewNode->hash = hash;
+    pNewNode->pToken = pToken;
+    pNewNode->pNext = pTable->ppBuckets[ndx];
+    pTable->ppBuckets[ndx] = pNewNode;
+    pTable->nrNodes++;
 
-        *ppNode = pNewNode;
-        *ppResult = pNewNode;
-    }
+    *ppResult = pNewNode;
 
     return;
 fail:
@@ -234,7 +278,7 @@ fail:
 void _sg_diff__get_tokens(
     SG_context * pCtx,
     _sg_diff__mempool * pMempool,
-    _sg_diff__tree_t * pTree,
+    _sg_diff__token_table_t * pTable,
     const SG_diff_functions * pVtable,
     void * pDiffBaton,
     SG_diff_datasource datasource,
@@ -262,7 +306,7 @@ void _sg_diff__get_tokens(
             break;
 
         offset++;
-        SG_ERR_CHECK(  _sg_diff__tree_insert_token(pCtx, pTree, pVtable, pDiffBaton, pToken, &pNode)  );
+        SG_ERR_CHECK(  _sg_diff__token_table_insert_token(pCtx, pTable, pVtable, pDiffBaton, pToken, &pNode)  );
 
         // Create a new position
         SG_ERR_CHECK(  _sg_diff__position_t__alloc(pCtx, pMempool, &pPosition)  );
@@ -479,7 +523,7 @@ SG_bool _sg_diff__lcs_juggle(_sg_diff__lcs_t * pLcsHead)
 // 
 // The "Juggle" routine is original to the SourceGear version.
 // 
-// NOTE: Use position lists and tree to compute LCS using graph
+// NOTE: Use position lists and token table to compute LCS using graph
 // NOTE: algorithm described in the paper.
 // NOTE:
 // NOTE: This produces a "LCS list".  Where each "LCS" represents
@@ -617,6 +661,173 @@ fail:
     SG_NULLFREE(pCtx, fp0);
 }
 
+// When diffing big files that only changed in a few places, most of
+// the work in _sg_diff__lcs() is spent on the lines before the first
+// change and after the last one.  Those are trivially common, so we
+// peel them off first and only run the LCS on what's left in between,
+// then splice the prefix and suffix back on as LCS's of their own.
+//
+// We leave a few lines of the common prefix and suffix in the middle
+// so that the LCS has some context to line up a change that could
+// equally well be placed before or after a run of repeated lines
+// (otherwise trimming would change where such changes are reported).
+#define _SG_DIFF__CONTEXT_LINES_TO_KEEP 50
+
+void _sg_diff__lcs_trimmed(
+    SG_context * pCtx,
+    _sg_diff__mempool * pMempool,
+    _sg_diff__position_t * pPositionList1,
+    _sg_diff__position_t * pPositionList2,
+    _sg_diff__lcs_t ** ppResult)
+{
+    SG_int32 length[2];
+    SG_int32 lenPrefix = 0;
+    SG_int32 lenSuffix = 0;
+    SG_int32 k;
+    _sg_diff__position_t * pFirst[2];  // first position after the prefix
+    _sg_diff__position_t * pLast[2];   // last position before the suffix
+    _sg_diff__position_t * pSaved[2];
+    _sg_diff__lcs_t * pLcsMiddle = NULL;
+    _sg_diff__lcs_t * pLcsTail = NULL;
+    _sg_diff__lcs_t * pLcsBeforeTail = NULL;
+    _sg_diff__lcs_t * pLcsEof = NULL;
+    _sg_diff__lcs_t * pLcsPrefix = NULL;
+
+    SG_ASSERT(pCtx!=NULL);
+    SG_NULLARGCHECK_RETURN(ppResult);
+
+    if (pPositionList1 == NULL || pPositionList2 == NULL)
+    {
+        SG_ERR_CHECK_RETURN(  _sg_diff__lcs(pCtx, pMempool, pPositionList1, pPositionList2, ppResult)  );
+        return;
+    }
+
+    length[0] = pPositionList1->offset - pPositionList1->pNext->offset + 1;
+    length[1] = pPositionList2->offset - pPositionList2->pNext->offset + 1;
+
+    pFirst[0] = pPositionList1->pNext;
+    pFirst[1] = pPositionList2->pNext;
+    while (lenPrefix < length[0] && lenPrefix < length[1] && pFirst[0]->pNode == pFirst[1]->pNode)
+    {
+        pFirst[0] = pFirst[0]->pNext;
+        pFirst[1] = pFirst[1]->pNext;
+        lenPrefix++;
+    }
+
+    pLast[0] = pPositionList1;
+    pLast[1] = pPositionList2;
+    while (lenPrefix + lenSuffix < length[0] && lenPrefix + lenSuffix < length[1] && pLast[0]->pNode == pLast[1]->pNode)
+    {
+        pLast[0] = pLast[0]->pPrev;
+        pLast[1] = pLast[1]->pPrev;
+        lenSuffix++;
+    }
+
+    // give the lines of the prefix and suffix nearest the change back
+    // to the middle.
+    for (k = 0; k < _SG_DIFF__CONTEXT_LINES_TO_KEEP && lenPrefix > 0; k++)
+    {
+        pFirst[0] = pFirst[0]->pPrev;
+        pFirst[1] = pFirst[1]->pPrev;
+        lenPrefix--;
+    }
+    for (k = 0; k < _SG_DIFF__CONTEXT_LINES_TO_KEEP && lenSuffix > 0; k++)
+    {
+        pLast[0] = pLast[0]->pNext;
+        pLast[1] = pLast[1]->pNext;
+        lenSuffix--;
+    }
+
+    if (lenPrefix == 0 && lenSuffix == 0)
+    {
+        SG_ERR_CHECK_RETURN(  _sg_diff__lcs(pCtx, pMempool, pPositionList1, pPositionList2, ppResult)  );
+        return;
+    }
+
+    // The scans above stop before the prefix and suffix cover either
+    // side, and we have just given at least one line back, so the
+    // middle is never empty on either side.
+    SG_ASSERT(lenPrefix + lenSuffix < length[0] && lenPrefix + lenSuffix < length[1]);
+
+    // Run the LCS on the middle, closed up into a ring of its own
+    // (the same shape _sg_diff__get_tokens() gives us).
+    pSaved[0] = pLast[0]->pNext;
+    pSaved[1] = pLast[1]->pNext;
+    pLast[0]->pNext = pFirst[0];
+    pLast[1]->pNext = pFirst[1];
+
+    _sg_diff__lcs(pCtx, pMempool, pLast[0], pLast[1], &pLcsMiddle);
+
+    pLast[0]->pNext = pSaved[0];
+    pLast[1]->pNext = pSaved[1];
+    SG_ERR_CHECK_CURRENT;
+
+    // The middle's EOF marker sits where the suffix begins; turn it
+    // into the suffix LCS and put the real EOF marker after it.
+    if (lenSuffix > 0)
+    {
+        for (pLcsTail = pLcsMiddle; pLcsTail->pNext != NULL; pLcsTail = pLcsTail->pNext)
+        {
+            pLcsBeforeTail = pLcsTail;
+        }
+
+        pLcsTail->positions[0] = pLast[0]->pNext;
+        pLcsTail->positions[1] = pLast[1]->pNext;
+        pLcsTail->length = lenSuffix;
+
+        SG_ERR_CHECK(  _sg_diff__lcs_t__alloc(pCtx, pMempool, &pLcsEof)  );
+        SG_ERR_CHECK(  _sg_diff__position_t__alloc(pCtx, pMempool, &pLcsEof->positions[0])  );
+        pLcsEof->positions[0]->offset = pPositionList1->offset + 1;
+        SG_ERR_CHECK(  _sg_diff__position_t__alloc(pCtx, pMempool, &pLcsEof->positions[1])  );
+        pLcsEof->positions[1]->offset = pPositionList2->offset + 1;
+        pLcsEof->length = 0;
+        pLcsEof->pNext = NULL;
+
+        pLcsTail->pNext = pLcsEof;
+
+        // if the middle ended in common lines, they run straight on
+        // into the suffix; report them as one piece like _sg_diff__lcs() would.
+        if (pLcsBeforeTail
+            && (pLcsBeforeTail->positions[0]->offset + pLcsBeforeTail->length == pLcsTail->positions[0]->offset)
+            && (pLcsBeforeTail->positions[1]->offset + pLcsBeforeTail->length == pLcsTail->positions[1]->offset))
+        {
+            pLcsBeforeTail->length += pLcsTail->length;
+            pLcsBeforeTail->pNext = pLcsEof;
+        }
+    }
+
+    if (lenPrefix > 0)
+    {
+        SG_ERR_CHECK(  _sg_diff__lcs_t__alloc(pCtx, pMempool, &pLcsPrefix)  );
+        pLcsPrefix->positions[0] = pPositionList1->pNext;
+        pLcsPrefix->positions[1] = pPositionList2->pNext;
+        pLcsPrefix->length = lenPrefix;
+        pLcsPrefix->pNext = pLcsMiddle;
+
+        // likewise if the middle started with common lines.
+        if ((pLcsMiddle->length > 0)
+            && (pLcsMiddle->positions[0]->offset == pLcsPrefix->positions[0]->offset + lenPrefix)
+            && (pLcsMiddle->positions[1]->offset == pLcsPrefix->positions[1]->offset + lenPrefix))
+        {
+            pLcsPrefix->length += pLcsMiddle->length;
+            pLcsPrefix->pNext = pLcsMiddle->pNext;
+        }
+
+        pLcsMiddle = pLcsPrefix;
+    }
+
+    // the pieces may now line up with each other.
+    while(_sg_diff__lcs_juggle(pLcsMiddle))
+    {
+    }
+
+    *ppResult = pLcsMiddle;
+
+    return;
+fail:
+    ;
+}
+
 void _sg_diff__diff(SG_context * pCtx, _sg_diff__lcs_t *pLcs, SG_int32 originalStart, SG_int32 modifiedStart, SG_bool want_common, SG_diff_t ** ppResult)
 {
     // Morph a _sg_lcs_t into a _sg_diff_t.
@@ -1767,6 +1978,17 @@ void _sg_diff__file_load_fncmp(void * pDiffBaton)
 }
 
 
+static SG_bool _sg_diff__is_plain_ascii(const SG_byte * pBuf, SG_uint32 len)
+{
+    SG_uint32 k;
+
+    for (k=0; k<len; k++)
+        if (pBuf[k] == 0 || pBuf[k] >= 0x80)
+            return SG_FALSE;
+
+    return SG_TRUE;
+}
+
 static void _sg_diff__file_datasource_open(SG_context * pCtx, void * pDiffBaton, SG_diff_datasource datasource)
 {
     // Read raw file and convert from whatever encoding into utf-8.
@@ -1800,11 +2022,22 @@ static void _sg_diff__file_datasource_open(SG_context * pCtx, void * pDiffBaton,
         //todo: don't store the whole file in memory all at once
         if(finfo.size>SG_UINT32_MAX)
             SG_ERR_THROW2(SG_ERR_LIMIT_EXCEEDED, (pCtx, "File '%s' is too large to diff.", pFileDiffBaton->path));
-        SG_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)finfo.size, pFileContents)  );
+        SG_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)finfo.size+1, pFileContents)  );
         SG_ERR_CHECK(  SG_file__read(pCtx, pFile,(SG_uint32)finfo.size, pFileContents, NULL)  );
         SG_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
 
-        SG_ERR_CHECK(  SG_utf8__import_buffer(pCtx, pFileContents, (SG_uint32)finfo.size, &pFileDiffBaton->buffer[idx], NULL)  );
+        if (_sg_diff__is_plain_ascii(pFileContents, (SG_uint32)finfo.size))
+        {
+            // Plain 7-bit ASCII (no NULs) is already utf-8 and the import
+            // wouldn't change it, so skip the conversion and the copy.
+            pFileContents[finfo.size] = 0;
+            pFileDiffBaton->buffer[idx] = (char *)pFileContents;
+            pFileContents = NULL;
+        }
+        else
+        {
+            SG_ERR_CHECK(  SG_utf8__import_buffer(pCtx, pFileContents, (SG_uint32)finfo.size, &pFileDiffBaton->buffer[idx], NULL)  );
+        }
 
         pFileDiffBaton->curp[idx] = pFileDiffBaton->buffer[idx];
         pFileDiffBaton->endp[idx] = pFileDiffBaton->buffer[idx] + strlen(pFileDiffBaton->buffer[idx]);
@@ -1970,6 +2203,72 @@ int _sg_diff__file_token_ignorewhitespace_compare(void * pDiffBaton, void * pTok
     else
         return 1; // buf2 shorter
 }
+
+// The hashes must agree with the compare functions above: tokens that
+// compare equal must hash the same.  So when ignoring case we fold
+// ASCII letters, and hash any non-ASCII byte as the same value (in
+// case the platform's case-insensitive compare folds those too).
+
+#define _SG_DIFF__FNV_OFFSET 2166136261u
+#define _SG_DIFF__FNV_PRIME  16777619u
+
+static SG_uint32 _sg_diff__file_hash_byte(SG_uint32 hash, SG_bool bIgnoreCase, unsigned char b)
+{
+    if (bIgnoreCase)
+    {
+        if (b >= 'A' && b <= 'Z')
+            b = (unsigned char)(b - 'A' + 'a');
+        else if (b >= 0x80)
+            b = 0x80;
+    }
+    return (hash ^ b) * _SG_DIFF__FNV_PRIME;
+}
+
+SG_uint32 _sg_diff__file_token_hash(void * pDiffBaton, void * pToken)
+{
+    _sg_diff__file_baton_t * pFileDiffBaton = (_sg_diff__file_baton_t *)pDiffBaton;
+    _sg_diff__file_token_t * pFileToken = (_sg_diff__file_token_t *)pToken;
+    SG_bool bIgnoreCase = SG_HAS_SET(pFileDiffBaton->options, SG_DIFF_OPTION__IGNORE_CASE);
+    const unsigned char * p = (const unsigned char *)pFileToken->line;
+    const unsigned char * pEnd = p + pFileToken->length;
+    SG_uint32 hash = _SG_DIFF__FNV_OFFSET ^ (SG_uint32)pFileToken->length;
+
+    while (p < pEnd)
+        hash = _sg_diff__file_hash_byte(hash, bIgnoreCase, *p++);
+
+    return hash;
+}
+
+SG_uint32 _sg_diff__file_token_ignorewhitespace_hash(void * pDiffBaton, void * pToken)
+{
+    // Trailing whitespace is ignored and any other run of whitespace
+    // counts as a single space (see _sg_diff__file_token_ignorewhitespace_compare).
+    _sg_diff__file_baton_t * pFileDiffBaton = (_sg_diff__file_baton_t *)pDiffBaton;
+    _sg_diff__file_token_t * pFileToken = (_sg_diff__file_token_t *)pToken;
+    SG_bool bIgnoreCase = SG_HAS_SET(pFileDiffBaton->options, SG_DIFF_OPTION__IGNORE_CASE);
+    const char * p = pFileToken->line;
+    const char * pEnd = p + pFileToken->length;
+    SG_uint32 hash = _SG_DIFF__FNV_OFFSET;
+
+    while( (pEnd>p) && my_isspace(pEnd[-1]) )
+        pEnd--;
+
+    while (p < pEnd)
+    {
+        if (my_isspace(*p))
+        {
+            do{ p++; } while( (p<pEnd) && my_isspace(*p) );
+            hash = _sg_diff__file_hash_byte(hash, bIgnoreCase, ' ');
+        }
+        else
+        {
+            hash = _sg_diff__file_hash_byte(hash, bIgnoreCase, (unsigned char)*p++);
+        }
+    }
+
+    return hash;
+}
+
 static void _sg_diff__file_token_discard(void * pDiffBaton, void * pToken)
 {
     _sg_diff__file_baton_t * pFileDiffBaton = (_sg_diff__file_baton_t *)pDiffBaton;
@@ -2003,7 +2302,8 @@ static const SG_diff_functions _sg_diff__file_vtable = {
     _sg_diff__file_datasource_get_next_token,
     _sg_diff__file_token_compare,
     _sg_diff__file_token_discard,
-    _sg_diff__file_token_discard_all
+    _sg_diff__file_token_discard_all,
+    _sg_diff__file_token_hash
 };
 static const SG_diff_functions _sg_diff__file_ignorewhitespace_vtable = {
     _sg_diff__file_datasource_open,
@@ -2011,7 +2311,8 @@ static const SG_diff_functions _sg_diff__file_ignorewhitespace_vtable = {
     _sg_diff__file_datasource_get_next_token,
     _sg_diff__file_token_ignorewhitespace_compare,
     _sg_diff__file_token_discard,
-    _sg_diff__file_token_discard_all
+    _sg_diff__file_token_discard_all,
+    _sg_diff__file_token_ignorewhitespace_hash
 };
 const SG_diff_functions * _sg_diff__selectDiffFnsVTable(SG_diff_options eOptions)
 {
@@ -2028,7 +2329,7 @@ const SG_diff_functions * _sg_diff__selectDiffFnsVTable(SG_diff_options eOptions
 
 void SG_diff(SG_context * pCtx, const SG_diff_functions * pVtable, void * pDiffBaton, SG_diff_t ** ppDiff)
 {
-    _sg_diff__tree_t tree;
+    _sg_diff__token_table_t table;
     _sg_diff__mempool mempool;
     _sg_diff__position_t * positionLists[2] = {NULL, NULL};
     _sg_diff__lcs_t * pLcs = NULL;
@@ -2037,22 +2338,22 @@ void SG_diff(SG_context * pCtx, const SG_diff_functions * pVtable, void * pDiffB
     SG_NULLARGCHECK_RETURN(pVtable);
     SG_NULLARGCHECK_RETURN(ppDiff);
 
-    tree.pRoot = NULL;
+    SG_zero(table);
     SG_zero(mempool);
 
-    // Insert the data into the tree
-    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &tree, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__ORIGINAL, &positionLists[0])  );
-    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &tree, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__MODIFIED, &positionLists[1])  );
+    // Insert the data into the token table
+    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &table, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__ORIGINAL, &positionLists[0])  );
+    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &table, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__MODIFIED, &positionLists[1])  );
 
     // The cool part is that we don't need the tokens anymore.
     // Allow the app to clean them up if it wants to.
     if(pVtable->token_discard_all!=NULL)
         pVtable->token_discard_all(pDiffBaton);
 
-    _sg_diff__node__nullfree(&tree.pRoot);
+    _sg_diff__token_table__free(&table);
 
     // Get the lcs
-    SG_ERR_CHECK(  _sg_diff__lcs(pCtx, &mempool, positionLists[0], positionLists[1], &pLcs)  );
+    SG_ERR_CHECK(  _sg_diff__lcs_trimmed(pCtx, &mempool, positionLists[0], positionLists[1], &pLcs)  );
 
     // Produce the diff
     SG_ERR_CHECK(  _sg_diff__diff(pCtx, pLcs, 1, 1, SG_TRUE, ppDiff)  );
@@ -2061,13 +2362,13 @@ void SG_diff(SG_context * pCtx, const SG_diff_functions * pVtable, void * pDiffB
 
     return;
 fail:
-    _sg_diff__node__nullfree(&tree.pRoot);
+    _sg_diff__token_table__free(&table);
     _sg_diff__mempool__flush(&mempool);
 }
 
 void SG_diff3(SG_context * pCtx, const SG_diff_functions * pVtable, void * pDiffBaton, SG_diff_t ** ppDiff)
 {
-    _sg_diff__tree_t tree;
+    _sg_diff__token_table_t table;
     _sg_diff__mempool mempool;
     _sg_diff__position_t * positionLists[3] = {NULL, NULL, NULL};
     _sg_diff__lcs_t * pLcs_om = NULL;
@@ -2077,23 +2378,23 @@ void SG_diff3(SG_context * pCtx, const SG_diff_functions * pVtable, void * pDiff
     SG_NULLARGCHECK_RETURN(pVtable);
     SG_NULLARGCHECK_RETURN(ppDiff);
 
-    tree.pRoot = NULL;
+    SG_zero(table);
     SG_zero(mempool);
 
-    // Insert the data into the tree
-    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &tree, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__ORIGINAL, &positionLists[0])  );
-    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &tree, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__MODIFIED, &positionLists[1])  );
-    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &tree, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__LATEST, &positionLists[2])  );
+    // Insert the data into the token table
+    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &table, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__ORIGINAL, &positionLists[0])  );
+    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &table, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__MODIFIED, &positionLists[1])  );
+    SG_ERR_CHECK(  _sg_diff__get_tokens(pCtx, &mempool, &table, pVtable, pDiffBaton, SG_DIFF_DATASOURCE__LATEST, &positionLists[2])  );
 
     // Get rid of the tokens, we don't need them to calc the diff
     if(pVtable->token_discard_all!=NULL)
         pVtable->token_discard_all(pDiffBaton);
 
-    _sg_diff__node__nullfree(&tree.pRoot);
+    _sg_diff__token_table__free(&table);
 
     // Get the lcs for original-modified and original-latest
-    SG_ERR_CHECK(  _sg_diff__lcs(pCtx, &mempool, positionLists[0], positionLists[1], &pLcs_om)  );
-    SG_ERR_CHECK(  _sg_diff__lcs(pCtx, &mempool, positionLists[0], positionLists[2], &pLcs_ol)  );
+    SG_ERR_CHECK(  _sg_diff__lcs_trimmed(pCtx, &mempool, positionLists[0], positionLists[1], &pLcs_om)  );
+    SG_ERR_CHECK(  _sg_diff__lcs_trimmed(pCtx, &mempool, positionLists[0], positionLists[2], &pLcs_ol)  );
 
     // Produce a merged diff
     SG_ERR_CHECK(  _sg_diff3__diff3(pCtx, &mempool, pLcs_om, pLcs_ol, 1, 1, 1, positionLists, ppDiff)  );
@@ -2102,7 +2403,7 @@ void SG_diff3(SG_context * pCtx, const SG_diff_functions * pVtable, void * pDiff
 
     return;
 fail:
-    _sg_diff__node__nullfree(&tree.pRoot);
+    _sg_diff__token_table__free(&table);
     _sg_diff__mempool__flush(&mempool);
 }
 
@@ -0,0 +1,299 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_fetch_pool.c
+ *
+ * @details Write blobs into files on a pool of worker threads.
+ *
+ * This is a thin layer over SG_work_queue: the queue does the threads,
+ * the waiting and the error hand-off, and we keep a repo instance for
+ * each worker.  Items are not freed until the pool is, so the results
+ * (timestamps) can be read after SG_fetch_pool__finish().
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg.h>
+
+//////////////////////////////////////////////////////////////////
+
+#define MY_FETCH_POOL__MAX_THREADS		8
+
+typedef struct
+{
+	SG_uint32				iItem;
+	SG_pathname *			pPath;
+	SG_fsobj_perms			perms;
+	char *					pszHidBlob;
+	SG_fetch_pool_flags		flags;
+	SG_int64				attrBits;
+	char *					pszHidXattrs;
+
+	SG_int64				mtime_ms;
+	SG_int64				clock_ms;
+} sg_fetch_pool_item;
+
+struct _SG_fetch_pool
+{
+	SG_repo *				pRepo;
+	SG_work_queue *			pQueue;
+
+	SG_uint32				nrRepos;
+	SG_repo **				aRepos;				// one per worker; NULL when there are no workers
+
+	sg_fetch_pool_item **	aItems;				// only the caller's thread touches this array
+	SG_uint32				nrItemsSpace;
+	SG_uint32				nrItems;
+	SG_bool					bFinished;
+};
+
+//////////////////////////////////////////////////////////////////
+
+static void _sg_fetch_pool_item__free(SG_context * pCtx, sg_fetch_pool_item * pItem)
+{
+	if (!pItem)
+		return;
+
+	SG_PATHNAME_NULLFREE(pCtx, pItem->pPath);
+	SG_NULLFREE(pCtx, pItem->pszHidBlob);
+	SG_NULLFREE(pCtx, pItem->pszHidXattrs);
+	SG_NULLFREE(pCtx, pItem);
+}
+
+/**
+ * Create the file and write the blob into it, then do whatever else
+ * the item asked for.  This runs on a worker thread with the worker's
+ * own repo instance (or on the caller's thread if there are no workers).
+ */
+static void _sg_fetch_pool__do_item(SG_context * pCtx, SG_repo * pRepo, sg_fetch_pool_item * pItem)
+{
+	SG_file * pFile = NULL;
+#ifdef SG_BUILD_FLAG_FEATURE_XATTR
+	SG_vhash * pvhXattrs = NULL;
+#endif
+
+	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pItem->pPath, SG_FILE_WRONLY | SG_FILE_CREATE_NEW, pItem->perms, &pFile)  );
+	SG_ERR_CHECK(  SG_repo__fetch_blob_into_file(pCtx, pRepo, pItem->pszHidBlob, pFile, NULL)  );
+	SG_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+
+	if (pItem->flags & SG_FETCH_POOL_FLAGS__ATTRIBUTES)
+	{
+		if (pItem->pszHidXattrs)
+		{
+#ifdef SG_BUILD_FLAG_FEATURE_XATTR
+			SG_ERR_CHECK(  SG_repo__fetch_vhash(pCtx, pRepo, pItem->pszHidXattrs, &pvhXattrs)  );
+			SG_ERR_CHECK(  SG_attributes__xattrs__apply(pCtx, pItem->pPath, pvhXattrs, pRepo)  );
+#endif
+		}
+
+		SG_ERR_CHECK(  SG_attributes__bits__apply(pCtx, pItem->pPath, pItem->attrBits)  );
+	}
+
+	if (pItem->flags & SG_FETCH_POOL_FLAGS__TIMESTAMP)
+	{
+		SG_fsobj_stat st;
+
+		SG_ERR_CHECK(  SG_fsobj__stat__pathname(pCtx, pItem->pPath, &st)  );
+		SG_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &pItem->clock_ms)  );
+		pItem->mtime_ms = st.mtime_ms;
+	}
+
+	/* fall through */
+
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+#ifdef SG_BUILD_FLAG_FEATURE_XATTR
+	SG_VHASH_NULLFREE(pCtx, pvhXattrs);
+#endif
+}
+
+static SG_work_queue__callback _sg_fetch_pool__work_cb;
+
+static void _sg_fetch_pool__work_cb(SG_context * pCtx,
+									SG_uint32 kThread,
+									void * pVoidData,
+									void * pVoidItem)
+{
+	SG_fetch_pool * pPool = (SG_fetch_pool *)pVoidData;
+	sg_fetch_pool_item * pItem = (sg_fetch_pool_item *)pVoidItem;
+	SG_repo * pRepo = ((pPool->aRepos) ? pPool->aRepos[kThread] : pPool->pRepo);
+
+	SG_ERR_CHECK_RETURN(  _sg_fetch_pool__do_item(pCtx, pRepo, pItem)  );
+}
+
+//////////////////////////////////////////////////////////////////
+
+void SG_fetch_pool__alloc(SG_context * pCtx,
+						  SG_repo * pRepo,
+						  SG_fetch_pool ** ppNew)
+{
+	SG_fetch_pool * pPool = NULL;
+	SG_uint32 nrThreads = 0;
+	SG_uint32 k;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(ppNew);
+
+	SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pPool)  );
+	pPool->pRepo = pRepo;
+
+	SG_ERR_CHECK(  SG_work_queue__alloc(pCtx, MY_FETCH_POOL__MAX_THREADS, 0, SG_WORK_QUEUE_FLAGS__COLLECT,
+										_sg_fetch_pool__work_cb, (void *)pPool, &pPool->pQueue)  );
+	SG_ERR_CHECK(  SG_work_queue__get_thread_count(pCtx, pPool->pQueue, &nrThreads)  );
+	if (nrThreads > 0)
+	{
+		SG_ERR_CHECK(  SG_allocN(pCtx, nrThreads, pPool->aRepos)  );
+		pPool->nrRepos = nrThreads;
+		for (k=0; k<nrThreads; k++)
+			SG_ERR_CHECK(  SG_repo__open_repo_instance__copy(pCtx, pRepo, &pPool->aRepos[k])  );
+	}
+
+	*ppNew = pPool;
+	return;
+
+fail:
+	SG_FETCH_POOL_NULLFREE(pCtx, pPool);
+}
+
+void SG_fetch_pool__free(SG_context * pCtx, SG_fetch_pool * pPool)
+{
+	SG_uint32 k;
+
+	if (!pPool)
+		return;
+
+	// this abandons whatever is still queued.
+	SG_WORK_QUEUE_NULLFREE(pCtx, pPool->pQueue);
+
+	if (pPool->aRepos)
+	{
+		for (k=0; k<pPool->nrRepos; k++)
+			SG_REPO_NULLFREE(pCtx, pPool->aRepos[k]);
+		SG_NULLFREE(pCtx, pPool->aRepos);
+	}
+
+	if (pPool->aItems)
+	{
+		for (k=0; k<pPool->nrItems; k++)
+			_sg_fetch_pool_item__free(pCtx, pPool->aItems[k]);
+		SG_NULLFREE(pCtx, pPool->aItems);
+	}
+
+	SG_NULLFREE(pCtx, pPool);
+}
+
+void SG_fetch_pool__add(SG_context * pCtx,
+						SG_fetch_pool * pPool,
+						const SG_pathname * pPath,
+						SG_fsobj_perms perms,
+						const char * pszHidBlob,
+						SG_fetch_pool_flags flags,
+						SG_int64 attrBits,
+						const char * pszHidXattrs,
+						SG_uint32 * piItem)
+{
+	sg_fetch_pool_item * pItem = NULL;
+	sg_fetch_pool_item ** aGrown = NULL;
+	SG_uint32 iItem;
+
+	SG_NULLARGCHECK_RETURN(pPool);
+	SG_NULLARGCHECK_RETURN(pPath);
+	SG_NONEMPTYCHECK_RETURN(pszHidBlob);
+	SG_ARGCHECK_RETURN( !pPool->bFinished , pPool );
+
+	if (pPool->nrItems == pPool->nrItemsSpace)
+	{
+		SG_uint32 nrSpace = (pPool->nrItemsSpace ? 2 * pPool->nrItemsSpace : 256);
+
+		SG_ERR_CHECK(  SG_allocN(pCtx, nrSpace, aGrown)  );
+		if (pPool->aItems)
+			memcpy(aGrown, pPool->aItems, pPool->nrItems * sizeof(sg_fetch_pool_item *));
+		SG_NULLFREE(pCtx, pPool->aItems);
+		pPool->aItems = aGrown;
+		aGrown = NULL;
+		pPool->nrItemsSpace = nrSpace;
+	}
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pItem)  );
+	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pItem->pPath, pPath)  );
+	SG_ERR_CHECK(  SG_STRDUP(pCtx, pszHidBlob, &pItem->pszHidBlob)  );
+	if (pszHidXattrs && *pszHidXattrs)
+		SG_ERR_CHECK(  SG_STRDUP(pCtx, pszHidXattrs, &pItem->pszHidXattrs)  );
+	pItem->perms = perms;
+	pItem->flags = flags;
+	pItem->attrBits = attrBits;
+
+	// once it is in aItems, the pool owns it.  (the workers only see
+	// the item itself, never the array, so growing it is safe.)
+
+	iItem = pPool->nrItems;
+	pItem->iItem = iItem;
+	pPool->aItems[pPool->nrItems++] = pItem;
+
+	SG_ERR_CHECK_RETURN(  SG_work_queue__add(pCtx, pPool->pQueue, (void *)pItem)  );
+
+	if (piItem)
+		*piItem = iItem;
+	return;
+
+fail:
+	_sg_fetch_pool_item__free(pCtx, pItem);
+}
+
+void SG_fetch_pool__next_done(SG_context * pCtx,
+							  SG_fetch_pool * pPool,
+							  SG_uint32 * piItem,
+							  SG_bool * pbFound)
+{
+	sg_fetch_pool_item * pItem = NULL;
+
+	SG_NULLARGCHECK_RETURN(pPool);
+	SG_NULLARGCHECK_RETURN(piItem);
+	SG_NULLARGCHECK_RETURN(pbFound);
+
+	SG_ERR_CHECK_RETURN(  SG_work_queue__next_done(pCtx, pPool->pQueue, (void **)&pItem)  );
+
+	*pbFound = (pItem != NULL);
+	*piItem = ((pItem) ? pItem->iItem : 0);
+}
+
+void SG_fetch_pool__finish(SG_context * pCtx, SG_fetch_pool * pPool)
+{
+	SG_NULLARGCHECK_RETURN(pPool);
+
+	pPool->bFinished = SG_TRUE;
+	SG_ERR_CHECK_RETURN(  SG_work_queue__finish(pCtx, pPool->pQueue)  );
+}
+
+void SG_fetch_pool__get_timestamp(SG_context * pCtx,
+								  const SG_fetch_pool * pPool,
+								  SG_uint32 iItem,
+								  SG_int64 * pMTime_ms,
+								  SG_int64 * pClock_ms)
+{
+	SG_NULLARGCHECK_RETURN(pPool);
+	SG_ARGCHECK_RETURN( pPool->bFinished , pPool );
+	SG_ARGCHECK_RETURN( iItem < pPool->nrItems , iItem );
+	SG_ARGCHECK_RETURN( (pPool->aItems[iItem]->flags & SG_FETCH_POOL_FLAGS__TIMESTAMP) , iItem );
+
+	if (pMTime_ms)
+		*pMTime_ms = pPool->aItems[iItem]->mtime_ms;
+	if (pClock_ms)
+		*pClock_ms = pPool->aItems[iItem]->clock_ms;
+}
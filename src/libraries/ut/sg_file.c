@@ -20,6 +20,10 @@ limitations under the License.
 
 #include <sg.h>
 
+#if defined(MAC) || defined(LINUX)
+#include <sys/mman.h>
+#endif
+
 //////////////////////////////////////////////////////////////////
 
 struct _SG_file
@@ -102,6 +106,14 @@ void _sg_compute_posix_open_args(
 		SG_ARGCHECK_RETURN( SG_FALSE , flags_sg );
 	}
 
+	// don't let a child that another thread fork/exec's inherit this
+	// descriptor.  SG_exec dup2()'s the ones it wants the child to have
+	// and dup2() clears the flag on the copy.
+
+#if defined(O_CLOEXEC)
+	oflag |= O_CLOEXEC;
+#endif
+
 	// TODO Linux offers a O_LARGEFILE flag.
 	// TODO is it needed if we defined the
 	// TODO LFS args on the compile line?
@@ -138,6 +150,9 @@ void _sg_file_posix_open(SG_context* pCtx, const SG_pathname * pPathname, SG_fil
 	pf->m_fd = open(pBufOS,oflag,mode);
 	if (MY_IS_CLOSED(pf))
 		SG_ERR_THROW(SG_ERR_ERRNO(errno));
+#if !defined(O_CLOEXEC)
+	(void)fcntl(pf->m_fd, F_SETFD, FD_CLOEXEC);
+#endif
 
 	SG_NULLFREE(pCtx, pBufOS);
 
@@ -381,6 +396,69 @@ void SG_file__truncate(SG_context* pCtx, SG_file* pFile)
 #endif
 }
 
+void SG_file__preallocate(SG_context* pCtx, SG_file* pFile, SG_uint64 iLength)
+{
+	// reserve disk space for iLength bytes without changing the
+	// file size.  this is only a hint to the filesystem, so if it
+	// can't be done we silently carry on.
+
+	SG_NULLARGCHECK_RETURN(pFile);
+	SG_ARGCHECK_RETURN( !MY_IS_CLOSED(pFile) , pFile );
+
+	if (iLength == 0)
+		return;
+
+	SG_ASSERT(iLength <= 0x7fffffffffffffffULL);
+
+#if defined(LINUX)
+	(void) fallocate(pFile->m_fd, FALLOC_FL_KEEP_SIZE, (off_t)0, (off_t)iLength);
+#endif
+
+#if defined(MAC)
+	{
+		fstore_t fst;
+
+		fst.fst_flags = F_ALLOCATECONTIG;
+		fst.fst_posmode = F_PEOFPOSMODE;
+		fst.fst_offset = 0;
+		fst.fst_length = (off_t)iLength;
+		fst.fst_bytesalloc = 0;
+
+		if (fcntl(pFile->m_fd, F_PREALLOCATE, &fst) == -1)
+		{
+			// no contiguous run that big; take it in pieces.
+			fst.fst_flags = F_ALLOCATEALL;
+			(void) fcntl(pFile->m_fd, F_PREALLOCATE, &fst);
+		}
+	}
+#endif
+
+#if defined(WINDOWS)
+	{
+		// SetFileInformationByHandle() only exists on Vista and
+		// later, so look it up at run time rather than linking to it.
+		// FileAllocationInfo (5) sets the allocation size without
+		// changing the end-of-file.
+
+		typedef BOOL (WINAPI * FN_SetFileInformationByHandle)(HANDLE, int, LPVOID, DWORD);
+		typedef struct { LARGE_INTEGER AllocationSize; } MY_FILE_ALLOCATION_INFO;
+
+		FN_SetFileInformationByHandle pfn = NULL;
+		HMODULE hKernel32 = GetModuleHandleW(L"kernel32.dll");
+
+		if (hKernel32)
+			pfn = (FN_SetFileInformationByHandle)GetProcAddress(hKernel32, "SetFileInformationByHandle");
+		if (pfn)
+		{
+			MY_FILE_ALLOCATION_INFO fai;
+
+			fai.AllocationSize.QuadPart = (LONGLONG)iLength;
+			(void) (*pfn)(pFile->m_hFile, 5 /* FileAllocationInfo */, &fai, (DWORD)sizeof(fai));
+		}
+	}
+#endif
+}
+
 void SG_file__seek(SG_context* pCtx, SG_file* pFile, SG_uint64 iPos)
 {
 	// seek absolute from beginning
@@ -762,6 +840,127 @@ void SG_file__fsync(SG_context* pCtx, SG_file * pFile)
 
 //////////////////////////////////////////////////////////////////
 
+struct _SG_file_mapping
+{
+	void *			m_pBase;		// the page-aligned address returned by the OS
+#if defined(MAC) || defined(LINUX)
+	size_t			m_len;			// the length we asked the OS for
+#endif
+#if defined(WINDOWS)
+	HANDLE			m_hMapping;
+#endif
+};
+
+void SG_file__mmap(SG_context* pCtx, SG_file* pFile, SG_uint64 iOffset, SG_uint64 iLength, SG_file_mapping** ppMapping, const SG_byte** ppData)
+{
+	SG_file_mapping * pMapping = NULL;
+	SG_uint64 iOffsetAligned;
+	SG_uint64 iSlop;
+
+	SG_NULLARGCHECK_RETURN(pFile);
+	SG_ARGCHECK_RETURN( !MY_IS_CLOSED(pFile) , pFile );
+	SG_ARGCHECK_RETURN( (iLength > 0) , iLength );
+	SG_NULLARGCHECK_RETURN(ppMapping);
+	SG_NULLARGCHECK_RETURN(ppData);
+
+	// the OS wants the offset to be a multiple of the page size
+	// (or the allocation granularity on Windows), so we map a little
+	// extra at the front and hand back a pointer past it.
+
+#if defined(MAC) || defined(LINUX)
+	{
+		long page = sysconf(_SC_PAGESIZE);
+		void * p;
+
+		if (page <= 0)
+			page = 4096;
+
+		iSlop = iOffset % (SG_uint64)page;
+		iOffsetAligned = iOffset - iSlop;
+
+		if ((iLength + iSlop) > (SG_uint64)((size_t)-1))
+			SG_ERR_THROW2_RETURN(  SG_ERR_LIMIT_EXCEEDED, (pCtx, "File region too large to map")  );
+
+		SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pMapping)  );
+		pMapping->m_len = (size_t)(iLength + iSlop);
+
+		p = mmap(NULL, pMapping->m_len, PROT_READ, MAP_SHARED, pFile->m_fd, (off_t)iOffsetAligned);
+		if (p == MAP_FAILED)
+		{
+			int err = errno;
+			SG_NULLFREE(pCtx, pMapping);
+			SG_ERR_THROW_RETURN(  SG_ERR_ERRNO(err)  );
+		}
+		pMapping->m_pBase = p;
+	}
+#endif
+#if defined(WINDOWS)
+	{
+		SYSTEM_INFO si;
+		LARGE_INTEGER liMax;
+		LARGE_INTEGER liOffset;
+		DWORD err;
+
+		GetSystemInfo(&si);
+
+		iSlop = iOffset % (SG_uint64)si.dwAllocationGranularity;
+		iOffsetAligned = iOffset - iSlop;
+
+		if ((iLength + iSlop) > (SG_uint64)((SIZE_T)-1))
+			SG_ERR_THROW2_RETURN(  SG_ERR_LIMIT_EXCEEDED, (pCtx, "File region too large to map")  );
+
+		SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pMapping)  );
+
+		liMax.QuadPart = iOffset + iLength;
+		pMapping->m_hMapping = CreateFileMappingW(pFile->m_hFile, NULL, PAGE_READONLY, liMax.HighPart, liMax.LowPart, NULL);
+		if (pMapping->m_hMapping == NULL)
+		{
+			err = GetLastError();
+			SG_NULLFREE(pCtx, pMapping);
+			SG_ERR_THROW_RETURN(  SG_ERR_GETLASTERROR(err)  );
+		}
+
+		liOffset.QuadPart = iOffsetAligned;
+		pMapping->m_pBase = MapViewOfFile(pMapping->m_hMapping, FILE_MAP_READ, liOffset.HighPart, liOffset.LowPart, (SIZE_T)(iLength + iSlop));
+		if (pMapping->m_pBase == NULL)
+		{
+			err = GetLastError();
+			CloseHandle(pMapping->m_hMapping);
+			SG_NULLFREE(pCtx, pMapping);
+			SG_ERR_THROW_RETURN(  SG_ERR_GETLASTERROR(err)  );
+		}
+	}
+#endif
+
+	*ppData = ((const SG_byte *)pMapping->m_pBase) + iSlop;
+	*ppMapping = pMapping;
+}
+
+void SG_file__munmap(SG_context* pCtx, SG_file_mapping** ppMapping)
+{
+	SG_file_mapping * pMapping;
+
+	if (ppMapping==NULL || *ppMapping==NULL)
+		return;
+
+	pMapping = *ppMapping;
+
+#if defined(MAC) || defined(LINUX)
+	if (munmap(pMapping->m_pBase, pMapping->m_len) == -1)
+		SG_ERR_THROW_RETURN(  SG_ERR_ERRNO(errno)  );
+#endif
+#if defined(WINDOWS)
+	if (!UnmapViewOfFile(pMapping->m_pBase))
+		SG_ERR_THROW_RETURN(  SG_ERR_GETLASTERROR(GetLastError())  );
+	CloseHandle(pMapping->m_hMapping);
+#endif
+
+	SG_NULLFREE(pCtx, pMapping);
+	*ppMapping = NULL;
+}
+
+//////////////////////////////////////////////////////////////////
+
 #if defined(MAC) || defined(LINUX)
 void SG_file__get_fd(SG_context* pCtx, SG_file * pFile, int * pfd)
 {
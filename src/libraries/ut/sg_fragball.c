@@ -93,31 +93,51 @@ fail:
     SG_NULLFREE(pCtx, p);
 }
 
+/**
+ * Frame an object header which has already been converted to JSON:
+ * the 4-byte length, then the JSON with its trailing zero.  The caller
+ * owns the returned buffer.
+ */
+static void sg_fragball__frame_object_header(SG_context * pCtx, const char* psz_json, SG_byte** ppBuf, SG_uint32* pLen)
+{
+    SG_uint32 len = 0;
+    SG_byte* p = NULL;
+
+    len = (SG_uint32) strlen(psz_json);
+    len++;
+
+    SG_ERR_CHECK_RETURN(  SG_alloc(pCtx, 4 + len, 1, &p)  );
+    p[0] = (SG_byte) ( (len >> 24) & 0xff );
+    p[1] = (SG_byte) ( (len >> 16) & 0xff );
+    p[2] = (SG_byte) ( (len >>  8) & 0xff );
+    p[3] = (SG_byte) ( (len >>  0) & 0xff );
+    memcpy(p + 4, psz_json, len);
+
+    *ppBuf = p;
+    *pLen = 4 + len;
+}
+
 void sg_fragball__write_object_header(SG_context * pCtx, SG_file* pFile, SG_vhash* pvh)
 {
     SG_string* pstr = NULL;
+    SG_byte* p = NULL;
     SG_uint32 len = 0;
-    SG_byte ba_len[4];
 
     SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx,&pstr)  );
     SG_ERR_CHECK(  SG_vhash__to_json(pCtx, pvh, pstr)  );
-    len = SG_string__length_in_bytes(pstr);
-    len++;
-    ba_len[0] = (SG_byte) ( (len >> 24) & 0xff );
-    ba_len[1] = (SG_byte) ( (len >> 16) & 0xff );
-    ba_len[2] = (SG_byte) ( (len >>  8) & 0xff );
-    ba_len[3] = (SG_byte) ( (len >>  0) & 0xff );
-    SG_ERR_CHECK(  SG_file__write(pCtx, pFile, 4, ba_len, NULL)  );
-    SG_ERR_CHECK(  SG_file__write(pCtx, pFile, len, (SG_byte*) SG_string__sz(pstr), NULL)  );
+    SG_ERR_CHECK(  sg_fragball__frame_object_header(pCtx, SG_string__sz(pstr), &p, &len)  );
     SG_STRING_NULLFREE(pCtx, pstr);
+    SG_ERR_CHECK(  SG_file__write(pCtx, pFile, len, p, NULL)  );
+    SG_NULLFREE(pCtx, p);
 
     return;
 
 fail:
     SG_STRING_NULLFREE(pCtx, pstr);
+    SG_NULLFREE(pCtx, p);
 }
 
-void sg_fragball__write_version_header(SG_context * pCtx, SG_file* pFile)
+static void sg_fragball__alloc_version_header(SG_context * pCtx, SG_vhash** ppvh)
 {
     SG_vhash* pvh = NULL;
 
@@ -125,6 +145,19 @@ void sg_fragball__write_version_header(SG_context * pCtx, SG_file* pFile)
     SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "op", "version")  );
     SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "version", "1")  ); /* TODO verify this number? */
 
+    *ppvh = pvh;
+
+    return;
+
+fail:
+    SG_VHASH_NULLFREE(pCtx, pvh);
+}
+
+void sg_fragball__write_version_header(SG_context * pCtx, SG_file* pFile)
+{
+    SG_vhash* pvh = NULL;
+
+    SG_ERR_CHECK(  sg_fragball__alloc_version_header(pCtx, &pvh)  );
     SG_ERR_CHECK(  sg_fragball__write_object_header(pCtx, pFile, pvh)  );
     SG_VHASH_NULLFREE(pCtx, pvh);
 
@@ -134,7 +167,7 @@ fail:
     SG_VHASH_NULLFREE(pCtx, pvh);
 }
 
-void sg_fragball__write_frag(SG_context * pCtx, SG_file* pFile, SG_dagfrag* pFrag)
+static void sg_fragball__alloc_frag_header(SG_context * pCtx, SG_dagfrag* pFrag, SG_vhash** ppvh)
 {
     SG_vhash* pvh = NULL;
     SG_vhash* pvh_frag = NULL;
@@ -145,16 +178,58 @@ void sg_fragball__write_frag(SG_context * pCtx, SG_file* pFile, SG_dagfrag* pFra
     SG_ERR_CHECK(  SG_dagfrag__to_vhash__shared(pCtx, pFrag, pvh, &pvh_frag)  );
     SG_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pvh, "frag", &pvh_frag)  );
 
+    *ppvh = pvh;
+
+    return;
+
+fail:
+    SG_VHASH_NULLFREE(pCtx, pvh_frag);
+    SG_VHASH_NULLFREE(pCtx, pvh);
+}
+
+void sg_fragball__write_frag(SG_context * pCtx, SG_file* pFile, SG_dagfrag* pFrag)
+{
+    SG_vhash* pvh = NULL;
+
+    SG_ERR_CHECK(  sg_fragball__alloc_frag_header(pCtx, pFrag, &pvh)  );
     SG_ERR_CHECK(  sg_fragball__write_object_header(pCtx, pFile, pvh)  );
     SG_VHASH_NULLFREE(pCtx, pvh);
 
     return;
 
 fail:
-    SG_VHASH_NULLFREE(pCtx, pvh_frag);
     SG_VHASH_NULLFREE(pCtx, pvh);
 }
 
+static void sg_fragball__alloc_blob_header(
+	SG_context* pCtx,
+	const char* psz_objectid,
+	const char* pszHid,
+	SG_blob_encoding encoding,
+	const char* pszHidVcdiffRef,
+	SG_uint64 lenEncoded,
+	SG_uint64 lenFull,
+	SG_vhash** ppvh)
+{
+	SG_vhash* pvh = NULL;
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh)  );
+	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "op", "blob")  );
+	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "hid", pszHid)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "encoding", (SG_int64) encoding)  ); /* TODO enum string */
+	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "vcdiff_ref", pszHidVcdiffRef)  );
+	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "objectid", psz_objectid)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "len_encoded", (SG_int64) lenEncoded)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "len_full", (SG_int64) lenFull)  );
+
+	*ppvh = pvh;
+
+	return;
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvh);
+}
+
 void SG_fragball__append_blob__from_handle(
 	SG_context* pCtx,
 	SG_fragball_writer* pWriter,
@@ -177,15 +252,7 @@ void SG_fragball__append_blob__from_handle(
 	pBlob = *ppBlob;
 
 	/* write the header */
-	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh)  );
-	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "op", "blob")  );
-	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "hid", pszHid)  );
-	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "encoding", (SG_int64) encoding)  ); /* TODO enum string */
-	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "vcdiff_ref", pszHidVcdiffRef)  );
-	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvh, "objectid", psz_objectid)  );
-	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "len_encoded", (SG_int64) lenEncoded)  );
-	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "len_full", (SG_int64) lenFull)  );
-
+	SG_ERR_CHECK(  sg_fragball__alloc_blob_header(pCtx, psz_objectid, pszHid, encoding, pszHidVcdiffRef, lenEncoded, lenFull, &pvh)  );
 	SG_ERR_CHECK(  sg_fragball__write_object_header(pCtx, pWriter->pFile, pvh)  );
 	SG_VHASH_NULLFREE(pCtx, pvh);
 
@@ -194,13 +261,14 @@ void SG_fragball__append_blob__from_handle(
 	{
 		SG_uint32 want = pWriter->buf_size;
 		SG_uint32 got = 0;
+		const SG_byte* p_span = NULL;
 
 		if (want > left)
 		{
 			want = (SG_uint32) left;
 		}
-		SG_ERR_CHECK(  SG_repo__fetch_blob__chunk(pCtx, pWriter->pRepo, pBlob, want, pWriter->buf, &got, &b_done)  );
-		SG_ERR_CHECK(  SG_file__write(pCtx, pWriter->pFile, got, pWriter->buf, NULL)  );
+		SG_ERR_CHECK(  SG_repo__fetch_blob__chunk__span(pCtx, pWriter->pRepo, pBlob, want, pWriter->buf, &p_span, &got, &b_done)  );
+		SG_ERR_CHECK(  SG_file__write(pCtx, pWriter->pFile, got, p_span, NULL)  );
 
 		left -= got;
 	}
@@ -583,3 +651,365 @@ void SG_fragball__free(SG_context* pCtx, SG_pathname* pPath_fragball)
 		SG_PATHNAME_NULLFREE(pCtx, pPath_fragball);
 	}
 }
+
+//////////////////////////////////////////////////////////////////
+
+/*
+ * A fragball stream produces exactly the bytes of a fragball file,
+ * but on demand, so the fragball never has to exist anywhere in
+ * its entirety.  Frags are small, so they are converted to JSON
+ * when they are added.  Blobs are only recorded by HID.  Each blob
+ * header is generated when the reader gets to it, and the payload
+ * is pulled from the repo one chunk at a time.
+ *
+ * We ask the repo for the info of each blob when it is added, so
+ * the total length is known before the first byte is read.  (An
+ * http POST wants the content length up front.)
+ *
+ * All the frags are sent before any of the blobs.
+ */
+
+struct _sg_fragball_stream
+{
+	SG_repo* pRepo;
+
+	SG_varray* pva_headers;          /* JSON of the version header and each frag */
+	SG_stringarray* psa_blobs;       /* blob HIDs, in the order they will be sent */
+	SG_vector_i64* pvec_blob_lengths; /* length of each blob object, header included */
+	SG_uint64 len_total;
+
+	/* read state */
+	SG_bool b_started;
+	SG_uint32 ndx_next_header;
+	SG_uint32 ndx_next_blob;
+
+	SG_byte* p_cur;                  /* the framed header we are in the middle of */
+	SG_uint32 len_cur;
+	SG_uint32 pos_cur;
+
+	SG_repo_fetch_blob_handle* pBlob;
+	SG_uint64 left_blob;
+
+	SG_uint64 len_sent;
+};
+
+static void sg_fragball_stream__add_header(SG_context * pCtx, SG_fragball_stream* pfs, SG_vhash* pvh)
+{
+	SG_string* pstr = NULL;
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
+	SG_ERR_CHECK(  SG_vhash__to_json(pCtx, pvh, pstr)  );
+	SG_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pfs->pva_headers, SG_string__sz(pstr))  );
+	pfs->len_total += 4 + SG_string__length_in_bytes(pstr) + 1;
+
+	/* fall through */
+fail:
+	SG_STRING_NULLFREE(pCtx, pstr);
+}
+
+void SG_fragball_stream__alloc(SG_context * pCtx, SG_repo* pRepo, SG_fragball_stream** ppNew)
+{
+	SG_fragball_stream* pfs = NULL;
+	SG_vhash* pvh = NULL;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(ppNew);
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pfs)  );
+	pfs->pRepo = pRepo;
+	SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pfs->pva_headers)  );
+	SG_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &pfs->psa_blobs, 100)  );
+	SG_ERR_CHECK(  SG_vector_i64__alloc(pCtx, &pfs->pvec_blob_lengths, 100)  );
+
+	SG_ERR_CHECK(  sg_fragball__alloc_version_header(pCtx, &pvh)  );
+	SG_ERR_CHECK(  sg_fragball_stream__add_header(pCtx, pfs, pvh)  );
+	SG_VHASH_NULLFREE(pCtx, pvh);
+
+	*ppNew = pfs;
+
+	return;
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvh);
+	SG_ERR_IGNORE(  SG_fragball_stream__free(pCtx, pfs)  );
+}
+
+void SG_fragball_stream__free(SG_context * pCtx, SG_fragball_stream* pfs)
+{
+	if (!pfs)
+		return;
+
+	if (pfs->pBlob)
+		SG_ERR_IGNORE(  SG_repo__fetch_blob__abort(pCtx, pfs->pRepo, &pfs->pBlob)  );
+
+	SG_NULLFREE(pCtx, pfs->p_cur);
+	SG_VARRAY_NULLFREE(pCtx, pfs->pva_headers);
+	SG_STRINGARRAY_NULLFREE(pCtx, pfs->psa_blobs);
+	SG_VECTOR_I64_NULLFREE(pCtx, pfs->pvec_blob_lengths);
+	SG_NULLFREE(pCtx, pfs);
+}
+
+void SG_fragball_stream__add_frag(SG_context * pCtx, SG_fragball_stream* pfs, SG_dagfrag* pFrag)
+{
+	SG_vhash* pvh = NULL;
+
+	SG_NULLARGCHECK_RETURN(pfs);
+	SG_NULLARGCHECK_RETURN(pFrag);
+	SG_ARGCHECK_RETURN(!pfs->b_started, pfs);
+
+	SG_ERR_CHECK(  sg_fragball__alloc_frag_header(pCtx, pFrag, &pvh)  );
+	SG_ERR_CHECK(  sg_fragball_stream__add_header(pCtx, pfs, pvh)  );
+
+	/* fall through */
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvh);
+}
+
+void SG_fragball_stream__add_dagnodes(SG_context * pCtx, SG_fragball_stream* pfs, SG_uint32 iDagNum, SG_rbtree* prb_ids)
+{
+	SG_dagfrag* pFrag = NULL;
+	char* psz_repo_id = NULL;
+	char* psz_admin_id = NULL;
+
+	SG_NULLARGCHECK_RETURN(pfs);
+
+	SG_ERR_CHECK(  SG_repo__get_repo_id(pCtx, pfs->pRepo, &psz_repo_id)  );
+	SG_ERR_CHECK(  SG_repo__get_admin_id(pCtx, pfs->pRepo, &psz_admin_id)  );
+
+	SG_ERR_CHECK(  SG_dagfrag__alloc(pCtx, &pFrag, psz_repo_id, psz_admin_id, iDagNum)  );
+	SG_ERR_CHECK(  SG_dagfrag__load_from_repo__simple(pCtx, pFrag, pfs->pRepo, prb_ids)  );
+
+	SG_ERR_CHECK(  SG_fragball_stream__add_frag(pCtx, pfs, pFrag)  );
+
+	/* fall through */
+fail:
+	SG_NULLFREE(pCtx, psz_repo_id);
+	SG_NULLFREE(pCtx, psz_admin_id);
+	SG_DAGFRAG_NULLFREE(pCtx, pFrag);
+}
+
+/**
+ * The length of a blob object: its framed header plus the encoded payload.
+ */
+static void sg_fragball__blob_object_length(
+	SG_context* pCtx,
+	const char* psz_objectid,
+	const char* pszHid,
+	SG_blob_encoding encoding,
+	const char* pszHidVcdiffRef,
+	SG_uint64 lenEncoded,
+	SG_uint64 lenFull,
+	SG_uint64* pLen)
+{
+	SG_vhash* pvh = NULL;
+	SG_string* pstr = NULL;
+
+	SG_ERR_CHECK(  sg_fragball__alloc_blob_header(pCtx, psz_objectid, pszHid, encoding, pszHidVcdiffRef, lenEncoded, lenFull, &pvh)  );
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
+	SG_ERR_CHECK(  SG_vhash__to_json(pCtx, pvh, pstr)  );
+
+	*pLen = 4 + SG_string__length_in_bytes(pstr) + 1 + lenEncoded;
+
+	/* fall through */
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvh);
+	SG_STRING_NULLFREE(pCtx, pstr);
+}
+
+void SG_fragball_stream__add_blobs(SG_context * pCtx, SG_fragball_stream* pfs, const char* const* pasz_blob_hids, SG_uint32 countHids)
+{
+	SG_uint32 i = 0;
+	char* psz_objectid = NULL;
+	char* psz_hid_vcdiff_reference = NULL;
+
+	SG_NULLARGCHECK_RETURN(pfs);
+	SG_ARGCHECK_RETURN(!pfs->b_started, pfs);
+
+	for (i=0; i<countHids; i++)
+	{
+		SG_bool b_exists = SG_FALSE;
+		SG_blob_encoding encoding;
+		SG_uint64 len_encoded = 0;
+		SG_uint64 len_full = 0;
+		SG_uint64 len_object = 0;
+
+		SG_ERR_CHECK(  SG_repo__fetch_blob__info(pCtx, pfs->pRepo, pasz_blob_hids[i], &b_exists, &psz_objectid, &encoding, &psz_hid_vcdiff_reference, &len_encoded, &len_full)  );
+		if (!b_exists)
+			SG_ERR_THROW2(  SG_ERR_BLOB_NOT_FOUND, (pCtx, "%s", pasz_blob_hids[i])  );
+
+		SG_ERR_CHECK(  sg_fragball__blob_object_length(pCtx, psz_objectid, pasz_blob_hids[i], encoding, psz_hid_vcdiff_reference, len_encoded, len_full, &len_object)  );
+		SG_NULLFREE(pCtx, psz_objectid);
+		SG_NULLFREE(pCtx, psz_hid_vcdiff_reference);
+
+		SG_ERR_CHECK(  SG_stringarray__add(pCtx, pfs->psa_blobs, pasz_blob_hids[i])  );
+		SG_ERR_CHECK(  SG_vector_i64__append(pCtx, pfs->pvec_blob_lengths, (SG_int64) len_object, NULL)  );
+		pfs->len_total += len_object;
+	}
+
+	/* fall through */
+fail:
+	SG_NULLFREE(pCtx, psz_objectid);
+	SG_NULLFREE(pCtx, psz_hid_vcdiff_reference);
+}
+
+void SG_fragball_stream__get_length(SG_context * pCtx, const SG_fragball_stream* pfs, SG_uint64* pLen)
+{
+	SG_NULLARGCHECK_RETURN(pfs);
+	SG_NULLARGCHECK_RETURN(pLen);
+
+	*pLen = pfs->len_total;
+}
+
+static void sg_fragball_stream__begin_next_blob(SG_context * pCtx, SG_fragball_stream* pfs)
+{
+	const char* psz_hid = NULL;
+	char* psz_objectid = NULL;
+	char* psz_hid_vcdiff_reference = NULL;
+	SG_blob_encoding encoding;
+	SG_uint64 len_encoded = 0;
+	SG_uint64 len_full = 0;
+	SG_int64 len_expected = 0;
+	SG_vhash* pvh = NULL;
+	SG_string* pstr = NULL;
+
+	SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, pfs->psa_blobs, pfs->ndx_next_blob, &psz_hid)  );
+	SG_ERR_CHECK(  SG_vector_i64__get(pCtx, pfs->pvec_blob_lengths, pfs->ndx_next_blob, &len_expected)  );
+	pfs->ndx_next_blob++;
+
+	SG_ERR_CHECK(  SG_repo__fetch_blob__begin(pCtx, pfs->pRepo, psz_hid, SG_FALSE, &psz_objectid, &encoding, &psz_hid_vcdiff_reference, &len_encoded, &len_full, &pfs->pBlob)  );
+
+	SG_ERR_CHECK(  sg_fragball__alloc_blob_header(pCtx, psz_objectid, psz_hid, encoding, psz_hid_vcdiff_reference, len_encoded, len_full, &pvh)  );
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
+	SG_ERR_CHECK(  SG_vhash__to_json(pCtx, pvh, pstr)  );
+	SG_ERR_CHECK(  sg_fragball__frame_object_header(pCtx, SG_string__sz(pstr), &pfs->p_cur, &pfs->len_cur)  );
+	pfs->pos_cur = 0;
+	pfs->left_blob = len_encoded;
+
+	/* The length we promised was computed when the blob was added.  If the
+	 * repo has re-encoded the blob since then (a pack, for example) the
+	 * receiver would get a fragball that doesn't match its content length. */
+	if ((SG_uint64) len_expected != pfs->len_cur + len_encoded)
+		SG_ERR_THROW2(  SG_ERR_INCOMPLETEREAD, (pCtx, "blob %s changed while it was being sent", psz_hid)  );
+
+	/* fall through */
+fail:
+	SG_NULLFREE(pCtx, psz_objectid);
+	SG_NULLFREE(pCtx, psz_hid_vcdiff_reference);
+	SG_VHASH_NULLFREE(pCtx, pvh);
+	SG_STRING_NULLFREE(pCtx, pstr);
+}
+
+void SG_fragball_stream__read(
+	SG_context * pCtx,
+	void* pUnderlying,
+	SG_uint32 iNumBytesWanted,
+	SG_byte* pBytes,
+	SG_uint32* piNumBytesRetrieved,
+	SG_bool* pb_done)
+{
+	SG_fragball_stream* pfs = (SG_fragball_stream*) pUnderlying;
+	SG_uint32 count_headers = 0;
+	SG_uint32 count_blobs = 0;
+	SG_uint32 got = 0;
+	SG_bool b_done = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pfs);
+	SG_NULLARGCHECK_RETURN(pBytes);
+
+	pfs->b_started = SG_TRUE;
+
+	SG_ERR_CHECK(  SG_varray__count(pCtx, pfs->pva_headers, &count_headers)  );
+	SG_ERR_CHECK(  SG_stringarray__count(pCtx, pfs->psa_blobs, &count_blobs)  );
+
+	while (got < iNumBytesWanted)
+	{
+		if (pfs->p_cur)
+		{
+			SG_uint32 n = SG_MIN(iNumBytesWanted - got, pfs->len_cur - pfs->pos_cur);
+
+			memcpy(pBytes + got, pfs->p_cur + pfs->pos_cur, n);
+			got += n;
+			pfs->pos_cur += n;
+			if (pfs->pos_cur == pfs->len_cur)
+				SG_NULLFREE(pCtx, pfs->p_cur);
+		}
+		else if (pfs->pBlob)
+		{
+			if (pfs->left_blob)
+			{
+				SG_uint32 want = iNumBytesWanted - got;
+				SG_uint32 n = 0;
+				const SG_byte* p_span = NULL;
+				SG_bool b_blob_done = SG_FALSE;
+
+				if (want > pfs->left_blob)
+					want = (SG_uint32) pfs->left_blob;
+
+				SG_ERR_CHECK(  SG_repo__fetch_blob__chunk__span(pCtx, pfs->pRepo, pfs->pBlob, want, pBytes + got, &p_span, &n, &b_blob_done)  );
+				if (p_span != pBytes + got)
+					memcpy(pBytes + got, p_span, n);
+				got += n;
+				pfs->left_blob -= n;
+
+				if (b_blob_done && pfs->left_blob)
+					SG_ERR_THROW(  SG_ERR_INCOMPLETEREAD  );
+			}
+			if (0 == pfs->left_blob)
+				SG_ERR_CHECK(  SG_repo__fetch_blob__end(pCtx, pfs->pRepo, &pfs->pBlob)  );
+		}
+		else if (pfs->ndx_next_header < count_headers)
+		{
+			const char* psz_json = NULL;
+
+			SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pfs->pva_headers, pfs->ndx_next_header, &psz_json)  );
+			SG_ERR_CHECK(  sg_fragball__frame_object_header(pCtx, psz_json, &pfs->p_cur, &pfs->len_cur)  );
+			pfs->pos_cur = 0;
+			pfs->ndx_next_header++;
+		}
+		else if (pfs->ndx_next_blob < count_blobs)
+		{
+			SG_ERR_CHECK(  sg_fragball_stream__begin_next_blob(pCtx, pfs)  );
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	pfs->len_sent += got;
+
+	b_done = (!pfs->p_cur
+			  && !pfs->pBlob
+			  && pfs->ndx_next_header == count_headers
+			  && pfs->ndx_next_blob == count_blobs);
+
+	if (b_done && pfs->len_sent != pfs->len_total)
+		SG_ERR_THROW(  SG_ERR_INCOMPLETEREAD  );
+
+	if (piNumBytesRetrieved)
+		*piNumBytesRetrieved = got;
+	if (pb_done)
+		*pb_done = b_done;
+
+	return;
+
+fail:
+	if (pfs->pBlob)
+		SG_ERR_IGNORE(  SG_repo__fetch_blob__abort(pCtx, pfs->pRepo, &pfs->pBlob)  );
+}
+
+static SG_stream__func__close sg_fragball_stream__close;
+
+static void sg_fragball_stream__close(SG_context * pCtx, void* pUnderlying)
+{
+	SG_fragball_stream__free(pCtx, (SG_fragball_stream*) pUnderlying);
+}
+
+void SG_fragball_stream__alloc_readstream(SG_context * pCtx, SG_fragball_stream** ppfs, SG_readstream** ppStream)
+{
+	SG_NULL_PP_CHECK_RETURN(ppfs);
+	SG_NULLARGCHECK_RETURN(ppStream);
+
+	SG_ERR_CHECK_RETURN(  SG_readstream__alloc(pCtx, *ppfs, SG_fragball_stream__read, sg_fragball_stream__close, ppStream)  );
+	*ppfs = NULL;
+}
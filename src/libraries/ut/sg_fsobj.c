@@ -1172,6 +1172,92 @@ void SG_fsobj__move__pathname_pathname(SG_context * pCtx, const SG_pathname * pP
 #endif
 }
 
+void SG_fsobj__move_new_file__pathname_pathname(SG_context * pCtx, const SG_pathname * pPathnameOld, const SG_pathname * pPathnameNew)
+{
+	// like SG_fsobj__move__pathname_pathname(), but for a file that is to be
+	// CREATED at 'new': if something is already there, we fail (the same way
+	// SG_file__open__pathname() fails with SG_FILE_CREATE_NEW) rather than
+	// replace it.
+	//
+	// Linux/Mac:
+	//   rename() always replaces, so we link() the file to the new name
+	//   (which fails with EEXIST) and then unlink the old one.  If the
+	//   filesystem doesn't do hard links, we look before we rename().
+	//
+	// Windows:
+	//   MoveFileEx() without MOVEFILE_REPLACE_EXISTING fails with
+	//   ERROR_ALREADY_EXISTS.
+
+	SG_ARGCHECK_RETURN( SG_pathname__is_set(pPathnameOld) , pPathname );
+	SG_ARGCHECK_RETURN( SG_pathname__is_set(pPathnameNew) , pPathname );
+
+#if defined(MAC) || defined(LINUX)
+	{
+		int result;
+		char * pBufOS_Old = NULL;
+		char * pBufOS_New = NULL;
+		SG_bool bExists = SG_FALSE;
+
+		SG_ERR_CHECK(  SG_utf8__extern_to_os_buffer__sz(pCtx, SG_pathname__sz(pPathnameOld),&pBufOS_Old)  );
+		SG_ERR_CHECK(  SG_utf8__extern_to_os_buffer__sz(pCtx, SG_pathname__sz(pPathnameNew),&pBufOS_New)  );
+
+		result = link(pBufOS_Old,pBufOS_New);
+		if (result == 0)
+		{
+			result = unlink(pBufOS_Old);
+			if (result == -1)
+				SG_ERR_THROW2(  SG_ERR_ERRNO(errno),
+								(pCtx,"Calling unlink() on '%s'", SG_pathname__sz(pPathnameOld))  );
+		}
+		else if (errno == EEXIST)
+		{
+			SG_ERR_THROW2(  SG_ERR_ERRNO(EEXIST),
+							(pCtx,"Calling link() on '%s' --> '%s'",
+							 SG_pathname__sz(pPathnameOld),SG_pathname__sz(pPathnameNew))  );
+		}
+		else
+		{
+			SG_ERR_CHECK(  SG_fsobj__exists__pathname(pCtx, pPathnameNew, &bExists, NULL, NULL)  );
+			if (bExists)
+				SG_ERR_THROW2(  SG_ERR_ERRNO(EEXIST),
+								(pCtx,"Moving '%s' --> '%s'",
+								 SG_pathname__sz(pPathnameOld),SG_pathname__sz(pPathnameNew))  );
+
+			result = rename(pBufOS_Old,pBufOS_New);
+			if (result == -1)
+				SG_ERR_THROW2(  SG_ERR_ERRNO(errno),
+								(pCtx,"Calling rename() on '%s' --> '%s'",
+								 SG_pathname__sz(pPathnameOld),SG_pathname__sz(pPathnameNew))  );
+		}
+
+	fail:
+		SG_NULLFREE(pCtx, pBufOS_Old);
+		SG_NULLFREE(pCtx, pBufOS_New);
+	}
+#endif
+
+#if defined(WINDOWS)
+	{
+		BOOL bResult;
+		wchar_t * pBufOld = NULL;
+		wchar_t * pBufNew = NULL;
+
+		SG_ERR_CHECK(  SG_pathname__to_unc_wchar(pCtx, pPathnameOld,&pBufOld,NULL)  );
+		SG_ERR_CHECK(  SG_pathname__to_unc_wchar(pCtx, pPathnameNew,&pBufNew,NULL)  );
+
+		bResult = MoveFileEx(pBufOld,pBufNew, 0);
+		if (!bResult)
+			SG_ERR_THROW2(  SG_ERR_GETLASTERROR(GetLastError()),
+							(pCtx,"Calling MoveFileEx() on '%s' --> '%s'",
+							 SG_pathname__sz(pPathnameOld),SG_pathname__sz(pPathnameNew))  );
+
+	fail:
+		SG_NULLFREE(pCtx, pBufNew);
+		SG_NULLFREE(pCtx, pBufOld);
+	}
+#endif
+}
+
 //////////////////////////////////////////////////////////////////
 
 SG_bool SG_fsobj__equivalent_perms(SG_fsobj_perms p1, SG_fsobj_perms p2)
@@ -94,7 +94,9 @@ void SG_lib__global_initialize(SG_context * pCtx)
 
 	SG_ERR_CHECK(  sg_lib_utf8__global_initialize(pCtx, &gLibData.pUtf8GlobalData)  );
 
+	SG_ERR_CHECK(  sg_objcache__global_initialize(pCtx)  );
 	SG_ERR_CHECK(  SG_curl__global_init(pCtx)  );
+	SG_ERR_CHECK(  sg_lib_uridispatch__global_initialize(pCtx)  );
 
     {
         SG_int64 itime = -1;
@@ -113,6 +115,7 @@ void SG_lib__global_cleanup(SG_context * pCtx)
 {
 	SG_curl__global_cleanup();
 	sg_lib_uridispatch__global_cleanup(pCtx);
+	sg_objcache__global_cleanup(pCtx);
 	sg_lib_utf8__global_cleanup(pCtx, &gLibData.pUtf8GlobalData);
     SG_zing__now_free_all_cached_templates(pCtx);
 
@@ -44,7 +44,10 @@ void sg_lib_utf8__global_initialize(SG_context * pCtx, sg_lib_utf8__global_data
 void sg_lib_utf8__global_cleanup(SG_context * pCtx, sg_lib_utf8__global_data ** ppUtf8GlobalData);
 
 void sg_lib_localsettings__global_cleanup(SG_context * pCtx);
+void sg_lib_uridispatch__global_initialize(SG_context * pCtx);
 void sg_lib_uridispatch__global_cleanup(SG_context * pCtx);
+void sg_objcache__global_initialize(SG_context * pCtx);
+void sg_objcache__global_cleanup(SG_context * pCtx);
 
 /**
  * Fetch the pointer for utf8 global data.
@@ -171,6 +171,54 @@ void SG_curl__state_file__free(SG_context* pCtx, SG_curl_state_file* pState)
 	}
 }
 
+void SG_curl__state_readstream__alloc(SG_context* pCtx, SG_curl_state_readstream** ppState)
+{
+	SG_curl_state_readstream* pState = NULL;
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pState)  );
+	SG_ERR_CHECK(  SG_context__alloc(&pState->pCtx)  );
+
+	SG_RETURN_AND_NULL(pState, ppState);
+
+	/* fall through */
+fail:
+	SG_CURL_STATE_READSTREAM_NULLFREE(pCtx, pState);
+}
+
+void SG_curl__state_readstream__free(SG_context* pCtx, SG_curl_state_readstream* pState)
+{
+	if (pState)
+	{
+		if (pState->pStream)
+			SG_ERR_IGNORE(  SG_readstream__close(pCtx, pState->pStream)  );
+		SG_CONTEXT_NULLFREE(pState->pCtx);
+		SG_NULLFREE(pCtx, pState);
+	}
+}
+
+void SG_curl__state_writestream__alloc(SG_context* pCtx, SG_curl_state_writestream** ppState)
+{
+	SG_curl_state_writestream* pState = NULL;
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pState)  );
+	SG_ERR_CHECK(  SG_context__alloc(&pState->pCtx)  );
+
+	SG_RETURN_AND_NULL(pState, ppState);
+
+	/* fall through */
+fail:
+	SG_CURL_STATE_WRITESTREAM_NULLFREE(pCtx, pState);
+}
+
+void SG_curl__state_writestream__free(SG_context* pCtx, SG_curl_state_writestream* pState)
+{
+	if (pState)
+	{
+		SG_CONTEXT_NULLFREE(pState->pCtx);
+		SG_NULLFREE(pCtx, pState);
+	}
+}
+
 void SG_curl__state_string__alloc(SG_context* pCtx, SG_curl_state_string** ppState)
 {
 	SG_curl_state_string* pState = NULL;
@@ -248,6 +296,23 @@ fail:
 	return 0;
 }
 
+size_t SG_curl__send_readstream_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState)
+{
+	SG_curl_state_readstream* pState = (SG_curl_state_readstream*)pVoidState;
+	SG_context* pCtx = pState->pCtx;
+
+	SG_uint32 buf_len = size * nmemb;
+	SG_uint32 len_read = 0;
+
+	SG_ERR_CHECK(  SG_readstream__read(pCtx, pState->pStream, buf_len, (SG_byte*)buffer, &len_read, NULL)  );
+
+	return len_read;
+
+fail:
+	// As above, returning 0 stops the transfer and leaves our error in place.
+	return 0;
+}
+
 size_t SG_curl__receive_file_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState)
 {
 	SG_file* pFile = ((SG_curl_state_file*)pVoidState)->pFile;
@@ -265,6 +330,21 @@ fail:
 	return real_size;
 }
 
+size_t SG_curl__receive_writestream_chunk(char* buffer, size_t size, size_t nmemb, void* pVoidState)
+{
+	SG_curl_state_writestream* pState = (SG_curl_state_writestream*)pVoidState;
+	SG_context* pCtx = pState->pCtx;
+	SG_uint32 real_size = size * nmemb;
+
+	SG_ERR_CHECK(  SG_writestream__write(pCtx, pState->pStream, real_size, (SG_byte*)buffer, NULL)  );
+
+	return real_size;
+
+fail:
+	// Returning a short count stops the transfer and leaves our error in place.
+	return 0;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void SG_curl__throw_on_non200(SG_context* pCtx, CURL* pCurl)
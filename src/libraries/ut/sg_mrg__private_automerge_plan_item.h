@@ -151,21 +151,25 @@ void SG_mrg_automerge_plan_item__set_interior_result(SG_context * pCtx,
 /**
  * actually fetch the contents of the ancestor/mine/yours blobs
  * from the repo *if* necessary.
+ *
+ * the caller passes the repo so that this can be done on an automerge
+ * worker thread using the worker's own repo instance.
  */
 void SG_mrg_automerge_plan_item__fetch_files(SG_context * pCtx,
+											 SG_repo * pRepo,
 											 SG_mrg_automerge_plan_item * pItem)
 {
-	SG_ERR_CHECK_RETURN(  SG_mrg__export_to_temp_file(pCtx,pItem->pMrg,
+	SG_ERR_CHECK_RETURN(  SG_mrg__export_to_temp_file(pCtx,pRepo,
 													  pItem->pMrgCSetEntry_Ancestor->bufHid_Blob,
 													  pItem->pPath_Ancestor)  );
 
 	if (pItem->bufHidBlob_Mine[0])
-		SG_ERR_CHECK_RETURN(  SG_mrg__export_to_temp_file(pCtx,pItem->pMrg,
+		SG_ERR_CHECK_RETURN(  SG_mrg__export_to_temp_file(pCtx,pRepo,
 														  pItem->bufHidBlob_Mine,
 														  pItem->pPath_Mine)  );
 
 	if (pItem->bufHidBlob_Yours[0])
-		SG_ERR_CHECK_RETURN(  SG_mrg__export_to_temp_file(pCtx,pItem->pMrg,
+		SG_ERR_CHECK_RETURN(  SG_mrg__export_to_temp_file(pCtx,pRepo,
 														  pItem->bufHidBlob_Yours,
 														  pItem->pPath_Yours)  );
 }
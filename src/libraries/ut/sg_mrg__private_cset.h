@@ -45,6 +45,7 @@ void SG_mrg_cset__free(SG_context * pCtx, SG_mrg_cset * pMrgCSet)
 	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pMrgCSet->prbConflicts, (SG_free_callback *)SG_mrg_cset_entry_conflict__free);
 
 	SG_RBTREE_NULLFREE(pCtx, pMrgCSet->prbDeletes);		// we do not own the assoc-data
+	SG_RBTREE_NULLFREE(pCtx, pMrgCSet->prbUnloadedDirs);
 
 	SG_STRING_NULLFREE(pCtx, pMrgCSet->pStringName);
 	SG_NULLFREE(pCtx, pMrgCSet);
@@ -71,6 +72,7 @@ void SG_mrg_cset__alloc(SG_context * pCtx,
 	// we do not allocate prbDirs or set pMrgCSetDir_Root until we actually need it.
 	// we do not allocate prbConflicts until we actually need it.
 	// we do not allocate prbDeletes until we actually need it.
+	// we do not allocate prbUnloadedDirs unless we are asked to load lazily.
 
 	*ppMrgCSet = pMrgCSet;
 	return;
@@ -82,13 +84,15 @@ fail:
 //////////////////////////////////////////////////////////////////
 
 /**
- * Load the entire contents of the version control tree as of
- * this CSET into memory.
+ * Load the version control tree as of this CSET into memory.
+ * When bLazy is set, we only load the actual-root entry and
+ * leave it in prbUnloadedDirs.
  */
-void SG_mrg_cset__load_entire_cset(SG_context * pCtx,
-								   SG_mrg_cset * pMrgCSet,
-								   SG_repo * pRepo,
-								   const char * pszHid_CSet)
+static void _sg_mrg_cset__load(SG_context * pCtx,
+							   SG_mrg_cset * pMrgCSet,
+							   SG_repo * pRepo,
+							   const char * pszHid_CSet,
+							   SG_bool bLazy)
 {
 	SG_changeset * pCSet = NULL;
 	SG_treenode * pTn_SuperRoot = NULL;
@@ -109,6 +113,9 @@ void SG_mrg_cset__load_entire_cset(SG_context * pCtx,
 									pMrgCSet->bufHid_CSet,SG_NrElements(pMrgCSet->bufHid_CSet),
 									pszHid_CSet)  );
 
+	if (bLazy)
+		SG_ERR_CHECK_RETURN(  SG_RBTREE__ALLOC(pCtx,&pMrgCSet->prbUnloadedDirs)  );
+
 	// load the changeset from disk.
 	// get the HID of the super-root treenode.
 	// load the super-root treenode.
@@ -152,7 +159,8 @@ void SG_mrg_cset__load_entire_cset(SG_context * pCtx,
 	}
 #endif
 
-	// use the treenode-entry of the actual-root and load the entire version control tree into memory.
+	// use the treenode-entry of the actual-root and load the entire version control tree into memory
+	// (or just the actual-root entry if we are being lazy).
 	// we store the pMrgCSetEntry of the actual-root directory in pMrgCSet as a convenience.
 
 	SG_ERR_CHECK(  SG_mrg_cset_entry__load(pCtx,pMrgCSet,pRepo,
@@ -165,6 +173,54 @@ fail:
 	SG_TREENODE_NULLFREE(pCtx, pTn_SuperRoot);
 }
 
+void SG_mrg_cset__load_entire_cset(SG_context * pCtx,
+								   SG_mrg_cset * pMrgCSet,
+								   SG_repo * pRepo,
+								   const char * pszHid_CSet)
+{
+	SG_ERR_CHECK_RETURN(  _sg_mrg_cset__load(pCtx,pMrgCSet,pRepo,pszHid_CSet,SG_FALSE)  );
+}
+
+void SG_mrg_cset__load_lazy(SG_context * pCtx,
+							SG_mrg_cset * pMrgCSet,
+							SG_repo * pRepo,
+							const char * pszHid_CSet)
+{
+	SG_ERR_CHECK_RETURN(  _sg_mrg_cset__load(pCtx,pMrgCSet,pRepo,pszHid_CSet,SG_TRUE)  );
+}
+
+void SG_mrg_cset__load_unloaded_dir(SG_context * pCtx,
+									SG_mrg_cset * pMrgCSet,
+									SG_repo * pRepo,
+									const char * pszGid_Dir)
+{
+	SG_mrg_cset_entry * pMrgCSetEntry;
+	const char * pszHid_Treenode;
+	char bufHid_Treenode[SG_HID_MAX_BUFFER_LENGTH];
+	SG_bool bFound;
+
+	SG_NULLARGCHECK_RETURN(pMrgCSet);
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NONEMPTYCHECK_RETURN(pszGid_Dir);
+
+	SG_ARGCHECK_RETURN(  (pMrgCSet->prbUnloadedDirs != NULL), prbUnloadedDirs  );
+
+	SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx,pMrgCSet->prbUnloadedDirs,pszGid_Dir,&bFound,(void **)&pszHid_Treenode)  );
+	if (!bFound)
+		SG_ERR_THROW_RETURN(  SG_ERR_NOT_FOUND  );
+	SG_ERR_CHECK_RETURN(  SG_strcpy(pCtx,bufHid_Treenode,SG_NrElements(bufHid_Treenode),pszHid_Treenode)  );
+
+	SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx,pMrgCSet->prbEntries,pszGid_Dir,&bFound,(void **)&pMrgCSetEntry)  );
+	if (!bFound)
+		SG_ERR_THROW_RETURN(  SG_ERR_NOT_FOUND  );
+
+	// take it off the list before we load it; the sub-directories within it
+	// will be added to the list as their entries are loaded.
+
+	SG_ERR_CHECK_RETURN(  SG_rbtree__remove(pCtx,pMrgCSet->prbUnloadedDirs,pszGid_Dir)  );
+	SG_ERR_CHECK_RETURN(  SG_mrg_cset_entry__load_subdir(pCtx,pMrgCSet,pRepo,pszGid_Dir,pMrgCSetEntry,bufHid_Treenode)  );
+}
+
 //////////////////////////////////////////////////////////////////
 
 static SG_rbtree_foreach_callback _set_marker_cb;
@@ -117,9 +117,16 @@ void SG_mrg_cset_entry__load(SG_context * pCtx,
 	// TODO do we care about the TNE version?
 
 	// we don't set bufHid_Blob for directories.
+	// when the cset is being loaded lazily, we just remember the treenode HID
+	// of the directory and let the caller decide if/when to load its contents.
 	SG_ERR_CHECK(  SG_treenode_entry__get_hid_blob(pCtx,pTne_Self,&psz_temp)  );
 	if (pMrgCSetEntry->tneType == SG_TREENODEENTRY_TYPE_DIRECTORY)
-		SG_ERR_CHECK(  SG_mrg_cset_entry__load_subdir(pCtx,pMrgCSet,pRepo,pszGid_Self,pMrgCSetEntry,psz_temp)  );
+	{
+		if (pMrgCSet->prbUnloadedDirs)
+			SG_ERR_CHECK(  SG_rbtree__add__with_pooled_sz(pCtx,pMrgCSet->prbUnloadedDirs,pszGid_Self,psz_temp)  );
+		else
+			SG_ERR_CHECK(  SG_mrg_cset_entry__load_subdir(pCtx,pMrgCSet,pRepo,pszGid_Self,pMrgCSetEntry,psz_temp)  );
+	}
 	else
 		SG_ERR_CHECK(  SG_strcpy(pCtx,pMrgCSetEntry->bufHid_Blob,SG_NrElements(pMrgCSetEntry->bufHid_Blob),psz_temp)  );
 
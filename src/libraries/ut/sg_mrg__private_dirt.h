@@ -156,6 +156,8 @@ static void _mrg__try_to_handle_dirt_cb__found(SG_context * pCtx,
 	SG_mrg_cset_dir * pMrgCSetDirParent;			// we do not own this
 	SG_rbtree_iterator * pIter = NULL;
 	SG_portability_dir * pPort = NULL;
+	SG_treenode * pTnParent = NULL;
+	const char * pszHidTreenodeParent = NULL;
 	SG_bool bParentWillBePresentInFinalResult;
 
 	// NOTE: Because this is a FOUND item, the GID is fabricated freshly for
@@ -170,6 +172,18 @@ static void _mrg__try_to_handle_dirt_cb__found(SG_context * pCtx,
 								   pszGidParent,
 								   &bParentWillBePresentInFinalResult,
 								   (void **)&pMrgCSetDirParent)  );
+	if (!bParentWillBePresentInFinalResult && pMrg->pMrgCSet_Baseline->prbUnloadedDirs)
+	{
+		// The merge did not load the contents of the parent directory
+		// because it is identical in all of the csets, so it will be present
+		// (and unchanged) in the final result even though it isn't in prbDirs.
+
+		SG_ERR_CHECK(  SG_rbtree__find(pCtx,
+									   pMrg->pMrgCSet_Baseline->prbUnloadedDirs,
+									   pszGidParent,
+									   &bParentWillBePresentInFinalResult,
+									   (void **)&pszHidTreenodeParent)  );
+	}
 	if (bParentWillBePresentInFinalResult)
 	{
 		SG_mrg_cset_entry * pMrgCSetEntryChild;			// we do not own this
@@ -196,19 +210,46 @@ static void _mrg__try_to_handle_dirt_cb__found(SG_context * pCtx,
 		SG_ERR_CHECK(  SG_pendingtree__get_port_settings(pCtx, pMrg->pPendingTree,
 														 &pConverterRepoCharSet, &pvaWarnings, &portMask, &bIgnoreWarnings)  );
 		SG_ERR_CHECK(  SG_portability_dir__alloc(pCtx, portMask, NULL, pConverterRepoCharSet, pvaWarnings, &pPort)  );
-		SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pMrgCSetDirParent->prbEntry_Children,
-												  &bOK, &pszGidEntryChild, (void **)&pMrgCSetEntryChild)  );
-		while (bOK)
+		if (pszHidTreenodeParent)
 		{
-			SG_ERR_CHECK(  SG_portability_dir__add_item__with_assoc(pCtx, pPort,
-																	pMrgCSetEntryChild->bufGid_Entry,
-																	SG_string__sz(pMrgCSetEntryChild->pStringEntryname),
-																	SG_FALSE, SG_TRUE, pMrgCSetEntryChild, NULL,
-																	&bIsDuplicate, NULL)  );
-			SG_ASSERT(  (!bIsDuplicate)  );
-
-			SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, 
-													 &bOK, &pszGidEntryChild, (void **)&pMrgCSetEntryChild)  );
+			// we never loaded the parent's contents; get them from its treenode.
+
+			SG_repo * pRepo;
+			const SG_treenode_entry * pTneChild;
+			const char * pszEntrynameChild;
+			SG_uint32 nrEntries, k;
+
+			SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pMrg->pPendingTree, &pRepo)  );
+			SG_ERR_CHECK(  SG_treenode__load_from_repo(pCtx, pRepo, pszHidTreenodeParent, &pTnParent)  );
+			SG_ERR_CHECK(  SG_treenode__count(pCtx, pTnParent, &nrEntries)  );
+			for (k=0; k<nrEntries; k++)
+			{
+				SG_ERR_CHECK(  SG_treenode__get_nth_treenode_entry__ref(pCtx, pTnParent, k, &pszGidEntryChild, &pTneChild)  );
+				SG_ERR_CHECK(  SG_treenode_entry__get_entry_name(pCtx, pTneChild, &pszEntrynameChild)  );
+				SG_ERR_CHECK(  SG_portability_dir__add_item__with_assoc(pCtx, pPort,
+																		pszGidEntryChild,
+																		pszEntrynameChild,
+																		SG_FALSE, SG_TRUE, NULL, NULL,
+																		&bIsDuplicate, NULL)  );
+				SG_ASSERT(  (!bIsDuplicate)  );
+			}
+		}
+		else
+		{
+			SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pMrgCSetDirParent->prbEntry_Children,
+													  &bOK, &pszGidEntryChild, (void **)&pMrgCSetEntryChild)  );
+			while (bOK)
+			{
+				SG_ERR_CHECK(  SG_portability_dir__add_item__with_assoc(pCtx, pPort,
+																		pMrgCSetEntryChild->bufGid_Entry,
+																		SG_string__sz(pMrgCSetEntryChild->pStringEntryname),
+																		SG_FALSE, SG_TRUE, pMrgCSetEntryChild, NULL,
+																		&bIsDuplicate, NULL)  );
+				SG_ASSERT(  (!bIsDuplicate)  );
+
+				SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, 
+														 &bOK, &pszGidEntryChild, (void **)&pMrgCSetEntryChild)  );
+			}
 		}
 
 		// now add the FOUND item's entryname to the collider and see if
@@ -317,6 +358,7 @@ static void _mrg__try_to_handle_dirt_cb__found(SG_context * pCtx,
 fail:
 	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
 	SG_PORTABILITY_DIR_NULLFREE(pCtx, pPort);
+	SG_TREENODE_NULLFREE(pCtx, pTnParent);
 }
 
 //////////////////////////////////////////////////////////////////
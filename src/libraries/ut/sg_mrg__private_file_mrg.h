@@ -31,11 +31,35 @@ BEGIN_EXTERN_C;
 
 //////////////////////////////////////////////////////////////////
 
+#define MY_AMF__MAX_THREADS		8
+
+/**
+ * One TBD content conflict to be auto-merged.  The worker fills in
+ * bAutoMergeSuccessful; the flags and stats on the conflict and the
+ * result-cset are only updated on the caller's thread after all of
+ * the workers are done, in the order of SG_mrg_cset.prbConflicts.
+ */
+struct _amf_job
+{
+	SG_mrg_cset_entry_conflict *			pMrgCSetEntryConflict;	// we do not own this
+	SG_mrg_external_automerge_handler *		pfn;
+	SG_bool									bAutoMergeSuccessful;
+};
+
+typedef struct _amf_job _amf_job;
+
 struct _amf_data
 {
 	SG_mrg *				pMrg;
 	SG_mrg_cset *			pMrgCSet;
 	SG_mrg_cset_stats *		pMrgCSetStats;
+
+	_amf_job *				aJobs;			// we own this
+	SG_uint32				nrJobs;
+
+	SG_repo *				pRepo;			// we do not own this
+	SG_uint32				nrRepos;
+	SG_repo **				aRepos;			// one per worker (we own these); NULL when there are no workers
 };
 
 typedef struct _amf_data _amf_data;
@@ -123,20 +147,18 @@ static void _handle_external_automerge(SG_context * pCtx,
 /**
  * We get called once for each conflict in SG_mrg_cset.prbConflicts.
  * We may be a structural conflict or a TBD content conflict.  Ignore
- * the former and try to automerge the contents of the latter.
+ * the former and add a job to automerge the contents of the latter.
  */
-static SG_rbtree_foreach_callback _try_automerge_files;
+static SG_rbtree_foreach_callback _collect_automerge_files;
 
-static void _try_automerge_files(SG_context * pCtx,
-								 SG_UNUSED_PARAM(const char * pszKey_Gid_Entry),
-								 void * pVoidAssocData_MrgCSetEntryConflict,
-								 void * pVoid_Data)
+static void _collect_automerge_files(SG_context * pCtx,
+									 SG_UNUSED_PARAM(const char * pszKey_Gid_Entry),
+									 void * pVoidAssocData_MrgCSetEntryConflict,
+									 void * pVoid_Data)
 {
 	SG_mrg_cset_entry_conflict * pMrgCSetEntryConflict = (SG_mrg_cset_entry_conflict *)pVoidAssocData_MrgCSetEntryConflict;
 	_amf_data * pAmfData = (_amf_data *)pVoid_Data;
-	SG_mrg_external_automerge_handler * pfn = NULL;
-	SG_bool bAutoMergeSuccessful = SG_FALSE;
-	SG_uint32 k, nrItems;
+	_amf_job * pJob;
 
 	SG_UNUSED(pszKey_Gid_Entry);
 
@@ -147,6 +169,27 @@ static void _try_automerge_files(SG_context * pCtx,
 	SG_ASSERT( (pMrgCSetEntryConflict->pVec_AutoMergePlan) );
 	SG_ASSERT( (pMrgCSetEntryConflict->pPathAutoMergePlanResult) );
 
+	pJob = &pAmfData->aJobs[pAmfData->nrJobs++];
+	pJob->pMrgCSetEntryConflict = pMrgCSetEntryConflict;
+
+	// choose handler based upon suffix or the phase of the moon....
+
+	SG_ERR_CHECK_RETURN(  _select_external_automerge_handler(pCtx,pAmfData,pMrgCSetEntryConflict,&pJob->pfn)  );
+}
+
+/**
+ * Fetch the files for the merge-plan of one conflict and let the handler
+ * try to merge them.  This may run on one of the automerge worker threads
+ * (using the worker's own repo instance), so it only touches the job and
+ * its conflict.
+ */
+static void _try_automerge_files(SG_context * pCtx,
+								 SG_repo * pRepo,
+								 _amf_job * pJob)
+{
+	SG_mrg_cset_entry_conflict * pMrgCSetEntryConflict = pJob->pMrgCSetEntryConflict;
+	SG_uint32 k, nrItems;
+
 	// We are given a "merge-plan".  A sequence of steps that we need to
 	// perform (and in the given order) to completely merge the various
 	// versions of the file's content.
@@ -198,38 +241,63 @@ static void _try_automerge_files(SG_context * pCtx,
 		SG_mrg_automerge_plan_item * pItem;
 
 		SG_ERR_CHECK(  SG_vector__get(pCtx,pMrgCSetEntryConflict->pVec_AutoMergePlan,k,(void **)&pItem)  );
-		SG_ERR_CHECK(  SG_mrg_automerge_plan_item__fetch_files(pCtx,pItem)  );
+		SG_ERR_CHECK(  SG_mrg_automerge_plan_item__fetch_files(pCtx,pRepo,pItem)  );
 	}
 
-	// choose handler based upon suffix or the phase of the moon....
+	if (pJob->pfn)
+		SG_ERR_CHECK(  _handle_external_automerge(pCtx,pMrgCSetEntryConflict,pJob->pfn,&pJob->bAutoMergeSuccessful)  );
+
+fail:
+	return;
+}
+
+/**
+ * Update the conflict and the stats with the outcome of a job.
+ * This is only done on the caller's thread.
+ */
+static void _record_automerge_result(_amf_data * pAmfData,
+									 const _amf_job * pJob)
+{
+	SG_mrg_cset_entry_conflict * pMrgCSetEntryConflict = pJob->pMrgCSetEntryConflict;
 
-	SG_ERR_CHECK(  _select_external_automerge_handler(pCtx,pAmfData,pMrgCSetEntryConflict,&pfn)  );
-	if (pfn == NULL)
+	if (pJob->pfn == NULL)
 	{
 		pMrgCSetEntryConflict->flags |=  SG_MRG_CSET_ENTRY_CONFLICT_FLAGS__DIVERGENT_FILE_EDIT__NO_RULE;
 		pAmfData->pMrgCSetStats->nrAutoMerge_NoRule++;
 	}
+	else if (pJob->bAutoMergeSuccessful)
+	{
+		pMrgCSetEntryConflict->flags |=  SG_MRG_CSET_ENTRY_CONFLICT_FLAGS__DIVERGENT_FILE_EDIT__AUTO_OK;
+		pAmfData->pMrgCSetStats->nrAutoMerge_OK++;
+	}
 	else
 	{
-		SG_ERR_CHECK(  _handle_external_automerge(pCtx,pMrgCSetEntryConflict,pfn,&bAutoMergeSuccessful)  );
-
-		if (bAutoMergeSuccessful)
-		{
-			pMrgCSetEntryConflict->flags |=  SG_MRG_CSET_ENTRY_CONFLICT_FLAGS__DIVERGENT_FILE_EDIT__AUTO_OK;
-			pAmfData->pMrgCSetStats->nrAutoMerge_OK++;
-		}
-		else
-		{
-			pMrgCSetEntryConflict->flags |=  SG_MRG_CSET_ENTRY_CONFLICT_FLAGS__DIVERGENT_FILE_EDIT__AUTO_FAILED;
-			pAmfData->pMrgCSetStats->nrAutoMerge_Fail++;
-		}
+		pMrgCSetEntryConflict->flags |=  SG_MRG_CSET_ENTRY_CONFLICT_FLAGS__DIVERGENT_FILE_EDIT__AUTO_FAILED;
+		pAmfData->pMrgCSetStats->nrAutoMerge_Fail++;
 	}
 
 	pMrgCSetEntryConflict->flags &= ~SG_MRG_CSET_ENTRY_CONFLICT_FLAGS__DIVERGENT_FILE_EDIT__TBD;
 	pAmfData->pMrgCSetStats->nrAutoMerge_TBD--;
+}
 
-fail:
-	return;
+//////////////////////////////////////////////////////////////////
+
+static SG_work_queue__callback _amf__work_cb;
+
+/**
+ * Run one automerge job on a work queue thread (or on the caller's
+ * thread if the queue has no workers) using that thread's repo instance.
+ */
+static void _amf__work_cb(SG_context * pCtx,
+						  SG_uint32 kThread,
+						  void * pVoidData,
+						  void * pVoidItem)
+{
+	_amf_data * pAmfData = (_amf_data *)pVoidData;
+	_amf_job * pJob = (_amf_job *)pVoidItem;
+	SG_repo * pRepo = ((pAmfData->aRepos) ? pAmfData->aRepos[kThread] : pAmfData->pRepo);
+
+	SG_ERR_CHECK_RETURN(  _try_automerge_files(pCtx, pRepo, pJob)  );
 }
 
 //////////////////////////////////////////////////////////////////
@@ -237,6 +305,10 @@ fail:
 void SG_mrg__automerge_files(SG_context * pCtx, SG_mrg * pMrg, SG_mrg_cset * pMrgCSet, SG_mrg_cset_stats * pMrgCSetStats)
 {
 	_amf_data amfData;
+	SG_work_queue * pQueue = NULL;
+	SG_uint32 nrConflicts;
+	SG_uint32 nrThreads = 0;
+	SG_uint32 k;
 
 	SG_NULLARGCHECK_RETURN(pMrg);
 	SG_NULLARGCHECK_RETURN(pMrgCSet);
@@ -246,13 +318,66 @@ void SG_mrg__automerge_files(SG_context * pCtx, SG_mrg * pMrg, SG_mrg_cset * pMr
 	if (!pMrgCSet->prbConflicts)
 		return;
 
-	// visit each entry in the result-cset and do any auto-merges that we can.
-
+	memset(&amfData,0,sizeof(amfData));
 	amfData.pMrg = pMrg;
 	amfData.pMrgCSet = pMrgCSet;
 	amfData.pMrgCSetStats = pMrgCSetStats;
 
-	SG_ERR_CHECK_RETURN(  SG_rbtree__foreach(pCtx,pMrgCSet->prbConflicts,_try_automerge_files,&amfData)  );
+	// visit each entry in the result-cset and make a list of the auto-merges
+	// that we should try.
+
+	SG_ERR_CHECK(  SG_rbtree__count(pCtx,pMrgCSet->prbConflicts,&nrConflicts)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx,nrConflicts,amfData.aJobs)  );
+	SG_ERR_CHECK(  SG_rbtree__foreach(pCtx,pMrgCSet->prbConflicts,_collect_automerge_files,&amfData)  );
+
+	if (amfData.nrJobs == 0)
+		goto done;
+
+	// each job fetches its own blobs and runs its own merge tool, so they
+	// can run in parallel.  each worker gets its own repo instance.
+
+	SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pMrg->pPendingTree, &amfData.pRepo)  );
+
+	SG_ERR_CHECK(  SG_work_queue__alloc(pCtx,
+										((amfData.nrJobs < MY_AMF__MAX_THREADS) ? amfData.nrJobs : MY_AMF__MAX_THREADS),
+										0, SG_WORK_QUEUE_FLAGS__NONE,
+										_amf__work_cb, (void *)&amfData, &pQueue)  );
+	SG_ERR_CHECK(  SG_work_queue__get_thread_count(pCtx, pQueue, &nrThreads)  );
+	if (nrThreads > 0)
+	{
+		SG_ERR_CHECK(  SG_allocN(pCtx,nrThreads,amfData.aRepos)  );
+		amfData.nrRepos = nrThreads;
+		for (k=0; k<nrThreads; k++)
+			SG_ERR_CHECK(  SG_repo__open_repo_instance__copy(pCtx,amfData.pRepo,&amfData.aRepos[k])  );
+	}
+
+	for (k=0; k<amfData.nrJobs; k++)
+		SG_ERR_CHECK(  SG_work_queue__add(pCtx, pQueue, (void *)&amfData.aJobs[k])  );
+
+	// this rethrows the first error that a worker hit (with its
+	// description and stack) after all of the workers have stopped.
+
+	SG_ERR_CHECK(  SG_work_queue__finish(pCtx, pQueue)  );
+
+	// now that everything is done, record the outcomes in the order
+	// of the conflict list so that the stats and flags don't depend
+	// on which thread finished first.
+
+	for (k=0; k<amfData.nrJobs; k++)
+		_record_automerge_result(&amfData,&amfData.aJobs[k]);
+
+done:
+fail:
+	// this abandons whatever is still queued (and waits for the
+	// workers) before we take their repo instances away.
+	SG_WORK_QUEUE_NULLFREE(pCtx, pQueue);
+	if (amfData.aRepos)
+	{
+		for (k=0; k<amfData.nrRepos; k++)
+			SG_REPO_NULLFREE(pCtx, amfData.aRepos[k]);
+		SG_NULLFREE(pCtx, amfData.aRepos);
+	}
+	SG_NULLFREE(pCtx, amfData.aJobs);
 }
 
 //////////////////////////////////////////////////////////////////
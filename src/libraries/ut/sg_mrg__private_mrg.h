@@ -248,11 +248,21 @@ static void _sg_mrg__daglca_callback__load_cset(SG_context * pCtx,
 	else if (bIsBaseline)
 		pLoadCSetData->pMrg->pMrgCSet_Baseline = pMrgCSet;
 
+	// only load the actual-root for now.  _sg_mrg__load_changed_dirs() will
+	// load the parts of the tree that we actually need once all of the
+	// CSETs have been started.
+
 	SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pLoadCSetData->pMrg->pPendingTree, &pRepo)  );
-	SG_ERR_CHECK(  SG_mrg_cset__load_entire_cset(pCtx,
-												 pMrgCSet,
-												 pRepo,
-												 pszHid_CSet)  );
+	if (pLoadCSetData->pMrg->bLoadEntireCSets)
+		SG_ERR_CHECK(  SG_mrg_cset__load_entire_cset(pCtx,
+													 pMrgCSet,
+													 pRepo,
+													 pszHid_CSet)  );
+	else
+		SG_ERR_CHECK(  SG_mrg_cset__load_lazy(pCtx,
+											  pMrgCSet,
+											  pRepo,
+											  pszHid_CSet)  );
 
 	// TODO use the prbImmediateDescendants to compute a plan for performing merge.
 
@@ -263,6 +273,289 @@ fail:
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * See if the given unloaded directory has the same treenode in
+ * all of the CSETs that we loaded.
+ */
+static void _sg_mrg__is_dir_unchanged_in_all_csets(SG_context * pCtx,
+												   SG_mrg * pMrg,
+												   const char * pszGid_Dir,
+												   const char * pszHid_Treenode,
+												   SG_bool * pbUnchanged)
+{
+	SG_rbtree_iterator * pIter = NULL;
+	SG_mrg_cset * pMrgCSet_k;
+	const char * pszKey;
+	const char * pszHid_k;
+	SG_bool bOK, bFound;
+	SG_bool bUnchanged = SG_TRUE;
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pMrg->prbCSets, &bOK, &pszKey, (void **)&pMrgCSet_k)  );
+	while (bOK && bUnchanged)
+	{
+		SG_ERR_CHECK(  SG_rbtree__find(pCtx, pMrgCSet_k->prbUnloadedDirs, pszGid_Dir, &bFound, (void **)&pszHid_k)  );
+		if (!bFound || (strcmp(pszHid_k, pszHid_Treenode) != 0))
+			bUnchanged = SG_FALSE;
+		else
+			SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &bOK, &pszKey, (void **)&pMrgCSet_k)  );
+	}
+
+	*pbUnchanged = bUnchanged;
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+}
+
+/**
+ * Load the contents of an unloaded directory in all of the CSETs.
+ * The caller must have finished _sg_mrg__load_changed_dirs(), so
+ * that the directory is unloaded (with the same HID) in all of them.
+ */
+static void _sg_mrg__load_unloaded_dir_in_all_csets(SG_context * pCtx,
+													SG_mrg * pMrg,
+													SG_repo * pRepo,
+													const char * pszGid_Dir)
+{
+	SG_rbtree_iterator * pIter = NULL;
+	SG_mrg_cset * pMrgCSet_k;
+	const char * pszKey;
+	char bufGid_Dir[SG_GID_BUFFER_LENGTH];
+	SG_bool bOK;
+
+	// the caller's GID may be a key in one of the prbUnloadedDirs that we are about to change.
+
+	SG_ERR_CHECK(  SG_strcpy(pCtx, bufGid_Dir, sizeof(bufGid_Dir), pszGid_Dir)  );
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pMrg->prbCSets, &bOK, &pszKey, (void **)&pMrgCSet_k)  );
+	while (bOK)
+	{
+		SG_ERR_CHECK(  SG_mrg_cset__load_unloaded_dir(pCtx, pMrgCSet_k, pRepo, bufGid_Dir)  );
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &bOK, &pszKey, (void **)&pMrgCSet_k)  );
+	}
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+}
+
+/**
+ * Find the entry with the given name in a loaded directory of the CSET.
+ * We don't have the hierarchial view yet, so this is a scan of the flat list.
+ */
+static void _sg_mrg__find_loaded_child_by_name(SG_context * pCtx,
+											   SG_mrg_cset * pMrgCSet,
+											   const char * pszGid_Dir,
+											   const char * pszEntryname,
+											   SG_mrg_cset_entry ** ppMrgCSetEntry_Child)
+{
+	SG_rbtree_iterator * pIter = NULL;
+	SG_mrg_cset_entry * pMrgCSetEntry_k;
+	SG_mrg_cset_entry * pMrgCSetEntry_Child = NULL;
+	const char * pszGid_k;
+	SG_bool bOK;
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pMrgCSet->prbEntries, &bOK, &pszGid_k, (void **)&pMrgCSetEntry_k)  );
+	while (bOK && !pMrgCSetEntry_Child)
+	{
+		if ((strcmp(pMrgCSetEntry_k->bufGid_Parent, pszGid_Dir) == 0)
+			&& (strcmp(SG_string__sz(pMrgCSetEntry_k->pStringEntryname), pszEntryname) == 0))
+			pMrgCSetEntry_Child = pMrgCSetEntry_k;
+		else
+			SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &bOK, &pszGid_k, (void **)&pMrgCSetEntry_k)  );
+	}
+
+	*ppMrgCSetEntry_Child = pMrgCSetEntry_Child;
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+}
+
+/**
+ * The dirt code (see _mrg__try_to_handle_dirt_cb__found()) needs to
+ * see the directory containing each FOUND item in the WD.  It can cope
+ * with a parent whose contents were not loaded (it reads the names from
+ * the parent's treenode), but not with a parent that is buried deeper
+ * inside an unloaded directory -- we don't even have an entry for it.
+ *
+ * So for each such FOUND item, walk its (baseline) repo-path down from
+ * the root and load the unloaded directories along the way.  This only
+ * loads the directories on the path, not everything beneath them.
+ */
+static void _sg_mrg__load_dirs_above_found_items(SG_context * pCtx,
+												 SG_mrg * pMrg,
+												 SG_repo * pRepo)
+{
+	SG_treediff2_iterator * pIter = NULL;
+	SG_string * pStrComponent = NULL;
+	SG_mrg_cset * pMrgCSet = pMrg->pMrgCSet_Baseline;
+	SG_mrg_cset_entry * pMrgCSetEntry_Child;
+	SG_treediff2_ObjectData * pOD;
+	const SG_treediff2_ObjectData * pOD_Parent;
+	const char * pszGid;
+	const char * pszGid_Parent;
+	const char * pszRepoPath;
+	const char * p;
+	const char * pSlash;
+	char bufGid_Dir[SG_GID_BUFFER_LENGTH];
+	SG_diffstatus_flags dsFlags;
+	SG_diffstatus_flags dsFlagsParent;
+	SG_bool bOK, bFound, bLoaded;
+
+	if (!pMrg->pTreeDiff_Baseline_WD_Dirt || !pMrgCSet || !pMrgCSet->prbUnloadedDirs)
+		return;
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pStrComponent)  );
+
+	SG_ERR_CHECK(  SG_treediff2__iterator__first(pCtx, pMrg->pTreeDiff_Baseline_WD_Dirt, &bOK, &pszGid, &pOD, &pIter)  );
+	while (bOK)
+	{
+		SG_ERR_CHECK(  SG_treediff2__ObjectData__get_dsFlags(pCtx, pOD, &dsFlags)  );
+		if (dsFlags & SG_DIFFSTATUS_FLAGS__FOUND)
+		{
+			SG_ERR_CHECK(  SG_treediff2__ObjectData__get_parent_gid(pCtx, pOD, &pszGid_Parent)  );
+			SG_ERR_CHECK(  SG_rbtree__find(pCtx, pMrgCSet->prbEntries, pszGid_Parent, &bLoaded, NULL)  );
+
+			// if the parent is itself FOUND, we do this for it instead.
+
+			dsFlagsParent = SG_DIFFSTATUS_FLAGS__ZERO;
+			if (!bLoaded)
+			{
+				SG_ERR_CHECK(  SG_treediff2__get_ObjectData(pCtx, pMrg->pTreeDiff_Baseline_WD_Dirt, pszGid_Parent,
+															&bFound, &pOD_Parent)  );
+				if (bFound)
+					SG_ERR_CHECK(  SG_treediff2__ObjectData__get_dsFlags(pCtx, pOD_Parent, &dsFlagsParent)  );
+			}
+
+			if (!bLoaded && ((dsFlagsParent & SG_DIFFSTATUS_FLAGS__FOUND) == 0))
+			{
+				// the repo-path looks like "@/a/b/c/<found-item>".  load "a", "a/b", and
+				// "a/b/c" as necessary.  stop early if we reach something that isn't under
+				// version control (a FOUND directory); the dirt code deals with those.
+
+				SG_ERR_CHECK(  SG_treediff2__ObjectData__get_repo_path(pCtx, pOD, &pszRepoPath)  );
+				SG_ERR_CHECK(  SG_strcpy(pCtx, bufGid_Dir, sizeof(bufGid_Dir), pMrgCSet->bufGid_Root)  );
+
+				p = pszRepoPath + 2;
+				while ((pSlash = strchr(p, '/')) != NULL)
+				{
+					SG_ERR_CHECK(  SG_rbtree__find(pCtx, pMrgCSet->prbUnloadedDirs, bufGid_Dir, &bFound, NULL)  );
+					if (bFound)
+						SG_ERR_CHECK(  _sg_mrg__load_unloaded_dir_in_all_csets(pCtx, pMrg, pRepo, bufGid_Dir)  );
+
+					SG_ERR_CHECK(  SG_string__set__buf_len(pCtx, pStrComponent, (const SG_byte *)p, (SG_uint32)(pSlash - p))  );
+					SG_ERR_CHECK(  _sg_mrg__find_loaded_child_by_name(pCtx, pMrgCSet, bufGid_Dir, SG_string__sz(pStrComponent), &pMrgCSetEntry_Child)  );
+					if (!pMrgCSetEntry_Child)
+						break;
+
+					SG_ERR_CHECK(  SG_strcpy(pCtx, bufGid_Dir, sizeof(bufGid_Dir), pMrgCSetEntry_Child->bufGid_Entry)  );
+					p = pSlash + 1;
+				}
+			}
+		}
+
+		SG_ERR_CHECK(  SG_treediff2__iterator__next(pCtx, pIter, &bOK, &pszGid, &pOD)  );
+	}
+
+fail:
+	SG_TREEDIFF2_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_STRING_NULLFREE(pCtx, pStrComponent);
+}
+
+/**
+ * All of the CSETs (leaves, SPCAs, and the LCA) were loaded lazily,
+ * so we only have the actual-root of each.  Load the contents of each
+ * directory *unless* the directory has the same treenode HID in all
+ * of the CSETs.
+ *
+ * The treenode HID covers everything within the directory, so when
+ * it is the same in all of them nothing inside could have changed in
+ * any branch and there is nothing there for the merge to compare or
+ * to put in the result.  The entry for the directory itself is still
+ * loaded (from its parent), so a rename/move/xattr change on it is
+ * still handled normally.  This keeps the cost of the merge proportional
+ * to what changed rather than to the size of the tree.
+ *
+ * We repeat until we don't load anything new.  If an entry was moved,
+ * the directory may not have been loaded yet in another CSET; we just
+ * load it (which is always safe).  When we are done, each unloaded
+ * directory is unloaded (with the same HID) in all of the CSETs.
+ *
+ * Finally, we load the directories above any FOUND items in the WD
+ * that are buried within an unloaded directory.
+ */
+static void _sg_mrg__load_changed_dirs(SG_context * pCtx,
+									   SG_mrg * pMrg)
+{
+	SG_rbtree_iterator * pIterCSet = NULL;
+	SG_rbtree_iterator * pIterDir = NULL;
+	SG_rbtree * prbToLoad = NULL;
+	SG_repo * pRepo;
+	SG_mrg_cset * pMrgCSet_k;
+	const char * pszKey;
+	const char * pszGid_Dir;
+	const char * pszHid_Treenode;
+	SG_bool bOK, bOKDir, bUnchanged;
+	SG_bool bLoadedSomething;
+
+	pMrg->nrDirsPruned = 0;
+	if (pMrg->bLoadEntireCSets)
+		return;
+
+	SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pMrg->pPendingTree, &pRepo)  );
+
+	do
+	{
+		bLoadedSomething = SG_FALSE;
+
+		SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIterCSet, pMrg->prbCSets, &bOK, &pszKey, (void **)&pMrgCSet_k)  );
+		while (bOK)
+		{
+			// loading a directory changes prbUnloadedDirs, so collect them first.
+
+			SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbToLoad)  );
+			SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIterDir, pMrgCSet_k->prbUnloadedDirs,
+													  &bOKDir, &pszGid_Dir, (void **)&pszHid_Treenode)  );
+			while (bOKDir)
+			{
+				SG_ERR_CHECK(  _sg_mrg__is_dir_unchanged_in_all_csets(pCtx, pMrg, pszGid_Dir, pszHid_Treenode, &bUnchanged)  );
+				if (!bUnchanged)
+					SG_ERR_CHECK(  SG_rbtree__add(pCtx, prbToLoad, pszGid_Dir)  );
+
+				SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIterDir, &bOKDir, &pszGid_Dir, (void **)&pszHid_Treenode)  );
+			}
+			SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIterDir);
+
+			SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIterDir, prbToLoad, &bOKDir, &pszGid_Dir, NULL)  );
+			while (bOKDir)
+			{
+				SG_ERR_CHECK(  SG_mrg_cset__load_unloaded_dir(pCtx, pMrgCSet_k, pRepo, pszGid_Dir)  );
+				bLoadedSomething = SG_TRUE;
+
+				SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIterDir, &bOKDir, &pszGid_Dir, NULL)  );
+			}
+			SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIterDir);
+			SG_RBTREE_NULLFREE(pCtx, prbToLoad);
+
+			SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIterCSet, &bOK, &pszKey, (void **)&pMrgCSet_k)  );
+		}
+		SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIterCSet);
+
+	} while (bLoadedSomething);
+
+	SG_ERR_CHECK(  _sg_mrg__load_dirs_above_found_items(pCtx, pMrg, pRepo)  );
+
+	// what is left is the same in all of them, so just count one.
+
+	if (pMrg->pMrgCSet_Baseline)
+		SG_ERR_CHECK(  SG_rbtree__count(pCtx, pMrg->pMrgCSet_Baseline->prbUnloadedDirs, &pMrg->nrDirsPruned)  );
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIterDir);
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIterCSet);
+	SG_RBTREE_NULLFREE(pCtx, prbToLoad);
+}
+
+//////////////////////////////////////////////////////////////////
+
 /**
  * Compute the MERGE using the given CSET and the BASELINE.
  * The LCA is computed and used as the Ancestor.  This builds
@@ -307,11 +600,13 @@ void SG_mrg__compute_merge_on_cset_with_baseline(SG_context * pCtx,
 	load_cset_data.pMrg = pMrg;
 	load_cset_data.kLeaves = 1;	// force required baseline to be L0 and label others starting with L1.
 
-	// load the complete version control tree of all of the CSETs (leaves, SPCAs, and the LCA)
+	// load the version control tree of all of the CSETs (leaves, SPCAs, and the LCA)
 	// into the CSET-RBTREE.  This converts the treenodes and treenode-entries into sg_mrg_cset_entry's
-	// and builds the flat entry-list in each CSET.
+	// and builds the flat entry-list in each CSET.  We skip the contents of directories
+	// that are identical in all of them.
 
 	SG_ERR_CHECK(  SG_daglca__foreach(pCtx,pMrg->pDagLca,SG_TRUE,_sg_mrg__daglca_callback__load_cset,&load_cset_data)  );
+	SG_ERR_CHECK(  _sg_mrg__load_changed_dirs(pCtx,pMrg)  );
 
 	SG_ASSERT(  (pMrg->pMrgCSet_LCA)  );
 	SG_ASSERT(  (pMrg->pMrgCSet_Baseline)  );
@@ -392,6 +687,7 @@ void SG_mrg__compute_n_way_merge_with_baseline(SG_context * pCtx, SG_mrg * pMrg,
 	// and builds the flat entry-list in each CSET.
 
 	SG_ERR_CHECK(  SG_daglca__foreach(pCtx,pMrg->pDagLca,SG_TRUE,_sg_mrg__daglca_callback__load_cset,&load_cset_data)  );
+	SG_ERR_CHECK(  _sg_mrg__load_changed_dirs(pCtx,pMrg)  );
 
 	SG_ASSERT(  (pMrg->pMrgCSet_LCA)  );
 	SG_ASSERT(  (pMrg->pMrgCSet_Baseline)  );
@@ -595,6 +891,28 @@ void SG_mrg__get_wd_issues__ref(SG_context * pCtx,
 
 //////////////////////////////////////////////////////////////////
 
+void SG_mrg_debug__set_load_entire_csets(SG_context * pCtx,
+										 SG_mrg * pMrg,
+										 SG_bool bLoadEntireCSets)
+{
+	SG_NULLARGCHECK_RETURN(pMrg);
+	SG_ARGCHECK_RETURN(  (pMrg->pDagLca == NULL), pMrg  );
+
+	pMrg->bLoadEntireCSets = bLoadEntireCSets;
+}
+
+void SG_mrg_debug__get_nr_dirs_pruned(SG_context * pCtx,
+									  const SG_mrg * pMrg,
+									  SG_uint32 * pNrDirsPruned)
+{
+	SG_NULLARGCHECK_RETURN(pMrg);
+	SG_NULLARGCHECK_RETURN(pNrDirsPruned);
+
+	*pNrDirsPruned = pMrg->nrDirsPruned;
+}
+
+//////////////////////////////////////////////////////////////////
+
 END_EXTERN_C;
 
 #endif//H_SG_MRG__PRIVATE_MRG_H
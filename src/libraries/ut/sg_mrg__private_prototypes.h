@@ -121,6 +121,29 @@ void SG_mrg_cset__load_entire_cset(SG_context * pCtx,
 								   SG_repo * pRepo,
 								   const char * pszHid_CSet);
 
+/**
+ * Begin loading the version control tree as of this CSET.
+ *
+ * This only loads the entry for the actual-root directory.  Each
+ * directory whose contents have not been loaded is listed (with the
+ * HID of its treenode) in SG_mrg_cset.prbUnloadedDirs; use
+ * SG_mrg_cset__load_unloaded_dir() to load them as needed.
+ */
+void SG_mrg_cset__load_lazy(SG_context * pCtx,
+							SG_mrg_cset * pMrgCSet,
+							SG_repo * pRepo,
+							const char * pszHid_CSet);
+
+/**
+ * Load the contents of a directory that was left in SG_mrg_cset.prbUnloadedDirs
+ * by SG_mrg_cset__load_lazy().  Any sub-directories within it are added to the
+ * unloaded list.
+ */
+void SG_mrg_cset__load_unloaded_dir(SG_context * pCtx,
+									SG_mrg_cset * pMrgCSet,
+									SG_repo * pRepo,
+									const char * pszGid_Dir);
+
 /**
  * Set the value of SG_mrg_cset_entry.markerValue to the given newValue
  * on all entries in the tree.
@@ -439,7 +462,7 @@ void SG_mrg__make_hid_blob_temp_file_pathname(SG_context * pCtx, SG_mrg * pMrg,
  *
  * You own the returned pathname and the file on disk.
  */
-void SG_mrg__export_to_temp_file(SG_context * pCtx, SG_mrg * pMrg,
+void SG_mrg__export_to_temp_file(SG_context * pCtx, SG_repo * pRepo,
 								 const char * pszHidBlob,
 								 const SG_pathname * pPathTempFile);
 
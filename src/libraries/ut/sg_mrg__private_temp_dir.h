@@ -222,12 +222,11 @@ fail:
  *
  * You own the returned pathname and the file on disk.
  */
-void SG_mrg__export_to_temp_file(SG_context * pCtx, SG_mrg * pMrg,
+void SG_mrg__export_to_temp_file(SG_context * pCtx, SG_repo * pRepo,
 								 const char * pszHidBlob,
 								 const SG_pathname * pPathTempFile)
 {
 	SG_file * pFile = NULL;
-	SG_repo * pRepo;
 	SG_bool bExists;
 
 	SG_ERR_CHECK(  SG_fsobj__exists__pathname(pCtx,pPathTempFile,&bExists,NULL,NULL)  );
@@ -246,7 +245,6 @@ void SG_mrg__export_to_temp_file(SG_context * pCtx, SG_mrg * pMrg,
 #endif
 
 		SG_ERR_CHECK(  SG_file__open__pathname(pCtx,pPathTempFile,SG_FILE_WRONLY|SG_FILE_CREATE_NEW,0400,&pFile)  );
-		SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pMrg->pPendingTree, &pRepo)  );
 		SG_ERR_CHECK(  SG_repo__fetch_blob_into_file(pCtx,pRepo,pszHidBlob,pFile,NULL)  );
 		SG_FILE_NULLCLOSE(pCtx,pFile);
 	}
@@ -151,6 +151,11 @@ typedef enum _sg_mrg_cset_origin	SG_mrg_cset_origin;
  * Later, we *MAY* build a hierarchial view of the tree using SG_mrg_cset_dir's
  * and .prgDirs.
  *
+ * When a CSET is loaded lazily (for a merge), the contents of some directories
+ * may never be loaded; those directories are listed in .prbUnloadedDirs.  The
+ * merge only leaves a directory unloaded when its treenode is identical in all
+ * of the CSETs involved, so none of them have the directory's contents.
+ *
  * We do remember some fields to help name/find the root node to help with some things.
  *
  * We keep a copy of the change-set's HID (which matches the key in SG_mrg->prbCSets
@@ -170,6 +175,8 @@ struct _sg_mrg_cset
 
 	SG_rbtree *						prbDeletes;				// map[<gid-entry> --> SG_mrg_cset_entry * ancestor]	we do not own these -- only defined when needed
 
+	SG_rbtree *						prbUnloadedDirs;		// map[<gid-entry> --> <hid-treenode>]  directories whose contents we have not loaded -- only defined when loading lazily
+
 	char							bufGid_Root[SG_GID_BUFFER_LENGTH];				// GID of the actual-root directory.
 	char							bufHid_CSet[SG_HID_MAX_BUFFER_LENGTH];			// HID of this CSET.  (will be empty for virtual CSETs)
 
@@ -349,6 +356,9 @@ struct _sg_mrg
 
 	char					bufGid_Temp[SG_GID_BUFFER_LENGTH];				// only needed when MERGE needs to TEMPORARILY
 	char					bufGid_Temp_ParkingLot[SG_GID_BUFFER_LENGTH];	// add .sgtemp and parkinglot to the pendingtree.
+
+	SG_bool					bLoadEntireCSets;				// debug: load everything rather than skipping unchanged directories
+	SG_uint32				nrDirsPruned;					// number of directories whose contents we did not load
 };
 
 //////////////////////////////////////////////////////////////////
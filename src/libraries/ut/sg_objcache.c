@@ -0,0 +1,428 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file sg_objcache.c
+ *
+ * @details A bounded LRU cache of decoded, frozen objects.
+ *
+ * Entries are found by key in an rbtree and are also kept on a
+ * doubly-linked list in order of use; the head is the most recently
+ * used and eviction takes from the tail.  The key is the type
+ * character followed by the HID.
+ *
+ * The cache holds one reference on each object it contains.  Hits add
+ * a reference for the caller.  Evicted objects are freed (which drops
+ * the cache's reference) after the cache lock has been released.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg.h>
+#include "sg_lib__private.h"
+
+//////////////////////////////////////////////////////////////////
+
+typedef struct _sg_objcache_entry sg_objcache_entry;
+
+struct _sg_objcache_entry
+{
+	char							bufKey[SG_HID_MAX_BUFFER_LENGTH + 1];
+	void *							pObj;
+	SG_uint32						size;
+	SG_objcache__addref_callback *	pfnAddref;
+	SG_free_callback *				pfnFree;
+
+	sg_objcache_entry *				pPrev;		// more recently used
+	sg_objcache_entry *				pNext;		// less recently used
+};
+
+struct _SG_objcache
+{
+	SG_mutex						lock;
+
+	SG_rbtree *						prbEntries;	// key --> sg_objcache_entry*
+	sg_objcache_entry *				pMRU;
+	sg_objcache_entry *				pLRU;
+
+	SG_uint64						max_bytes;
+	SG_uint32						max_count;
+	SG_uint64						cur_bytes;
+	SG_uint32						cur_count;
+
+	SG_uint32						nrHits;
+	SG_uint32						nrMisses;
+	SG_uint32						nrEvictions;
+};
+
+static struct
+{
+	SG_bool bInitialized;
+	SG_mutex lock;
+} gShares;
+
+//////////////////////////////////////////////////////////////////
+
+void sg_objcache__global_initialize(SG_context * pCtx)
+{
+	SG_UNUSED(pCtx);
+
+	if (gShares.bInitialized)
+		return;
+
+	SG_mutex__init(&gShares.lock);
+	gShares.bInitialized = SG_TRUE;
+}
+
+void sg_objcache__global_cleanup(SG_context * pCtx)
+{
+	SG_UNUSED(pCtx);
+
+	if (!gShares.bInitialized)
+		return;
+
+	SG_mutex__destroy(&gShares.lock);
+	gShares.bInitialized = SG_FALSE;
+}
+
+void SG_objcache__share(SG_uint32 * pnShares)
+{
+	if (gShares.bInitialized)
+		SG_mutex__lock(&gShares.lock);
+
+	(*pnShares)++;
+
+	if (gShares.bInitialized)
+		SG_mutex__unlock(&gShares.lock);
+}
+
+SG_bool SG_objcache__unshare(SG_uint32 * pnShares)
+{
+	SG_bool bStillShared = SG_FALSE;
+
+	// if there are no other references, the caller holds the only one
+	// and nobody else can be changing the count.
+	if (*pnShares == 0)
+		return SG_FALSE;
+
+	if (gShares.bInitialized)
+		SG_mutex__lock(&gShares.lock);
+
+	if (*pnShares > 0)
+	{
+		(*pnShares)--;
+		bStillShared = SG_TRUE;
+	}
+
+	if (gShares.bInitialized)
+		SG_mutex__unlock(&gShares.lock);
+
+	return bStillShared;
+}
+
+SG_bool SG_objcache__is_shared(const SG_uint32 * pnShares)
+{
+	return (*pnShares > 0);
+}
+
+//////////////////////////////////////////////////////////////////
+
+static void _make_key(SG_context * pCtx, SG_objcache_type type, const char * pszHid, char * bufKey)
+{
+	SG_uint32 len = (SG_uint32)strlen(pszHid);
+
+	if (len + 2 > SG_HID_MAX_BUFFER_LENGTH + 1)
+		SG_ERR_THROW2_RETURN(  SG_ERR_INVALIDARG, (pCtx, "HID too long for object cache: %s", pszHid)  );
+
+	bufKey[0] = (char)type;
+	memcpy(&bufKey[1], pszHid, len + 1);
+}
+
+static void _unlink(SG_objcache * pCache, sg_objcache_entry * pEntry)
+{
+	if (pEntry->pPrev)
+		pEntry->pPrev->pNext = pEntry->pNext;
+	else
+		pCache->pMRU = pEntry->pNext;
+
+	if (pEntry->pNext)
+		pEntry->pNext->pPrev = pEntry->pPrev;
+	else
+		pCache->pLRU = pEntry->pPrev;
+
+	pEntry->pPrev = NULL;
+	pEntry->pNext = NULL;
+}
+
+static void _push_front(SG_objcache * pCache, sg_objcache_entry * pEntry)
+{
+	pEntry->pPrev = NULL;
+	pEntry->pNext = pCache->pMRU;
+
+	if (pCache->pMRU)
+		pCache->pMRU->pPrev = pEntry;
+	else
+		pCache->pLRU = pEntry;
+
+	pCache->pMRU = pEntry;
+}
+
+/**
+ * Free a chain of entries (linked through pNext) which have already
+ * been removed from the cache.  This drops the cache's reference on
+ * each object.  Call this without holding the cache lock.
+ */
+static void _free_chain(SG_context * pCtx, sg_objcache_entry * pChain)
+{
+	while (pChain)
+	{
+		sg_objcache_entry * pNext = pChain->pNext;
+
+		pChain->pfnFree(pCtx, pChain->pObj);
+		SG_NULLFREE(pCtx, pChain);
+
+		pChain = pNext;
+	}
+}
+
+/**
+ * Take entries off the LRU end until there is room for one more
+ * entry of the given size.  The removed entries are chained onto
+ * *ppChain for the caller to free after unlocking.
+ */
+static void _evict(SG_context * pCtx, SG_objcache * pCache, SG_uint32 size_needed, sg_objcache_entry ** ppChain)
+{
+	while (pCache->pLRU
+		   && ((pCache->cur_count + 1 > pCache->max_count)
+			   || (pCache->cur_bytes + size_needed > pCache->max_bytes)))
+	{
+		sg_objcache_entry * pVictim = pCache->pLRU;
+
+		SG_ERR_CHECK_RETURN(  SG_rbtree__remove(pCtx, pCache->prbEntries, pVictim->bufKey)  );
+		_unlink(pCache, pVictim);
+
+		pCache->cur_count--;
+		pCache->cur_bytes -= pVictim->size;
+		pCache->nrEvictions++;
+
+		pVictim->pNext = *ppChain;
+		*ppChain = pVictim;
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+
+void SG_objcache__alloc(SG_context * pCtx,
+						SG_objcache ** ppNew,
+						SG_uint64 max_bytes,
+						SG_uint32 max_count)
+{
+	SG_objcache * pCache = NULL;
+
+	SG_NULLARGCHECK_RETURN(ppNew);
+
+	SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pCache)  );
+	SG_mutex__init(&pCache->lock);
+
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &pCache->prbEntries)  );
+	pCache->max_bytes = max_bytes;
+	pCache->max_count = max_count;
+
+	*ppNew = pCache;
+	return;
+
+fail:
+	SG_OBJCACHE_NULLFREE(pCtx, pCache);
+}
+
+void SG_objcache__free(SG_context * pCtx, SG_objcache * pCache)
+{
+	if (!pCache)
+		return;
+
+	// all of the entries are on the list, so chain them up through
+	// pNext and drop the cache's references.
+	_free_chain(pCtx, pCache->pMRU);
+
+	SG_RBTREE_NULLFREE(pCtx, pCache->prbEntries);
+	SG_mutex__destroy(&pCache->lock);
+
+	SG_NULLFREE(pCtx, pCache);
+}
+
+void SG_objcache__lookup(SG_context * pCtx,
+						 SG_objcache * pCache,
+						 SG_objcache_type type,
+						 const char * pszHid,
+						 void ** ppObj)
+{
+	char bufKey[SG_HID_MAX_BUFFER_LENGTH + 1];
+	sg_objcache_entry * pEntry = NULL;
+	SG_bool bFound = SG_FALSE;
+	SG_bool bLocked = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pCache);
+	SG_NULLARGCHECK_RETURN(pszHid);
+	SG_NULLARGCHECK_RETURN(ppObj);
+
+	*ppObj = NULL;
+
+	SG_ERR_CHECK_RETURN(  _make_key(pCtx, type, pszHid, bufKey)  );
+
+	SG_mutex__lock(&pCache->lock);
+	bLocked = SG_TRUE;
+
+	SG_ERR_CHECK(  SG_rbtree__find(pCtx, pCache->prbEntries, bufKey, &bFound, (void **)&pEntry)  );
+	if (bFound)
+	{
+		pCache->nrHits++;
+
+		_unlink(pCache, pEntry);
+		_push_front(pCache, pEntry);
+
+		// add the caller's reference while we still hold the lock,
+		// so that the entry can't be evicted and freed out from
+		// under us.
+		pEntry->pfnAddref(pCtx, pEntry->pObj);
+		*ppObj = pEntry->pObj;
+	}
+	else
+	{
+		pCache->nrMisses++;
+	}
+
+fail:
+	if (bLocked)
+		SG_mutex__unlock(&pCache->lock);
+}
+
+void SG_objcache__add(SG_context * pCtx,
+					  SG_objcache * pCache,
+					  SG_objcache_type type,
+					  const char * pszHid,
+					  void * pObj,
+					  SG_uint32 size,
+					  SG_objcache__addref_callback * pfnAddref,
+					  SG_free_callback * pfnFree)
+{
+	sg_objcache_entry * pEntry = NULL;
+	sg_objcache_entry * pChainEvicted = NULL;
+	SG_bool bFound = SG_FALSE;
+	SG_bool bLocked = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pCache);
+	SG_NULLARGCHECK_RETURN(pszHid);
+	SG_NULLARGCHECK_RETURN(pObj);
+	SG_NULLARGCHECK_RETURN(pfnAddref);
+	SG_NULLARGCHECK_RETURN(pfnFree);
+
+	// something bigger than the whole cache would just push
+	// everything else out.
+	if (size > pCache->max_bytes || pCache->max_count == 0)
+		return;
+
+	SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pEntry)  );
+	SG_ERR_CHECK(  _make_key(pCtx, type, pszHid, pEntry->bufKey)  );
+	pEntry->pObj = pObj;
+	pEntry->size = size;
+	pEntry->pfnAddref = pfnAddref;
+	pEntry->pfnFree = pfnFree;
+
+	SG_mutex__lock(&pCache->lock);
+	bLocked = SG_TRUE;
+
+	// another caller may have loaded and added the same object
+	// while we were loading ours.  theirs wins.
+	SG_ERR_CHECK(  SG_rbtree__find(pCtx, pCache->prbEntries, pEntry->bufKey, &bFound, NULL)  );
+	if (!bFound)
+	{
+		SG_ERR_CHECK(  _evict(pCtx, pCache, size, &pChainEvicted)  );
+		SG_ERR_CHECK(  SG_rbtree__add__with_assoc(pCtx, pCache->prbEntries, pEntry->bufKey, pEntry)  );
+
+		_push_front(pCache, pEntry);
+		pCache->cur_count++;
+		pCache->cur_bytes += size;
+
+		pfnAddref(pCtx, pObj);
+		pEntry = NULL;
+	}
+
+	// fall thru
+
+fail:
+	if (bLocked)
+		SG_mutex__unlock(&pCache->lock);
+	SG_NULLFREE(pCtx, pEntry);
+	_free_chain(pCtx, pChainEvicted);
+}
+
+void SG_objcache__clear(SG_context * pCtx, SG_objcache * pCache)
+{
+	sg_objcache_entry * pChain = NULL;
+	SG_rbtree * prbNew = NULL;
+
+	SG_NULLARGCHECK_RETURN(pCache);
+
+	SG_ERR_CHECK_RETURN(  SG_RBTREE__ALLOC(pCtx, &prbNew)  );
+
+	SG_mutex__lock(&pCache->lock);
+
+	pChain = pCache->pMRU;
+	pCache->pMRU = NULL;
+	pCache->pLRU = NULL;
+	pCache->cur_count = 0;
+	pCache->cur_bytes = 0;
+
+	SG_RBTREE_NULLFREE(pCtx, pCache->prbEntries);
+	pCache->prbEntries = prbNew;
+
+	SG_mutex__unlock(&pCache->lock);
+
+	_free_chain(pCtx, pChain);
+}
+
+void SG_objcache__get_stats(SG_context * pCtx, SG_objcache * pCache, SG_vhash ** ppvhStats)
+{
+	SG_vhash * pvh = NULL;
+	SG_uint32 nrHits, nrMisses, nrEvictions, cur_count;
+	SG_uint64 cur_bytes;
+
+	SG_NULLARGCHECK_RETURN(pCache);
+	SG_NULLARGCHECK_RETURN(ppvhStats);
+
+	SG_mutex__lock(&pCache->lock);
+	nrHits = pCache->nrHits;
+	nrMisses = pCache->nrMisses;
+	nrEvictions = pCache->nrEvictions;
+	cur_count = pCache->cur_count;
+	cur_bytes = pCache->cur_bytes;
+	SG_mutex__unlock(&pCache->lock);
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "hits", (SG_int64)nrHits)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "misses", (SG_int64)nrMisses)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "evictions", (SG_int64)nrEvictions)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "count", (SG_int64)cur_count)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "bytes", (SG_int64)cur_bytes)  );
+
+	*ppvhStats = pvh;
+	return;
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvh);
+}
@@ -216,6 +216,8 @@ struct _SG_pendingtree
 
 	SG_bool bDebugExport;	// true if we are in __export_to_vhash and want extra info
 
+	struct _pt_sd_prescan *		pScanPrescan;	// set only while a recursive scan-dir is walking the ptnodes
+
 #if STATS_TIMESTAMP_CACHE
 	struct
 	{
@@ -223,6 +225,13 @@ struct _SG_pendingtree
 		SG_uint32 nr_queries;
 	} trace_timestamp_cache;
 #endif
+
+	// always kept; see SG_pendingtree_debug__get_dir_cache_stats().
+	struct
+	{
+		SG_uint32 nr_valid;
+		SG_uint32 nr_queries;
+	} stats_dir_cache;
 };
 
 //////////////////////////////////////////////////////////////////
@@ -1352,9 +1361,11 @@ void SG_pendingtree__save(
 							   pPendingTree->b_pvh_wd__timestamps__dirty)  );
 #endif
 #if STATS_TIMESTAMP_CACHE
-	SG_ERR_IGNORE(  SG_console(pCtx, SG_CS_STDERR, "SG_pendingtree__save: timestamp cache stats: %d / %d\n",
+	SG_ERR_IGNORE(  SG_console(pCtx, SG_CS_STDERR, "SG_pendingtree__save: timestamp cache stats: %d / %d [directories %d / %d]\n",
 							   pPendingTree->trace_timestamp_cache.nr_valid,
-							   pPendingTree->trace_timestamp_cache.nr_queries)  );
+							   pPendingTree->trace_timestamp_cache.nr_queries,
+							   pPendingTree->stats_dir_cache.nr_valid,
+							   pPendingTree->stats_dir_cache.nr_queries)  );
 #endif
 
 	// update the "pending" sub-vhash based upon our in-memory pending tree.
@@ -5855,6 +5866,19 @@ fail:
 
 //////////////////////////////////////////////////////////////////
 
+void SG_pendingtree_debug__get_dir_cache_stats(SG_context * pCtx,
+												const SG_pendingtree * pPendingTree,
+												SG_uint32 * pNrValid,
+												SG_uint32 * pNrQueries)
+{
+	SG_NULLARGCHECK_RETURN(pPendingTree);
+
+	if (pNrValid)
+		*pNrValid = pPendingTree->stats_dir_cache.nr_valid;
+	if (pNrQueries)
+		*pNrQueries = pPendingTree->stats_dir_cache.nr_queries;
+}
+
 void SG_pendingtree_debug__get_wd_dot_json_stats(SG_context * pCtx,
 												 const SG_pathname * pPathWorkingDir,
 												 SG_uint32 * pNrParents,
@@ -6034,6 +6058,18 @@ void SG_pendingtree__clear_wd_timestamp_cache(SG_context * pCtx,
 	{
 		SG_ERR_CHECK_RETURN(  SG_vhash__remove(pCtx, pPendingTree->pvh_wd, "timestamps")  );
 
+#if defined(DEBUG)
+		pPendingTree->b_pvh_wd__timestamps__dirty = SG_TRUE;
+#endif
+	}
+
+	// the directory cache only means something alongside the file cache.
+
+	SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pPendingTree->pvh_wd, "dirstamps", &bFound)  );
+	if (bFound)
+	{
+		SG_ERR_CHECK_RETURN(  SG_vhash__remove(pCtx, pPendingTree->pvh_wd, "dirstamps")  );
+
 #if defined(DEBUG)
 		pPendingTree->b_pvh_wd__timestamps__dirty = SG_TRUE;
 #endif
@@ -6306,6 +6342,143 @@ fail:
 	return;
 }
 
+//////////////////////////////////////////////////////////////////
+
+void SG_pendingtree__set_wd_dir_timestamp__dont_save_pendingtree(SG_context * pCtx,
+																 SG_pendingtree * pPendingTree,
+																 const char * pszGid,
+																 SG_int64 mtime_ms,
+																 const char * pszDigest,
+																 const char * pszSpecDigest)
+{
+	// pendingtree.dirstamps.<gid>.mtime_ms = <mtime_ms>
+	// pendingtree.dirstamps.<gid>.clock_ms = <now_ms>
+	// pendingtree.dirstamps.<gid>.digest   = <digest>
+	// pendingtree.dirstamps.<gid>.spec     = <spec-digest>   (optional)
+
+	SG_vhash * pvhDirstamps_Allocated = NULL;
+	SG_vhash * pvhDirstamps;
+	SG_vhash * pvhGid = NULL;
+	SG_int64 iTimeNow;
+	SG_bool bFound;
+
+	SG_NULLARGCHECK_RETURN(pPendingTree);
+	SG_NONEMPTYCHECK_RETURN(pszGid);
+	SG_NONEMPTYCHECK_RETURN(pszDigest);
+
+	SG_ASSERT(  (pPendingTree->pvh_wd)  );
+
+	SG_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &iTimeNow)  );
+
+#if TRACE_TIMESTAMP_CACHE
+	SG_ERR_IGNORE(  SG_console(pCtx, SG_CS_STDERR,
+							   "set_wd_dir_timestamp: [gid %s][digest %s]\n",
+							   pszGid, pszDigest)  );
+#endif
+
+	SG_ERR_CHECK(  SG_vhash__has(pCtx, pPendingTree->pvh_wd, "dirstamps", &bFound)  );
+	if (bFound)
+	{
+		SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pPendingTree->pvh_wd, "dirstamps", &pvhDirstamps)  );
+	}
+	else
+	{
+		SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhDirstamps_Allocated)  );
+		pvhDirstamps = pvhDirstamps_Allocated;
+		SG_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pPendingTree->pvh_wd, "dirstamps", &pvhDirstamps_Allocated)  );	// this steals the vhash
+	}
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhGid)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhGid, "mtime_ms", mtime_ms)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhGid, "clock_ms", iTimeNow)  );
+	SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvhGid, "digest", pszDigest)  );
+	if (pszSpecDigest)
+		SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvhGid, "spec", pszSpecDigest)  );
+	SG_ERR_CHECK(  SG_vhash__update__vhash(pCtx, pvhDirstamps, pszGid, &pvhGid)  );	// this steals our vhash
+
+#if defined(DEBUG)
+	pPendingTree->b_pvh_wd__timestamps__dirty = SG_TRUE;
+#endif
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvhDirstamps_Allocated);
+	SG_VHASH_NULLFREE(pCtx, pvhGid);
+}
+
+void SG_pendingtree__is_wd_dir_timestamp_valid(SG_context * pCtx,
+											   SG_pendingtree * pPendingTree,
+											   const char * pszGid,
+											   SG_int64 mtime_ms_observed_now,
+											   const char * pszDigest,
+											   const char * pszSpecDigest,
+											   SG_bool * pbResult)
+{
+	SG_vhash * pvhDirstamps;
+	SG_vhash * pvhGid;
+	const char * pszDigest_cached;
+	const char * pszSpecDigest_cached = NULL;
+	SG_int64 mtime_ms_cached;
+	SG_int64 clock_ms_cached;
+	SG_int64 iTimeNow;
+	SG_bool bFound;
+
+	SG_NULLARGCHECK_RETURN(pPendingTree);
+	SG_NONEMPTYCHECK_RETURN(pszGid);
+	SG_NONEMPTYCHECK_RETURN(pszDigest);
+	SG_NULLARGCHECK_RETURN(pbResult);
+
+	SG_ASSERT(  (pPendingTree->pvh_wd)  );
+
+	*pbResult = SG_FALSE;
+
+	pPendingTree->stats_dir_cache.nr_queries++;
+
+	SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pPendingTree->pvh_wd, "dirstamps", &bFound)  );
+	if (!bFound)
+		return;
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__vhash(pCtx, pPendingTree->pvh_wd, "dirstamps", &pvhDirstamps)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pvhDirstamps, pszGid, &bFound)  );
+	if (!bFound)
+		return;
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__vhash(pCtx, pvhDirstamps, pszGid, &pvhGid)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvhGid, "mtime_ms", &mtime_ms_cached)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvhGid, "clock_ms", &clock_ms_cached)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvhGid, "digest", &pszDigest_cached)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pvhGid, "spec", &bFound)  );
+	if (bFound)
+		SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvhGid, "spec", &pszSpecDigest_cached)  );
+
+	// the set of things we know about in the directory has changed.
+
+	if (strcmp(pszDigest, pszDigest_cached) != 0)
+		return;
+
+	// the directory had entries that the file-spec told us to skip
+	// and we are now looking at it with a different file-spec.
+
+	if (pszSpecDigest_cached && (!pszSpecDigest || (strcmp(pszSpecDigest, pszSpecDigest_cached) != 0)))
+		return;
+
+	// something was created, removed or renamed in the directory.
+
+	if (mtime_ms_observed_now != mtime_ms_cached)
+		return;
+
+	// the same "grey area" rules as in SG_pendingtree__is_wd_file_timestamp_valid()
+	// apply here.  if the directory could have changed within the same
+	// second that we recorded it, don't trust it.
+
+	SG_ERR_CHECK_RETURN(  SG_time__get_milliseconds_since_1970_utc(pCtx, &iTimeNow)  );
+	if (iTimeNow <= clock_ms_cached)
+		return;
+	if ((clock_ms_cached / 1000) - (mtime_ms_cached / 1000) <= 0)
+		return;
+
+	pPendingTree->stats_dir_cache.nr_valid++;
+
+	*pbResult = SG_TRUE;
+}
+
 
 static void sg_ptnode__remove_safely(SG_context* pCtx,
 									 struct sg_ptnode* ptn,
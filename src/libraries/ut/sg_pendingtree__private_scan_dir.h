@@ -72,6 +72,8 @@ struct _pt_sd
 
 	SG_rbtree *				prbEntriesOnDisk;	// map[<entryname> --> _pt_sd_entry *]      we own this
 	SG_pathname *			pPathDirectory;		// we own this
+
+	SG_uint32				nrUnclaimed;		// entries on disk not claimed by a ptnode
 };
 
 //////////////////////////////////////////////////////////////////
@@ -252,6 +254,193 @@ static void _pt_sd__read_directory(SG_context * pCtx,
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * Compute a digest of what the pendingtree knows about the directory:
+ * the type, name and deleted-ness of each of its (non-phantom) ptnodes.
+ * If this changes, anything we cached about the directory is stale.
+ *
+ * You own the returned digest.
+ */
+static void _pt_sd__compute_dir_digest(SG_context * pCtx,
+									   struct _pt_sd * pData,
+									   char ** ppszDigest)
+{
+	SG_string * pString = NULL;
+	SG_rbtree_iterator * pIter = NULL;
+	struct sg_ptnode * ptnSub;
+	const char * pszName;
+	SG_bool b;
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pString)  );
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pData->ptnDirectory->prbItems, &b, NULL, (void **)&ptnSub)  );
+	while (b)
+	{
+		if ((ptnSub->saved_flags & sg_PTNODE_SAVED_FLAG_MOVED_AWAY) == 0)
+		{
+			SG_ERR_CHECK(  sg_ptnode__get_name(pCtx, ptnSub, &pszName)  );
+			SG_ERR_CHECK(  SG_string__append__format(pCtx, pString, "%d %d %s\n",
+													 (int)ptnSub->type,
+													 ((ptnSub->saved_flags & sg_PTNODE_SAVED_FLAG_DELETED) != 0),
+													 pszName)  );
+		}
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, NULL, (void **)&ptnSub)  );
+	}
+
+	SG_ERR_CHECK(  SG_repo__alloc_compute_hash__from_string(pCtx, pData->pPendingTree->pRepo, pString, ppszDigest)  );
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_STRING_NULLFREE(pCtx, pString);
+}
+
+/**
+ * Compute a digest of the Ignore/Include/Exclude rules that we were given.
+ *
+ * You own the returned digest.
+ */
+static void _pt_sd__compute_spec_digest(SG_context * pCtx,
+										struct _pt_sd * pData,
+										char ** ppszDigest)
+{
+	SG_string * pString = NULL;
+	SG_uint32 k;
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pString)  );
+
+	for (k=0; k<pData->countIncludes; k++)
+		SG_ERR_CHECK(  SG_string__append__format(pCtx, pString, "i %s\n", pData->pszIncludes[k])  );
+	for (k=0; k<pData->countExcludes; k++)
+		SG_ERR_CHECK(  SG_string__append__format(pCtx, pString, "e %s\n", pData->pszExcludes[k])  );
+	for (k=0; k<pData->countIgnores; k++)
+		SG_ERR_CHECK(  SG_string__append__format(pCtx, pString, "g %s\n", pData->pszIgnores[k])  );
+
+	SG_ERR_CHECK(  SG_repo__alloc_compute_hash__from_string(pCtx, pData->pPendingTree->pRepo, pString, ppszDigest)  );
+
+fail:
+	SG_STRING_NULLFREE(pCtx, pString);
+}
+
+/**
+ * The directory cache says that the set of entries on disk hasn't changed
+ * since the last time we accounted for all of them, so build the list of
+ * entries from the ptnodes instead of reading the directory.  We still
+ * stat each item so that we see changes to file contents and attributes.
+ *
+ * If anything doesn't look the way the cache promised, we set *pbValid
+ * to false and the caller should read the directory the normal way.
+ */
+static void _pt_sd__read_directory__from_ptnodes(SG_context * pCtx,
+												 struct _pt_sd * pData,
+												 SG_bool * pbValid)
+{
+	SG_rbtree_iterator * pIter = NULL;
+	struct sg_ptnode * ptnSub;
+	struct _pt_sd_entry * pEntry = NULL;
+	const char * pszName;
+	SG_fsobj_stat fsStat;
+	SG_bool bAlready;
+	SG_bool b;
+
+	*pbValid = SG_FALSE;
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pData->ptnDirectory->prbItems, &b, NULL, (void **)&ptnSub)  );
+	while (b)
+	{
+		if ((ptnSub->saved_flags & (sg_PTNODE_SAVED_FLAG_MOVED_AWAY | sg_PTNODE_SAVED_FLAG_DELETED)) == 0)
+		{
+			SG_ERR_CHECK(  sg_ptnode__get_name(pCtx, ptnSub, &pszName)  );
+			SG_ERR_CHECK(  SG_rbtree__find(pCtx, pData->prbEntriesOnDisk, pszName, &bAlready, NULL)  );
+			if (bAlready)
+				goto done;
+
+			SG_ERR_CHECK(  SG_alloc1(pCtx, pEntry)  );
+			SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pEntry->pPath, pData->pPathDirectory, pszName)  );
+
+			SG_fsobj__stat__pathname(pCtx, pEntry->pPath, &fsStat);
+			if (SG_context__has_err(pCtx))
+			{
+				// it's gone.  the directory should have looked different.
+				SG_context__err_reset(pCtx);
+				goto done;
+			}
+
+			SG_ERR_CHECK(  sg_pendingtree__fsobjtype_to_treenodeentrytype(pCtx, fsStat.type, &pEntry->tneType)  );
+			if (pEntry->tneType == SG_TREENODEENTRY_TYPE_REGULAR_FILE)
+				pEntry->mtime_ms = fsStat.mtime_ms;
+			pEntry->bMatched = SG_FALSE;
+
+			SG_ERR_CHECK(  SG_rbtree__add__with_assoc(pCtx, pData->prbEntriesOnDisk, pszName, (void *)pEntry)  );
+			pEntry = NULL;		// pData->prbEntriesOnDisk now owns it
+		}
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, NULL, (void **)&ptnSub)  );
+	}
+
+	*pbValid = SG_TRUE;
+
+done:
+	;
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_ERR_IGNORE(  _pt_sd_entry__free(pCtx, pEntry)  );
+}
+
+/**
+ * The directory cache is valid and the pre-scan has already read the
+ * directory.  Make sure that the listing has exactly one entry for each
+ * of the ptnodes; this is what _pt_sd__read_directory__from_ptnodes()
+ * would have found out by stat'ing them.
+ *
+ * If it doesn't, we set *pbValid to false and the caller should treat
+ * the listing as a normal read of the directory.
+ */
+static void _pt_sd__check_listing_against_ptnodes(SG_context * pCtx,
+												  struct _pt_sd * pData,
+												  SG_rbtree * prbListing,
+												  SG_bool * pbValid)
+{
+	SG_rbtree_iterator * pIter = NULL;
+	struct sg_ptnode * ptnSub;
+	struct _pt_sd_entry * pEntry;
+	const char * pszName;
+	SG_bool bFound;
+	SG_bool b;
+
+	*pbValid = SG_FALSE;
+
+	// we borrow bMatched to catch two ptnodes with the same name.
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pData->ptnDirectory->prbItems, &b, NULL, (void **)&ptnSub)  );
+	while (b)
+	{
+		if ((ptnSub->saved_flags & (sg_PTNODE_SAVED_FLAG_MOVED_AWAY | sg_PTNODE_SAVED_FLAG_DELETED)) == 0)
+		{
+			SG_ERR_CHECK(  sg_ptnode__get_name(pCtx, ptnSub, &pszName)  );
+			SG_ERR_CHECK(  SG_rbtree__find(pCtx, prbListing, pszName, &bFound, (void **)&pEntry)  );
+			if (!bFound || pEntry->bMatched)
+				goto done;
+			pEntry->bMatched = SG_TRUE;
+		}
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, NULL, (void **)&ptnSub)  );
+	}
+
+	*pbValid = SG_TRUE;
+
+done:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, prbListing, &b, NULL, (void **)&pEntry)  );
+	while (b)
+	{
+		pEntry->bMatched = SG_FALSE;
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, NULL, (void **)&pEntry)  );
+	}
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+}
+
+//////////////////////////////////////////////////////////////////
+
 /**
  * Open the given pathname and compute the HID on the current contents.
  *
@@ -277,6 +466,443 @@ fail:
 	SG_FILE_NULLCLOSE(pCtx, pFile);
 }
 
+//////////////////////////////////////////////////////////////////
+
+/**
+ * The parallel pre-scan.
+ *
+ * Nearly all of the time in a big scan goes to reading directories,
+ * stat'ing their entries and hashing the files that changed.  None of
+ * that needs the ptnodes, so a recursive scan hands it to a pool of
+ * threads:
+ *
+ * [1] Before we walk the ptnodes, the threads read the tree on disk.
+ *     Each one takes a directory off a work queue, reads (and stats)
+ *     it and queues the subdirectories that the walk would dive into.
+ *
+ * [2] The walk takes each directory's listing from the pre-scan rather
+ *     than reading it, and rather than hashing a file that changed it
+ *     queues it up.  The threads hash the queue while the walk goes on.
+ *
+ * [3] When the walk is done and the queue is empty, we store the HIDs
+ *     in the ptnodes.
+ *
+ * Only the caller's thread touches the ptnodes, the strpool and the
+ * timestamp caches.  The pre-scan is nothing more than a cache: if
+ * a thread could not read a directory, the walk reads it in the usual
+ * way; if a thread could not hash a file, we hash it again in [3] so
+ * that the error is reported the way it always was.
+ */
+
+#define PT_SD__MAX_THREADS		8
+
+struct _pt_sd_dirlist
+{
+	SG_int64				mtime_ms;			// mtime of the directory, from before we read it
+	SG_rbtree *				prbEntries;			// map[<entryname> --> _pt_sd_entry *]      we own this
+};
+
+struct _pt_sd_hashjob
+{
+	struct sg_ptnode *		ptnSub;				// we do not own this
+	SG_pathname *			pPath;				// we own this
+	SG_int64				mtime_ms;
+	char *					pszHid;				// we own this.  null until hashed (or if hashing failed).
+};
+
+struct _pt_sd_prescan
+{
+	SG_pendingtree *		pPendingTree;		// we do not own this.  the threads only look at pRepo and pPathWorkingDirectoryTop.
+	SG_uint32				countIncludes;
+	SG_uint32				countExcludes;
+	SG_uint32				countIgnores;
+	const char * const*		pszIncludes;		// we do not own this
+	const char * const*		pszExcludes;		// we do not own this
+	const char * const*		pszIgnores;			// we do not own this
+
+	SG_work_queue *			pQueueDirs;			// items are SG_pathname * of directories to read; the worker frees them
+	SG_work_queue *			pQueueHash;			// items are struct _pt_sd_hashjob *
+
+	SG_mutex				mtx;				// protects prbDirs while the directories are being read
+	SG_rbtree *				prbDirs;			// map[<directory path> --> _pt_sd_dirlist *]
+
+	struct _pt_sd_hashjob **	apJobs;			// only the walk's thread touches this array
+	SG_uint32				nrJobs;
+	SG_uint32				nrJobsAllocated;
+};
+
+static void _pt_sd_dirlist__free(SG_context * pCtx, struct _pt_sd_dirlist * pDirList)
+{
+	if (!pDirList)
+		return;
+
+	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pDirList->prbEntries, (SG_free_callback *)_pt_sd_entry__free);
+	SG_NULLFREE(pCtx, pDirList);
+}
+
+static void _pt_sd_prescan__free(SG_context * pCtx, struct _pt_sd_prescan * pPrescan)
+{
+	SG_uint32 k;
+
+	if (!pPrescan)
+		return;
+
+	// this stops any threads that are still running.
+	SG_WORK_QUEUE_NULLFREE(pCtx, pPrescan->pQueueDirs);
+	SG_WORK_QUEUE_NULLFREE(pCtx, pPrescan->pQueueHash);
+
+	for (k=0; k<pPrescan->nrJobs; k++)
+	{
+		SG_PATHNAME_NULLFREE(pCtx, pPrescan->apJobs[k]->pPath);
+		SG_NULLFREE(pCtx, pPrescan->apJobs[k]->pszHid);
+		SG_NULLFREE(pCtx, pPrescan->apJobs[k]);
+	}
+	SG_NULLFREE(pCtx, pPrescan->apJobs);
+
+	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pPrescan->prbDirs, (SG_free_callback *)_pt_sd_dirlist__free);
+	SG_mutex__destroy(&pPrescan->mtx);
+	SG_NULLFREE(pCtx, pPrescan);
+}
+
+/**
+ * Queue a directory to be read.  We take ownership of the pathname
+ * (and null your pointer) only if we succeed.
+ */
+static void _pt_sd_prescan__push_dir(SG_context * pCtx,
+									 struct _pt_sd_prescan * pPrescan,
+									 SG_pathname ** ppPathDir)
+{
+	SG_ERR_CHECK_RETURN(  SG_work_queue__add(pCtx, pPrescan->pQueueDirs, (void *)*ppPathDir)  );
+	*ppPathDir = NULL;
+}
+
+/**
+ * Read and stat one directory and queue the subdirectories that the walk
+ * would dive into.  This uses the same file-spec evaluation as
+ * _pt_sd__create_new_ptnode_for_unclaimed_entry_cb() so that we skip the
+ * same IGNORED/EXCLUDED directories that it does.  (If we guess wrong,
+ * we only waste a little time or leave a directory for the walk to read.)
+ *
+ * This runs on a pre-scan thread.  It must not touch the ptnodes.
+ */
+static void _pt_sd_prescan__read_one_dir(SG_context * pCtx,
+										 struct _pt_sd_prescan * pPrescan,
+										 SG_pathname * pPathDir)
+{
+	struct _pt_sd pt_sd;
+	struct _pt_sd_dirlist * pDirList = NULL;
+	struct _pt_sd_entry * pEntry;
+	SG_rbtree_iterator * pIter = NULL;
+	SG_string * pStringRepoPath = NULL;
+	SG_pathname * pPathSub = NULL;
+	SG_fsobj_stat fsStatDir;
+	SG_file_spec_eval eval;
+	SG_bool b;
+
+	memset(&pt_sd, 0, sizeof(pt_sd));
+	pt_sd.pPendingTree  = pPrescan->pPendingTree;
+	pt_sd.bRecursive    = SG_TRUE;
+	pt_sd.pszIncludes   = pPrescan->pszIncludes;
+	pt_sd.countIncludes = pPrescan->countIncludes;
+	pt_sd.pszExcludes   = pPrescan->pszExcludes;
+	pt_sd.countExcludes = pPrescan->countExcludes;
+	pt_sd.pszIgnores    = pPrescan->pszIgnores;
+	pt_sd.countIgnores  = pPrescan->countIgnores;
+	pt_sd.pPathDirectory = pPathDir;		// we borrow this
+
+	// stat the directory before reading it (see _pt_sd__scan_one_dir()).
+
+	SG_ERR_CHECK(  SG_fsobj__stat__pathname(pCtx, pPathDir, &fsStatDir)  );
+	if (fsStatDir.type != SG_FSOBJ_TYPE__DIRECTORY)
+		goto done;
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pDirList)  );
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &pDirList->prbEntries)  );
+	pDirList->mtime_ms = fsStatDir.mtime_ms;
+
+	pt_sd.prbEntriesOnDisk = pDirList->prbEntries;
+	SG_ERR_CHECK(  SG_dir__foreach(pCtx, pPathDir, SG_TRUE, _pt_sd__read_directory_cb, (void *)&pt_sd)  );
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, pDirList->prbEntries, &b, NULL, (void **)&pEntry)  );
+	while (b)
+	{
+		if (pEntry->tneType == SG_TREENODEENTRY_TYPE_DIRECTORY)
+		{
+			SG_ERR_CHECK(  SG_workingdir__wdpath_to_repopath(pCtx, pPrescan->pPendingTree->pPathWorkingDirectoryTop, pEntry->pPath, SG_TRUE, &pStringRepoPath)  );
+			SG_ERR_CHECK(  _pt_sd__file_spec__should_include(pCtx, &pt_sd, SG_string__sz(pStringRepoPath), &eval)  );
+			SG_STRING_NULLFREE(pCtx, pStringRepoPath);
+
+			if ((eval != SG_FILE_SPEC_EVAL__EXPLICITLY_EXCLUDED) && (eval != SG_FILE_SPEC_EVAL__EXPLICITLY_IGNORED))
+			{
+				SG_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pPathSub, pEntry->pPath)  );
+				SG_ERR_CHECK(  _pt_sd_prescan__push_dir(pCtx, pPrescan, &pPathSub)  );
+			}
+		}
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, NULL, (void **)&pEntry)  );
+	}
+
+	SG_mutex__lock(&pPrescan->mtx);
+	SG_rbtree__add__with_assoc(pCtx, pPrescan->prbDirs, SG_pathname__sz(pPathDir), (void *)pDirList);
+	SG_mutex__unlock(&pPrescan->mtx);
+	SG_ERR_CHECK_CURRENT;
+	pDirList = NULL;		// pPrescan->prbDirs now owns it
+
+done:
+	;
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_STRING_NULLFREE(pCtx, pStringRepoPath);
+	SG_PATHNAME_NULLFREE(pCtx, pPathSub);
+	SG_ERR_IGNORE(  _pt_sd_dirlist__free(pCtx, pDirList)  );
+}
+
+/**
+ * SG_work_queue__callback for pQueueDirs.
+ *
+ * Nothing in here is fatal.  A directory that we could not read is simply
+ * missing from prbDirs.
+ */
+static void _pt_sd_prescan__read_dir_cb(SG_context * pCtx,
+										SG_uint32 kThread,
+										void * pVoidData,
+										void * pVoidItem)
+{
+	struct _pt_sd_prescan * pPrescan = (struct _pt_sd_prescan *)pVoidData;
+	SG_pathname * pPathDir = (SG_pathname *)pVoidItem;
+
+	SG_UNUSED(kThread);
+
+	SG_ERR_IGNORE(  _pt_sd_prescan__read_one_dir(pCtx, pPrescan, pPathDir)  );
+	SG_PATHNAME_NULLFREE(pCtx, pPathDir);
+}
+
+/**
+ * SG_work_queue__callback for pQueueHash.
+ *
+ * If a file can't be hashed, we leave its HID null and the caller's
+ * thread tries again so that it can report the error.
+ */
+static void _pt_sd_prescan__hash_file_cb(SG_context * pCtx,
+										 SG_uint32 kThread,
+										 void * pVoidData,
+										 void * pVoidItem)
+{
+	struct _pt_sd_prescan * pPrescan = (struct _pt_sd_prescan *)pVoidData;
+	struct _pt_sd_hashjob * pJob = (struct _pt_sd_hashjob *)pVoidItem;
+
+	SG_UNUSED(kThread);
+
+	SG_ERR_IGNORE(  _pt__compute_file_hid(pCtx, pPrescan->pPendingTree->pRepo, pJob->pPath, &pJob->pszHid)  );
+}
+
+/**
+ * Set up a pre-scan of the tree rooted at pPathTop and wait while the
+ * threads read it.  When we return, every directory that could be read
+ * is in prbDirs and the threads are waiting for hash jobs.
+ *
+ * If this machine doesn't have the processors for it, *ppPrescan is set
+ * to null and the scan should just do everything on this thread.
+ */
+static void _pt_sd_prescan__start(SG_context * pCtx,
+								  SG_pendingtree * pPendingTree,
+								  const SG_pathname * pPathTop,
+								  const char* const* pszIncludes, SG_uint32 count_includes,
+								  const char* const* pszExcludes, SG_uint32 count_excludes,
+								  const char* const* pszIgnores,  SG_uint32 count_ignores,
+								  struct _pt_sd_prescan ** ppPrescan)
+{
+	struct _pt_sd_prescan * pPrescan = NULL;
+	SG_pathname * pPath = NULL;
+	SG_uint32 nrThreads = 0;
+
+	*ppPrescan = NULL;
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pPrescan)  );
+	SG_mutex__init(&pPrescan->mtx);
+
+	pPrescan->pPendingTree  = pPendingTree;
+	pPrescan->pszIncludes   = pszIncludes;
+	pPrescan->countIncludes = count_includes;
+	pPrescan->pszExcludes   = pszExcludes;
+	pPrescan->countExcludes = count_excludes;
+	pPrescan->pszIgnores    = pszIgnores;
+	pPrescan->countIgnores  = count_ignores;
+
+	SG_ERR_CHECK(  SG_work_queue__alloc(pCtx, PT_SD__MAX_THREADS, 0, SG_WORK_QUEUE_FLAGS__NONE,
+										_pt_sd_prescan__read_dir_cb, (void *)pPrescan, &pPrescan->pQueueDirs)  );
+	SG_ERR_CHECK(  SG_work_queue__get_thread_count(pCtx, pPrescan->pQueueDirs, &nrThreads)  );
+	if (nrThreads == 0)
+		goto fail;		// not worth it; nothing has gone wrong.
+
+	SG_ERR_CHECK(  SG_work_queue__alloc(pCtx, PT_SD__MAX_THREADS, 0, SG_WORK_QUEUE_FLAGS__NONE,
+										_pt_sd_prescan__hash_file_cb, (void *)pPrescan, &pPrescan->pQueueHash)  );
+
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &pPrescan->prbDirs)  );
+	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pPath, pPathTop)  );
+	SG_ERR_CHECK(  _pt_sd_prescan__push_dir(pCtx, pPrescan, &pPath)  );
+
+	// the reading threads queue the subdirectories as they find them.
+
+	SG_ERR_CHECK(  SG_work_queue__wait(pCtx, pPrescan->pQueueDirs)  );
+	SG_ERR_CHECK(  SG_work_queue__finish(pCtx, pPrescan->pQueueDirs)  );
+	SG_WORK_QUEUE_NULLFREE(pCtx, pPrescan->pQueueDirs);
+
+	*ppPrescan = pPrescan;
+	pPrescan = NULL;
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+	SG_ERR_IGNORE(  _pt_sd_prescan__free(pCtx, pPrescan)  );
+}
+
+/**
+ * Give the walk the listing that the pre-scan made for this directory,
+ * if there is one.  You own the result.
+ */
+static void _pt_sd_prescan__take_dir(SG_context * pCtx,
+									 struct _pt_sd_prescan * pPrescan,
+									 const SG_pathname * pPathDir,
+									 struct _pt_sd_dirlist ** ppDirList)
+{
+	struct _pt_sd_dirlist * pDirList = NULL;
+	SG_bool bFound;
+
+	*ppDirList = NULL;
+
+	// the reading is done, so nobody else is looking at prbDirs.
+
+	SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx, pPrescan->prbDirs, SG_pathname__sz(pPathDir), &bFound, NULL)  );
+	if (bFound)
+	{
+		SG_ERR_CHECK_RETURN(  SG_rbtree__remove__with_assoc(pCtx, pPrescan->prbDirs, SG_pathname__sz(pPathDir), (void **)&pDirList)  );
+		*ppDirList = pDirList;
+	}
+}
+
+/**
+ * Queue a file to be hashed by the pre-scan threads.
+ */
+static void _pt_sd_prescan__add_hash_job(SG_context * pCtx,
+										 struct _pt_sd_prescan * pPrescan,
+										 struct sg_ptnode * ptnSub,
+										 const struct _pt_sd_entry * pEntry)
+{
+	struct _pt_sd_hashjob ** apNew = NULL;
+	struct _pt_sd_hashjob * pJob = NULL;
+	SG_uint32 nrNew;
+
+	if (pPrescan->nrJobs == pPrescan->nrJobsAllocated)
+	{
+		nrNew = ((pPrescan->nrJobsAllocated) ? (2 * pPrescan->nrJobsAllocated) : 256);
+		SG_ERR_CHECK(  SG_allocN(pCtx, nrNew, apNew)  );
+		if (pPrescan->nrJobs)
+			memcpy(apNew, pPrescan->apJobs, pPrescan->nrJobs * sizeof(struct _pt_sd_hashjob *));
+		SG_NULLFREE(pCtx, pPrescan->apJobs);
+		pPrescan->apJobs = apNew;
+		pPrescan->nrJobsAllocated = nrNew;
+	}
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pJob)  );
+	pJob->ptnSub   = ptnSub;
+	pJob->mtime_ms = pEntry->mtime_ms;
+	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pJob->pPath, pEntry->pPath)  );
+
+	// once it is in apJobs, _pt_sd_prescan__free() owns it.
+	pPrescan->apJobs[pPrescan->nrJobs++] = pJob;
+	SG_ERR_CHECK_RETURN(  SG_work_queue__add(pCtx, pPrescan->pQueueHash, (void *)pJob)  );
+	return;
+
+fail:
+	if (pJob)
+	{
+		SG_PATHNAME_NULLFREE(pCtx, pJob->pPath);
+		SG_NULLFREE(pCtx, pJob);
+	}
+}
+
+/**
+ * Store a freshly computed HID for the file's content in the ptnode and
+ * remember the mtime that it goes with in the timestamp cache.
+ */
+static void _pt_sd__set_file_hid(SG_context * pCtx,
+								 SG_pendingtree * pPendingTree,
+								 struct sg_ptnode * ptnSub,
+								 SG_int64 mtime_ms,
+								 const char * pszHid_now_current)
+{
+	const char * pszHid_baseline = NULL;
+
+	if (ptnSub->pBaselineEntry)
+		SG_ERR_CHECK_RETURN(  SG_treenode_entry__get_hid_blob(pCtx, ptnSub->pBaselineEntry, &pszHid_baseline)  );
+
+	if (pszHid_baseline && (strcmp(pszHid_now_current, pszHid_baseline) == 0))
+	{
+		// something like a '/usr/bin/touch' or they undid any changes to the file.
+
+		ptnSub->pszCurrentHid = NULL;
+	}
+	else if ((ptnSub->pszCurrentHid == NULL) || (strcmp(pszHid_now_current, ptnSub->pszCurrentHid) != 0))
+	{
+		// set new unique hid value.  (avoid overwriting same value.)
+		SG_ERR_CHECK_RETURN(  SG_strpool__add__sz(pCtx, pPendingTree->pStrPool, pszHid_now_current, &ptnSub->pszCurrentHid)  );
+	}
+
+	SG_ERR_CHECK_RETURN(  SG_pendingtree__set_wd_file_timestamp__dont_save_pendingtree(pCtx,
+																					   pPendingTree,
+																					   ptnSub->pszgid,
+																					   mtime_ms)  );
+}
+
+/**
+ * The walk is done.  Wait for the threads to hash what is left in the
+ * queue and then store the HIDs in the ptnodes.
+ */
+static void _pt_sd_prescan__finish(SG_context * pCtx, struct _pt_sd_prescan * pPrescan)
+{
+	struct _pt_sd_hashjob * pJob;
+	SG_uint32 k;
+
+	SG_ERR_CHECK_RETURN(  SG_work_queue__finish(pCtx, pPrescan->pQueueHash)  );
+
+	for (k=0; k<pPrescan->nrJobs; k++)
+	{
+		pJob = pPrescan->apJobs[k];
+
+		// if a thread couldn't hash it, try again here so that we throw
+		// whatever error we would have thrown without the pre-scan.
+
+		if (!pJob->pszHid)
+			SG_ERR_CHECK_RETURN(  _pt__compute_file_hid(pCtx, pPrescan->pPendingTree->pRepo, pJob->pPath, &pJob->pszHid)  );
+		SG_ERR_CHECK_RETURN(  _pt_sd__set_file_hid(pCtx, pPrescan->pPendingTree, pJob->ptnSub, pJob->mtime_ms, pJob->pszHid)  );
+	}
+}
+
+/**
+ * The file's content may have changed, so compute its HID and store it.
+ * During a pre-scan, we just queue the file up and the HID is stored when
+ * the walk is done.
+ */
+static void _pt_sd__rehash_file(SG_context * pCtx,
+								struct _pt_sd * pData,
+								struct sg_ptnode * ptnSub,
+								struct _pt_sd_entry * pEntry)
+{
+	char * pszHid_now_current = NULL;
+
+	if (pData->pPendingTree->pScanPrescan)
+	{
+		SG_ERR_CHECK(  _pt_sd_prescan__add_hash_job(pCtx, pData->pPendingTree->pScanPrescan, ptnSub, pEntry)  );
+	}
+	else
+	{
+		SG_ERR_CHECK(  _pt__compute_file_hid(pCtx, pData->pPendingTree->pRepo, pEntry->pPath, &pszHid_now_current)  );
+		SG_ERR_CHECK(  _pt_sd__set_file_hid(pCtx, pData->pPendingTree, ptnSub, pEntry->mtime_ms, pszHid_now_current)  );
+	}
+
+fail:
+	SG_NULLFREE(pCtx, pszHid_now_current);
+}
+
 /**
  * Our caller is trying to fill in the "current" fields in the ptnode
  * so that later we can see if any of them are different from the "baseline"
@@ -325,12 +951,12 @@ static void _pt_sd__update_ptnode__file_content(SG_context * pCtx,
 {
 	char * pszHid_now_current = NULL;
 	const char * pszHid_baseline = NULL;
-	SG_fsobj_stat stat_now_current;
 	SG_bool bCachedTimeValid = SG_FALSE;
 
 	SG_ASSERT(  (ptnSub->type == SG_TREENODEENTRY_TYPE_REGULAR_FILE)  );
 
-	SG_ERR_CHECK(  SG_fsobj__stat__pathname(pCtx, pEntry->pPath, &stat_now_current)  );
+	// pEntry->mtime_ms came from the stat we did when we read the
+	// directory (or the ptnodes), so we don't stat the file again here.
 
 	if ((ptnSub->pBaselineEntry == NULL) && (ptnSub->pszCurrentHid == NULL))
 	{
@@ -345,12 +971,7 @@ static void _pt_sd__update_ptnode__file_content(SG_context * pCtx,
 								   SG_pathname__sz(pEntry->pPath))  );
 #endif
 
-		SG_ERR_CHECK(  _pt__compute_file_hid(pCtx, pData->pPendingTree->pRepo, pEntry->pPath, &pszHid_now_current)  );
-		SG_ERR_CHECK(  SG_strpool__add__sz(pCtx, pData->pPendingTree->pStrPool, pszHid_now_current, &ptnSub->pszCurrentHid)  );
-		SG_ERR_CHECK(  SG_pendingtree__set_wd_file_timestamp__dont_save_pendingtree(pCtx,
-																					pData->pPendingTree,
-																					ptnSub->pszgid,
-																					stat_now_current.mtime_ms)  );
+		SG_ERR_CHECK(  _pt_sd__rehash_file(pCtx, pData, ptnSub, pEntry)  );
 		goto done;
 	}
 
@@ -358,7 +979,7 @@ static void _pt_sd__update_ptnode__file_content(SG_context * pCtx,
 		SG_ERR_CHECK(  SG_treenode_entry__get_hid_blob(pCtx, ptnSub->pBaselineEntry, &pszHid_baseline)  );
 
 	SG_ERR_CHECK(  SG_pendingtree__is_wd_file_timestamp_valid(pCtx, pData->pPendingTree, ptnSub->pszgid,
-															  stat_now_current.mtime_ms,
+															  pEntry->mtime_ms,
 															  &bCachedTimeValid)  );
 	if (bCachedTimeValid)
 	{
@@ -411,23 +1032,7 @@ static void _pt_sd__update_ptnode__file_content(SG_context * pCtx,
 #endif
 		// mtime has changed on file since our last run or the cache was invalid.
 
-		SG_ERR_CHECK(  _pt__compute_file_hid(pCtx, pData->pPendingTree->pRepo, pEntry->pPath, &pszHid_now_current)  );
-		if (pszHid_baseline && (strcmp(pszHid_now_current, pszHid_baseline) == 0))
-		{
-			// something like a '/usr/bin/touch' or they undid any changes to the file.
-
-			ptnSub->pszCurrentHid = NULL;
-		}
-		else if ((ptnSub->pszCurrentHid == NULL) || (strcmp(pszHid_now_current, ptnSub->pszCurrentHid) != 0))
-		{
-			// set new unique hid value.  (avoid overwriting same value.)
-			SG_ERR_CHECK(  SG_strpool__add__sz(pCtx, pData->pPendingTree->pStrPool, pszHid_now_current, &ptnSub->pszCurrentHid)  );
-		}
-
-		SG_ERR_CHECK(  SG_pendingtree__set_wd_file_timestamp__dont_save_pendingtree(pCtx,
-																					pData->pPendingTree,
-																					ptnSub->pszgid,
-																					stat_now_current.mtime_ms)  );
+		SG_ERR_CHECK(  _pt_sd__rehash_file(pCtx, pData, ptnSub, pEntry)  );
 	}
 
 done:
@@ -652,6 +1257,28 @@ static void _pt_sd__inspect_child_ptnode_cb(SG_context * pCtx, const char * pszK
 		return;
 	}
 
+	// look up the entryname in the directory on disk.
+
+	SG_ERR_CHECK(  SG_rbtree__find(pCtx,pData->prbEntriesOnDisk,pszEntryName,&bFoundOnDisk,(void **)&pEntry)  );
+
+	if (((ptnSub->saved_flags & sg_PTNODE_SAVED_FLAG_DELETED) == 0)
+		&& (bFoundOnDisk) && (pEntry->tneType == ptnSub->type))
+	{
+		// this is by far the most common case: we think the item is present and
+		// there is an entry on disk with the same ENTRYNAME and the same type.
+		// we have to ASSUME that they should be associated with each other.
+		//
+		// TODO i'm going to assume that we always update the ptnode regardless of
+		// TODO the Ignore/Include/Exclude status.  that is, the --include is meant
+		// TODO for add/remove and not is-dirty.  so we don't bother evaluating the
+		// TODO file-spec here.
+
+		SG_ERR_CHECK(  _pt_sd__update_ptnode(pCtx,pData,ptnSub,pEntry)  );
+
+		pEntry->bMatched = SG_TRUE;
+		return;
+	}
+
 	// Compute the absolute path and repo-path for this ptnode (without regard for whether
 	// it currently exists on disk) and see if it matches any of the Ignore/Include/Exclude
 	// rules.
@@ -671,10 +1298,6 @@ static void _pt_sd__inspect_child_ptnode_cb(SG_context * pCtx, const char * pszK
 							   eval)  );
 #endif
 
-	// look up the entryname in the directory on disk.
-
-	SG_ERR_CHECK(  SG_rbtree__find(pCtx,pData->prbEntriesOnDisk,pszEntryName,&bFoundOnDisk,(void **)&pEntry)  );
-
 	if (ptnSub->saved_flags & sg_PTNODE_SAVED_FLAG_DELETED)
 	{
 		// this ptnode currently thinks the item has been deleted, but there is an apparent match for it
@@ -731,22 +1354,6 @@ static void _pt_sd__inspect_child_ptnode_cb(SG_context * pCtx, const char * pszK
 	}
 	else							// we currently think the item is present
 	{
-		if ((bFoundOnDisk) && (pEntry->tneType == ptnSub->type))
-		{
-			// TODO i'm going to assume that we always update the ptnode regardless of
-			// TODO the Ignore/Include/Exclude status.  that is, the --include is meant
-			// TODO for add/remove and not is-dirty.
-
-			SG_ERR_CHECK(  _pt_sd__update_ptnode(pCtx,pData,ptnSub,pEntry)  );
-
-			// this PTNODE has a correspeonding ENTRY on disk with the same ENTRYNAME
-			// AND they have the same type.  we have to ASSUME that they should be
-			// associated with each other.
-
-			pEntry->bMatched = SG_TRUE;
-			return;
-		}
-
 		// either there is no entry with this entryname on disk or the type of the entry on
 		// disk is different than what we were expecting.
 		//
@@ -808,6 +1415,8 @@ static void _pt_sd__create_new_ptnode_for_unclaimed_entry_cb(SG_context * pCtx,
 	if (pEntry->bMatched)
 		return;
 
+	pData->nrUnclaimed++;
+
 	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathSub, pData->pPathDirectory, pszKey_EntryName)  );
 	SG_ERR_CHECK(  SG_fsobj__stat__pathname(pCtx, pPathSub, &fsStat)  );
 	SG_ERR_CHECK(  SG_workingdir__wdpath_to_repopath(pCtx, pData->pPendingTree->pPathWorkingDirectoryTop, pPathSub, SG_TRUE, &pStringRepoPath)  );
@@ -919,6 +1528,9 @@ fail:
 //////////////////////////////////////////////////////////////////
 
 /**
+ * Scan one directory (and, if bRecursive, everything under it).  See
+ * sg_pendingtree__scan_dir().
+ *
  * The job of the "scan" operation is to fix the pending tree to match
  * the working directory.  Flags allow the caller to control whether
  * we want everything to be included or maybe we just want to scan for
@@ -926,8 +1538,20 @@ fail:
  *
  * When used for the purpose of a command like 'sg status', we expect
  * that the resulting pending tree will not be saved to disk.
+ *
+ * We keep a directory-level cache (the "dirstamps" in wd.json) next to
+ * the file timestamp cache.  When a scan accounts for every entry in a
+ * directory without having to create any new ptnodes, we remember the
+ * directory's mtime and a digest of its ptnodes.  When both still match
+ * on a later scan, the set of entries on disk can't have changed, so we
+ * stat the items we already know about rather than reading the directory
+ * and evaluating the unclaimed entries again.  Anything unexpected falls
+ * back to the full scan.
+ *
+ * During a pre-scan, the directory has (probably) already been read for
+ * us and changed files are hashed later; see _pt_sd_prescan__start().
  */
-static void sg_pendingtree__scan_dir(SG_context* pCtx,
+static void _pt_sd__scan_one_dir(SG_context* pCtx,
 									 SG_pendingtree* pPendingTree,
 									 SG_pathname* pPathLocalDirectory,
 									 const SG_bool bAddRemove,
@@ -939,7 +1563,14 @@ static void sg_pendingtree__scan_dir(SG_context* pCtx,
 									 const char* const* pszIgnores,  SG_uint32 count_ignores)
 {
 	struct _pt_sd pt_sd;
+	struct _pt_sd_dirlist * pDirList = NULL;
 	struct sg_ptnode * ptn = NULL;
+	SG_fsobj_stat fsStatDir;
+	char * pszDigest = NULL;
+	char * pszSpecDigest = NULL;
+	SG_uint32 nrItemsBefore = 0;
+	SG_uint32 nrItemsAfter = 0;
+	SG_bool bCacheValid = SG_FALSE;
 	SG_bool bExists;
 	SG_bool bIsDirectory;
 
@@ -977,16 +1608,57 @@ static void sg_pendingtree__scan_dir(SG_context* pCtx,
 	pt_sd.ptnDirectory	   = ptn;
 	pt_sd.prbEntriesOnDisk = NULL;
 	pt_sd.pPathDirectory   = NULL;
+	pt_sd.nrUnclaimed      = 0;
 	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &pt_sd.prbEntriesOnDisk)	);
 	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pt_sd.pPathDirectory, pPathLocalDirectory)  );
 
-	// Read the contents of the directory as it currently exists on disk (if it exists).
+	// See if the directory cache lets us skip reading the directory.  We stat
+	// the directory before reading it, so that if it changes while we're
+	// looking, the mtime we cache is already out of date.  (The pre-scan
+	// does the same.)
 
+	if (pPendingTree->pScanPrescan)
+		SG_ERR_CHECK(  _pt_sd_prescan__take_dir(pCtx, pPendingTree->pScanPrescan, pt_sd.pPathDirectory, &pDirList)  );
+	if (pDirList)
+		fsStatDir.mtime_ms = pDirList->mtime_ms;
+	else
+		SG_ERR_CHECK(  SG_fsobj__stat__pathname(pCtx, pt_sd.pPathDirectory, &fsStatDir)  );
+	SG_ERR_CHECK(  _pt_sd__compute_dir_digest(pCtx, &pt_sd, &pszDigest)  );
+	SG_ERR_CHECK(  _pt_sd__compute_spec_digest(pCtx, &pt_sd, &pszSpecDigest)  );
+	SG_ERR_CHECK(  SG_pendingtree__is_wd_dir_timestamp_valid(pCtx, pPendingTree, ptn->pszgid,
+															 fsStatDir.mtime_ms, pszDigest, pszSpecDigest,
+															 &bCacheValid)  );
+	if (pDirList)
+	{
+		// the pre-scan has already read the directory.  either way, the
+		// listing is what's on disk.
 
-	SG_ERR_CHECK(  _pt_sd__read_directory(pCtx, &pt_sd, &bExists, &bIsDirectory)  );
+		if (bCacheValid)
+			SG_ERR_CHECK(  _pt_sd__check_listing_against_ptnodes(pCtx, &pt_sd, pDirList->prbEntries, &bCacheValid)  );
 
-	SG_ASSERT(	(bExists)  );		// TODO these are only needed for top-level call because
-	SG_ASSERT(	(bIsDirectory)	);	// TODO all of the recursive calls should be correct.
+		SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pt_sd.prbEntriesOnDisk, (SG_free_callback *)_pt_sd_entry__free);
+		pt_sd.prbEntriesOnDisk = pDirList->prbEntries;
+		pDirList->prbEntries = NULL;
+	}
+	else if (bCacheValid)
+	{
+		SG_ERR_CHECK(  _pt_sd__read_directory__from_ptnodes(pCtx, &pt_sd, &bCacheValid)  );
+		if (!bCacheValid)
+		{
+			SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pt_sd.prbEntriesOnDisk, (SG_free_callback *)_pt_sd_entry__free);
+			SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &pt_sd.prbEntriesOnDisk)	);
+		}
+	}
+
+	if (!bCacheValid && !pDirList)
+	{
+		// Read the contents of the directory as it currently exists on disk (if it exists).
+
+		SG_ERR_CHECK(  _pt_sd__read_directory(pCtx, &pt_sd, &bExists, &bIsDirectory)  );
+
+		SG_ASSERT(	(bExists)  );		// TODO these are only needed for top-level call because
+		SG_ASSERT(	(bIsDirectory)	);	// TODO all of the recursive calls should be correct.
+	}
 
 	// Iterate over all of the PTNODES (indexed by GID rather than ENTRYNAME) for this directory.
 	// Match up the ptnodes with an ENTRY in the prbEntriesOnDisk and do the right thing.  This
@@ -995,14 +1667,79 @@ static void sg_pendingtree__scan_dir(SG_context* pCtx,
 	SG_ERR_CHECK(  SG_rbtree__foreach(pCtx, ptn->prbItems, _pt_sd__inspect_child_ptnode_cb, (void *)&pt_sd)	 );
 
 	// Iterate over all of the ENTRIES that we found in the directory and deal with the "unclaimed" ones.
-	// This handled entries that were added
+	// This handled entries that were added.  (When the directory cache was valid, there aren't any.)
 
-	if (bAddRemove)
+	if (bAddRemove && !bCacheValid)
+	{
+		SG_ERR_CHECK(  SG_rbtree__count(pCtx, ptn->prbItems, &nrItemsBefore)  );
 		SG_ERR_CHECK(  SG_rbtree__foreach(pCtx, pt_sd.prbEntriesOnDisk, _pt_sd__create_new_ptnode_for_unclaimed_entry_cb, (void *)&pt_sd)  );
+		SG_ERR_CHECK(  SG_rbtree__count(pCtx, ptn->prbItems, &nrItemsAfter)  );
+
+		if (nrItemsAfter == nrItemsBefore)
+		{
+			// every entry on disk was either claimed by a ptnode or skipped
+			// because of the file-spec.  remember that.
+
+			SG_NULLFREE(pCtx, pszDigest);
+			SG_ERR_CHECK(  _pt_sd__compute_dir_digest(pCtx, &pt_sd, &pszDigest)  );
+			SG_ERR_CHECK(  SG_pendingtree__set_wd_dir_timestamp__dont_save_pendingtree(pCtx, pPendingTree, ptn->pszgid,
+																					   fsStatDir.mtime_ms, pszDigest,
+																					   ((pt_sd.nrUnclaimed > 0) ? pszSpecDigest : NULL))  );
+		}
+	}
 
 fail:
+	SG_NULLFREE(pCtx, pszDigest);
+	SG_NULLFREE(pCtx, pszSpecDigest);
 	SG_PATHNAME_NULLFREE(pCtx, pt_sd.pPathDirectory);
 	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pt_sd.prbEntriesOnDisk, (SG_free_callback *)_pt_sd_entry__free);
+	SG_ERR_IGNORE(  _pt_sd_dirlist__free(pCtx, pDirList)  );
+}
+
+/**
+ * Scan the given directory.  A recursive scan starts a pre-scan, which
+ * reads the tree and hashes changed files on a pool of threads, and then
+ * walks the ptnodes on this thread; see _pt_sd_prescan__start().  The
+ * recursion (and a non-recursive scan) goes straight to _pt_sd__scan_one_dir().
+ */
+static void sg_pendingtree__scan_dir(SG_context* pCtx,
+									 SG_pendingtree* pPendingTree,
+									 SG_pathname* pPathLocalDirectory,
+									 const SG_bool bAddRemove,
+									 const SG_bool bMarkImplicit,
+									 SG_bool bRecursive,
+									 struct sg_ptnode* ptn_given,
+									 const char* const* pszIncludes, SG_uint32 count_includes,	// TODO 2010/06/03 psz is not right
+									 const char* const* pszExcludes, SG_uint32 count_excludes,	// TODO            for a char **
+									 const char* const* pszIgnores,  SG_uint32 count_ignores)
+{
+	struct _pt_sd_prescan * pPrescan = NULL;
+
+	if (bRecursive && !pPendingTree->pScanPrescan)
+		SG_ERR_CHECK(  _pt_sd_prescan__start(pCtx, pPendingTree, pPathLocalDirectory,
+											  pszIncludes, count_includes,
+											  pszExcludes, count_excludes,
+											  pszIgnores,  count_ignores,
+											  &pPrescan)  );
+
+	if (pPrescan)
+		pPendingTree->pScanPrescan = pPrescan;
+
+	SG_ERR_CHECK(  _pt_sd__scan_one_dir(pCtx, pPendingTree, pPathLocalDirectory,
+										bAddRemove, bMarkImplicit, bRecursive, ptn_given,
+										pszIncludes, count_includes,
+										pszExcludes, count_excludes,
+										pszIgnores,  count_ignores)  );
+
+	if (pPrescan)
+		SG_ERR_CHECK(  _pt_sd_prescan__finish(pCtx, pPrescan)  );
+
+fail:
+	if (pPrescan)
+	{
+		pPendingTree->pScanPrescan = NULL;
+		SG_ERR_IGNORE(  _pt_sd_prescan__free(pCtx, pPrescan)  );
+	}
 }
 
 //////////////////////////////////////////////////////////////////
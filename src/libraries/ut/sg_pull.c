@@ -16,8 +16,6 @@ limitations under the License.
 
 #include <sg.h>
 
-#define GENERATIONS_PER_ROUNDTRIP 100
-
 #define TRACE_PULL 0
 
 /* This exists primarily as a convenience so policy/credential data can be added to it later. 
@@ -116,6 +114,30 @@ fail:
 	_NULLFREE_INSTANCE_DATA(pCtx, pMe);
 }
 
+/**
+ * Request a fragball and stage it as it arrives.
+ */
+static void _request_fragball_into_staging(SG_context* pCtx,
+										   SG_client* pClient,
+										   SG_vhash* pvhRequest,
+										   SG_staging* pStaging,
+										   SG_vhash** ppvhRequestStatus)
+{
+	SG_writestream* pStream = NULL;
+
+	SG_ERR_CHECK(  SG_staging__open_fragball_writestream(pCtx, pStaging, &pStream)  );
+	SG_ERR_CHECK(  SG_client__pull_request_fragball__stream(pCtx, pClient, pvhRequest, pStream, ppvhRequestStatus)  );
+
+	SG_writestream__close(pCtx, pStream);
+	pStream = NULL;
+	SG_ERR_CHECK_CURRENT;
+
+	/* fall through */
+fail:
+	if (pStream)
+		SG_ERR_IGNORE(  SG_writestream__close(pCtx, pStream)  );
+}
+
 static void _add_dagnodes_until_connected(SG_context* pCtx, 
 										  SG_vhash** ppvhStagingStatus, 
 										  sg_pull_instance_data* pMe, 
@@ -123,11 +145,8 @@ static void _add_dagnodes_until_connected(SG_context* pCtx,
 {
 	SG_bool disconnected = SG_FALSE;
 	SG_vhash* pvhFragballRequest = NULL;
-	char* pszFragballName = NULL;
 	SG_vhash* pvhRequestStatus = NULL;
-	const SG_pathname* pStagingPathname;
-
-	SG_ERR_CHECK(  SG_staging__get_pathname(pCtx, pMe->pStaging, &pStagingPathname)  );
+	SG_uint32 generations = SG_SYNC__GENERATIONS_PER_ROUNDTRIP__INITIAL;
 
 	SG_ERR_CHECK(  SG_vhash__has(pCtx, *ppvhStagingStatus, SG_SYNC_STATUS_KEY__DAGS, &disconnected)  );
 	while (disconnected)
@@ -139,20 +158,22 @@ static void _add_dagnodes_until_connected(SG_context* pCtx,
 		// There's at least one dag with connection problems.  
 		
 		// Convert the staging status vhash into a fragball request vhash.
+		// The status already carries a sample of our dags (see
+		// SG_sync__add_dag_samples_to_status()), which lets the server
+		// send more than the requested generations when it can see that
+		// we diverged further back.
 		pvhFragballRequest = *ppvhStagingStatus;
 		*ppvhStagingStatus = NULL;
-		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhFragballRequest, SG_SYNC_STATUS_KEY__GENERATIONS, GENERATIONS_PER_ROUNDTRIP)  );
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhFragballRequest, SG_SYNC_STATUS_KEY__GENERATIONS, generations)  );
+		generations = SG_MIN(2 * generations, SG_SYNC__GENERATIONS_PER_ROUNDTRIP__MAX);
 
-		SG_ERR_CHECK(  SG_client__pull_request_fragball(pCtx, pClient, pvhFragballRequest, pStagingPathname, &pszFragballName, &pvhRequestStatus)  );
+		SG_ERR_CHECK(  _request_fragball_into_staging(pCtx, pClient, pvhFragballRequest, pMe->pStaging, &pvhRequestStatus)  );
 
 		/* Ian TODO: inspect pvhRequestStatus */
 
 		SG_VHASH_NULLFREE(pCtx, pvhRequestStatus);
 		SG_VHASH_NULLFREE(pCtx, pvhFragballRequest);
 
-		SG_ERR_CHECK(  SG_staging__slurp_fragball(pCtx, pMe->pStaging, (const char*)pszFragballName)  );
-		SG_NULLFREE(pCtx, pszFragballName);
-
 		SG_ERR_CHECK(  SG_staging__check_status(pCtx, pMe->pStaging, SG_TRUE, SG_FALSE, SG_FALSE, SG_FALSE, SG_FALSE, ppvhStagingStatus)  );
 
 		SG_ERR_CHECK(  SG_vhash__has(pCtx, *ppvhStagingStatus, SG_SYNC_STATUS_KEY__DAGS, &disconnected)  );
@@ -168,7 +189,6 @@ static void _add_dagnodes_until_connected(SG_context* pCtx,
 fail:
 	SG_VHASH_NULLFREE(pCtx, *ppvhStagingStatus);
 	SG_VHASH_NULLFREE(pCtx, pvhFragballRequest);
-	SG_NULLFREE(pCtx, pszFragballName);
 	SG_VHASH_NULLFREE(pCtx, pvhRequestStatus);
 	SG_ERR_IGNORE(  SG_context__msg__emit(pCtx, "\n")  );
 }
@@ -179,9 +199,7 @@ static void _add_blobs_until_done(SG_context* pCtx,
 {
 	SG_bool need_blobs = SG_FALSE;
 	SG_vhash* pvhFragballRequest = NULL;
-	char* pszFragballName = NULL;
 	SG_vhash* pvhRequestStatus = NULL;
-	const SG_pathname* pStagingPathname = NULL;
 	SG_vhash* pvhStagingStatus = NULL;
 
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "Retrieving blobs...")  );
@@ -189,25 +207,19 @@ static void _add_blobs_until_done(SG_context* pCtx,
 	SG_ERR_CHECK(  SG_staging__check_status(pCtx, pStaging, SG_FALSE, SG_FALSE, SG_FALSE, SG_TRUE, SG_TRUE, &pvhStagingStatus)  );
 
 	SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhStagingStatus, SG_SYNC_STATUS_KEY__BLOBS, &need_blobs)  );
-	
-	if (need_blobs)
-		SG_ERR_CHECK(  SG_staging__get_pathname(pCtx, pStaging, &pStagingPathname)  );
 
 	while (need_blobs)
 	{
 		pvhFragballRequest = pvhStagingStatus;
 		pvhStagingStatus = NULL;
 
-		SG_ERR_CHECK(  SG_client__pull_request_fragball(pCtx, pClient, pvhFragballRequest, pStagingPathname, &pszFragballName, &pvhRequestStatus)  );
+		SG_ERR_CHECK(  _request_fragball_into_staging(pCtx, pClient, pvhFragballRequest, pStaging, &pvhRequestStatus)  );
 
 		/* Ian TODO: inspect pvhRequestStatus */
 
 		SG_VHASH_NULLFREE(pCtx, pvhRequestStatus);
 		SG_VHASH_NULLFREE(pCtx, pvhFragballRequest);
 
-		SG_ERR_CHECK(  SG_staging__slurp_fragball(pCtx, pStaging, (const char*)pszFragballName)  );
-		SG_NULLFREE(pCtx, pszFragballName);
-
 		SG_ERR_CHECK(  SG_staging__check_status(pCtx, pStaging, SG_FALSE, SG_FALSE, SG_FALSE, SG_TRUE, SG_TRUE, &pvhStagingStatus)  );
 
 #if TRACE_PULL
@@ -223,7 +235,6 @@ static void _add_blobs_until_done(SG_context* pCtx,
 fail:
 	SG_VHASH_NULLFREE(pCtx, pvhStagingStatus);
 	SG_VHASH_NULLFREE(pCtx, pvhFragballRequest);
-	SG_NULLFREE(pCtx, pszFragballName);
 	SG_VHASH_NULLFREE(pCtx, pvhRequestStatus);
 	SG_ERR_IGNORE(  SG_context__msg__emit(pCtx, "\n")  );
 }
@@ -296,26 +307,22 @@ void SG_pull__all(SG_context* pCtx,
 				  SG_varray** ppvaLog)
 {
 	sg_pull_instance_data* pMe = NULL;
-	char* pszFragballName = NULL;
 	SG_vhash* pvhStatus = NULL; // Used for both fragball request status returned by SG_client
 								// and staging status returned by SG_staging.
-	const SG_pathname* pStagingPathname;
 
 	SG_NULLARGCHECK_RETURN(pszPullIntoRepoDescriptorName);
 	SG_NULLARGCHECK_RETURN(pClient);
 
 	SG_ERR_CHECK(  _pull_init(pCtx, pClient, pszPullIntoRepoDescriptorName, &pMe)  );
-	SG_ERR_CHECK(  SG_staging__get_pathname(pCtx, pMe->pStaging, &pStagingPathname)  );
 
 	/* Request a fragball containing leaves of every dag */
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "Retrieving dagnodes...")  );
-	SG_ERR_CHECK(  SG_client__pull_request_fragball(pCtx, pClient, NULL, pStagingPathname, &pszFragballName, &pvhStatus)  );
+	SG_ERR_CHECK(  _request_fragball_into_staging(pCtx, pClient, NULL, pMe->pStaging, &pvhStatus)  );
 
 	/* Ian TODO: inspect pvhStatus */
 
 	SG_ERR_CHECK(  SG_VHASH_NULLFREE(pCtx, pvhStatus)  );
 
-	SG_ERR_CHECK(  SG_staging__slurp_fragball(pCtx, pMe->pStaging, pszFragballName)  );
 	SG_ERR_CHECK(  SG_staging__check_status(pCtx, pMe->pStaging, SG_TRUE, SG_FALSE, SG_FALSE, SG_FALSE, SG_FALSE, &pvhStatus)  );
 
 	/* Finish the pull using the status data we got back. */
@@ -325,7 +332,6 @@ void SG_pull__all(SG_context* pCtx,
 fail:
 	_NULLFREE_INSTANCE_DATA(pCtx, pMe);
 	SG_VHASH_NULLFREE(pCtx, pvhStatus);
-	SG_NULLFREE(pCtx, pszFragballName);
 }
 
 void SG_pull__begin(
@@ -457,17 +463,13 @@ void SG_pull__commit(
 	_sg_pull* pMyPull = NULL;
 	sg_pull_instance_data* pMe = NULL;
 	SG_vhash* pvhStatus = NULL;
-	char* pszFragballName = NULL;
-	const SG_pathname* pStagingPathname;
 	
 	SG_NULL_PP_CHECK_RETURN(ppPull);
 	pMyPull = (_sg_pull*)*ppPull;
 	pMe = pMyPull->pPullInstance;
 
-	SG_ERR_CHECK(  SG_staging__get_pathname(pCtx, pMe->pStaging, &pStagingPathname)  );
-
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "Retrieving dagnodes...")  );
-	SG_ERR_CHECK(  SG_client__pull_request_fragball(pCtx, pMyPull->pClient, pMyPull->pvhFragballRequest, pStagingPathname, &pszFragballName, &pvhStatus)  );
+	SG_ERR_CHECK(  _request_fragball_into_staging(pCtx, pMyPull->pClient, pMyPull->pvhFragballRequest, pMe->pStaging, &pvhStatus)  );
 #if TRACE_PULL
 	SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, pvhStatus, "pull staging status")  );
 #endif
@@ -476,7 +478,6 @@ void SG_pull__commit(
 
 	SG_ERR_CHECK(  SG_VHASH_NULLFREE(pCtx, pvhStatus)  );
 
-	SG_ERR_CHECK(  SG_staging__slurp_fragball(pCtx, pMe->pStaging, pszFragballName)  );
 	SG_ERR_CHECK(  SG_staging__check_status(pCtx, pMe->pStaging, SG_TRUE, SG_FALSE, SG_FALSE, SG_FALSE, SG_FALSE, &pvhStatus)  );
 
 	/* Finish the pull using the status data we got back. */
@@ -486,7 +487,6 @@ void SG_pull__commit(
 fail:
 	SG_ERR_IGNORE(  _sg_pull__nullfree(pCtx, (_sg_pull**)ppPull)  );
 	SG_VHASH_NULLFREE(pCtx, pvhStatus);
-	SG_NULLFREE(pCtx, pszFragballName);
 }
 
 void SG_pull__abort(
@@ -507,26 +507,22 @@ void SG_pull__all__list_incoming(
 	SG_varray** ppvaInfo)
 {
 	sg_pull_instance_data* pMe = NULL;
-	char* pszFragballName = NULL;
 	SG_vhash* pvhStatus = NULL; // Used for both fragball request status returned by SG_client
 	// and staging status returned by SG_staging.
-	const SG_pathname* pStagingPathname;
 
 	SG_NULLARGCHECK_RETURN(pszPullIntoRepoDescriptorName);
 	SG_NULLARGCHECK_RETURN(pClient);
 
 	SG_ERR_CHECK(  _pull_init(pCtx, pClient, pszPullIntoRepoDescriptorName, &pMe)  );
-	SG_ERR_CHECK(  SG_staging__get_pathname(pCtx, pMe->pStaging, &pStagingPathname)  );
 
 	/* Request a fragball containing leaves of every dag */
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "Retrieving dagnodes...")  );
-	SG_ERR_CHECK(  SG_client__pull_request_fragball(pCtx, pClient, NULL, pStagingPathname, &pszFragballName, &pvhStatus)  );
+	SG_ERR_CHECK(  _request_fragball_into_staging(pCtx, pClient, NULL, pMe->pStaging, &pvhStatus)  );
 
 	/* Ian TODO: inspect pvhStatus */
 
 	SG_ERR_CHECK(  SG_VHASH_NULLFREE(pCtx, pvhStatus)  );
 
-	SG_ERR_CHECK(  SG_staging__slurp_fragball(pCtx, pMe->pStaging, pszFragballName)  );
 	SG_ERR_CHECK(  SG_staging__check_status(pCtx, pMe->pStaging, SG_TRUE, SG_FALSE, SG_FALSE, SG_FALSE, SG_FALSE, &pvhStatus)  );
 
 	/* Check the status and use it to request more dagnodes until the dags connect */
@@ -550,5 +546,4 @@ void SG_pull__all__list_incoming(
 fail:
 	_NULLFREE_INSTANCE_DATA(pCtx, pMe);
 	SG_VHASH_NULLFREE(pCtx, pvhStatus);
-	SG_NULLFREE(pCtx, pszFragballName);
 }
\ No newline at end of file
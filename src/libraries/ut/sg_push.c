@@ -16,8 +16,6 @@ limitations under the License.
 
 #include <sg.h>
 
-#define GENERATIONS_PER_ROUNDTRIP 100
-
 #define TRACE_PUSH 0
 
 typedef struct
@@ -25,7 +23,7 @@ typedef struct
 	SG_repo* pRepo;
 	SG_client* pClient;
 	SG_pathname* pTempPathname;
-	SG_pathname* pFragballPathname;
+	SG_fragball_stream* pFragballStream;
 	SG_client_push_handle* pClientPushHandle;
 } _sg_push;
 
@@ -35,7 +33,7 @@ static void _sg_push__nullfree(SG_context* pCtx, _sg_push** ppMyPush)
 	{
 		_sg_push* pMyPush = *ppMyPush;
 		SG_PATHNAME_NULLFREE(pCtx, pMyPush->pTempPathname);
-		SG_PATHNAME_NULLFREE(pCtx, pMyPush->pFragballPathname);
+		SG_FRAGBALL_STREAM_NULLFREE(pCtx, pMyPush->pFragballStream);
 		if (pMyPush->pClient && pMyPush->pClientPushHandle)
 			SG_ERR_IGNORE(  SG_client__push_end(pCtx, pMyPush->pClient, &pMyPush->pClientPushHandle)  );
 		SG_NULLFREE(pCtx, pMyPush);
@@ -47,7 +45,7 @@ static void _push_init(SG_context* pCtx,
 					   SG_repo* pThisRepo,
 					   SG_client* pClient, 
 					   SG_pathname** ppTempPathname, 
-					   SG_pathname** ppFragballPathname, 
+					   SG_fragball_stream** ppFragballStream, 
 					   SG_client_push_handle** ppClientPushHandle)
 {
 	char* pszThisRepoId = NULL;
@@ -56,7 +54,7 @@ static void _push_init(SG_context* pCtx,
 	char* pszOtherHashMethod = NULL;
 
 	SG_pathname* pTempPathname = *ppTempPathname;
-	SG_pathname* pFragballPathname = NULL;
+	SG_fragball_stream* pFragballStream = NULL;
 	SG_client_push_handle* pClientPushHandle = NULL;
 
 	SG_ERR_CHECK(  SG_client__get_repo_info(pCtx, pClient, &pszOtherRepoId, NULL, &pszOtherHashMethod)  );
@@ -75,11 +73,11 @@ static void _push_init(SG_context* pCtx,
 	/* Start the push operation */
 	SG_ERR_CHECK(  SG_client__push_begin(pCtx, pClient, &pTempPathname, &pClientPushHandle)  );
 
-	/* Create a fragball */
-	SG_ERR_CHECK(  SG_fragball__create(pCtx, pTempPathname, &pFragballPathname)  );
+	/* Start the initial fragball.  Nothing is read from it until it's sent. */
+	SG_ERR_CHECK(  SG_fragball_stream__alloc(pCtx, pThisRepo, &pFragballStream)  );
 
 	SG_RETURN_AND_NULL(pTempPathname, ppTempPathname);
-	SG_RETURN_AND_NULL(pFragballPathname, ppFragballPathname);
+	SG_RETURN_AND_NULL(pFragballStream, ppFragballStream);
 	SG_RETURN_AND_NULL(pClientPushHandle, ppClientPushHandle);
 
 	/* fall through */
@@ -89,7 +87,7 @@ fail:
 	SG_NULLFREE(pCtx, pszOtherRepoId);
 	SG_NULLFREE(pCtx, pszOtherHashMethod);
 	SG_PATHNAME_NULLFREE(pCtx, pTempPathname);
-	SG_FRAGBALL_NULLFREE(pCtx, pFragballPathname);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 	if (SG_context__has_err(pCtx) && pClientPushHandle)
 		SG_ERR_IGNORE(  SG_client__push_end(pCtx, pClient, &pClientPushHandle)  );
 }
@@ -97,14 +95,13 @@ fail:
 
 static void _add_dagnodes_until_connected(SG_context* pCtx, 
 										  SG_vhash** ppvh_status, 
-										  SG_pathname* pPath_tempdir, 
 										  SG_repo* pRepo, 
 										  SG_client* pClient, 
 										  SG_client_push_handle* pClientPushHandle)
 {
 	SG_uint32 i;
 	SG_bool disconnected = SG_FALSE;
-	SG_pathname* pPath_fragball = NULL;
+	SG_fragball_stream* pFragballStream = NULL;
 	SG_vhash* pvh_unknown_dagnodes = NULL;
 	const char* pszDagNum = NULL; 
 	const SG_variant* pvMissingNodes = NULL;
@@ -112,12 +109,13 @@ static void _add_dagnodes_until_connected(SG_context* pCtx,
 	SG_rbtree* prb_missing_nodes = NULL;
 	const char* pszHidMissingDagnode = NULL;
 	SG_uint32 count_dagnums;
+	SG_uint32 generations = SG_SYNC__GENERATIONS_PER_ROUNDTRIP__INITIAL;
 
 	SG_ERR_CHECK(  SG_vhash__has(pCtx, *ppvh_status, SG_SYNC_STATUS_KEY__DAGS, &disconnected)  );
 	while (disconnected)
 	{
 		// There's at least one dag with connection problems.
-		SG_ERR_CHECK(  SG_fragball__create(pCtx, pPath_tempdir, &pPath_fragball)  );
+		SG_ERR_CHECK(  SG_fragball_stream__alloc(pCtx, pRepo, &pFragballStream)  );
 		SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, *ppvh_status, SG_SYNC_STATUS_KEY__DAGS, &pvh_unknown_dagnodes)  );
 
 		// For each dag, get the unknown nodes.
@@ -135,6 +133,11 @@ static void _add_dagnodes_until_connected(SG_context* pCtx,
 			{
 				SG_uint32 iDagnum;
 				SG_uint32 j;
+				SG_int32 genCommon = 0;
+
+				// The server sent a sample of its dag along with the status.  If we
+				// have any of those nodes, we know how far back we have to go.
+				SG_ERR_CHECK(  SG_sync__get_common_generation(pCtx, pRepo, *ppvh_status, pszDagNum, &genCommon)  );
 
 				SG_ERR_CHECK(  SG_rbtree__alloc__params(pCtx, &prb_missing_nodes, iMissingNodeCount, NULL)  );
 				for (j=0; j<iMissingNodeCount; j++)
@@ -142,27 +145,31 @@ static void _add_dagnodes_until_connected(SG_context* pCtx,
 					SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_missing_nodes, j, &pszHidMissingDagnode, NULL)  );
 					SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb_missing_nodes, pszHidMissingDagnode)  );
 
-					SG_ERR_CHECK(  SG_sync__add_n_generations(pCtx, pRepo, pszHidMissingDagnode, prb_missing_nodes, GENERATIONS_PER_ROUNDTRIP)  );
+					SG_ERR_CHECK(  SG_sync__add_generations(pCtx, pRepo, pszHidMissingDagnode, prb_missing_nodes, generations, genCommon)  );
 				}
 
 				SG_ERR_CHECK(  SG_dagnum__from_sz__decimal(pCtx, pszDagNum, &iDagnum)  );
-				SG_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pPath_fragball, pRepo, iDagnum, prb_missing_nodes)  );
+				SG_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pFragballStream, iDagnum, prb_missing_nodes)  );
 				SG_RBTREE_NULLFREE(pCtx, prb_missing_nodes);
 			}
 		}
 
 		SG_VHASH_NULLFREE(pCtx, *ppvh_status);
 
-		SG_ERR_CHECK(  SG_client__push_add(pCtx, pClient, pClientPushHandle, &pPath_fragball, ppvh_status)  );
+		SG_ERR_CHECK(  SG_client__push_add__stream(pCtx, pClient, pClientPushHandle, &pFragballStream, ppvh_status)  );
 
 		SG_ERR_CHECK(  SG_vhash__has(pCtx, *ppvh_status, SG_SYNC_STATUS_KEY__DAGS, &disconnected)  );
 
+		// Still disconnected?  Then the dags diverged further back than we
+		// guessed.  Reach back twice as far next time.
+		generations = SG_MIN(2 * generations, SG_SYNC__GENERATIONS_PER_ROUNDTRIP__MAX);
+
 #if TRACE_PUSH
 		SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, *ppvh_status, "push staging status")  );
 #endif
 	}
 
-	SG_FRAGBALL_NULLFREE(pCtx, pPath_fragball);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 	SG_RBTREE_NULLFREE(pCtx, prb_missing_nodes);
 
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "done\n")  );
@@ -170,7 +177,7 @@ static void _add_dagnodes_until_connected(SG_context* pCtx,
 	return;
 
 fail:
-	SG_FRAGBALL_NULLFREE(pCtx, pPath_fragball);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 	SG_RBTREE_NULLFREE(pCtx, prb_missing_nodes);
 	SG_VHASH_NULLFREE(pCtx, *ppvh_status);
 	SG_ERR_IGNORE(  SG_context__msg__emit(pCtx, "\n")  );
@@ -178,13 +185,12 @@ fail:
 
 static void _add_blobs_until_done(SG_context* pCtx, 
 								  SG_vhash** ppvh_status, 
-								  SG_pathname* pPath_tempdir, 
 								  SG_repo* pRepo, 
 								  SG_client* pClient, 
 								  SG_client_push_handle* pph) 
 {
 	SG_bool need_blobs = SG_FALSE;
-	SG_pathname* pPath_fragball = NULL;
+	SG_fragball_stream* pFragballStream = NULL;
 
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "Sending blobs...")  );
 
@@ -194,10 +200,11 @@ static void _add_blobs_until_done(SG_context* pCtx,
 	{
 		SG_vhash* pvh;
 		SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, *ppvh_status, SG_SYNC_STATUS_KEY__BLOBS, &pvh)  );
-		SG_ERR_CHECK(  SG_fragball__create(pCtx, pPath_tempdir, &pPath_fragball)  );
-		SG_ERR_CHECK(  SG_sync__add_blobs_to_fragball(pCtx, pRepo, pPath_fragball, pvh)  );
+		/* The blobs are read from the repo as they're sent. */
+		SG_ERR_CHECK(  SG_fragball_stream__alloc(pCtx, pRepo, &pFragballStream)  );
+		SG_ERR_CHECK(  SG_sync__add_blobs_to_fragball_stream(pCtx, pFragballStream, pvh)  );
 		SG_VHASH_NULLFREE(pCtx, *ppvh_status);
-		SG_ERR_CHECK(  SG_client__push_add(pCtx, pClient, pph, &pPath_fragball, ppvh_status)  );
+		SG_ERR_CHECK(  SG_client__push_add__stream(pCtx, pClient, pph, &pFragballStream, ppvh_status)  );
 
 #if TRACE_PUSH
 		SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, *ppvh_status, "push staging status")  );
@@ -206,14 +213,14 @@ static void _add_blobs_until_done(SG_context* pCtx,
 		SG_ERR_CHECK(  SG_vhash__has(pCtx, *ppvh_status, SG_SYNC_STATUS_KEY__BLOBS, &need_blobs)  );
 	}
 
-	SG_FRAGBALL_NULLFREE(pCtx, pPath_fragball);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "done\n")  );
 
 	return;
 
 fail:
-	SG_FRAGBALL_NULLFREE(pCtx, pPath_fragball);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 	SG_VHASH_NULLFREE(pCtx, *ppvh_status);
 	SG_ERR_IGNORE(  SG_context__msg__emit(pCtx, "\n")  );
 }
@@ -264,17 +271,16 @@ static void _push_common(SG_context* pCtx,
 						 SG_client* pClient,
 						 SG_client_push_handle** ppClientPushHandle,
 						 SG_vhash** ppvh_status,
-						 SG_pathname* pPath_tempdir,
 						 SG_bool bAllowHeadCountIncrease)
 {
 	/* Check the status and use it to send more dagnodes until the dags connect */
-	SG_ERR_CHECK(  _add_dagnodes_until_connected(pCtx, ppvh_status, pPath_tempdir, pRepo, pClient, *ppClientPushHandle)  );
+	SG_ERR_CHECK(  _add_dagnodes_until_connected(pCtx, ppvh_status, pRepo, pClient, *ppClientPushHandle)  );
 
 	if (!bAllowHeadCountIncrease)
 		SG_ERR_CHECK(  _check_for_head_addition(pCtx, *ppvh_status)  );
 
 	/* All necessary dagnodes are in the frag at this point.  Add the blobs the server said it was missing. */
-	SG_ERR_CHECK(  _add_blobs_until_done(pCtx, ppvh_status, pPath_tempdir, pRepo, pClient, *ppClientPushHandle)  );
+	SG_ERR_CHECK(  _add_blobs_until_done(pCtx, ppvh_status, pRepo, pClient, *ppClientPushHandle)  );
 
 	SG_VHASH_NULLFREE(pCtx, *ppvh_status);
 
@@ -300,7 +306,7 @@ fail:
 void SG_push__all(SG_context* pCtx, SG_repo* pSrcRepo, SG_client* pClient, SG_bool bAllowHeadCountIncrease)
 {
     SG_pathname* pPath_tempdir = NULL;
-    SG_pathname* pPath_fragball = NULL;
+    SG_fragball_stream* pFragballStream = NULL;
     SG_uint32 count_dagnums = 0;
     SG_uint32* paDagNums = NULL;
     SG_uint32 i;
@@ -311,7 +317,7 @@ void SG_push__all(SG_context* pCtx, SG_repo* pSrcRepo, SG_client* pClient, SG_bo
 	SG_NULLARGCHECK(pSrcRepo);
 	SG_NULLARGCHECK(pClient);
 
-	SG_ERR_CHECK(  _push_init(pCtx, pSrcRepo, pClient, &pPath_tempdir, &pPath_fragball, &pClientPushHandle)  );
+	SG_ERR_CHECK(  _push_init(pCtx, pSrcRepo, pClient, &pPath_tempdir, &pFragballStream, &pClientPushHandle)  );
 
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "Sending dagnodes...")  );
 
@@ -321,20 +327,20 @@ void SG_push__all(SG_context* pCtx, SG_repo* pSrcRepo, SG_client* pClient, SG_bo
     for (i=0; i<count_dagnums; i++)
     {
          SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pSrcRepo, paDagNums[i], &prb_leaves)  );
-         SG_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pPath_fragball, pSrcRepo, paDagNums[i], prb_leaves)  );
+         SG_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pFragballStream, paDagNums[i], prb_leaves)  );
 		 SG_RBTREE_NULLFREE(pCtx, prb_leaves);
     }
     SG_NULLFREE(pCtx, paDagNums);
 	SG_RBTREE_NULLFREE(pCtx, prb_leaves);
 
-    SG_ERR_CHECK(  SG_client__push_add(pCtx, pClient, pClientPushHandle, &pPath_fragball, &pvh_status)  );
+    SG_ERR_CHECK(  SG_client__push_add__stream(pCtx, pClient, pClientPushHandle, &pFragballStream, &pvh_status)  );
 
 #if TRACE_PUSH
 	SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, pvh_status, "push staging status")  );
 #endif
 
 	/* Finish the push using the status data we got back. */
-	SG_ERR_CHECK(  _push_common(pCtx, pSrcRepo, pClient, &pClientPushHandle, &pvh_status, pPath_tempdir, bAllowHeadCountIncrease)  );
+	SG_ERR_CHECK(  _push_common(pCtx, pSrcRepo, pClient, &pClientPushHandle, &pvh_status, bAllowHeadCountIncrease)  );
 	
 	/* fall through */
 fail:
@@ -344,7 +350,7 @@ fail:
  	if (pPath_tempdir)
  		SG_ERR_IGNORE(  SG_fsobj__rmdir_recursive__pathname(pCtx, pPath_tempdir)  );
 
-	SG_FRAGBALL_NULLFREE(pCtx, pPath_fragball);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 	SG_PATHNAME_NULLFREE(pCtx, pPath_tempdir);
 	SG_NULLFREE(pCtx, paDagNums);
 	SG_RBTREE_NULLFREE(pCtx, prb_leaves);
@@ -364,7 +370,7 @@ void SG_push__begin(
 	SG_NULLARGCHECK_RETURN(ppPush);
 
 	SG_alloc1(pCtx, pMyPush);
-	SG_ERR_CHECK(  _push_init(pCtx, pRepo, pClient, &pMyPush->pTempPathname, &pMyPush->pFragballPathname, &pMyPush->pClientPushHandle)  );
+	SG_ERR_CHECK(  _push_init(pCtx, pRepo, pClient, &pMyPush->pTempPathname, &pMyPush->pFragballStream, &pMyPush->pClientPushHandle)  );
 	pMyPush->pClient = pClient;
 	pMyPush->pRepo = pRepo;
 
@@ -417,13 +423,13 @@ void SG_push__add(
 	if (prbDagnodes)
 	{
 		/* Add specified nodes to the initial fragball */
-		SG_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pMyPush->pFragballPathname, pMyPush->pRepo, iDagnum, prbDagnodes)  );
+		SG_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pMyPush->pFragballStream, iDagnum, prbDagnodes)  );
 	}
 	else
 	{
 		/* No specific nodes were provided, so add the leaves */
 		SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pMyPush->pRepo, iDagnum, &prbLeaves)  );
-		SG_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pMyPush->pFragballPathname, pMyPush->pRepo, iDagnum, prbLeaves)  );
+		SG_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pMyPush->pFragballStream, iDagnum, prbLeaves)  );
 	}
 
 	/* fall through */
@@ -445,7 +451,7 @@ void SG_push__commit(
 	pMyPush = (_sg_push*)*ppPush;
 
 	/* Push the initial fragball */
-	SG_ERR_CHECK(  SG_client__push_add(pCtx, pMyPush->pClient, pMyPush->pClientPushHandle, &pMyPush->pFragballPathname, &pvh_status)  );
+	SG_ERR_CHECK(  SG_client__push_add__stream(pCtx, pMyPush->pClient, pMyPush->pClientPushHandle, &pMyPush->pFragballStream, &pvh_status)  );
 
 #if TRACE_PUSH
 	SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, pvh_status, "push staging status")  );
@@ -453,7 +459,7 @@ void SG_push__commit(
 
 	/* Finish the push using the status data we got back. */
 	SG_ERR_CHECK(  _push_common(pCtx, pMyPush->pRepo, pMyPush->pClient, &pMyPush->pClientPushHandle, 
-		&pvh_status, pMyPush->pTempPathname, bAllowHeadCountIncrease)  );
+		&pvh_status, bAllowHeadCountIncrease)  );
 	
 	SG_ERR_CHECK(  _sg_push__nullfree(pCtx, &pMyPush)  );
 	*ppPush = NULL;
@@ -482,7 +488,7 @@ void SG_push__abort(
 void SG_push__all__list_outgoing(SG_context* pCtx, SG_repo* pSrcRepo, SG_client* pClient, SG_varray** ppvaInfo)
 {
 	SG_pathname* pPath_tempdir = NULL;
-	SG_pathname* pPath_fragball = NULL;
+	SG_fragball_stream* pFragballStream = NULL;
 	SG_uint32 count_dagnums = 0;
 	SG_uint32* paDagNums = NULL;
 	SG_uint32 i;
@@ -493,7 +499,7 @@ void SG_push__all__list_outgoing(SG_context* pCtx, SG_repo* pSrcRepo, SG_client*
 	SG_NULLARGCHECK(pSrcRepo);
 	SG_NULLARGCHECK(pClient);
 
-	SG_ERR_CHECK(  _push_init(pCtx, pSrcRepo, pClient, &pPath_tempdir, &pPath_fragball, &pClientPushHandle)  );
+	SG_ERR_CHECK(  _push_init(pCtx, pSrcRepo, pClient, &pPath_tempdir, &pFragballStream, &pClientPushHandle)  );
 
 	SG_ERR_CHECK_RETURN(  SG_context__msg__emit(pCtx, "Sending dagnodes...")  );
 
@@ -503,20 +509,20 @@ void SG_push__all__list_outgoing(SG_context* pCtx, SG_repo* pSrcRepo, SG_client*
 	for (i=0; i<count_dagnums; i++)
 	{
 		SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pSrcRepo, paDagNums[i], &prb_leaves)  );
-		SG_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pPath_fragball, pSrcRepo, paDagNums[i], prb_leaves)  );
+		SG_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pFragballStream, paDagNums[i], prb_leaves)  );
 		SG_RBTREE_NULLFREE(pCtx, prb_leaves);
 	}
 	SG_NULLFREE(pCtx, paDagNums);
 	SG_RBTREE_NULLFREE(pCtx, prb_leaves);
 
-	SG_ERR_CHECK(  SG_client__push_add(pCtx, pClient, pClientPushHandle, &pPath_fragball, &pvh_status)  );
+	SG_ERR_CHECK(  SG_client__push_add__stream(pCtx, pClient, pClientPushHandle, &pFragballStream, &pvh_status)  );
 
 #if TRACE_PUSH
 	SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, pvh_status, "push staging status")  );
 #endif
 
 	/* Check the status and use it to send more dagnodes until the dags connect */
-	SG_ERR_CHECK(  _add_dagnodes_until_connected(pCtx, &pvh_status, pPath_tempdir, pSrcRepo, pClient, pClientPushHandle)  );
+	SG_ERR_CHECK(  _add_dagnodes_until_connected(pCtx, &pvh_status, pSrcRepo, pClient, pClientPushHandle)  );
 	SG_VHASH_NULLFREE(pCtx, pvh_status);
 
 	/* An add with no fragball does a complete status check */
@@ -543,7 +549,7 @@ fail:
 	if (pPath_tempdir)
 		SG_ERR_IGNORE(  SG_fsobj__rmdir_recursive__pathname(pCtx, pPath_tempdir)  );
 
-	SG_FRAGBALL_NULLFREE(pCtx, pPath_fragball);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 	SG_PATHNAME_NULLFREE(pCtx, pPath_tempdir);
 	SG_NULLFREE(pCtx, paDagNums);
 	SG_RBTREE_NULLFREE(pCtx, prb_leaves);
@@ -46,6 +46,14 @@ void SG_repo__get_descriptor_name(
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * Limits for the per-repo cache of decoded objects.  The byte limit
+ * is in terms of the serialized (JSON) size of the objects; the
+ * decoded form is several times larger.
+ */
+#define SG_REPO__OBJCACHE__MAX_BYTES		(16 * 1024 * 1024)
+#define SG_REPO__OBJCACHE__MAX_COUNT		32768
+
 void SG_repo__alloc(SG_context * pCtx, SG_repo ** ppRepo, const char * pszStorage)
 {
 	SG_repo * pRepo = NULL;
@@ -54,6 +62,7 @@ void SG_repo__alloc(SG_context * pCtx, SG_repo ** ppRepo, const char * pszStorag
 
 	SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pRepo)  );
 	SG_ERR_CHECK(  sg_repo__bind_vtable(pCtx, pRepo, pszStorage)  );
+	SG_ERR_CHECK(  SG_objcache__alloc(pCtx, &pRepo->p_objcache, SG_REPO__OBJCACHE__MAX_BYTES, SG_REPO__OBJCACHE__MAX_COUNT)  );
 
 	*ppRepo = pRepo;
 	return;
@@ -291,6 +300,9 @@ void SG_repo__free(SG_context* pCtx, SG_repo* pRepo)
 		SG_ASSERT(  (pRepo->p_vtable_instance_data == NULL)  );
     }
 
+	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pRepo->prb_dagindex, (SG_free_callback*) SG_dagindex__free);
+	SG_OBJCACHE_NULLFREE(pCtx, pRepo->p_objcache);
+
 	// unbind the vtables incase it was dynamically loaded and
 	// needs to be freed.
 	SG_ERR_IGNORE(  sg_repo__unbind_vtable(pCtx, pRepo)  );
@@ -384,6 +396,16 @@ void SG_repo__commit_tx(SG_context* pCtx,
 	VERIFY_VTABLE_AND_INSTANCE(pRepo);
 
 	pRepo->p_vtable->commit_tx(pCtx,pRepo,ppTx);
+
+	// if the commit failed, the dagfrags we folded into the cached
+	// dag indexes didn't make it to disk.  see SG_repo__abort_tx().
+
+	if (SG_context__has_err(pCtx))
+	{
+		SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pRepo->prb_dagindex, (SG_free_callback*) SG_dagindex__free);
+		if (pRepo->p_objcache)
+			SG_ERR_IGNORE(  SG_objcache__clear(pCtx, pRepo->p_objcache)  );
+	}
 }
 
 void SG_repo__abort_tx(SG_context* pCtx,
@@ -392,6 +414,17 @@ void SG_repo__abort_tx(SG_context* pCtx,
 {
 	VERIFY_VTABLE_AND_INSTANCE(pRepo);
 
+	// any dagfrags stored in this tx have already been folded into
+	// the cached dag indexes.  we don't know which nodes to take back
+	// out, so just drop them all and let them be reloaded.
+
+	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pRepo->prb_dagindex, (SG_free_callback*) SG_dagindex__free);
+
+	// likewise, anything we decoded during the tx might be gone.
+
+	if (pRepo->p_objcache)
+		SG_ERR_IGNORE(  SG_objcache__clear(pCtx, pRepo->p_objcache)  );
+
 	pRepo->p_vtable->abort_tx(pCtx,pRepo,ppTx);
 }
 
@@ -399,12 +432,40 @@ void SG_repo__abort_tx(SG_context* pCtx,
 
 void SG_repo__fetch_dagnode(SG_context* pCtx, SG_repo * pRepo, const char* pszidHidChangeset, SG_dagnode ** ppNewDagnode)
 {
+	SG_dagnode * pDagnode = NULL;
+	SG_uint32 nrParents = 0;
+
 	VERIFY_VTABLE_AND_INSTANCE(pRepo);
 
 	SG_NULLARGCHECK_RETURN(pszidHidChangeset);
 	SG_NULLARGCHECK_RETURN(ppNewDagnode);
 
-	pRepo->p_vtable->fetch_dagnode(pCtx,pRepo,pszidHidChangeset,ppNewDagnode);
+	if (pRepo->p_objcache)
+	{
+		SG_ERR_CHECK_RETURN(  SG_objcache__lookup(pCtx, pRepo->p_objcache, SG_OBJCACHE_TYPE__DAGNODE, pszidHidChangeset, (void**)&pDagnode)  );
+		if (pDagnode)
+		{
+			*ppNewDagnode = pDagnode;
+			return;
+		}
+	}
+
+	SG_ERR_CHECK_RETURN(  pRepo->p_vtable->fetch_dagnode(pCtx,pRepo,pszidHidChangeset,&pDagnode)  );
+
+	if (pRepo->p_objcache)
+	{
+		SG_ERR_CHECK(  SG_dagnode__count_parents(pCtx, pDagnode, &nrParents)  );
+		SG_ERR_CHECK(  SG_objcache__add(pCtx, pRepo->p_objcache, SG_OBJCACHE_TYPE__DAGNODE, pszidHidChangeset, pDagnode,
+										(1 + nrParents) * SG_HID_MAX_BUFFER_LENGTH,
+										(SG_objcache__addref_callback*) SG_dagnode__addref,
+										(SG_free_callback*) SG_dagnode__free)  );
+	}
+
+	*ppNewDagnode = pDagnode;
+	return;
+
+fail:
+	SG_DAGNODE_NULLFREE(pCtx, pDagnode);
 }
 
 //////////////////////////////////////////////////////////////////
@@ -455,6 +516,24 @@ void SG_repo__check_dagfrag(
 	pRepo->p_vtable->check_dagfrag(pCtx,pRepo,pFrag,pbConnected,ppIdsetMissing,ppsa_new,pprbLeaves);
 }
 
+static void sg_repo__drop_dagindex(SG_context* pCtx, SG_repo* pRepo, SG_uint32 iDagNum)
+{
+	char buf[SG_DAGNUM__BUF_MAX__DEC];
+	SG_dagindex * pIndex = NULL;
+	SG_bool bFound = SG_FALSE;
+
+	if (!pRepo->prb_dagindex)
+		return;
+
+	SG_ERR_CHECK_RETURN(  SG_dagnum__to_sz__decimal(pCtx, iDagNum, buf, sizeof(buf))  );
+	SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx, pRepo->prb_dagindex, buf, &bFound, NULL)  );
+	if (bFound)
+	{
+		SG_ERR_CHECK_RETURN(  SG_rbtree__remove__with_assoc(pCtx, pRepo->prb_dagindex, buf, (void**)&pIndex)  );
+		SG_DAGINDEX_NULLFREE(pCtx, pIndex);
+	}
+}
+
 void SG_repo__store_dagfrag(SG_context* pCtx,
 							SG_repo * pRepo,
 								 SG_repo_tx_handle* pTx,
@@ -464,7 +543,43 @@ void SG_repo__store_dagfrag(SG_context* pCtx,
 
 	SG_NULLARGCHECK_RETURN(pFrag);
 
+	// keep the cached index for this dag (if we have one) coherent.
+	// we do this before handing the frag to the implementation because
+	// it takes ownership of it.  if the frag can't be folded in (or the
+	// store fails) we just drop the index and it will be reloaded.
+
+	if (pRepo->prb_dagindex)
+	{
+		SG_uint32 iDagNum = 0;
+		char buf[SG_DAGNUM__BUF_MAX__DEC];
+		SG_dagindex * pIndex = NULL;
+		SG_bool bFound = SG_FALSE;
+
+		SG_ERR_CHECK(  SG_dagfrag__get_dagnum(pCtx, pFrag, &iDagNum)  );
+		SG_ERR_CHECK(  SG_dagnum__to_sz__decimal(pCtx, iDagNum, buf, sizeof(buf))  );
+		SG_ERR_CHECK(  SG_rbtree__find(pCtx, pRepo->prb_dagindex, buf, &bFound, (void**)&pIndex)  );
+		if (bFound)
+		{
+			SG_dagindex__add_dagfrag(pCtx, pIndex, pFrag);
+			if (SG_context__has_err(pCtx))
+			{
+				SG_context__err_reset(pCtx);
+				SG_ERR_CHECK(  sg_repo__drop_dagindex(pCtx, pRepo, iDagNum)  );
+			}
+		}
+	}
+
 	pRepo->p_vtable->store_dagfrag(pCtx,pRepo,pTx,pFrag);
+	if (SG_context__has_err(pCtx) && pRepo->prb_dagindex)
+	{
+		SG_uint32 iDagNum = 0;
+
+		SG_ERR_IGNORE(  SG_dagfrag__get_dagnum(pCtx, pFrag, &iDagNum)  );
+		SG_ERR_IGNORE(  sg_repo__drop_dagindex(pCtx, pRepo, iDagNum)  );
+	}
+
+fail:
+	return;
 }
 
 //////////////////////////////////////////////////////////////////
@@ -686,17 +801,20 @@ void SG_repo__fetch_blob_into_file(SG_context* pCtx,
 	SG_NULLARGCHECK_RETURN(pszidHidBlob);
 
     SG_ERR_CHECK(  SG_repo__fetch_blob__begin(pCtx, pRepo, pszidHidBlob, SG_TRUE, NULL, NULL, NULL, NULL, &len, &pbh)  );
+    SG_ERR_CHECK(  SG_file__preallocate(pCtx, pFileRawData, len)  );
     left = len;
     SG_ERR_CHECK(  SG_alloc(pCtx, SG_STREAMING_BUFFER_SIZE, 1, &p_buf)  );
     while (!b_done)
     {
         SG_uint32 want = SG_STREAMING_BUFFER_SIZE;
+        const SG_byte* p_span = NULL;
+
         if (want > left)
         {
             want = (SG_uint32) left;
         }
-        SG_ERR_CHECK(  SG_repo__fetch_blob__chunk(pCtx, pRepo, pbh, want, p_buf, &got, &b_done)  );
-        SG_ERR_CHECK(  SG_file__write(pCtx, pFileRawData, got, p_buf, NULL)  );
+        SG_ERR_CHECK(  SG_repo__fetch_blob__chunk__span(pCtx, pRepo, pbh, want, p_buf, &p_span, &got, &b_done)  );
+        SG_ERR_CHECK(  SG_file__write(pCtx, pFileRawData, got, p_span, NULL)  );
 
         left -= got;
     }
@@ -752,13 +870,147 @@ void SG_repo__get_dag_lca(
     SG_daglca ** ppDagLca
     )
 {
+	const SG_dagindex * pIndex = NULL;
+	SG_daglca * pDagLca = NULL;
+	SG_rbtree_iterator * pIter = NULL;
+	const char * pszHid = NULL;
+	SG_bool b = SG_FALSE;
+
 	VERIFY_VTABLE_AND_INSTANCE(pRepo);
 
 	SG_NULLARGCHECK_RETURN(pRepo);
 	SG_NULLARGCHECK_RETURN(prbNodes);
 	SG_NULLARGCHECK_RETURN(ppDagLca);
 
-	pRepo->p_vtable->get_dag_lca(pCtx,pRepo,iDagNum,prbNodes,ppDagLca);
+	// run the LCA over the in-memory dag index so that each node the
+	// LCA code visits doesn't cost a trip to the repo.  implementations
+	// that can't build an index get their own get_dag_lca.
+	//
+	// we ask for the index once per leaf so that it gets reloaded if
+	// one of the leaves was stored by somebody else.
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, prbNodes, &b, &pszHid, NULL)  );
+	while (b)
+	{
+		SG_repo__get_dagindex(pCtx, pRepo, iDagNum, pszHid, &pIndex);
+		if (SG_context__err_equals(pCtx, SG_ERR_NOTIMPLEMENTED))
+		{
+			SG_context__err_reset(pCtx);
+			SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+			SG_ERR_CHECK_RETURN(  pRepo->p_vtable->get_dag_lca(pCtx,pRepo,iDagNum,prbNodes,ppDagLca)  );
+			return;
+		}
+		SG_ERR_CHECK_CURRENT;
+
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, &pszHid, NULL)  );
+	}
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+
+	SG_ERR_CHECK(  SG_daglca__alloc(pCtx, &pDagLca, iDagNum, SG_dagindex__fetch_dagnode, (void*)pIndex)  );
+	SG_ERR_CHECK(  SG_daglca__add_leaves(pCtx, pDagLca, prbNodes)  );
+	SG_ERR_CHECK(  SG_daglca__compute_lca(pCtx, pDagLca)  );
+
+	*ppDagLca = pDagLca;
+	return;
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_DAGLCA_NULLFREE(pCtx, pDagLca);
+}
+
+void SG_repo__get_dagindex(
+    SG_context* pCtx,
+    SG_repo* pRepo,
+    SG_uint32 iDagNum,
+    const char* pszHidWanted,
+    const SG_dagindex ** ppIndex
+    )
+{
+	char buf[SG_DAGNUM__BUF_MAX__DEC];
+	SG_dagindex * pIndex = NULL;
+	SG_bool bFound = SG_FALSE;
+
+	VERIFY_VTABLE_AND_INSTANCE(pRepo);
+
+	SG_NULLARGCHECK_RETURN(ppIndex);
+
+	SG_ERR_CHECK(  SG_dagnum__to_sz__decimal(pCtx, iDagNum, buf, sizeof(buf))  );
+
+	if (!pRepo->prb_dagindex)
+		SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &pRepo->prb_dagindex)  );
+
+	SG_ERR_CHECK(  SG_rbtree__find(pCtx, pRepo->prb_dagindex, buf, &bFound, (void**)&pIndex)  );
+	if (bFound && pszHidWanted)
+	{
+		SG_bool bHaveHid = SG_FALSE;
+
+		SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHidWanted, &bHaveHid, NULL)  );
+		if (!bHaveHid)
+		{
+			SG_ERR_CHECK(  sg_repo__drop_dagindex(pCtx, pRepo, iDagNum)  );
+			pIndex = NULL;
+			bFound = SG_FALSE;
+		}
+	}
+	if (!bFound)
+	{
+		SG_ERR_CHECK(  pRepo->p_vtable->fetch_dagindex(pCtx, pRepo, iDagNum, &pIndex)  );
+		SG_ERR_CHECK(  SG_rbtree__add__with_assoc(pCtx, pRepo->prb_dagindex, buf, pIndex)  );
+	}
+
+	*ppIndex = pIndex;
+	return;
+
+fail:
+	if (!bFound)
+		SG_DAGINDEX_NULLFREE(pCtx, pIndex);
+}
+
+void SG_repo__drop_dagindexes(
+    SG_context* pCtx,
+    SG_repo* pRepo
+    )
+{
+	VERIFY_VTABLE_AND_INSTANCE(pRepo);
+
+	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pRepo->prb_dagindex, (SG_free_callback*) SG_dagindex__free);
+}
+
+void SG_repo__get_objcache__ref(
+    SG_context* pCtx,
+    SG_repo* pRepo,
+    SG_objcache ** ppCache
+    )
+{
+	VERIFY_VTABLE_ONLY(pRepo);
+
+	SG_NULLARGCHECK_RETURN(ppCache);
+
+	*ppCache = pRepo->p_objcache;
+}
+
+void SG_repo__get_refcache_stats(
+    SG_context* pCtx,
+    SG_repo* pRepo,
+    SG_vhash ** ppvhStats
+    )
+{
+	VERIFY_VTABLE_AND_INSTANCE(pRepo);
+
+	SG_NULLARGCHECK_RETURN(ppvhStats);
+
+	SG_ERR_CHECK_RETURN(  pRepo->p_vtable->get_refcache_stats(pCtx, pRepo, ppvhStats)  );
+}
+
+void SG_repo__drop_caches(
+    SG_context* pCtx,
+    SG_repo* pRepo
+    )
+{
+	VERIFY_VTABLE_AND_INSTANCE(pRepo);
+
+	SG_ERR_CHECK_RETURN(  SG_repo__drop_dagindexes(pCtx, pRepo)  );
+	SG_ERR_CHECK_RETURN(  pRepo->p_vtable->drop_caches(pCtx, pRepo)  );
 }
 
 void SG_repo__store_blob__begin(
@@ -855,6 +1107,24 @@ void SG_repo__fetch_blob__chunk(
     pRepo->p_vtable->fetch_blob__chunk(pCtx, pRepo, pHandle, len_buf, p_buf, p_len_got, pb_done);
 }
 
+void SG_repo__fetch_blob__chunk__span(
+	SG_context* pCtx,
+    SG_repo * pRepo,
+    SG_repo_fetch_blob_handle* pHandle,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    )
+{
+    VERIFY_VTABLE_AND_INSTANCE(pRepo);
+	SG_NULLARGCHECK_RETURN(pHandle);
+	SG_NULLARGCHECK_RETURN(pp_span);
+
+    pRepo->p_vtable->fetch_blob__chunk__span(pCtx, pRepo, pHandle, len_buf, p_buf, pp_span, p_len_got, pb_done);
+}
+
 void SG_repo__fetch_blob__end(
     SG_context* pCtx,
     SG_repo * pRepo,
@@ -902,7 +1172,8 @@ void SG_repo__get_blob_stats(
     SG_uint64* p_total_blob_size_zlib_full,
     SG_uint64* p_total_blob_size_zlib_encoded,
     SG_uint64* p_total_blob_size_vcdiff_full,
-    SG_uint64* p_total_blob_size_vcdiff_encoded
+    SG_uint64* p_total_blob_size_vcdiff_encoded,
+    SG_vhash** ppvh_chain_depths
     )
 {
     VERIFY_VTABLE_AND_INSTANCE(pRepo);
@@ -918,7 +1189,8 @@ void SG_repo__get_blob_stats(
         p_total_blob_size_zlib_full,
         p_total_blob_size_zlib_encoded,
         p_total_blob_size_vcdiff_full,
-        p_total_blob_size_vcdiff_encoded
+        p_total_blob_size_vcdiff_encoded,
+        ppvh_chain_depths
     );
 }
 
@@ -1239,6 +1511,7 @@ void SG_repo__change_blob_encoding(
     const char* psz_hid_blob,
     SG_blob_encoding blob_encoding_desired,
     const char* psz_hid_vcdiff_reference_desired,
+    const SG_vcdiff_options* pVcdiffOptions,
     SG_blob_encoding* p_blob_encoding_new,
     char** ppsz_hid_vcdiff_reference,
     SG_uint64* p_len_encoded,
@@ -1253,6 +1526,7 @@ void SG_repo__change_blob_encoding(
             psz_hid_blob,
             blob_encoding_desired,
             psz_hid_vcdiff_reference_desired,
+            pVcdiffOptions,
             p_blob_encoding_new,
             ppsz_hid_vcdiff_reference,
             p_len_encoded,
@@ -1260,6 +1534,32 @@ void SG_repo__change_blob_encoding(
             );
 }
 
+void SG_repo__replace_blob_encoding(
+    SG_context* pCtx,
+    SG_repo * pRepo,
+	SG_repo_tx_handle* pTx,
+    const char* psz_hid_blob,
+    SG_blob_encoding blob_encoding,
+    const char* psz_hid_vcdiff_reference,
+    SG_uint64 len_full,
+    SG_uint32 len_encoded,
+    const SG_byte* p_encoded
+    )
+{
+    VERIFY_VTABLE_AND_INSTANCE(pRepo);
+
+    SG_ERR_CHECK_RETURN(  pRepo->p_vtable->replace_blob_encoding(pCtx,
+			pRepo,
+			pTx,
+            psz_hid_blob,
+            blob_encoding,
+            psz_hid_vcdiff_reference,
+            len_full,
+            len_encoded,
+            p_encoded
+            )  );
+}
+
 void SG_repo__list_blobs(
 	    SG_context* pCtx,
         SG_repo * pRepo,
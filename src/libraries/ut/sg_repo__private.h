@@ -277,6 +277,24 @@ typedef void FN__sg_repo__fetch_blob__chunk(
     SG_bool* pb_done
     );
 
+/**
+ * Like fetch_blob__chunk, but the implementation may hand back a pointer
+ * to the bytes in place (for example, in a memory-mapped data file) rather
+ * than copying them into p_buf.  *pp_span is valid until the next call on
+ * this handle.  Implementations that can't do this fill p_buf and set
+ * *pp_span to p_buf.
+ */
+typedef void FN__sg_repo__fetch_blob__chunk__span(
+    SG_context* pCtx,
+	SG_repo * pRepo,
+    SG_repo_fetch_blob_handle* pHandle,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    );
+
 typedef void FN__sg_repo__fetch_blob__end(
     SG_context* pCtx,
 	SG_repo * pRepo,
@@ -308,12 +326,30 @@ typedef void FN__sg_repo__change_blob_encoding(
     const char* psz_hid_blob,
     SG_blob_encoding blob_encoding_desired,
     const char* psz_hid_vcdiff_reference_desired,
+    const SG_vcdiff_options* pVcdiffOptions,
     SG_blob_encoding* p_blob_encoding_new,
     char** ppsz_hid_vcdiff_reference,
     SG_uint64* p_len_encoded,
     SG_uint64* p_len_full
 );
 
+/**
+ * Replace the stored form of an existing blob with one which the caller
+ * has already encoded.  This lets the expensive part of a change of
+ * encoding happen outside the tx.
+ */
+typedef void FN__sg_repo__replace_blob_encoding(
+    SG_context* pCtx,
+	SG_repo * pRepo,
+	SG_repo_tx_handle* pTx,
+    const char* psz_hid_blob,
+    SG_blob_encoding blob_encoding,
+    const char* psz_hid_vcdiff_reference,
+    SG_uint64 len_full,
+    SG_uint32 len_encoded,
+    const SG_byte* p_encoded
+);
+
 typedef void FN__sg_repo__get_blob_stats(
     SG_context* pCtx,
 	SG_repo * pRepo,
@@ -326,7 +362,8 @@ typedef void FN__sg_repo__get_blob_stats(
     SG_uint64* p_total_blob_size_zlib_full,
     SG_uint64* p_total_blob_size_zlib_encoded,
     SG_uint64* p_total_blob_size_vcdiff_full,
-    SG_uint64* p_total_blob_size_vcdiff_encoded
+    SG_uint64* p_total_blob_size_vcdiff_encoded,
+    SG_vhash** ppvh_chain_depths
     );
 
 typedef void FN__sg_repo__fetch_dagnode(
@@ -477,6 +514,18 @@ typedef void FN__sg_repo__get_dag_lca(
         SG_daglca ** ppDagLca
         );
 
+/**
+ * Load the shape of an entire dag (every dagnode, its generation and
+ * its parent edges) into a frozen SG_dagindex.  The SG_repo layer
+ * caches the result per dagnum; see SG_repo__get_dagindex().
+ */
+typedef void FN__sg_repo__fetch_dagindex(
+        SG_context* pCtx,
+		SG_repo* pRepo,
+        SG_uint32 iDagNum,
+        SG_dagindex ** ppIndex
+        );
+
 /**
  * This function will return a list of all the dagnums that
  * actually exist in this repo instance.
@@ -604,6 +653,26 @@ typedef void FN__sg_repo__get_hash_method(
         char** ppsz_result  /* caller must free */
         );
 
+/**
+ * Get the counters of the instance's cache of reconstructed VCDIFF
+ * reference blobs.  Throws SG_ERR_NOTIMPLEMENTED if the implementation
+ * doesn't keep one.
+ */
+typedef void FN__sg_repo__get_refcache_stats(
+        SG_context* pCtx,
+        SG_repo* pRepo,
+        SG_vhash** ppvhStats  /* caller must free */
+        );
+
+/**
+ * Free whatever the instance caches in memory or in temp files
+ * (but not anything a pending tx needs).  The instance stays open.
+ */
+typedef void FN__sg_repo__drop_caches(
+        SG_context* pCtx,
+        SG_repo* pRepo
+        );
+
 //////////////////////////////////////////////////////////////////
 // The REPO VTABLE
 
@@ -629,6 +698,7 @@ struct _sg_repo__vtable
 
 	FN__sg_repo__fetch_blob__begin              * const		fetch_blob__begin;
 	FN__sg_repo__fetch_blob__chunk              * const		fetch_blob__chunk;
+	FN__sg_repo__fetch_blob__chunk__span        * const		fetch_blob__chunk__span;
 	FN__sg_repo__fetch_blob__end                * const		fetch_blob__end;
 	FN__sg_repo__fetch_blob__abort              * const		fetch_blob__abort;
 
@@ -637,6 +707,7 @@ struct _sg_repo__vtable
 	FN__sg_repo__check_dagfrag		            * const		check_dagfrag;
 
 	FN__sg_repo__change_blob_encoding           * const		change_blob_encoding;
+	FN__sg_repo__replace_blob_encoding          * const		replace_blob_encoding;
 
 	FN__sg_repo__get_blob_stats                 * const		get_blob_stats;
 
@@ -651,6 +722,7 @@ struct _sg_repo__vtable
 	FN__sg_repo__fetch_dag_leaves		        * const		fetch_dag_leaves;
 	FN__sg_repo__fetch_dagnode_children		    * const		fetch_dagnode_children;
     FN__sg_repo__get_dag_lca                    * const     get_dag_lca;
+    FN__sg_repo__fetch_dagindex                 * const     fetch_dagindex;
 	FN__sg_repo__get_repo_id	                * const		get_repo_id;
 	FN__sg_repo__get_admin_id	                * const		get_admin_id;
 
@@ -679,6 +751,8 @@ struct _sg_repo__vtable
 	FN__sg_repo__hash__abort                    * const		hash__abort;
 	FN__sg_repo__check_integrity                * const		check_integrity;
 
+	FN__sg_repo__get_refcache_stats             * const		get_refcache_stats;
+	FN__sg_repo__drop_caches                    * const		drop_caches;
 };
 
 typedef struct _sg_repo__vtable sg_repo__vtable;
@@ -702,11 +776,13 @@ typedef struct _sg_repo__vtable sg_repo__vtable;
 	FN__sg_repo__store_dagfrag			        sg_repo__##name##__store_dagfrag;		            \
 	FN__sg_repo__fetch_blob__begin              sg_repo__##name##__fetch_blob__begin;               \
 	FN__sg_repo__fetch_blob__chunk              sg_repo__##name##__fetch_blob__chunk;               \
+	FN__sg_repo__fetch_blob__chunk__span        sg_repo__##name##__fetch_blob__chunk__span;         \
 	FN__sg_repo__fetch_blob__end                sg_repo__##name##__fetch_blob__end;                 \
 	FN__sg_repo__fetch_blob__abort              sg_repo__##name##__fetch_blob__abort;               \
 	FN__sg_repo__fetch_repo__fragball           sg_repo__##name##__fetch_repo__fragball;            \
 	FN__sg_repo__check_dagfrag			        sg_repo__##name##__check_dagfrag;		            \
 	FN__sg_repo__change_blob_encoding           sg_repo__##name##__change_blob_encoding;            \
+	FN__sg_repo__replace_blob_encoding          sg_repo__##name##__replace_blob_encoding;           \
 	FN__sg_repo__get_blob_stats                 sg_repo__##name##__get_blob_stats;                  \
 	FN__sg_repo__fetch_dagnode			        sg_repo__##name##__fetch_dagnode;		            \
 	FN__sg_repo__find_dagnodes_by_prefix        sg_repo__##name##__find_dagnodes_by_prefix;	        \
@@ -716,6 +792,7 @@ typedef struct _sg_repo__vtable sg_repo__vtable;
 	FN__sg_repo__list_dags			            sg_repo__##name##__list_dags;		                \
 	FN__sg_repo__fetch_dag_leaves			    sg_repo__##name##__fetch_dag_leaves;		        \
 	FN__sg_repo__get_dag_lca			        sg_repo__##name##__get_dag_lca;	    	            \
+	FN__sg_repo__fetch_dagindex			        sg_repo__##name##__fetch_dagindex;	                \
 	FN__sg_repo__get_repo_id	        	    sg_repo__##name##__get_repo_id;                     \
 	FN__sg_repo__get_admin_id	   	            sg_repo__##name##__get_admin_id;                    \
 	FN__sg_repo__query_implementation           sg_repo__##name##__query_implementation;            \
@@ -739,6 +816,8 @@ typedef struct _sg_repo__vtable sg_repo__vtable;
 	FN__sg_repo__hash__abort                    sg_repo__##name##__hash__abort;                     \
 	FN__sg_repo__check_integrity                sg_repo__##name##__check_integrity;                 \
 	FN__sg_repo__fetch_dagnode_children         sg_repo__##name##__fetch_dagnode_children;          \
+	FN__sg_repo__get_refcache_stats             sg_repo__##name##__get_refcache_stats;              \
+	FN__sg_repo__drop_caches                    sg_repo__##name##__drop_caches;                     \
 
 
 // Convenience macro to declare a properly initialized static
@@ -761,11 +840,13 @@ typedef struct _sg_repo__vtable sg_repo__vtable;
 		sg_repo__##name##__store_dagfrag,					\
 		sg_repo__##name##__fetch_blob__begin,               \
 		sg_repo__##name##__fetch_blob__chunk,               \
+		sg_repo__##name##__fetch_blob__chunk__span,         \
 		sg_repo__##name##__fetch_blob__end,                 \
 		sg_repo__##name##__fetch_blob__abort,               \
 		sg_repo__##name##__fetch_repo__fragball,            \
 		sg_repo__##name##__check_dagfrag,					\
 		sg_repo__##name##__change_blob_encoding,            \
+		sg_repo__##name##__replace_blob_encoding,           \
 		sg_repo__##name##__get_blob_stats,                  \
 		sg_repo__##name##__fetch_dagnode,				    \
 		sg_repo__##name##__find_dagnodes_by_prefix,	        \
@@ -776,6 +857,7 @@ typedef struct _sg_repo__vtable sg_repo__vtable;
 		sg_repo__##name##__fetch_dag_leaves,				\
 		sg_repo__##name##__fetch_dagnode_children,			\
 		sg_repo__##name##__get_dag_lca,	    				\
+		sg_repo__##name##__fetch_dagindex,    				\
 		sg_repo__##name##__get_repo_id,     		        \
 		sg_repo__##name##__get_admin_id,   			        \
         sg_repo__##name##__query_implementation,            \
@@ -798,6 +880,8 @@ typedef struct _sg_repo__vtable sg_repo__vtable;
         sg_repo__##name##__hash__end,                       \
         sg_repo__##name##__hash__abort,                     \
         sg_repo__##name##__check_integrity,                 \
+        sg_repo__##name##__get_refcache_stats,              \
+        sg_repo__##name##__drop_caches,                     \
 	}
 
 //////////////////////////////////////////////////////////////////
@@ -839,6 +923,9 @@ struct _SG_repo
 
 	sg_repo__vtable *		            p_vtable;		        // the binding to a specific REPO VTABLE implementation
 	sg_repo__vtable__instance_data *	p_vtable_instance_data;	// binding-specific instance data (opaque outside of imp)
+
+	SG_rbtree *							prb_dagindex;			// dagnum (decimal) --> SG_dagindex*, built on first use
+	SG_objcache *						p_objcache;				// decoded treenodes, changesets and dagnodes
 };
 
 //////////////////////////////////////////////////////////////////
@@ -172,6 +172,151 @@ void sg_repo_utils__hash_abort__from_sghash(SG_context * pCtx,
 
 //////////////////////////////////////////////////////////////////
 
+static void _chain_depth(SG_context * pCtx,
+						 SG_rbtree * prb_refs,
+						 SG_vhash * pvh_memo,
+						 SG_uint32 count_deltas,
+						 const char * psz_hid,
+						 SG_int64 * pi_depth)
+{
+	const char * psz = psz_hid;
+	const char * psz_ref = NULL;
+	SG_int64 base = 0;
+	SG_int64 depth = 0;
+	SG_int64 d;
+	SG_bool b = SG_FALSE;
+
+	// walk down to a blob which isn't a delta or whose depth we already know.
+	while (1)
+	{
+		SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pvh_memo, psz, &b)  );
+		if (b)
+		{
+			SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvh_memo, psz, &base)  );
+			break;
+		}
+
+		SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx, prb_refs, psz, &b, (void**) &psz_ref)  );
+		if (!b)
+		{
+			break;
+		}
+
+		// a chain longer than the number of deltas means there is a cycle.
+		if (depth > (SG_int64) count_deltas)
+		{
+			SG_ERR_THROW_RETURN(  SG_ERR_ASSERT  );
+		}
+
+		depth++;
+		psz = psz_ref;
+	}
+
+	// and walk it again to remember the depth of everything on the way.
+	psz = psz_hid;
+	for (d = base + depth; d > base; d--)
+	{
+		SG_ERR_CHECK_RETURN(  SG_vhash__update__int64(pCtx, pvh_memo, psz, d)  );
+		SG_ERR_CHECK_RETURN(  SG_rbtree__find(pCtx, prb_refs, psz, NULL, (void**) &psz)  );
+	}
+
+	*pi_depth = base + depth;
+}
+
+static void _chain_depth__count(SG_context * pCtx,
+								SG_vhash * pvh_chain_depths,
+								SG_int64 depth,
+								SG_int64 count)
+{
+	char buf[32];
+	SG_bool b = SG_FALSE;
+	SG_int64 sofar = 0;
+
+	SG_ERR_CHECK_RETURN(  SG_sprintf(pCtx, buf, sizeof(buf), "%d", (int) depth)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__has(pCtx, pvh_chain_depths, buf, &b)  );
+	if (b)
+	{
+		SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvh_chain_depths, buf, &sofar)  );
+	}
+	SG_ERR_CHECK_RETURN(  SG_vhash__update__int64(pCtx, pvh_chain_depths, buf, sofar + count)  );
+}
+
+void sg_repo_utils__get_chain_depths(SG_context * pCtx,
+									 sqlite3 * psql,
+									 const char * psz_sql,
+									 SG_vhash ** ppvh_chain_depths)
+{
+	sqlite3_stmt * pStmt = NULL;
+	SG_rbtree * prb_refs = NULL;
+	SG_rbtree_iterator * pit = NULL;
+	SG_vhash * pvh_memo = NULL;
+	SG_vhash * pvh_chain_depths = NULL;
+	SG_uint32 count_deltas = 0;
+	SG_int64 count_not_deltas = 0;
+	const char * psz_hid = NULL;
+	SG_bool b = SG_FALSE;
+	int rc;
+
+	SG_NULLARGCHECK_RETURN(psql);
+	SG_NULLARGCHECK_RETURN(psz_sql);
+	SG_NULLARGCHECK_RETURN(ppvh_chain_depths);
+
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb_refs)  );
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_memo)  );
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_chain_depths)  );
+
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmt, "%s", psz_sql)  );
+	while ((rc=sqlite3_step(pStmt)) == SQLITE_ROW)
+	{
+		const char * psz_hid_blob = (const char *) sqlite3_column_text(pStmt, 0);
+		const char * psz_hid_ref = (const char *) sqlite3_column_text(pStmt, 1);
+
+		if (psz_hid_ref && *psz_hid_ref)
+		{
+			SG_ERR_CHECK(  SG_rbtree__update__with_pooled_sz(pCtx, prb_refs, psz_hid_blob, psz_hid_ref)  );
+		}
+		else
+		{
+			count_not_deltas++;
+		}
+	}
+	if (rc != SQLITE_DONE)
+	{
+		SG_ERR_THROW(  SG_ERR_SQLITE(rc)  );
+	}
+	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+
+	if (count_not_deltas)
+	{
+		SG_ERR_CHECK(  _chain_depth__count(pCtx, pvh_chain_depths, 0, count_not_deltas)  );
+	}
+
+	SG_ERR_CHECK(  SG_rbtree__count(pCtx, prb_refs, &count_deltas)  );
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_refs, &b, &psz_hid, NULL)  );
+	while (b)
+	{
+		SG_int64 depth = 0;
+
+		SG_ERR_CHECK(  _chain_depth(pCtx, prb_refs, pvh_memo, count_deltas, psz_hid, &depth)  );
+		SG_ERR_CHECK(  _chain_depth__count(pCtx, pvh_chain_depths, depth, 1)  );
+
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid, NULL)  );
+	}
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+
+	*ppvh_chain_depths = pvh_chain_depths;
+	pvh_chain_depths = NULL;
+
+fail:
+	SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+	SG_RBTREE_NULLFREE(pCtx, prb_refs);
+	SG_VHASH_NULLFREE(pCtx, pvh_memo);
+	SG_VHASH_NULLFREE(pCtx, pvh_chain_depths);
+}
+
+//////////////////////////////////////////////////////////////////
+
 void sg_repo_utils__one_step_hash__from_sghash(SG_context * pCtx,
 											   const char * pszHashMethod,
 											   SG_uint32 lenBuf,
@@ -93,6 +93,22 @@ void sg_repo_utils__one_step_hash__from_sghash(SG_context * pCtx,
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * Build a histogram of vcdiff chain depths.  psz_sql must select two
+ * columns for every blob in the repo: its HID and the HID of its vcdiff
+ * reference (NULL when it isn't a delta).  A blob which isn't a delta
+ * has depth 0; a delta has depth one more than its reference.
+ *
+ * The returned vhash maps each depth (as a string) to the number of
+ * blobs at that depth.  You own it.
+ */
+void sg_repo_utils__get_chain_depths(SG_context * pCtx,
+									 sqlite3 * psql,
+									 const char * psz_sql,
+									 SG_vhash ** ppvh_chain_depths);
+
+//////////////////////////////////////////////////////////////////
+
 END_EXTERN_C;
 
 #endif//H_SG_REPO__PRIVATE_UTILS_H
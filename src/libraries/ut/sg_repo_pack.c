@@ -15,17 +15,612 @@ limitations under the License.
 */
 
 #include <sg.h>
+#include <zlib.h>
 
 // TODO NOTE
 // The functions in this file are not ready to be features.
 // These functions aren't much more than sample code to help
 // test change_blob_encoding() in repo implementations.
 
+//////////////////////////////////////////////////////////////////
+
+/* The pack engine.  Every pack/unpack operation boils down to a flat
+ * list of (blob, desired encoding, reference) items.
+ *
+ * The expensive part is reading the blobs and compressing or
+ * deltifying them, so that is handed to a pool of worker threads, each
+ * with its own repo instance, which do the encoding into memory.  This
+ * thread is the only writer.  It takes the results in order and stores
+ * them with SG_repo__replace_blob_encoding(), MY_PACK__BLOBS_PER_TX to a
+ * tx.  Nothing here needs the repo to allow concurrent transactions.
+ *
+ * Blobs too big to encode in memory, and blobs a worker found busy, are
+ * left to change_blob_encoding() on the writer. */
+
+#define MY_PACK__MAX_THREADS            8
+#define MY_PACK__MAX_AHEAD              (4 * MY_PACK__MAX_THREADS)
+#define MY_PACK__MAX_IN_MEMORY          (2 * 1024 * 1024)
+#define MY_PACK__BLOBS_PER_TX           64
+#define MY_PACK__LIST_PAGE              500
+#define MY_PACK__BUSY_RETRIES           3
+#define MY_PACK__BUSY_SLEEP_MS          100
+
+typedef struct
+{
+    const char* psz_hid;
+    SG_blob_encoding blob_encoding;
+    const char* psz_hid_ref;
+    const SG_vcdiff_options* p_vcdiff_options;
+
+    /* Instead of changing the encoding, make the blob full if it is
+     * currently a delta against anything other than psz_hid_ref. */
+    SG_bool b_reset;
+} my_pack_item;
+
+/* One item on its way from a worker to the writer. */
+typedef struct
+{
+    const my_pack_item* pItem;
+
+    SG_bool b_nothing_to_do;
+    SG_blob_encoding blob_encoding;
+    SG_uint64 len_full;
+    SG_uint32 len_encoded;
+    SG_byte* p_encoded;     /* NULL when the writer has to do it the slow way */
+} my_pack_job;
+
+typedef struct
+{
+    SG_repo* pRepo;
+    SG_repo** pa_repos;     /* one per worker thread */
+} my_pack_data;
+
+typedef struct
+{
+    SG_byte* p;
+    SG_uint32 len;
+    SG_uint32 space;
+    SG_uint32 pos;
+} my_pack_membuf;
+
+//////////////////////////////////////////////////////////////////
+
+static void sg_pack__membuf__read(SG_context* pCtx, my_pack_membuf* pmb, SG_uint32 want, SG_byte* p, SG_uint32* p_got)
+{
+    SG_uint32 got = SG_MIN(want, pmb->len - pmb->pos);
+
+    SG_UNUSED(pCtx);
+
+    memcpy(p, pmb->p + pmb->pos, got);
+    pmb->pos += got;
+    if (p_got)
+    {
+        *p_got = got;
+    }
+}
+
+static void sg_pack__membuf__stream_read(SG_context* pCtx, my_pack_membuf* pmb, SG_uint32 want, SG_byte* p, SG_uint32* p_got, SG_bool* pb_done)
+{
+    // like SG_file__read(), which is what vcdiff expects underneath.
+    if (want && (pmb->pos == pmb->len))
+    {
+        SG_ERR_THROW_RETURN(  SG_ERR_EOF  );
+    }
+
+    SG_ERR_CHECK_RETURN(  sg_pack__membuf__read(pCtx, pmb, want, p, p_got)  );
+    *pb_done = (pmb->pos == pmb->len);
+}
+
+static void sg_pack__membuf__seek(SG_context* pCtx, my_pack_membuf* pmb, SG_uint64 pos)
+{
+    SG_ARGCHECK_RETURN(pos <= pmb->len, pos);
+
+    pmb->pos = (SG_uint32) pos;
+}
+
+static void sg_pack__membuf__close(SG_context* pCtx, my_pack_membuf* pmb)
+{
+    SG_UNUSED(pCtx);
+    SG_UNUSED(pmb);
+}
+
+static void sg_pack__membuf__write(SG_context* pCtx, my_pack_membuf* pmb, SG_uint32 count, SG_byte* p, SG_uint32* p_written)
+{
+    SG_byte* p_new = NULL;
+
+    if (pmb->len + count > pmb->space)
+    {
+        SG_uint32 space = pmb->space ? pmb->space : 4096;
+
+        while (space < pmb->len + count)
+        {
+            space *= 2;
+        }
+        SG_ERR_CHECK_RETURN(  SG_allocN(pCtx, space, p_new)  );
+        if (pmb->len)
+        {
+            memcpy(p_new, pmb->p, pmb->len);
+        }
+        SG_NULLFREE(pCtx, pmb->p);
+        pmb->p = p_new;
+        pmb->space = space;
+    }
+
+    memcpy(pmb->p + pmb->len, p, count);
+    pmb->len += count;
+    if (p_written)
+    {
+        *p_written = count;
+    }
+}
+
+/**
+ * Deltify p_full against p_ref, into a new buffer.
+ */
+static void sg_pack__deltify(
+        SG_context* pCtx,
+        const SG_vcdiff_options* p_vcdiff_options,
+        SG_byte* p_ref,
+        SG_uint32 len_ref,
+        SG_byte* p_full,
+        SG_uint32 len_full,
+        SG_byte** pp_delta,
+        SG_uint32* p_len_delta
+        )
+{
+    my_pack_membuf mb_ref;
+    my_pack_membuf mb_full;
+    my_pack_membuf mb_delta;
+    SG_seekreader* psr_ref = NULL;
+    SG_readstream* pstrm_full = NULL;
+    SG_writestream* pstrm_delta = NULL;
+
+    memset(&mb_ref, 0, sizeof(mb_ref));
+    memset(&mb_full, 0, sizeof(mb_full));
+    memset(&mb_delta, 0, sizeof(mb_delta));
+    mb_ref.p = p_ref;
+    mb_ref.len = len_ref;
+    mb_full.p = p_full;
+    mb_full.len = len_full;
+
+    SG_ERR_CHECK(  SG_seekreader__alloc(pCtx, &mb_ref, 0, len_ref,
+                (SG_nonstream__func__read*) sg_pack__membuf__read,
+                (SG_stream__func__seek*) sg_pack__membuf__seek,
+                (SG_stream__func__close*) sg_pack__membuf__close,
+                &psr_ref)  );
+    SG_ERR_CHECK(  SG_readstream__alloc(pCtx, &mb_full, (SG_stream__func__read*) sg_pack__membuf__stream_read, NULL, &pstrm_full)  );
+    SG_ERR_CHECK(  SG_writestream__alloc(pCtx, &mb_delta, (SG_stream__func__write*) sg_pack__membuf__write, NULL, &pstrm_delta)  );
+
+    SG_ERR_CHECK(  SG_vcdiff__deltify__streams__options(pCtx, psr_ref, pstrm_full, pstrm_delta, p_vcdiff_options)  );
+
+    *pp_delta = mb_delta.p;
+    mb_delta.p = NULL;
+    *p_len_delta = mb_delta.len;
+
+    /* fall through */
+
+fail:
+    if (psr_ref)
+    {
+        SG_ERR_IGNORE(  SG_seekreader__close(pCtx, psr_ref)  );
+    }
+    if (pstrm_full)
+    {
+        SG_ERR_IGNORE(  SG_readstream__close(pCtx, pstrm_full)  );
+    }
+    if (pstrm_delta)
+    {
+        SG_ERR_IGNORE(  SG_writestream__close(pCtx, pstrm_delta)  );
+    }
+    SG_NULLFREE(pCtx, mb_delta.p);
+}
+
+static void sg_pack__get_info(SG_context* pCtx, SG_repo* pRepo, const char* psz_hid, SG_blob_encoding* p_blob_encoding, char** ppsz_hid_ref, SG_uint64* p_len_full)
+{
+    SG_repo_fetch_blob_handle* pbh = NULL;
+
+    SG_ERR_CHECK(  SG_repo__fetch_blob__begin(pCtx, pRepo, psz_hid, SG_FALSE, NULL, p_blob_encoding, ppsz_hid_ref, NULL, p_len_full, &pbh)  );
+    SG_ERR_CHECK(  SG_repo__fetch_blob__abort(pCtx, pRepo, &pbh)  );
+
+    return;
+
+fail:
+    if (pbh)
+    {
+        SG_ERR_IGNORE(  SG_repo__fetch_blob__abort(pCtx, pRepo, &pbh)  );
+    }
+}
+
+/**
+ * The worker side of one item: decide whether anything needs doing and,
+ * if the blob is small enough, encode it into pJob->p_encoded.
+ */
+static void sg_pack__encode(SG_context* pCtx, SG_repo* pRepo, my_pack_job* pJob)
+{
+    const my_pack_item* pItem = pJob->pItem;
+    SG_blob_encoding blob_encoding_stored = 0;
+    char* psz_hid_ref_stored = NULL;
+    SG_uint64 len_full = 0;
+    SG_uint64 len_ref = 0;
+    SG_byte* p_full = NULL;
+    SG_byte* p_ref = NULL;
+    uLongf len_deflated = 0;
+    int zErr;
+
+    SG_ERR_CHECK(  sg_pack__get_info(pCtx, pRepo, pItem->psz_hid, &blob_encoding_stored, &psz_hid_ref_stored, &len_full)  );
+
+    if (pItem->b_reset)
+    {
+        pJob->blob_encoding = SG_BLOBENCODING__FULL;
+        pJob->b_nothing_to_do = !(
+                (SG_BLOBENCODING__VCDIFF == blob_encoding_stored)
+                && (!psz_hid_ref_stored || !pItem->psz_hid_ref || (0 != strcmp(psz_hid_ref_stored, pItem->psz_hid_ref)))
+                );
+    }
+    else
+    {
+        pJob->blob_encoding = pItem->blob_encoding;
+        switch (pItem->blob_encoding)
+        {
+        case SG_BLOBENCODING__FULL:
+            pJob->b_nothing_to_do = SG_IS_BLOBENCODING_FULL(blob_encoding_stored);
+            break;
+
+        case SG_BLOBENCODING__ZLIB:
+        case SG_BLOBENCODING__VCDIFF:
+            pJob->b_nothing_to_do = ((pItem->blob_encoding == blob_encoding_stored) || (SG_BLOBENCODING__ALWAYSFULL == blob_encoding_stored));
+            break;
+
+        default:
+            SG_ERR_THROW2(  SG_ERR_INVALIDARG,
+                    (pCtx, "Unknown desired blob encoding: %d", (int) pItem->blob_encoding)  );
+        }
+    }
+
+    if (pJob->b_nothing_to_do || (len_full > MY_PACK__MAX_IN_MEMORY))
+    {
+        goto fail;
+    }
+
+    if (SG_BLOBENCODING__VCDIFF == pJob->blob_encoding)
+    {
+        SG_NULLARGCHECK(pItem->psz_hid_ref);
+
+        SG_ERR_CHECK(  sg_pack__get_info(pCtx, pRepo, pItem->psz_hid_ref, NULL, NULL, &len_ref)  );
+        if (len_ref > MY_PACK__MAX_IN_MEMORY)
+        {
+            goto fail;
+        }
+        SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, pItem->psz_hid_ref, &p_ref, &len_ref)  );
+    }
+
+    SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, pItem->psz_hid, &p_full, &len_full)  );
+    pJob->len_full = len_full;
+
+    switch (pJob->blob_encoding)
+    {
+    case SG_BLOBENCODING__FULL:
+        pJob->p_encoded = p_full;
+        p_full = NULL;
+        pJob->len_encoded = (SG_uint32) len_full;
+        break;
+
+    case SG_BLOBENCODING__ZLIB:
+        len_deflated = compressBound((uLong) len_full);
+        SG_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32) len_deflated, pJob->p_encoded)  );
+        zErr = compress2(pJob->p_encoded, &len_deflated, p_full, (uLong) len_full, Z_DEFAULT_COMPRESSION);
+        if (zErr != Z_OK)
+        {
+            SG_ERR_THROW(  SG_ERR_ZLIB(zErr)  );
+        }
+        pJob->len_encoded = (SG_uint32) len_deflated;
+        break;
+
+    case SG_BLOBENCODING__VCDIFF:
+        SG_ERR_CHECK(  sg_pack__deltify(pCtx, pItem->p_vcdiff_options, p_ref, (SG_uint32) len_ref, p_full, (SG_uint32) len_full, &pJob->p_encoded, &pJob->len_encoded)  );
+        break;
+    }
+
+    /* fall through */
+
+fail:
+    if (SG_context__has_err(pCtx))
+    {
+        SG_NULLFREE(pCtx, pJob->p_encoded);
+    }
+    SG_NULLFREE(pCtx, psz_hid_ref_stored);
+    SG_NULLFREE(pCtx, p_full);
+    SG_NULLFREE(pCtx, p_ref);
+}
+
+static void sg_pack__prepare(SG_context* pCtx, SG_uint32 kThread, void* pVoidData, void* pVoidJob)
+{
+    my_pack_data* pData = (my_pack_data*) pVoidData;
+    my_pack_job* pJob = (my_pack_job*) pVoidJob;
+    SG_repo* pRepo = pData->pa_repos ? pData->pa_repos[kThread] : pData->pRepo;
+
+    sg_pack__encode(pCtx, pRepo, pJob);
+    if (SG_context__err_equals(pCtx, SG_ERR_REPO_BUSY))
+    {
+        // the writer will do this one itself, with retries.
+        SG_context__err_reset(pCtx);
+        pJob->b_nothing_to_do = SG_FALSE;
+    }
+}
+
+/**
+ * The slow way, for when the worker couldn't encode the blob.
+ */
+static void sg_pack__do_item(SG_context* pCtx, SG_repo* pRepo, SG_repo_tx_handle* pTx, const my_pack_item* pItem)
+{
+    SG_blob_encoding blob_encoding = 0;
+    char* psz_hid_ref = NULL;
+
+    if (pItem->b_reset)
+    {
+        SG_ERR_CHECK(  sg_pack__get_info(pCtx, pRepo, pItem->psz_hid, &blob_encoding, &psz_hid_ref, NULL)  );
+
+        if (
+                (SG_BLOBENCODING__VCDIFF == blob_encoding)
+                && (!psz_hid_ref || !pItem->psz_hid_ref || (0 != strcmp(psz_hid_ref, pItem->psz_hid_ref)))
+           )
+        {
+            SG_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, pItem->psz_hid, SG_BLOBENCODING__FULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
+        }
+    }
+    else
+    {
+        SG_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, pItem->psz_hid, pItem->blob_encoding, pItem->psz_hid_ref, pItem->p_vcdiff_options, NULL, NULL, NULL, NULL)  );
+    }
+
+    /* fall through */
+
+fail:
+    SG_NULLFREE(pCtx, psz_hid_ref);
+}
+
+static void sg_pack__store(SG_context* pCtx, SG_repo* pRepo, SG_repo_tx_handle* pTx, SG_bool b_skip_busy, const my_pack_job* pJob)
+{
+    const my_pack_item* pItem = pJob->pItem;
+    SG_uint32 tries = 0;
+
+    while (1)
+    {
+        if (pJob->p_encoded)
+        {
+            SG_repo__replace_blob_encoding(pCtx, pRepo, pTx,
+                    pItem->psz_hid,
+                    pJob->blob_encoding,
+                    (SG_BLOBENCODING__VCDIFF == pJob->blob_encoding) ? pItem->psz_hid_ref : NULL,
+                    pJob->len_full,
+                    pJob->len_encoded,
+                    pJob->p_encoded);
+        }
+        else
+        {
+            sg_pack__do_item(pCtx, pRepo, pTx, pItem);
+        }
+
+        if (!SG_context__has_err(pCtx))
+        {
+            break;
+        }
+        if (!SG_context__err_equals(pCtx,SG_ERR_REPO_BUSY))
+        {
+            SG_ERR_RETHROW_RETURN;
+        }
+
+        // somebody else is working on this blob.
+        if (++tries > MY_PACK__BUSY_RETRIES)
+        {
+            if (b_skip_busy)
+            {
+                SG_context__err_reset(pCtx);
+                break;
+            }
+            SG_ERR_RETHROW_RETURN;
+        }
+        SG_context__err_reset(pCtx);
+        SG_sleep_ms(MY_PACK__BUSY_SLEEP_MS);
+    }
+}
+
+/**
+ * Do all the items.  When b_skip_busy is set, a blob which stays busy
+ * is left alone.  Otherwise that's an error, because later work depends
+ * on every item having been done.
+ */
+static void sg_pack__run(SG_context* pCtx, SG_repo* pRepo, const my_pack_item* p_items, SG_uint32 count_items, SG_bool b_skip_busy)
+{
+    my_pack_data data;
+    my_pack_job* pa_jobs = NULL;
+    my_pack_job* pJob = NULL;
+    SG_work_queue* pQueue = NULL;
+    SG_uint32 count_threads = 0;
+    SG_repo_tx_handle* pTx = NULL;
+    SG_uint32 count_in_tx = 0;
+    SG_uint32 i;
+
+    if (!count_items)
+    {
+        return;
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.pRepo = pRepo;
+
+    SG_ERR_CHECK(  SG_allocN(pCtx, count_items, pa_jobs)  );
+    for (i=0; i<count_items; i++)
+    {
+        pa_jobs[i].pItem = &p_items[i];
+    }
+
+    SG_ERR_CHECK(  SG_work_queue__alloc(pCtx, SG_MIN(MY_PACK__MAX_THREADS, count_items), 0, SG_WORK_QUEUE_FLAGS__COLLECT, sg_pack__prepare, &data, &pQueue)  );
+    SG_ERR_CHECK(  SG_work_queue__get_thread_count(pCtx, pQueue, &count_threads)  );
+    if (count_threads)
+    {
+        SG_ERR_CHECK(  SG_allocN(pCtx, count_threads, data.pa_repos)  );
+        for (i=0; i<count_threads; i++)
+        {
+            SG_ERR_CHECK(  SG_repo__open_repo_instance__copy(pCtx, pRepo, &data.pa_repos[i])  );
+        }
+    }
+
+    for (i=0; i<=count_items; i++)
+    {
+        if (i < count_items)
+        {
+            SG_ERR_CHECK(  SG_work_queue__add(pCtx, pQueue, &pa_jobs[i])  );
+            if (i < MY_PACK__MAX_AHEAD)
+            {
+                continue;
+            }
+        }
+
+        // store the oldest one; at the end, store all the rest.
+        while (1)
+        {
+            SG_ERR_CHECK(  SG_work_queue__next_done(pCtx, pQueue, (void**) &pJob)  );
+            if (!pJob)
+            {
+                break;
+            }
+
+            if (!pJob->b_nothing_to_do)
+            {
+                if (!pTx)
+                {
+                    SG_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
+                }
+                SG_ERR_CHECK(  sg_pack__store(pCtx, pRepo, pTx, b_skip_busy, pJob)  );
+                if (++count_in_tx == MY_PACK__BLOBS_PER_TX)
+                {
+                    SG_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
+                    count_in_tx = 0;
+                }
+            }
+            SG_NULLFREE(pCtx, pJob->p_encoded);
+
+            if (i < count_items)
+            {
+                break;
+            }
+        }
+    }
+
+    if (pTx)
+    {
+        SG_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
+    }
+    SG_ERR_CHECK(  SG_work_queue__finish(pCtx, pQueue)  );
+
+    /* fall through */
+
+fail:
+    if (pTx)
+    {
+        SG_ERR_IGNORE(  SG_repo__abort_tx(pCtx, pRepo, &pTx)  );
+    }
+    // the workers must be stopped before their repo instances are freed.
+    SG_WORK_QUEUE_NULLFREE(pCtx, pQueue);
+    if (data.pa_repos)
+    {
+        for (i=0; i<count_threads; i++)
+        {
+            SG_REPO_NULLFREE(pCtx, data.pa_repos[i]);
+        }
+        SG_NULLFREE(pCtx, data.pa_repos);
+    }
+    if (pa_jobs)
+    {
+        for (i=0; i<count_items; i++)
+        {
+            SG_NULLFREE(pCtx, pa_jobs[i].p_encoded);
+        }
+        SG_NULLFREE(pCtx, pa_jobs);
+    }
+}
+
+/**
+ * Fetch the HIDs of all blobs with the given encoding, a page at a time.
+ * The returned rbtree owns the strings.
+ */
+static void sg_pack__list_all_blobs(SG_context* pCtx, SG_repo* pRepo, SG_blob_encoding blob_encoding, SG_rbtree** pprb)
+{
+    SG_rbtree* prb = NULL;
+    SG_vhash* pvh = NULL;
+    SG_uint32 offset = 0;
+    SG_uint32 count = 0;
+    SG_uint32 i;
+
+    SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb)  );
+    do
+    {
+        SG_ERR_CHECK(  SG_repo__list_blobs(pCtx, pRepo, blob_encoding, SG_TRUE, SG_TRUE, MY_PACK__LIST_PAGE, offset, &pvh)  );
+        SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh, &count)  );
+        for (i=0; i<count; i++)
+        {
+            const char* psz_hid = NULL;
+
+            SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh, i, &psz_hid, NULL)  );
+            SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb, psz_hid)  );
+        }
+        SG_VHASH_NULLFREE(pCtx, pvh);
+        offset += count;
+    } while (count == MY_PACK__LIST_PAGE);
+
+    *pprb = prb;
+    prb = NULL;
+
+fail:
+    SG_VHASH_NULLFREE(pCtx, pvh);
+    SG_RBTREE_NULLFREE(pCtx, prb);
+}
+
+static void sg_pack__change_all(SG_context* pCtx, SG_repo* pRepo, SG_blob_encoding blob_encoding_from, SG_blob_encoding blob_encoding_to)
+{
+    SG_rbtree* prb_hids = NULL;
+    SG_rbtree_iterator* pit = NULL;
+    my_pack_item* pa_items = NULL;
+    SG_uint32 count = 0;
+    SG_uint32 i = 0;
+    SG_bool b = SG_FALSE;
+    const char* psz_hid = NULL;
+
+    SG_ERR_CHECK(  sg_pack__list_all_blobs(pCtx, pRepo, blob_encoding_from, &prb_hids)  );
+    SG_ERR_CHECK(  SG_rbtree__count(pCtx, prb_hids, &count)  );
+    if (count)
+    {
+        SG_ERR_CHECK(  SG_allocN(pCtx, count, pa_items)  );
+
+        SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_hids, &b, &psz_hid, NULL)  );
+        while (b)
+        {
+            pa_items[i].psz_hid = psz_hid;
+            pa_items[i].blob_encoding = blob_encoding_to;
+            i++;
+            SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid, NULL)  );
+        }
+        SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+
+        SG_ERR_CHECK(  sg_pack__run(pCtx, pRepo, pa_items, i, SG_TRUE)  );
+    }
+
+    /* fall through */
+
+fail:
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+    SG_NULLFREE(pCtx, pa_items);
+    SG_RBTREE_NULLFREE(pCtx, prb_hids);
+}
+
+//////////////////////////////////////////////////////////////////
+
 void sg_pack__do_blob(SG_context* pCtx, const char* psz_gid, const char* psz_hid, SG_int32 gen, SG_rbtree* prb_blobs, SG_rbtree* prb_new)
 {
     SG_rbtree* prb = NULL;
     SG_bool b = SG_FALSE;
-    char buf[64];
+    char buf[16 + SG_HID_MAX_BUFFER_LENGTH];
 
     SG_ERR_CHECK(  SG_rbtree__find(pCtx, prb_new, psz_hid, &b, NULL)  );
     if (b)
@@ -36,8 +631,11 @@ void sg_pack__do_blob(SG_context* pCtx, const char* psz_gid, const char* psz_hid
             SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb)  );
             SG_ERR_CHECK(  SG_rbtree__add__with_assoc(pCtx, prb_blobs, psz_gid, prb)  );
         }
-        SG_ERR_CHECK(  SG_sprintf(pCtx, buf, sizeof(buf), "%05d", (int) gen)  );
-        SG_ERR_CHECK(  SG_rbtree__add__with_pooled_sz(pCtx, prb, buf, psz_hid)  );
+        /* Sort by generation.  The HID is part of the key because
+         * different branches can change the same file in the same
+         * generation. */
+        SG_ERR_CHECK(  SG_sprintf(pCtx, buf, sizeof(buf), "%010d.%s", (int) gen, psz_hid)  );
+        SG_ERR_CHECK(  SG_rbtree__update__with_pooled_sz(pCtx, prb, buf, psz_hid)  );
     }
 
     return;
@@ -144,7 +742,12 @@ fail:
 	SG_NULLFREE(pCtx, pBytes);
 }
 
-void sg_pack__do_changeset(SG_context* pCtx, SG_repo* pRepo, const char* psz_hid_cs, SG_rbtree* prb_blobs)
+/**
+ * Collect the blobs which are new in one changeset.  Instead of recursing
+ * into the parents, add the ones we haven't seen yet to prb_todo, so that
+ * history shared between several leaves is only walked once.
+ */
+static void sg_pack__do_changeset(SG_context* pCtx, SG_repo* pRepo, const char* psz_hid_cs, SG_rbtree* prb_blobs, SG_rbtree* prb_todo, SG_rbtree* prb_done)
 {
 	SG_changeset* pcs = NULL;
     SG_int32 gen = 0;
@@ -176,7 +779,7 @@ void sg_pack__do_changeset(SG_context* pCtx, SG_repo* pRepo, const char* psz_hid
         const char* psz_hid = NULL;
 
         SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_blobs, i, &psz_hid, NULL)  );
-        SG_ERR_CHECK(  SG_rbtree__add(pCtx, prb_new, psz_hid)  );
+        SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb_new, psz_hid)  );
     }
 
     /* and the treenode blobs */
@@ -188,7 +791,8 @@ void sg_pack__do_changeset(SG_context* pCtx, SG_repo* pRepo, const char* psz_hid
     {
         const char* psz_hid = NULL;
 
-        SG_ERR_CHECK(  SG_rbtree__add(pCtx, prb_new, psz_hid)  );
+        SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_blobs, i, &psz_hid, NULL)  );
+        SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb_new, psz_hid)  );
     }
 
     SG_ERR_CHECK(  sg_pack__do_get_dir__top(pCtx, pRepo, gen, psz_hid_root_treenode, prb_blobs, prb_new)  );
@@ -203,9 +807,15 @@ void sg_pack__do_changeset(SG_context* pCtx, SG_repo* pRepo, const char* psz_hid
         {
             const char* psz_hid = NULL;
 
+            SG_bool b_done = SG_FALSE;
+
             SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pva_parents, i, &psz_hid)  );
 
-            SG_ERR_CHECK(  sg_pack__do_changeset(pCtx, pRepo, psz_hid, prb_blobs)  );
+            SG_ERR_CHECK(  SG_rbtree__find(pCtx, prb_done, psz_hid, &b_done, NULL)  );
+            if (!b_done)
+            {
+                SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb_todo, psz_hid)  );
+            }
         }
     }
 
@@ -215,151 +825,245 @@ void sg_pack__do_changeset(SG_context* pCtx, SG_repo* pRepo, const char* psz_hid
 
 fail:
     SG_RBTREE_NULLFREE(pCtx, prb_new);
+    SG_CHANGESET_NULLFREE(pCtx, pcs);
 }
 
 void SG_repo__unpack(SG_context* pCtx, SG_repo * pRepo, SG_blob_encoding blob_encoding)
 {
-    SG_vhash* pvh = NULL;
-    SG_uint32 count = 0;
-    SG_uint32 i = 0;
-	SG_repo_tx_handle* pTx;
-
-    SG_ERR_CHECK(  SG_repo__list_blobs(pCtx, pRepo, blob_encoding, SG_FALSE, SG_FALSE, 500, 0, &pvh)  );
-    SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh, &count)  );
-    for (i=0; i<count; i++)
-    {
-        const char* psz_hid = NULL;
-        const SG_variant* pv = NULL;
-        SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh, i, &psz_hid, &pv)  );
-
-		// Not a lot of thought went into doing each of these in its own repo tx.  Consider alternatives.
-		SG_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-        SG_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, psz_hid, SG_BLOBENCODING__FULL, NULL, NULL, NULL, NULL, NULL)  );
-		SG_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
-    }
-    SG_VHASH_NULLFREE(pCtx, pvh);
+    SG_ERR_CHECK_RETURN(  sg_pack__change_all(pCtx, pRepo, blob_encoding, SG_BLOBENCODING__FULL)  );
+}
 
-    return;
+void SG_repo__pack__zlib(SG_context* pCtx, SG_repo * pRepo)
+{
+    SG_ERR_CHECK_RETURN(  sg_pack__change_all(pCtx, pRepo, SG_BLOBENCODING__FULL, SG_BLOBENCODING__ZLIB)  );
+}
 
-fail:
-    SG_VHASH_NULLFREE(pCtx, pvh);
+SG_free_callback _sg_repo__free_rbtree;
+void _sg_repo__free_rbtree(SG_context* pCtx, void* assocData)
+{
+	SG_rbtree__free(pCtx, (SG_rbtree*)assocData);
 }
 
-void SG_repo__pack__zlib(SG_context* pCtx, SG_repo * pRepo)
+/**
+ * Walk the history of every leaf and group the blobs which were added
+ * by a changeset by the GID of the file or directory they belong to.
+ */
+static void sg_pack__collect_blobs(SG_context* pCtx, SG_repo* pRepo, SG_rbtree** pprb_blobs)
 {
-    SG_vhash* pvh = NULL;
-    SG_uint32 count = 0;
-    SG_uint32 i = 0;
-	SG_repo_tx_handle* pTx;
+	SG_rbtree* prb_leaves = NULL;
+    SG_rbtree* prb_todo = NULL;
+    SG_rbtree* prb_done = NULL;
+    SG_rbtree* prb_blobs = NULL;
+    SG_rbtree_iterator* pit = NULL;
+    const char* psz_hid_cs = NULL;
+    char* psz_hid_cs_copy = NULL;
+    SG_bool b = SG_FALSE;
 
-    SG_ERR_CHECK(  SG_repo__list_blobs(pCtx, pRepo, SG_BLOBENCODING__FULL, SG_TRUE, SG_TRUE, 500, 0, &pvh)  );
-    SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh, &count)  );
-    SG_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-    for (i=0; i<count; i++)
+    SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb_blobs)  );
+    SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb_todo)  );
+    SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb_done)  );
+
+    SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo,SG_DAGNUM__VERSION_CONTROL,&prb_leaves)  );
+    SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_leaves, &b, &psz_hid_cs, NULL)  );
+    while (b)
     {
-        const char* psz_hid = NULL;
-        const SG_variant* pv = NULL;
-        SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh, i, &psz_hid, &pv)  );
-        SG_repo__change_blob_encoding(pCtx, pRepo, pTx,  psz_hid, SG_BLOBENCODING__ZLIB, NULL, NULL, NULL, NULL, NULL);
+        SG_ERR_CHECK(  SG_rbtree__update(pCtx, prb_todo, psz_hid_cs)  );
+        SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid_cs, NULL)  );
+    }
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
 
-		if (SG_context__has_err(pCtx))
+    while (1)
+    {
+        SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, NULL, prb_todo, &b, &psz_hid_cs, NULL)  );
+        if (!b)
         {
-            if (!SG_context__err_equals(pCtx,SG_ERR_REPO_BUSY))
-            {
-                SG_ERR_RETHROW;
-            }
-            else
-            {
-                SG_context__err_reset(pCtx);
-            }
+            break;
         }
+
+        SG_ERR_CHECK(  SG_STRDUP(pCtx, psz_hid_cs, &psz_hid_cs_copy)  );
+        SG_ERR_CHECK(  SG_rbtree__remove(pCtx, prb_todo, psz_hid_cs_copy)  );
+        SG_ERR_CHECK(  SG_rbtree__add(pCtx, prb_done, psz_hid_cs_copy)  );
+
+        SG_ERR_CHECK(  sg_pack__do_changeset(pCtx, pRepo, psz_hid_cs_copy, prb_blobs, prb_todo, prb_done)  );
+        SG_NULLFREE(pCtx, psz_hid_cs_copy);
     }
-    SG_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
-    SG_VHASH_NULLFREE(pCtx, pvh);
 
-    return;
+    *pprb_blobs = prb_blobs;
+    prb_blobs = NULL;
 
 fail:
-    SG_VHASH_NULLFREE(pCtx, pvh);
+    SG_NULLFREE(pCtx, psz_hid_cs_copy);
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+    SG_RBTREE_NULLFREE(pCtx, prb_leaves);
+    SG_RBTREE_NULLFREE(pCtx, prb_todo);
+    SG_RBTREE_NULLFREE(pCtx, prb_done);
+    SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, prb_blobs, _sg_repo__free_rbtree);
 }
 
-SG_free_callback _sg_repo__free_rbtree;
-void _sg_repo__free_rbtree(SG_context* pCtx, void* assocData)
+static void sg_pack__claim(SG_context* pCtx, SG_vhash* pvh_claimed, const char* psz_hid, SG_uint32 depth)
 {
-	SG_rbtree__free(pCtx, (SG_rbtree*)assocData);
+    SG_ERR_CHECK_RETURN(  SG_vhash__add__int64(pCtx, pvh_claimed, psz_hid, (SG_int64) depth)  );
 }
 
-void SG_repo__pack__vcdiff(SG_context* pCtx, SG_repo * pRepo)
+void SG_repo__pack__vcdiff__policy(SG_context* pCtx, SG_repo * pRepo, const SG_repo_pack_policy* pPolicy)
 {
-	SG_rbtree* prb_leaves = NULL;
-	SG_uint32 count_leaves = 0;
-    const char* psz_hid_cs = NULL;
     SG_rbtree* prb_blobs = NULL;
-    SG_bool b;
+    SG_vhash* pvh_claimed = NULL;
     SG_rbtree_iterator* pit = NULL;
     SG_rbtree_iterator* pit_for_gid = NULL;
-    SG_bool b_for_gid;
-    const char* psz_hid_ref = NULL;
-    const char* psz_hid_blob = NULL;
+    SG_bool b = SG_FALSE;
+    SG_bool b_for_gid = SG_FALSE;
     const char* psz_gid = NULL;
-    SG_rbtree* prb = NULL;
     const char* psz_gen = NULL;
-	SG_repo_tx_handle* pTx;
+    const char* psz_hid_blob = NULL;
+    SG_rbtree* prb = NULL;
+    const char** pa_versions = NULL;
+    my_pack_item* pa_first = NULL;
+    my_pack_item* pa_deltas = NULL;
+    SG_uint32 count_first = 0;
+    SG_uint32 count_deltas = 0;
+    SG_uint32 count_total = 0;
+    SG_uint32 count_max_for_gid = 0;
+    SG_vcdiff_options vcdiff_options;
 
-    SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo,SG_DAGNUM__VERSION_CONTROL,&prb_leaves)  );
-    SG_ERR_CHECK(  SG_rbtree__count(pCtx, prb_leaves, &count_leaves)  );
+    SG_NULLARGCHECK_RETURN(pPolicy);
+    SG_ARGCHECK_RETURN(pPolicy->max_chain_depth > 0, max_chain_depth);
+    SG_ERR_CHECK_RETURN(  SG_vcdiff__options__init(pCtx, &vcdiff_options, pPolicy->vcdiff_method)  );
 
-    SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, NULL, prb_leaves, &b, &psz_hid_cs, NULL)  );
+    SG_ERR_CHECK(  sg_pack__collect_blobs(pCtx, pRepo, &prb_blobs)  );
 
-    SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prb_blobs)  );
+    SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_blobs, &b, &psz_gid, (void**) &prb)  );
+    while (b)
+    {
+        SG_uint32 count_for_gid = 0;
+
+        SG_ERR_CHECK(  SG_rbtree__count(pCtx, prb, &count_for_gid)  );
+        count_total += count_for_gid;
+        if (count_for_gid > count_max_for_gid)
+        {
+            count_max_for_gid = count_for_gid;
+        }
+        SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_gid, (void**) &prb)  );
+    }
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
 
-    SG_ERR_CHECK(  sg_pack__do_changeset(pCtx, pRepo, psz_hid_cs, prb_blobs)  );
+    if (!count_total)
+    {
+        goto fail;
+    }
 
+    SG_ERR_CHECK(  SG_allocN(pCtx, count_max_for_gid, pa_versions)  );
+    SG_ERR_CHECK(  SG_allocN(pCtx, count_total, pa_first)  );
+    SG_ERR_CHECK(  SG_allocN(pCtx, count_total, pa_deltas)  );
+    SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_claimed)  );
+
+    /* Plan where every blob goes.  Each blob is claimed by exactly one
+     * chain (the first GID it shows up under), and a delta only ever
+     * points at a blob which was claimed before it, so the plan has no
+     * cycles even when the same contents appear under several GIDs.  A
+     * blob claimed by another chain can still be used as a reference; we
+     * just continue from its depth. */
     SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_blobs, &b, &psz_gid, (void**) &prb)  );
     while (b)
     {
         SG_uint32 count_for_gid = 0;
-        SG_ERR_CHECK(  SG_rbtree__count(pCtx, prb, &count_for_gid)  );
-        if (count_for_gid > 1)
+        SG_uint32 k = 0;
+        const char* psz_prev = NULL;
+        SG_uint32 depth_prev = 0;
+
+        SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit_for_gid, prb, &b_for_gid, &psz_gen, (void**) &psz_hid_blob)  );
+        while (b_for_gid)
         {
-            psz_hid_ref = NULL;
-            SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit_for_gid, prb, &b_for_gid, &psz_gen, (void**) &psz_hid_blob)  );
-            while (b_for_gid)
-            {
-				// Not a lot of thought went into doing each of these in its own repo tx.  Consider alternatives.
-				SG_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
+            pa_versions[count_for_gid++] = psz_hid_blob;
+            SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit_for_gid, &b_for_gid, &psz_gen, (void**) &psz_hid_blob)  );
+        }
+        SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit_for_gid);
 
-				if (psz_hid_ref)
-                {
-                    SG_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, psz_hid_blob, SG_BLOBENCODING__VCDIFF, psz_hid_ref, NULL, NULL, NULL, NULL)  );
-                    // TODO be tolerant here of SG_ERR_REPO_BUSY
-                }
-                else
-                {
-                    psz_hid_ref = psz_hid_blob;
+        // a file with only one version has nothing to be a delta against.
+        for (k=0; (count_for_gid > 1) && (k < count_for_gid); k++)
+        {
+            const char* psz_hid = pa_versions[pPolicy->b_reverse ? (count_for_gid - 1 - k) : k];
+            SG_bool b_claimed = SG_FALSE;
 
-                    SG_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, psz_hid_ref, SG_BLOBENCODING__FULL, NULL, NULL, NULL, NULL, NULL)  );
-                    // TODO be tolerant here of SG_ERR_REPO_BUSY
-                }
+            if (psz_prev && (0 == strcmp(psz_prev, psz_hid)))
+            {
+                continue;
+            }
+
+            SG_ERR_CHECK(  SG_vhash__has(pCtx, pvh_claimed, psz_hid, &b_claimed)  );
+            if (b_claimed)
+            {
+                SG_int64 depth = 0;
 
-				SG_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
+                SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh_claimed, psz_hid, &depth)  );
+                psz_prev = psz_hid;
+                depth_prev = (SG_uint32) depth;
+            }
+            else if (
+                    !psz_prev
+                    || (depth_prev + 1 > pPolicy->max_chain_depth)
+                    || (pPolicy->keyframe_interval && (0 == (k % pPolicy->keyframe_interval)))
+                    )
+            {
+                pa_first[count_first].psz_hid = psz_hid;
+                pa_first[count_first].blob_encoding = SG_BLOBENCODING__ZLIB;
+                count_first++;
 
-                SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit_for_gid, &b_for_gid, &psz_gen, (void**) &psz_hid_blob)  );
+                SG_ERR_CHECK(  sg_pack__claim(pCtx, pvh_claimed, psz_hid, 0)  );
+                psz_prev = psz_hid;
+                depth_prev = 0;
+            }
+            else
+            {
+                pa_first[count_first].psz_hid = psz_hid;
+                pa_first[count_first].psz_hid_ref = psz_prev;
+                pa_first[count_first].b_reset = SG_TRUE;
+                count_first++;
+
+                pa_deltas[count_deltas].psz_hid = psz_hid;
+                pa_deltas[count_deltas].blob_encoding = SG_BLOBENCODING__VCDIFF;
+                pa_deltas[count_deltas].psz_hid_ref = psz_prev;
+                pa_deltas[count_deltas].p_vcdiff_options = &vcdiff_options;
+                count_deltas++;
+
+                SG_ERR_CHECK(  sg_pack__claim(pCtx, pvh_claimed, psz_hid, depth_prev + 1)  );
+                psz_prev = psz_hid;
+                depth_prev++;
             }
-            SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit_for_gid);
-            psz_hid_ref = NULL;
         }
+
         SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_gid, (void**) &prb)  );
     }
     SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
 
+    /* The first run stores the keyframes and undoes any delta left over
+     * from an earlier pack which doesn't match the plan.  (Without that,
+     * an old delta of A against B plus a new delta of B against A would
+     * make a cycle.)  Only then do we make the new deltas. */
+    SG_ERR_CHECK(  sg_pack__run(pCtx, pRepo, pa_first, count_first, SG_FALSE)  );
+    SG_ERR_CHECK(  sg_pack__run(pCtx, pRepo, pa_deltas, count_deltas, SG_TRUE)  );
+
+    /* fall through */
+
+fail:
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit_for_gid);
+    SG_NULLFREE(pCtx, pa_versions);
+    SG_NULLFREE(pCtx, pa_first);
+    SG_NULLFREE(pCtx, pa_deltas);
+    SG_VHASH_NULLFREE(pCtx, pvh_claimed);
 	SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, prb_blobs, _sg_repo__free_rbtree);
+}
 
-    SG_RBTREE_NULLFREE(pCtx, prb_leaves);
+void SG_repo__pack__vcdiff(SG_context* pCtx, SG_repo * pRepo)
+{
+    SG_repo_pack_policy policy;
 
-    return;
+    policy.max_chain_depth = SG_REPO_PACK_POLICY__DEFAULT_MAX_CHAIN_DEPTH;
+    policy.keyframe_interval = SG_REPO_PACK_POLICY__DEFAULT_KEYFRAME_INTERVAL;
+    policy.b_reverse = SG_REPO_PACK_POLICY__DEFAULT_REVERSE;
+    policy.vcdiff_method = SG_REPO_PACK_POLICY__DEFAULT_VCDIFF_METHOD;
 
-fail:
-    return;
+    SG_ERR_CHECK_RETURN(  SG_repo__pack__vcdiff__policy(pCtx, pRepo, &policy)  );
 }
 
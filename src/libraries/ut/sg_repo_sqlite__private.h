@@ -173,6 +173,7 @@ struct _my_instance_data
 	char							buf_admin_id[SG_GID_BUFFER_LENGTH];
 
 	sqlite3*						psql;
+	sg_sqlite__stmt_cache*			pStmtCache;		// prepared statements for psql
 
 	sg_blob_sqlite_handle_store*	pBlobStoreHandle;
 
@@ -328,6 +329,18 @@ void sg_blob_sqlite__get_blob_stats(
 	SG_uint64* p_total_blob_size_vcdiff_encoded
 	);
 
+void sg_blob_sqlite__replace_blob_encoding(
+	SG_context* pCtx,
+	sg_repo_tx_sqlite_handle* pTx,
+	sqlite3 * psql,
+	const char* psz_hid_blob,
+	SG_blob_encoding blob_encoding,
+	const char* psz_hid_vcdiff_reference,
+	SG_uint64 len_full,
+	SG_uint32 len_encoded,
+	const SG_byte* p_encoded
+	);
+
 void sg_blob_sqlite__change_blob_encoding(
 	SG_context* pCtx,
 	sg_repo_tx_sqlite_handle* pTx,
@@ -335,6 +348,7 @@ void sg_blob_sqlite__change_blob_encoding(
 	const char* psz_hid_blob,
 	SG_blob_encoding blob_encoding_desired,
 	const char* psz_hid_vcdiff_reference_desired,
+	const SG_vcdiff_options* pVcdiffOptions,
 	SG_blob_encoding* p_blob_encoding_new,
 	char** ppsz_hid_vcdiff_reference,
 	SG_uint64* p_len_encoded,
@@ -113,6 +113,7 @@ struct _my_instance_data
     char						buf_admin_id[SG_GID_BUFFER_LENGTH];
 
     sqlite3*					psql;
+    sg_sqlite__stmt_cache*		pStmtCache;			// prepared statements for psql
 
     SG_bool                     b_in_sqlite_transaction;
 	sg_blob_fs2_handle_store*	pBlobStoreHandle;
@@ -134,6 +135,11 @@ typedef struct _my_tx_data my_tx_data;
 
 #define MY_CHUNK_SIZE			(16*1024)
 
+// blobs whose encoded bytes are read straight out of a data file
+// are memory-mapped when they are at least this big.  for smaller
+// ones, a read() is cheaper than setting up the mapping.
+#define MY_MMAP_MIN_LENGTH		(64*1024)
+
 struct _sg_blob_fs2_handle_fetch
 {
 	my_instance_data *			pData;
@@ -169,6 +175,10 @@ struct _sg_blob_fs2_handle_fetch
     SG_bool                     b_uncompressing;
 	z_stream zStream;
 	SG_byte bufCompressed[MY_CHUNK_SIZE];
+
+    /* mmap stuff */
+    SG_file_mapping*            pMapping;
+    const SG_byte*              p_mapped;		// the encoded bytes of the blob, when mapped
 };
 
 struct _sg_blob_fs2_handle_store
@@ -230,6 +240,16 @@ void sg_blob_fs2__fetch_blob__chunk(
     SG_bool* pb_done
     );
 
+void sg_blob_fs2__fetch_blob__chunk__span(
+    SG_context * pCtx,
+    sg_blob_fs2_handle_fetch* pbh,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    );
+
 void sg_blob_fs2__fetch_blob__end(
     SG_context * pCtx,
     sg_blob_fs2_handle_fetch** ppbh
@@ -353,7 +373,7 @@ static void my_fetch_info(
     SG_uint32 filenumber = 0;
     SG_uint64 offset = 0;
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pData->psql,&pStmt,
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pData->psql, pData->pStmtCache, &pStmt,
 									  "SELECT encoding, len_encoded, len_full, hid_vcdiff, filenumber, offset FROM directory WHERE hid = ?")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,szHidBlob)  );
 
@@ -389,7 +409,7 @@ static void my_fetch_info(
 
         SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
 
-        SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+        SG_ERR_CHECK(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
 
         if (lock)
         {
@@ -423,7 +443,7 @@ static void my_fetch_info(
     else if (SQLITE_DONE == rc)
     {
 		SG_context__err__generic(pCtx, SG_ERR_BLOB_NOT_FOUND, __FILE__, __LINE__);
-        SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+        SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
     }
     else
     {
@@ -433,7 +453,7 @@ static void my_fetch_info(
 	return;
 
 fail:
-	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
 }
 
 void sg_blob_fs2__sql__fetch_info(
@@ -1437,6 +1457,25 @@ fail:
     SG_PATHNAME_NULLFREE(pCtx, pPath_tempfile);
 }
 
+/**
+ * Try to map the encoded bytes of this blob out of its (already open)
+ * data file.  If the mapping can't be made, we quietly leave the handle
+ * reading through m_pFileBlob.
+ */
+static void _map_blob_for_reading(SG_context * pCtx, sg_blob_fs2_handle_fetch * pbh)
+{
+	if (pbh->len_encoded_stored < MY_MMAP_MIN_LENGTH)
+		return;
+
+	SG_file__mmap(pCtx, pbh->m_pFileBlob, pbh->offset, pbh->len_encoded_stored, &pbh->pMapping, &pbh->p_mapped);
+	if (SG_context__has_err(pCtx))
+	{
+		SG_context__err_reset(pCtx);
+		pbh->pMapping = NULL;
+		pbh->p_mapped = NULL;
+	}
+}
+
 static void sg_fs2__open_blob_for_reading(
 	SG_context * pCtx,
     my_instance_data* pData,
@@ -1517,6 +1556,13 @@ static void sg_fs2__open_blob_for_reading(
             SG_ERR_CHECK(  SG_file__seek(pCtx, pbh->m_pFileBlob, pbh->offset)  );
         }
 
+        // when we undeltify, the bytes are read by a second handle on the
+        // delta, so there is no point mapping them here.
+        if (!(b_convert_to_full && (SG_BLOBENCODING__VCDIFF == pbh->blob_encoding_stored)))
+        {
+            SG_ERR_CHECK(  _map_blob_for_reading(pCtx, pbh)  );
+        }
+
         if (
                 SG_IS_BLOBENCODING_FULL(pbh->blob_encoding_stored)
                 || b_convert_to_full
@@ -1561,6 +1607,9 @@ static void _sg_blob_handle__close(SG_context * pCtx, sg_blob_fs2_handle_fetch *
 		SG_ERR_IGNORE(  sg_repo__fs2__hash__abort(pCtx, pbh->pData->pRepo, &pbh->pRHH_VerifyOnFetch)  );
 	}
 
+	SG_ERR_IGNORE(  SG_file__munmap(pCtx, &pbh->pMapping)  );
+	pbh->p_mapped = NULL;
+
 	SG_FILE_NULLCLOSE(pCtx, pbh->m_pFileBlob);
     SG_NULLFREE(pCtx, pbh->psz_hid_vcdiff_reference_stored);
 
@@ -1728,7 +1777,19 @@ void sg_blob_fs2__fetch_blob__chunk(
     {
         int zError;
 
-        if (0 == pbh->zStream.avail_in)
+        if ((0 == pbh->zStream.avail_in) && pbh->p_mapped)
+        {
+            // feed the inflater straight from the mapping rather than
+            // copying through bufCompressed.
+            SG_uint64 left = pbh->len_encoded_stored - pbh->len_encoded_observed;
+            uInt want = (left > 0x7fffffff) ? 0x7fffffff : (uInt) left;
+
+            pbh->zStream.next_in = (Bytef*) (pbh->p_mapped + pbh->len_encoded_observed);
+            pbh->zStream.avail_in = want;
+
+            pbh->len_encoded_observed += want;
+        }
+        else if (0 == pbh->zStream.avail_in)
         {
             SG_uint32 want = sizeof(pbh->bufCompressed);
             if (want > (pbh->len_encoded_stored - pbh->len_encoded_observed))
@@ -1834,10 +1895,18 @@ void sg_blob_fs2__fetch_blob__chunk(
             want = (SG_uint32)(pbh->len_encoded_stored - pbh->len_encoded_observed);
         }
 
-        SG_file__read(pCtx, pbh->m_pFileBlob, want, p_buf, &nbr);
-        if(SG_context__has_err(pCtx) && !SG_context__err_equals(pCtx, SG_ERR_EOF))
+        if (pbh->p_mapped)
         {
-			SG_ERR_RETHROW_RETURN;
+            memcpy(p_buf, pbh->p_mapped + pbh->len_encoded_observed, want);
+            nbr = want;
+        }
+        else
+        {
+            SG_file__read(pCtx, pbh->m_pFileBlob, want, p_buf, &nbr);
+            if(SG_context__has_err(pCtx) && !SG_context__err_equals(pCtx, SG_ERR_EOF))
+            {
+                SG_ERR_RETHROW_RETURN;
+            }
         }
 
         pbh->len_encoded_observed += nbr;
@@ -1868,6 +1937,57 @@ fail:
     return;
 }
 
+/**
+ * Like sg_blob_fs2__fetch_blob__chunk(), but when the bytes we would
+ * return are sitting in a mapping, hand back a pointer into it instead
+ * of copying them.  Otherwise, fill p_buf and point at that.
+ */
+void sg_blob_fs2__fetch_blob__chunk__span(
+    SG_context * pCtx,
+    sg_blob_fs2_handle_fetch* pbh,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    )
+{
+    SG_uint32 want;
+    const SG_byte* p = NULL;
+
+    if (!pbh->p_mapped || pbh->b_uncompressing || pbh->b_undeltifying)
+    {
+        SG_ERR_CHECK_RETURN(  sg_blob_fs2__fetch_blob__chunk(pCtx, pbh, len_buf, p_buf, p_len_got, pb_done)  );
+        *pp_span = p_buf;
+        return;
+    }
+
+    want = len_buf;
+    if (want > (pbh->len_encoded_stored - pbh->len_encoded_observed))
+    {
+        want = (SG_uint32)(pbh->len_encoded_stored - pbh->len_encoded_observed);
+    }
+
+    p = pbh->p_mapped + pbh->len_encoded_observed;
+    pbh->len_encoded_observed += want;
+
+    if (want)
+    {
+        if (pbh->pRHH_VerifyOnFetch)
+        {
+            SG_ERR_CHECK_RETURN(  sg_repo__fs2__hash__chunk(pCtx, pbh->pData->pRepo, pbh->pRHH_VerifyOnFetch, want, (SG_byte*) p)  );
+        }
+        if (SG_IS_BLOBENCODING_FULL(pbh->blob_encoding_returning))
+        {
+            pbh->len_full_observed += want;
+        }
+    }
+
+    *pp_span = p;
+    *p_len_got = want;
+    *pb_done = (pbh->len_encoded_observed == pbh->len_encoded_stored);
+}
+
 void sg_blob_fs2__fetch_blob__end(
     SG_context * pCtx,
     sg_blob_fs2_handle_fetch** ppbh
@@ -2118,7 +2238,8 @@ void sg_blob_fs2__change_encoding_to_vcdiff(
     SG_context * pCtx,
     my_tx_data* ptx,
     const char* psz_hid_blob,
-    const char* psz_hid_vcdiff_reference
+    const char* psz_hid_vcdiff_reference,
+    const SG_vcdiff_options* pVcdiffOptions
     )
 {
     sg_blob_fs2_handle_fetch* pbh_target = NULL;
@@ -2180,14 +2301,16 @@ void sg_blob_fs2__change_encoding_to_vcdiff(
                 NULL,
                 &pstrmDelta)  );
 
-    SG_ERR_CHECK(  SG_vcdiff__deltify__streams(pCtx, psr_reference, pstrmTarget, pstrmDelta)  );
+    SG_ERR_CHECK(  SG_vcdiff__deltify__streams__options(pCtx, psr_reference, pstrmTarget, pstrmDelta, pVcdiffOptions)  );
 
     SG_ERR_CHECK(  SG_readstream__close(pCtx, pstrmTarget)  );
     pstrmTarget = NULL;
-    SG_ERR_CHECK(  SG_writestream__close(pCtx, pstrmDelta)  );
+    SG_writestream__close(pCtx, pstrmDelta);
     pstrmDelta = NULL;
-    SG_ERR_CHECK(  SG_seekreader__close(pCtx, psr_reference)  );
+    SG_ERR_CHECK_CURRENT;
+    SG_seekreader__close(pCtx, psr_reference);
     psr_reference = NULL;
+    SG_ERR_CHECK_CURRENT;
 
     if (pPath_tempfile)
     {
@@ -2211,12 +2334,71 @@ fail:
     }
 }
 
+static void sg_blob_fs2__replace_blob_encoding(
+    SG_context * pCtx,
+    my_tx_data* ptx,
+    const char* psz_hid_blob,
+    SG_blob_encoding blob_encoding,
+    const char* psz_hid_vcdiff_reference,
+    SG_uint64 len_full,
+    SG_uint32 len_encoded,
+    const SG_byte* p_encoded
+    )
+{
+    sg_blob_fs2_handle_fetch* pbh_orig = NULL;
+    sg_blob_fs2_handle_store* pbh_new = NULL;
+
+	SG_NULLARGCHECK_RETURN(ptx);
+	SG_NULLARGCHECK_RETURN(psz_hid_blob);
+	SG_NULLARGCHECK_RETURN(p_encoded);
+
+    /* We only need the old file number and the drill lock.  The new
+     * contents came from the caller. */
+    SG_ERR_CHECK(  sg_blob_fs2__fetch_blob__begin(pCtx,
+                ptx->pData,
+                psz_hid_blob,
+                SG_FS2__LOCK__DRILL,
+                SG_FALSE,
+                NULL,
+                NULL,
+                NULL,
+                NULL,
+                NULL,
+                &pbh_orig)  );
+
+    // move the drill lock into the tx
+    SG_ERR_CHECK(  SG_rbtree__add__with_assoc(pCtx, ptx->prb_drill_locks, psz_hid_blob, pbh_orig->pPath_readlock)  );
+    pbh_orig->pPath_readlock = NULL;
+
+    SG_ERR_CHECK(  my_sg_blob_fs2__store_blob__begin(pCtx,
+                ptx,
+                blob_encoding,
+                psz_hid_vcdiff_reference,
+                SG_FALSE,
+                SG_IS_BLOBENCODING_FULL(blob_encoding) ? 0 : len_encoded,
+                len_full,
+                psz_hid_blob,
+                &pbh_new)  );
+    pbh_new->old_filenumber = pbh_orig->filenumber;
+
+    SG_ERR_CHECK(  sg_blob_fs2__store_blob__chunk(pCtx, pbh_new, len_encoded, p_encoded, NULL)  );
+    SG_ERR_CHECK(  sg_blob_fs2__store_blob__end(pCtx, &pbh_new, NULL)  );
+    SG_ERR_CHECK(  sg_blob_fs2__fetch_blob__abort(pCtx, &pbh_orig)  );
+
+    return;
+
+fail:
+    SG_ERR_IGNORE(  sg_blob_fs2__store_blob__abort(pCtx, &pbh_new)  );
+    SG_ERR_IGNORE(  sg_blob_fs2__fetch_blob__abort(pCtx, &pbh_orig)  );
+}
+
 void sg_blob_fs2__change_blob_encoding(
     SG_context * pCtx,
     my_tx_data* ptx,
     const char* psz_hid_blob,
     SG_blob_encoding blob_encoding_desired,
     const char* psz_hid_vcdiff_reference_desired,
+    const SG_vcdiff_options* pVcdiffOptions,
     SG_blob_encoding* p_blob_encoding_new,
     char** ppsz_hid_vcdiff_reference,
     SG_uint64* p_len_encoded,
@@ -2298,7 +2480,8 @@ void sg_blob_fs2__change_blob_encoding(
                     SG_ERR_CHECK(  sg_blob_fs2__change_encoding_to_vcdiff(pCtx,
                                 ptx,
                                 psz_hid_blob,
-                                psz_hid_vcdiff_reference_desired
+                                psz_hid_vcdiff_reference_desired,
+                                pVcdiffOptions
                                 )  );
                 }
 
@@ -2959,6 +3142,7 @@ void sg_repo__fs2__open_repo_instance(SG_context * pCtx, SG_repo * pRepo)
 
 	// all is well.
 
+    SG_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pData->pStmtCache)  );
     pData->psql = psql;
 	return;
 
@@ -3069,6 +3253,7 @@ void sg_repo__fs2__create_repo_instance(
     /* Tell the dag code to create its sql db */
 	SG_ERR_CHECK(  _my_make_db_pathname(pCtx, pData,&pPathnameSqlDb)  );
     SG_ERR_CHECK(  SG_dag_sqlite3__create(pCtx, pPathnameSqlDb, &pData->psql)  );
+    SG_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pData->pStmtCache)  );
 
     // Now we add our stuff into that same db
 	SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pData->psql, "BEGIN EXCLUSIVE TRANSACTION")  );
@@ -3130,6 +3315,7 @@ fail:
         SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pData->psql, "ROLLBACK TRANSACTION")  );
         pData->b_in_sqlite_transaction = SG_FALSE;
     }
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pData->pStmtCache);
 	SG_NULLFREE(pCtx, pData);
 	SG_NULLFREE(pCtx, pszTrivialHash);
 }
@@ -3173,6 +3359,7 @@ void sg_repo__fs2__close_repo_instance(SG_context * pCtx, SG_repo * pRepo)
 
 	// TODO should we assert that we are not in a transaction?  YES, or error code.
 
+    SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pData->pStmtCache);
     SG_ERR_IGNORE(  SG_dag_sqlite3__nullclose(pCtx, &pData->psql)  );
 
 	SG_PATHNAME_NULLFREE(pCtx, pData->pPathParentDir);
@@ -3191,7 +3378,7 @@ void sg_repo__fs2__fetch_dagnode(SG_context * pCtx, SG_repo * pRepo, const char*
 	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
 
     SG_RETRY_THINGIE(
-            SG_dag_sqlite3__fetch_dagnode(pCtx,pData->psql, pszidHidChangeset, ppNewDagnode)
+            SG_dag_sqlite3__fetch_dagnode(pCtx,pData->psql, pData->pStmtCache, pszidHidChangeset, ppNewDagnode)
             );
 
 fail:
@@ -3256,6 +3443,24 @@ fail:
     return;
 }
 
+void sg_repo__fs2__fetch_dagindex(
+    SG_context * pCtx,
+    SG_repo* pRepo,
+    SG_uint32 iDagNum,
+    SG_dagindex ** ppIndex
+    )
+{
+	my_instance_data * pData = NULL;
+	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
+
+    SG_RETRY_THINGIE(
+        SG_dag_sqlite3__get_dagindex(pCtx, pData->psql, iDagNum, ppIndex)
+        );
+
+fail:
+    return;
+}
+
 void sg_repo__fs2__check_dag_consistency(SG_context * pCtx, SG_repo * pRepo, SG_uint32 iDagNum)	// must match FN_
 {
 	// I consider this to be a DEBUG routine.  But I'm putting it
@@ -3559,6 +3764,22 @@ fail:
     return;
 }
 
+void sg_repo__fs2__fetch_blob__chunk__span(
+    SG_context * pCtx,
+    SG_repo * pRepo,
+    SG_repo_fetch_blob_handle* pHandle,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    )
+{
+	SG_NULLARGCHECK_RETURN(pRepo);
+
+    SG_ERR_CHECK_RETURN(  sg_blob_fs2__fetch_blob__chunk__span(pCtx, (sg_blob_fs2_handle_fetch*) pHandle, len_buf, p_buf, pp_span, p_len_got, pb_done)  );
+}
+
 void sg_repo__fs2__fetch_blob__end(
     SG_context * pCtx,
     SG_repo * pRepo,
@@ -3638,7 +3859,7 @@ static void _build_repo_fragball(
 			while ((rc=sqlite3_step(pStmt)) == SQLITE_ROW)
 			{
 				pszHid = (const char*)sqlite3_column_text(pStmt, 0);
-				SG_ERR_CHECK(  SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pszHid, &pDagnode)  );
+				SG_ERR_CHECK(  SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pData->pStmtCache, pszHid, &pDagnode)  );
 				SG_ERR_CHECK(  SG_dagfrag__add_dagnode(pCtx, pFrag, &pDagnode)  );
 			}
 			SG_ERR_CHECK(  sg_sqlite__reset(pCtx, pStmt)  );
@@ -3741,7 +3962,8 @@ void sg_repo__fs2__get_blob_stats(
     SG_uint64* p_total_blob_size_zlib_full,
     SG_uint64* p_total_blob_size_zlib_encoded,
     SG_uint64* p_total_blob_size_vcdiff_full,
-    SG_uint64* p_total_blob_size_vcdiff_encoded
+    SG_uint64* p_total_blob_size_vcdiff_encoded,
+    SG_vhash** ppvh_chain_depths
     )
 {
 	my_instance_data * pData = NULL;
@@ -3765,6 +3987,13 @@ void sg_repo__fs2__get_blob_stats(
         )
         );
 
+    if (ppvh_chain_depths)
+    {
+        SG_RETRY_THINGIE(
+            sg_repo_utils__get_chain_depths(pCtx, pData->psql, "SELECT hid, hid_vcdiff FROM directory", ppvh_chain_depths)
+            );
+    }
+
 fail:
     return;
 }
@@ -3790,6 +4019,7 @@ void sg_repo__fs2__change_blob_encoding(
     const char* psz_hid_blob,
     SG_blob_encoding blob_encoding_desired,
     const char* psz_hid_vcdiff_reference_desired,
+    const SG_vcdiff_options* pVcdiffOptions,
     SG_blob_encoding* p_blob_encoding_new,
     char** ppsz_hid_vcdiff_reference,
     SG_uint64* p_len_encoded,
@@ -3798,7 +4028,24 @@ void sg_repo__fs2__change_blob_encoding(
 {
     SG_NULLARGCHECK_RETURN(pRepo);
 
-    SG_ERR_CHECK_RETURN(  sg_blob_fs2__change_blob_encoding(pCtx, (my_tx_data*) ptx, psz_hid_blob, blob_encoding_desired, psz_hid_vcdiff_reference_desired, p_blob_encoding_new, ppsz_hid_vcdiff_reference, p_len_encoded, p_len_full)  );
+    SG_ERR_CHECK_RETURN(  sg_blob_fs2__change_blob_encoding(pCtx, (my_tx_data*) ptx, psz_hid_blob, blob_encoding_desired, psz_hid_vcdiff_reference_desired, pVcdiffOptions, p_blob_encoding_new, ppsz_hid_vcdiff_reference, p_len_encoded, p_len_full)  );
+}
+
+void sg_repo__fs2__replace_blob_encoding(
+    SG_context * pCtx,
+    SG_repo * pRepo,
+	SG_repo_tx_handle* ptx,
+    const char* psz_hid_blob,
+    SG_blob_encoding blob_encoding,
+    const char* psz_hid_vcdiff_reference,
+    SG_uint64 len_full,
+    SG_uint32 len_encoded,
+    const SG_byte* p_encoded
+    )
+{
+    SG_NULLARGCHECK_RETURN(pRepo);
+
+    SG_ERR_CHECK_RETURN(  sg_blob_fs2__replace_blob_encoding(pCtx, (my_tx_data*) ptx, psz_hid_blob, blob_encoding, psz_hid_vcdiff_reference, len_full, len_encoded, p_encoded)  );
 }
 
 void sg_fs2__remove_lock_files(
@@ -4145,7 +4392,7 @@ void sg_repo__fs2__check_dagfrag(
 {
 	my_instance_data * pData = NULL;
 	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
-    SG_ERR_CHECK_RETURN(  SG_dag_sqlite3__check_frag(pCtx, pData->psql, pFrag, pbConnected, ppIdsetMissing, ppsa_new, pprbLeaves)  );
+    SG_ERR_CHECK_RETURN(  SG_dag_sqlite3__check_frag(pCtx, pData->psql, pData->pStmtCache, pFrag, pbConnected, ppIdsetMissing, ppsa_new, pprbLeaves)  );
 }
 
 void sg_repo__fs2__store_dagfrag(
@@ -4517,6 +4764,13 @@ void sg_repo__fs2__query_implementation(
 			return;
 		}
 
+	case SG_REPO__QUESTION__BOOL__SUPPORTS_CONCURRENT_TX:
+		{
+			SG_NULLARGCHECK_RETURN(p_bool);
+			*p_bool = SG_TRUE;
+			return;
+		}
+
 	default:
 		SG_ERR_THROW_RETURN(  SG_ERR_NOTIMPLEMENTED  );
 	}
@@ -4743,3 +4997,26 @@ fail:
     return;
 }
 
+void sg_repo__fs2__get_refcache_stats(
+    SG_context* pCtx,
+    SG_repo * pRepo,
+    SG_vhash** ppvhStats
+    )
+{
+	SG_UNUSED(pRepo);
+	SG_UNUSED(ppvhStats);
+
+	// no reference cache here.
+	SG_ERR_THROW_RETURN(  SG_ERR_NOTIMPLEMENTED  );
+}
+
+void sg_repo__fs2__drop_caches(
+    SG_context* pCtx,
+    SG_repo * pRepo
+    )
+{
+	SG_UNUSED(pCtx);
+	SG_UNUSED(pRepo);
+
+	// nothing cached here beyond what the dag code keeps in SG_repo.
+}
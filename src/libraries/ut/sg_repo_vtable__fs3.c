@@ -123,6 +123,7 @@ struct _my_instance_data
     char						buf_admin_id[SG_GID_BUFFER_LENGTH];
 
     sqlite3*					psql;
+    sg_sqlite__stmt_cache*		pStmtCache;			// prepared statements for psql
 
     SG_bool                     b_in_sqlite_transaction;
 	sg_blob_fs3_handle_store*	pBlobStoreHandle;
@@ -132,6 +133,15 @@ struct _my_instance_data
     SG_rbtree*                  prb_blob_info;
 
     SG_rbtree*                  prb_paths;
+
+    // cache of reconstructed vcdiff reference blobs, keyed by HID.
+    // see sg_fs3__refcache__open_seekreader().
+    SG_rbtree*                  prb_refcache;
+    SG_uint64                   refcache_clock;
+    SG_uint64                   refcache_bytes_memory;
+    SG_uint64                   refcache_bytes_disk;
+    SG_uint32                   refcache_hits;
+    SG_uint32                   refcache_misses;
 };
 typedef struct _my_instance_data my_instance_data;
 
@@ -148,6 +158,11 @@ typedef struct _my_tx_data my_tx_data;
 
 #define MY_CHUNK_SIZE			(16*1024)
 
+// blobs whose encoded bytes are read straight out of a data file
+// are memory-mapped when they are at least this big.  for smaller
+// ones, a read() is cheaper than setting up the mapping.
+#define MY_MMAP_MIN_LENGTH		(64*1024)
+
 struct _sg_blob_fs3_handle_fetch
 {
 	my_instance_data *			pData;
@@ -172,7 +187,6 @@ struct _sg_blob_fs3_handle_fetch
     sg_blob_fs3_handle_fetch* pbh_delta;
     SG_readstream* pstrm_delta;
     SG_seekreader* psr_reference;
-    SG_pathname* pPath_tempfile;
     SG_byte* p_buf;
     SG_uint32 count;
     SG_uint32 next;
@@ -182,6 +196,10 @@ struct _sg_blob_fs3_handle_fetch
 	z_stream zStream;
 	SG_byte bufCompressed[MY_CHUNK_SIZE];
 
+    /* mmap stuff */
+    SG_file_mapping*            pMapping;
+    const SG_byte*              p_mapped;		// the encoded bytes of the blob, when mapped
+
 	SG_bool						b_we_own_file; // When closing the handle, should we close the file?
 };
 
@@ -244,6 +262,16 @@ void sg_blob_fs3__fetch_blob__chunk(
     SG_bool* pb_done
     );
 
+void sg_blob_fs3__fetch_blob__chunk__span(
+    SG_context * pCtx,
+    sg_blob_fs3_handle_fetch* pbh,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    );
+
 void sg_blob_fs3__fetch_blob__end(
     SG_context * pCtx,
     sg_blob_fs3_handle_fetch** ppbh
@@ -406,7 +434,7 @@ static void my_fetch_info(
         return;
     }
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pData->psql,&pStmt,
+	SG_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, pData->psql, pData->pStmtCache, &pStmt,
 									  "SELECT encoding, len_encoded, len_full, hid_vcdiff, filenumber, offset, objectid FROM directory WHERE hid = ?")  );
 	SG_ERR_CHECK(  sg_sqlite__bind_text(pCtx, pStmt,1,szHidBlob)  );
 
@@ -456,7 +484,7 @@ static void my_fetch_info(
 
         SG_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_DONE)  );
 
-        SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+        SG_ERR_CHECK(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
 
         if (p_blob_encoding)
         {
@@ -482,7 +510,7 @@ static void my_fetch_info(
     else if (SQLITE_DONE == rc)
     {
 		SG_context__err__generic(pCtx, SG_ERR_BLOB_NOT_FOUND, __FILE__, __LINE__);
-        SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+        SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
     }
     else
     {
@@ -492,7 +520,7 @@ static void my_fetch_info(
 	return;
 
 fail:
-	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+	SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
 }
 
 void sg_blob_fs3_handle_store__free(SG_context* pCtx, sg_blob_fs3_handle_store* pbh)
@@ -1315,34 +1343,382 @@ fail:
     SG_NULLFREE(pCtx, p_buf);
 }
 
-static void sg_blob_fs3__open_seekreader(
+//////////////////////////////////////////////////////////////////
+// Reference blob cache.
+//
+// When we undeltify a VCDIFF blob, the vcdiff reference needs to be
+// available in full through a seekreader.  The reference may itself
+// be a delta, so without a cache every fetch of a deep chain rebuilds
+// every link from scratch.
+//
+// We keep the most recently used reconstructions around for the life
+// of the repo instance.  Small ones are kept in memory.  Large ones
+// stay in the tempfile they were reconstructed into.  Both kinds are
+// bounded and evicted least-recently-used first.  Since blobs are
+// content-addressed, entries never need to be invalidated.
+//
+// An entry is pinned while a seekreader is open on it, so we never
+// evict something that an undeltify in progress is reading.
+
+#define MY_REFCACHE__MAX_MEMORY_BLOB	(1024*1024)
+#define MY_REFCACHE__MAX_MEMORY_TOTAL	(16*1024*1024)
+#define MY_REFCACHE__MAX_DISK_TOTAL		(256*1024*1024)
+
+struct my_refcache_entry
+{
+    SG_uint64 len;
+    SG_byte* p_buf;					// the full blob, if small enough to keep in memory
+    SG_pathname* pPath_spill;		// otherwise, the tempfile holding the full blob
+    SG_uint32 count_readers;
+    SG_uint64 last_used;
+};
+
+struct my_refcache_reader
+{
+    struct my_refcache_entry* pEntry;
+    SG_file* pFile;
+    SG_uint64 pos;
+};
+
+static void sg_fs3__refcache__free_entry(SG_context * pCtx, struct my_refcache_entry* pEntry)
+{
+    if (!pEntry)
+        return;
+
+    if (pEntry->pPath_spill)
+    {
+        SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pEntry->pPath_spill)  );
+        SG_PATHNAME_NULLFREE(pCtx, pEntry->pPath_spill);
+    }
+    SG_NULLFREE(pCtx, pEntry->p_buf);
+    SG_NULLFREE(pCtx, pEntry);
+}
+
+static void sg_fs3__refcache__reader__read(
+	SG_context * pCtx,
+    struct my_refcache_reader* pReader,
+    SG_uint32 iNumBytesWanted,
+    SG_byte* pBytes,
+    SG_uint32* piNumBytesRetrieved
+    )
+{
+    SG_uint32 got = 0;
+
+    if (pReader->pFile)
+    {
+        SG_ERR_CHECK_RETURN(  SG_file__read(pCtx, pReader->pFile, iNumBytesWanted, pBytes, &got)  );
+    }
+    else
+    {
+        if (pReader->pos >= pReader->pEntry->len)
+        {
+            SG_ERR_THROW_RETURN(  SG_ERR_EOF  );
+        }
+
+        got = iNumBytesWanted;
+        if (got > (pReader->pEntry->len - pReader->pos))
+        {
+            got = (SG_uint32) (pReader->pEntry->len - pReader->pos);
+        }
+        memcpy(pBytes, pReader->pEntry->p_buf + pReader->pos, got);
+    }
+
+    pReader->pos += got;
+
+    if (piNumBytesRetrieved)
+    {
+        *piNumBytesRetrieved = got;
+    }
+}
+
+static void sg_fs3__refcache__reader__seek(
+	SG_context * pCtx,
+    struct my_refcache_reader* pReader,
+    SG_uint64 iPos
+    )
+{
+    if (pReader->pFile)
+    {
+        SG_ERR_CHECK_RETURN(  SG_file__seek(pCtx, pReader->pFile, iPos)  );
+    }
+
+    pReader->pos = iPos;
+}
+
+static void sg_fs3__refcache__reader__close(
+	SG_context * pCtx,
+    struct my_refcache_reader* pReader
+    )
+{
+    if (!pReader)
+        return;
+
+    SG_FILE_NULLCLOSE(pCtx, pReader->pFile);
+
+    SG_ASSERT(pReader->pEntry->count_readers > 0);
+    pReader->pEntry->count_readers--;
+
+    SG_NULLFREE(pCtx, pReader);
+}
+
+/**
+ * Throw out least-recently-used entries until both the memory and
+ * the disk totals are within their limits, or until everything left
+ * is pinned.
+ */
+static void sg_fs3__refcache__evict(
+	SG_context * pCtx,
+    my_instance_data* pData
+    )
+{
+    SG_rbtree_iterator* pit = NULL;
+
+    while (
+            (pData->refcache_bytes_memory > MY_REFCACHE__MAX_MEMORY_TOTAL)
+            || (pData->refcache_bytes_disk > MY_REFCACHE__MAX_DISK_TOTAL)
+          )
+    {
+        SG_bool b = SG_FALSE;
+        const char* psz_hid = NULL;
+        struct my_refcache_entry* pEntry = NULL;
+        const char* psz_hid_victim = NULL;
+        struct my_refcache_entry* pVictim = NULL;
+        SG_bool b_memory_over = (pData->refcache_bytes_memory > MY_REFCACHE__MAX_MEMORY_TOTAL);
+
+        SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, pData->prb_refcache, &b, &psz_hid, (void**) &pEntry)  );
+        while (b)
+        {
+            if (
+                    (0 == pEntry->count_readers)
+                    && ((pEntry->p_buf != NULL) == b_memory_over)
+                    && (!pVictim || (pEntry->last_used < pVictim->last_used))
+               )
+            {
+                psz_hid_victim = psz_hid;
+                pVictim = pEntry;
+            }
+            SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid, (void**) &pEntry)  );
+        }
+        SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+
+        if (!pVictim)
+        {
+            break;
+        }
+
+        if (pVictim->p_buf)
+        {
+            pData->refcache_bytes_memory -= pVictim->len;
+        }
+        else
+        {
+            pData->refcache_bytes_disk -= pVictim->len;
+        }
+
+        SG_ERR_CHECK(  SG_rbtree__remove(pCtx, pData->prb_refcache, psz_hid_victim)  );
+        SG_ERR_IGNORE(  sg_fs3__refcache__free_entry(pCtx, pVictim)  );
+    }
+
+    return;
+
+fail:
+    SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+}
+
+static void sg_fs3__refcache__add(
 	SG_context * pCtx,
     my_instance_data* pData,
-	const char* szHidBlob, // HID of BLOBFILE that we want
-	SG_seekreader** ppsr,
-	SG_pathname** ppPath_tempfile
+	const char* psz_hid_blob,
+    struct my_refcache_entry** ppEntry
+    )
+{
+    struct my_refcache_entry* pEntry = NULL;
+    SG_pathname* pPath_tempfile = NULL;
+    SG_file* pFile = NULL;
+
+    SG_ERR_CHECK(  sg_fs3__fetch_blob_into_tempfile(pCtx, pData, psz_hid_blob, &pPath_tempfile)  );
+
+    SG_ERR_CHECK(  SG_alloc1(pCtx, pEntry)  );
+    SG_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPath_tempfile, &pEntry->len, NULL)  );
+
+    if (pEntry->len <= MY_REFCACHE__MAX_MEMORY_BLOB)
+    {
+        SG_uint32 sofar = 0;
+
+        SG_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32) pEntry->len + 1, pEntry->p_buf)  );
+        SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPath_tempfile, SG_FILE_RDONLY | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFile)  );
+        while (sofar < pEntry->len)
+        {
+            SG_uint32 got = 0;
+
+            SG_ERR_CHECK(  SG_file__read(pCtx, pFile, (SG_uint32) pEntry->len - sofar, pEntry->p_buf + sofar, &got)  );
+            sofar += got;
+        }
+        SG_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+
+        SG_ERR_CHECK(  SG_fsobj__remove__pathname(pCtx, pPath_tempfile)  );
+        SG_PATHNAME_NULLFREE(pCtx, pPath_tempfile);
+    }
+    else
+    {
+        pEntry->pPath_spill = pPath_tempfile;
+        pPath_tempfile = NULL;
+    }
+
+    SG_ERR_CHECK(  SG_rbtree__add__with_assoc(pCtx, pData->prb_refcache, psz_hid_blob, pEntry)  );
+    if (pEntry->p_buf)
+    {
+        pData->refcache_bytes_memory += pEntry->len;
+    }
+    else
+    {
+        pData->refcache_bytes_disk += pEntry->len;
+    }
+
+    *ppEntry = pEntry;
+
+    return;
+
+fail:
+    SG_FILE_NULLCLOSE(pCtx, pFile);
+    if (pPath_tempfile)
+    {
+        SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPath_tempfile)  );
+        SG_PATHNAME_NULLFREE(pCtx, pPath_tempfile);
+    }
+    SG_ERR_IGNORE(  sg_fs3__refcache__free_entry(pCtx, pEntry)  );
+}
+
+/**
+ * Get a seekreader on the full contents of the given blob, reconstructing
+ * it and adding it to the reference cache if it isn't already there.
+ * The entry stays pinned until the seekreader is closed.
+ */
+static void sg_fs3__refcache__open_seekreader(
+	SG_context * pCtx,
+    my_instance_data* pData,
+	const char* psz_hid_blob,
+	SG_seekreader** ppsr
 	)
 {
+    SG_bool b_found = SG_FALSE;
+    struct my_refcache_entry* pEntry = NULL;
+    struct my_refcache_reader* pReader = NULL;
     SG_seekreader* psr = NULL;
-    SG_pathname* pPath_tempfile = NULL;
 
 	SG_NULLARGCHECK_RETURN(pData);
-	SG_NULLARGCHECK_RETURN(szHidBlob);
+	SG_NULLARGCHECK_RETURN(psz_hid_blob);
 	SG_NULLARGCHECK_RETURN(ppsr);
 
-    SG_ERR_CHECK(  sg_fs3__fetch_blob_into_tempfile(pCtx, pData, szHidBlob, &pPath_tempfile)  );
-    SG_ERR_CHECK(  SG_seekreader__alloc__for_file(pCtx, pPath_tempfile, 0, &psr)  );
+    SG_ERR_CHECK(  SG_rbtree__find(pCtx, pData->prb_refcache, psz_hid_blob, &b_found, (void**) &pEntry)  );
+    if (b_found)
+    {
+        pData->refcache_hits++;
+    }
+    else
+    {
+        SG_ERR_CHECK(  sg_fs3__refcache__add(pCtx, pData, psz_hid_blob, &pEntry)  );
+        pData->refcache_misses++;
+    }
+
+    SG_ERR_CHECK(  SG_alloc1(pCtx, pReader)  );
+    pReader->pEntry = pEntry;
+    if (pEntry->pPath_spill)
+    {
+        SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pEntry->pPath_spill, SG_FILE_RDONLY | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pReader->pFile)  );
+    }
 
-    *ppPath_tempfile = pPath_tempfile;
-    pPath_tempfile = NULL;
+    SG_ERR_CHECK(  SG_seekreader__alloc(
+                pCtx,
+                pReader,
+                0,
+                pEntry->len,
+                (SG_nonstream__func__read*) sg_fs3__refcache__reader__read,
+                (SG_stream__func__seek*) sg_fs3__refcache__reader__seek,
+                (SG_stream__func__close*) sg_fs3__refcache__reader__close,
+                &psr)  );
+    pEntry->count_readers++;
+    pEntry->last_used = ++pData->refcache_clock;
+    pReader = NULL;
+
+    SG_ERR_CHECK(  sg_fs3__refcache__evict(pCtx, pData)  );
 
     *ppsr = psr;
     psr = NULL;
 
+    return;
+
+fail:
+    if (pReader)
+    {
+        SG_FILE_NULLCLOSE(pCtx, pReader->pFile);
+        SG_NULLFREE(pCtx, pReader);
+    }
+    if (psr)
+    {
+        SG_ERR_IGNORE(  SG_seekreader__close(pCtx, psr)  );
+    }
+}
+
+static void sg_fs3__refcache__free(
+	SG_context * pCtx,
+    my_instance_data* pData
+    )
+{
+    SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pData->prb_refcache, (SG_free_callback *) sg_fs3__refcache__free_entry);
+    pData->refcache_bytes_memory = 0;
+    pData->refcache_bytes_disk = 0;
+}
+
+void sg_repo__fs3__get_refcache_stats(
+	SG_context * pCtx,
+    SG_repo * pRepo,
+    SG_vhash ** ppvhStats
+    )
+{
+	my_instance_data * pData = NULL;
+    SG_vhash * pvh = NULL;
+    SG_uint32 count = 0;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(ppvhStats);
+
+	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
+	SG_NULLARGCHECK_RETURN(pData);
+
+    if (pData->prb_refcache)
+    {
+        SG_ERR_CHECK(  SG_rbtree__count(pCtx, pData->prb_refcache, &count)  );
+    }
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "hits", (SG_int64)pData->refcache_hits)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "misses", (SG_int64)pData->refcache_misses)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "count", (SG_int64)count)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "bytes_memory", (SG_int64)pData->refcache_bytes_memory)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "bytes_disk", (SG_int64)pData->refcache_bytes_disk)  );
+
+	*ppvhStats = pvh;
 	return;
+
 fail:
-    // TODO remove the tempfile?
-    SG_PATHNAME_NULLFREE(pCtx, pPath_tempfile);
+	SG_VHASH_NULLFREE(pCtx, pvh);
+}
+
+void sg_repo__fs3__drop_caches(
+	SG_context * pCtx,
+    SG_repo * pRepo
+    )
+{
+	my_instance_data * pData = NULL;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+
+	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
+	SG_NULLARGCHECK_RETURN(pData);
+
+    SG_ERR_CHECK_RETURN(  sg_fs3__refcache__free(pCtx, pData)  );
+    SG_ERR_CHECK_RETURN(  SG_rbtree__alloc(pCtx, &pData->prb_refcache)  );
 }
 
 static void _open_blobfile_for_reading( SG_context * pCtx, my_instance_data* pData, sg_blob_fs3_handle_fetch * pbh)
@@ -1384,6 +1760,25 @@ fail:
 	;
 }
 
+/**
+ * Try to map the encoded bytes of this blob out of its (already open)
+ * data file.  If the mapping can't be made, we quietly leave the handle
+ * reading through m_pFileBlob.
+ */
+static void _map_blob_for_reading(SG_context * pCtx, sg_blob_fs3_handle_fetch * pbh)
+{
+	if (pbh->len_encoded_stored < MY_MMAP_MIN_LENGTH)
+		return;
+
+	SG_file__mmap(pCtx, pbh->m_pFileBlob, pbh->offset, pbh->len_encoded_stored, &pbh->pMapping, &pbh->p_mapped);
+	if (SG_context__has_err(pCtx))
+	{
+		SG_context__err_reset(pCtx);
+		pbh->pMapping = NULL;
+		pbh->p_mapped = NULL;
+	}
+}
+
 static void sg_fs3__open_blob_for_reading(
 	SG_context * pCtx,
     my_instance_data* pData,
@@ -1435,6 +1830,13 @@ static void sg_fs3__open_blob_for_reading(
 	if (b_open_file)
 	{
 		SG_ERR_CHECK(  _open_blobfile_for_reading(pCtx, pData, pbh)  );
+
+		// when we undeltify, the bytes are read by a second handle on the
+		// delta, so there is no point mapping them here.
+		if (!(b_convert_to_full && (SG_BLOBENCODING__VCDIFF == pbh->blob_encoding_stored)))
+		{
+			SG_ERR_CHECK(  _map_blob_for_reading(pCtx, pbh)  );
+		}
 	}
 
     if (
@@ -1466,6 +1868,31 @@ static void _sg_blob_handle__close(SG_context * pCtx, sg_blob_fs3_handle_fetch *
 
 	inflateEnd(&pbh->zStream);
 
+	// if we are being aborted in the middle of an undeltify, let go of
+	// the delta handle and the reference.  closing the reference seekreader
+	// is what unpins its entry in the reference cache.
+
+	if (pbh->pst)
+	{
+		SG_ERR_IGNORE(  SG_vcdiff__undeltify__end(pCtx, pbh->pst)  );
+		pbh->pst = NULL;
+	}
+	if (pbh->pstrm_delta)
+	{
+		SG_ERR_IGNORE(  SG_readstream__close(pCtx, pbh->pstrm_delta)  );
+		pbh->pstrm_delta = NULL;
+	}
+	if (pbh->pbh_delta)
+	{
+		SG_ERR_IGNORE(  _sg_blob_handle__close(pCtx, pbh->pbh_delta)  );
+		pbh->pbh_delta = NULL;
+	}
+	if (pbh->psr_reference)
+	{
+		SG_ERR_IGNORE(  SG_seekreader__close(pCtx, pbh->psr_reference)  );
+		pbh->psr_reference = NULL;
+	}
+
 	if (pbh->pRHH_VerifyOnFetch)
 	{
 		// if this fetch-handle is being freed with an active repo_hash_handle, we destory it too.
@@ -1476,6 +1903,9 @@ static void _sg_blob_handle__close(SG_context * pCtx, sg_blob_fs3_handle_fetch *
 		SG_ERR_IGNORE(  sg_repo__fs3__hash__abort(pCtx, pbh->pData->pRepo, &pbh->pRHH_VerifyOnFetch)  );
 	}
 
+	SG_ERR_IGNORE(  SG_file__munmap(pCtx, &pbh->pMapping)  );
+	pbh->p_mapped = NULL;
+
 	if (pbh->b_we_own_file)
 		SG_FILE_NULLCLOSE(pCtx, pbh->m_pFileBlob);
 
@@ -1493,12 +1923,12 @@ void sg_blob_fs3__setup_undeltify(
     const char* psz_hid_vcdiff_reference
     )
 {
-    /* The reference blob needs to get into a seekreader. */
-    SG_ERR_CHECK(  sg_blob_fs3__open_seekreader(pCtx,
+    /* The reference blob needs to get into a seekreader.  The reference
+     * cache reconstructs it if necessary and keeps it for the next fetch. */
+    SG_ERR_CHECK(  sg_fs3__refcache__open_seekreader(pCtx,
                 pData,
                 psz_hid_vcdiff_reference,
-                &pbh->psr_reference,
-                &pbh->pPath_tempfile
+                &pbh->psr_reference
                 )  );
 
     /* The delta blob needs to be a readstream */
@@ -1662,7 +2092,19 @@ void sg_blob_fs3__fetch_blob__chunk(
     {
         int zError;
 
-        if (0 == pbh->zStream.avail_in)
+        if ((0 == pbh->zStream.avail_in) && pbh->p_mapped)
+        {
+            // feed the inflater straight from the mapping rather than
+            // copying through bufCompressed.
+            SG_uint64 left = pbh->len_encoded_stored - pbh->len_encoded_observed;
+            uInt want = (left > 0x7fffffff) ? 0x7fffffff : (uInt) left;
+
+            pbh->zStream.next_in = (Bytef*) (pbh->p_mapped + pbh->len_encoded_observed);
+            pbh->zStream.avail_in = want;
+
+            pbh->len_encoded_observed += want;
+        }
+        else if (0 == pbh->zStream.avail_in)
         {
             SG_uint32 want = sizeof(pbh->bufCompressed);
             if (want > (pbh->len_encoded_stored - pbh->len_encoded_observed))
@@ -1768,10 +2210,18 @@ void sg_blob_fs3__fetch_blob__chunk(
             want = (SG_uint32)(pbh->len_encoded_stored - pbh->len_encoded_observed);
         }
 
-        SG_file__read(pCtx, pbh->m_pFileBlob, want, p_buf, &nbr);
-        if(SG_context__has_err(pCtx) && !SG_context__err_equals(pCtx, SG_ERR_EOF))
+        if (pbh->p_mapped)
         {
-			SG_ERR_RETHROW_RETURN;
+            memcpy(p_buf, pbh->p_mapped + pbh->len_encoded_observed, want);
+            nbr = want;
+        }
+        else
+        {
+            SG_file__read(pCtx, pbh->m_pFileBlob, want, p_buf, &nbr);
+            if(SG_context__has_err(pCtx) && !SG_context__err_equals(pCtx, SG_ERR_EOF))
+            {
+                SG_ERR_RETHROW_RETURN;
+            }
         }
 
         pbh->len_encoded_observed += nbr;
@@ -1802,6 +2252,57 @@ fail:
     return;
 }
 
+/**
+ * Like sg_blob_fs3__fetch_blob__chunk(), but when the bytes we would
+ * return are sitting in a mapping, hand back a pointer into it instead
+ * of copying them.  Otherwise, fill p_buf and point at that.
+ */
+void sg_blob_fs3__fetch_blob__chunk__span(
+    SG_context * pCtx,
+    sg_blob_fs3_handle_fetch* pbh,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    )
+{
+    SG_uint32 want;
+    const SG_byte* p = NULL;
+
+    if (!pbh->p_mapped || pbh->b_uncompressing || pbh->b_undeltifying)
+    {
+        SG_ERR_CHECK_RETURN(  sg_blob_fs3__fetch_blob__chunk(pCtx, pbh, len_buf, p_buf, p_len_got, pb_done)  );
+        *pp_span = p_buf;
+        return;
+    }
+
+    want = len_buf;
+    if (want > (pbh->len_encoded_stored - pbh->len_encoded_observed))
+    {
+        want = (SG_uint32)(pbh->len_encoded_stored - pbh->len_encoded_observed);
+    }
+
+    p = pbh->p_mapped + pbh->len_encoded_observed;
+    pbh->len_encoded_observed += want;
+
+    if (want)
+    {
+        if (pbh->pRHH_VerifyOnFetch)
+        {
+            SG_ERR_CHECK_RETURN(  sg_repo__fs3__hash__chunk(pCtx, pbh->pData->pRepo, pbh->pRHH_VerifyOnFetch, want, (SG_byte*) p)  );
+        }
+        if (SG_IS_BLOBENCODING_FULL(pbh->blob_encoding_returning))
+        {
+            pbh->len_full_observed += want;
+        }
+    }
+
+    *pp_span = p;
+    *p_len_got = want;
+    *pb_done = (pbh->len_encoded_observed == pbh->len_encoded_stored);
+}
+
 void sg_blob_fs3__fetch_blob__end(
     SG_context * pCtx,
     sg_blob_fs3_handle_fetch** ppbh
@@ -1828,14 +2329,9 @@ void sg_blob_fs3__fetch_blob__end(
         SG_ERR_CHECK(  SG_readstream__close(pCtx, pbh->pstrm_delta)  );
         pbh->pstrm_delta = NULL;
 
-        SG_ERR_CHECK(  SG_seekreader__close(pCtx, pbh->psr_reference)  );
+        SG_seekreader__close(pCtx, pbh->psr_reference);
         pbh->psr_reference = NULL;
-
-        if (pbh->pPath_tempfile)
-        {
-            SG_ERR_CHECK(  SG_fsobj__remove__pathname(pCtx, pbh->pPath_tempfile)  );
-            SG_PATHNAME_NULLFREE(pCtx, pbh->pPath_tempfile);
-        }
+        SG_ERR_CHECK_CURRENT;
 
         pbh->p_buf = NULL;
         pbh->count = 0;
@@ -2138,6 +2634,7 @@ void sg_repo__fs3__open_repo_instance(SG_context * pCtx, SG_repo * pRepo)
 
     SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &pData->prb_blob_info)  );
     SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &pData->prb_paths)  );
+    SG_ERR_CHECK(  SG_rbtree__alloc(pCtx, &pData->prb_refcache)  );
 
 	SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pRepo->pvh_descriptor, SG_RIDESC_FSLOCAL__PATH_PARENT_DIR, &pszParentDir)  );
 	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__SZ(pCtx, &pData->pPathParentDir, pszParentDir)  );
@@ -2208,6 +2705,7 @@ void sg_repo__fs3__open_repo_instance(SG_context * pCtx, SG_repo * pRepo)
 
 	// all is well.
 
+    SG_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pData->pStmtCache)  );
     pData->psql = psql;
 	return;
 
@@ -2220,6 +2718,7 @@ fail:
     {
 		SG_RBTREE_NULLFREE(pCtx, pData->prb_blob_info);
         SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pData->prb_paths, (SG_free_callback *)SG_pathname__free);
+        SG_ERR_IGNORE(  sg_fs3__refcache__free(pCtx, pData)  );
         SG_PATHNAME_NULLFREE(pCtx, pData->pPathParentDir);
         SG_PATHNAME_NULLFREE(pCtx, pData->pPathMyDir);
     	SG_NULLFREE(pCtx, pData);
@@ -2323,6 +2822,7 @@ void sg_repo__fs3__create_repo_instance(
     /* Tell the dag code to create its sql db */
 	SG_ERR_CHECK(  _my_make_db_pathname(pCtx, pData,&pPathnameSqlDb)  );
     SG_ERR_CHECK(  SG_dag_sqlite3__create(pCtx, pPathnameSqlDb, &pData->psql)  );
+    SG_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pData->pStmtCache)  );
 
     // Now we add our stuff into that same db
 	SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pData->psql, "BEGIN EXCLUSIVE TRANSACTION")  );
@@ -2385,6 +2885,7 @@ fail:
         SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pData->psql, "ROLLBACK TRANSACTION")  );
         pData->b_in_sqlite_transaction = SG_FALSE;
     }
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pData->pStmtCache);
 	SG_NULLFREE(pCtx, pData);
 	SG_NULLFREE(pCtx, pszTrivialHash);
 }
@@ -2428,6 +2929,7 @@ void sg_repo__fs3__close_repo_instance(SG_context * pCtx, SG_repo * pRepo)
 
 	// TODO should we assert that we are not in a transaction?  YES, or error code.
 
+    SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pData->pStmtCache);
     SG_ERR_IGNORE(  SG_dag_sqlite3__nullclose(pCtx, &pData->psql)  );
 
 	SG_PATHNAME_NULLFREE(pCtx, pData->pPathParentDir);
@@ -2435,6 +2937,7 @@ void sg_repo__fs3__close_repo_instance(SG_context * pCtx, SG_repo * pRepo)
 
     SG_RBTREE_NULLFREE(pCtx, pData->prb_blob_info);
     SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, pData->prb_paths, (SG_free_callback *)SG_pathname__free);
+    SG_ERR_IGNORE(  sg_fs3__refcache__free(pCtx, pData)  );
 
     SG_ERR_IGNORE(  sg_blob_fs3_handle_store__free(pCtx, pData->pBlobStoreHandle)  );
 	SG_NULLFREE(pCtx, pData);
@@ -2449,7 +2952,7 @@ void sg_repo__fs3__fetch_dagnode(SG_context * pCtx, SG_repo * pRepo, const char*
 	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
 
     SG_RETRY_THINGIE(
-            SG_dag_sqlite3__fetch_dagnode(pCtx,pData->psql, pszidHidChangeset, ppNewDagnode)
+            SG_dag_sqlite3__fetch_dagnode(pCtx,pData->psql, pData->pStmtCache, pszidHidChangeset, ppNewDagnode)
             );
 
 fail:
@@ -2514,6 +3017,24 @@ fail:
     return;
 }
 
+void sg_repo__fs3__fetch_dagindex(
+    SG_context * pCtx,
+    SG_repo* pRepo,
+    SG_uint32 iDagNum,
+    SG_dagindex ** ppIndex
+    )
+{
+	my_instance_data * pData = NULL;
+	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
+
+    SG_RETRY_THINGIE(
+        SG_dag_sqlite3__get_dagindex(pCtx, pData->psql, iDagNum, ppIndex)
+        );
+
+fail:
+    return;
+}
+
 void sg_repo__fs3__check_dag_consistency(SG_context * pCtx, SG_repo * pRepo, SG_uint32 iDagNum)	// must match FN_
 {
 	// I consider this to be a DEBUG routine.  But I'm putting it
@@ -2815,6 +3336,22 @@ fail:
     return;
 }
 
+void sg_repo__fs3__fetch_blob__chunk__span(
+    SG_context * pCtx,
+    SG_repo * pRepo,
+    SG_repo_fetch_blob_handle* pHandle,
+    SG_uint32 len_buf,
+    SG_byte* p_buf,
+    const SG_byte** pp_span,
+    SG_uint32* p_len_got,
+    SG_bool* pb_done
+    )
+{
+	SG_NULLARGCHECK_RETURN(pRepo);
+
+    SG_ERR_CHECK_RETURN(  sg_blob_fs3__fetch_blob__chunk__span(pCtx, (sg_blob_fs3_handle_fetch*) pHandle, len_buf, p_buf, pp_span, p_len_got, pb_done)  );
+}
+
 void sg_repo__fs3__fetch_blob__end(
     SG_context * pCtx,
     SG_repo * pRepo,
@@ -2896,7 +3433,7 @@ static void _build_repo_fragball(
 			while ((rc=sqlite3_step(pStmt)) == SQLITE_ROW)
 			{
 				pszHid = (const char*)sqlite3_column_text(pStmt, 0);
-				SG_ERR_CHECK(  SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pszHid, &pDagnode)  );
+				SG_ERR_CHECK(  SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pData->pStmtCache, pszHid, &pDagnode)  );
 				SG_ERR_CHECK(  SG_dagfrag__add_dagnode(pCtx, pFrag, &pDagnode)  );
 			}
 			SG_ERR_CHECK(  sg_sqlite__reset(pCtx, pStmt)  );
@@ -2916,7 +3453,7 @@ static void _build_repo_fragball(
 		SG_uint64 lenFull;
 		SG_blob_encoding encoding;
 		SG_uint32 currentFilenum = 0;
-		SG_uint64 next_offset = 0;
+		SG_uint64 file_pos = 0;
 
 		SG_ERR_CHECK(  SG_fragball_writer__alloc(pCtx, pRepo, pFragballPath, SG_FALSE, &pFragballWriter)  );
 
@@ -2937,16 +3474,23 @@ static void _build_repo_fragball(
 				SG_ERR_CHECK(  _open_blobfile_for_reading(pCtx, pData, pbh)  );
 				pBlobFile = pbh->m_pFileBlob;
 				currentFilenum = pbh->filenumber;
+				file_pos = pbh->offset;
 			}
 			else
 			{
-				// Even if we haven't switched files, we'll sometimes have to seek past a hole.
-				if (pbh->offset != next_offset)
-					SG_ERR_CHECK(  SG_file__seek(pCtx, pBlobFile, pbh->offset)  );
-
 				pbh->m_pFileBlob = pBlobFile;
 			}
-			next_offset = pbh->offset + lenEncoded;
+
+			// Big blobs are read through a mapping, which doesn't move the
+			// file position.  Everything else is read sequentially, but even
+			// then we'll sometimes have to seek past a hole.
+			SG_ERR_CHECK(  _map_blob_for_reading(pCtx, pbh)  );
+			if (!pbh->p_mapped)
+			{
+				if (pbh->offset != file_pos)
+					SG_ERR_CHECK(  SG_file__seek(pCtx, pBlobFile, pbh->offset)  );
+				file_pos = pbh->offset + lenEncoded;
+			}
 
 			SG_ERR_CHECK(  SG_fragball__append_blob__from_handle(pCtx, pFragballWriter,
 				(SG_repo_fetch_blob_handle**)&pbh, psz_objectid, pszHid, encoding, pszHidVcdiffRef, lenEncoded, lenFull)  );
@@ -3025,7 +3569,8 @@ void sg_repo__fs3__get_blob_stats(
     SG_uint64* p_total_blob_size_zlib_full,
     SG_uint64* p_total_blob_size_zlib_encoded,
     SG_uint64* p_total_blob_size_vcdiff_full,
-    SG_uint64* p_total_blob_size_vcdiff_encoded
+    SG_uint64* p_total_blob_size_vcdiff_encoded,
+    SG_vhash** ppvh_chain_depths
     )
 {
 	my_instance_data * pData = NULL;
@@ -3049,6 +3594,13 @@ void sg_repo__fs3__get_blob_stats(
         )
         );
 
+    if (ppvh_chain_depths)
+    {
+        SG_RETRY_THINGIE(
+            sg_repo_utils__get_chain_depths(pCtx, pData->psql, "SELECT hid, hid_vcdiff FROM directory", ppvh_chain_depths)
+            );
+    }
+
 fail:
     return;
 }
@@ -3070,6 +3622,7 @@ void sg_repo__fs3__change_blob_encoding(
     const char* psz_hid_blob,
     SG_blob_encoding blob_encoding_desired,
     const char* psz_hid_vcdiff_reference_desired,
+    const SG_vcdiff_options* pVcdiffOptions,
     SG_blob_encoding* p_blob_encoding_new,
     char** ppsz_hid_vcdiff_reference,
     SG_uint64* p_len_encoded,
@@ -3081,6 +3634,7 @@ void sg_repo__fs3__change_blob_encoding(
     SG_UNUSED(psz_hid_blob);
     SG_UNUSED(blob_encoding_desired);
     SG_UNUSED(psz_hid_vcdiff_reference_desired);
+    SG_UNUSED(pVcdiffOptions);
     SG_UNUSED(p_blob_encoding_new);
     SG_UNUSED(ppsz_hid_vcdiff_reference);
     SG_UNUSED(p_len_encoded);
@@ -3089,6 +3643,30 @@ void sg_repo__fs3__change_blob_encoding(
     SG_ERR_THROW_RETURN(  SG_ERR_REPO_FEATURE_NOT_SUPPORTED  );
 }
 
+void sg_repo__fs3__replace_blob_encoding(
+    SG_context * pCtx,
+    SG_repo * pRepo,
+	SG_repo_tx_handle* ptx,
+    const char* psz_hid_blob,
+    SG_blob_encoding blob_encoding,
+    const char* psz_hid_vcdiff_reference,
+    SG_uint64 len_full,
+    SG_uint32 len_encoded,
+    const SG_byte* p_encoded
+    )
+{
+    SG_UNUSED(pRepo);
+    SG_UNUSED(ptx);
+    SG_UNUSED(psz_hid_blob);
+    SG_UNUSED(blob_encoding);
+    SG_UNUSED(psz_hid_vcdiff_reference);
+    SG_UNUSED(len_full);
+    SG_UNUSED(len_encoded);
+    SG_UNUSED(p_encoded);
+
+    SG_ERR_THROW_RETURN(  SG_ERR_REPO_FEATURE_NOT_SUPPORTED  );
+}
+
 void sg_fs3__remove_lock_files(
 	SG_context * pCtx,
 	my_tx_data* ptx
@@ -3163,18 +3741,11 @@ fail:
 }
 
 // this is a helper function called only from sg_fs3__commit_tx
-static void sg_fs3__insert__prepare(SG_context * pCtx, sqlite3* psql, sqlite3_stmt** pp)
+// the statement comes from pData's statement cache; give it back with sg_sqlite__release().
+static void sg_fs3__insert__prepare(SG_context * pCtx, my_instance_data* pData, sqlite3_stmt** pp)
 {
-    sqlite3_stmt* pStmt = NULL;
-
-    SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql,&pStmt,
+    SG_ERR_CHECK_RETURN(  sg_sqlite__prepare__cached(pCtx, pData->psql, pData->pStmtCache, pp,
                                       "INSERT INTO directory (hid, filenumber, offset, encoding, len_encoded, len_full, hid_vcdiff, objectid) VALUES (?, ?, ?, ?, ?, ?, ?, ?)")  );
-
-    *pp = pStmt;
-
-    return;
-fail:
-    return;
 }
 
 void sg_fs3__close_file_handles(
@@ -3337,7 +3908,7 @@ void sg_fs3__commit_tx(
     SG_ERR_CHECK(  SG_vector__length(pCtx, ptx->pvec_blobs, &count)  );
 
     /* Now process all the inserts */
-    SG_ERR_CHECK(  sg_fs3__insert__prepare(pCtx, pData->psql, &pStmt)  );
+    SG_ERR_CHECK(  sg_fs3__insert__prepare(pCtx, pData, &pStmt)  );
     for (i=0; i<count; i++)
     {
         struct pending_blob_info* pbi = NULL;
@@ -3369,8 +3940,8 @@ void sg_fs3__commit_tx(
 			SG_context__err_reset(pCtx);
 
             // clean up pStmt because we still want to use it
-            SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
-            SG_ERR_CHECK(  sg_fs3__insert__prepare(pCtx, pData->psql, &pStmt)  );
+            SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
+            SG_ERR_CHECK(  sg_fs3__insert__prepare(pCtx, pData, &pStmt)  );
         }
 		else
 		{
@@ -3383,7 +3954,7 @@ void sg_fs3__commit_tx(
 
         SG_ERR_CHECK(  sg_fs3__cache_blob_info__pbi( pCtx, pData, pbi)  );
     }
-	SG_ERR_CHECK(  sg_sqlite__nullfinalize(pCtx, &pStmt)  );
+	SG_ERR_CHECK(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
 
     /* store the frags */
     if (ptx->prb_frags)
@@ -3433,6 +4004,7 @@ void sg_fs3__commit_tx(
     }
 
 fail:
+    SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pData->pStmtCache, &pStmt)  );
     SG_ERR_IGNORE(  sg_fs3__nullfree_tx_data(pCtx, (my_tx_data**) pptx)  );
     SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
     SG_RBTREE_NULLFREE(pCtx, prb_missing);
@@ -3457,7 +4029,7 @@ void sg_repo__fs3__check_dagfrag(
 {
 	my_instance_data * pData = NULL;
 	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
-    SG_ERR_CHECK_RETURN(  SG_dag_sqlite3__check_frag(pCtx, pData->psql, pFrag, pbConnected, ppIdsetMissing, ppsa_new, pprbLeaves)  );
+    SG_ERR_CHECK_RETURN(  SG_dag_sqlite3__check_frag(pCtx, pData->psql, pData->pStmtCache, pFrag, pbConnected, ppIdsetMissing, ppsa_new, pprbLeaves)  );
 }
 
 void sg_repo__fs3__store_dagfrag(
@@ -3829,6 +4401,13 @@ void sg_repo__fs3__query_implementation(
 			return;
 		}
 
+	case SG_REPO__QUESTION__BOOL__SUPPORTS_CONCURRENT_TX:
+		{
+			SG_NULLARGCHECK_RETURN(p_bool);
+			*p_bool = SG_FALSE;
+			return;
+		}
+
 	default:
 		SG_ERR_THROW_RETURN(  SG_ERR_NOTIMPLEMENTED  );
 	}
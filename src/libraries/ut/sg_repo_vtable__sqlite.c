@@ -43,6 +43,7 @@ static void _my_nullfree_instance_data(SG_context* pCtx, my_instance_data** ppDa
 {
 	if ( ppData && (*ppData))
 	{
+		SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, (*ppData)->pStmtCache);
 		SG_dag_sqlite3__nullclose(pCtx, &(*ppData)->psql);
 		SG_PATHNAME_NULLFREE(pCtx, (*ppData)->pParentDirPathname);
 		SG_PATHNAME_NULLFREE(pCtx, (*ppData)->pMyDirPathname);
@@ -188,6 +189,7 @@ void sg_repo__sqlite__create_repo_instance(SG_context* pCtx, SG_repo* pRepo, SG_
 	pData->strlen_hashes = strlen(pszTrivialHash);
 	SG_NULLFREE(pCtx, pszTrivialHash);
 
+	SG_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pData->pStmtCache)  );
 	pData->psql = psql;
 
 	pRepo->p_vtable_instance_data = (sg_repo__vtable__instance_data*)pData;
@@ -261,6 +263,7 @@ void sg_repo__sqlite__open_repo_instance(SG_context* pCtx, SG_repo* pRepo)
 	SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pRepo->pvh_descriptor, SG_RIDESC_SQLITE__FILENAME, &pszDbFileName)  );
 	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pData->pSqlDbPathname, pData->pMyDirPathname, pszDbFileName)  );
 	SG_ERR_CHECK(  SG_dag_sqlite3__open(pCtx, pData->pSqlDbPathname, &pData->psql)  );
+	SG_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pData->pStmtCache)  );
 
 	// Get repo and admin ids
 	SG_ERR_CHECK( sg_repo_sqlite_get_id(pCtx, pData->psql, "hashmethod", &pstrId) );
@@ -325,6 +328,7 @@ void sg_repo__sqlite__close_repo_instance(SG_context* pCtx, SG_repo* pRepo)
 	if (!pData)		// no instance data implies that the sql db is not open
 		return;		// just ignore close.
 
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pData->pStmtCache);
 	SG_ERR_CHECK(  SG_dag_sqlite3__nullclose(pCtx, &pData->psql)  );
 	_my_nullfree_instance_data(pCtx, &pData);
 
@@ -384,7 +388,7 @@ void sg_repo__sqlite__fetch_dagnode(SG_context* pCtx,
 	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
 
 	SG_ERR_CHECK_RETURN(  sg_sqlite__exec(pCtx, pData->psql, "BEGIN TRANSACTION")  );
-	SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pszidHidChangeset, ppNewDagnode);
+	SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pData->pStmtCache, pszidHidChangeset, ppNewDagnode);
 	SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pData->psql, "ROLLBACK TRANSACTION")  );
 	SG_ERR_CHECK_RETURN_CURRENT;
 }
@@ -446,6 +450,21 @@ void sg_repo__sqlite__get_dag_lca(SG_context* pCtx,
 	SG_ERR_CHECK_RETURN_CURRENT;
 }
 
+void sg_repo__sqlite__fetch_dagindex(SG_context* pCtx,
+									 SG_repo* pRepo,
+									 SG_uint32 iDagNum,
+									 SG_dagindex** ppIndex)
+{
+	my_instance_data * pData = NULL;
+
+	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
+
+	SG_ERR_CHECK_RETURN(  sg_sqlite__exec(pCtx, pData->psql, "BEGIN TRANSACTION")  );
+	SG_dag_sqlite3__get_dagindex(pCtx, pData->psql, iDagNum, ppIndex);
+	SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pData->psql, "ROLLBACK TRANSACTION")  );
+	SG_ERR_CHECK_RETURN_CURRENT;
+}
+
 void sg_repo__sqlite__check_dagfrag(SG_context* pCtx,
 									SG_repo* pRepo,
 									SG_dagfrag* pFrag,
@@ -456,7 +475,7 @@ void sg_repo__sqlite__check_dagfrag(SG_context* pCtx,
 {
 	my_instance_data * pData = NULL;
 	pData = (my_instance_data *)pRepo->p_vtable_instance_data;
-	SG_ERR_CHECK_RETURN(  SG_dag_sqlite3__check_frag(pCtx, pData->psql, pFrag, pbConnected, ppIdsetMissing, ppsa_new, pprbLeaves)  );
+	SG_ERR_CHECK_RETURN(  SG_dag_sqlite3__check_frag(pCtx, pData->psql, pData->pStmtCache, pFrag, pbConnected, ppIdsetMissing, ppsa_new, pprbLeaves)  );
 }
 
 void sg_repo__sqlite__store_dagfrag(SG_context* pCtx,
@@ -789,6 +808,22 @@ void sg_repo__sqlite__fetch_blob__chunk(SG_context* pCtx,
 	SG_ERR_CHECK_RETURN(  sg_blob_sqlite__fetch_blob__chunk(pCtx, (sg_blob_sqlite_handle_fetch*)pHandle, len_buf, p_buf, p_len_got, pb_done)  );
 }
 
+void sg_repo__sqlite__fetch_blob__chunk__span(SG_context* pCtx,
+											SG_repo* pRepo,
+											SG_repo_fetch_blob_handle* pHandle,
+											SG_uint32 len_buf,
+											SG_byte* p_buf,
+											const SG_byte** pp_span,
+											SG_uint32* p_len_got,
+                                            SG_bool* pb_done)
+{
+	SG_NULLARGCHECK_RETURN(pRepo);
+
+	// blobs live in the sqlite db, so there is nothing to map.
+	SG_ERR_CHECK_RETURN(  sg_blob_sqlite__fetch_blob__chunk(pCtx, (sg_blob_sqlite_handle_fetch*)pHandle, len_buf, p_buf, p_len_got, pb_done)  );
+	*pp_span = p_buf;
+}
+
 void sg_repo__sqlite__fetch_blob__end(SG_context* pCtx,
 									  SG_repo* pRepo,
 									  SG_repo_fetch_blob_handle** ppHandle)
@@ -844,7 +879,7 @@ static void _build_repo_fragball(
 			while ((rc=sqlite3_step(pStmt)) == SQLITE_ROW)
 			{
 				pszHid = (const char*)sqlite3_column_text(pStmt, 0);
-				SG_ERR_CHECK(  SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pszHid, &pDagnode)  );
+				SG_ERR_CHECK(  SG_dag_sqlite3__fetch_dagnode(pCtx, pData->psql, pData->pStmtCache, pszHid, &pDagnode)  );
 				SG_ERR_CHECK(  SG_dagfrag__add_dagnode(pCtx, pFrag, &pDagnode)  );
 			}
 			SG_ERR_CHECK(  sg_sqlite__reset(pCtx, pStmt)  );
@@ -946,7 +981,8 @@ void sg_repo__sqlite__get_blob_stats(SG_context* pCtx,
 									 SG_uint64* p_total_blob_size_zlib_full,
 									 SG_uint64* p_total_blob_size_zlib_encoded,
 									 SG_uint64* p_total_blob_size_vcdiff_full,
-									 SG_uint64* p_total_blob_size_vcdiff_encoded)
+									 SG_uint64* p_total_blob_size_vcdiff_encoded,
+									 SG_vhash** ppvh_chain_depths)
 {
 	my_instance_data* pData = NULL;
 
@@ -967,6 +1003,10 @@ void sg_repo__sqlite__get_blob_stats(SG_context* pCtx,
 		p_total_blob_size_vcdiff_full,
 		p_total_blob_size_vcdiff_encoded
 		)  );
+	if (ppvh_chain_depths)
+	{
+		SG_ERR_CHECK(  sg_repo_utils__get_chain_depths(pCtx, pData->psql, "SELECT hid_blob, hid_vcdiff FROM blobinfo", ppvh_chain_depths)  );
+	}
 
 	/* fall through */
 fail:
@@ -979,6 +1019,7 @@ void sg_repo__sqlite__change_blob_encoding(SG_context* pCtx,
 										   const char* psz_hid_blob,
 										   SG_blob_encoding blob_encoding_desired,
 										   const char* psz_hid_vcdiff_reference_desired,
+										   const SG_vcdiff_options* pVcdiffOptions,
 										   SG_blob_encoding* p_blob_encoding_new,
 										   char** ppsz_hid_vcdiff_reference,
 										   SG_uint64* p_len_encoded,
@@ -991,7 +1032,27 @@ void sg_repo__sqlite__change_blob_encoding(SG_context* pCtx,
 	pData = (my_instance_data*)pRepo->p_vtable_instance_data;
 
 	SG_ERR_CHECK_RETURN(  sg_blob_sqlite__change_blob_encoding(pCtx, (sg_repo_tx_sqlite_handle*)pTx, pData->psql, psz_hid_blob, blob_encoding_desired,
-		psz_hid_vcdiff_reference_desired, p_blob_encoding_new, ppsz_hid_vcdiff_reference, p_len_encoded, p_len_full)  );
+		psz_hid_vcdiff_reference_desired, pVcdiffOptions, p_blob_encoding_new, ppsz_hid_vcdiff_reference, p_len_encoded, p_len_full)  );
+}
+
+void sg_repo__sqlite__replace_blob_encoding(SG_context* pCtx,
+											SG_repo* pRepo,
+											SG_repo_tx_handle* pTx,
+											const char* psz_hid_blob,
+											SG_blob_encoding blob_encoding,
+											const char* psz_hid_vcdiff_reference,
+											SG_uint64 len_full,
+											SG_uint32 len_encoded,
+											const SG_byte* p_encoded)
+{
+	my_instance_data* pData;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+
+	pData = (my_instance_data*)pRepo->p_vtable_instance_data;
+
+	SG_ERR_CHECK_RETURN(  sg_blob_sqlite__replace_blob_encoding(pCtx, (sg_repo_tx_sqlite_handle*)pTx, pData->psql, psz_hid_blob, blob_encoding,
+		psz_hid_vcdiff_reference, len_full, len_encoded, p_encoded)  );
 }
 
 void sg_repo__sqlite__vacuum(SG_context* pCtx,
@@ -1117,6 +1178,13 @@ void sg_repo__sqlite__query_implementation(
 			return;
 		}
 
+	case SG_REPO__QUESTION__BOOL__SUPPORTS_CONCURRENT_TX:
+		{
+			SG_NULLARGCHECK_RETURN(p_bool);
+			*p_bool = SG_FALSE;
+			return;
+		}
+
 	default:
 		SG_ERR_THROW_RETURN(  SG_ERR_NOTIMPLEMENTED  );
 	}
@@ -1474,3 +1542,26 @@ fail:
 	SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pData->psql, "ROLLBACK TRANSACTION")  );
 }
 
+void sg_repo__sqlite__get_refcache_stats(
+    SG_context* pCtx,
+    SG_repo * pRepo,
+    SG_vhash** ppvhStats
+    )
+{
+	SG_UNUSED(pRepo);
+	SG_UNUSED(ppvhStats);
+
+	// no reference cache here.
+	SG_ERR_THROW_RETURN(  SG_ERR_NOTIMPLEMENTED  );
+}
+
+void sg_repo__sqlite__drop_caches(
+    SG_context* pCtx,
+    SG_repo * pRepo
+    )
+{
+	SG_UNUSED(pCtx);
+	SG_UNUSED(pRepo);
+
+	// nothing cached here beyond what the dag code keeps in SG_repo.
+}
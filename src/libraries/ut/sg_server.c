@@ -116,6 +116,57 @@ fail:
 	SG_STAGING_NULLFREE(pCtx, pStaging);
 }
 
+void SG_server__push_add__stream(
+	SG_context* pCtx,
+	SG_server * pServer,
+	const char* pPushId,
+	SG_readstream* pFragballStream,
+	SG_vhash** ppResult
+	)
+{
+	SG_staging* pStaging = NULL;
+	SG_writestream* pStagingStream = NULL;
+	SG_vhash* pvh_status = NULL;
+	SG_byte* buf = NULL;
+	SG_bool b_done = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pServer);
+	SG_NULLARGCHECK_RETURN(pPushId);
+	SG_NULLARGCHECK_RETURN(pFragballStream);
+	SG_NULLARGCHECK_RETURN(ppResult);
+
+	SG_ERR_CHECK(  SG_staging__open(pCtx, pPushId, &pStaging)  );
+	SG_ERR_CHECK(  SG_staging__open_fragball_writestream(pCtx, pStaging, &pStagingStream)  );
+
+	SG_ERR_CHECK(  SG_alloc(pCtx, SG_STREAMING_BUFFER_SIZE, 1, &buf)  );
+	while (!b_done)
+	{
+		SG_uint32 got = 0;
+
+		SG_ERR_CHECK(  SG_readstream__read(pCtx, pFragballStream, SG_STREAMING_BUFFER_SIZE, buf, &got, &b_done)  );
+		if (got)
+			SG_ERR_CHECK(  SG_writestream__write(pCtx, pStagingStream, got, buf, NULL)  );
+	}
+
+	SG_writestream__close(pCtx, pStagingStream);
+	pStagingStream = NULL;
+	SG_ERR_CHECK_CURRENT;
+
+	SG_ERR_CHECK(  SG_staging__check_status(pCtx, pStaging, SG_TRUE, SG_TRUE, SG_FALSE, SG_TRUE, SG_TRUE, &pvh_status)  );
+
+	*ppResult = pvh_status;
+	pvh_status = NULL;
+
+	/* fallthru */
+
+fail:
+	if (pStagingStream)
+		SG_ERR_IGNORE(  SG_writestream__close(pCtx, pStagingStream)  );
+	SG_NULLFREE(pCtx, buf);
+	SG_VHASH_NULLFREE(pCtx, pvh_status);
+	SG_STAGING_NULLFREE(pCtx, pStaging);
+}
+
 void SG_server__push_remove(
 	SG_context* pCtx,
 	SG_server * pServer,
@@ -166,31 +217,21 @@ void SG_server__push_end(SG_context* pCtx,
 	SG_ERR_CHECK_RETURN(  SG_staging__cleanup__by_id(pCtx, pPushId)  );
 }
 
-void SG_server__pull_request_fragball(SG_context* pCtx,
-									  SG_repo* pRepo,
-									  SG_vhash* pvhRequest,
-									  const SG_pathname* pFragballDirPathname,
-									  char** ppszFragballName,
-									  SG_vhash** ppvhStatus)
+/**
+ * Add everything a (non-clone) pull request asks for to a fragball
+ * stream.  See SG_server__pull_request_fragball for the request format.
+ */
+static void _add_request_to_fragball_stream(SG_context* pCtx,
+											SG_repo* pRepo,
+											SG_vhash* pvhRequest,
+											SG_fragball_stream* pfs)
 {
-	SG_pathname* pFragballPathname = NULL;
 	SG_uint32* paDagNums = NULL;
-    SG_rbtree* prbDagnodes = NULL;
-	SG_string* pstrFragballName = NULL;
+	SG_rbtree* prbDagnodes = NULL;
 	char* pszRevFullHid = NULL;
 	SG_rbtree_iterator* pit = NULL;
 	SG_uint32* repoDagnums = NULL;
 
-	SG_NULLARGCHECK_RETURN(pRepo);
-	SG_NULLARGCHECK_RETURN(pFragballDirPathname);
-	SG_NULLARGCHECK_RETURN(ppvhStatus);
-
-#if TRACE_SERVER
-	SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, pvhRequest, "pull fragball request")  );
-#endif
-
-	SG_ERR_CHECK(  SG_fragball__create(pCtx, pFragballDirPathname, &pFragballPathname)  );
-
 	if (!pvhRequest)
 	{
 		// Add leaves from every dag to the fragball.
@@ -201,190 +242,271 @@ void SG_server__pull_request_fragball(SG_context* pCtx,
 		for (i=0; i<count_dagnums; i++)
 		{
 			SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, paDagNums[i], &prbDagnodes)  );
-			SG_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pFragballPathname, pRepo, paDagNums[i], prbDagnodes)  );
+			SG_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pfs, paDagNums[i], prbDagnodes)  );
 			SG_RBTREE_NULLFREE(pCtx, prbDagnodes);
 		}
-
-		SG_ERR_CHECK(  SG_pathname__get_last(pCtx, pFragballPathname, &pstrFragballName)  );
-		SG_ERR_CHECK(  SG_STRDUP(pCtx, SG_string__sz(pstrFragballName), ppszFragballName)  );
 	}
 	else
 	{
-		// Build the requested fragball.
 		SG_bool found;
 
-		SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__CLONE, &found)  );
+		SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__DAGS, &found)  );
 		if (found)
 		{
-			// Full clone requested.
-			SG_ERR_CHECK(  SG_repo__fetch_repo__fragball(pCtx, pRepo, pFragballDirPathname, ppszFragballName) );
-		}
-		else
-		{
-			// Not a full clone.
-
-			SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__DAGS, &found)  );
+			// Dagnodes were requested.
+
+			SG_uint32 generations = 0;
+			SG_vhash* pvhDags;
+			SG_uint32 count_requested_dagnums;
+			SG_uint32 count_repo_dagnums = 0;
+			SG_uint32 i;
+			const char* pszDagNum = NULL;
+			const SG_variant* pvRequestedNodes = NULL;
+			SG_vhash* pvhRequestedNodes = NULL;
+			const char* pszHidRequestedDagnode = NULL;
+
+			// Were additional generations requested?
+			SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__GENERATIONS, &found)  );
 			if (found)
+				SG_ERR_CHECK(  SG_vhash__get__uint32(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__GENERATIONS, &generations)  );
+
+			SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__DAGS, &pvhDags)  );
+			SG_ERR_CHECK(  SG_vhash__count(pCtx, pvhDags, &count_requested_dagnums)  );
+			if (count_requested_dagnums)
+				SG_ERR_CHECK(  SG_repo__list_dags(pCtx, pRepo, &count_repo_dagnums, &repoDagnums)  );
+
+			// For each requested dag, get the requested nodes.
+			for (i=0; i<count_requested_dagnums; i++)
 			{
-				// Dagnodes were requested.
-
-				SG_uint32 generations = 0;
-				SG_vhash* pvhDags;
-				SG_uint32 count_requested_dagnums;
-				SG_uint32 count_repo_dagnums = 0;
-				SG_uint32 i;
-				const char* pszDagNum = NULL;
-				const SG_variant* pvRequestedNodes = NULL;
-				SG_vhash* pvhRequestedNodes = NULL;
-				const char* pszHidRequestedDagnode = NULL;
-
-				// Were additional generations requested?
-				SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__GENERATIONS, &found)  );
-				if (found)
-					SG_ERR_CHECK(  SG_vhash__get__uint32(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__GENERATIONS, &generations)  );
-
-				SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__DAGS, &pvhDags)  );
-				SG_ERR_CHECK(  SG_vhash__count(pCtx, pvhDags, &count_requested_dagnums)  );
-				if (count_requested_dagnums)
-					SG_ERR_CHECK(  SG_repo__list_dags(pCtx, pRepo, &count_repo_dagnums, &repoDagnums)  );
-
-				// For each requested dag, get the requested nodes.
-				for (i=0; i<count_requested_dagnums; i++)
+				SG_uint32 iMissingNodeCount;
+				SG_uint32 iDagnum;
+				SG_uint32 j;
+				SG_bool isValidDagnum = SG_FALSE;
+				SG_bool bSpecificNodesRequested = SG_FALSE;
+				SG_int32 genCommon = 0;
+
+				// Get the dag's missing node vhash.
+				SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvhDags, i, &pszDagNum, &pvRequestedNodes)  );
+				SG_ERR_CHECK(  SG_dagnum__from_sz__decimal(pCtx, pszDagNum, &iDagnum)  );
+
+				// Verify that requested dagnum exists
+				for (j = 0; j < count_repo_dagnums; j++)
 				{
-					SG_uint32 iMissingNodeCount;
-					SG_uint32 iDagnum;
-					SG_uint32 j;
-					SG_bool isValidDagnum = SG_FALSE;
-					SG_bool bSpecificNodesRequested = SG_FALSE;
-
-					// Get the dag's missing node vhash.
-					SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvhDags, i, &pszDagNum, &pvRequestedNodes)  );
-					SG_ERR_CHECK(  SG_dagnum__from_sz__decimal(pCtx, pszDagNum, &iDagnum)  );
-
-					// Verify that requested dagnum exists
-					for (j = 0; j < count_repo_dagnums; j++)
+					if (repoDagnums[j] == iDagnum)
 					{
-						if (repoDagnums[j] == iDagnum)
-						{
-							isValidDagnum = SG_TRUE;
-							break;
-						}
-					}
-					if (!isValidDagnum)
-					{
-						char buf[SG_DAGNUM__BUF_MAX__NAME];
-						SG_ERR_CHECK(  SG_dagnum__to_name(pCtx, iDagnum, buf, sizeof(buf))  );
-						SG_ERR_THROW2(SG_ERR_NO_SUCH_DAG, (pCtx, "%s", buf));
+						isValidDagnum = SG_TRUE;
+						break;
 					}
+				}
+				if (!isValidDagnum)
+				{
+					char buf[SG_DAGNUM__BUF_MAX__NAME];
+					SG_ERR_CHECK(  SG_dagnum__to_name(pCtx, iDagnum, buf, sizeof(buf))  );
+					SG_ERR_THROW2(SG_ERR_NO_SUCH_DAG, (pCtx, "%s", buf));
+				}
 
-					if (pvRequestedNodes)
+				// If the client sent a sample of its dag, find the newest
+				// node we have in common so we can go back that far at once.
+				if (generations)
+					SG_ERR_CHECK(  SG_sync__get_common_generation(pCtx, pRepo, pvhRequest, pszDagNum, &genCommon)  );
+
+				if (pvRequestedNodes)
+				{
+					SG_ERR_CHECK(  SG_variant__get__vhash(pCtx, pvRequestedNodes, &pvhRequestedNodes)  );
+
+					// Get each node listed for the dag
+					SG_ERR_CHECK(  SG_vhash__count(pCtx, pvhRequestedNodes, &iMissingNodeCount)  );
+					if (iMissingNodeCount > 0)
 					{
-						SG_ERR_CHECK(  SG_variant__get__vhash(pCtx, pvRequestedNodes, &pvhRequestedNodes)  );
+						SG_uint32 j;
+						const SG_variant* pvVal;
 
-						// Get each node listed for the dag
-						SG_ERR_CHECK(  SG_vhash__count(pCtx, pvhRequestedNodes, &iMissingNodeCount)  );
-						if (iMissingNodeCount > 0)
-						{
-							SG_uint32 j;
-							const SG_variant* pvVal;
+						bSpecificNodesRequested = SG_TRUE;
 
-							bSpecificNodesRequested = SG_TRUE;
+						SG_ERR_CHECK(  SG_RBTREE__ALLOC__PARAMS(pCtx, &prbDagnodes, iMissingNodeCount, NULL)  );
+						for (j=0; j<iMissingNodeCount; j++)
+						{
+							SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvhRequestedNodes, j, &pszHidRequestedDagnode, &pvVal)  );
 
-							SG_ERR_CHECK(  SG_RBTREE__ALLOC__PARAMS(pCtx, &prbDagnodes, iMissingNodeCount, NULL)  );
-							for (j=0; j<iMissingNodeCount; j++)
+							if (pvVal)
 							{
-								SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvhRequestedNodes, j, &pszHidRequestedDagnode, &pvVal)  );
-
-								if (pvVal)
+								const char* pszVal;
+								SG_ERR_CHECK(  SG_variant__get__sz(pCtx, pvVal, &pszVal)  );
+								if (pszVal)
 								{
-									const char* pszVal;
-									SG_ERR_CHECK(  SG_variant__get__sz(pCtx, pvVal, &pszVal)  );
-									if (pszVal)
+									if (0 == strcmp(pszVal, SG_SYNC_REQUEST_VALUE_HID_PREFIX))
 									{
-										if (0 == strcmp(pszVal, SG_SYNC_REQUEST_VALUE_HID_PREFIX))
-										{
-											SG_ERR_CHECK(  SG_repo__hidlookup__dagnode(pCtx, pRepo, iDagnum, pszHidRequestedDagnode, &pszRevFullHid)  );
-											pszHidRequestedDagnode = pszRevFullHid;
-										}
-										else if (0 == strcmp(pszVal, SG_SYNC_REQUEST_VALUE_TAG))
-										{
-											SG_ERR_CHECK(  SG_vc_tags__lookup__tag(pCtx, pRepo, pszHidRequestedDagnode, &pszRevFullHid)  );
-											if (!pszRevFullHid)
-												SG_ERR_THROW(SG_ERR_TAG_NOT_FOUND);
-											pszHidRequestedDagnode = pszRevFullHid;
-										}
-										else
-											SG_ERR_THROW(SG_ERR_PULL_INVALID_FRAGBALL_REQUEST);
+										SG_ERR_CHECK(  SG_repo__hidlookup__dagnode(pCtx, pRepo, iDagnum, pszHidRequestedDagnode, &pszRevFullHid)  );
+										pszHidRequestedDagnode = pszRevFullHid;
 									}
+									else if (0 == strcmp(pszVal, SG_SYNC_REQUEST_VALUE_TAG))
+									{
+										SG_ERR_CHECK(  SG_vc_tags__lookup__tag(pCtx, pRepo, pszHidRequestedDagnode, &pszRevFullHid)  );
+										if (!pszRevFullHid)
+											SG_ERR_THROW(SG_ERR_TAG_NOT_FOUND);
+										pszHidRequestedDagnode = pszRevFullHid;
+									}
+									else
+										SG_ERR_THROW(SG_ERR_PULL_INVALID_FRAGBALL_REQUEST);
 								}
-								
-								SG_ERR_CHECK(  SG_rbtree__update(pCtx, prbDagnodes, pszHidRequestedDagnode)  );
-								// Get additional dagnode generations, if requested.
-								SG_ERR_CHECK(  SG_sync__add_n_generations(pCtx, pRepo, pszHidRequestedDagnode, prbDagnodes, generations)  );
-								SG_NULLFREE(pCtx, pszRevFullHid);
 							}
+						
+							SG_ERR_CHECK(  SG_rbtree__update(pCtx, prbDagnodes, pszHidRequestedDagnode)  );
+							// Get additional dagnode generations, if requested.
+							SG_ERR_CHECK(  SG_sync__add_generations(pCtx, pRepo, pszHidRequestedDagnode, prbDagnodes, generations, genCommon)  );
+							SG_NULLFREE(pCtx, pszRevFullHid);
 						}
 					}
+				}
 
-					if (!bSpecificNodesRequested)
-					{
-						// When no specific nodes are in the request, add all leaves.
-						SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, iDagnum, &prbDagnodes)  );
+				if (!bSpecificNodesRequested)
+				{
+					// When no specific nodes are in the request, add all leaves.
+					SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, iDagnum, &prbDagnodes)  );
 
-						// Get additional dagnode generations, if requested.
-						if (generations)
+					// Get additional dagnode generations, if requested.
+					if (generations)
+					{
+						SG_bool found;
+						const char* hid;
+					
+						SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prbDagnodes, &found, &hid, NULL)  );
+						while (found)
 						{
-							SG_bool found;
-							const char* hid;
-							
-							SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prbDagnodes, &found, &hid, NULL)  );
-							while (found)
-							{
-								SG_ERR_CHECK(  SG_sync__add_n_generations(pCtx, pRepo, hid, prbDagnodes, generations)  );
-								SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &found, &hid, NULL)  );
-							}
+							SG_ERR_CHECK(  SG_sync__add_generations(pCtx, pRepo, hid, prbDagnodes, generations, genCommon)  );
+							SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &found, &hid, NULL)  );
 						}
 					}
+				}
 
-					if (prbDagnodes) // can be null when leaves of an empty dag are requested
-					{
-						SG_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pFragballPathname, pRepo, iDagnum, prbDagnodes)  );
-						SG_RBTREE_NULLFREE(pCtx, prbDagnodes);
-					}
+				if (prbDagnodes) // can be null when leaves of an empty dag are requested
+				{
+					SG_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pfs, iDagnum, prbDagnodes)  );
+					SG_RBTREE_NULLFREE(pCtx, prbDagnodes);
+				}
 
-				} // dagnum loop
-			} // if "dags" exists
+			} // dagnum loop
+		} // if "dags" exists
 
-			/* Add requested blobs to the fragball */
-			SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__BLOBS, &found)  );
-			if (found)
-			{
-				// Blobs were requested.
-				SG_vhash* pvhBlobs;
-				SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__BLOBS, &pvhBlobs)  );
-				SG_ERR_CHECK(  SG_sync__add_blobs_to_fragball(pCtx, pRepo, pFragballPathname, pvhBlobs)  );
-			}
-
-			SG_ERR_CHECK(  SG_pathname__get_last(pCtx, pFragballPathname, &pstrFragballName)  );
-			SG_ERR_CHECK(  SG_STRDUP(pCtx, SG_string__sz(pstrFragballName), ppszFragballName)  );
+		/* Add requested blobs to the fragball */
+		SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__BLOBS, &found)  );
+		if (found)
+		{
+			// Blobs were requested.
+			SG_vhash* pvhBlobs;
+			SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__BLOBS, &pvhBlobs)  );
+			SG_ERR_CHECK(  SG_sync__add_blobs_to_fragball_stream(pCtx, pfs, pvhBlobs)  );
 		}
 	}
-	
+
 	/* fallthru */
 fail:
-	// If we had an error, delete the half-baked fragball.
-	if (pFragballPathname && SG_context__has_err(pCtx))
-		SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pFragballPathname)  );
-
-	SG_PATHNAME_NULLFREE(pCtx, pFragballPathname);
 	SG_NULLFREE(pCtx, paDagNums);
 	SG_RBTREE_NULLFREE(pCtx, prbDagnodes);
-	SG_STRING_NULLFREE(pCtx, pstrFragballName);
 	SG_NULLFREE(pCtx, pszRevFullHid);
 	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
 	SG_NULLFREE(pCtx, repoDagnums);
 }
 
+void SG_server__pull_request_fragball__stream(SG_context* pCtx,
+											  SG_repo* pRepo,
+											  SG_vhash* pvhRequest,
+											  SG_fragball_stream** ppFragballStream,
+											  SG_vhash** ppvhStatus)
+{
+	SG_fragball_stream* pfs = NULL;
+	SG_bool bClone = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(ppFragballStream);
+	SG_NULLARGCHECK_RETURN(ppvhStatus);
+
+#if TRACE_SERVER
+	SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, pvhRequest, "pull fragball stream request")  );
+#endif
+
+	// A clone comes from the repo's own fragball, which can't be streamed.
+	if (pvhRequest)
+		SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__CLONE, &bClone)  );
+	if (bClone)
+		SG_ERR_THROW2(SG_ERR_PULL_INVALID_FRAGBALL_REQUEST, (pCtx, "a clone can't be streamed"));
+
+	SG_ERR_CHECK(  SG_fragball_stream__alloc(pCtx, pRepo, &pfs)  );
+	SG_ERR_CHECK(  _add_request_to_fragball_stream(pCtx, pRepo, pvhRequest, pfs)  );
+
+	SG_RETURN_AND_NULL(pfs, ppFragballStream);
+
+	/* fallthru */
+fail:
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pfs);
+}
+
+void SG_server__pull_request_fragball(SG_context* pCtx,
+									  SG_repo* pRepo,
+									  SG_vhash* pvhRequest,
+									  const SG_pathname* pFragballDirPathname,
+									  char** ppszFragballName,
+									  SG_vhash** ppvhStatus)
+{
+	SG_fragball_stream* pfs = NULL;
+	char* pszFragballName = NULL;
+	SG_pathname* pFragballPathname = NULL;
+	SG_file* pFile = NULL;
+	SG_byte* buf = NULL;
+	SG_bool b_done = SG_FALSE;
+	SG_bool bClone = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(pFragballDirPathname);
+	SG_NULLARGCHECK_RETURN(ppszFragballName);
+	SG_NULLARGCHECK_RETURN(ppvhStatus);
+
+#if TRACE_SERVER
+	SG_ERR_CHECK(  SG_vhash_debug__dump_to_console__named(pCtx, pvhRequest, "pull fragball request")  );
+#endif
+
+	if (pvhRequest)
+		SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__CLONE, &bClone)  );
+	if (bClone)
+	{
+		// Full clone requested.
+		SG_ERR_CHECK_RETURN(  SG_repo__fetch_repo__fragball(pCtx, pRepo, pFragballDirPathname, ppszFragballName)  );
+		return;
+	}
+
+	SG_ERR_CHECK(  SG_server__pull_request_fragball__stream(pCtx, pRepo, pvhRequest, &pfs, ppvhStatus)  );
+
+	SG_ERR_CHECK(  SG_allocN(pCtx, SG_TID_MAX_BUFFER_LENGTH, pszFragballName)  );
+	SG_ERR_CHECK(  SG_tid__generate(pCtx, pszFragballName, SG_TID_MAX_BUFFER_LENGTH)  );
+	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pFragballPathname, pFragballDirPathname, pszFragballName)  );
+	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pFragballPathname, SG_FILE_WRONLY | SG_FILE_CREATE_NEW, 0644, &pFile)  );
+
+	SG_ERR_CHECK(  SG_alloc(pCtx, SG_STREAMING_BUFFER_SIZE, 1, &buf)  );
+	while (!b_done)
+	{
+		SG_uint32 got = 0;
+
+		SG_ERR_CHECK(  SG_fragball_stream__read(pCtx, pfs, SG_STREAMING_BUFFER_SIZE, buf, &got, &b_done)  );
+		if (got)
+			SG_ERR_CHECK(  SG_file__write(pCtx, pFile, got, buf, NULL)  );
+	}
+	SG_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+
+	SG_RETURN_AND_NULL(pszFragballName, ppszFragballName);
+
+	/* fallthru */
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+	// If we had an error, delete the half-baked fragball.
+	if (pFragballPathname && SG_context__has_err(pCtx))
+		SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pFragballPathname)  );
+
+	SG_PATHNAME_NULLFREE(pCtx, pFragballPathname);
+	SG_NULLFREE(pCtx, pszFragballName);
+	SG_NULLFREE(pCtx, buf);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pfs);
+}
+
 void SG_server__get_temp_fragball_path(SG_context* pCtx,
 									   const char* pPushId,
 									   const char** ppsz_fragball_name,
@@ -15,6 +15,7 @@ limitations under the License.
 */
 
 #include <sg.h>
+#include "sg_lib__private.h"
 
 #if defined(DEBUG)
 #	define TRACE_SQLITE				0
@@ -32,6 +33,201 @@ limitations under the License.
 															if (rc)																		\
 																SG_ERR_THROW2_RETURN(SG_ERR_SQLITE(rc), (pCtx, sqlite3_errmsg(psql)));	)
 
+//////////////////////////////////////////////////////////////////
+
+/*
+ * Prepared statement cache.
+ *
+ * The hot paths (dagnode fetch/store, blob lookups, dbndx updates)
+ * execute the same handful of statements over and over against the
+ * same connection.  Rather than compiling the SQL every time, they
+ * call sg_sqlite__prepare__cached() and hand the statement back with
+ * sg_sqlite__release(), which resets it and clears its bindings so
+ * the next caller gets a fresh statement without another prepare.
+ *
+ * Each connection has its own cache, allocated and kept by whatever
+ * owns the connection (the dbndx, the repo's instance data) and passed
+ * in.  It must be freed before the connection is closed.
+ * Like the connection itself, a cache must not be used by two threads
+ * at once.  A NULL cache is allowed: the statement is prepared as
+ * usual and finalized when it is released.
+ *
+ * A statement can only be handed out once at a time; if a caller
+ * asks for a statement that is already in use (eg, a nested query),
+ * it gets another copy, which is cached too.  When the cache is full,
+ * the least recently prepared idle entry is replaced, and if nothing
+ * is idle the new statement is finalized when it is released.
+ */
+
+#define SG_SQLITE__STMT_CACHE_SIZE		64
+
+typedef struct
+{
+	char* psz_sql;
+	sqlite3_stmt* pStmt;
+	SG_bool b_in_use;
+} sg_sqlite__cached_stmt;
+
+struct _sg_sqlite__stmt_cache
+{
+	SG_uint32 count;
+	SG_uint32 next_victim;
+	sg_sqlite__cached_stmt a[SG_SQLITE__STMT_CACHE_SIZE];
+};
+
+void sg_sqlite__stmt_cache__alloc(SG_context * pCtx, sg_sqlite__stmt_cache** ppNew)
+{
+	sg_sqlite__stmt_cache* pCache = NULL;
+
+	SG_NULLARGCHECK_RETURN(ppNew);
+
+	SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pCache)  );
+
+	*ppNew = pCache;
+}
+
+void sg_sqlite__stmt_cache__free(SG_context * pCtx, sg_sqlite__stmt_cache* pCache)
+{
+	SG_uint32 i;
+
+	if (!pCache)
+		return;
+
+	for (i=0; i<pCache->count; i++)
+	{
+		// the statement may still hold the error of its last step,
+		// which would be reported again here.  we don't care.
+		(void) sqlite3_finalize(pCache->a[i].pStmt);
+		SG_NULLFREE(pCtx, pCache->a[i].psz_sql);
+	}
+
+	SG_NULLFREE(pCtx, pCache);
+}
+
+void sg_sqlite__prepare__cached(SG_context * pCtx, sqlite3* psql, sg_sqlite__stmt_cache* pCache, sqlite3_stmt** ppStmt, const char* pszSql)
+{
+	sqlite3_stmt* pStmt = NULL;
+	char* psz_copy = NULL;
+	SG_uint32 i;
+	int rc;
+
+	SG_NULLARGCHECK_RETURN(psql);
+	SG_NULLARGCHECK_RETURN(ppStmt);
+	SG_NULLARGCHECK_RETURN(pszSql);
+
+	if (pCache)
+	{
+		for (i=0; i<pCache->count; i++)
+		{
+			sg_sqlite__cached_stmt* pEntry = &pCache->a[i];
+
+			if (
+				!pEntry->b_in_use
+				&& ((pEntry->psz_sql == pszSql) || (0 == strcmp(pEntry->psz_sql, pszSql)))
+			   )
+			{
+				pEntry->b_in_use = SG_TRUE;
+				*ppStmt = pEntry->pStmt;
+				return;
+			}
+		}
+	}
+
+#if TRACE_SQLITE
+	fprintf(stderr,"Preparing Statement(%s)\n",pszSql);
+#endif
+	SG_SQLITE_ERR_CHECK(  sqlite3_prepare_v2(psql, pszSql, -1, &pStmt, 0)  );
+
+	if (!pCache)
+	{
+		i = SG_SQLITE__STMT_CACHE_SIZE;	// no cache; release will finalize it
+	}
+	else if (pCache->count < SG_SQLITE__STMT_CACHE_SIZE)
+	{
+		i = pCache->count;
+	}
+	else
+	{
+		SG_uint32 k;
+
+		for (k=0; k<SG_SQLITE__STMT_CACHE_SIZE; k++)
+		{
+			i = (pCache->next_victim + k) % SG_SQLITE__STMT_CACHE_SIZE;
+			if (!pCache->a[i].b_in_use)
+				break;
+		}
+		if (k == SG_SQLITE__STMT_CACHE_SIZE)
+			i = SG_SQLITE__STMT_CACHE_SIZE;	// everything is in use; don't cache this one
+		else
+			pCache->next_victim = (i + 1) % SG_SQLITE__STMT_CACHE_SIZE;
+	}
+
+	if (i < SG_SQLITE__STMT_CACHE_SIZE)
+	{
+		SG_ERR_CHECK(  SG_STRDUP(pCtx, pszSql, &psz_copy)  );
+
+		if (i < pCache->count)
+		{
+			(void) sqlite3_finalize(pCache->a[i].pStmt);
+			SG_NULLFREE(pCtx, pCache->a[i].psz_sql);
+		}
+		else
+		{
+			pCache->count++;
+		}
+
+		pCache->a[i].psz_sql = psz_copy;
+		psz_copy = NULL;
+		pCache->a[i].pStmt = pStmt;
+		pCache->a[i].b_in_use = SG_TRUE;
+	}
+
+	*ppStmt = pStmt;
+	return;
+
+fail:
+	SG_NULLFREE(pCtx, psz_copy);
+	if (pStmt)
+		(void) sqlite3_finalize(pStmt);
+}
+
+void sg_sqlite__release(SG_context * pCtx, sg_sqlite__stmt_cache* pCache, sqlite3_stmt** ppStmt)
+{
+	sqlite3_stmt* pStmt;
+	SG_bool bCached = SG_FALSE;
+	SG_uint32 i;
+
+	if (!ppStmt || !*ppStmt)
+		return;
+
+	pStmt = *ppStmt;
+	*ppStmt = NULL;
+
+	if (pCache)
+	{
+		for (i=0; i<pCache->count; i++)
+		{
+			if (pCache->a[i].pStmt == pStmt)
+			{
+				// sqlite3_reset() returns the error from the last step,
+				// if any.  The caller has already dealt with that.
+				(void) sqlite3_reset(pStmt);
+				(void) sqlite3_clear_bindings(pStmt);
+				pCache->a[i].b_in_use = SG_FALSE;
+				bCached = SG_TRUE;
+				break;
+			}
+		}
+	}
+
+	if (!bCached)
+		(void) sqlite3_finalize(pStmt);
+
+	SG_UNUSED(pCtx);
+}
+
+//////////////////////////////////////////////////////////////////
+
 void sg_sqlite__create__pathname(
 	SG_context * pCtx,
 	const SG_pathname * pPathnameDb,
@@ -20,6 +20,10 @@ limitations under the License.
 #define MY_BUSY_TIMEOUT_MS      (30000)
 #define REPO_FILENAME "__REPO__"
 
+#define MY_STORE__MAX_THREADS       8
+#define MY_STORE__MAX_AHEAD         64
+#define MY_STORE__MAX_IN_MEMORY     (1024 * 1024)
+
 struct _sg_staging_blob_handle
 {
 	SG_repo* pRepo;
@@ -721,85 +725,490 @@ fail:
 	SG_PATHNAME_NULLFREE(pCtx, pPath);
 }
 
-static void _store_all_blobs(
-	SG_context* pCtx,
-	sg_staging* pMe,
-	SG_repo_tx_handle* ptx
-	)
+/**
+ * One row of blobs_present, plus what a worker found out about it.
+ *
+ * When pBuf is set, it holds the bytes to hand to the repo, already
+ * verified, with encoding_store and len_store.  Blobs too big to keep
+ * in memory are only verified by the worker, and the store thread
+ * copies them out of the fragball itself.
+ */
+typedef struct
 {
-	sqlite3_stmt* pStmt = NULL;
-	int rc;
-	SG_byte* buf = NULL;
-	SG_uint32 buf_size;
+	char* psz_hid;
+	char* psz_filename;
+	SG_uint64 offset;
+	SG_blob_encoding encoding;
+	SG_uint64 len_encoded;
+	SG_uint64 len_full;
+	char* psz_hid_vcdiff;
+	char* psz_objectid;
 
-	SG_file* pFile = NULL;
-	char* pszLastFile = NULL;
+	SG_byte* pBuf;
+	SG_blob_encoding encoding_store;
+	SG_uint32 len_store;
+} my_store_item;
+
+typedef struct
+{
+	SG_file* pFile;
+	char* pszLastFile;
+	SG_byte* buf;
+	SG_byte* buf_inflate;
+} my_store_reader;
+
+typedef struct
+{
+	sg_staging* pMe;
+	my_store_reader* pa_readers;	// one per worker
+} my_store_data;
+
+static void _store_reader__close(SG_context* pCtx, my_store_reader* pr)
+{
+	SG_FILE_NULLCLOSE(pCtx, pr->pFile);
+	SG_NULLFREE(pCtx, pr->pszLastFile);
+	SG_NULLFREE(pCtx, pr->buf);
+	SG_NULLFREE(pCtx, pr->buf_inflate);
+}
+
+/**
+ * Position the reader at the start of the item's encoded bytes,
+ * reopening the file only when the item lives in a different fragball.
+ */
+static void _store_reader__seek(SG_context* pCtx, sg_staging* pMe, my_store_reader* pr, const my_store_item* pItem)
+{
 	SG_pathname* pPath_file = NULL;
 
-	buf_size = SG_STREAMING_BUFFER_SIZE;
-	SG_ERR_CHECK(  SG_alloc(pCtx, buf_size, 1, &buf)  );
+	if ( (!pr->pFile) || (strcmp(pr->pszLastFile, pItem->psz_filename) != 0) )
+	{
+		SG_FILE_NULLCLOSE(pCtx, pr->pFile);
+		SG_NULLFREE(pCtx, pr->pszLastFile);
 
-	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pMe->psql,&pStmt,
-		"SELECT hid, filename, offset, encoding, len_encoded, len_full, hid_vcdiff, objectid FROM blobs_present ORDER BY filename ASC, offset ASC")  );
+		SG_ERR_CHECK(  SG_STRDUP(pCtx, pItem->psz_filename, &pr->pszLastFile)  );
+		SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPath_file, pMe->pPath, pItem->psz_filename)  );
+		SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPath_file, SG_FILE_RDONLY|SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pr->pFile)  );
+	}
 
-	while ((rc=sqlite3_step(pStmt)) == SQLITE_ROW)
+	// We have to seek past the object header each time.
+	SG_ERR_CHECK(  SG_file__seek(pCtx, pr->pFile, pItem->offset)  );
+
+	/* fall through */
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPath_file);
+}
+
+/**
+ * Read the encoded bytes of one blob and make sure they hash to its HID.
+ * Full blobs are hashed as they are; zlib blobs are inflated on the fly
+ * and the result is hashed.  A vcdiff blob can't be checked without its
+ * reference, so (as before) we trust what the fragball says about it.
+ *
+ * If pBufKeep is given, the encoded bytes are also copied into it.
+ */
+static void _verify_one_blob(
+	SG_context* pCtx,
+	SG_repo* pRepo,
+	my_store_reader* pr,
+	const my_store_item* pItem,
+	SG_byte* pBufKeep
+	)
+{
+	SG_repo_hash_handle* pRHH = NULL;
+	char* psz_hid_computed = NULL;
+	SG_bool b_zlib = (SG_BLOBENCODING__ZLIB == pItem->encoding);
+	SG_bool b_inflating = SG_FALSE;
+	SG_bool b_stream_end = SG_FALSE;
+	z_stream strm;
+	int zErr;
+	SG_uint64 sofar = 0;
+	SG_uint64 len_full_observed = 0;
+
+	if (!SG_IS_BLOBENCODING_FULL(pItem->encoding) && !b_zlib)
 	{
-		const char* psz_hid = (const char*) sqlite3_column_text(pStmt, 0);
-		const char* psz_filename = (const char*) sqlite3_column_text(pStmt, 1);
-		SG_uint64 offset = sqlite3_column_int64(pStmt,2);
-		SG_blob_encoding encoding = (SG_blob_encoding)sqlite3_column_int(pStmt,3);
-		SG_uint64 len_encoded = sqlite3_column_int64(pStmt, 4);
-		SG_uint64 len_full = sqlite3_column_int64(pStmt, 5);
-		const char * psz_hid_vcdiff = (const char *)sqlite3_column_text(pStmt,6);
-		const char * psz_objectid = (const char *)sqlite3_column_text(pStmt,7);
+		if (!pBufKeep)
+		{
+			return;
+		}
+	}
+	else
+	{
+		SG_ERR_CHECK(  SG_repo__hash__begin(pCtx, pRepo, &pRHH)  );
+	}
+
+	if (b_zlib)
+	{
+		memset(&strm, 0, sizeof(strm));
+		zErr = inflateInit(&strm);
+		if (zErr != Z_OK)
+		{
+			SG_ERR_THROW(  SG_ERR_ZLIB(zErr)  );
+		}
+		b_inflating = SG_TRUE;
+	}
+
+	while (sofar < pItem->len_encoded)
+	{
+		SG_byte* p = pBufKeep ? (pBufKeep + sofar) : pr->buf;
+		SG_uint32 want = SG_STREAMING_BUFFER_SIZE;
+		SG_uint32 got = 0;
+
+		if ((pItem->len_encoded - sofar) < want)
+		{
+			want = (SG_uint32) (pItem->len_encoded - sofar);
+		}
+		SG_ERR_CHECK(  SG_file__read(pCtx, pr->pFile, want, p, &got)  );
+		sofar += got;
 
-		if ( (!pFile) || (strcmp(pszLastFile, psz_filename) != 0) )
+		if (b_inflating)
 		{
-			if (pFile)
+			strm.next_in = p;
+			strm.avail_in = got;
+			while ((strm.avail_in > 0) && !b_stream_end)
 			{
-				SG_FILE_NULLCLOSE(pCtx, pFile);
-				SG_NULLFREE(pCtx, pszLastFile);
+				SG_uint32 have;
+
+				strm.next_out = pr->buf_inflate;
+				strm.avail_out = SG_STREAMING_BUFFER_SIZE;
+				zErr = inflate(&strm, Z_NO_FLUSH);
+				if (Z_STREAM_END == zErr)
+				{
+					b_stream_end = SG_TRUE;
+				}
+				else if (zErr != Z_OK)
+				{
+					if (Z_NEED_DICT == zErr)
+					{
+						zErr = Z_DATA_ERROR;
+					}
+					SG_ERR_THROW(  SG_ERR_ZLIB(zErr)  );
+				}
+				have = SG_STREAMING_BUFFER_SIZE - strm.avail_out;
+				SG_ERR_CHECK(  SG_repo__hash__chunk(pCtx, pRepo, pRHH, have, pr->buf_inflate)  );
+				len_full_observed += have;
 			}
+		}
+		else if (pRHH)
+		{
+			SG_ERR_CHECK(  SG_repo__hash__chunk(pCtx, pRepo, pRHH, got, p)  );
+			len_full_observed += got;
+		}
+	}
 
-			SG_STRDUP(pCtx, psz_filename, &pszLastFile);
-			SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPath_file, pMe->pPath, psz_filename)  );
-			SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPath_file, SG_FILE_RDONLY|SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFile)  );
-			SG_PATHNAME_NULLFREE(pCtx, pPath_file);
+	if (pRHH)
+	{
+		if ((b_zlib && !b_stream_end) || (len_full_observed != pItem->len_full))
+		{
+			SG_ERR_THROW(  SG_ERR_BLOB_NOT_VERIFIED_INCOMPLETE  );
 		}
 
-		// We have to seek past the object header each time.
-		SG_ERR_CHECK(  SG_file__seek(pCtx, pFile, offset)  );
+		SG_ERR_CHECK(  SG_repo__hash__end(pCtx, pRepo, &pRHH, &psz_hid_computed)  );
+		if (0 != strcmp(psz_hid_computed, pItem->psz_hid))
+		{
+			SG_ERR_THROW(  SG_ERR_BLOB_NOT_VERIFIED_MISMATCH  );
+		}
+	}
 
-		SG_ERR_CHECK(  _store_one_blob(
-			pCtx,
-			pMe,
-			pFile,
-            psz_objectid,
-			buf,
-			buf_size,
-			ptx,
-			psz_hid,
-			encoding,
-			psz_hid_vcdiff,
-			len_full,
-			len_encoded
-			)  );
+	/* fall through */
 
+fail:
+	if (b_inflating)
+	{
+		(void)inflateEnd(&strm);
 	}
-	if (rc != SQLITE_DONE)
+	if (pRHH)
+	{
+		SG_ERR_IGNORE(  SG_repo__hash__abort(pCtx, pRepo, &pRHH)  );
+	}
+	SG_NULLFREE(pCtx, psz_hid_computed);
+}
+
+/**
+ * Everything about storing a blob that doesn't need the repo tx:
+ * verify it, and if it's small enough, get the bytes ready in memory.
+ * A full blob gets deflated here, since the repo would otherwise do
+ * that (and hash it again) on the store thread.
+ */
+static void _prepare_one_blob(
+	SG_context* pCtx,
+	sg_staging* pMe,
+	my_store_reader* pr,
+	my_store_item* pItem
+	)
+{
+	SG_byte* pBufKeep = NULL;
+	SG_byte* pBufDeflated = NULL;
+	uLongf len_deflated = 0;
+	int zErr;
+
+	if (!pr->buf)
+	{
+		SG_ERR_CHECK(  SG_allocN(pCtx, SG_STREAMING_BUFFER_SIZE, pr->buf)  );
+		SG_ERR_CHECK(  SG_allocN(pCtx, SG_STREAMING_BUFFER_SIZE, pr->buf_inflate)  );
+	}
+
+	if (pItem->len_encoded <= MY_STORE__MAX_IN_MEMORY)
+	{
+		SG_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)pItem->len_encoded + 1, pBufKeep)  );
+	}
+	else if (!SG_IS_BLOBENCODING_FULL(pItem->encoding) && (SG_BLOBENCODING__ZLIB != pItem->encoding))
+	{
+		// nothing to check, and too big to hold.  the store thread copies it.
+		pItem->encoding_store = pItem->encoding;
+		return;
+	}
+
+	SG_ERR_CHECK(  _store_reader__seek(pCtx, pMe, pr, pItem)  );
+	SG_ERR_CHECK(  _verify_one_blob(pCtx, pMe->pRepo, pr, pItem, pBufKeep)  );
+
+	pItem->encoding_store = pItem->encoding;
+
+	if (pBufKeep && (SG_BLOBENCODING__FULL == pItem->encoding))
+	{
+		len_deflated = compressBound((uLong) pItem->len_encoded);
+		SG_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)len_deflated, pBufDeflated)  );
+		zErr = compress2(pBufDeflated, &len_deflated, pBufKeep, (uLong) pItem->len_encoded, Z_DEFAULT_COMPRESSION);
+		if (zErr != Z_OK)
+		{
+			SG_ERR_THROW(  SG_ERR_ZLIB(zErr)  );
+		}
+
+		SG_NULLFREE(pCtx, pBufKeep);
+		pItem->pBuf = pBufDeflated;
+		pBufDeflated = NULL;
+		pItem->len_store = (SG_uint32) len_deflated;
+		pItem->encoding_store = SG_BLOBENCODING__ZLIB;
+	}
+	else if (pBufKeep)
+	{
+		pItem->pBuf = pBufKeep;
+		pBufKeep = NULL;
+		pItem->len_store = (SG_uint32) pItem->len_encoded;
+	}
+
+	/* fall through */
+
+fail:
+	SG_NULLFREE(pCtx, pBufKeep);
+	SG_NULLFREE(pCtx, pBufDeflated);
+}
+
+static void _store_worker(SG_context* pCtx, SG_uint32 kThread, void* pVoidData, void* pVoidItem)
+{
+	my_store_data* pData = (my_store_data*) pVoidData;
+
+	SG_ERR_CHECK_RETURN(  _prepare_one_blob(pCtx, pData->pMe, &pData->pa_readers[kThread], (my_store_item*) pVoidItem)  );
+}
+
+static void _store_one_blob__from_memory(
+	SG_context* pCtx,
+	sg_staging* pMe,
+	SG_repo_tx_handle* ptx,
+	const my_store_item* pItem
+	)
+{
+	SG_repo_store_blob_handle* pbh = NULL;
+
+	SG_ERR_CHECK(  SG_repo__store_blob__begin(pCtx, pMe->pRepo, ptx, pItem->psz_objectid, pItem->encoding_store, pItem->psz_hid_vcdiff, pItem->len_full, pItem->len_store, pItem->psz_hid, &pbh)  );
+	SG_ERR_CHECK(  SG_repo__store_blob__chunk(pCtx, pMe->pRepo, pbh, pItem->len_store, pItem->pBuf, NULL)  );
+	SG_ERR_CHECK(  SG_repo__store_blob__end(pCtx, pMe->pRepo, ptx, &pbh, NULL)  );
+
+	return;
+
+fail:
+	if (pbh)
+		SG_ERR_IGNORE(  SG_repo__store_blob__abort(pCtx, pMe->pRepo, ptx, &pbh)  );
+}
+
+static void _load_blobs_present(
+	SG_context* pCtx,
+	sg_staging* pMe,
+	my_store_item** ppa_items,
+	SG_uint32* pCount
+	)
+{
+	sqlite3_stmt* pStmt = NULL;
+	int rc = SQLITE_DONE;
+	SG_int32 count = 0;
+	SG_int32 i = 0;
+	my_store_item* pa_items = NULL;
+
+	SG_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, pMe->psql, &count, "SELECT COUNT(*) FROM blobs_present")  );
+	if (!count)
+	{
+		goto fail;
+	}
+	SG_ERR_CHECK(  SG_allocN(pCtx, count, pa_items)  );
+
+	SG_ERR_CHECK(  sg_sqlite__prepare(pCtx, pMe->psql,&pStmt,
+		"SELECT hid, filename, offset, encoding, len_encoded, len_full, hid_vcdiff, objectid FROM blobs_present ORDER BY filename ASC, offset ASC")  );
+
+	while ((i < count) && ((rc=sqlite3_step(pStmt)) == SQLITE_ROW))
+	{
+		my_store_item* pItem = &pa_items[i++];
+		const char * psz_hid_vcdiff = (const char *)sqlite3_column_text(pStmt,6);
+		const char * psz_objectid = (const char *)sqlite3_column_text(pStmt,7);
+
+		SG_ERR_CHECK(  SG_STRDUP(pCtx, (const char*) sqlite3_column_text(pStmt, 0), &pItem->psz_hid)  );
+		SG_ERR_CHECK(  SG_STRDUP(pCtx, (const char*) sqlite3_column_text(pStmt, 1), &pItem->psz_filename)  );
+		pItem->offset = sqlite3_column_int64(pStmt,2);
+		pItem->encoding = (SG_blob_encoding)sqlite3_column_int(pStmt,3);
+		pItem->len_encoded = sqlite3_column_int64(pStmt, 4);
+		pItem->len_full = sqlite3_column_int64(pStmt, 5);
+		if (psz_hid_vcdiff)
+			SG_ERR_CHECK(  SG_STRDUP(pCtx, psz_hid_vcdiff, &pItem->psz_hid_vcdiff)  );
+		if (psz_objectid)
+			SG_ERR_CHECK(  SG_STRDUP(pCtx, psz_objectid, &pItem->psz_objectid)  );
+	}
+	if (i != count)
 	{
 		SG_ERR_THROW(  SG_ERR_SQLITE(rc)  );
 	}
 
+	*ppa_items = pa_items;
+	pa_items = NULL;
+	*pCount = (SG_uint32) count;
+
 	/* fall thru */
 
 fail:
-	SG_NULLFREE(pCtx, buf);
 	if (pStmt)
 		SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx,&pStmt)  );
-	SG_FILE_NULLCLOSE(pCtx, pFile);
-	SG_NULLFREE(pCtx, pszLastFile);
-	SG_PATHNAME_NULLFREE(pCtx, pPath_file);
+	if (pa_items)
+	{
+		for (i=0; i<count; i++)
+		{
+			SG_NULLFREE(pCtx, pa_items[i].psz_hid);
+			SG_NULLFREE(pCtx, pa_items[i].psz_filename);
+			SG_NULLFREE(pCtx, pa_items[i].psz_hid_vcdiff);
+			SG_NULLFREE(pCtx, pa_items[i].psz_objectid);
+		}
+		SG_NULLFREE(pCtx, pa_items);
+	}
+}
+
+/**
+ * Move every blob in the staging area into the repo.
+ *
+ * Reading, verifying, inflating and deflating blobs is done on a
+ * work queue, each worker with its own file handles.  This thread is
+ * the only one that touches the repo tx: it takes the blobs back from
+ * the queue in fragball order and stores them.  It never lets the
+ * workers get more than MY_STORE__MAX_AHEAD blobs ahead of it, which
+ * bounds the memory used.  The first failure anywhere stops
+ * everything and fails the commit.
+ */
+static void _store_all_blobs(
+	SG_context* pCtx,
+	sg_staging* pMe,
+	SG_repo_tx_handle* ptx
+	)
+{
+	my_store_item* pa_items = NULL;
+	SG_uint32 count_items = 0;
+	my_store_data data;
+	SG_work_queue* pQueue = NULL;
+	SG_uint32 count_threads = 0;
+	SG_uint32 count_readers = 0;
+	my_store_reader r;
+	my_store_item* pItem = NULL;
+	SG_uint32 i;
+
+	memset(&data, 0, sizeof(data));
+	memset(&r, 0, sizeof(r));
+
+	SG_ERR_CHECK(  _load_blobs_present(pCtx, pMe, &pa_items, &count_items)  );
+	if (!count_items)
+	{
+		return;
+	}
+
+	data.pMe = pMe;
+	SG_ERR_CHECK(  SG_work_queue__alloc(pCtx, SG_MIN(MY_STORE__MAX_THREADS, count_items), 0, SG_WORK_QUEUE_FLAGS__COLLECT, _store_worker, &data, &pQueue)  );
+	SG_ERR_CHECK(  SG_work_queue__get_thread_count(pCtx, pQueue, &count_threads)  );
+	count_readers = (count_threads ? count_threads : 1);
+	SG_ERR_CHECK(  SG_allocN(pCtx, count_readers, data.pa_readers)  );
+
+	for (i=0; i<=count_items; i++)
+	{
+		if (i < count_items)
+		{
+			SG_ERR_CHECK(  SG_work_queue__add(pCtx, pQueue, &pa_items[i])  );
+			if (i < MY_STORE__MAX_AHEAD)
+			{
+				continue;
+			}
+		}
+
+		// store the oldest blob; at the end, store all the rest.
+		while (1)
+		{
+			SG_ERR_CHECK(  SG_work_queue__next_done(pCtx, pQueue, (void**) &pItem)  );
+			if (!pItem)
+			{
+				break;
+			}
+
+			if (pItem->pBuf)
+			{
+				SG_ERR_CHECK(  _store_one_blob__from_memory(pCtx, pMe, ptx, pItem)  );
+				SG_NULLFREE(pCtx, pItem->pBuf);
+			}
+			else
+			{
+				if (!r.buf)
+				{
+					SG_ERR_CHECK(  SG_allocN(pCtx, SG_STREAMING_BUFFER_SIZE, r.buf)  );
+				}
+				SG_ERR_CHECK(  _store_reader__seek(pCtx, pMe, &r, pItem)  );
+				SG_ERR_CHECK(  _store_one_blob(
+					pCtx,
+					pMe,
+					r.pFile,
+					pItem->psz_objectid,
+					r.buf,
+					SG_STREAMING_BUFFER_SIZE,
+					ptx,
+					pItem->psz_hid,
+					pItem->encoding,
+					pItem->psz_hid_vcdiff,
+					pItem->len_full,
+					pItem->len_encoded
+					)  );
+			}
+
+			if (i < count_items)
+			{
+				break;
+			}
+		}
+	}
+
+	SG_ERR_CHECK(  SG_work_queue__finish(pCtx, pQueue)  );
+
+	/* fall thru */
+
+fail:
+	// the workers must be stopped before their readers are closed.
+	SG_WORK_QUEUE_NULLFREE(pCtx, pQueue);
+	if (data.pa_readers)
+	{
+		for (i=0; i<count_readers; i++)
+		{
+			SG_ERR_IGNORE(  _store_reader__close(pCtx, &data.pa_readers[i])  );
+		}
+		SG_NULLFREE(pCtx, data.pa_readers);
+	}
+	SG_ERR_IGNORE(  _store_reader__close(pCtx, &r)  );
+	for (i=0; i<count_items; i++)
+	{
+		SG_NULLFREE(pCtx, pa_items[i].psz_hid);
+		SG_NULLFREE(pCtx, pa_items[i].psz_filename);
+		SG_NULLFREE(pCtx, pa_items[i].psz_hid_vcdiff);
+		SG_NULLFREE(pCtx, pa_items[i].psz_objectid);
+		SG_NULLFREE(pCtx, pa_items[i].pBuf);
+	}
+	SG_NULLFREE(pCtx, pa_items);
 }
 
 static void _check_all_frags(
@@ -990,6 +1399,46 @@ fail:
 	SG_ERR_IGNORE(  sg_sqlite__nullfinalize(pCtx,&pStmt)  );
 }
 
+/**
+ * Record a blob whose header is pvh and whose payload begins at the
+ * given offset of the named fragball.
+ */
+static void _save_blob_header(
+	SG_context* pCtx,
+	sg_staging* pMe,
+	const char* psz_filename,
+	SG_uint64 offset,
+	SG_vhash* pvh,
+	SG_uint64* p_len_encoded
+	)
+{
+	SG_int64 i64;
+	const char* psz_hid = NULL;
+	SG_blob_encoding encoding = 0;
+	const char* psz_hid_vcdiff_reference = NULL;
+	const char* psz_objectid = NULL;
+	SG_uint64 len_full  = 0;
+	SG_uint64 len_encoded  = 0;
+
+	// TODO: Should we check the blobs_referenced table to ensure this is a blob we actually want?
+	//       The assumption is that a blob would never arrive here unless it was first returned by
+	//       get_status, which means it's already in blobs_referenced.
+
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvh, "hid", &psz_hid)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvh, "encoding", &i64)  );
+	encoding = (SG_blob_encoding) i64;
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvh, "vcdiff_ref", &psz_hid_vcdiff_reference)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvh, "objectid", &psz_objectid)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvh, "len_full", &i64)  );
+	len_full = (SG_uint64) i64;
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__int64(pCtx, pvh, "len_encoded", &i64)  );
+	len_encoded = (SG_uint64) i64;
+
+	SG_ERR_CHECK_RETURN(  _save_blob_info(pCtx, pMe, psz_filename, offset, len_encoded, psz_hid, encoding, psz_hid_vcdiff_reference, psz_objectid, len_full)  );
+
+	*p_len_encoded = len_encoded;
+}
+
 static void _slurp__version_1(
 	SG_context* pCtx,
 	sg_staging* pMe,
@@ -1023,30 +1472,10 @@ static void _slurp__version_1(
 		}
 		else if (0 == strcmp(psz_op, "blob"))
 		{
-			SG_int64 i64;
-			const char* psz_hid = NULL;
-			SG_blob_encoding encoding = 0;
-			const char* psz_hid_vcdiff_reference = NULL;
-			const char* psz_objectid = NULL;
-			SG_uint64 len_full  = 0;
 			SG_uint64 len_encoded  = 0;
 
-			// TODO: Should we check the blobs_referenced table to ensure this is a blob we actually want?
-			//       The assumption is that a blob would never arrive here unless it was first returned by
-			//       get_status, which means it's already in blobs_referenced.
-
-			SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh, "hid", &psz_hid)  );
-			SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh, "encoding", &i64)  );
-			encoding = (SG_blob_encoding) i64;
-			SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh, "vcdiff_ref", &psz_hid_vcdiff_reference)  );
-			SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh, "objectid", &psz_objectid)  );
-			SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh, "len_full", &i64)  );
-			len_full = (SG_uint64) i64;
-			SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh, "len_encoded", &i64)  );
-			len_encoded = (SG_uint64) i64;
 			SG_ERR_CHECK(  SG_file__tell(pCtx, pfb, &iPos)  );
-
-			SG_ERR_CHECK(  _save_blob_info(pCtx, pMe, psz_filename, iPos, len_encoded, psz_hid, encoding, psz_hid_vcdiff_reference, psz_objectid, len_full)  );
+			SG_ERR_CHECK(  _save_blob_header(pCtx, pMe, psz_filename, iPos, pvh, &len_encoded)  );
 
 			/* seek ahead to skip the blob */
 			SG_ERR_CHECK(  SG_file__seek(pCtx, pfb, iPos + len_encoded)  );
@@ -1431,6 +1860,268 @@ fail:
 		SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pMe->psql, "ROLLBACK TRANSACTION")  );
 }
 
+/*
+ * A fragball writestream lets the staging area take a fragball as it
+ * arrives instead of after it has been written out somewhere else.
+ * The bytes go straight into a new fragball file in the staging
+ * directory, and the object headers are parsed as they go by, so the
+ * frags and blob offsets are known without reading the file back.
+ *
+ * The headers are only kept in memory until the stream is closed.  If
+ * the fragball ended cleanly on an object boundary, they are recorded
+ * in one short sqlite transaction; otherwise nothing is recorded and
+ * the file is removed.  Either way the staging db is not held in a
+ * transaction while the bytes are arriving.
+ */
+#define SG_STAGING_WRITER_KEY__OFFSET "staging_offset"
+
+struct _sg_staging_fragball_writer
+{
+	sg_staging* pMe;
+	char sz_filename[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPath;
+	SG_file* pFile;
+	SG_uint64 offset;           /* bytes written to pFile so far */
+	SG_varray* pva_headers;     /* object headers, in order, to record at close */
+	SG_bool b_failed;
+	SG_bool b_got_version;
+
+	/* parser state.  We are always collecting exactly one of:
+	 * the 4-byte header length, the header, or the payload. */
+	SG_byte ba_len[4];
+	SG_uint32 count_len;
+	SG_byte* p_header;
+	SG_uint32 len_header;
+	SG_uint32 count_header;
+	SG_uint64 left_payload;
+};
+typedef struct _sg_staging_fragball_writer sg_staging_fragball_writer;
+
+static void _fragball_writer__free(SG_context* pCtx, sg_staging_fragball_writer* pfw)
+{
+	if (!pfw)
+		return;
+
+	SG_FILE_NULLCLOSE(pCtx, pfw->pFile);
+	SG_PATHNAME_NULLFREE(pCtx, pfw->pPath);
+	SG_VARRAY_NULLFREE(pCtx, pfw->pva_headers);
+	SG_NULLFREE(pCtx, pfw->p_header);
+	SG_NULLFREE(pCtx, pfw);
+}
+
+static void _fragball_writer__header(
+	SG_context* pCtx,
+	sg_staging_fragball_writer* pfw,
+	SG_uint64 offset_payload
+	)
+{
+	SG_vhash* pvh = NULL;
+	const char* psz = NULL;
+	SG_int64 i64 = 0;
+
+	if (pfw->p_header[pfw->len_header - 1])
+		SG_ERR_THROW(  SG_ERR_FRAGBALL_INVALID_OP  );
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC__FROM_JSON(pCtx, &pvh, (const char*) pfw->p_header)  );
+	SG_NULLFREE(pCtx, pfw->p_header);
+
+	if (!pfw->b_got_version)
+	{
+		SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh, "version", &psz)  );
+		if (1 != atoi(psz))
+			SG_ERR_THROW(  SG_ERR_FRAGBALL_INVALID_VERSION  );
+		pfw->b_got_version = SG_TRUE;
+	}
+	else
+	{
+		SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh, "op", &psz)  );
+		if (0 == strcmp(psz, "blob"))
+		{
+			/* we need the length now to find the next header, and the
+			 * offset later to record the blob. */
+			SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh, "len_encoded", &i64)  );
+			pfw->left_payload = (SG_uint64) i64;
+			SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, SG_STAGING_WRITER_KEY__OFFSET, (SG_int64) offset_payload)  );
+		}
+		else if (0 != strcmp(psz, "frag"))
+		{
+			SG_ERR_THROW(  SG_ERR_FRAGBALL_INVALID_OP  );
+		}
+
+		SG_ERR_CHECK(  SG_varray__append__vhash(pCtx, pfw->pva_headers, &pvh)  );
+	}
+
+	/* fall through */
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvh);
+}
+
+static SG_stream__func__write _fragball_writer__write;
+
+static void _fragball_writer__write(
+	SG_context* pCtx,
+	void* pUnderlying,
+	SG_uint32 iNumBytes,
+	SG_byte* pBytes,
+	SG_uint32* piNumBytesWritten
+	)
+{
+	sg_staging_fragball_writer* pfw = (sg_staging_fragball_writer*) pUnderlying;
+	SG_uint32 i = 0;
+
+	SG_ERR_CHECK(  SG_file__write(pCtx, pfw->pFile, iNumBytes, pBytes, NULL)  );
+
+	while (i < iNumBytes)
+	{
+		if (pfw->left_payload)
+		{
+			SG_uint32 n = iNumBytes - i;
+
+			if (n > pfw->left_payload)
+				n = (SG_uint32) pfw->left_payload;
+			pfw->left_payload -= n;
+			i += n;
+		}
+		else if (pfw->p_header)
+		{
+			SG_uint32 n = SG_MIN(iNumBytes - i, pfw->len_header - pfw->count_header);
+
+			memcpy(pfw->p_header + pfw->count_header, pBytes + i, n);
+			pfw->count_header += n;
+			i += n;
+
+			if (pfw->count_header == pfw->len_header)
+				SG_ERR_CHECK(  _fragball_writer__header(pCtx, pfw, pfw->offset + i)  );
+		}
+		else
+		{
+			pfw->ba_len[pfw->count_len++] = pBytes[i++];
+			if (4 == pfw->count_len)
+			{
+				pfw->len_header = (pfw->ba_len[0] << 24)
+					| (pfw->ba_len[1] << 16)
+					| (pfw->ba_len[2] <<  8)
+					| (pfw->ba_len[3] <<  0);
+				pfw->count_len = 0;
+				pfw->count_header = 0;
+
+				if (0 == pfw->len_header)
+					SG_ERR_THROW(  SG_ERR_FRAGBALL_INVALID_OP  );
+				SG_ERR_CHECK(  SG_alloc(pCtx, pfw->len_header, 1, &pfw->p_header)  );
+			}
+		}
+	}
+
+	pfw->offset += iNumBytes;
+
+	if (piNumBytesWritten)
+		*piNumBytesWritten = iNumBytes;
+
+	return;
+
+fail:
+	pfw->b_failed = SG_TRUE;
+}
+
+static SG_stream__func__close _fragball_writer__close;
+
+static void _fragball_writer__close(SG_context* pCtx, void* pUnderlying)
+{
+	sg_staging_fragball_writer* pfw = (sg_staging_fragball_writer*) pUnderlying;
+	SG_bool bInSqlTx = SG_FALSE;
+	SG_uint32 count = 0;
+	SG_uint32 i;
+
+	if (pfw->b_failed
+		|| !pfw->b_got_version
+		|| pfw->count_len
+		|| pfw->p_header
+		|| pfw->left_payload)
+	{
+		SG_ERR_THROW(  SG_ERR_INCOMPLETEREAD  );
+	}
+
+	SG_ERR_CHECK(  SG_file__close(pCtx, &pfw->pFile)  );
+
+	SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pfw->pMe->psql, "BEGIN TRANSACTION")  );
+	bInSqlTx = SG_TRUE;
+
+	SG_ERR_CHECK(  SG_varray__count(pCtx, pfw->pva_headers, &count)  );
+	for (i = 0; i < count; i++)
+	{
+		SG_vhash* pvh = NULL;
+		const char* psz_op = NULL;
+
+		SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pfw->pva_headers, i, &pvh)  );
+		SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh, "op", &psz_op)  );
+		if (0 == strcmp(psz_op, "frag"))
+		{
+			SG_vhash* pvh_frag = NULL;
+
+			SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvh, "frag", &pvh_frag)  );
+			SG_ERR_CHECK(  _save_frag(pCtx, pfw->pMe, pvh_frag)  );
+		}
+		else
+		{
+			SG_int64 offset = 0;
+			SG_uint64 len_encoded = 0;
+
+			SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvh, SG_STAGING_WRITER_KEY__OFFSET, &offset)  );
+			SG_ERR_CHECK(  _save_blob_header(pCtx, pfw->pMe, pfw->sz_filename, (SG_uint64) offset, pvh, &len_encoded)  );
+		}
+	}
+
+	SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pfw->pMe->psql, "COMMIT TRANSACTION")  );
+	bInSqlTx = SG_FALSE;
+
+	_fragball_writer__free(pCtx, pfw);
+
+	return;
+
+fail:
+	if (bInSqlTx)
+		SG_ERR_IGNORE(  sg_sqlite__exec(pCtx, pfw->pMe->psql, "ROLLBACK TRANSACTION")  );
+	SG_FILE_NULLCLOSE(pCtx, pfw->pFile);
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pfw->pPath)  );
+	_fragball_writer__free(pCtx, pfw);
+}
+
+void SG_staging__open_fragball_writestream(
+	SG_context* pCtx,
+	SG_staging* pStaging,
+	SG_writestream** ppStream
+	)
+{
+	sg_staging* pMe = (sg_staging*)pStaging;
+	sg_staging_fragball_writer* pfw = NULL;
+
+	SG_NULLARGCHECK_RETURN(pStaging);
+	SG_NULLARGCHECK_RETURN(ppStream);
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pfw)  );
+	pfw->pMe = pMe;
+
+	SG_ERR_CHECK(  SG_tid__generate(pCtx, pfw->sz_filename, sizeof(pfw->sz_filename))  );
+	SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pfw->pPath, pMe->pPath, pfw->sz_filename)  );
+	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pfw->pPath, SG_FILE_WRONLY | SG_FILE_CREATE_NEW, 0644, &pfw->pFile)  );
+	SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pfw->pva_headers)  );
+
+	SG_ERR_CHECK(  SG_writestream__alloc(pCtx, pfw, _fragball_writer__write, _fragball_writer__close, ppStream)  );
+
+	return;
+
+fail:
+	if (pfw)
+	{
+		if (pfw->pFile)
+		{
+			SG_FILE_NULLCLOSE(pCtx, pfw->pFile);
+			SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pfw->pPath)  );
+		}
+		_fragball_writer__free(pCtx, pfw);
+	}
+}
+
 void SG_staging__commit(
 	SG_context* pCtx,
 	SG_staging* pStaging
@@ -1554,6 +2245,11 @@ void SG_staging__check_status(
 		SG_ERR_CHECK(  _check_blobs(pCtx, pMe, pvh_status, bCheckChangesetBlobs, bCheckDataBlobs)  );
 	SG_ERR_CHECK(  sg_sqlite__exec(pCtx, pMe->psql, "COMMIT TRANSACTION")  );
 
+	// If any dags are disconnected, tell the other side a little about what
+	// we have, so it can figure out how much it needs to send to connect them.
+	if (bCheckConnectedness)
+		SG_ERR_CHECK(  SG_sync__add_dag_samples_to_status(pCtx, pMe->pRepo, pvh_status)  );
+
 	/* TODO lots more checks here */
 
 	*ppResult = pvh_status;
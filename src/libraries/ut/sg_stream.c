@@ -189,23 +189,27 @@ fail:
     SG_NULLFREE(pCtx, pstrm);
 }
 
+/**
+ * The stream is freed even if the underlying close fails, so the
+ * caller must not close it again either way.
+ */
 void SG_writestream__close(
 	SG_context * pCtx,
 	SG_writestream* pstrm
 	)
 {
+	if (!pstrm)
+		return;
+
     if (pstrm->pfn_close)
     {
         SG_ERR_CHECK(  pstrm->pfn_close(pCtx,pstrm->pUnderlying)  );
     }
 
-    SG_NULLFREE(pCtx, pstrm);
-
-    return;
+    /* fall through */
 
 fail:
-	// TODO should this do a SG_NULLFREE(pstrm) ??
-    return;
+    SG_NULLFREE(pCtx, pstrm);
 }
 
 void SG_writestream__write(
@@ -305,6 +309,10 @@ void SG_seekreader__length(
     *piLength = psr->iLength;
 }
 
+/**
+ * Like SG_writestream__close, this frees the reader even if the
+ * underlying close fails.
+ */
 void SG_seekreader__close(
 	SG_context * pCtx,
 	SG_seekreader* psr
@@ -315,13 +323,10 @@ void SG_seekreader__close(
 
     SG_ERR_CHECK(  psr->pfn_close(pCtx, psr->pUnderlying)  );
 
-    SG_NULLFREE(pCtx, psr);
-
-    return;
+    /* fall through */
 
 fail:
-	// TODO should this do a SG_NULLFREE(psr) ??
-    return;
+    SG_NULLFREE(pCtx, psr);
 }
 
 void SG_seekreader__read(
@@ -16,6 +16,12 @@ limitations under the License.
 
 #include <sg.h>
 
+/**
+ * The most HIDs we'll put in the sample of one dag.  See
+ * SG_sync__add_dag_samples_to_status().
+ */
+#define MAX_SAMPLES_PER_DAG 64
+
 /**
  * Recursively compare dagnodes depth-first.
  */
@@ -255,7 +261,7 @@ void SG_sync__compare_repo_blobs(SG_context* pCtx,
 		SG_VHASH_NULLFREE(pCtx, pvh);
 	}
 
-	SG_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo2, NULL, NULL, &count_returned, NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
+	SG_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo2, NULL, NULL, &count_returned, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 	if (count_returned != count_observed)
 		*pbIdentical = SG_FALSE;
 
@@ -306,6 +312,16 @@ void SG_sync__add_n_generations(SG_context* pCtx,
 										   const char* pszDagnodeHid,
 										   SG_rbtree* prbDagnodeHids,
 										   SG_uint32 generations)
+{
+	SG_ERR_CHECK_RETURN(  SG_sync__add_generations(pCtx, pRepo, pszDagnodeHid, prbDagnodeHids, generations, 0)  );
+}
+
+void SG_sync__add_generations(SG_context* pCtx,
+							  SG_repo* pRepo,
+							  const char* pszDagnodeHid,
+							  SG_rbtree* prbDagnodeHids,
+							  SG_uint32 generations,
+							  SG_int32 genCommon)
 {
 	_dagwalk_data dagWalkData;
 	SG_dagnode* pStartNode = NULL;
@@ -315,6 +331,8 @@ void SG_sync__add_n_generations(SG_context* pCtx,
 	SG_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pszDagnodeHid, &pStartNode)  );
 	SG_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pStartNode, &startGen)  );
 	dagWalkData.genLimit = startGen - generations;
+	if (genCommon > 0 && genCommon < dagWalkData.genLimit)
+		dagWalkData.genLimit = genCommon;
 	dagWalkData.prbVisitedNodes = prbDagnodeHids;
 
 	SG_ERR_CHECK(  SG_dagwalker__walk_dag_single(pCtx, pRepo, pszDagnodeHid, _dagwalk_callback, &dagWalkData)  );
@@ -324,6 +342,190 @@ fail:
 	SG_DAGNODE_NULLFREE(pCtx, pStartNode);
 }
 
+/**
+ * Sample one dag: starting at each leaf, follow the first parent back
+ * and take the HIDs at distance 0, 1, 2, 4, 8, ... from the leaf.  That
+ * gives a few dozen HIDs even for a very deep dag, and the samples are
+ * densest near the leaves, which is where two repos usually diverge.
+ */
+static void _sample_one_dag(SG_context* pCtx,
+							SG_repo* pRepo,
+							SG_uint32 iDagNum,
+							SG_varray* pvaSamples)
+{
+	SG_rbtree* prbLeaves = NULL;
+	SG_rbtree* prbSampled = NULL;
+	SG_rbtree_iterator* pit = NULL;
+	const SG_dagindex* pIndex = NULL;
+	const char* pszLeaf = NULL;
+	SG_uint32 count_samples = 0;
+	SG_bool b = SG_FALSE;
+
+	SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, iDagNum, &prbLeaves)  );
+	if (!prbLeaves)
+		return;
+
+	SG_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbSampled)  );
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prbLeaves, &b, &pszLeaf, NULL)  );
+	while (b && (count_samples < MAX_SAMPLES_PER_DAG))
+	{
+		SG_uint32 iNode;
+		SG_uint32 dist = 0;
+		SG_uint32 next_sample = 0;
+		SG_bool bFound = SG_FALSE;
+
+		SG_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, iDagNum, pszLeaf, &pIndex)  );
+		SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszLeaf, &bFound, &iNode)  );
+
+		while (bFound && (count_samples < MAX_SAMPLES_PER_DAG))
+		{
+			SG_uint32 count_parents;
+			const SG_uint32* aParents;
+
+			if (dist == next_sample)
+			{
+				const char* pszHid;
+				SG_bool bAlready = SG_FALSE;
+
+				SG_ERR_CHECK(  SG_dagindex__get_hid_ref(pCtx, pIndex, iNode, &pszHid)  );
+				SG_ERR_CHECK(  SG_rbtree__find(pCtx, prbSampled, pszHid, &bAlready, NULL)  );
+				if (bAlready)
+					break;		// the rest of this line was sampled from another leaf.
+
+				SG_ERR_CHECK(  SG_rbtree__add(pCtx, prbSampled, pszHid)  );
+				SG_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaSamples, pszHid)  );
+				count_samples++;
+
+				next_sample = (next_sample ? (2 * next_sample) : 1);
+			}
+
+			SG_ERR_CHECK(  SG_dagindex__get_parents(pCtx, pIndex, iNode, &count_parents, &aParents)  );
+			bFound = (count_parents > 0);
+			if (bFound)
+				iNode = aParents[0];
+			dist++;
+		}
+
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &pszLeaf, NULL)  );
+	}
+
+	/* fall through */
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+	SG_RBTREE_NULLFREE(pCtx, prbLeaves);
+	SG_RBTREE_NULLFREE(pCtx, prbSampled);
+}
+
+void SG_sync__add_dag_samples_to_status(SG_context* pCtx,
+										SG_repo* pRepo,
+										SG_vhash* pvh_status)
+{
+	SG_vhash* pvh_dags = NULL;
+	SG_vhash* pvh_samples = NULL;
+	SG_varray* pva = NULL;
+	SG_uint32 count_dagnums = 0;
+	SG_uint32 i;
+	SG_bool b = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(pvh_status);
+
+	SG_ERR_CHECK_RETURN(  SG_vhash__check__vhash(pCtx, pvh_status, SG_SYNC_STATUS_KEY__DAGS, &b, &pvh_dags)  );
+	if (!b || !pvh_dags)
+		return;
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh_samples)  );
+
+	SG_ERR_CHECK(  SG_vhash__count(pCtx, pvh_dags, &count_dagnums)  );
+	for (i = 0; i < count_dagnums; i++)
+	{
+		const char* pszDagNum = NULL;
+		SG_uint32 iDagNum;
+		SG_uint32 count_samples;
+
+		SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_dags, i, &pszDagNum, NULL)  );
+		SG_ERR_CHECK(  SG_dagnum__from_sz__decimal(pCtx, pszDagNum, &iDagNum)  );
+
+		SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pva)  );
+		_sample_one_dag(pCtx, pRepo, iDagNum, pva);
+		if (SG_context__err_equals(pCtx, SG_ERR_NOTIMPLEMENTED))
+		{
+			// No dag index for this repo.  The samples are only a hint, so
+			// the other side will just have to do without them.
+			SG_context__err_reset(pCtx);
+			SG_VARRAY_NULLFREE(pCtx, pva);
+			goto fail;
+		}
+		SG_ERR_CHECK_CURRENT;
+
+		SG_ERR_CHECK(  SG_varray__count(pCtx, pva, &count_samples)  );
+		if (count_samples)
+			SG_ERR_CHECK(  SG_vhash__add__varray(pCtx, pvh_samples, pszDagNum, &pva)  );
+		SG_VARRAY_NULLFREE(pCtx, pva);
+	}
+
+	SG_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pvh_status, SG_SYNC_STATUS_KEY__SAMPLES, &pvh_samples)  );
+
+	/* fall through */
+fail:
+	SG_VARRAY_NULLFREE(pCtx, pva);
+	SG_VHASH_NULLFREE(pCtx, pvh_samples);
+}
+
+void SG_sync__get_common_generation(SG_context* pCtx,
+									SG_repo* pRepo,
+									const SG_vhash* pvh_status,
+									const char* pszDagNum,
+									SG_int32* pGenCommon)
+{
+	SG_vhash* pvh_samples = NULL;
+	SG_varray* pva = NULL;
+	SG_dagnode* pdn = NULL;
+	SG_int32 genCommon = 0;
+	SG_uint32 count_samples = 0;
+	SG_uint32 i;
+	SG_bool b = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(pvh_status);
+	SG_NULLARGCHECK_RETURN(pszDagNum);
+	SG_NULLARGCHECK_RETURN(pGenCommon);
+
+	SG_ERR_CHECK(  SG_vhash__check__vhash(pCtx, pvh_status, SG_SYNC_STATUS_KEY__SAMPLES, &b, &pvh_samples)  );
+	if (b && pvh_samples)
+		SG_ERR_CHECK(  SG_vhash__check__varray(pCtx, pvh_samples, pszDagNum, &b, &pva)  );
+	if (b && pva)
+		SG_ERR_CHECK(  SG_varray__count(pCtx, pva, &count_samples)  );
+
+	for (i = 0; i < count_samples; i++)
+	{
+		const char* pszHid = NULL;
+		SG_int32 gen;
+
+		SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pva, i, &pszHid)  );
+
+		SG_repo__fetch_dagnode(pCtx, pRepo, pszHid, &pdn);
+		if (SG_context__err_equals(pCtx, SG_ERR_NOT_FOUND))
+		{
+			SG_context__err_reset(pCtx);
+			continue;
+		}
+		SG_ERR_CHECK_CURRENT;
+
+		SG_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pdn, &gen)  );
+		if (gen > genCommon)
+			genCommon = gen;
+		SG_DAGNODE_NULLFREE(pCtx, pdn);
+	}
+
+	*pGenCommon = genCommon;
+
+	/* fall through */
+fail:
+	SG_DAGNODE_NULLFREE(pCtx, pdn);
+}
+
 void SG_sync__add_blobs_to_fragball(SG_context* pCtx, SG_repo* pRepo, SG_pathname* pPath_fragball, SG_vhash* pvh_missing_blobs)
 {
 	SG_uint32 iMissingBlobCount;
@@ -347,3 +549,27 @@ void SG_sync__add_blobs_to_fragball(SG_context* pCtx, SG_repo* pRepo, SG_pathnam
 fail:
 	SG_NULLFREE(pCtx, paszHids);
 }
+
+void SG_sync__add_blobs_to_fragball_stream(SG_context* pCtx, SG_fragball_stream* pFragballStream, SG_vhash* pvh_missing_blobs)
+{
+	SG_uint32 iMissingBlobCount;
+	const char** paszHids = NULL;
+
+	SG_NULLARGCHECK_RETURN(pFragballStream);
+	SG_NULLARGCHECK_RETURN(pvh_missing_blobs);
+
+	SG_ERR_CHECK_RETURN(  SG_vhash__count(pCtx, pvh_missing_blobs, &iMissingBlobCount)  );
+	if (iMissingBlobCount > 0)
+	{
+		SG_uint32 i;
+		SG_ERR_CHECK(  SG_allocN(pCtx, iMissingBlobCount, paszHids)  );
+		for (i = 0; i < iMissingBlobCount; i++)
+			SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, pvh_missing_blobs, i, &paszHids[i], NULL)  );
+	}
+
+	SG_ERR_CHECK(  SG_fragball_stream__add_blobs(pCtx, pFragballStream, paszHids, iMissingBlobCount)  );
+
+	/* fall through */
+fail:
+	SG_NULLFREE(pCtx, paszHids);
+}
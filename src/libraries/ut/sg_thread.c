@@ -0,0 +1,177 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <sg.h>
+
+#if defined(MAC) || defined(LINUX)
+#include <unistd.h>
+
+static void* sg_thread__trampoline(void* p)
+{
+    SG_thread* pThread = (SG_thread*) p;
+
+    pThread->pfn(pThread->pArg);
+
+    return NULL;
+}
+#endif
+
+#if defined(WINDOWS)
+static DWORD WINAPI sg_thread__trampoline(LPVOID p)
+{
+    SG_thread* pThread = (SG_thread*) p;
+
+    pThread->pfn(pThread->pArg);
+
+    return 0;
+}
+#endif
+
+void SG_thread__start(SG_context* pCtx, SG_thread* pThread, SG_thread__func* pfn, void* pArg)
+{
+#if defined(MAC) || defined(LINUX)
+    int rc;
+#endif
+
+    SG_NULLARGCHECK_RETURN(pThread);
+    SG_NULLARGCHECK_RETURN(pfn);
+
+    pThread->pfn = pfn;
+    pThread->pArg = pArg;
+
+#if defined(MAC) || defined(LINUX)
+    rc = pthread_create(&pThread->thr, NULL, sg_thread__trampoline, pThread);
+    if (rc)
+    {
+        SG_ERR_THROW_RETURN(  SG_ERR_ERRNO(rc)  );
+    }
+#endif
+
+#if defined(WINDOWS)
+    pThread->h = CreateThread(NULL, 0, sg_thread__trampoline, pThread, 0, NULL);
+    if (!pThread->h)
+    {
+        SG_ERR_THROW_RETURN(  SG_ERR_GETLASTERROR(GetLastError())  );
+    }
+#endif
+}
+
+void SG_thread__join(SG_context* pCtx, SG_thread* pThread)
+{
+#if defined(MAC) || defined(LINUX)
+    int rc;
+#endif
+
+    SG_NULLARGCHECK_RETURN(pThread);
+
+#if defined(MAC) || defined(LINUX)
+    rc = pthread_join(pThread->thr, NULL);
+    if (rc)
+    {
+        SG_ERR_THROW_RETURN(  SG_ERR_ERRNO(rc)  );
+    }
+#endif
+
+#if defined(WINDOWS)
+    if (WAIT_OBJECT_0 != WaitForSingleObject(pThread->h, INFINITE))
+    {
+        SG_ERR_THROW_RETURN(  SG_ERR_GETLASTERROR(GetLastError())  );
+    }
+    CloseHandle(pThread->h);
+    pThread->h = NULL;
+#endif
+}
+
+SG_uint32 SG_thread__count_processors(void)
+{
+#if defined(MAC) || defined(LINUX)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (n > 0) ? (SG_uint32) n : 1;
+#endif
+
+#if defined(WINDOWS)
+    SYSTEM_INFO si;
+
+    GetSystemInfo(&si);
+
+    return (si.dwNumberOfProcessors > 0) ? (SG_uint32) si.dwNumberOfProcessors : 1;
+#endif
+}
+
+
+int SG_cond__init(SG_cond* pc)
+{
+#if defined(MAC) || defined(LINUX)
+    return pthread_cond_init(&pc->cond, NULL);
+#endif
+
+#if defined(WINDOWS)
+    InitializeConditionVariable(&pc->cv);
+    return 0;
+#endif
+}
+
+void SG_cond__destroy(SG_cond* pc)
+{
+#if defined(MAC) || defined(LINUX)
+    (void) pthread_cond_destroy(&pc->cond);
+#endif
+
+#if defined(WINDOWS)
+    // nothing to release
+    (void) pc;
+#endif
+}
+
+int SG_cond__wait(SG_cond* pc, SG_mutex* pm)
+{
+#if defined(MAC) || defined(LINUX)
+    return pthread_cond_wait(&pc->cond, &pm->mtx);
+#endif
+
+#if defined(WINDOWS)
+    if (!SleepConditionVariableCS(&pc->cv, &pm->cs, INFINITE))
+    {
+        return (int) GetLastError();
+    }
+    return 0;
+#endif
+}
+
+int SG_cond__signal(SG_cond* pc)
+{
+#if defined(MAC) || defined(LINUX)
+    return pthread_cond_signal(&pc->cond);
+#endif
+
+#if defined(WINDOWS)
+    WakeConditionVariable(&pc->cv);
+    return 0;
+#endif
+}
+
+int SG_cond__broadcast(SG_cond* pc)
+{
+#if defined(MAC) || defined(LINUX)
+    return pthread_cond_broadcast(&pc->cond);
+#endif
+
+#if defined(WINDOWS)
+    WakeAllConditionVariable(&pc->cv);
+    return 0;
+#endif
+}
@@ -63,6 +63,13 @@ struct SG_treenode
 	 * recommend it.
 	 */
 	char*					m_pszidHidFrozen;
+
+	/**
+	 * Frozen Treenodes loaded from the repo are shared with the
+	 * repo's object cache.  This counts the references beyond the
+	 * first; see SG_objcache__share().
+	 */
+	SG_uint32				m_nShares;
 };
 
 //////////////////////////////////////////////////////////////////
@@ -120,6 +127,9 @@ void SG_treenode__free(SG_context * pCtx, SG_treenode * pTreenode)
 	if (!pTreenode)
 		return;
 
+	if (SG_objcache__unshare(&pTreenode->m_nShares))
+		return;
+
 	if (pTreenode->m_vhash)
 		SG_VHASH_NULLFREE(pCtx, pTreenode->m_vhash);
 
@@ -129,6 +139,13 @@ void SG_treenode__free(SG_context * pCtx, SG_treenode * pTreenode)
 	SG_NULLFREE(pCtx, pTreenode);
 }
 
+void SG_treenode__addref(SG_context * pCtx, SG_treenode * pTreenode)
+{
+	SG_UNUSED(pCtx);
+
+	SG_objcache__share(&pTreenode->m_nShares);
+}
+
 //////////////////////////////////////////////////////////////////
 
 void SG_treenode__equal(
@@ -640,6 +657,10 @@ void SG_treenode__unfreeze(SG_context * pCtx, SG_treenode * pTreenode)
 {
 	SG_NULLARGCHECK_RETURN(pTreenode);
 
+	// other people are looking at this one.  clone it instead.
+	if (SG_objcache__is_shared(&pTreenode->m_nShares))
+		SG_ERR_THROW_RETURN(SG_ERR_INVALID_WHILE_FROZEN);
+
 	if (pTreenode->m_pszidHidFrozen)
 	{
 		SG_NULLFREE(pCtx, pTreenode->m_pszidHidFrozen);
@@ -751,8 +772,10 @@ void SG_treenode__load_from_repo(
 	// fetch contents of a Treenode-type blob and convert to an Treenode object.
 
 	SG_byte * pbuf = NULL;
+	SG_uint64 lenBuf = 0;
 	SG_treenode * pTreenode = NULL;
 	char* pszidHidCopy = NULL;
+	SG_objcache * pCache = NULL;
 
 	SG_NULLARGCHECK_RETURN(pRepo);
 	SG_NULLARGCHECK_RETURN(pszidHidBlob);
@@ -760,10 +783,24 @@ void SG_treenode__load_from_repo(
 
 	*ppTreenodeReturned = NULL;
 
+	// treenodes are immutable, so if we've already decoded this one
+	// we can just share it.
+
+	SG_ERR_CHECK(  SG_repo__get_objcache__ref(pCtx, pRepo, &pCache)  );
+	if (pCache)
+	{
+		SG_ERR_CHECK(  SG_objcache__lookup(pCtx, pCache, SG_OBJCACHE_TYPE__TREENODE, pszidHidBlob, (void**)&pTreenode)  );
+		if (pTreenode)
+		{
+			*ppTreenodeReturned = pTreenode;
+			return;
+		}
+	}
+
 	// fetch the Blob for the given HID and convert from a JSON stream into an
 	// allocated Treenode object.
 
-	SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo,pszidHidBlob,&pbuf,NULL)  );
+	SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo,pszidHidBlob,&pbuf,&lenBuf)  );
 	SG_ERR_CHECK(  _sg_treenode__alloc__from_json(pCtx, &pTreenode,(const char *)pbuf)  );
 	SG_NULLFREE(pCtx, pbuf);
 	pbuf = NULL;
@@ -774,6 +811,13 @@ void SG_treenode__load_from_repo(
 
 	SG_ERR_CHECK(  SG_strdup(pCtx, pszidHidBlob, &pszidHidCopy)  );
 	_sg_treenode__freeze(pCtx, pTreenode,pszidHidCopy);
+	pszidHidCopy = NULL;
+
+	if (pCache)
+		SG_ERR_CHECK(  SG_objcache__add(pCtx, pCache, SG_OBJCACHE_TYPE__TREENODE, pszidHidBlob, pTreenode,
+										(SG_uint32)lenBuf,
+										(SG_objcache__addref_callback*) SG_treenode__addref,
+										(SG_free_callback*) SG_treenode__free)  );
 
 	*ppTreenodeReturned = pTreenode;
 	return;
@@ -86,11 +86,11 @@ static SG_contenttype _figure_accept_header(const char * pAccept)
 
 //////////////////////////////////////////////////////////////////
 
-void SG_uridispatch__request(const char * pUri, const char *pQueryString, const char * pRequestMethod, SG_bool isSsl, const char *host, const char * pAccept, const char * pUserAgent, const char * pFrom, const char *pIfModifiedSince, void ** ppResponseHandle)
+void SG_uridispatch__request(const char * pUri, const char *pQueryString, const char * pRequestMethod, SG_bool isSsl, const char *host, const char * pAccept, const char * pUserAgent, const char * pFrom, const char *pIfModifiedSince, const char *pIfNoneMatch, void ** ppResponseHandle)
 {
     _request_handle * pRequestHandle = NULL;
 
-    SG_uridispatch__begin_request(pUri, pQueryString, pRequestMethod, isSsl, host, pAccept, pUserAgent, 0, pFrom, pIfModifiedSince, (void**)&pRequestHandle, ppResponseHandle);
+    SG_uridispatch__begin_request(pUri, pQueryString, pRequestMethod, isSsl, host, pAccept, pUserAgent, 0, pFrom, pIfModifiedSince, pIfNoneMatch, (void**)&pRequestHandle, ppResponseHandle);
 
     if(pRequestHandle!=NULL) // This probably shouldn't happen...
     {
@@ -126,7 +126,7 @@ static void _dupMinusSlashes(
 
 
 
-void SG_uridispatch__begin_request(const char * pUri, const char * pQueryString, const char * pRequestMethod, SG_bool isSsl, const char *host, const char * pAccept, const char * pUserAgent, SG_uint64 contentLength, const char * pFrom, const char *pIfModifiedSince, void ** ppRequestHandle__voidpp, void ** ppResponseHandle__voidpp)
+void SG_uridispatch__begin_request(const char * pUri, const char * pQueryString, const char * pRequestMethod, SG_bool isSsl, const char *host, const char * pAccept, const char * pUserAgent, SG_uint64 contentLength, const char * pFrom, const char *pIfModifiedSince, const char *pIfNoneMatch, void ** ppRequestHandle__voidpp, void ** ppResponseHandle__voidpp)
 {
     _request_handle ** ppRequestHandle = (_request_handle**)ppRequestHandle__voidpp;
     _response_handle ** ppResponseHandle = (_response_handle**)ppResponseHandle__voidpp;
@@ -220,6 +220,7 @@ void SG_uridispatch__begin_request(const char * pUri, const char * pQueryString,
         requestHeaders.contentLength = contentLength;
 		requestHeaders.ifModifiedSince = ifModifiedSince;
 		requestHeaders.localIfModifiedSince = localIfModifiedSince;
+		requestHeaders.pIfNoneMatch = pIfNoneMatch;
         requestHeaders.pFrom = pFrom;
 		requestHeaders.pQueryString = pQueryString;
 		requestHeaders.pHost = host;
@@ -714,11 +715,683 @@ void SG_uridispatch__abort_response(void ** ppResponseHandle__voidpp)
 
 
 //////////////////////////////////////////////////////////////////
-// sg_lib_uridispatch__global_cleanup is prototyped in sg_lib__private.h, not sg_uridispatch_prototypes.h.
+// Repo handle pool.
+//
+// Opening a repo instance means reading the closet descriptor and opening
+// the repo's database(s), index files, etc.  When the server is answering
+// a steady stream of small requests, that is most of the work.  So instead
+// of freeing the repo when a request is done, we keep the handle around
+// (by descriptor name) and give it to the next request for the same repo.
+//
+// A handle is only used by one request at a time.  Since other handles
+// (and other processes) may store dagnodes while a handle sits in the pool,
+// we drop its caches (dag indexes, fs3's reference cache) before it goes
+// back in; that also keeps an idle handle from holding on to memory and
+// temp files.  Every so often we also compare the closet descriptor with
+// the one the handle was opened with, so that a repo which was deleted (or
+// re-created under the same name) doesn't get served from an old handle.
+//
+// A handle that comes back from a failed or aborted request is closed, not
+// kept.  And we limit how many handles can be out at once; past that,
+// requests get SG_ERR_REPO_BUSY (503) rather than opening yet another one.
+
+#define MY_POOL__MAX_IDLE_PER_REPO		4
+#define MY_POOL__MAX_IDLE				32
+#define MY_POOL__MAX_BORROWED			64
+#define MY_POOL__REVALIDATE_MS			1000
+
+typedef struct
+{
+	SG_repo * apRepo[MY_POOL__MAX_IDLE_PER_REPO];
+	SG_uint32 count;
+	SG_int64 timeValidated;
+} _repo_pool_bucket;
+
+static struct
+{
+	SG_bool bInitialized;
+	SG_mutex lock;
+	SG_rbtree * prbBuckets;		// descriptor name --> _repo_pool_bucket *
+	SG_uint32 countIdle;
+	SG_uint32 countBorrowed;
+
+	SG_uint64 nrHits;
+	SG_uint64 nrMisses;
+	SG_uint64 nrDiscarded;
+	SG_uint64 nrBusy;
+} gRepoPool;
+
+static void _repo_pool_bucket__free(SG_context * pCtx, _repo_pool_bucket * pBucket)
+{
+	SG_uint32 k;
+
+	if (!pBucket)
+		return;
+
+	for (k=0; k<pBucket->count; k++)
+		SG_REPO_NULLFREE(pCtx, pBucket->apRepo[k]);
+	SG_NULLFREE(pCtx, pBucket);
+}
+
+/**
+ * Is the closet descriptor for this name still the one the repo was opened with?
+ */
+static void _repo_pool__is_current(SG_context * pCtx, SG_repo * pRepo, const char * pszDescriptorName, SG_bool * pbCurrent)
+{
+	SG_vhash * pvhDescriptorNow = NULL;
+	const SG_vhash * pvhDescriptorOpened = NULL;
+
+	SG_closet__descriptors__get(pCtx, pszDescriptorName, &pvhDescriptorNow);
+	if (SG_context__err_equals(pCtx, SG_ERR_NOTAREPOSITORY))
+	{
+		SG_context__err_reset(pCtx);
+		*pbCurrent = SG_FALSE;
+		return;
+	}
+	SG_ERR_CHECK_CURRENT;
+
+	SG_ERR_CHECK(  SG_repo__get_descriptor(pCtx, pRepo, &pvhDescriptorOpened)  );
+	SG_ERR_CHECK(  SG_vhash__equal(pCtx, pvhDescriptorNow, pvhDescriptorOpened, pbCurrent)  );
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvhDescriptorNow);
+}
+
+/**
+ * Close all of the idle handles for the given descriptor name.
+ */
+static void _repo_pool__invalidate(SG_context * pCtx, const char * pszDescriptorName)
+{
+	_repo_pool_bucket * pBucket = NULL;
+	SG_bool bFound = SG_FALSE;
+
+	SG_mutex__lock(&gRepoPool.lock);
+	SG_rbtree__find(pCtx, gRepoPool.prbBuckets, pszDescriptorName, &bFound, (void**)&pBucket);
+	if (!SG_context__has_err(pCtx) && bFound)
+		SG_rbtree__remove(pCtx, gRepoPool.prbBuckets, pszDescriptorName);
+	if (!SG_context__has_err(pCtx) && bFound)
+	{
+		gRepoPool.countIdle -= pBucket->count;
+		gRepoPool.nrDiscarded += pBucket->count;
+	}
+	else
+		pBucket = NULL;
+	SG_mutex__unlock(&gRepoPool.lock);
+
+	// close the repos outside of the lock.
+	_repo_pool_bucket__free(pCtx, pBucket);
+}
+
+void _repo_pool__borrow(SG_context * pCtx, const char * pszDescriptorName, SG_repo ** ppRepo)
+{
+	SG_repo * pRepo = NULL;
+	_repo_pool_bucket * pBucket = NULL;
+	SG_bool bFound = SG_FALSE;
+	SG_bool bLocked = SG_FALSE;
+	SG_bool bCounted = SG_FALSE;
+	SG_bool bRevalidate = SG_FALSE;
+	SG_int64 timeNow = 0;
+
+	SG_NONEMPTYCHECK_RETURN(pszDescriptorName);
+	SG_NULL_PP_CHECK_RETURN(ppRepo);
+
+	if (gRepoPool.bInitialized)
+	{
+		SG_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &timeNow)  );
+
+		SG_mutex__lock(&gRepoPool.lock);
+		bLocked = SG_TRUE;
+
+		if (gRepoPool.countBorrowed >= MY_POOL__MAX_BORROWED)
+		{
+			gRepoPool.nrBusy++;
+			SG_ERR_THROW2(  SG_ERR_REPO_BUSY,
+							(pCtx, "%u repo handles are already in use", gRepoPool.countBorrowed)  );
+		}
+		gRepoPool.countBorrowed++;
+		bCounted = SG_TRUE;
+
+		SG_ERR_CHECK(  SG_rbtree__find(pCtx, gRepoPool.prbBuckets, pszDescriptorName, &bFound, (void**)&pBucket)  );
+		if (bFound && pBucket->count > 0)
+		{
+			pBucket->count--;
+			pRepo = pBucket->apRepo[pBucket->count];
+			pBucket->apRepo[pBucket->count] = NULL;
+			gRepoPool.countIdle--;
+			gRepoPool.nrHits++;
+
+			bRevalidate = (timeNow - pBucket->timeValidated >= MY_POOL__REVALIDATE_MS);
+		}
+		else
+		{
+			gRepoPool.nrMisses++;
+		}
+
+		SG_mutex__unlock(&gRepoPool.lock);
+		bLocked = SG_FALSE;
+	}
+
+	if (pRepo && bRevalidate)
+	{
+		SG_bool bCurrent = SG_FALSE;
+
+		SG_ERR_CHECK(  _repo_pool__is_current(pCtx, pRepo, pszDescriptorName, &bCurrent)  );
+		if (bCurrent)
+		{
+			SG_mutex__lock(&gRepoPool.lock);
+			bLocked = SG_TRUE;
+			SG_ERR_CHECK(  SG_rbtree__find(pCtx, gRepoPool.prbBuckets, pszDescriptorName, &bFound, (void**)&pBucket)  );
+			if (bFound)
+				pBucket->timeValidated = timeNow;
+			SG_mutex__unlock(&gRepoPool.lock);
+			bLocked = SG_FALSE;
+		}
+		else
+		{
+			SG_REPO_NULLFREE(pCtx, pRepo);
+			SG_ERR_CHECK(  _repo_pool__invalidate(pCtx, pszDescriptorName)  );
+		}
+	}
+
+	// pooled handles had their caches dropped when they were released.
+	if (!pRepo)
+		SG_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, pszDescriptorName, &pRepo)  );
+
+	*ppRepo = pRepo;
+	pRepo = NULL;
+	bCounted = SG_FALSE;
+
+fail:
+	if (bCounted)
+	{
+		if (!bLocked)
+		{
+			SG_mutex__lock(&gRepoPool.lock);
+			bLocked = SG_TRUE;
+		}
+		gRepoPool.countBorrowed--;
+	}
+	if (bLocked)
+		SG_mutex__unlock(&gRepoPool.lock);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+}
+
+static void _repo_pool__keep(SG_context * pCtx, SG_repo * pRepo, SG_bool * pbKept)
+{
+	const char * pszDescriptorName = NULL;
+	_repo_pool_bucket * pBucket = NULL;
+	SG_bool bFound = SG_FALSE;
+	SG_bool bLocked = SG_FALSE;
+	SG_int64 timeNow = 0;
+
+	*pbKept = SG_FALSE;
+
+	SG_ERR_CHECK(  SG_repo__get_descriptor_name(pCtx, pRepo, &pszDescriptorName)  );
+	if (!pszDescriptorName)
+		return;
+
+	SG_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &timeNow)  );
+
+	SG_mutex__lock(&gRepoPool.lock);
+	bLocked = SG_TRUE;
+
+	if (gRepoPool.countIdle < MY_POOL__MAX_IDLE)
+	{
+		SG_ERR_CHECK(  SG_rbtree__find(pCtx, gRepoPool.prbBuckets, pszDescriptorName, &bFound, (void**)&pBucket)  );
+		if (!bFound)
+		{
+			SG_ERR_CHECK(  SG_alloc1(pCtx, pBucket)  );
+			pBucket->timeValidated = timeNow;
+			SG_rbtree__add__with_assoc(pCtx, gRepoPool.prbBuckets, pszDescriptorName, pBucket);
+			if (SG_context__has_err(pCtx))
+			{
+				SG_NULLFREE(pCtx, pBucket);
+				SG_ERR_RETHROW;
+			}
+		}
+
+		if (pBucket->count < MY_POOL__MAX_IDLE_PER_REPO)
+		{
+			pBucket->apRepo[pBucket->count++] = pRepo;
+			gRepoPool.countIdle++;
+			*pbKept = SG_TRUE;
+		}
+	}
+
+fail:
+	if (bLocked)
+		SG_mutex__unlock(&gRepoPool.lock);
+}
+
+void _repo_pool__nullrelease(SG_context * pCtx, SG_repo ** ppRepo, SG_bool bFailed)
+{
+	SG_bool bKept = SG_FALSE;
+
+	if (!ppRepo || !*ppRepo)
+		return;
+
+	if (gRepoPool.bInitialized)
+	{
+		SG_mutex__lock(&gRepoPool.lock);
+		gRepoPool.countBorrowed--;
+		if (bFailed)
+			gRepoPool.nrDiscarded++;
+		SG_mutex__unlock(&gRepoPool.lock);
+
+		// If the request failed, we don't know what state the handle is in
+		// (an abandoned tx, for example), so we don't keep it.
+		if (!bFailed)
+		{
+			SG_context__push_level(pCtx);
+			SG_repo__drop_caches(pCtx, *ppRepo);
+			if (!SG_context__has_err(pCtx))
+				_repo_pool__keep(pCtx, *ppRepo, &bKept);
+			if (SG_context__has_err(pCtx))
+			{
+				SG_log_current_error(pCtx);
+				bKept = SG_FALSE;
+			}
+			SG_context__pop_level(pCtx);
+		}
+	}
+
+	if (bKept)
+		*ppRepo = NULL;
+	else
+		SG_REPO_NULLFREE(pCtx, *ppRepo);
+}
+
+void SG_uridispatch_debug__get_repo_pool_stats(SG_context * pCtx, SG_vhash ** ppvhStats)
+{
+	SG_vhash * pvh = NULL;
+	SG_bool bLocked = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(ppvhStats);
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvh)  );
+	SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "max_borrowed", MY_POOL__MAX_BORROWED)  );
+	if (gRepoPool.bInitialized)
+	{
+		SG_mutex__lock(&gRepoPool.lock);
+		bLocked = SG_TRUE;
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "hits", (SG_int64)gRepoPool.nrHits)  );
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "misses", (SG_int64)gRepoPool.nrMisses)  );
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "discarded", (SG_int64)gRepoPool.nrDiscarded)  );
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "busy", (SG_int64)gRepoPool.nrBusy)  );
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "idle", (SG_int64)gRepoPool.countIdle)  );
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvh, "borrowed", (SG_int64)gRepoPool.countBorrowed)  );
+		SG_mutex__unlock(&gRepoPool.lock);
+		bLocked = SG_FALSE;
+	}
+
+	*ppvhStats = pvh;
+	pvh = NULL;
+
+fail:
+	if (bLocked)
+		SG_mutex__unlock(&gRepoPool.lock);
+	SG_VHASH_NULLFREE(pCtx, pvh);
+}
+
+//////////////////////////////////////////////////////////////////
+// Response cache.
+//
+// Some GETs (the activity stream, history) are expensive to compute but
+// only change when the repo does.  The handler describes the repo state
+// the response depends on by the leaves of the dags involved (see
+// _repo_state__get_leaves); a hash of that is the response's ETag, so a
+// client that already has it can be sent a 304 straight away.  Otherwise
+// the handler looks for what it computed last time under a key of its
+// choosing.  An entry is a vhash owned by the handler; by convention it
+// has a "leaves" member recording the state it was computed from, which
+// also lets the handler update it incrementally rather than start over.
+
+#define MY_CACHE__MAX_ENTRIES			64
+
+typedef struct
+{
+	SG_vhash * pvhEntry;
+	SG_uint64 iLastUsed;
+} _response_cache_entry;
+
+static struct
+{
+	SG_bool bInitialized;
+	SG_mutex lock;
+	SG_rbtree * prbEntries;		// key --> _response_cache_entry *
+	SG_uint64 iClock;
+} gResponseCache;
+
+static void _response_cache_entry__free(SG_context * pCtx, _response_cache_entry * pEntry)
+{
+	if (!pEntry)
+		return;
+
+	SG_VHASH_NULLFREE(pCtx, pEntry->pvhEntry);
+	SG_NULLFREE(pCtx, pEntry);
+}
+
+void _response_cache__get(SG_context * pCtx, const char * pszKey, SG_vhash ** ppvhEntry)
+{
+	_response_cache_entry * pEntry = NULL;
+	SG_vhash * pvhCopy = NULL;
+	SG_bool bFound = SG_FALSE;
+
+	SG_NONEMPTYCHECK_RETURN(pszKey);
+	SG_NULLARGCHECK_RETURN(ppvhEntry);
+
+	*ppvhEntry = NULL;
+
+	if (!gResponseCache.bInitialized)
+		return;
+
+	SG_mutex__lock(&gResponseCache.lock);
+	SG_rbtree__find(pCtx, gResponseCache.prbEntries, pszKey, &bFound, (void**)&pEntry);
+	if (!SG_context__has_err(pCtx) && bFound)
+	{
+		pEntry->iLastUsed = ++gResponseCache.iClock;
+		SG_VHASH__ALLOC__COPY(pCtx, &pvhCopy, pEntry->pvhEntry);
+	}
+	SG_mutex__unlock(&gResponseCache.lock);
+	SG_ERR_CHECK_RETURN_CURRENT;
+
+	*ppvhEntry = pvhCopy;
+}
+
+/**
+ * Take the least recently used entry out of the cache.  Caller holds the lock.
+ */
+static void _response_cache__evict_one(SG_context * pCtx, _response_cache_entry ** ppEvicted)
+{
+	SG_rbtree_iterator * pIter = NULL;
+	const char * pszKey = NULL;
+	const char * pszKeyOldest = NULL;
+	_response_cache_entry * pEntry = NULL;
+	SG_uint64 iOldest = 0;
+	SG_bool b = SG_FALSE;
+
+	SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, gResponseCache.prbEntries, &b, &pszKey, (void**)&pEntry)  );
+	while (b)
+	{
+		if (!pszKeyOldest || pEntry->iLastUsed < iOldest)
+		{
+			pszKeyOldest = pszKey;
+			iOldest = pEntry->iLastUsed;
+		}
+		SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, &pszKey, (void**)&pEntry)  );
+	}
+
+	if (pszKeyOldest)
+		SG_ERR_CHECK(  SG_rbtree__remove__with_assoc(pCtx, gResponseCache.prbEntries, pszKeyOldest, (void**)ppEvicted)  );
+
+fail:
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+}
+
+void _response_cache__put(SG_context * pCtx, const char * pszKey, SG_vhash ** ppvhEntry)
+{
+	_response_cache_entry * pNew = NULL;
+	_response_cache_entry * pOld = NULL;
+	_response_cache_entry * pEvicted = NULL;
+	SG_bool bLocked = SG_FALSE;
+	SG_bool bFound = SG_FALSE;
+	SG_uint32 count = 0;
+
+	SG_NONEMPTYCHECK_RETURN(pszKey);
+	SG_NULL_PP_CHECK_RETURN(ppvhEntry);
+
+	if (!gResponseCache.bInitialized)
+	{
+		SG_VHASH_NULLFREE(pCtx, *ppvhEntry);
+		return;
+	}
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pNew)  );
+	pNew->pvhEntry = *ppvhEntry;
+	*ppvhEntry = NULL;
+
+	SG_mutex__lock(&gResponseCache.lock);
+	bLocked = SG_TRUE;
+
+	pNew->iLastUsed = ++gResponseCache.iClock;
+
+	SG_ERR_CHECK(  SG_rbtree__find(pCtx, gResponseCache.prbEntries, pszKey, &bFound, NULL)  );
+	if (!bFound)
+	{
+		SG_ERR_CHECK(  SG_rbtree__count(pCtx, gResponseCache.prbEntries, &count)  );
+		if (count >= MY_CACHE__MAX_ENTRIES)
+			SG_ERR_CHECK(  _response_cache__evict_one(pCtx, &pEvicted)  );
+	}
+	SG_ERR_CHECK(  SG_rbtree__update__with_assoc(pCtx, gResponseCache.prbEntries, pszKey, pNew, (void**)&pOld)  );
+	pNew = NULL;
+
+fail:
+	if (bLocked)
+		SG_mutex__unlock(&gResponseCache.lock);
+	_response_cache_entry__free(pCtx, pNew);
+	_response_cache_entry__free(pCtx, pOld);
+	_response_cache_entry__free(pCtx, pEvicted);
+}
+
+void _repo_state__get_leaves(
+	SG_context * pCtx,
+	SG_repo * pRepo,
+	const SG_uint32 * paDagNums,
+	SG_uint32 countDagNums,
+	SG_vhash ** ppvhLeaves)
+{
+	SG_vhash * pvhLeaves = NULL;
+	SG_rbtree * prbLeaves = NULL;
+	SG_rbtree_iterator * pIter = NULL;
+	SG_varray * pvaLeaves = NULL;
+	const char * pszHid = NULL;
+	SG_bool b = SG_FALSE;
+	SG_uint32 k;
+
+	SG_NULLARGCHECK_RETURN(pRepo);
+	SG_NULLARGCHECK_RETURN(paDagNums);
+	SG_NULLARGCHECK_RETURN(ppvhLeaves);
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhLeaves)  );
+	for (k=0; k<countDagNums; k++)
+	{
+		char bufDagNum[SG_DAGNUM__BUF_MAX__DEC];
+
+		SG_ERR_CHECK(  SG_dagnum__to_sz__decimal(pCtx, paDagNums[k], bufDagNum, sizeof(bufDagNum))  );
+		SG_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, paDagNums[k], &prbLeaves)  );
+		SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaLeaves)  );
+		if (prbLeaves)
+		{
+			// the rbtree gives them to us sorted, so the same leaves always look the same.
+			SG_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, prbLeaves, &b, &pszHid, NULL)  );
+			while (b)
+			{
+				SG_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaLeaves, pszHid)  );
+				SG_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &b, &pszHid, NULL)  );
+			}
+			SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+		}
+		SG_ERR_CHECK(  SG_vhash__add__varray(pCtx, pvhLeaves, bufDagNum, &pvaLeaves)  );
+		SG_RBTREE_NULLFREE(pCtx, prbLeaves);
+	}
+
+	*ppvhLeaves = pvhLeaves;
+	pvhLeaves = NULL;
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvhLeaves);
+	SG_VARRAY_NULLFREE(pCtx, pvaLeaves);
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_RBTREE_NULLFREE(pCtx, prbLeaves);
+}
+
+void _repo_state__compute_etag(
+	SG_context * pCtx,
+	SG_repo * pRepo,
+	const SG_vhash * pvhLeaves,
+	const char * pszVariant,
+	char ** ppszETag)
+{
+	SG_string * pstr = NULL;
+
+	SG_NULLARGCHECK_RETURN(pvhLeaves);
+	SG_NULLARGCHECK_RETURN(ppszETag);
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC__SZ(pCtx, &pstr, (pszVariant ? pszVariant : ""))  );
+	SG_ERR_CHECK(  SG_string__append__sz(pCtx, pstr, "\n")  );
+	SG_ERR_CHECK(  SG_vhash__to_json(pCtx, pvhLeaves, pstr)  );
+	SG_ERR_CHECK(  SG_repo__alloc_compute_hash__from_string(pCtx, pRepo, pstr, ppszETag)  );
+
+fail:
+	SG_STRING_NULLFREE(pCtx, pstr);
+}
+
+void _repo_state__dag_unchanged(
+	SG_context * pCtx,
+	const SG_vhash * pvhLeavesOld,
+	const SG_vhash * pvhLeavesNew,
+	SG_uint32 iDagNum,
+	SG_bool * pbUnchanged)
+{
+	char bufDagNum[SG_DAGNUM__BUF_MAX__DEC];
+	SG_bool bHasOld = SG_FALSE;
+	SG_bool bHasNew = SG_FALSE;
+	SG_varray * pvaOld = NULL;
+	SG_varray * pvaNew = NULL;
+
+	SG_NULLARGCHECK_RETURN(pvhLeavesOld);
+	SG_NULLARGCHECK_RETURN(pvhLeavesNew);
+	SG_NULLARGCHECK_RETURN(pbUnchanged);
+
+	*pbUnchanged = SG_FALSE;
+
+	SG_ERR_CHECK_RETURN(  SG_dagnum__to_sz__decimal(pCtx, iDagNum, bufDagNum, sizeof(bufDagNum))  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__check__varray(pCtx, pvhLeavesOld, bufDagNum, &bHasOld, &pvaOld)  );
+	SG_ERR_CHECK_RETURN(  SG_vhash__check__varray(pCtx, pvhLeavesNew, bufDagNum, &bHasNew, &pvaNew)  );
+	if (!bHasOld || !bHasNew)
+		return;
+
+	SG_ERR_CHECK_RETURN(  SG_varray__equal(pCtx, pvaOld, pvaNew, pbUnchanged)  );
+}
+
+SG_bool _request_headers__if_none_match(const _request_headers * pRequestHeaders, const char * pszETag)
+{
+	const char * p = NULL;
+	SG_uint32 lenETag;
+
+	if (!pRequestHeaders || !pRequestHeaders->pIfNoneMatch || !pszETag)
+		return SG_FALSE;
+
+	lenETag = (SG_uint32)strlen(pszETag);
+	p = pRequestHeaders->pIfNoneMatch;
+
+	// The header is a comma-separated list of (possibly weak) quoted tags, or "*".
+	while (*p)
+	{
+		const char * pStart = NULL;
+		const char * pEnd = NULL;
+
+		while (*p==' ' || *p=='\t' || *p==',')
+			p++;
+		if (*p=='*')
+			return SG_TRUE;
+		if (p[0]=='W' && p[1]=='/')
+			p += 2;
+
+		pStart = p;
+		while (*p && *p!=',')
+			p++;
+		pEnd = p;
+		while (pEnd > pStart && (pEnd[-1]==' ' || pEnd[-1]=='\t'))
+			pEnd--;
+		if (pEnd - pStart >= 2 && *pStart=='"' && pEnd[-1]=='"')
+		{
+			pStart++;
+			pEnd--;
+		}
+
+		if ((SG_uint32)(pEnd - pStart) == lenETag && strncmp(pStart, pszETag, lenETag)==0)
+			return SG_TRUE;
+	}
+
+	return SG_FALSE;
+}
+
+void _create_response_handle_for_not_modified(
+	SG_context * pCtx,
+	const char * pszETag,
+	_response_handle ** ppResponseHandle)
+{
+	SG_string * pstrBody = NULL;
+
+	SG_NULLARGCHECK_RETURN(ppResponseHandle);
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrBody)  );
+	SG_ERR_CHECK(  _create_response_handle_for_string(pCtx, SG_HTTP_STATUS_NOT_MODIFIED, SG_contenttype__text, &pstrBody, ppResponseHandle)  );
+	if (pszETag)
+		SG_ERR_CHECK(  _response_handle__add_etag(pCtx, *ppResponseHandle, pszETag)  );
+
+fail:
+	SG_STRING_NULLFREE(pCtx, pstrBody);
+}
+
+void _response_handle__add_etag(SG_context * pCtx, _response_handle * pResponseHandle, const char * pszETag)
+{
+	SG_string * pstrETag = NULL;
+
+	SG_NULLARGCHECK_RETURN(pResponseHandle);
+	SG_NONEMPTYCHECK_RETURN(pszETag);
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrETag)  );
+	SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstrETag, "\"%s\"", pszETag)  );
+	SG_ERR_CHECK(  _response_handle__add_header(pCtx, pResponseHandle, "ETag", SG_string__sz(pstrETag))  );
+
+fail:
+	SG_STRING_NULLFREE(pCtx, pstrETag);
+}
+
+//////////////////////////////////////////////////////////////////
+// sg_lib_uridispatch__global_initialize and sg_lib_uridispatch__global_cleanup
+// are prototyped in sg_lib__private.h, not sg_uridispatch_prototypes.h.
+
+void sg_lib_uridispatch__global_initialize(SG_context * pCtx)
+{
+	if (gRepoPool.bInitialized)
+		return;
+
+	memset(&gRepoPool, 0, sizeof(gRepoPool));
+	SG_ERR_CHECK_RETURN(  SG_RBTREE__ALLOC(pCtx, &gRepoPool.prbBuckets)  );
+	SG_mutex__init(&gRepoPool.lock);
+	gRepoPool.bInitialized = SG_TRUE;
+
+	memset(&gResponseCache, 0, sizeof(gResponseCache));
+	SG_ERR_CHECK_RETURN(  SG_RBTREE__ALLOC(pCtx, &gResponseCache.prbEntries)  );
+	SG_mutex__init(&gResponseCache.lock);
+	gResponseCache.bInitialized = SG_TRUE;
+}
 
 extern SG_pathname * _sg_uridispatch__templatePath;
 void sg_lib_uridispatch__global_cleanup(SG_context * pCtx)
 {
     SG_PATHNAME_NULLFREE(pCtx, _sg_uridispatch__templatePath);
+
+	if (gRepoPool.bInitialized)
+	{
+		if (gRepoPool.nrHits + gRepoPool.nrMisses > 0)
+			SG_ERR_IGNORE(  SG_log_debug(pCtx, "Repo handle pool: %u hits, %u misses, %u discarded, %u busy.",
+										 (SG_uint32)gRepoPool.nrHits, (SG_uint32)gRepoPool.nrMisses,
+										 (SG_uint32)gRepoPool.nrDiscarded, (SG_uint32)gRepoPool.nrBusy)  );
+
+		SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, gRepoPool.prbBuckets, (SG_free_callback *)_repo_pool_bucket__free);
+		SG_mutex__destroy(&gRepoPool.lock);
+		memset(&gRepoPool, 0, sizeof(gRepoPool));
+	}
+
+	if (gResponseCache.bInitialized)
+	{
+		SG_RBTREE_NULLFREE_WITH_ASSOC(pCtx, gResponseCache.prbEntries, (SG_free_callback *)_response_cache_entry__free);
+		SG_mutex__destroy(&gResponseCache.lock);
+		memset(&gResponseCache, 0, sizeof(gResponseCache));
+	}
 }
 
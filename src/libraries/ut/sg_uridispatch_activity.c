@@ -25,114 +25,127 @@ limitations under the License.
 
 #define eq(str1,str2) (strcmp(str1,str2)==0)
 
-static void _addHistoryActivity(
+#define MY_ACTIVITY__MAX_ACTS	25
+
+static void _addHistoryResults(
     SG_context * pCtx,
-    _request_headers * pRequestHeaders,
-	SG_varray *acts,
-    SG_repo * pRepo)
+	const SG_varray * pVArrayResults,
+	SG_varray *acts)
 {
-    SG_varray * pVArrayResults = NULL;
-    SG_int64 nFromDate = 0;
-    SG_int64 nToDate = SG_INT64_MAX;
 	SG_vhash *act = NULL;
 	SG_string *what = NULL;
 	SG_string *who  = NULL;
 	SG_string *link = NULL;
 	SG_int64 lastwhen = 0;
-
+	SG_uint32 resultsLength = 0;
+	SG_uint32 i = 0;
+	SG_vhash * currentDagnode = NULL;
+	SG_varray * pVArray = NULL;
+	SG_vhash * pVHashCurrentThingy = NULL;
+	SG_uint32 nCount = 0;
+	SG_uint32 nIndex = 0;
+	SG_int64 when = 0;
+	const char * pszUser = NULL;
+	const char * pszComment = NULL;
+
+	SG_NULLARGCHECK_RETURN(pVArrayResults);
 	SG_NULLARGCHECK_RETURN(acts);
-	SG_NULLARGCHECK_RETURN(pRepo);
-
-	if (pRequestHeaders->ifModifiedSince > 0)
-		nFromDate = pRequestHeaders->ifModifiedSince;
 
-	SG_ERR_CHECK(  SG_history__query(pCtx, NULL, pRepo, 0, NULL, NULL, 0, NULL, NULL, 25, nFromDate, nToDate, SG_TRUE, SG_FALSE, &pVArrayResults)  );
+	SG_ERR_CHECK(  SG_varray__count(pCtx, pVArrayResults, &resultsLength)  );
 
-	// fall thru to common cleanup
-	if (pVArrayResults != NULL)
+	for (i = 0; i < resultsLength; i++)
 	{
-		SG_uint32 resultsLength = 0;
-		SG_uint32 i = 0;
-		SG_vhash * currentDagnode = NULL;
-		SG_varray * pVArray = NULL;
-		SG_vhash * pVHashCurrentThingy = NULL;
-		SG_uint32 nCount = 0;
-		SG_uint32 nIndex = 0;
-		SG_int64 when = 0;
-		const char * pszUser = NULL;
-		const char * pszComment = NULL;
-
-		SG_ERR_CHECK(  SG_varray__count(pCtx, pVArrayResults, &resultsLength)  );
-
-		for (i = 0; i < resultsLength; i++)
-		{
-			const char *csid = NULL;
+		const char *csid = NULL;
 
-			SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &act)  );
-			SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &what)  );
-			SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &who)  );
-			SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &link)  );
+		SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &act)  );
+		SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &what)  );
+		SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &who)  );
+		SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &link)  );
 
-			SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pVArrayResults, i, &currentDagnode)  );
+		SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pVArrayResults, i, &currentDagnode)  );
 
-			SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, currentDagnode, "changeset_id", &csid)  );
+		SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, currentDagnode, "changeset_id", &csid)  );
 
-			SG_ERR_CHECK(  SG_string__sprintf(pCtx, link, "/changesets/%s", csid)  );
+		SG_ERR_CHECK(  SG_string__sprintf(pCtx, link, "/changesets/%s", csid)  );
 
-			SG_ERR_CHECK(  SG_string__set__sz(pCtx, what, "checkin")  );
+		SG_ERR_CHECK(  SG_string__set__sz(pCtx, what, "checkin")  );
 
-			SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, currentDagnode, "audits", &pVArray)  );
-			SG_ERR_CHECK(  SG_varray__count(pCtx, pVArray, &nCount)  );
+		SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, currentDagnode, "audits", &pVArray)  );
+		SG_ERR_CHECK(  SG_varray__count(pCtx, pVArray, &nCount)  );
 
-			lastwhen = 0;
+		lastwhen = 0;
 
-			for (nIndex = 0; nIndex < nCount; nIndex++)
-			{
-				SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pVArray, nIndex, &pVHashCurrentThingy)  );
-				SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pVHashCurrentThingy, "when", &when)  );
-				SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pVHashCurrentThingy, "who", &pszUser)  );
+		for (nIndex = 0; nIndex < nCount; nIndex++)
+		{
+			SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pVArray, nIndex, &pVHashCurrentThingy)  );
+			SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pVHashCurrentThingy, "when", &when)  );
+			SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pVHashCurrentThingy, "who", &pszUser)  );
 
-				if (when > lastwhen)
-				{
-					lastwhen = when;
-					SG_ERR_CHECK(  SG_string__set__sz(pCtx, who, pszUser)  );
-				}
+			if (when > lastwhen)
+			{
+				lastwhen = when;
+				SG_ERR_CHECK(  SG_string__set__sz(pCtx, who, pszUser)  );
 			}
+		}
 
-			SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, currentDagnode, "comments", &pVArray)  );
-			SG_ERR_CHECK(  SG_varray__count(pCtx, pVArray, &nCount)  );
+		SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, currentDagnode, "comments", &pVArray)  );
+		SG_ERR_CHECK(  SG_varray__count(pCtx, pVArray, &nCount)  );
 
-			if (nCount > 0)
-			{
-				SG_vhash *vhcmt = NULL;
+		if (nCount > 0)
+		{
+			SG_vhash *vhcmt = NULL;
 
-				SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pVArray, nCount - 1, &vhcmt)  );
-				SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, vhcmt, "text", &pszComment)  );
-				SG_ERR_CHECK(  SG_string__append__sz(pCtx, what, ": ")  );
-				SG_ERR_CHECK(  SG_string__append__sz(pCtx, what, pszComment)  );
-			}
+			SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pVArray, nCount - 1, &vhcmt)  );
+			SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, vhcmt, "text", &pszComment)  );
+			SG_ERR_CHECK(  SG_string__append__sz(pCtx, what, ": ")  );
+			SG_ERR_CHECK(  SG_string__append__sz(pCtx, what, pszComment)  );
+		}
 
-			SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, act, "what", SG_string__sz(what))  );
-			SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, act, "who", SG_string__sz(who))  );
-			SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, act, "link", SG_string__sz(link))  );
-			SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, act, "when", lastwhen)  );
+		SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, act, "what", SG_string__sz(what))  );
+		SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, act, "who", SG_string__sz(who))  );
+		SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, act, "link", SG_string__sz(link))  );
+		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, act, "when", lastwhen)  );
 
-			SG_ERR_CHECK(  SG_varray__append__vhash(pCtx, acts, &act)  );
+		SG_ERR_CHECK(  SG_varray__append__vhash(pCtx, acts, &act)  );
 
-			SG_STRING_NULLFREE(pCtx, who);
-			SG_STRING_NULLFREE(pCtx, what);
-			SG_STRING_NULLFREE(pCtx, link);
-		}
+		SG_STRING_NULLFREE(pCtx, who);
+		SG_STRING_NULLFREE(pCtx, what);
+		SG_STRING_NULLFREE(pCtx, link);
 	}
 
 fail:
-	SG_VARRAY_NULLFREE(pCtx, pVArrayResults);
 	SG_VHASH_NULLFREE(pCtx, act);
 	SG_STRING_NULLFREE(pCtx, what);
 	SG_STRING_NULLFREE(pCtx, who);
 	SG_STRING_NULLFREE(pCtx, link);
 }
 
+static void _addHistoryActivity(
+    SG_context * pCtx,
+    _request_headers * pRequestHeaders,
+	SG_varray *acts,
+    SG_repo * pRepo)
+{
+    SG_varray * pVArrayResults = NULL;
+    SG_int64 nFromDate = 0;
+    SG_int64 nToDate = SG_INT64_MAX;
+
+	SG_NULLARGCHECK_RETURN(acts);
+	SG_NULLARGCHECK_RETURN(pRepo);
+
+	if (pRequestHeaders->ifModifiedSince > 0)
+		nFromDate = pRequestHeaders->ifModifiedSince;
+
+	SG_ERR_CHECK(  SG_history__query(pCtx, NULL, pRepo, 0, NULL, NULL, 0, NULL, NULL, MY_ACTIVITY__MAX_ACTS, nFromDate, nToDate, SG_TRUE, SG_FALSE, &pVArrayResults)  );
+
+	// fall thru to common cleanup
+	if (pVArrayResults != NULL)
+		SG_ERR_CHECK(  _addHistoryResults(pCtx, pVArrayResults, acts)  );
+
+fail:
+	SG_VARRAY_NULLFREE(pCtx, pVArrayResults);
+}
+
 static void get_wit_comment_links(
 	SG_context *pCtx,
     SG_repo * pRepo,
@@ -521,23 +534,18 @@ fail:
 	;
 }
 
-static void _collect_activity_stream(
+static void _collect_other_activity(
     SG_context * pCtx,
     _request_headers * pRequestHeaders,
-    SG_repo ** ppRepo, // On success we've taken ownership and nulled the caller's copy.
-	SG_varray **ppActs,
-	const char **status)
+    SG_repo * pRepo,
+	SG_varray **ppActs)
 {
     char * pBaseline = NULL;
-	SG_uint32 count = 0;
 	SG_varray *acts = NULL;
-	SG_bool	hasIms = SG_FALSE;
 	SG_string *pstr_where = NULL;
 	SG_stringarray *psa_fields = NULL;
-	SG_vhash *users = NULL;
-	struct _expandContext ctxt;
 
-    SG_ERR_CHECK(  SG_zing__get_leaf__fail_if_needs_merge(pCtx, *ppRepo, SG_DAGNUM__SUP, &pBaseline)  );
+    SG_ERR_CHECK(  SG_zing__get_leaf__fail_if_needs_merge(pCtx, pRepo, SG_DAGNUM__SUP, &pBaseline)  );
 
 	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr_where)  );
 
@@ -548,18 +556,77 @@ static void _collect_activity_stream(
     SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa_fields, "who")  );
     SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa_fields, "when")  );
     SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa_fields, "what")  );
-    SG_ERR_CHECK(  SG_zing__query(pCtx, *ppRepo, SG_DAGNUM__SUP, pBaseline, "item", SG_string__sz(pstr_where), "when #DESC", 0, 0, psa_fields, &acts)  );
+    SG_ERR_CHECK(  SG_zing__query(pCtx, pRepo, SG_DAGNUM__SUP, pBaseline, "item", SG_string__sz(pstr_where), "when #DESC", 0, 0, psa_fields, &acts)  );
 
 	if (acts == NULL)
 		SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &acts)  );
 
-	SG_ERR_CHECK(  _addHistoryActivity(pCtx, pRequestHeaders, acts, *ppRepo)  );
-	SG_ERR_CHECK(  _addWitActivity(pCtx, pRequestHeaders, acts, *ppRepo)  );
+	SG_ERR_CHECK(  _addWitActivity(pCtx, pRequestHeaders, acts, pRepo)  );
+
+ 	*ppActs = acts;
+	acts = NULL;
+
+fail:
+	SG_VARRAY_NULLFREE(pCtx, acts);
+	SG_STRINGARRAY_NULLFREE(pCtx, psa_fields);
+	SG_STRING_NULLFREE(pCtx, pstr_where);
+    SG_NULLFREE(pCtx, pBaseline);
+}
+
+/**
+ * Drop the acts without a time, turn user ids into email addresses,
+ * and keep only the most recent ones.  *pCount is the number of acts
+ * that had a time (before trimming to the most recent).
+ */
+static void _finish_activity_stream(
+	SG_context * pCtx,
+	SG_repo * pRepo,
+	SG_varray *acts,
+	SG_uint32 *pCount)
+{
+	SG_uint32 count = 0;
+	SG_vhash *users = NULL;
+	struct _expandContext ctxt;
 
 	SG_ERR_CHECK(  SG_varray__count(pCtx, acts, &count)  );
 
 	SG_ERR_CHECK(  _removeTimelessActs(pCtx, acts, &count)  );
 
+	*pCount = count;
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &users)  );
+	ctxt.pRepo = pRepo;
+	ctxt.users = users;
+	SG_ERR_CHECK(  SG_varray__foreach(pCtx, acts, _expandWho, &ctxt)  );
+
+	SG_ERR_CHECK(  SG_varray__sort(pCtx, acts, _revWhenSort)  );
+
+	while (count > MY_ACTIVITY__MAX_ACTS)
+	{
+		SG_ERR_CHECK(  SG_varray__remove(pCtx, acts, count - 1)  );
+		--count;
+	}
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, users);
+}
+
+static void _collect_activity_stream(
+    SG_context * pCtx,
+    _request_headers * pRequestHeaders,
+    SG_repo ** ppRepo, // On success we've taken ownership and nulled the caller's copy.
+	SG_varray **ppActs,
+	const char **status)
+{
+	SG_uint32 count = 0;
+	SG_varray *acts = NULL;
+	SG_bool	hasIms = SG_FALSE;
+
+	SG_ERR_CHECK(  _collect_other_activity(pCtx, pRequestHeaders, *ppRepo, &acts)  );
+	SG_ERR_CHECK(  _addHistoryActivity(pCtx, pRequestHeaders, acts, *ppRepo)  );
+
+	SG_ERR_CHECK(  _finish_activity_stream(pCtx, *ppRepo, acts, &count)  );
+
 	hasIms = (pRequestHeaders->ifModifiedSince > 0);
 
 	if (hasIms && (count == 0))
@@ -574,28 +641,409 @@ static void _collect_activity_stream(
 		*status = SG_HTTP_STATUS_OK;
 	}
 
-	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &users)  );
-	ctxt.pRepo = *ppRepo;
-	ctxt.users = users;
-	SG_ERR_CHECK(  SG_varray__foreach(pCtx, acts, _expandWho, &ctxt)  );
+ 	*ppActs = acts;
+	acts = NULL;
 
-	SG_ERR_CHECK(  SG_varray__sort(pCtx, acts, _revWhenSort)  );
+fail:
+	SG_VARRAY_NULLFREE(pCtx, acts);
+}
+
+//////////////////////////////////////////////////////////////////
+
+// Without an If-Modified-Since, the activity stream only depends on the
+// leaves of these dags.  We remember what we computed last time (in the
+// response cache, under "activity/<descriptor>") and when the leaves
+// move we only redo the parts that could have changed:
+//
+//     "leaves"  the state the rest of the entry was computed from
+//     "csids"   the changesets the history part is about, newest first
+//     "history" the acts for those changesets (user ids not yet expanded)
+//     "other"   the acts from the sup and work item dags (ditto)
+//
+// When version control only moved forward (the common case after a
+// commit or a push), the new changesets are the few nodes between the
+// new leaves and the old ones; we find them in the dag index and then
+// only ask history for the details of those plus the ones we already
+// had, rather than walking the dag again.  Asking for details again
+// also picks up new comments.
+
+static const SG_uint32 gaActivityDagNums[] =
+{
+	SG_DAGNUM__VERSION_CONTROL,
+	SG_DAGNUM__VC_COMMENTS,
+	SG_DAGNUM__USERS,
+	SG_DAGNUM__SUP,
+	SG_DAGNUM__WORK_ITEMS,
+};
+
+#define MY_ACTIVITY__MAX_WALK	(4 * MY_ACTIVITY__MAX_ACTS)
 
-	while (count > 25)
+/**
+ * Find the version control changesets that are ancestors of the new
+ * leaves but not of the old ones, newest (highest generation) first.
+ *
+ * *ppvaNew is set to NULL when we can't answer cheaply (there are more
+ * than a page of them, or the dag index doesn't know one of the leaves);
+ * the caller should start over.
+ */
+static void _activity__find_new_changesets(
+	SG_context * pCtx,
+	SG_repo * pRepo,
+	const SG_varray * pvaOldLeaves,
+	const SG_varray * pvaNewLeaves,
+	SG_varray ** ppvaNew)
+{
+	const SG_dagindex * pIndex = NULL;
+	SG_uint32 * paOld = NULL;
+	SG_uint32 countOld = 0;
+	SG_uint32 countNew = 0;
+	SG_uint32 aStack[MY_ACTIVITY__MAX_WALK];
+	SG_uint32 countStack = 0;
+	SG_uint32 aSeen[MY_ACTIVITY__MAX_WALK];
+	SG_uint32 countSeen = 0;
+	SG_uint32 aFound[MY_ACTIVITY__MAX_ACTS];
+	SG_int32 aFoundGen[MY_ACTIVITY__MAX_ACTS];
+	SG_uint32 countFound = 0;
+	SG_varray * pvaNew = NULL;
+	const char * pszHid = NULL;
+	SG_bool bFound = SG_FALSE;
+	SG_uint32 iNode = 0;
+	SG_uint32 k, j;
+
+	SG_NULLARGCHECK_RETURN(pvaOldLeaves);
+	SG_NULLARGCHECK_RETURN(pvaNewLeaves);
+	SG_NULLARGCHECK_RETURN(ppvaNew);
+
+	*ppvaNew = NULL;
+
+	SG_ERR_CHECK(  SG_varray__count(pCtx, pvaOldLeaves, &countOld)  );
+	SG_ERR_CHECK(  SG_varray__count(pCtx, pvaNewLeaves, &countNew)  );
+	if (countOld == 0 || countNew == 0 || countNew > MY_ACTIVITY__MAX_ACTS)
+		goto fail;
+
+	SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pvaNewLeaves, 0, &pszHid)  );
+	SG_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, SG_DAGNUM__VERSION_CONTROL, pszHid, &pIndex)  );
+
+	SG_ERR_CHECK(  SG_allocN(pCtx, countOld, paOld)  );
+	for (k=0; k<countOld; k++)
 	{
-		SG_ERR_CHECK(  SG_varray__remove(pCtx, acts, count - 1)  );
-		--count;
+		SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pvaOldLeaves, k, &pszHid)  );
+		SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHid, &bFound, &paOld[k])  );
+		if (!bFound)
+			goto fail;
+	}
+
+	for (k=0; k<countNew; k++)
+	{
+		SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pvaNewLeaves, k, &pszHid)  );
+		SG_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHid, &bFound, &iNode)  );
+		if (!bFound)
+			goto fail;
+
+		aSeen[countSeen++] = iNode;
+		aStack[countStack++] = iNode;
+	}
+
+	while (countStack > 0)
+	{
+		SG_bool bOld = SG_FALSE;
+		SG_int32 gen = 0;
+		SG_uint32 countParents = 0;
+		const SG_uint32 * paParents = NULL;
+
+		iNode = aStack[--countStack];
+
+		for (k=0; (k<countOld) && !bOld; k++)
+			SG_ERR_CHECK(  SG_dagindex__is_ancestor(pCtx, pIndex, iNode, paOld[k], &bOld)  );
+		if (bOld)
+			continue;
+
+		if (countFound == MY_ACTIVITY__MAX_ACTS)
+			goto fail;
+
+		// keep aFound sorted by generation, highest first.
+		SG_ERR_CHECK(  SG_dagindex__get_generation(pCtx, pIndex, iNode, &gen)  );
+		for (k=countFound; (k>0) && (aFoundGen[k-1] < gen); k--)
+		{
+			aFound[k] = aFound[k-1];
+			aFoundGen[k] = aFoundGen[k-1];
+		}
+		aFound[k] = iNode;
+		aFoundGen[k] = gen;
+		countFound++;
+
+		SG_ERR_CHECK(  SG_dagindex__get_parents(pCtx, pIndex, iNode, &countParents, &paParents)  );
+		for (k=0; k<countParents; k++)
+		{
+			SG_bool bSeen = SG_FALSE;
+
+			for (j=0; (j<countSeen) && !bSeen; j++)
+				bSeen = (aSeen[j] == paParents[k]);
+			if (bSeen)
+				continue;
+
+			if (countSeen == MY_ACTIVITY__MAX_WALK)
+				goto fail;
+
+			aSeen[countSeen++] = paParents[k];
+			aStack[countStack++] = paParents[k];
+		}
+	}
+
+	SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaNew)  );
+	for (k=0; k<countFound; k++)
+	{
+		SG_ERR_CHECK(  SG_dagindex__get_hid_ref(pCtx, pIndex, aFound[k], &pszHid)  );
+		SG_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaNew, pszHid)  );
 	}
 
+	*ppvaNew = pvaNew;
+	pvaNew = NULL;
+
+fail:
+	SG_VARRAY_NULLFREE(pCtx, pvaNew);
+	SG_NULLFREE(pCtx, paOld);
+}
+
+/**
+ * Compute the history part of the activity stream, reusing what we can
+ * from the previous cache entry (if any).
+ */
+static void _activity__compute_history(
+	SG_context * pCtx,
+	SG_repo * pRepo,
+	const SG_vhash * pvhEntryOld,
+	const SG_vhash * pvhLeaves,
+	SG_varray ** ppvaCsids,
+	SG_varray ** ppvaHistory)
+{
+	char bufDagNum[SG_DAGNUM__BUF_MAX__DEC];
+	SG_vhash * pvhLeavesOld = NULL;
+	SG_varray * pvaCsidsOld = NULL;
+	SG_varray * pvaHistoryOld = NULL;
+	SG_varray * pvaVcLeavesOld = NULL;
+	SG_varray * pvaVcLeaves = NULL;
+	SG_varray * pvaCsids = NULL;
+	SG_varray * pvaHistory = NULL;
+	SG_varray * pVArrayResults = NULL;
+	const char ** paszCsids = NULL;
+	SG_uint32 countCsids = 0;
+	SG_uint32 countCsidsOld = 0;
+	SG_uint32 k;
+
+	if (pvhEntryOld)
+	{
+		SG_bool bVcUnchanged = SG_FALSE;
+		SG_bool bCommentsUnchanged = SG_FALSE;
+
+		SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhEntryOld, "leaves", &pvhLeavesOld)  );
+		SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, pvhEntryOld, "csids", &pvaCsidsOld)  );
+		SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, pvhEntryOld, "history", &pvaHistoryOld)  );
+
+		SG_ERR_CHECK(  _repo_state__dag_unchanged(pCtx, pvhLeavesOld, pvhLeaves, SG_DAGNUM__VERSION_CONTROL, &bVcUnchanged)  );
+		SG_ERR_CHECK(  _repo_state__dag_unchanged(pCtx, pvhLeavesOld, pvhLeaves, SG_DAGNUM__VC_COMMENTS, &bCommentsUnchanged)  );
+
+		if (bVcUnchanged && bCommentsUnchanged)
+		{
+			SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaCsids)  );
+			SG_ERR_CHECK(  SG_varray__copy_items(pCtx, pvaCsidsOld, pvaCsids)  );
+			SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaHistory)  );
+			SG_ERR_CHECK(  SG_varray__copy_items(pCtx, pvaHistoryOld, pvaHistory)  );
+			goto done;
+		}
+
+		SG_ERR_CHECK(  SG_dagnum__to_sz__decimal(pCtx, SG_DAGNUM__VERSION_CONTROL, bufDagNum, sizeof(bufDagNum))  );
+		SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, pvhLeavesOld, bufDagNum, &pvaVcLeavesOld)  );
+		SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, pvhLeaves, bufDagNum, &pvaVcLeaves)  );
+
+		SG_ERR_CHECK(  _activity__find_new_changesets(pCtx, pRepo, pvaVcLeavesOld, pvaVcLeaves, &pvaCsids)  );
+		if (pvaCsids)
+		{
+			SG_ERR_CHECK(  SG_varray__count(pCtx, pvaCsids, &countCsids)  );
+			SG_ERR_CHECK(  SG_varray__count(pCtx, pvaCsidsOld, &countCsidsOld)  );
+			for (k=0; (k<countCsidsOld) && (countCsids<MY_ACTIVITY__MAX_ACTS); k++)
+			{
+				const char * pszCsid = NULL;
+
+				SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pvaCsidsOld, k, &pszCsid)  );
+				SG_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaCsids, pszCsid)  );
+				countCsids++;
+			}
+		}
+	}
+
+	if (pvaCsids)
+	{
+		if (countCsids > 0)
+		{
+			SG_ERR_CHECK(  SG_allocN(pCtx, countCsids, paszCsids)  );
+			for (k=0; k<countCsids; k++)
+				SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pvaCsids, k, &paszCsids[k])  );
+
+			SG_ERR_CHECK(  SG_history__query(pCtx, NULL, pRepo, 0, NULL, paszCsids, countCsids, NULL, NULL, MY_ACTIVITY__MAX_ACTS, 0, SG_INT64_MAX, SG_FALSE, SG_FALSE, &pVArrayResults)  );
+		}
+	}
+	else
+	{
+		SG_uint32 countResults = 0;
+
+		SG_ERR_CHECK(  SG_history__query(pCtx, NULL, pRepo, 0, NULL, NULL, 0, NULL, NULL, MY_ACTIVITY__MAX_ACTS, 0, SG_INT64_MAX, SG_TRUE, SG_FALSE, &pVArrayResults)  );
+
+		SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaCsids)  );
+		if (pVArrayResults)
+			SG_ERR_CHECK(  SG_varray__count(pCtx, pVArrayResults, &countResults)  );
+		for (k=0; k<countResults; k++)
+		{
+			SG_vhash * pvhResult = NULL;
+			const char * pszCsid = NULL;
+
+			SG_ERR_CHECK(  SG_varray__get__vhash(pCtx, pVArrayResults, k, &pvhResult)  );
+			SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvhResult, "changeset_id", &pszCsid)  );
+			SG_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaCsids, pszCsid)  );
+		}
+	}
+
+	SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaHistory)  );
+	if (pVArrayResults)
+		SG_ERR_CHECK(  _addHistoryResults(pCtx, pVArrayResults, pvaHistory)  );
+
+done:
+	*ppvaCsids = pvaCsids;
+	pvaCsids = NULL;
+	*ppvaHistory = pvaHistory;
+	pvaHistory = NULL;
+
+fail:
+	SG_VARRAY_NULLFREE(pCtx, pvaCsids);
+	SG_VARRAY_NULLFREE(pCtx, pvaHistory);
+	SG_VARRAY_NULLFREE(pCtx, pVArrayResults);
+	SG_NULLFREE(pCtx, paszCsids);
+}
+
+static void _collect_activity_stream__cached(
+    SG_context * pCtx,
+    _request_headers * pRequestHeaders,
+    SG_repo * pRepo,
+	const SG_vhash * pvhLeaves,
+	SG_varray **ppActs)
+{
+	const char * pszDescriptorName = NULL;
+	SG_string * pstrKey = NULL;
+	SG_vhash * pvhEntryOld = NULL;
+	SG_vhash * pvhEntry = NULL;
+	SG_vhash * pvhLeavesCopy = NULL;
+	SG_varray * pvaCsids = NULL;
+	SG_varray * pvaHistory = NULL;
+	SG_varray * pvaOther = NULL;
+	SG_varray * acts = NULL;
+	SG_uint32 count = 0;
+
+	SG_ERR_CHECK(  SG_repo__get_descriptor_name(pCtx, pRepo, &pszDescriptorName)  );
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrKey)  );
+	SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstrKey, "activity/%s", pszDescriptorName)  );
+
+	SG_ERR_CHECK(  _response_cache__get(pCtx, SG_string__sz(pstrKey), &pvhEntryOld)  );
+
+	SG_ERR_CHECK(  _activity__compute_history(pCtx, pRepo, pvhEntryOld, pvhLeaves, &pvaCsids, &pvaHistory)  );
+
+	if (pvhEntryOld)
+	{
+		SG_vhash * pvhLeavesOld = NULL;
+		SG_bool bSupUnchanged = SG_FALSE;
+		SG_bool bWitUnchanged = SG_FALSE;
+
+		SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhEntryOld, "leaves", &pvhLeavesOld)  );
+		SG_ERR_CHECK(  _repo_state__dag_unchanged(pCtx, pvhLeavesOld, pvhLeaves, SG_DAGNUM__SUP, &bSupUnchanged)  );
+		SG_ERR_CHECK(  _repo_state__dag_unchanged(pCtx, pvhLeavesOld, pvhLeaves, SG_DAGNUM__WORK_ITEMS, &bWitUnchanged)  );
+
+		if (bSupUnchanged && bWitUnchanged)
+		{
+			SG_varray * pvaOtherOld = NULL;
+
+			SG_ERR_CHECK(  SG_vhash__get__varray(pCtx, pvhEntryOld, "other", &pvaOtherOld)  );
+			SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaOther)  );
+			SG_ERR_CHECK(  SG_varray__copy_items(pCtx, pvaOtherOld, pvaOther)  );
+		}
+	}
+	if (!pvaOther)
+		SG_ERR_CHECK(  _collect_other_activity(pCtx, pRequestHeaders, pRepo, &pvaOther)  );
+
+	// _finish_activity_stream rewrites the acts, so it gets copies.
+	SG_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &acts)  );
+	SG_ERR_CHECK(  SG_varray__copy_items(pCtx, pvaHistory, acts)  );
+	SG_ERR_CHECK(  SG_varray__copy_items(pCtx, pvaOther, acts)  );
+	SG_ERR_CHECK(  _finish_activity_stream(pCtx, pRepo, acts, &count)  );
+
+	SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhEntry)  );
+	SG_ERR_CHECK(  SG_VHASH__ALLOC__COPY(pCtx, &pvhLeavesCopy, pvhLeaves)  );
+	SG_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pvhEntry, "leaves", &pvhLeavesCopy)  );
+	SG_ERR_CHECK(  SG_vhash__add__varray(pCtx, pvhEntry, "csids", &pvaCsids)  );
+	SG_ERR_CHECK(  SG_vhash__add__varray(pCtx, pvhEntry, "history", &pvaHistory)  );
+	SG_ERR_CHECK(  SG_vhash__add__varray(pCtx, pvhEntry, "other", &pvaOther)  );
+	SG_ERR_CHECK(  _response_cache__put(pCtx, SG_string__sz(pstrKey), &pvhEntry)  );
+
  	*ppActs = acts;
 	acts = NULL;
 
 fail:
+	SG_STRING_NULLFREE(pCtx, pstrKey);
+	SG_VHASH_NULLFREE(pCtx, pvhEntryOld);
+	SG_VHASH_NULLFREE(pCtx, pvhEntry);
+	SG_VHASH_NULLFREE(pCtx, pvhLeavesCopy);
+	SG_VARRAY_NULLFREE(pCtx, pvaCsids);
+	SG_VARRAY_NULLFREE(pCtx, pvaHistory);
+	SG_VARRAY_NULLFREE(pCtx, pvaOther);
 	SG_VARRAY_NULLFREE(pCtx, acts);
-	SG_STRINGARRAY_NULLFREE(pCtx, psa_fields);
-	SG_STRING_NULLFREE(pCtx, pstr_where);
-	SG_VHASH_NULLFREE(pCtx, users);
-    SG_NULLFREE(pCtx, pBaseline);
+}
+
+/**
+ * Get the acts for an activity stream response.
+ *
+ * Without an If-Modified-Since, the response also gets an ETag (derived
+ * from pszVariant and the state of the repo) and if the client already
+ * has that ETag, *ppActs is set to NULL and the caller should just send
+ * a 304.
+ */
+static void _begin_activity_stream(
+    SG_context * pCtx,
+    _request_headers * pRequestHeaders,
+    SG_repo ** ppRepo,
+	const char * pszVariant,
+	SG_varray **ppActs,
+	const char **status,
+	char ** ppszETag)
+{
+	SG_vhash * pvhLeaves = NULL;
+	char * pszETag = NULL;
+
+	*ppActs = NULL;
+	*ppszETag = NULL;
+
+	if (pRequestHeaders->ifModifiedSince > 0)
+	{
+		SG_ERR_CHECK(  _collect_activity_stream(pCtx, pRequestHeaders, ppRepo, ppActs, status)  );
+		goto fail;
+	}
+
+	SG_ERR_CHECK(  _repo_state__get_leaves(pCtx, *ppRepo, gaActivityDagNums, SG_NrElements(gaActivityDagNums), &pvhLeaves)  );
+	SG_ERR_CHECK(  _repo_state__compute_etag(pCtx, *ppRepo, pvhLeaves, pszVariant, &pszETag)  );
+
+	if (_request_headers__if_none_match(pRequestHeaders, pszETag))
+	{
+		*status = SG_HTTP_STATUS_NOT_MODIFIED;
+	}
+	else
+	{
+		SG_ERR_CHECK(  _collect_activity_stream__cached(pCtx, pRequestHeaders, *ppRepo, pvhLeaves, ppActs)  );
+		*status = SG_HTTP_STATUS_OK;
+	}
+
+	*ppszETag = pszETag;
+	pszETag = NULL;
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvhLeaves);
+	SG_NULLFREE(pCtx, pszETag);
 }
 
 static void _atom_time__format_utc__i64(SG_context* pCtx, SG_int64 iTime,
@@ -684,11 +1132,22 @@ static void _get_activity_stream_atom(
 	SG_int64	lastmod;
 	char	lastmodstr[SG_MAX_RFC850_LENGTH + 1];
 	SG_int64	maxmod = 0;
+	SG_string *variant = NULL;
+	char *etag = NULL;
 
 	SG_NULL_PP_CHECK_RETURN(ppRepo);
 
 	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &idstr)  );
-	SG_ERR_CHECK(  _collect_activity_stream(pCtx, pRequestHeaders, ppRepo, &acts, &status)  );
+
+	// the feed has absolute links, so it depends on how we were asked.
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &variant)  );
+	SG_ERR_CHECK(  SG_string__sprintf(pCtx, variant, "atom http%s://%s", pRequestHeaders->isSsl ? "s" : "", pRequestHeaders->pHost ? pRequestHeaders->pHost : "")  );
+	SG_ERR_CHECK(  _begin_activity_stream(pCtx, pRequestHeaders, ppRepo, SG_string__sz(variant), &acts, &status, &etag)  );
+	if (acts == NULL)
+	{
+		SG_ERR_CHECK(  _create_response_handle_for_not_modified(pCtx, etag, ppResponseHandle)  );
+		goto fail;
+	}
 
 	SG_ERR_CHECK(  SG_varray__count(pCtx, acts, &count)  );
 
@@ -805,6 +1264,8 @@ static void _get_activity_stream_atom(
 		SG_ERR_CHECK(  SG_xmlwriter__write_end_document(pCtx, w)  );
 
 		SG_ERR_CHECK(  _create_response_handle_for_string(pCtx, status, SG_contenttype__xml, &xmlstr, ppResponseHandle)  );
+		if (etag)
+			SG_ERR_CHECK(  _response_handle__add_etag(pCtx, *ppResponseHandle, etag)  );
 
 		if (maxwhen > 0)
 			lastmod = maxwhen;
@@ -819,11 +1280,13 @@ static void _get_activity_stream_atom(
 fail:
 	SG_VARRAY_NULLFREE(pCtx, acts);
 	SG_STRING_NULLFREE(pCtx, idstr);
-	SG_REPO_NULLFREE(pCtx, *ppRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 	SG_VARRAY_NULLFREE(pCtx, acts);
 	SG_STRING_NULLFREE(pCtx, xmlstr);
 	SG_STRING_NULLFREE(pCtx, linkstr);
 	SG_XMLWRITER_NULLFREE(pCtx, w);
+	SG_STRING_NULLFREE(pCtx, variant);
+	SG_NULLFREE(pCtx, etag);
 }
 
 static void _get_activity_stream_json(
@@ -837,8 +1300,14 @@ static void _get_activity_stream_json(
 	const char *status = NULL;
 	SG_uint32 count = 0;
 	SG_bool hasIms = SG_FALSE;
+	char *etag = NULL;
 
-	SG_ERR_CHECK(  _collect_activity_stream(pCtx, pRequestHeaders, ppRepo, &acts, &status)  );
+	SG_ERR_CHECK(  _begin_activity_stream(pCtx, pRequestHeaders, ppRepo, "json", &acts, &status, &etag)  );
+	if (acts == NULL)
+	{
+		SG_ERR_CHECK(  _create_response_handle_for_not_modified(pCtx, etag, ppResponseHandle)  );
+		goto fail;
+	}
 
 	SG_ERR_CHECK(  SG_varray__count(pCtx, acts, &count)  );
 	hasIms = (pRequestHeaders->ifModifiedSince > 0);
@@ -848,7 +1317,8 @@ static void _get_activity_stream_json(
 	SG_VARRAY_NULLFREE(pCtx, acts);
 
 	SG_ERR_CHECK(  _create_response_handle_for_string(pCtx, status, SG_contenttype__json, &actsJSON, ppResponseHandle)  );
-
+	if (etag)
+		SG_ERR_CHECK(  _response_handle__add_etag(pCtx, *ppResponseHandle, etag)  );
 
 	if ((count > 0) || ! hasIms)
 	{
@@ -864,7 +1334,8 @@ static void _get_activity_stream_json(
 fail:
 	SG_VARRAY_NULLFREE(pCtx, acts);
 	SG_STRING_NULLFREE(pCtx, actsJSON);
-	SG_REPO_NULLFREE(pCtx, *ppRepo);
+	SG_NULLFREE(pCtx, etag);
+	_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 }
 
 void _dispatch__activity_stream(
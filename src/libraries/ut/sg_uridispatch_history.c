@@ -29,22 +29,81 @@ limitations under the License.
 
 //////////////////////////////////////////////////////////////////
 
-static void _GET__history_json(SG_context * pCtx, SG_repo* pRepo, SG_uint32 numRecords, const char* pszUser, const char* pszStamp, SG_int64 dateFrom, SG_int64 dateTo,
+// A page of history only depends on the query string and the leaves of
+// these dags (comments, stamps, tags and user names are all part of it).
+static const SG_uint32 gaHistoryDagNums[] =
+{
+	SG_DAGNUM__VERSION_CONTROL,
+	SG_DAGNUM__VC_COMMENTS,
+	SG_DAGNUM__VC_STAMPS,
+	SG_DAGNUM__VC_TAGS,
+	SG_DAGNUM__USERS,
+};
+
+static void _GET__history_json(SG_context * pCtx, const _request_headers * pRequestHeaders, SG_repo* pRepo, SG_uint32 numRecords, const char* pszUser, const char* pszStamp, SG_int64 dateFrom, SG_int64 dateTo,
     _response_handle ** ppResponseHandle)
 {
 	SG_string *content = NULL;
 	SG_varray* pvaResults = NULL;
+	SG_vhash* pvhLeaves = NULL;
+	SG_vhash* pvhLeavesCached = NULL;
+	SG_vhash* pvhEntry = NULL;
+	SG_string* pstrKey = NULL;
+	char* pszETag = NULL;
+	const char* pszDescriptorName = NULL;
+	const char* pszQueryString = pRequestHeaders->pQueryString ? pRequestHeaders->pQueryString : "";
+	SG_bool bCurrent = SG_FALSE;
+
+	SG_ERR_CHECK(  _repo_state__get_leaves(pCtx, pRepo, gaHistoryDagNums, SG_NrElements(gaHistoryDagNums), &pvhLeaves)  );
+	SG_ERR_CHECK(  _repo_state__compute_etag(pCtx, pRepo, pvhLeaves, pszQueryString, &pszETag)  );
+
+	if (_request_headers__if_none_match(pRequestHeaders, pszETag))
+	{
+		SG_ERR_CHECK(  _create_response_handle_for_not_modified(pCtx, pszETag, ppResponseHandle)  );
+		goto fail;
+	}
 
-	SG_ERR_CHECK(  SG_history__query(pCtx, NULL, pRepo, 0, NULL, NULL, 0, pszUser, pszStamp, numRecords, dateFrom, dateTo, SG_TRUE, SG_FALSE, &pvaResults)  );
+	SG_ERR_CHECK(  SG_repo__get_descriptor_name(pCtx, pRepo, &pszDescriptorName)  );
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrKey)  );
+	SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstrKey, "history/%s?%s", pszDescriptorName, pszQueryString)  );
+
+	SG_ERR_CHECK(  _response_cache__get(pCtx, SG_string__sz(pstrKey), &pvhEntry)  );
+	if (pvhEntry)
+	{
+		SG_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhEntry, "leaves", &pvhLeavesCached)  );
+		SG_ERR_CHECK(  SG_vhash__equal(pCtx, pvhLeavesCached, pvhLeaves, &bCurrent)  );
+	}
 
 	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &content)  );
-	SG_ERR_CHECK(  SG_varray__to_json(pCtx, pvaResults, content)  );
+	if (bCurrent)
+	{
+		const char* pszBody = NULL;
+
+		SG_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvhEntry, "body", &pszBody)  );
+		SG_ERR_CHECK(  SG_string__set__sz(pCtx, content, pszBody)  );
+	}
+	else
+	{
+		SG_ERR_CHECK(  SG_history__query(pCtx, NULL, pRepo, 0, NULL, NULL, 0, pszUser, pszStamp, numRecords, dateFrom, dateTo, SG_TRUE, SG_FALSE, &pvaResults)  );
+		SG_ERR_CHECK(  SG_varray__to_json(pCtx, pvaResults, content)  );
+
+		SG_VHASH_NULLFREE(pCtx, pvhEntry);
+		SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhEntry)  );
+		SG_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvhEntry, "body", SG_string__sz(content))  );
+		SG_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pvhEntry, "leaves", &pvhLeaves)  );
+		SG_ERR_CHECK(  _response_cache__put(pCtx, SG_string__sz(pstrKey), &pvhEntry)  );
+	}
 
-	_create_response_handle_for_string(pCtx, SG_HTTP_STATUS_OK, SG_contenttype__json, &content, ppResponseHandle);
+	SG_ERR_CHECK(  _create_response_handle_for_string(pCtx, SG_HTTP_STATUS_OK, SG_contenttype__json, &content, ppResponseHandle)  );
+	SG_ERR_CHECK(  _response_handle__add_etag(pCtx, *ppResponseHandle, pszETag)  );
 
 fail:
 	SG_VARRAY_NULLFREE(pCtx, pvaResults);
-	SG_NULLFREE(pCtx, content);
+	SG_STRING_NULLFREE(pCtx, content);
+	SG_VHASH_NULLFREE(pCtx, pvhLeaves);
+	SG_VHASH_NULLFREE(pCtx, pvhEntry);
+	SG_STRING_NULLFREE(pCtx, pstrKey);
+	SG_NULLFREE(pCtx, pszETag);
 }
 
 static void _history_replacer(
@@ -70,16 +129,17 @@ typedef struct
 	SG_repo* pRepo;
 } _dispatch_history_multiple_request_body_state;
 
-static void _dispatch_history_multiple_request_body_state__free(SG_context* pCtx, _dispatch_history_multiple_request_body_state* pState)
+static void _dispatch_history_multiple_request_body_state__free(SG_context* pCtx, _dispatch_history_multiple_request_body_state* pState, SG_bool bFailed)
 {
 	if (pState)
 	{
 		SG_STRING_NULLFREE(pCtx, pState->pstrRequestBody);
-		SG_REPO_NULLFREE(pCtx, pState->pRepo);
+		_repo_pool__nullrelease(pCtx, &pState->pRepo, bFailed);
 		SG_NULLFREE(pCtx, pState);
 	}
 }
-#define _DISPATCH_HISTORY_MULTIPLE_REQUEST_BODY_STATE__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _dispatch_history_multiple_request_body_state__free(pCtx,p); SG_context__pop_level(pCtx); p=NULL;)
+#define _DISPATCH_HISTORY_MULTIPLE_REQUEST_BODY_STATE__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _dispatch_history_multiple_request_body_state__free(pCtx,p,_bFailed); SG_context__pop_level(pCtx); p=NULL;)
+#define _DISPATCH_HISTORY_MULTIPLE_REQUEST_BODY_STATE__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _dispatch_history_multiple_request_body_state__free(pCtx,p,SG_TRUE); SG_context__pop_level(pCtx); p=NULL;)
 
 static void _dispatch__history__multiple__request_body__chunk(SG_context* pCtx,
 	_response_handle** ppResponseHandle,
@@ -97,7 +157,7 @@ static void _dispatch__history__multiple__request_body__chunk(SG_context* pCtx,
 static void _dispatch__history__multiple__request_body__aborted(SG_context* pCtx, void *pVoidState)
 {
 	_dispatch_history_multiple_request_body_state* pState = (_dispatch_history_multiple_request_body_state*)pVoidState;
-	_DISPATCH_HISTORY_MULTIPLE_REQUEST_BODY_STATE__NULLFREE(pCtx, pState);
+	_DISPATCH_HISTORY_MULTIPLE_REQUEST_BODY_STATE__NULLDISCARD(pCtx, pState);
 }
 
 static void _dispatch__history__multiple__request_body__finish(SG_context* pCtx,
@@ -243,7 +303,7 @@ void _dispatch__history(SG_context * pCtx,
 					}
 
 				}
-                SG_ERR_CHECK(  _GET__history_json(pCtx, *ppRepo, maxResults, pszUser, pszStamp, nDateFrom, nDateTo, ppResponseHandle)  );
+                SG_ERR_CHECK(  _GET__history_json(pCtx, pRequestHeaders, *ppRepo, maxResults, pszUser, pszStamp, nDateFrom, nDateTo, ppResponseHandle)  );
 			}
             else
                 SG_ERR_CHECK_RETURN(  _create_response_handle_for_template(pCtx, pRequestHeaders, SG_HTTP_STATUS_OK, "history.xhtml", _history_replacer, ppResponseHandle)  );
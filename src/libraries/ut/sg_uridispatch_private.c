@@ -588,16 +588,18 @@ fail:
 
     static void _generic_blob_response__context__free(
         SG_context * pCtx,
-        _generic_blob_response__context * p)
+        _generic_blob_response__context * p,
+        SG_bool bFailed)
     {
         if(p==NULL)
             return;
         if(p->pFetchBlobHandle!=NULL)
             SG_ERR_IGNORE(  SG_repo__fetch_blob__abort(pCtx, p->pRepo, &p->pFetchBlobHandle)  );
-        SG_REPO_NULLFREE(pCtx,p->pRepo);
+        _repo_pool__nullrelease(pCtx, &p->pRepo, bFailed);
         SG_NULLFREE(pCtx,p);
     }
-#define _GENERIC_BLOB_RESPONSE__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _generic_blob_response__context__free(pCtx,p); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _GENERIC_BLOB_RESPONSE__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _generic_blob_response__context__free(pCtx,p,_bFailed); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _GENERIC_BLOB_RESPONSE__CONTEXT__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _generic_blob_response__context__free(pCtx,p,SG_TRUE); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
 
     static void _generic_blob_response__chunk(SG_context * pCtx, SG_uint64 processedLength, SG_byte * pBuffer, SG_uint32 bufferLength, void * pContext__voidp)
     {
@@ -642,7 +644,7 @@ fail:
     static void _generic_blob_response__aborted(SG_context * pCtx, void * pContext)
     {
         SG_ASSERT(pCtx!=NULL);
-        _GENERIC_BLOB_RESPONSE__CONTEXT__NULLFREE(pCtx, pContext);
+        _GENERIC_BLOB_RESPONSE__CONTEXT__NULLDISCARD(pCtx, pContext);
     }
 
 void _create_response_handle_for_blob(
@@ -795,6 +797,95 @@ fail:
 	_GENERIC_FILE_RESPONSE__CONTEXT__NULLFREE(pCtx, pResponseCtx);
 }
 
+// -- _create_response_handle_for_fragball_stream -- //
+
+typedef struct
+{
+	SG_repo* pRepo;
+	SG_fragball_stream* pFragballStream; // reads blobs from pRepo, so it goes first
+} _fragball_stream_response_context;
+
+static void _fragball_stream_response__context__free(SG_context* pCtx, _fragball_stream_response_context* pState, SG_bool bFailed)
+{
+	if (pState)
+	{
+		SG_FRAGBALL_STREAM_NULLFREE(pCtx, pState->pFragballStream);
+		_repo_pool__nullrelease(pCtx, &pState->pRepo, bFailed);
+		SG_NULLFREE(pCtx, pState);
+	}
+}
+#define _FRAGBALL_STREAM_RESPONSE__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _fragball_stream_response__context__free(pCtx,p,_bFailed); SG_context__pop_level(pCtx); p=NULL;)
+#define _FRAGBALL_STREAM_RESPONSE__CONTEXT__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _fragball_stream_response__context__free(pCtx,p,SG_TRUE); SG_context__pop_level(pCtx); p=NULL;)
+
+static void _fragball_stream_response__chunk(SG_context * pCtx, SG_uint64 processedLength, SG_byte * pBuffer, SG_uint32 bufferLength, void * pContext)
+{
+	_fragball_stream_response_context* pState = (_fragball_stream_response_context*)pContext;
+
+	SG_uint32 total_length_got = 0;
+	SG_uint32 length_got = 0;
+	SG_bool b_done = SG_FALSE;
+
+	SG_UNUSED(processedLength);
+
+	while (!b_done && (total_length_got<bufferLength))
+	{
+		SG_ERR_CHECK_RETURN(  SG_fragball_stream__read(pCtx, pState->pFragballStream, bufferLength-total_length_got, pBuffer+total_length_got, &length_got, &b_done)  );
+		total_length_got+=length_got;
+	}
+
+	if (total_length_got<bufferLength)
+		SG_ERR_THROW_RETURN(SG_ERR_INCOMPLETEREAD);
+}
+
+static void _fragball_stream_response__finished(SG_context * pCtx, void * pContext)
+{
+	_fragball_stream_response_context* pState = pContext;
+
+	_FRAGBALL_STREAM_RESPONSE__CONTEXT__NULLFREE(pCtx, pState);
+}
+
+static void _fragball_stream_response__aborted(SG_context * pCtx, void * pContext)
+{
+	_fragball_stream_response_context* pState = pContext;
+
+	_FRAGBALL_STREAM_RESPONSE__CONTEXT__NULLDISCARD(pCtx, pState);
+}
+
+void _create_response_handle_for_fragball_stream(
+	SG_context * pCtx,
+	const char * pHttpStatusCode,
+	SG_repo ** ppRepo, // On success we've taken ownership and nulled the caller's copy.
+	SG_fragball_stream** ppFragballStream, // On success we've taken ownership and nulled the caller's copy.
+	_response_handle ** ppResponseHandle)
+{
+	SG_uint64 length = 0;
+	_fragball_stream_response_context* pResponseCtx = NULL;
+
+	SG_NONEMPTYCHECK_RETURN(pHttpStatusCode);
+	SG_NULL_PP_CHECK_RETURN(ppRepo);
+	SG_NULL_PP_CHECK_RETURN(ppFragballStream);
+	SG_NULLARGCHECK_RETURN(ppResponseHandle);
+	SG_ASSERT(*ppResponseHandle==NULL);
+
+	SG_ERR_CHECK_RETURN(  SG_fragball_stream__get_length(pCtx, *ppFragballStream, &length)  );
+
+	SG_ERR_CHECK_RETURN(  SG_alloc1(pCtx, pResponseCtx)  );
+
+	SG_ERR_CHECK(  _response_handle__alloc(pCtx, ppResponseHandle,
+		pHttpStatusCode, _response_header_for(SG_contenttype__fragball), length,
+		_fragball_stream_response__chunk, _fragball_stream_response__finished, _fragball_stream_response__aborted,
+		pResponseCtx)  );
+
+	pResponseCtx->pRepo = *ppRepo;
+	*ppRepo = NULL;
+	pResponseCtx->pFragballStream = *ppFragballStream;
+	*ppFragballStream = NULL;
+
+	return;
+fail:
+	SG_NULLFREE(pCtx, pResponseCtx);
+}
+
 _response_handle * _create_response_handle_for_error(SG_context * pCtx)
 {
     SG_string * pString = NULL;
@@ -840,6 +931,8 @@ _response_handle * _create_response_handle_for_error(SG_context * pCtx)
             pHttpStatusCode = "500 Internal Server Error";
         else if(SG_context__err_equals(pCtx,SG_ERR_URI_POSTDATA_MISSING))
             pHttpStatusCode = "400 Bad Request";
+        else if(SG_context__err_equals(pCtx,SG_ERR_REPO_BUSY))
+            pHttpStatusCode = "503 Service Unavailable";
 
         SG_context__push_level(pCtx);
         {
@@ -1055,16 +1148,18 @@ static void _dispatch__tests(
 
     static void _uri__changeset_specific_POST__context__free(
         SG_context * pCtx,
-        _uri__changeset_specific_POST__context * p)
+        _uri__changeset_specific_POST__context * p,
+        SG_bool bFailed)
     {
         if(p==NULL)
             return;
-        SG_REPO_NULLFREE(pCtx,p->pRepo);
+        _repo_pool__nullrelease(pCtx, &p->pRepo, bFailed);
         SG_NULLFREE(pCtx, p->pChangesetHid);
         SG_STRING_NULLFREE(pCtx, p->pRequestBody);
         SG_NULLFREE(pCtx,p);
     }
-#define _URI__CHANGESET_SPECIFIC_POST__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__changeset_specific_POST__context__free(pCtx,p); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__CHANGESET_SPECIFIC_POST__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _uri__changeset_specific_POST__context__free(pCtx,p,_bFailed); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__CHANGESET_SPECIFIC_POST__CONTEXT__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__changeset_specific_POST__context__free(pCtx,p,SG_TRUE); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
 
     static void _uri__changeset_specific_POST__chunk(SG_context * pCtx, _response_handle ** ppResponseHandle, SG_byte * pBuffer, SG_uint32 bufferLength, void * pContext__voidp)
     {
@@ -1184,7 +1279,7 @@ static void _dispatch__tests(
     }
     static void _uri__changeset_specific_POST__abort(SG_context * pCtx, void * pContext)
     {
-        _URI__CHANGESET_SPECIFIC_POST__CONTEXT__NULLFREE(pCtx, pContext);
+        _URI__CHANGESET_SPECIFIC_POST__CONTEXT__NULLDISCARD(pCtx, pContext);
     }
 
 	static void _POST__changeset_specific( SG_context * pCtx,
@@ -2029,12 +2124,14 @@ static void _fetch_blob_to_zip_file(SG_context* pCtx, SG_repo* pRepo, const char
 	while (!b_done)
 	{
 		SG_uint32 want = SG_STREAMING_BUFFER_SIZE;
+		const SG_byte* p_span = NULL;
+
 		if (want > left)
 		{
 			want = (SG_uint32) left;
 		}
-		SG_ERR_CHECK(  SG_repo__fetch_blob__chunk(pCtx, pRepo, pbh, want, p_buf, &got, &b_done)  );
-		SG_ERR_CHECK(  SG_zip__write(pCtx, *pzip, p_buf, got)  );
+		SG_ERR_CHECK(  SG_repo__fetch_blob__chunk__span(pCtx, pRepo, pbh, want, p_buf, &p_span, &got, &b_done)  );
+		SG_ERR_CHECK(  SG_zip__write(pCtx, *pzip, p_span, got)  );
 		left -= got;
 	}
 	SG_ERR_CHECK(  SG_repo__fetch_blob__end(pCtx, pRepo, &pbh)  );
@@ -2503,7 +2600,7 @@ static void _dispatch__repo_specific_wit(
 		_isRecRequest(pCtx, *ppRepo, SG_DAGNUM__WORK_ITEMS, ppUriSubstrings, uriSubstringsCount)
 		)
 	{
-        SG_REPO_NULLFREE(pCtx, *ppRepo);
+        _REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 		SG_ERR_CHECK_RETURN(  _create_response_handle_for_template(pCtx, pRequestHeaders, SG_HTTP_STATUS_OK, "listwi.xhtml", _new_wit_replacer, ppResponseHandle)  );
 	}
 	else
@@ -2575,15 +2672,17 @@ fail:
 
     static void _uri__zing_record_POST__context__free(
         SG_context * pCtx,
-        _uri__zing_record_POST__context * p)
+        _uri__zing_record_POST__context * p,
+        SG_bool bFailed)
     {
         if(p==NULL)
             return;
-        SG_REPO_NULLFREE(pCtx,p->pRepo);
+        _repo_pool__nullrelease(pCtx, &p->pRepo, bFailed);
         SG_STRING_NULLFREE(pCtx, p->pRequestBody);
         SG_NULLFREE(pCtx,p);
     }
-#define _URI__ZING_RECORD_POST__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_record_POST__context__free(pCtx,p); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__ZING_RECORD_POST__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _uri__zing_record_POST__context__free(pCtx,p,_bFailed); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__ZING_RECORD_POST__CONTEXT__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_record_POST__context__free(pCtx,p,SG_TRUE); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
 
     static void _uri__zing_record_POST__chunk(SG_context * pCtx, _response_handle ** ppResponseHandle, SG_byte * pBuffer, SG_uint32 bufferLength, void * pContext__voidp)
     {
@@ -2705,7 +2804,7 @@ fail:
 
     static void _uri__zing_record_POST__aborted(SG_context * pCtx, void * pContext)
     {
-        _URI__ZING_RECORD_POST__CONTEXT__NULLFREE(pCtx, pContext);
+        _URI__ZING_RECORD_POST__CONTEXT__NULLDISCARD(pCtx, pContext);
     }
 
 static void _POST__zing_record(
@@ -2780,7 +2879,7 @@ static void _DELETE__zing_record_specific(
     SG_ERR_CHECK(  SG_zingtx__delete_record(pCtx, pZingTx, pRecId)  );
 
     SG_ERR_CHECK(  SG_zing__commit_tx(pCtx, audit.when_int64, &pZingTx, &pChangeset, &pDagnode, NULL)  );
-    SG_REPO_NULLFREE(pCtx, *ppRepo);
+    _REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 
     SG_CHANGESET_NULLFREE(pCtx, pChangeset);
     SG_DAGNODE_NULLFREE(pCtx, pDagnode);
@@ -2836,15 +2935,17 @@ fail:
 
     static void _uri__zing_record_specific_PUT__context__free(
         SG_context * pCtx,
-        _uri__zing_record_specific_PUT__context * p)
+        _uri__zing_record_specific_PUT__context * p,
+        SG_bool bFailed)
     {
         if(p==NULL)
             return;
-        SG_REPO_NULLFREE(pCtx,p->pRepo);
+        _repo_pool__nullrelease(pCtx, &p->pRepo, bFailed);
         SG_STRING_NULLFREE(pCtx, p->pRequestBody);
         SG_NULLFREE(pCtx,p);
     }
-#define _URI__ZING_RECORD_SPECIFIC_PUT__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_record_specific_PUT__context__free(pCtx,p); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__ZING_RECORD_SPECIFIC_PUT__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _uri__zing_record_specific_PUT__context__free(pCtx,p,_bFailed); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__ZING_RECORD_SPECIFIC_PUT__CONTEXT__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_record_specific_PUT__context__free(pCtx,p,SG_TRUE); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
 
     static void _uri__zing_record_specific_PUT__chunk(SG_context * pCtx, _response_handle ** ppResponseHandle, SG_byte * pBuffer, SG_uint32 bufferLength, void * pContext__voidp)
     {
@@ -2940,7 +3041,7 @@ fail:
 
     static void _uri__zing_record_specific_PUT__aborted(SG_context * pCtx, void * pContext)
     {
-        _URI__ZING_RECORD_SPECIFIC_PUT__CONTEXT__NULLFREE(pCtx, pContext);
+        _URI__ZING_RECORD_SPECIFIC_PUT__CONTEXT__NULLDISCARD(pCtx, pContext);
     }
 
 static void _PUT__zing_record_specific(
@@ -3038,16 +3139,18 @@ fail:
 
     static void _uri__zing_record_specific_put_link__context__free(
         SG_context * pCtx,
-        _uri__zing_record_specific_put_link__context * p)
+        _uri__zing_record_specific_put_link__context * p,
+        SG_bool bFailed)
     {
         if(p==NULL)
             return;
-        SG_REPO_NULLFREE(pCtx,p->pRepo);
+        _repo_pool__nullrelease(pCtx, &p->pRepo, bFailed);
         SG_STRING_NULLFREE(pCtx, p->pRequestBody);
 		SG_NULLFREE(pCtx, p->linkName);
         SG_NULLFREE(pCtx,p);
     }
-#define _URI__zing_record_specific_put_link__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_record_specific_put_link__context__free(pCtx,p); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__zing_record_specific_put_link__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _uri__zing_record_specific_put_link__context__free(pCtx,p,_bFailed); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__zing_record_specific_put_link__CONTEXT__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_record_specific_put_link__context__free(pCtx,p,SG_TRUE); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
 
     static void _uri__zing_record_specific_put_link__chunk(SG_context * pCtx, _response_handle ** ppResponseHandle, SG_byte * pBuffer, SG_uint32 bufferLength, void * pContext__voidp)
     {
@@ -3141,7 +3244,7 @@ fail:
 
     static void _uri__zing_record_specific_put_link__aborted(SG_context * pCtx, void * pContext)
     {
-        _URI__zing_record_specific_put_link__CONTEXT__NULLFREE(pCtx, pContext);
+        _URI__zing_record_specific_put_link__CONTEXT__NULLDISCARD(pCtx, pContext);
     }
 
 static void _PUT__zing_record_specific_put_link(
@@ -3736,7 +3839,7 @@ fail:
 	SG_STRING_NULLFREE(pCtx, arg);
 	SG_STRING_NULLFREE(pCtx, results);
     SG_RBTREE_NULLFREE(pCtx, pLeaves);
-	SG_REPO_NULLFREE(pCtx, *ppRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 }
 
 static void _dispatch__zing_dag_specific_records(
@@ -3775,7 +3878,7 @@ static void _dispatch__zing_dag_specific_records(
                 SG_ERR_CHECK_RETURN(  _dispatch__zing_dag_all_records(pCtx, pRequestHeaders, ppRepo, dagnum, ppRequestHandle, ppResponseHandle)  );
             else
             {
-                SG_REPO_NULLFREE(pCtx, *ppRepo);
+                _REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 				SG_ERR_CHECK_RETURN(  _create_response_handle_for_template(pCtx, pRequestHeaders, SG_HTTP_STATUS_OK, "listwi.xhtml", _new_wit_replacer, ppResponseHandle)  );
             }
         }
@@ -3835,7 +3938,7 @@ fail:
     SG_VARRAY_NULLFREE(pCtx, pva_query_result);
     SG_VARRAY_NULLFREE(pCtx, pQuery);
     SG_RBTREE_NULLFREE(pCtx, pLeaves);
-	SG_REPO_NULLFREE(pCtx, *ppRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 }
 
 // -- _POST__zing_rectype_specific -- //
@@ -3876,17 +3979,19 @@ fail:
 
     static void _uri__zing_rectype_specific_POST__context__free(
         SG_context * pCtx,
-        _uri__zing_rectype_specific_POST__context * p)
+        _uri__zing_rectype_specific_POST__context * p,
+        SG_bool bFailed)
     {
         if(p==NULL)
             return;
-        SG_REPO_NULLFREE(pCtx,p->pRepo);
         SG_ERR_IGNORE(  SG_zing__abort_tx(pCtx, &p->pZingTx)  );
+        _repo_pool__nullrelease(pCtx, &p->pRepo, bFailed);
         SG_STRING_NULLFREE(pCtx, p->pRectype);
         SG_STRING_NULLFREE(pCtx, p->pRequestBody);
         SG_NULLFREE(pCtx,p);
     }
-#define _URI__ZING_RECTYPE_SPECIFIC_POST__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_rectype_specific_POST__context__free(pCtx,p); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__ZING_RECTYPE_SPECIFIC_POST__CONTEXT__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _uri__zing_rectype_specific_POST__context__free(pCtx,p,_bFailed); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
+#define _URI__ZING_RECTYPE_SPECIFIC_POST__CONTEXT__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _uri__zing_rectype_specific_POST__context__free(pCtx,p,SG_TRUE); SG_ASSERT(!SG_context__has_err(pCtx)); SG_context__pop_level(pCtx); p=NULL;)
 
     static void _uri__zing_rectype_specific_POST__chunk(SG_context * pCtx, _response_handle ** ppResponseHandle, SG_byte * pBuffer, SG_uint32 bufferLength, void * pContext__voidp)
     {
@@ -3947,7 +4052,7 @@ fail:
 
     static void _uri__zing_rectype_specific_POST__aborted(SG_context * pCtx, void * pContext)
     {
-        _URI__ZING_RECTYPE_SPECIFIC_POST__CONTEXT__NULLFREE(pCtx, pContext);
+        _URI__ZING_RECTYPE_SPECIFIC_POST__CONTEXT__NULLDISCARD(pCtx, pContext);
     }
 
 static void _POST__zing_rectype_specific(
@@ -4600,7 +4705,7 @@ static void _GET_repo(SG_context* pCtx,
 
 	SG_ERR_CHECK(  _create_response_handle_for_string(pCtx, SG_HTTP_STATUS_OK, SG_contenttype__json, &pstrResponse, &pResponseHandle)  );
 
-	SG_REPO_NULLFREE(pCtx, pRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, pRepo);
 	*ppRepo = NULL;
 	SG_RETURN_AND_NULL(pResponseHandle, ppResponseHandle);
 
@@ -4729,7 +4834,7 @@ static void _GET__repos(
 		SG_ERR_CHECK(  SG_varray__get__sz(pCtx, pDescriptorNames, i, &pszRepoName)  );
 
 		// Tolerate malformed descriptors primarily because the test suite adds some.
-		SG_repo__open_repo_instance(pCtx, pszRepoName,  &pRepo);
+		_repo_pool__borrow(pCtx, pszRepoName,  &pRepo);
 		if (SG_context__has_err(pCtx))
 		{
 			SG_ERR_DISCARD; // TODO: be more specific here, rather than disregarding *any* error.
@@ -4749,7 +4854,7 @@ static void _GET__repos(
 		}
 		SG_ERR_CHECK(  SG_vhash__add__varray(pCtx, pResult, pszRepoName, &pvaHids)  );
 		SG_VARRAY_NULLFREE(pCtx, pvaHids);
-		SG_REPO_NULLFREE(pCtx, pRepo);
+		_REPO_POOL__NULLRELEASE(pCtx, pRepo);
 		SG_RBTREE_NULLFREE(pCtx, prbLeaves);
 		SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
 
@@ -4764,7 +4869,7 @@ fail:
     SG_VARRAY_NULLFREE(pCtx, pDescriptorNames);
     SG_VHASH_NULLFREE(pCtx, pDescriptors);
 	SG_VHASH_NULLFREE(pCtx, pResult);
-	SG_REPO_NULLFREE(pCtx, pRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, pRepo);
 	SG_RBTREE_NULLFREE(pCtx, prbLeaves);
 	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
 	SG_STRING_NULLFREE(pCtx, pString);
@@ -4801,14 +4906,14 @@ static void _dispatch__repo(
 		SG_ERR_CHECK(  SG_PATHNAME__ALLOC(pCtx, &pPathCwd)  );
 		SG_ERR_CHECK(  SG_pathname__set__from_cwd(pCtx, pPathCwd)  );
 		SG_ERR_CHECK(  SG_workingdir__find_mapping(pCtx, pPathCwd, NULL, &pstrRepoDescriptorName, NULL)  );
-        SG_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, SG_string__sz(pstrRepoDescriptorName), &pRepo)  );
+        SG_ERR_CHECK(  _repo_pool__borrow(pCtx, SG_string__sz(pstrRepoDescriptorName), &pRepo)  );
         SG_ERR_CHECK(  _dispatch__repo_specific(pCtx, pRequestHeaders, SG_string__sz(pstrRepoDescriptorName), &pRepo, ppUriSubstrings, uriSubstringsCount, ppRequestHandle, ppResponseHandle)  );
 
 	}
 
 fail:
 	SG_PATHNAME_NULLFREE(pCtx, pPathCwd);
-    SG_REPO_NULLFREE(pCtx, pRepo);
+    _REPO_POOL__NULLRELEASE(pCtx, pRepo);
     SG_STRING_NULLFREE(pCtx, pstrRepoDescriptorName);
 }
 
@@ -4863,15 +4968,17 @@ static void _dispatch__repos(
     }
     else
     {
-		SG_repo__open_repo_instance(pCtx, ppUriSubstrings[0], &pRepo);
-		if(pRepo==NULL || SG_context__has_err(pCtx))
+		_repo_pool__borrow(pCtx, ppUriSubstrings[0], &pRepo);
+		if(SG_context__err_equals(pCtx, SG_ERR_REPO_BUSY))
+			SG_ERR_RETHROW;
+		else if(pRepo==NULL || SG_context__has_err(pCtx))
 			SG_ERR_RESET_THROW(SG_ERR_URI_HTTP_404_NOT_FOUND);
         else
 			SG_ERR_CHECK(  _dispatch__repo_specific(pCtx, pRequestHeaders, ppUriSubstrings[0], &pRepo, ppUriSubstrings+1, uriSubstringsCount-1, ppRequestHandle, ppResponseHandle)  );
     }
 
 fail:
-    SG_REPO_NULLFREE(pCtx, pRepo);
+    _REPO_POOL__NULLRELEASE(pCtx, pRepo);
 }
 
 // -- _PUT__local -- //
@@ -69,6 +69,72 @@ void _response_handle__add_header(SG_context * pCtx, _response_handle *pResponse
 //////////////////////////////////////////////////////////////////
 
 
+// Get an open repo for the given descriptor name, from the pool if we have
+// one, otherwise by opening it.  Give it back with _REPO_POOL__NULLRELEASE
+// (instead of SG_REPO_NULLFREE) when the request is done with it.
+// Throws SG_ERR_REPO_BUSY if too many handles are already out.
+void _repo_pool__borrow(SG_context * pCtx, const char * pszDescriptorName, SG_repo ** ppRepo);
+
+// Like SG_repo__free(), this is safe to call from a fail: block.  If
+// bFailed is set, the handle is closed rather than kept for reuse.
+void _repo_pool__nullrelease(SG_context * pCtx, SG_repo ** ppRepo, SG_bool bFailed);
+
+// This looks at pCtx to see whether the request failed, so it must not be
+// used between SG_context__push_level() and SG_context__pop_level();
+// capture SG_context__has_err() first and call _repo_pool__nullrelease().
+#define _REPO_POOL__NULLRELEASE(pCtx,p)		SG_STATEMENT(  _repo_pool__nullrelease(pCtx, &(p), SG_context__has_err(pCtx));  )
+
+
+//////////////////////////////////////////////////////////////////
+
+
+// A small process-wide cache of computed responses.  See the comments
+// in sg_uridispatch.c for what goes in an entry.  __get returns a copy
+// (or NULL if there is no entry for the key); __put takes ownership.
+void _response_cache__get(SG_context * pCtx, const char * pszKey, SG_vhash ** ppvhEntry);
+void _response_cache__put(SG_context * pCtx, const char * pszKey, SG_vhash ** ppvhEntry);
+
+// Describe the state of a repo by the leaves of the given dags.  The
+// result maps the dagnum (decimal) to a sorted varray of leaf HIDs.
+void _repo_state__get_leaves(
+	SG_context * pCtx,
+	SG_repo * pRepo,
+	const SG_uint32 * paDagNums,
+	SG_uint32 countDagNums,
+	SG_vhash ** ppvhLeaves);
+
+// Hash the leaves (and whatever else distinguishes this response, such
+// as the content type) into an ETag.
+void _repo_state__compute_etag(
+	SG_context * pCtx,
+	SG_repo * pRepo,
+	const SG_vhash * pvhLeaves,
+	const char * pszVariant,
+	char ** ppszETag);
+
+// Are the leaves of the given dag the same in both?  (False if either
+// doesn't mention the dag.)
+void _repo_state__dag_unchanged(
+	SG_context * pCtx,
+	const SG_vhash * pvhLeavesOld,
+	const SG_vhash * pvhLeavesNew,
+	SG_uint32 iDagNum,
+	SG_bool * pbUnchanged);
+
+SG_bool _request_headers__if_none_match(const _request_headers * pRequestHeaders, const char * pszETag);
+
+// A 304 for a client that already has the current ETag.
+void _create_response_handle_for_not_modified(
+	SG_context * pCtx,
+	const char * pszETag,
+	_response_handle ** ppResponseHandle);
+
+void _response_handle__add_etag(SG_context * pCtx, _response_handle * pResponseHandle, const char * pszETag);
+
+
+//////////////////////////////////////////////////////////////////
+
+
 _request_chunk_cb _chunk_request_to_string;
 _request_aborted_cb _free_string;
 
@@ -110,6 +176,14 @@ void _create_response_handle_for_file(
 	SG_bool bDeleteOnSuccessfulFinish,
 	_response_handle ** ppResponseHandle);
 
+// The response reads the fragball from the stream as it is sent.
+void _create_response_handle_for_fragball_stream(
+	SG_context * pCtx,
+	const char * pHttpStatusCode,
+	SG_repo ** ppRepo, // On success we've taken ownership and nulled the caller's copy.
+	SG_fragball_stream** ppFragballStream, // On success we've taken ownership and nulled the caller's copy.
+	_response_handle ** ppResponseHandle);
+
 // ***WE WILL ALWAYS RETURN A USABLE RESPONSE HANDLE NO MATTER WHAT, NEVER NULL***
 //
 // If anything catestrophic happens, we'll return either
@@ -148,6 +148,7 @@ typedef struct
     const char * pFrom;
 	SG_int64 ifModifiedSince;
 	SG_int64 localIfModifiedSince;
+	const char * pIfNoneMatch;
 } _request_headers;
 
 
@@ -30,16 +30,17 @@ typedef struct
 	SG_repo* pRepo;
 } _POST_sync_request_body_state;
 
-static void _POST_sync_request_body_state__free(SG_context* pCtx, _POST_sync_request_body_state* pState)
+static void _POST_sync_request_body_state__free(SG_context* pCtx, _POST_sync_request_body_state* pState, SG_bool bFailed)
 {
 	if (pState)
 	{
 		SG_STRING_NULLFREE(pCtx, pState->pstrRequestBody);
-		SG_REPO_NULLFREE(pCtx, pState->pRepo);
+		_repo_pool__nullrelease(pCtx, &pState->pRepo, bFailed);
 		SG_NULLFREE(pCtx, pState);
 	}
 }
-#define _POST_SYNC_REQUEST_BODY_STATE__NULLFREE(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _POST_sync_request_body_state__free(pCtx,p); SG_context__pop_level(pCtx); p=NULL;)
+#define _POST_SYNC_REQUEST_BODY_STATE__NULLFREE(pCtx,p) SG_STATEMENT(SG_bool _bFailed = SG_context__has_err(pCtx); SG_context__push_level(pCtx); _POST_sync_request_body_state__free(pCtx,p,_bFailed); SG_context__pop_level(pCtx); p=NULL;)
+#define _POST_SYNC_REQUEST_BODY_STATE__NULLDISCARD(pCtx,p) SG_STATEMENT(SG_context__push_level(pCtx); _POST_sync_request_body_state__free(pCtx,p,SG_TRUE); SG_context__pop_level(pCtx); p=NULL;)
 
 //////////////////////////////////////////////////////////////////
 
@@ -58,7 +59,7 @@ static void _POST_sync_request_body__chunk(SG_context* pCtx,
 
 static void _POST_sync_request_body__aborted(SG_context* pCtx, void *pState)
 {
-	_POST_SYNC_REQUEST_BODY_STATE__NULLFREE(pCtx, pState);
+	_POST_SYNC_REQUEST_BODY_STATE__NULLDISCARD(pCtx, pState);
 }
 
 static void _POST_sync_request_body__finish(SG_context* pCtx,
@@ -72,21 +73,38 @@ static void _POST_sync_request_body__finish(SG_context* pCtx,
 	char* pszFragballName = NULL;
 	SG_vhash* pvhStatus = NULL;
 	SG_pathname* pPathFragball = NULL;
+	SG_fragball_stream* pFragballStream = NULL;
+	SG_bool bClone = SG_FALSE;
 
 	SG_UNUSED(pAudit);
 
 	if (pRequestState->pstrRequestBody)
 		SG_ERR_CHECK(  SG_vhash__alloc__from_json(pCtx, &pvhRequest, SG_string__sz(pRequestState->pstrRequestBody))  );
 
-	SG_ERR_CHECK(  SG_pathname__alloc__user_temp_directory(pCtx, &pPathTemp)  ); // TODO: what's the right path?  Not user temp.
-	SG_ERR_CHECK(  SG_server__pull_request_fragball(pCtx, pRequestState->pRepo, pvhRequest, pPathTemp, &pszFragballName, &pvhStatus) );
+	if (pvhRequest)
+		SG_ERR_CHECK(  SG_vhash__has(pCtx, pvhRequest, SG_SYNC_STATUS_KEY__CLONE, &bClone)  );
+
+	if (bClone)
+	{
+		// A clone is sent from the repo's own fragball file.
+		SG_ERR_CHECK(  SG_pathname__alloc__user_temp_directory(pCtx, &pPathTemp)  ); // TODO: what's the right path?  Not user temp.
+		SG_ERR_CHECK(  SG_server__pull_request_fragball(pCtx, pRequestState->pRepo, pvhRequest, pPathTemp, &pszFragballName, &pvhStatus) );
 
-	SG_ERR_CHECK(  SG_pathname__alloc__pathname_sz(pCtx, &pPathFragball, pPathTemp, (const char*)pszFragballName)  );
+		SG_ERR_CHECK(  SG_pathname__alloc__pathname_sz(pCtx, &pPathFragball, pPathTemp, (const char*)pszFragballName)  );
 
-	SG_ERR_CHECK(  _create_response_handle_for_file(pCtx, SG_HTTP_STATUS_OK, SG_contenttype__fragball, &pPathFragball, SG_TRUE, ppResponseHandle)  );
+		SG_ERR_CHECK(  _create_response_handle_for_file(pCtx, SG_HTTP_STATUS_OK, SG_contenttype__fragball, &pPathFragball, SG_TRUE, ppResponseHandle)  );
+	}
+	else
+	{
+		// Everything else is read from the repo as it's sent, so the
+		// response keeps the repo until it's done.
+		SG_ERR_CHECK(  SG_server__pull_request_fragball__stream(pCtx, pRequestState->pRepo, pvhRequest, &pFragballStream, &pvhStatus)  );
+		SG_ERR_CHECK(  _create_response_handle_for_fragball_stream(pCtx, SG_HTTP_STATUS_OK, &pRequestState->pRepo, &pFragballStream, ppResponseHandle)  );
+	}
 
 	/* fall through */
 fail:
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pFragballStream);
 	_POST_SYNC_REQUEST_BODY_STATE__NULLFREE(pCtx, pRequestState);
 	SG_VHASH_NULLFREE(pCtx, pvhRequest);
 	SG_PATHNAME_NULLFREE(pCtx, pPathTemp);
@@ -167,7 +185,7 @@ static void _POST_sync(SG_context* pCtx,
 		SG_ERR_CHECK(  SG_STRING__ALLOC__SZ(pCtx, &pstrResponse, pszPushId)  );
 		SG_ERR_CHECK(  _create_response_handle_for_string(pCtx, SG_HTTP_STATUS_OK, SG_contenttype__json, &pstrResponse, ppResponseHandle)  );
 
-		SG_REPO_NULLFREE(pCtx, *ppRepo);
+		_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 		*ppRepo = NULL;
 	}
 	else
@@ -204,7 +222,7 @@ static void _DELETE_pushid(SG_context* pCtx,
 
 	SG_ERR_CHECK(  _response_handle__alloc(pCtx, ppResponseHandle, SG_HTTP_STATUS_OK, NULL, 0, NULL, NULL, NULL, NULL)  );
 
-	SG_REPO_NULLFREE(pCtx, *ppRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 
 	/* fall through */
 fail:
@@ -216,17 +234,19 @@ fail:
 
 typedef struct
 {
-	char bufFragballFilename[SG_TID_MAX_BUFFER_LENGTH];
-	SG_file* pFileFragball;
-	char* pszPushId;
+	SG_staging* pStaging;
+	SG_writestream* pStreamFragball; // Stages the fragball as it arrives.  Must be closed before pStaging is freed.
 } _POST_pushid_request_body_state;
 
 static void _POST_pushid_request_body_state__free(SG_context* pCtx, _POST_pushid_request_body_state* pState)
 {
 	if (pState)
 	{
-		SG_FILE_NULLCLOSE(pCtx, pState->pFileFragball);
-		SG_NULLFREE(pCtx, pState->pszPushId);
+		// If we get here with the stream still open, the request didn't finish.  Closing the
+		// stream discards whatever part of the fragball we got.
+		if (pState->pStreamFragball)
+			SG_ERR_IGNORE(  SG_writestream__close(pCtx, pState->pStreamFragball)  );
+		SG_STAGING_NULLFREE(pCtx, pState->pStaging);
 		SG_NULLFREE(pCtx, pState);
 	}
 }
@@ -238,12 +258,12 @@ static void _POST_pushid_request_body__chunk(SG_context* pCtx,
 											 SG_uint32 bufferLength,
 											 void* pState)
 {
-	SG_file* pFileFragball = ((_POST_pushid_request_body_state*)pState)->pFileFragball;
+	SG_writestream* pStreamFragball = ((_POST_pushid_request_body_state*)pState)->pStreamFragball;
 	SG_uint32 lenWritten;
 
 	SG_UNUSED(ppResponseHandle);
 
-	SG_ERR_CHECK_RETURN(  SG_file__write(pCtx, pFileFragball, bufferLength, (const SG_byte*)pBuffer, &lenWritten)  );
+	SG_ERR_CHECK_RETURN(  SG_writestream__write(pCtx, pStreamFragball, bufferLength, pBuffer, &lenWritten)  );
 	if (lenWritten != bufferLength)
 		SG_ERR_THROW_RETURN(SG_ERR_INCOMPLETEWRITE);
 }
@@ -259,15 +279,18 @@ static void _POST_pushid_request_body__finish(SG_context* pCtx,
 											  _response_handle ** ppResponseHandle)
 {
 	_POST_pushid_request_body_state* pState = (_POST_pushid_request_body_state*)pVoidState;
-	SG_server* pServer = NULL;
+	SG_writestream* pStreamFragball = NULL;
 	SG_vhash* pvhAddResult = NULL;
 	SG_string* pstrResponse = NULL;
 
 	SG_UNUSED(pAudit);
 
-	SG_ERR_CHECK(  SG_server__alloc(pCtx, &pServer)  );
+	/* The fragball was staged as it arrived.  Closing the stream makes it part of the push. */
+	pStreamFragball = pState->pStreamFragball;
+	pState->pStreamFragball = NULL;
+	SG_ERR_CHECK(  SG_writestream__close(pCtx, pStreamFragball)  );
 
-	SG_ERR_CHECK(  SG_server__push_add(pCtx, pServer, pState->pszPushId, (const char*)pState->bufFragballFilename, &pvhAddResult) );
+	SG_ERR_CHECK(  SG_staging__check_status(pCtx, pState->pStaging, SG_TRUE, SG_TRUE, SG_FALSE, SG_TRUE, SG_TRUE, &pvhAddResult)  );
 	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrResponse)  );
 	SG_ERR_CHECK(  SG_vhash__to_json(pCtx, pvhAddResult, pstrResponse)  );
 
@@ -277,7 +300,6 @@ static void _POST_pushid_request_body__finish(SG_context* pCtx,
 fail:
 	_POST_PUSHID_REQUEST_BODY_STATE__NULLFREE(pCtx, pState);
 	SG_STRING_NULLFREE(pCtx, pstrResponse);
-	SG_SERVER_NULLFREE(pCtx, pServer);
 	SG_VHASH_NULLFREE(pCtx, pvhAddResult);
 }
 
@@ -312,9 +334,6 @@ static void _POST_pushid(SG_context* pCtx,
 						 _request_handle ** ppRequestHandle,
 						 _response_handle** ppResponseHandle)
 {
-	SG_staging* pStaging = NULL;
-	const SG_pathname* pStagingPathname = NULL;
-	SG_pathname* pPathFragball = NULL;
 	_POST_pushid_request_body_state* pRequestState = NULL;
 
 	if (pRequestHeaders->contentLength == 0)
@@ -326,14 +345,9 @@ static void _POST_pushid(SG_context* pCtx,
 	{
 		// push add
 		SG_ERR_CHECK(  SG_alloc1(pCtx, pRequestState)  );
-		SG_ERR_CHECK(  SG_strdup(pCtx, pszPushId, &pRequestState->pszPushId)  );
 
-		SG_ERR_CHECK(  SG_tid__generate(pCtx, pRequestState->bufFragballFilename, SG_TID_MAX_BUFFER_LENGTH)  );
-		SG_ERR_CHECK(  SG_staging__open(pCtx, pszPushId, &pStaging)  );
-		SG_ERR_CHECK(  SG_staging__get_pathname(pCtx, pStaging, &pStagingPathname)  );
-		SG_ERR_CHECK(  SG_pathname__alloc__pathname_sz(pCtx, &pPathFragball, pStagingPathname, pRequestState->bufFragballFilename)  );
-
-		SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathFragball, SG_FILE_CREATE_NEW | SG_FILE_WRONLY, 0644, &pRequestState->pFileFragball)  );
+		SG_ERR_CHECK(  SG_staging__open(pCtx, pszPushId, &pRequestState->pStaging)  );
+		SG_ERR_CHECK(  SG_staging__open_fragball_writestream(pCtx, pRequestState->pStaging, &pRequestState->pStreamFragball)  );
 
 		SG_ERR_CHECK(  _request_handle__alloc(pCtx, ppRequestHandle, pRequestHeaders,
 			_POST_pushid_request_body__chunk,
@@ -343,12 +357,10 @@ static void _POST_pushid(SG_context* pCtx,
 		pRequestState = NULL;
 	}
 
-	SG_REPO_NULLFREE(pCtx, *ppRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 
 	/* fall through */
 fail:
-	SG_STAGING_NULLFREE(pCtx, pStaging);
-	SG_PATHNAME_NULLFREE(pCtx, pPathFragball);
 	_POST_PUSHID_REQUEST_BODY_STATE__NULLFREE(pCtx, pRequestState);
 }
 
@@ -376,7 +388,7 @@ static void _GET_pushid(SG_context* pCtx,
 
 	SG_ERR_CHECK(  _create_response_handle_for_string(pCtx, SG_HTTP_STATUS_OK, SG_contenttype__json, &pstrResponse, ppResponseHandle)  );
 
-	SG_REPO_NULLFREE(pCtx, *ppRepo);
+	_REPO_POOL__NULLRELEASE(pCtx, *ppRepo);
 	pstrResponse = NULL;
 
 	/* fall through */
@@ -302,7 +302,7 @@ static void _fillInUserSelection(
 	SG_string *curuid = NULL;
 
 	SG_ERR_CHECK(  SG_string__clear(pCtx, replacement)  );
-	SG_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, SG_string__sz(pstrRepoDescriptorName), &repo)  );
+	SG_ERR_CHECK(  _repo_pool__borrow(pCtx, SG_string__sz(pstrRepoDescriptorName), &repo)  );
 
 	SG_ERR_CHECK(  SG_user__list_all(pCtx, repo, &users)  );
 	SG_ERR_CHECK(  SG_varray__count(pCtx, users, &count)  );
@@ -344,7 +344,7 @@ static void _fillInUserSelection(
 	}
 fail:
 	SG_VARRAY_NULLFREE(pCtx, users);
-	SG_REPO_NULLFREE(pCtx, repo);
+	_REPO_POOL__NULLRELEASE(pCtx, repo);
 	SG_STRING_NULLFREE(pCtx, semail);
 	SG_STRING_NULLFREE(pCtx, suid);
 	SG_STRING_NULLFREE(pCtx, entry);
@@ -396,7 +396,7 @@ static void _default_replacer(
 
 		if (pstrRepoDescriptorName != NULL)
 		{
-			SG_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, SG_string__sz(pstrRepoDescriptorName), &repo)  );
+			SG_ERR_CHECK(  _repo_pool__borrow(pCtx, SG_string__sz(pstrRepoDescriptorName), &repo)  );
 		}
 
 		SG_ERR_CHECK(  _getUserId(pCtx, repo, replacement)  );
@@ -407,7 +407,7 @@ static void _default_replacer(
 
 		if (pstrRepoDescriptorName != NULL)
 		{
-			SG_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, SG_string__sz(pstrRepoDescriptorName), &repo)  );
+			SG_ERR_CHECK(  _repo_pool__borrow(pCtx, SG_string__sz(pstrRepoDescriptorName), &repo)  );
 		}
 
 		SG_ERR_CHECK( _getUserEmail(pCtx, repo, replacement)  );
@@ -421,5 +421,5 @@ static void _default_replacer(
 
 fail:
 	SG_STRING_NULLFREE(pCtx, pstrRepoDescriptorName);
-	SG_REPO_NULLFREE(pCtx, repo);
+	_REPO_POOL__NULLRELEASE(pCtx, repo);
 }
@@ -22,9 +22,10 @@ typedef struct _sg_vcdiff_window       sg_vcdiff_window;
 typedef struct _sg_vcdiff_encoder      sg_vcdiff_encoder;
 typedef struct _sg_vcdiff_decoder      sg_vcdiff_decoder;
 typedef struct _sg_vcdiff_hashconfig   sg_vcdiff_hashconfig;
+typedef struct _sg_vcdiff_srcindex     sg_vcdiff_srcindex;
 
 
-#define _SG_VCDIFF_DEFAULT_WINDOW_SIZE (128*1024)
+#define _SG_VCDIFF_DEFAULT_WINDOW_SIZE SG_VCDIFF_MAX_WINDOW_SIZE
 
 #define _SG_VCDIFF_OP_NOOP 0
 #define _SG_VCDIFF_OP_ADD  1
@@ -211,6 +212,21 @@ struct _sg_vcdiff_hash
 	SG_uint16* counts;
 };
 
+// The whole-source index.  One entry per indexed source block, in an
+// open-addressed table keyed by the block's rolling hash.  The first
+// block with a given hash wins; later ones are just not indexed.
+struct _sg_vcdiff_srcindex
+{
+	SG_uint32 block_size;
+	SG_uint32 stride;           // distance between the starts of indexed blocks
+	SG_uint32 pow;              // _SG_VCDIFF_ROLL_MULT ^ (block_size - 1)
+	SG_uint32 num_buckets;      // a power of 2
+	SG_uint32 shift;
+	SG_uint32* Hashes;
+	SG_uint64* Offsets;         // source offset + 1, 0 means the bucket is empty
+	SG_uint64* Hits;            // scratch for choosing a source segment
+};
+
 struct _sg_vcdiff_window
 {
     // WINDOW DATA
@@ -244,6 +260,7 @@ struct _sg_vcdiff_decoder
     SG_uint32 AddRunPointer/* = 0*/;
 
     SG_uint32 BufferPointer/* = 0*/;
+    SG_uint32 BufferLimit;          // instructions may not write past this
 
     sg_vcdiff_instrcache CodeTable;
 };
@@ -258,6 +275,7 @@ struct _sg_vcdiff_encoder
 
     sg_vcdiff_hash* SourceHash;
     sg_vcdiff_hash* TargetHash;
+    sg_vcdiff_srcindex* SourceIndex;
 
     SG_uint32 LastInstructionPointer/* = 0*/;
 
@@ -339,7 +357,7 @@ void sg_vcdiff_window__reset(sg_vcdiff_window* pThis)
     pThis->CopyAddrLength = 0;
 }
 
-void sg_vcdiff_decoder__init(sg_vcdiff_decoder* pThis, sg_vcdiff_window* window, SG_readstream* deltaAccessor, SG_seekreader* sourceAccessor)
+void sg_vcdiff_decoder__init(sg_vcdiff_decoder* pThis, sg_vcdiff_window* window, SG_readstream* deltaAccessor, SG_seekreader* sourceAccessor, SG_uint32 bufferLimit)
 {
     pThis->Window = window;
 
@@ -350,6 +368,7 @@ void sg_vcdiff_decoder__init(sg_vcdiff_decoder* pThis, sg_vcdiff_window* window,
     pThis->CopyAddrPointer = 0;
     pThis->AddRunPointer = 0;
     pThis->BufferPointer = 0;
+    pThis->BufferLimit = bufferLimit;
 
 	memset(&pThis->CodeTable, 0, sizeof(sg_vcdiff_instrcache));
 }
@@ -361,12 +380,13 @@ void sg_vcdiff__hash__free(SG_context * pCtx, sg_vcdiff_hash* pThis)
 	SG_NULLFREE(pCtx, pThis);
 }
 
-void sg_vcdiff_encoder__init(sg_vcdiff_encoder* pThis, sg_vcdiff_window* window, SG_writestream* deltaAccessor, SG_readstream* targetAccessor, SG_seekreader* sourceAccessor, sg_vcdiff_hash* SourceHash, sg_vcdiff_hash* TargetHash)
+void sg_vcdiff_encoder__init(sg_vcdiff_encoder* pThis, sg_vcdiff_window* window, SG_writestream* deltaAccessor, SG_readstream* targetAccessor, SG_seekreader* sourceAccessor, sg_vcdiff_hash* SourceHash, sg_vcdiff_hash* TargetHash, sg_vcdiff_srcindex* SourceIndex)
 {
     pThis->Window = window;
 
 	pThis->SourceHash = SourceHash;
     pThis->TargetHash = TargetHash;
+    pThis->SourceIndex = SourceIndex;
     pThis->DeltaAccessor = deltaAccessor;
     pThis->TargetAccessor = targetAccessor;
     pThis->SourceAccessor = sourceAccessor;
@@ -573,14 +593,24 @@ void sg_vcdiff__read_window(SG_context* pCtx, sg_vcdiff_window* pw, SG_readstrea
     // read target window size
 	SG_ERR_CHECK(  sg_vcdiff__read_uint32(pCtx, windowAccessor, &(pw->TargetWinSize))  );
 
-	pw->WindowBufferLength = pw->SourceSize + pw->TargetWinSize;
-
-	if (pw->WindowBufferLength > max_window_size)
+	if (
+		(pw->SourceSize > max_window_size)
+		|| (pw->TargetWinSize > max_window_size)
+		|| ((pw->SourceSize + pw->TargetWinSize) > max_window_size)
+		)
 	{
 		// this delta uses windows that are too big
 		SG_ERR_THROW(  SG_ERR_VCDIFF_UNSUPPORTED  );
 	}
 
+	if (!pw->SourceSize && pw->TargetWinSize)
+	{
+		/* we don't support windows which don't use source data */
+		SG_ERR_THROW(  SG_ERR_VCDIFF_UNSUPPORTED  );
+	}
+
+	pw->WindowBufferLength = pw->SourceSize + pw->TargetWinSize;
+
     // read delta indicator: a bitfield indicating what is in this window
     deltaIndicator = 0;
 
@@ -607,6 +637,16 @@ void sg_vcdiff__read_window(SG_context* pCtx, sg_vcdiff_window* pw, SG_readstrea
 
 	SG_ERR_CHECK(  sg_vcdiff__read_uint32(pCtx, windowAccessor, &(pw->CopyAddrLength))  );
 
+	// these are the buffer sizes sg_vcdiff_window__init() gave us
+	if (
+		(pw->AddRunLength > 2 * max_window_size)
+		|| (pw->InstrLength > 2 * max_window_size)
+		|| (pw->CopyAddrLength > 4 * max_window_size)
+		)
+	{
+		SG_ERR_THROW(  SG_ERR_VCDIFF_INVALID_FORMAT  );
+	}
+
     // read add/run data
     if(pw->AddRunLength > 0)
 	{
@@ -793,47 +833,78 @@ fail:
 	return;
 }
 
+// The apply functions below work on the window buffer with memset()
+// and memcpy() rather than a byte at a time.  Every instruction is
+// checked against the data it reads and the room it writes into, so a
+// damaged delta gets SG_ERR_VCDIFF_INVALID_FORMAT instead of running off
+// the end of a buffer.
+//
+// Note that the output is limited by BufferLimit, not by the end of the
+// target window.  Older encoders kept going to the end of a full-sized
+// window even when the last one was short, and the decoder has always
+// quietly dropped those extra bytes.
+
 void sg_vcdiff_decoder__apply_run_instruction(SG_context* pCtx, sg_vcdiff_decoder* pThis, SG_uint32 size)
 {
 	sg_vcdiff_window* pw = pThis->Window;
-	SG_byte runData;
-	SG_uint32 i;
 
-	if ((pThis->AddRunPointer + 1) > pw->AddRunLength)
+	if (
+		(pThis->AddRunPointer >= pw->AddRunLength)
+		|| (size > (pThis->BufferLimit - pThis->BufferPointer))
+		)
 	{
 		//ErrorMessage = "out of add/run data"; //string.Format("out of add/run data (ptr={0}, size={1}, len={2})", AddRunPointer, size, Window->AddRunLength);
 
 		SG_ERR_THROW_RETURN( SG_ERR_VCDIFF_INVALID_FORMAT );
 	}
 
-    runData = pw->AddRunData[pThis->AddRunPointer++];
-
-    for(i = 0; i < size; i++)
-	{
-		pw->WindowBuffer[pThis->BufferPointer++] = runData;
-	}
-
+	memset(pw->WindowBuffer + pThis->BufferPointer, pw->AddRunData[pThis->AddRunPointer++], size);
+	pThis->BufferPointer += size;
 }
 
 void sg_vcdiff_decoder__apply_add_instruction(SG_context* pCtx, sg_vcdiff_decoder* pThis, SG_uint32 size)
 {
 	sg_vcdiff_window* pw = pThis->Window;
-	SG_uint32 i;
 
-	if ((pThis->AddRunPointer + size) > pw->AddRunLength)
+	if (
+		(size > (pw->AddRunLength - pThis->AddRunPointer))
+		|| (size > (pThis->BufferLimit - pThis->BufferPointer))
+		)
 	{
 
 		//ErrorMessage = "out of add/run data"; //String.Format("out of add/run data (ptr={0}, size={1}, datalength={2})", AddRunPointer, size, Window->AddRunLength);
 		SG_ERR_THROW_RETURN( SG_ERR_VCDIFF_INVALID_FORMAT );
 	}
 
-    for(i = 0; i < size; i++)
+	memcpy(pw->WindowBuffer + pThis->BufferPointer, pw->AddRunData + pThis->AddRunPointer, size);
+	pThis->BufferPointer += size;
+    pThis->AddRunPointer += size;
+}
+
+// A COPY whose source runs into the bytes it is writing repeats the
+// (pDest - pSrc) bytes before pDest.  We copy that pattern with memcpy,
+// doubling the length of each copy, since everything between pSrc and
+// pDest is already a whole number of repeats.
+static void sg_vcdiff__copy_overlapped(SG_byte* pDest, const SG_byte* pSrc, SG_uint32 size)
+{
+	if (1 == (pDest - pSrc))
 	{
-		pw->WindowBuffer[pThis->BufferPointer++] = pw->AddRunData[pThis->AddRunPointer + i];
+		memset(pDest, *pSrc, size);
+		return;
 	}
 
-    pThis->AddRunPointer += size;
+	while (size)
+	{
+		SG_uint32 len = (SG_uint32)(pDest - pSrc);
 
+		if (len > size)
+		{
+			len = size;
+		}
+		memcpy(pDest, pSrc, len);
+		pDest += len;
+		size -= len;
+	}
 }
 
 void sg_vcdiff_instrcache__update_cache(sg_vcdiff_instrcache* pThis, SG_uint32 addr)
@@ -848,7 +919,6 @@ void sg_vcdiff_instrcache__update_cache(sg_vcdiff_instrcache* pThis, SG_uint32 a
 
 void sg_vcdiff_decoder__apply_copy_instruction(SG_context* pCtx, sg_vcdiff_decoder* pThis, SG_uint32 size, SG_byte mode)
 {
-	SG_uint32 i;
     SG_uint32 position = 0;
     SG_int32 nearPosition, samePosition;
 	sg_vcdiff_window* pw = pThis->Window;
@@ -872,6 +942,10 @@ void sg_vcdiff_decoder__apply_copy_instruction(SG_context* pCtx, sg_vcdiff_decod
     // if it's in the same cache, the position is the next *byte* in the copy address block
     else if(((mode - NearSize) - 2) < SameSize)
 	{
+		if (pThis->CopyAddrPointer >= pw->CopyAddrLength)
+		{
+			SG_ERR_THROW(  SG_ERR_VCDIFF_INVALID_FORMAT  );
+		}
 		position = pw->CopyAddrData[pThis->CopyAddrPointer++];
 	}
 
@@ -910,11 +984,25 @@ void sg_vcdiff_decoder__apply_copy_instruction(SG_context* pCtx, sg_vcdiff_decod
     // update this address in the cache
     sg_vcdiff_instrcache__update_cache(&(pThis->CodeTable), position);
 
-    for(i = 0; i < size; i++)
+	// the copy has to start in data we already have
+	if (
+		(position >= pThis->BufferPointer)
+		|| (size > (pThis->BufferLimit - pThis->BufferPointer))
+		)
 	{
-		pw->WindowBuffer[pThis->BufferPointer++] = pw->WindowBuffer[position + i];
+		SG_ERR_THROW(  SG_ERR_VCDIFF_INVALID_FORMAT  );
 	}
 
+	if (size <= (pThis->BufferPointer - position))
+	{
+		memcpy(pw->WindowBuffer + pThis->BufferPointer, pw->WindowBuffer + position, size);
+	}
+	else
+	{
+		sg_vcdiff__copy_overlapped(pw->WindowBuffer + pThis->BufferPointer, pw->WindowBuffer + position, size);
+	}
+	pThis->BufferPointer += size;
+
 fail:
 	return;
 }
@@ -986,6 +1074,12 @@ void sg_vcdiff_decoder__apply(SG_context* pCtx, sg_vcdiff_decoder* pThis)
 		SG_ERR_CHECK(  sg_vcdiff_decoder__apply_instruction(pCtx, pThis, type2, size2, mode2)  );
 	}
 
+	if (pThis->BufferPointer < pw->WindowBufferLength)
+	{
+		// the instructions didn't produce the whole target window
+		SG_ERR_THROW(  SG_ERR_VCDIFF_INVALID_FORMAT  );
+	}
+
 fail:
 	return;
 }
@@ -1057,6 +1151,10 @@ void SG_vcdiff__undeltify__begin(SG_context* pCtx, SG_seekreader* psr_source, SG
     return;
 
 fail:
+    if (pst)
+    {
+        SG_ERR_IGNORE(  sg_vcdiff_window__free_buffers(pCtx, &pst->window)  );
+    }
     SG_NULLFREE(pCtx, pst);
 
     return;
@@ -1079,7 +1177,7 @@ void SG_vcdiff__undeltify__chunk(SG_context* pCtx, SG_vcdiff_undeltify_state* ps
     {
         sg_vcdiff_decoder windowDecoder;
 
-        sg_vcdiff_decoder__init(&windowDecoder, &pst->window, pst->pstrm_delta, pst->psr_source);
+        sg_vcdiff_decoder__init(&windowDecoder, &pst->window, pst->pstrm_delta, pst->psr_source, DECODE_MAX_WINDOW_SIZE);
 
         SG_ERR_CHECK(  sg_vcdiff_decoder__apply(pCtx, &windowDecoder)  );
     }
@@ -1123,8 +1221,10 @@ void SG_vcdiff__undeltify__streams(SG_context* pCtx, SG_seekreader* SourceAccess
     return;
 
 fail:
-    SG_NULLFREE(pCtx, pst);
-
+    if (pst)
+    {
+        SG_ERR_IGNORE(  SG_vcdiff__undeltify__end(pCtx, pst)  );
+    }
 }
 
 void sg_vcdiff__hash__alloc(SG_context* pCtx, const sg_vcdiff_hashconfig* pConfig,
@@ -1198,6 +1298,26 @@ SG_uint32 sg_vcdiff__hash__compare_forward(sg_vcdiff_hash* pThis, SG_uint32 pos_
 	SG_byte* pFront = pThis->WindowBuffer + pos_front;
 	SG_byte* pBack = pThis->WindowBuffer + pos_back;
 
+	// a machine word at a time while we can, then finish up (or find
+	// which byte differed) one byte at a time.
+	while(
+		(pFront + sizeof(size_t) <= pThis->limit_front)
+		&& (pBack + sizeof(size_t) <= pThis->limit_back)
+		)
+	{
+		size_t wFront;
+		size_t wBack;
+
+		memcpy(&wFront, pFront, sizeof(size_t));
+		memcpy(&wBack, pBack, sizeof(size_t));
+		if (wFront != wBack)
+		{
+			break;
+		}
+		pFront += sizeof(size_t);
+		pBack += sizeof(size_t);
+	}
+
 	while(
 		(pFront < pThis->limit_front)
 		&& (pBack < pThis->limit_back)
@@ -1242,7 +1362,7 @@ SG_bool sg_vcdiff__hash__find_match(sg_vcdiff_hash* pThis, SG_uint32 iBucket, SG
     return (*pBestSize) >= minLength;
 }
 
-void sg_vcdiff_encoder__init_window_buffer(SG_context* pCtx, sg_vcdiff_encoder* pThis)
+void sg_vcdiff_encoder__init_window_buffer(SG_context* pCtx, sg_vcdiff_encoder* pThis, SG_bool bTargetAlreadyRead)
 {
 	sg_vcdiff_window* pw = pThis->Window;
     SG_uint32 got = 0;
@@ -1251,9 +1371,16 @@ void sg_vcdiff_encoder__init_window_buffer(SG_context* pCtx, sg_vcdiff_encoder*
     SG_ERR_CHECK(  SG_seekreader__read(pCtx, pThis->SourceAccessor, pw->SourcePosition, pw->SourceSize, pw->WindowBuffer, NULL)  );
 
     // put the target in
-	SG_readstream__read(pCtx, pThis->TargetAccessor, pw->TargetWinSize, pw->WindowBuffer + pw->SourceSize, &got, NULL);
-	SG_ERR_CHECK_CURRENT_DISREGARD(SG_ERR_EOF);
-    pw->TargetWinSize = got;
+	if (!bTargetAlreadyRead)
+	{
+		SG_readstream__read(pCtx, pThis->TargetAccessor, pw->TargetWinSize, pw->WindowBuffer + pw->SourceSize, &got, NULL);
+		SG_ERR_CHECK_CURRENT_DISREGARD(SG_ERR_EOF);
+		pw->TargetWinSize = got;
+	}
+
+	// the last window is usually short.  don't encode the stale bytes
+	// beyond the end of it.
+	pw->WindowBufferLength = pw->SourceSize + pw->TargetWinSize;
 
 	sg_vcdiff__hash__init(pThis->SourceHash, pw->WindowBuffer, pw->WindowBufferLength, pw->SourceSize);
 
@@ -1424,6 +1551,273 @@ SG_bool sg_all_bytes_the_same(SG_byte* p, SG_uint32 len)
 	return SG_TRUE;
 }
 
+// WHOLE-SOURCE INDEX
+//  For SG_VCDIFF_METHOD__WHOLE_SOURCE we index blocks of the entire source
+//  with a polynomial rolling hash before encoding anything.  For each
+//  target window we roll the hash over every target position, look up which
+//  source blocks the window has in common with the source, and use the
+//  window_size stretch of source which contains the most of them as the
+//  source segment for that window.  From there on the window is encoded
+//  exactly like in the windowed method, so the delta format doesn't change.
+
+#define _SG_VCDIFF_ROLL_MULT 0x01000193
+
+static SG_uint32 sg_vcdiff_srcindex__hash(const SG_byte* p, SG_uint32 len)
+{
+	SG_uint32 h = 0;
+	SG_uint32 i;
+
+	for (i = 0; i < len; i++)
+	{
+		h = h * _SG_VCDIFF_ROLL_MULT + p[i];
+	}
+
+	return h;
+}
+
+static SG_uint32 sg_vcdiff_srcindex__bucket(const sg_vcdiff_srcindex* pThis, SG_uint32 h)
+{
+	return (SG_uint32)(h * 2654435761u) >> pThis->shift;
+}
+
+void sg_vcdiff_srcindex__free(SG_context* pCtx, sg_vcdiff_srcindex* pThis)
+{
+	if (!pThis)
+	{
+		return;
+	}
+
+	SG_NULLFREE(pCtx, pThis->Hashes);
+	SG_NULLFREE(pCtx, pThis->Offsets);
+	SG_NULLFREE(pCtx, pThis->Hits);
+	SG_NULLFREE(pCtx, pThis);
+}
+
+static void sg_vcdiff_srcindex__add(sg_vcdiff_srcindex* pThis, SG_uint32 h, SG_uint64 offset)
+{
+	SG_uint32 iBucket = sg_vcdiff_srcindex__bucket(pThis, h);
+	SG_uint32 i;
+
+	// linear probing, but not very far.  a crowded neighborhood means
+	// lots of blocks with this content, and one of them is enough.
+	for (i = 0; i < 8; i++)
+	{
+		SG_uint32 k = (iBucket + i) & (pThis->num_buckets - 1);
+
+		if (0 == pThis->Offsets[k])
+		{
+			pThis->Hashes[k] = h;
+			pThis->Offsets[k] = offset + 1;
+			return;
+		}
+		if (pThis->Hashes[k] == h)
+		{
+			return;
+		}
+	}
+}
+
+static SG_bool sg_vcdiff_srcindex__find(const sg_vcdiff_srcindex* pThis, SG_uint32 h, SG_uint64* pOffset)
+{
+	SG_uint32 iBucket = sg_vcdiff_srcindex__bucket(pThis, h);
+	SG_uint32 i;
+
+	for (i = 0; i < 8; i++)
+	{
+		SG_uint32 k = (iBucket + i) & (pThis->num_buckets - 1);
+
+		if (0 == pThis->Offsets[k])
+		{
+			return SG_FALSE;
+		}
+		if (pThis->Hashes[k] == h)
+		{
+			*pOffset = pThis->Offsets[k] - 1;
+			return SG_TRUE;
+		}
+	}
+
+	return SG_FALSE;
+}
+
+/**
+ * Index the whole source.  The window's buffer (2 * window_size bytes)
+ * is used as scratch space to read the source through.
+ */
+void sg_vcdiff_srcindex__alloc(SG_context* pCtx, SG_seekreader* psrSource, SG_uint64 source_length, const SG_vcdiff_options* pOptions, SG_byte* pScratch, SG_uint32 len_scratch, sg_vcdiff_srcindex** ppNew)
+{
+	sg_vcdiff_srcindex* pThis = NULL;
+	SG_uint64 count_blocks;
+	SG_uint64 pos;
+	SG_uint32 i;
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pThis)  );
+
+	pThis->block_size = pOptions->block_size;
+
+	// sources with more blocks than max_blocks are indexed more sparsely.
+	pThis->stride = pThis->block_size;
+	if (source_length / pThis->stride > pOptions->max_blocks)
+	{
+		pThis->stride = (SG_uint32)((source_length + pOptions->max_blocks - 1) / pOptions->max_blocks);
+	}
+	count_blocks = source_length / pThis->stride;
+
+	pThis->pow = 1;
+	for (i = 1; i < pThis->block_size; i++)
+	{
+		pThis->pow *= _SG_VCDIFF_ROLL_MULT;
+	}
+
+	// keep the table at most half full
+	pThis->num_buckets = 1024;
+	pThis->shift = 22;
+	while ((pThis->num_buckets < (1u << 31)) && (pThis->num_buckets < 2 * count_blocks))
+	{
+		pThis->num_buckets <<= 1;
+		pThis->shift--;
+	}
+
+	SG_ERR_CHECK(  SG_allocN(pCtx, pThis->num_buckets, pThis->Hashes)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pThis->num_buckets, pThis->Offsets)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, pOptions->window_size, pThis->Hits)  );
+
+	// read the source a bufferful at a time.  the buffer always begins
+	// with a block, so no block straddles two reads.
+	for (pos = 0; pos + pThis->block_size <= source_length; )
+	{
+		SG_uint32 len = len_scratch - (len_scratch % pThis->stride);
+		SG_uint32 k;
+
+		if (len < pThis->block_size)
+		{
+			// very sparse.  just read the one block.
+			len = pThis->block_size;
+		}
+		if (pos + len > source_length)
+		{
+			len = (SG_uint32)(source_length - pos);
+		}
+
+		SG_ERR_CHECK(  SG_seekreader__read(pCtx, psrSource, pos, len, pScratch, NULL)  );
+
+		for (k = 0; k + pThis->block_size <= len; k += pThis->stride)
+		{
+			// long runs of one byte are handled by RUN instructions, and
+			// would just crowd everything else out of the table.
+			if (!sg_all_bytes_the_same(pScratch + k, pThis->block_size))
+			{
+				sg_vcdiff_srcindex__add(pThis, sg_vcdiff_srcindex__hash(pScratch + k, pThis->block_size), pos + k);
+			}
+		}
+
+		pos += k;
+	}
+
+	*ppNew = pThis;
+	pThis = NULL;
+
+fail:
+	SG_ERR_IGNORE(  sg_vcdiff_srcindex__free(pCtx, pThis)  );
+}
+
+static int sg_vcdiff_srcindex__compare_offsets(const void* p1, const void* p2)
+{
+	SG_uint64 a = *(const SG_uint64*)p1;
+	SG_uint64 b = *(const SG_uint64*)p2;
+
+	return (a < b) ? -1 : ((a > b) ? 1 : 0);
+}
+
+/**
+ * Pick the source segment (window_size bytes, source_length must be
+ * bigger than that) for the given target window.  The segment starting
+ * at default_position is kept unless some other segment has more blocks
+ * in common with the target.
+ */
+void sg_vcdiff_srcindex__choose_source(sg_vcdiff_srcindex* pThis, const SG_byte* pTarget, SG_uint32 len_target, SG_uint32 window_size, SG_uint64 source_length, SG_uint64 default_position, SG_uint64* pSourcePosition)
+{
+	SG_uint32 count_hits = 0;
+	SG_uint32 count_default = 0;
+	SG_uint32 best_count = 0;
+	SG_uint64 best_first = 0;
+	SG_uint64 best_last = 0;
+	SG_uint64 start;
+	SG_uint32 lo, hi;
+	SG_uint32 h;
+	SG_uint32 i;
+
+	*pSourcePosition = default_position;
+
+	if (len_target < pThis->block_size)
+	{
+		return;
+	}
+
+	h = sg_vcdiff_srcindex__hash(pTarget, pThis->block_size);
+	for (i = 0; ; i++)
+	{
+		SG_uint64 offset;
+
+		if (sg_vcdiff_srcindex__find(pThis, h, &offset))
+		{
+			pThis->Hits[count_hits++] = offset;
+			if ((offset >= default_position) && (offset + pThis->block_size <= default_position + window_size))
+			{
+				count_default++;
+			}
+		}
+
+		if (i + pThis->block_size >= len_target)
+		{
+			break;
+		}
+
+		h = (h - pTarget[i] * pThis->pow) * _SG_VCDIFF_ROLL_MULT + pTarget[i + pThis->block_size];
+	}
+
+	if (0 == count_hits)
+	{
+		return;
+	}
+
+	// find the window_size stretch of source with the most hits in it
+	qsort(pThis->Hits, count_hits, sizeof(SG_uint64), sg_vcdiff_srcindex__compare_offsets);
+
+	for (lo = 0, hi = 0; lo < count_hits; lo++)
+	{
+		while ((hi < count_hits) && (pThis->Hits[hi] + pThis->block_size <= pThis->Hits[lo] + window_size))
+		{
+			hi++;
+		}
+
+		if (hi - lo > best_count)
+		{
+			best_count = hi - lo;
+			best_first = pThis->Hits[lo];
+			best_last = pThis->Hits[hi - 1] + pThis->block_size;
+		}
+	}
+
+	// moving over by a little to pick up a few more blocks usually
+	// loses as much at the other end.  only move for a real gain.
+	if (best_count <= count_default + count_default / 8)
+	{
+		return;
+	}
+
+	// center the hits in the segment, so the matches can be extended
+	// in both directions.
+	start = (window_size - (best_last - best_first)) / 2;
+	start = (best_first > start) ? (best_first - start) : 0;
+	if (start + window_size > source_length)
+	{
+		start = source_length - window_size;
+	}
+
+	*pSourcePosition = start;
+}
+
 void sg_vcdiff_encoder__process_window_buffer(SG_context* pCtx, sg_vcdiff_encoder* pThis)
 {
     SG_bool addMode = SG_FALSE;
@@ -1643,6 +2037,7 @@ fail:
 void sg_vcdiff_encoder__create(SG_context* pCtx, sg_vcdiff_encoder* pThis, SG_uint64 targetPosition, SG_uint64 source_length, SG_uint32 window_size)
 {
 	sg_vcdiff_window* pw = pThis->Window;
+	SG_bool bTargetAlreadyRead = SG_FALSE;
 
     // set up the window header
     pw->TargetWinSize = window_size;
@@ -1660,6 +2055,35 @@ void sg_vcdiff_encoder__create(SG_context* pCtx, sg_vcdiff_encoder* pThis, SG_ui
 		pw->SourcePosition = 0;
 		pw->SourceSize = (SG_uint32)source_length;	// cast for VS2005
 	}
+	else if (pThis->SourceIndex)
+	{
+		SG_uint32 got = 0;
+
+		/*
+		  Read the target first, into the back half of
+		  the buffer (which is exactly where it belongs,
+		  since the source segment will be a whole
+		  window), so we can choose the part of the
+		  source it has the most in common with.
+		*/
+		SG_readstream__read(pCtx, pThis->TargetAccessor, window_size, pw->WindowBuffer + window_size, &got, NULL);
+		SG_ERR_CHECK_CURRENT_DISREGARD(SG_ERR_EOF);
+		pw->TargetWinSize = got;
+		bTargetAlreadyRead = SG_TRUE;
+
+		if (0 == got)
+		{
+			return;
+		}
+
+		// unless the index finds somewhere better, use the same
+		// position as the windowed method would.
+		sg_vcdiff_srcindex__choose_source(pThis->SourceIndex, pw->WindowBuffer + window_size, got, window_size, source_length,
+			(targetPosition + window_size <= source_length) ? targetPosition : (source_length - window_size),
+			&pw->SourcePosition);
+
+		pw->SourceSize = window_size;
+	}
 	else
 	{
 		SG_uint64 source_avail;
@@ -1703,7 +2127,7 @@ void sg_vcdiff_encoder__create(SG_context* pCtx, sg_vcdiff_encoder* pThis, SG_ui
 	pw->WindowBufferLength = pw->SourceSize + pw->TargetWinSize;
 
 	// read the source and target data into the window buffer
-	SG_ERR_CHECK(  sg_vcdiff_encoder__init_window_buffer(pCtx, pThis)  );
+	SG_ERR_CHECK(  sg_vcdiff_encoder__init_window_buffer(pCtx, pThis, bTargetAlreadyRead)  );
 
     // process the source and target
 	SG_ERR_CHECK(  sg_vcdiff_encoder__process_window_buffer(pCtx, pThis)  );
@@ -1713,12 +2137,14 @@ fail:
 	return;
 }
 
-void sg_vcdiff__create(SG_context* pCtx, SG_seekreader* SourceAccessor, SG_uint64 source_length, SG_readstream* TargetAccessor, SG_writestream* DeltaAccessor, SG_uint32 window_size, const sg_vcdiff_hashconfig* pHashConfig_Source, const sg_vcdiff_hashconfig* pHashConfig_Target)
+void sg_vcdiff__create(SG_context* pCtx, SG_seekreader* SourceAccessor, SG_uint64 source_length, SG_readstream* TargetAccessor, SG_writestream* DeltaAccessor, const SG_vcdiff_options* pOptions, const sg_vcdiff_hashconfig* pHashConfig_Source, const sg_vcdiff_hashconfig* pHashConfig_Target)
 {
     SG_uint64 size = 0;
 	sg_vcdiff_window window;
 	sg_vcdiff_hash* pSourceHash = NULL;
 	sg_vcdiff_hash* pTargetHash = NULL;
+	sg_vcdiff_srcindex* pSourceIndex = NULL;
+	SG_uint32 window_size = pOptions->window_size;
 
     if (0 == source_length)
     {
@@ -1733,6 +2159,12 @@ void sg_vcdiff__create(SG_context* pCtx, SG_seekreader* SourceAccessor, SG_uint6
 	SG_ERR_CHECK(  sg_vcdiff__hash__alloc(pCtx, pHashConfig_Source,&pSourceHash)  );
 	SG_ERR_CHECK(  sg_vcdiff__hash__alloc(pCtx, pHashConfig_Target,&pTargetHash)  );
 
+	// a source that fits in one window gets used whole anyway
+	if ((SG_VCDIFF_METHOD__WHOLE_SOURCE == pOptions->method) && (source_length > window_size))
+	{
+		SG_ERR_CHECK(  sg_vcdiff_srcindex__alloc(pCtx, SourceAccessor, source_length, pOptions, window.WindowBuffer, 2 * window_size, &pSourceIndex)  );
+	}
+
     // process each window
     while(SG_TRUE)
 	{
@@ -1740,7 +2172,7 @@ void sg_vcdiff__create(SG_context* pCtx, SG_seekreader* SourceAccessor, SG_uint6
 
 		{
 			sg_vcdiff_encoder windowEncoder;
-			sg_vcdiff_encoder__init(&windowEncoder, &window, DeltaAccessor, TargetAccessor, SourceAccessor, pSourceHash, pTargetHash);
+			sg_vcdiff_encoder__init(&windowEncoder, &window, DeltaAccessor, TargetAccessor, SourceAccessor, pSourceHash, pTargetHash, pSourceIndex);
 			SG_ERR_CHECK(  sg_vcdiff_encoder__create(pCtx, &windowEncoder, size, source_length, window_size)  );
 		}
 
@@ -1756,6 +2188,7 @@ void sg_vcdiff__create(SG_context* pCtx, SG_seekreader* SourceAccessor, SG_uint6
 
 	sg_vcdiff__hash__free(pCtx, pSourceHash);
 	sg_vcdiff__hash__free(pCtx, pTargetHash);
+	sg_vcdiff_srcindex__free(pCtx, pSourceIndex);
 
 	sg_vcdiff_window__free_buffers(pCtx,&window);
 
@@ -1763,6 +2196,7 @@ void sg_vcdiff__create(SG_context* pCtx, SG_seekreader* SourceAccessor, SG_uint6
 
 fail:
 	SG_ERR_IGNORE(  sg_vcdiff_window__free_buffers(pCtx,&window)  );
+	SG_ERR_IGNORE(  sg_vcdiff_srcindex__free(pCtx, pSourceIndex)  );
 
 	if (pSourceHash)
 	{
@@ -1776,43 +2210,77 @@ fail:
 
 }
 
-void sg_vcdiff__deltify(SG_context* pCtx, SG_seekreader* psrSource, SG_readstream* pstrmTarget, SG_writestream* pstrmDelta, SG_uint32 window_size, sg_vcdiff_hashconfig* pshc, sg_vcdiff_hashconfig* pthc)
+void sg_vcdiff__deltify(SG_context* pCtx, SG_seekreader* psrSource, SG_readstream* pstrmTarget, SG_writestream* pstrmDelta, const SG_vcdiff_options* pOptions, sg_vcdiff_hashconfig* pshc, sg_vcdiff_hashconfig* pthc)
 {
 	SG_uint64 source_length = 0;
 
 	SG_ERR_CHECK(  SG_seekreader__length(pCtx, psrSource, &source_length)  );
 
-	SG_ERR_CHECK(  sg_vcdiff__create(pCtx, psrSource, source_length, pstrmTarget, pstrmDelta, window_size, pshc, pthc)  );
+	SG_ERR_CHECK(  sg_vcdiff__create(pCtx, psrSource, source_length, pstrmTarget, pstrmDelta, pOptions, pshc, pthc)  );
 
 fail:
 	return;
 }
 
-void SG_vcdiff__deltify__streams(SG_context* pCtx, SG_seekreader* psrSource, SG_readstream* pstrmTarget, SG_writestream* pstrmDelta)
+void SG_vcdiff__options__init(SG_context* pCtx, SG_vcdiff_options* pOptions, SG_uint32 method)
 {
+	SG_NULLARGCHECK_RETURN(pOptions);
+	SG_ARGCHECK_RETURN( (SG_VCDIFF_METHOD__WINDOW == method) || (SG_VCDIFF_METHOD__WHOLE_SOURCE == method), method );
+
+	pOptions->method = method;
+	pOptions->window_size = _SG_VCDIFF_DEFAULT_WINDOW_SIZE;
+	pOptions->slots_per_bucket = SG_VCDIFF_DEFAULT_SLOTS_PER_BUCKET;
+	pOptions->block_size = SG_VCDIFF_DEFAULT_BLOCK_SIZE;
+	pOptions->max_blocks = SG_VCDIFF_DEFAULT_MAX_BLOCKS;
+}
+
+void SG_vcdiff__deltify__streams__options(SG_context* pCtx, SG_seekreader* psrSource, SG_readstream* pstrmTarget, SG_writestream* pstrmDelta, const SG_vcdiff_options* pOptions)
+{
+	SG_vcdiff_options defaults;
 	sg_vcdiff_hashconfig shc;
 	sg_vcdiff_hashconfig thc;
-	SG_uint32 window_size = _SG_VCDIFF_DEFAULT_WINDOW_SIZE;
+
+	if (!pOptions)
+	{
+		SG_ERR_CHECK(  SG_vcdiff__options__init(pCtx, &defaults, SG_VCDIFF_METHOD__WINDOW)  );
+		pOptions = &defaults;
+	}
+
+	SG_ARGCHECK_RETURN( (SG_VCDIFF_METHOD__WINDOW == pOptions->method) || (SG_VCDIFF_METHOD__WHOLE_SOURCE == pOptions->method), pOptions->method );
+	SG_ARGCHECK_RETURN( (pOptions->window_size >= 1024) && (pOptions->window_size <= SG_VCDIFF_MAX_WINDOW_SIZE), pOptions->window_size );
+	SG_ARGCHECK_RETURN( (pOptions->slots_per_bucket > 0) && (pOptions->slots_per_bucket <= 256), pOptions->slots_per_bucket );
+	SG_ARGCHECK_RETURN( (pOptions->block_size >= 4) && (pOptions->block_size <= pOptions->window_size), pOptions->block_size );
+	SG_ARGCHECK_RETURN( (pOptions->max_blocks > 0), pOptions->max_blocks );
 
 	shc.key_size = 4;
 	shc.step_size = 1;
-	shc.slots_per_bucket = 4;
-	shc.num_buckets = window_size / shc.step_size / shc.slots_per_bucket;
+	shc.slots_per_bucket = (SG_uint16)pOptions->slots_per_bucket;
+	shc.num_buckets = pOptions->window_size / shc.step_size / shc.slots_per_bucket;
 	shc.enough = 1024;
 
 	thc.key_size = 4;
 	thc.step_size = 1;
-	thc.slots_per_bucket = 4;
-	thc.num_buckets = window_size / thc.step_size / thc.slots_per_bucket;
+	thc.slots_per_bucket = (SG_uint16)pOptions->slots_per_bucket;
+	thc.num_buckets = pOptions->window_size / thc.step_size / thc.slots_per_bucket;
 	thc.enough = 32;
 
-	SG_ERR_CHECK(  sg_vcdiff__deltify(pCtx, psrSource, pstrmTarget, pstrmDelta, window_size, &shc, &thc)  );
+	SG_ERR_CHECK(  sg_vcdiff__deltify(pCtx, psrSource, pstrmTarget, pstrmDelta, pOptions, &shc, &thc)  );
 
 fail:
 	return;
 }
 
+void SG_vcdiff__deltify__streams(SG_context* pCtx, SG_seekreader* psrSource, SG_readstream* pstrmTarget, SG_writestream* pstrmDelta)
+{
+	SG_ERR_CHECK_RETURN(  SG_vcdiff__deltify__streams__options(pCtx, psrSource, pstrmTarget, pstrmDelta, NULL)  );
+}
+
 void SG_vcdiff__deltify__files(SG_context* pCtx, SG_pathname* pPathSource, SG_pathname* pPathTarget, SG_pathname* pPathDelta)
+{
+	SG_ERR_CHECK_RETURN(  SG_vcdiff__deltify__files__options(pCtx, pPathSource, pPathTarget, pPathDelta, NULL)  );
+}
+
+void SG_vcdiff__deltify__files__options(SG_context* pCtx, SG_pathname* pPathSource, SG_pathname* pPathTarget, SG_pathname* pPathDelta, const SG_vcdiff_options* pOptions)
 {
 	SG_seekreader* pFile_Source = NULL;
 	SG_readstream* pFile_Target = NULL;
@@ -1824,16 +2292,18 @@ void SG_vcdiff__deltify__files(SG_context* pCtx, SG_pathname* pPathSource, SG_pa
 
     SG_ERR_CHECK(  SG_writestream__alloc__for_file(pCtx, pPathDelta, &pFile_Delta)  );
 
-	SG_ERR_CHECK(  SG_vcdiff__deltify__streams(pCtx, pFile_Source, pFile_Target, pFile_Delta)  );
+	SG_ERR_CHECK(  SG_vcdiff__deltify__streams__options(pCtx, pFile_Source, pFile_Target, pFile_Delta, pOptions)  );
 
-	SG_ERR_CHECK(  SG_seekreader__close(pCtx, pFile_Source)  );
+	SG_seekreader__close(pCtx, pFile_Source);
 	pFile_Source = NULL;
+	SG_ERR_CHECK_CURRENT;
 
 	SG_ERR_CHECK(  SG_readstream__close(pCtx, pFile_Target)  );
 	pFile_Target = NULL;
 
-	SG_ERR_CHECK(  SG_writestream__close(pCtx, pFile_Delta)  );
+	SG_writestream__close(pCtx, pFile_Delta);
 	pFile_Delta = NULL;
+	SG_ERR_CHECK_CURRENT;
 
 	return;
 
@@ -1868,11 +2338,13 @@ void SG_vcdiff__undeltify__files(SG_context* pCtx, SG_pathname* pPathSource, SG_
 
 	SG_ERR_CHECK(  SG_vcdiff__undeltify__streams(pCtx, pFile_Source, pFile_Target, pFile_Delta)  );
 
-	SG_ERR_CHECK(  SG_seekreader__close(pCtx, pFile_Source)  );
+	SG_seekreader__close(pCtx, pFile_Source);
 	pFile_Source = NULL;
+	SG_ERR_CHECK_CURRENT;
 
-	SG_ERR_CHECK(  SG_writestream__close(pCtx, pFile_Target)  );
+	SG_writestream__close(pCtx, pFile_Target);
 	pFile_Target = NULL;
+	SG_ERR_CHECK_CURRENT;
 
 	SG_ERR_CHECK(  SG_readstream__close(pCtx, pFile_Delta)  );
 	pFile_Delta = NULL;
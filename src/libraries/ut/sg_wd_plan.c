@@ -914,27 +914,35 @@ fail:
 	SG_PATHNAME_NULLFREE(pCtx, pPath);
 }
 
+#undef DCLVERB
+
+// the get_file and alter_file verbs also get the temp file that the
+// fetch pool wrote the content into.
+
+#define MY_COPY_CHUNK		(64 * 1024)
+
+#define DCLVERB(fn) static void fn(SG_context * pCtx, const SG_vhash * pvhItem, SG_pendingtree * pPendingTree, const SG_pathname * pPathFetched)
+
 DCLVERB(fn_get_file)			// Fetch a FILE from the REPO and do a special ADD with existing GID.
 {
 	SG_pathname * pPath = NULL;
-	SG_file * pFile = NULL;
 	SG_repo * pRepo;
 	const char * pszGid;
-	const char * pszHid_Blob;
 	const char * pszHid_XAttrs;
 	SG_int64 attrBits;
 
 	FETCHPATH("path_destination", &pPath);
 	FETCHSZ(  "gid",              &pszGid);
-	FETCHSZ(  "hid",              &pszHid_Blob);
 	FETCHSZ(  "xattrs",           &pszHid_XAttrs);
 	FETCHI64( "attrbits",         &attrBits);
 
 	SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pPendingTree, &pRepo)  );
 
-	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPath, SG_FILE_WRONLY|SG_FILE_CREATE_NEW, 0600, &pFile)  );
-	SG_ERR_CHECK(  SG_repo__fetch_blob_into_file(pCtx, pRepo, pszHid_Blob, pFile, NULL)  );
-	SG_FILE_NULLCLOSE(pCtx, pFile);
+	// the fetch pool has already written the content into a temp
+	// file; move it into place.  this must fail rather than replace
+	// anything that is already at pPath (such as a file that the user
+	// created after the plan was built).
+	SG_ERR_CHECK(  SG_fsobj__move_new_file__pathname_pathname(pCtx, pPathFetched, pPath)  );
 
 	// set attrbits and xattrs (if there are any).
 	// don't bother clearing XAttrs since we just created it and it won't have any.
@@ -947,9 +955,90 @@ DCLVERB(fn_get_file)			// Fetch a FILE from the REPO and do a special ADD with e
 
 fail:
 	SG_PATHNAME_NULLFREE(pCtx, pPath);
+}
+
+//////////////////////////////////////////////////////////////////
+
+DCLVERB(fn_alter_file)			// convert existing WD/baseline FILE to final-result
+{
+	SG_pathname * pPathSrc  = NULL;
+	SG_pathname * pPathDest = NULL;
+	SG_file * pFileFetched = NULL;
+	SG_file * pFile = NULL;
+	SG_byte * pBuf = NULL;
+	SG_uint32 nrBytes;
+	SG_repo * pRepo;
+	const char * pszHid_XAttrs_Src;
+	const char * pszHid_XAttrs_Dest;
+	SG_int64 attrBits_Src;
+	SG_int64 attrBits_Dest;
+
+	FETCHPATH("path_finalresult",     &pPathDest);
+	FETCHPATH("path_baseline",        &pPathSrc);
+	FETCHSZ(  "xattrs_finalresult",   &pszHid_XAttrs_Dest);
+	FETCHSZ(  "xattrs_baseline",      &pszHid_XAttrs_Src);
+	FETCHI64( "attrbits_finalresult", &attrBits_Dest);
+	FETCHI64( "attrbits_baseline",    &attrBits_Src);
+
+	SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pPendingTree, &pRepo)  );
+
+	// I know this sounds stupid, but there are a few
+	// strange/redundant things here that are necessary
+	// yet look like they could be omitted.
+	//
+	// [1] MOVE, RENAME, or MOVE+RENAME the file from pPathSrc to
+	//     pPathDest.  The WD disk move is the stupid part, but we
+	//     need to do this for the side-effects on the pendingtree.
+
+	SG_ERR_CHECK(  _do_move_rename(pCtx, pPendingTree, pPathSrc, pPathDest)  );
+
+	// [2] truncate pPathDest and copy in the content of the
+	//     final-result that the fetch pool wrote into a temp file.
+	//     we copy rather than move the temp file into place so that
+	//     pPathDest keeps the attrbits/xattrs of the baseline.
+
+	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathFetched, SG_FILE_RDONLY|SG_FILE_OPEN_EXISTING, 0600, &pFileFetched)  );
+	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathDest, SG_FILE_WRONLY|SG_FILE_OPEN_EXISTING|SG_FILE_TRUNC, 0600, &pFile)  );
+	SG_ERR_CHECK(  SG_allocN(pCtx, MY_COPY_CHUNK, pBuf)  );
+	while (1)
+	{
+		SG_file__read(pCtx, pFileFetched, MY_COPY_CHUNK, pBuf, &nrBytes);
+		if (SG_context__err_equals(pCtx, SG_ERR_EOF) || (nrBytes == 0))
+		{
+			SG_context__err_reset(pCtx);
+			break;
+		}
+		SG_ERR_CHECK_CURRENT;
+
+		SG_ERR_CHECK(  SG_file__write(pCtx, pFile, nrBytes, pBuf, NULL)  );
+	}
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+	SG_FILE_NULLCLOSE(pCtx, pFileFetched);
+	SG_ERR_CHECK(  SG_fsobj__remove__pathname(pCtx, pPathFetched)  );
+
+	// [3] apply any changes in attrbits/xattrs.  But since we did
+	//     the MOVE/RENAME in [1] the file should still have the
+	//     settings from the baseline, so we only need to do this
+	//     if they are different.
+
+	if (attrBits_Src != attrBits_Dest)
+		SG_ERR_CHECK(  SG_attributes__bits__apply(pCtx, pPathDest, attrBits_Dest)  );
+	if (_my_equal(pszHid_XAttrs_Src, pszHid_XAttrs_Dest))
+		SG_ERR_CHECK(  _apply_xattrs(pCtx, pRepo, pPathDest, pszHid_XAttrs_Dest, SG_TRUE)  );
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPathDest);
+	SG_PATHNAME_NULLFREE(pCtx, pPathSrc);
 	SG_FILE_NULLCLOSE(pCtx, pFile);
+	SG_FILE_NULLCLOSE(pCtx, pFileFetched);
+	SG_NULLFREE(pCtx, pBuf);
 }
 
+#undef MY_COPY_CHUNK
+#undef DCLVERB
+
+#define DCLVERB(fn) static void fn(SG_context * pCtx, const SG_vhash * pvhItem, SG_pendingtree * pPendingTree)
+
 DCLVERB(fn_get_file_auto_merge)			// Fetch a FILE from an auto-merge-result and do a special ADD with existing GID.
 {
 	SG_pathname * pPath = NULL;
@@ -1060,61 +1149,6 @@ fail:
 
 //////////////////////////////////////////////////////////////////
 
-DCLVERB(fn_alter_file)			// convert existing WD/baseline FILE to final-result
-{
-	SG_pathname * pPathSrc  = NULL;
-	SG_pathname * pPathDest = NULL;
-	SG_file * pFile = NULL;
-	SG_repo * pRepo;
-	const char * pszHid_Blob;
-	const char * pszHid_XAttrs_Src;
-	const char * pszHid_XAttrs_Dest;
-	SG_int64 attrBits_Src;
-	SG_int64 attrBits_Dest;
-
-	FETCHPATH("path_finalresult",     &pPathDest);
-	FETCHPATH("path_baseline",        &pPathSrc);
-	FETCHSZ(  "hid_finalresult",      &pszHid_Blob);
-	FETCHSZ(  "xattrs_finalresult",   &pszHid_XAttrs_Dest);
-	FETCHSZ(  "xattrs_baseline",      &pszHid_XAttrs_Src);
-	FETCHI64( "attrbits_finalresult", &attrBits_Dest);
-	FETCHI64( "attrbits_baseline",    &attrBits_Src);
-
-	SG_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pPendingTree, &pRepo)  );
-
-	// I know this sounds stupid, but there are a few
-	// strange/redundant things here that are necessary
-	// yet look like they could be omitted.
-	//
-	// [1] MOVE, RENAME, or MOVE+RENAME the file from pPathSrc to
-	//     pPathDest.  The WD disk move is the stupid part, but we
-	//     need to do this for the side-effects on the pendingtree.
-
-	SG_ERR_CHECK(  _do_move_rename(pCtx, pPendingTree, pPathSrc, pPathDest)  );
-
-	// [2] truncate pPathDest and fetch the content from the repo
-	//     using the HID of the final-result.
-
-	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathDest, SG_FILE_WRONLY|SG_FILE_OPEN_EXISTING|SG_FILE_TRUNC, 0600, &pFile)  );
-	SG_ERR_CHECK(  SG_repo__fetch_blob_into_file(pCtx, pRepo, pszHid_Blob, pFile, NULL)  );
-	SG_FILE_NULLCLOSE(pCtx, pFile);
-
-	// [3] apply any changes in attrbits/xattrs.  But since we did
-	//     the MOVE/RENAME in [1] the file should still have the
-	//     settings from the baseline, so we only need to do this
-	//     if they are different.
-
-	if (attrBits_Src != attrBits_Dest)
-		SG_ERR_CHECK(  SG_attributes__bits__apply(pCtx, pPathDest, attrBits_Dest)  );
-	if (_my_equal(pszHid_XAttrs_Src, pszHid_XAttrs_Dest))
-		SG_ERR_CHECK(  _apply_xattrs(pCtx, pRepo, pPathDest, pszHid_XAttrs_Dest, SG_TRUE)  );
-
-fail:
-	SG_PATHNAME_NULLFREE(pCtx, pPathDest);
-	SG_PATHNAME_NULLFREE(pCtx, pPathSrc);
-	SG_FILE_NULLCLOSE(pCtx, pFile);
-}
-
 DCLVERB(fn_alter_file_auto_merge)	// convert existing WD/baseline FILE to final-result (but use auto-merge-result for content)
 {
 	SG_pathname * pPathSrc  = NULL;
@@ -1272,24 +1306,144 @@ fail:
 
 //////////////////////////////////////////////////////////////////
 
+/**
+ * State while executing a plan.
+ *
+ * The content of the get_file and alter_file steps is written into
+ * temp files by a fetch pool, which fetches and decodes the blobs on
+ * worker threads.  The steps themselves still run one at a time, in
+ * order, on this thread: they change the pendingtree and may move the
+ * directories that those files end up in.  They just move (or copy)
+ * the temp file into place instead of fetching it.
+ *
+ * The pool only runs MY_FETCH_AHEAD files ahead of the script, so the
+ * temp dir never holds more than that many files.
+ */
+#define MY_FETCH_AHEAD		16
+
+struct _sg_wd_plan_exec
+{
+	SG_pendingtree *		pPendingTree;
+	const SG_varray *		pvaScript;			// we do not own this
+	SG_uint32				nrSteps;
+
+	SG_fetch_pool *			pPool;				// allocated with the first step that fetches
+	SG_pathname *			pPathTempDir;		// "<wd-top>/.sgtemp/fetch_<date>_<k>/"
+	SG_pathname **			aPathFetched;		// indexed by step; NULL for steps that don't fetch a file
+	SG_uint32				kNextStep;			// the next step to consider queueing on the pool
+	SG_uint32				nrInFlight;			// files queued but not yet taken by their step
+};
+
+static void _exec__get_fetch_hid(SG_context * pCtx, const SG_vhash * pvhItem, const char ** ppszHid)
+{
+	const char * pszValue_Action;
+
+	*ppszHid = NULL;
+
+	SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvhItem, "action", &pszValue_Action)  );
+	if (strcmp(pszValue_Action, "get_file") == 0)
+		SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvhItem, "hid", ppszHid)  );
+	else if (strcmp(pszValue_Action, "alter_file") == 0)
+		SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvhItem, "hid_finalresult", ppszHid)  );
+}
+
+/**
+ * Queue the content of upcoming get_file/alter_file steps on the pool until
+ * MY_FETCH_AHEAD of them are in flight.
+ */
+static void _exec__fetch_ahead(SG_context * pCtx, struct _sg_wd_plan_exec * pExec)
+{
+	SG_repo * pRepo;
+	const SG_pathname * pPathWorkingDirectoryTop;
+	char bufName[20];
+
+	while ((pExec->nrInFlight < MY_FETCH_AHEAD) && (pExec->kNextStep < pExec->nrSteps))
+	{
+		SG_vhash * pvhItem;
+		const char * pszHid = NULL;
+		SG_uint32 k = pExec->kNextStep++;
+
+		SG_ERR_CHECK_RETURN(  SG_varray__get__vhash(pCtx, pExec->pvaScript, k, &pvhItem)  );
+		SG_ERR_CHECK_RETURN(  _exec__get_fetch_hid(pCtx, pvhItem, &pszHid)  );
+		if (!pszHid)
+			continue;
+
+		if (!pExec->pPool)
+		{
+			SG_ERR_CHECK_RETURN(  SG_pendingtree__get_repo(pCtx, pExec->pPendingTree, &pRepo)  );
+			SG_ERR_CHECK_RETURN(  SG_pendingtree__get_working_directory_top__ref(pCtx, pExec->pPendingTree, &pPathWorkingDirectoryTop)  );
+			SG_ERR_CHECK_RETURN(  SG_workingdir__generate_and_create_temp_dir_for_purpose(pCtx,
+																						  pPathWorkingDirectoryTop,
+																						  "fetch",
+																						  &pExec->pPathTempDir)  );
+			SG_ERR_CHECK_RETURN(  SG_fetch_pool__alloc(pCtx, pRepo, &pExec->pPool)  );
+		}
+
+		SG_ERR_CHECK_RETURN(  SG_sprintf(pCtx, bufName, sizeof(bufName), "%d", k)  );
+		SG_ERR_CHECK_RETURN(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pExec->aPathFetched[k], pExec->pPathTempDir, bufName)  );
+		SG_ERR_CHECK_RETURN(  SG_fetch_pool__add(pCtx, pExec->pPool, pExec->aPathFetched[k], 0600, pszHid,
+												 SG_FETCH_POOL_FLAGS__NONE, 0, NULL, NULL)  );
+		pExec->nrInFlight++;
+	}
+}
+
+/**
+ * Wait for the pool to finish the temp file for this step and
+ * queue another one in its place.  The pool hands the files back in the
+ * order they were queued, which is the order of the steps.
+ */
+static void _exec__take_fetched(SG_context * pCtx, struct _sg_wd_plan_exec * pExec, SG_uint32 ndx)
+{
+	SG_uint32 iItem;
+	SG_bool bFound = SG_FALSE;
+
+	SG_ASSERT(  pExec->aPathFetched[ndx]  );
+
+	SG_ERR_CHECK_RETURN(  SG_fetch_pool__next_done(pCtx, pExec->pPool, &iItem, &bFound)  );
+	SG_ASSERT(  bFound  );
+	pExec->nrInFlight--;
+
+	SG_ERR_CHECK_RETURN(  _exec__fetch_ahead(pCtx, pExec)  );
+}
+
+static void _exec__cleanup(SG_context * pCtx, struct _sg_wd_plan_exec * pExec)
+{
+	SG_uint32 k;
+
+	// stop the pool before we delete the files it may be writing.
+	SG_FETCH_POOL_NULLFREE(pCtx, pExec->pPool);
+
+	if (pExec->pPathTempDir)
+		SG_ERR_IGNORE(  SG_fsobj__rmdir_recursive__pathname(pCtx, pExec->pPathTempDir)  );
+	SG_PATHNAME_NULLFREE(pCtx, pExec->pPathTempDir);
+
+	if (pExec->aPathFetched)
+	{
+		for (k=0; k<pExec->nrSteps; k++)
+			SG_PATHNAME_NULLFREE(pCtx, pExec->aPathFetched[k]);
+		SG_NULLFREE(pCtx, pExec->aPathFetched);
+	}
+}
+
 static SG_varray_foreach_callback _execute_cb;
 
 void _execute_cb(SG_context * pCtx,
 				 void * pVoidData,
 				 SG_UNUSED_PARAM( const SG_varray * pva ),
-				 SG_UNUSED_PARAM( SG_uint32 ndx ),
+				 SG_uint32 ndx,
 				 const SG_variant * pv)
 {
-	SG_pendingtree * pPendingTree = (SG_pendingtree *)pVoidData;
+	struct _sg_wd_plan_exec * pExec = (struct _sg_wd_plan_exec *)pVoidData;
+	SG_pendingtree * pPendingTree = pExec->pPendingTree;
 	SG_vhash * pvhItem;
 	const char * pszValue_Action;
 
 	SG_UNUSED( pva );
-	SG_UNUSED( ndx );
 
 	SG_ERR_CHECK_RETURN(  SG_variant__get__vhash(pCtx, pv, &pvhItem)  );
 	SG_ERR_CHECK_RETURN(  SG_vhash__get__sz(pCtx, pvhItem, "action", &pszValue_Action)  );
 
+#define IFVERB_FETCHED(v,fn)	SG_STATEMENT( if (strcmp(pszValue_Action,(v))==0) { SG_ERR_CHECK_RETURN(  _exec__take_fetched(pCtx, pExec, ndx)  ); SG_ERR_CHECK_RETURN(  (fn)(pCtx, pvhItem, pPendingTree, pExec->aPathFetched[ndx])  ); return; } )
 #define IFVERB(v,fn)	SG_STATEMENT( if (strcmp(pszValue_Action,(v))==0) { SG_ERR_CHECK_RETURN(  (fn)(pCtx, pvhItem, pPendingTree)  ); return; } )
 
 	IFVERB("move_rename",             fn_move_rename);
@@ -1298,12 +1452,12 @@ void _execute_cb(SG_context * pCtx,
 	IFVERB("remove_symlink",          fn_remove_generic);	// entries can be handled by the
 	IFVERB("remove_directory",        fn_remove_generic);	// same routine.
 
-	IFVERB("get_file",                fn_get_file);
+	IFVERB_FETCHED("get_file",        fn_get_file);
 	IFVERB("get_file_auto_merge",     fn_get_file_auto_merge);
 	IFVERB("get_symlink",             fn_get_symlink);
 	IFVERB("get_directory",           fn_get_directory);
 
-	IFVERB("alter_file",              fn_alter_file);
+	IFVERB_FETCHED("alter_file",      fn_alter_file);
 	IFVERB("alter_file_auto_merge",   fn_alter_file_auto_merge);
 	IFVERB("alter_symlink",           fn_alter_symlink);
 	IFVERB("alter_directory",         fn_alter_directory);
@@ -1316,6 +1470,7 @@ void _execute_cb(SG_context * pCtx,
 	// TODO other commands....
 
 #undef IFVERB
+#undef IFVERB_FETCHED
 
 #if TRACE_WD_PLAN
 	SG_ERR_IGNORE(  SG_console(pCtx, SG_CS_STDERR, "TODO Unhandled VERB[%s]\n", pszValue_Action)  );
@@ -1326,10 +1481,28 @@ void _execute_cb(SG_context * pCtx,
 
 void SG_wd_plan__execute(SG_context * pCtx, const SG_wd_plan * pPlan, SG_pendingtree * pPendingTree)
 {
+	struct _sg_wd_plan_exec exec;
+
 	SG_NULLARGCHECK_RETURN( pPlan );
 	SG_NULLARGCHECK_RETURN( pPendingTree );
 
-	SG_ERR_CHECK_RETURN(  SG_varray__foreach(pCtx, pPlan->pvaScript, _execute_cb, (void *)pPendingTree)  );
+	memset(&exec, 0, sizeof(exec));
+	exec.pPendingTree = pPendingTree;
+	exec.pvaScript = pPlan->pvaScript;
+
+	SG_ERR_CHECK(  SG_varray__count(pCtx, pPlan->pvaScript, &exec.nrSteps)  );
+	if (exec.nrSteps > 0)
+	{
+		SG_ERR_CHECK(  SG_allocN(pCtx, exec.nrSteps, exec.aPathFetched)  );
+		SG_ERR_CHECK(  _exec__fetch_ahead(pCtx, &exec)  );
+	}
+
+	SG_ERR_CHECK(  SG_varray__foreach(pCtx, pPlan->pvaScript, _execute_cb, (void *)&exec)  );
+	if (exec.pPool)
+		SG_ERR_CHECK(  SG_fetch_pool__finish(pCtx, exec.pPool)  );
+
+fail:
+	_exec__cleanup(pCtx, &exec);
 }
 
 //////////////////////////////////////////////////////////////////
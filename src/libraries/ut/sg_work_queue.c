@@ -0,0 +1,448 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/**
+ *
+ * @file sg_work_queue.c
+ *
+ * @details Run a callback on a series of items on a pool of worker
+ * threads.  See sg_work_queue_typedefs.h.
+ *
+ * Items live in one singly-linked list, oldest first.  pNextToTake
+ * points at the first entry no worker has picked up yet.  Without
+ * SG_WORK_QUEUE_FLAGS__COLLECT a worker unlinks the entry when it
+ * takes it, so pHead == pNextToTake.  With it, entries stay on the
+ * list until SG_work_queue__next_done() hands them back, which lets
+ * the caller see them in the order it added them.
+ *
+ * Everything in the queue is protected by mtx.  The workers sleep
+ * on condWork; the caller's thread sleeps on condMain.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg.h>
+
+//////////////////////////////////////////////////////////////////
+
+typedef struct _sg_work_queue_entry
+{
+	void *							pItem;
+	SG_bool							bDone;
+	struct _sg_work_queue_entry *	pNext;
+} sg_work_queue_entry;
+
+typedef struct
+{
+	SG_work_queue *			pQueue;
+	SG_uint32				kThread;
+	SG_context *			pCtxWorker;
+	SG_thread				thread;
+} sg_work_queue_worker;
+
+struct _SG_work_queue
+{
+	SG_work_queue__callback *	pfn;
+	void *					pVoidData;
+	SG_work_queue_flags		flags;
+	SG_uint32				nrMaxPending;
+
+	SG_uint32				nrThreads;
+	SG_uint32				nrStarted;
+	sg_work_queue_worker *	aWorkers;
+
+	SG_mutex				mtx;
+	SG_cond					condWork;		// workers wait here for an item (or to be told to quit)
+	SG_cond					condMain;		// the caller waits here for room, a finished item or an error
+
+	sg_work_queue_entry *	pHead;
+	sg_work_queue_entry *	pNextToTake;
+	sg_work_queue_entry *	pTail;
+	SG_uint32				nrPending;		// entries nobody has picked up yet
+	SG_uint32				nrRunning;		// entries a worker is on right now
+
+	SG_bool					bStarted;		// the first add has started (or is starting) the workers
+	SG_bool					bClosed;		// no more adds; workers quit once the list is empty
+	SG_bool					bAbort;			// workers quit after their current item
+	SG_bool					bFinished;
+
+	SG_bool					bFailed;
+	SG_context *			pCtxErr;		// the first error raised by a worker, once bFailed
+};
+
+//////////////////////////////////////////////////////////////////
+
+static void _sg_work_queue__append(sg_work_queue_entry * pEntry, SG_work_queue * pQueue)
+{
+	if (pQueue->pTail)
+		pQueue->pTail->pNext = pEntry;
+	else
+		pQueue->pHead = pEntry;
+	pQueue->pTail = pEntry;
+
+	if (!pEntry->bDone && !pQueue->pNextToTake)
+		pQueue->pNextToTake = pEntry;
+}
+
+/**
+ * Give the caller the error that stopped the queue.
+ * Only call this once bFailed has been seen under the mutex;
+ * pCtxErr does not change after that.
+ */
+static void _sg_work_queue__throw_worker_err(SG_context * pCtx, const SG_work_queue * pQueue)
+{
+	(void) SG_context__err_copy(pCtx, pQueue->pCtxErr);
+	SG_ERR_RETHROW_RETURN;
+}
+
+static void _sg_work_queue__worker(void * pArg)
+{
+	sg_work_queue_worker * pWorker = (sg_work_queue_worker *)pArg;
+	SG_work_queue * pQueue = pWorker->pQueue;
+	SG_context * pCtx = pWorker->pCtxWorker;
+	SG_bool bCollect = ((pQueue->flags & SG_WORK_QUEUE_FLAGS__COLLECT) == SG_WORK_QUEUE_FLAGS__COLLECT);
+
+	SG_mutex__lock(&pQueue->mtx);
+	while (1)
+	{
+		sg_work_queue_entry * pEntry;
+
+		while (!pQueue->bAbort && !pQueue->pNextToTake && !pQueue->bClosed)
+			SG_cond__wait(&pQueue->condWork, &pQueue->mtx);
+
+		if (pQueue->bAbort || !pQueue->pNextToTake)
+			break;
+
+		pEntry = pQueue->pNextToTake;
+		pQueue->pNextToTake = pEntry->pNext;
+		pQueue->nrPending--;
+		pQueue->nrRunning++;
+		if (!bCollect)
+		{
+			pQueue->pHead = pQueue->pNextToTake;
+			if (!pQueue->pHead)
+				pQueue->pTail = NULL;
+		}
+		SG_cond__broadcast(&pQueue->condMain);		// there is room for another add
+		SG_mutex__unlock(&pQueue->mtx);
+
+		pQueue->pfn(pCtx, pWorker->kThread, pQueue->pVoidData, pEntry->pItem);
+
+		SG_mutex__lock(&pQueue->mtx);
+		pQueue->nrRunning--;
+		if (SG_context__has_err(pCtx))
+		{
+			if (!pQueue->bFailed)
+			{
+				(void) SG_context__err_copy(pQueue->pCtxErr, pCtx);
+				pQueue->bFailed = SG_TRUE;
+			}
+			pQueue->bAbort = SG_TRUE;
+			SG_context__err_reset(pCtx);
+			SG_cond__broadcast(&pQueue->condWork);
+		}
+		else if (bCollect)
+		{
+			pEntry->bDone = SG_TRUE;
+		}
+		SG_cond__broadcast(&pQueue->condMain);
+
+		if (!bCollect)
+			SG_NULLFREE(pCtx, pEntry);
+	}
+	SG_mutex__unlock(&pQueue->mtx);
+}
+
+/**
+ * Stop the workers and wait for them.  With bAbort they quit after
+ * their current item, otherwise once the list is empty.
+ */
+static void _sg_work_queue__stop(SG_context * pCtx, SG_work_queue * pQueue, SG_bool bAbort)
+{
+	SG_uint32 k;
+
+	SG_mutex__lock(&pQueue->mtx);
+	pQueue->bClosed = SG_TRUE;
+	if (bAbort)
+		pQueue->bAbort = SG_TRUE;
+	SG_cond__broadcast(&pQueue->condWork);
+	SG_mutex__unlock(&pQueue->mtx);
+
+	for (k=pQueue->nrStarted; k>0; k--)
+	{
+		SG_ERR_CHECK_RETURN(  SG_thread__join(pCtx, &pQueue->aWorkers[k-1].thread)  );
+		pQueue->nrStarted--;
+	}
+}
+
+static void _sg_work_queue__start(SG_context * pCtx, SG_work_queue * pQueue)
+{
+	SG_error err;
+
+	while (pQueue->nrStarted < pQueue->nrThreads)
+	{
+		sg_work_queue_worker * pWorker = &pQueue->aWorkers[pQueue->nrStarted];
+
+		pWorker->pQueue = pQueue;
+		pWorker->kThread = pQueue->nrStarted;
+		if (!pWorker->pCtxWorker)
+		{
+			err = SG_context__alloc(&pWorker->pCtxWorker);
+			if (SG_IS_ERROR(err))
+				SG_ERR_THROW_RETURN(  err  );
+		}
+		SG_ERR_CHECK_RETURN(  SG_thread__start(pCtx, &pWorker->thread, _sg_work_queue__worker, pWorker)  );
+		pQueue->nrStarted++;
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+
+void SG_work_queue__alloc(SG_context * pCtx,
+						  SG_uint32 nrMaxThreads,
+						  SG_uint32 nrMaxPending,
+						  SG_work_queue_flags flags,
+						  SG_work_queue__callback * pfn,
+						  void * pVoidData,
+						  SG_work_queue ** ppNew)
+{
+	SG_work_queue * pQueue = NULL;
+	SG_uint32 nrCPU;
+	SG_error err;
+
+	SG_NULLARGCHECK_RETURN(pfn);
+	SG_NULLARGCHECK_RETURN(ppNew);
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pQueue)  );
+	pQueue->pfn = pfn;
+	pQueue->pVoidData = pVoidData;
+	pQueue->flags = flags;
+	pQueue->nrMaxPending = nrMaxPending;
+
+	nrCPU = SG_thread__count_processors();
+	pQueue->nrThreads = ((nrMaxThreads < nrCPU) ? nrMaxThreads : nrCPU);
+	if (pQueue->nrThreads < 2)
+		pQueue->nrThreads = 0;
+
+	if (pQueue->nrThreads)
+	{
+		SG_ERR_CHECK(  SG_allocN(pCtx, pQueue->nrThreads, pQueue->aWorkers)  );
+
+		err = SG_context__alloc(&pQueue->pCtxErr);
+		if (SG_IS_ERROR(err))
+			SG_ERR_THROW(  err  );
+
+		SG_mutex__init(&pQueue->mtx);
+		SG_cond__init(&pQueue->condWork);
+		SG_cond__init(&pQueue->condMain);
+	}
+
+	*ppNew = pQueue;
+	return;
+
+fail:
+	if (pQueue)
+	{
+		SG_CONTEXT_NULLFREE(pQueue->pCtxErr);
+		SG_NULLFREE(pCtx, pQueue->aWorkers);
+		SG_NULLFREE(pCtx, pQueue);
+	}
+}
+
+void SG_work_queue__free(SG_context * pCtx, SG_work_queue * pQueue)
+{
+	SG_uint32 k;
+
+	if (!pQueue)
+		return;
+
+	if (pQueue->nrThreads)
+	{
+		if (pQueue->nrStarted)
+			SG_ERR_IGNORE(  _sg_work_queue__stop(pCtx, pQueue, SG_TRUE)  );
+
+		for (k=0; k<pQueue->nrThreads; k++)
+			SG_CONTEXT_NULLFREE(pQueue->aWorkers[k].pCtxWorker);
+		SG_NULLFREE(pCtx, pQueue->aWorkers);
+		SG_CONTEXT_NULLFREE(pQueue->pCtxErr);
+
+		SG_cond__destroy(&pQueue->condMain);
+		SG_cond__destroy(&pQueue->condWork);
+		SG_mutex__destroy(&pQueue->mtx);
+	}
+
+	while (pQueue->pHead)
+	{
+		sg_work_queue_entry * pEntry = pQueue->pHead;
+
+		pQueue->pHead = pEntry->pNext;
+		SG_NULLFREE(pCtx, pEntry);
+	}
+
+	SG_NULLFREE(pCtx, pQueue);
+}
+
+void SG_work_queue__get_thread_count(SG_context * pCtx,
+									 const SG_work_queue * pQueue,
+									 SG_uint32 * pnrThreads)
+{
+	SG_NULLARGCHECK_RETURN(pQueue);
+	SG_NULLARGCHECK_RETURN(pnrThreads);
+
+	*pnrThreads = pQueue->nrThreads;
+}
+
+void SG_work_queue__add(SG_context * pCtx,
+						SG_work_queue * pQueue,
+						void * pItem)
+{
+	sg_work_queue_entry * pEntry = NULL;
+	SG_bool bCollect;
+	SG_bool bStart;
+	SG_bool bFailed;
+
+	SG_NULLARGCHECK_RETURN(pQueue);
+	SG_ARGCHECK_RETURN(!pQueue->bFinished, pQueue);
+
+	bCollect = ((pQueue->flags & SG_WORK_QUEUE_FLAGS__COLLECT) == SG_WORK_QUEUE_FLAGS__COLLECT);
+
+	if (!pQueue->nrThreads)
+	{
+		SG_ERR_CHECK(  pQueue->pfn(pCtx, 0, pQueue->pVoidData, pItem)  );
+		if (bCollect)
+		{
+			SG_ERR_CHECK(  SG_alloc1(pCtx, pEntry)  );
+			pEntry->pItem = pItem;
+			pEntry->bDone = SG_TRUE;
+			_sg_work_queue__append(pEntry, pQueue);
+		}
+		return;
+	}
+
+	// a callback can add too, but only once the workers are running,
+	// so it never gets here with bStart set.
+	SG_mutex__lock(&pQueue->mtx);
+	bStart = !pQueue->bStarted;
+	pQueue->bStarted = SG_TRUE;
+	SG_mutex__unlock(&pQueue->mtx);
+	if (bStart)
+		SG_ERR_CHECK(  _sg_work_queue__start(pCtx, pQueue)  );
+
+	SG_ERR_CHECK(  SG_alloc1(pCtx, pEntry)  );
+	pEntry->pItem = pItem;
+
+	SG_mutex__lock(&pQueue->mtx);
+	while (!pQueue->bFailed && pQueue->nrMaxPending && (pQueue->nrPending >= pQueue->nrMaxPending))
+		SG_cond__wait(&pQueue->condMain, &pQueue->mtx);
+	bFailed = pQueue->bFailed;
+	if (!bFailed)
+	{
+		_sg_work_queue__append(pEntry, pQueue);
+		pQueue->nrPending++;
+		pEntry = NULL;
+		SG_cond__signal(&pQueue->condWork);
+	}
+	SG_mutex__unlock(&pQueue->mtx);
+
+	if (bFailed)
+		SG_ERR_CHECK(  _sg_work_queue__throw_worker_err(pCtx, pQueue)  );
+
+	return;
+
+fail:
+	SG_NULLFREE(pCtx, pEntry);
+}
+
+void SG_work_queue__next_done(SG_context * pCtx,
+							  SG_work_queue * pQueue,
+							  void ** ppItem)
+{
+	sg_work_queue_entry * pEntry = NULL;
+	SG_bool bFailed = SG_FALSE;
+
+	SG_NULLARGCHECK_RETURN(pQueue);
+	SG_NULLARGCHECK_RETURN(ppItem);
+	SG_ARGCHECK_RETURN(((pQueue->flags & SG_WORK_QUEUE_FLAGS__COLLECT) == SG_WORK_QUEUE_FLAGS__COLLECT), pQueue);
+
+	*ppItem = NULL;
+
+	if (pQueue->nrThreads)
+	{
+		SG_mutex__lock(&pQueue->mtx);
+		while (!pQueue->bFailed && pQueue->pHead && !pQueue->pHead->bDone)
+			SG_cond__wait(&pQueue->condMain, &pQueue->mtx);
+		bFailed = pQueue->bFailed;
+	}
+
+	if (!bFailed && pQueue->pHead)
+	{
+		pEntry = pQueue->pHead;
+		pQueue->pHead = pEntry->pNext;
+		if (!pQueue->pHead)
+			pQueue->pTail = NULL;
+	}
+
+	if (pQueue->nrThreads)
+		SG_mutex__unlock(&pQueue->mtx);
+
+	if (bFailed)
+		SG_ERR_CHECK_RETURN(  _sg_work_queue__throw_worker_err(pCtx, pQueue)  );
+
+	if (pEntry)
+	{
+		*ppItem = pEntry->pItem;
+		SG_NULLFREE(pCtx, pEntry);
+	}
+}
+
+void SG_work_queue__wait(SG_context * pCtx, SG_work_queue * pQueue)
+{
+	SG_bool bFailed;
+
+	SG_NULLARGCHECK_RETURN(pQueue);
+
+	if (!pQueue->nrThreads)
+		return;
+
+	SG_mutex__lock(&pQueue->mtx);
+	while (!pQueue->bFailed && (pQueue->pNextToTake || pQueue->nrRunning))
+		SG_cond__wait(&pQueue->condMain, &pQueue->mtx);
+	bFailed = pQueue->bFailed;
+	SG_mutex__unlock(&pQueue->mtx);
+
+	if (bFailed)
+		SG_ERR_CHECK_RETURN(  _sg_work_queue__throw_worker_err(pCtx, pQueue)  );
+}
+
+void SG_work_queue__finish(SG_context * pCtx, SG_work_queue * pQueue)
+{
+	SG_NULLARGCHECK_RETURN(pQueue);
+
+	if (pQueue->bFinished)
+		return;
+	pQueue->bFinished = SG_TRUE;
+
+	if (!pQueue->nrThreads)
+		return;
+
+	SG_ERR_CHECK_RETURN(  _sg_work_queue__stop(pCtx, pQueue, SG_FALSE)  );
+
+	// the workers are gone, so nobody else is looking at bFailed.
+	if (pQueue->bFailed)
+		SG_ERR_CHECK_RETURN(  _sg_work_queue__throw_worker_err(pCtx, pQueue)  );
+}
@@ -252,28 +252,39 @@ fail:
  * private structure RATHER than populating the working directory -- yeah, i know
  * that the vv verb is called GET (perhaps that is the problem).
  */
+/**
+ * State for populating a working directory.  Regular files are queued
+ * on the fetch pool, which fetches, decodes and writes them on worker
+ * threads.  Directories and symlinks are created on this thread, and
+ * so is the timestamp cache: while the walk is running we only note
+ * which pool item belongs to which GID.
+ */
+typedef struct
+{
+	SG_repo *			pRepo;
+	SG_fetch_pool *		pPool;
+	SG_vhash *			pvhPending;		// gid --> index of the file in pPool (only when recording timestamps)
+} sg_workingdir__get_state;
+
 static void _sg_workingdir__get_entry2(SG_context * pCtx,
-									   SG_repo * pRepo,
+									   sg_workingdir__get_state * pState,
 									   const SG_pathname * pPathSub,
 									   const char * pszGid,
 									   SG_treenode_entry_type type,
 									   const char * pszidHidContent,
 									   const char * pszidHidXattrs,
-									   SG_int64 iAttributeBits,
-									   SG_vhash * pvhTimestamps);
+									   SG_int64 iAttributeBits);
 
 static void _sg_workingdir__get_entry(SG_context* pCtx,
-									  SG_repo* pRepo,
+									  sg_workingdir__get_state * pState,
 									  const SG_pathname* pPathSub,
 									  const char * pszGid,
-									  const SG_treenode_entry* pEntry,
-									  SG_vhash * pvhTimestamps);
+									  const SG_treenode_entry* pEntry);
 
 static void _sg_workingdir__get_dir(SG_context* pCtx,
-									SG_repo* pRepo,
+									sg_workingdir__get_state * pState,
 									const SG_pathname* pPathLocal,
-									const char* pszidHidTreeNode,
-									SG_vhash * pvhTimestamps);
+									const char* pszidHidTreeNode);
 
 //////////////////////////////////////////////////////////////////
 
@@ -294,37 +305,43 @@ fail:
 #endif
 
 static void _sg_workingdir__get_entry2(SG_context * pCtx,
-									   SG_repo * pRepo,
+									   sg_workingdir__get_state * pState,
 									   const SG_pathname * pPathSub,
 									   const char * pszGid,
 									   SG_treenode_entry_type type,
 									   const char * pszidHidContent,
 									   const char * pszidHidXattrs,
-									   SG_int64 iAttributeBits,
-									   SG_vhash * pvhTimestamps)
+									   SG_int64 iAttributeBits)
 {
-	SG_file* pFile = NULL;
 	SG_string* pstrLink = NULL;
 	SG_byte* pBytes = NULL;
-	SG_vhash * pvhGid = NULL;
 
     if (SG_TREENODEENTRY_TYPE_DIRECTORY == type)
     {
         /* create the directory and then recurse into it */
         SG_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathSub)  );
-        SG_ERR_CHECK(  _sg_workingdir__get_dir(pCtx, pRepo, pPathSub, pszidHidContent, pvhTimestamps)  );
+        SG_ERR_CHECK(  _sg_workingdir__get_dir(pCtx, pState, pPathSub, pszidHidContent)  );
     }
     else if (SG_TREENODEENTRY_TYPE_REGULAR_FILE == type)
     {
-        SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathSub, SG_FILE_RDWR | SG_FILE_CREATE_NEW, SG_FSOBJ_PERMS__MASK, &pFile)  );
-        SG_ERR_CHECK(  SG_repo__fetch_blob_into_file(pCtx, pRepo, pszidHidContent, pFile, NULL)  );
-        SG_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+        /* the pool writes the file and sets its attributes.  we pick
+         * up the timestamp once everything has been written. */
+        SG_uint32 iItem = 0;
+
+        SG_ERR_CHECK(  SG_fetch_pool__add(pCtx, pState->pPool, pPathSub, SG_FSOBJ_PERMS__MASK, pszidHidContent,
+                                          (SG_FETCH_POOL_FLAGS__ATTRIBUTES
+                                           | (pState->pvhPending ? SG_FETCH_POOL_FLAGS__TIMESTAMP : SG_FETCH_POOL_FLAGS__NONE)),
+                                          iAttributeBits, pszidHidXattrs, &iItem)  );
+        if (pState->pvhPending)
+            SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pState->pvhPending, pszGid, (SG_int64)iItem)  );
+
+        return;
     }
     else if (SG_TREENODEENTRY_TYPE_SYMLINK == type)
     {
         SG_uint64 iLenBytes = 0;
 
-        SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, pszidHidContent, &pBytes, &iLenBytes)  );
+        SG_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pState->pRepo, pszidHidContent, &pBytes, &iLenBytes)  );
         SG_ERR_CHECK(  SG_STRING__ALLOC__BUF_LEN(pCtx, &pstrLink, pBytes, (SG_uint32) iLenBytes)  );
         SG_ERR_CHECK(  SG_fsobj__symlink(pCtx, pstrLink, pPathSub)  );
         SG_NULLFREE(pCtx, pBytes);
@@ -338,7 +355,7 @@ static void _sg_workingdir__get_entry2(SG_context * pCtx,
     if (pszidHidXattrs)
     {
 #ifdef SG_BUILD_FLAG_FEATURE_XATTR
-        SG_ERR_CHECK(  _sg_workingdir__set_xattrs(pCtx, pRepo, pPathSub, pszidHidXattrs)  );
+        SG_ERR_CHECK(  _sg_workingdir__set_xattrs(pCtx, pState->pRepo, pPathSub, pszidHidXattrs)  );
 #else
 		// TODO do we need to stuff something into the pendingtree to remind us
 		// TODO that the entry originally had an XAttr and we just didn't restore
@@ -348,31 +365,16 @@ static void _sg_workingdir__get_entry2(SG_context * pCtx,
 
     SG_ERR_CHECK(  SG_attributes__bits__apply(pCtx, pPathSub, iAttributeBits)  );
 
-	if (pvhTimestamps && (SG_TREENODEENTRY_TYPE_REGULAR_FILE == type))
-	{
-		SG_fsobj_stat stat;
-		SG_int64 iTimeNow;
-
-		SG_ERR_CHECK(  SG_fsobj__stat__pathname(pCtx, pPathSub, &stat)  );
-		SG_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &iTimeNow)  );
-
-		SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhGid)  );
-		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhGid, "mtime_ms", stat.mtime_ms)  );
-		SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhGid, "clock_ms", iTimeNow)  );
-
-		SG_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pvhTimestamps, pszGid, &pvhGid)  );	// this steals our vhash
-	}
-
 fail:
-	SG_VHASH_NULLFREE(pCtx, pvhGid);
+	SG_NULLFREE(pCtx, pBytes);
+	SG_STRING_NULLFREE(pCtx, pstrLink);
 }
 
 static void _sg_workingdir__get_entry(SG_context* pCtx,
-									  SG_repo* pRepo,
+									  sg_workingdir__get_state * pState,
 									  const SG_pathname* pPathSub,
 									  const char * pszGid,
-									  const SG_treenode_entry* pEntry,
-									  SG_vhash * pvhTimestamps)
+									  const SG_treenode_entry* pEntry)
 {
     SG_treenode_entry_type type;
     const char* pszidHidContent = NULL;
@@ -384,27 +386,25 @@ static void _sg_workingdir__get_entry(SG_context* pCtx,
     SG_ERR_CHECK(  SG_treenode_entry__get_hid_xattrs(pCtx, pEntry, &pszidHidXattrs)  );
     SG_ERR_CHECK(  SG_treenode_entry__get_attribute_bits(pCtx, pEntry, &iAttributeBits)  );
 
-	SG_ERR_CHECK(  _sg_workingdir__get_entry2(pCtx, pRepo, pPathSub,
+	SG_ERR_CHECK(  _sg_workingdir__get_entry2(pCtx, pState, pPathSub,
 											  pszGid,
-											  type, pszidHidContent, pszidHidXattrs, iAttributeBits,
-											  pvhTimestamps)  );
+											  type, pszidHidContent, pszidHidXattrs, iAttributeBits)  );
 
 fail:
     return;
 }
 
 static void _sg_workingdir__get_dir(SG_context* pCtx,
-									SG_repo* pRepo,
+									sg_workingdir__get_state * pState,
 									const SG_pathname* pPathLocal,
-									const char* pszidHidTreeNode,
-									SG_vhash * pvhTimestamps)
+									const char* pszidHidTreeNode)
 {
 	SG_uint32 count;
 	SG_uint32 i;
 	SG_pathname* pPathSub = NULL;
 	SG_treenode* pTreenode = NULL;
 
-	SG_ERR_CHECK(  SG_treenode__load_from_repo(pCtx, pRepo, pszidHidTreeNode, &pTreenode)  );
+	SG_ERR_CHECK(  SG_treenode__load_from_repo(pCtx, pState->pRepo, pszidHidTreeNode, &pTreenode)  );
 	SG_ERR_CHECK(  SG_treenode__count(pCtx, pTreenode, &count)  );
 
 	for (i=0; i<count; i++)
@@ -418,7 +418,7 @@ static void _sg_workingdir__get_dir(SG_context* pCtx,
 
         SG_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathSub, pPathLocal, pszName)  );
 
-        SG_ERR_CHECK(  _sg_workingdir__get_entry(pCtx, pRepo, pPathSub, pszGid, pEntry, pvhTimestamps)  );
+        SG_ERR_CHECK(  _sg_workingdir__get_entry(pCtx, pState, pPathSub, pszGid, pEntry)  );
 
         SG_PATHNAME_NULLFREE(pCtx, pPathSub);
 	}
@@ -435,6 +435,9 @@ fail:
  *
  * Record the file timestamp of each file we fetch in the pvhTimestamps; this
  * provides the basis for the timestamp check in scan-dir.
+ *
+ * The files themselves are written by a fetch pool; we wait for all of
+ * them before collecting the timestamps.
  */
 static void sg_workingdir__do_get_dir__top(SG_context* pCtx,
 										   SG_repo* pRepo,
@@ -447,6 +450,8 @@ static void sg_workingdir__do_get_dir__top(SG_context* pCtx,
 	SG_string* pstrLink = NULL;
 	SG_byte* pBytes = NULL;
     SG_vhash* pvhAttributes = NULL;
+	SG_vhash* pvhGid = NULL;
+	sg_workingdir__get_state state;
     SG_int64 iAttributeBits = 0;
     const SG_treenode_entry* pEntry = NULL;
     const char* pszidHidContent = NULL;
@@ -455,6 +460,9 @@ static void sg_workingdir__do_get_dir__top(SG_context* pCtx,
 #endif
 	SG_bool bExists = SG_FALSE;
 
+	memset(&state, 0, sizeof(state));
+	state.pRepo = pRepo;
+
     /* Load the treenode.  It should have exactly one entry, a subdirectory,
      * named @ */
 	SG_ERR_CHECK(  SG_treenode__load_from_repo(pCtx, pRepo, pszidHidTreeNode, &pTreenode)  );
@@ -483,7 +491,39 @@ static void sg_workingdir__do_get_dir__top(SG_context* pCtx,
 	SG_ERR_CHECK(  SG_fsobj__exists__pathname(pCtx, pPathSub, &bExists, NULL, NULL)  );
 	if (!bExists)
 		SG_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathSub)  );
-    SG_ERR_CHECK(  _sg_workingdir__get_dir(pCtx, pRepo, pPathSub, pszidHidContent, pvhTimestamps)  );
+
+	SG_ERR_CHECK(  SG_fetch_pool__alloc(pCtx, pRepo, &state.pPool)  );
+	if (pvhTimestamps)
+		SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &state.pvhPending)  );
+
+    SG_ERR_CHECK(  _sg_workingdir__get_dir(pCtx, &state, pPathSub, pszidHidContent)  );
+	SG_ERR_CHECK(  SG_fetch_pool__finish(pCtx, state.pPool)  );
+
+	if (pvhTimestamps)
+	{
+		SG_uint32 count = 0;
+		SG_uint32 k;
+
+		SG_ERR_CHECK(  SG_vhash__count(pCtx, state.pvhPending, &count)  );
+		for (k=0; k<count; k++)
+		{
+			const char* pszGid = NULL;
+			const SG_variant* pv = NULL;
+			SG_int64 iItem = 0;
+			SG_int64 mtime_ms = 0;
+			SG_int64 clock_ms = 0;
+
+			SG_ERR_CHECK(  SG_vhash__get_nth_pair(pCtx, state.pvhPending, k, &pszGid, &pv)  );
+			SG_ERR_CHECK(  SG_variant__get__int64(pCtx, pv, &iItem)  );
+			SG_ERR_CHECK(  SG_fetch_pool__get_timestamp(pCtx, state.pPool, (SG_uint32)iItem, &mtime_ms, &clock_ms)  );
+
+			SG_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhGid)  );
+			SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhGid, "mtime_ms", mtime_ms)  );
+			SG_ERR_CHECK(  SG_vhash__add__int64(pCtx, pvhGid, "clock_ms", clock_ms)  );
+
+			SG_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pvhTimestamps, pszGid, &pvhGid)  );	// this steals our vhash
+		}
+	}
 
 #ifdef SG_BUILD_FLAG_FEATURE_XATTR
     /* fix up the xattrs on that directory */
@@ -502,11 +542,16 @@ static void sg_workingdir__do_get_dir__top(SG_context* pCtx,
 
     SG_PATHNAME_NULLFREE(pCtx, pPathSub);
 	SG_TREENODE_NULLFREE(pCtx, pTreenode);
+	SG_VHASH_NULLFREE(pCtx, state.pvhPending);
+	SG_FETCH_POOL_NULLFREE(pCtx, state.pPool);
 
 	return;
 fail:
 	/* TODO free stuff */
     SG_VHASH_NULLFREE(pCtx, pvhAttributes);
+	SG_VHASH_NULLFREE(pCtx, pvhGid);
+	SG_VHASH_NULLFREE(pCtx, state.pvhPending);
+	SG_FETCH_POOL_NULLFREE(pCtx, state.pPool);
 	SG_NULLFREE(pCtx, pBytes);
 	SG_STRING_NULLFREE(pCtx, pstrLink);
 }
@@ -83,6 +83,7 @@ BEGIN_EXTERN_C;
 #define SG_ZING_TEMPLATE__SUGGESTED "suggested"
 #define SG_ZING_TEMPLATE__ADDEND "addend"
 #define SG_ZING_TEMPLATE__DEPENDS_ON "depends_on"
+#define SG_ZING_TEMPLATE__INDEX "index"
 
 #define SG_ZING_MERGE__most_recent "most_recent"
 #define SG_ZING_MERGE__least_recent "least_recent"
@@ -154,6 +155,9 @@ struct SG_zingfieldattributes
     // constraints which apply to all field types
     SG_bool required;
 
+    // the field is queried often enough to deserve an index in the dbndx
+    SG_bool index;
+
     union
     {
         struct
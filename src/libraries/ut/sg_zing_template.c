@@ -1658,6 +1658,8 @@ static void SG_zingtemplate__validate__one_field(
     SG_vhash* pvh_merge = NULL;
     SG_vhash* pvh_form = NULL;
     SG_vhash* pvh_calculated = NULL;
+    SG_bool b_has_index = SG_FALSE;
+    SG_bool b_index = SG_FALSE;
 
     SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr_where)  );
     SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstr_where, "%s.%s", psz_where, psz_cur)  );
@@ -1681,8 +1683,11 @@ static void SG_zingtemplate__validate__one_field(
                 SG_ZING_TEMPLATE__FORM,
                 b_field_merge ? SG_ZING_TEMPLATE__MERGE : "",
                 SG_ZING_TEMPLATE__CALCULATED,
+                SG_ZING_TEMPLATE__INDEX,
                 NULL)  );
 
+    SG_ERR_CHECK(  sg_zingtemplate__optional__bool(pCtx, psz_where, psz_cur, pvh, SG_ZING_TEMPLATE__INDEX, &b_has_index, &b_index)  );
+
     SG_ERR_CHECK(  sg_zingtemplate__optional__vhash(pCtx, psz_where, psz_cur, pvh, SG_ZING_TEMPLATE__CALCULATED, &pvh_calculated)  );
     if (pvh_calculated)
     {
@@ -2556,6 +2561,12 @@ void SG_zingtemplate__get_field_attributes(
         SG_ERR_THROW(  SG_ERR_NOTIMPLEMENTED  );
     }
 
+    SG_ERR_CHECK(  SG_vhash__has(pCtx, pvh_fa, SG_ZING_TEMPLATE__INDEX, &b)  );
+    if (b)
+    {
+        SG_ERR_CHECK(  SG_vhash__get__bool(pCtx, pvh_fa, SG_ZING_TEMPLATE__INDEX, &pzfa->index)  );
+    }
+
     // TODO init all the constraints to nothing, for each type
     pzfa->required = SG_FALSE;
 
@@ -39,6 +39,11 @@ int u0004_file__test_file(SG_context * pCtx, SG_uint64 len)
 	VERIFYP_CTX_IS_OK("test_file_creat", pCtx, ("create should succeed because the file does not exist"));
 	SG_context__err_reset(pCtx);
 
+	// preallocating must not change the size; the length check below depends on it.
+	SG_file__preallocate(pCtx, pf, len);
+	VERIFY_CTX_IS_OK("test_file_preallocate", pCtx);
+	SG_context__err_reset(pCtx);
+
 	// TODO append
 
 	if (len > 0)
@@ -384,6 +384,343 @@ void u0023_vcdiff__test_deltify_run(SG_context * pCtx)
 	SG_PATHNAME_NULLFREE(pCtx, pPath_version2);
 }
 
+/* Measure one deltify with the given method, make sure it round-trips,
+ * and return the size of the delta. */
+void u0023_vcdiff__do_measure_method(SG_context * pCtx,
+									 SG_pathname* pPath_version1, SG_pathname* pPath_version2,
+									 SG_uint32 method, SG_uint64* pLenDelta)
+{
+	SG_bool b;
+	SG_vcdiff_options options;
+	SG_pathname* pPathDelta = NULL;
+	SG_pathname* pPathReconstructed = NULL;
+	SG_int64 t1 = 0;
+	SG_int64 t2 = 0;
+
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPathDelta)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPathReconstructed)  );
+	VERIFY_ERR_CHECK(  SG_vcdiff__options__init(pCtx, &options, method)  );
+
+	VERIFY_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &t1)  );
+	VERIFY_ERR_CHECK(  SG_vcdiff__deltify__files__options(pCtx,pPath_version1, pPath_version2, pPathDelta, &options)  );
+	VERIFY_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &t2)  );
+	VERIFY_ERR_CHECK(  SG_vcdiff__undeltify__files(pCtx,pPath_version1, pPathReconstructed, pPathDelta)  );
+
+	b = compare_files_are_identical(pPath_version2, pPathReconstructed);
+	VERIFY_COND("match after deltify/undeltify", (b));
+
+	VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathDelta, pLenDelta, NULL)  );
+	INFOP("deltify", ("method %d: %d bytes of delta in %d ms", method, (int) *pLenDelta, (int) (t2 - t1)));
+
+fail:
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx,pPathDelta)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx,pPathReconstructed)  );
+
+	SG_PATHNAME_NULLFREE(pCtx, pPathDelta);
+	SG_PATHNAME_NULLFREE(pCtx, pPathReconstructed);
+}
+
+/* A 1 MB file whose 16 KB chunks get reversed.  Every chunk of the
+ * target is somewhere in the source, but almost never in the window
+ * that lines up with it, so this is where the whole-source method
+ * should beat the plain windowed one. */
+void u0023_vcdiff__test_deltify_whole_source(SG_context * pCtx)
+{
+	FILE* fp;
+	SG_pathname* pPath_version1 = NULL;
+	SG_pathname* pPath_version2 = NULL;
+	SG_byte* pBuf = NULL;
+	SG_uint32 count_chunks = 64;
+	SG_uint32 chunk_size = 16 * 1024;
+	SG_uint32 seed = 12345;
+	SG_uint32 i;
+	SG_uint64 len_window = 0;
+	SG_uint64 len_whole = 0;
+
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPath_version1)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPath_version2)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, count_chunks * chunk_size, pBuf)  );
+
+	for (i=0; i<count_chunks * chunk_size; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		pBuf[i] = (SG_byte) (seed >> 16);
+	}
+
+	fp = fopen(SG_pathname__sz(pPath_version1), "wb");
+	fwrite(pBuf, 1, count_chunks * chunk_size, fp);
+	fclose(fp);
+
+	fp = fopen(SG_pathname__sz(pPath_version2), "wb");
+	for (i=0; i<count_chunks; i++)
+	{
+		fwrite(pBuf + (count_chunks - 1 - i) * chunk_size, 1, chunk_size, fp);
+	}
+	fclose(fp);
+
+	VERIFY_ERR_CHECK(  u0023_vcdiff__do_measure_method(pCtx, pPath_version1, pPath_version2, SG_VCDIFF_METHOD__WINDOW, &len_window)  );
+	VERIFY_ERR_CHECK(  u0023_vcdiff__do_measure_method(pCtx, pPath_version1, pPath_version2, SG_VCDIFF_METHOD__WHOLE_SOURCE, &len_whole)  );
+	VERIFY_COND("whole-source delta is smaller", (len_whole < len_window));
+
+fail:
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPath_version1)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPath_version2)  );
+
+	SG_NULLFREE(pCtx, pBuf);
+	SG_PATHNAME_NULLFREE(pCtx, pPath_version1);
+	SG_PATHNAME_NULLFREE(pCtx, pPath_version2);
+}
+
+static SG_uint32 u0023_vcdiff__random(SG_uint32* pSeed)
+{
+	*pSeed = *pSeed * 1103515245 + 12345;
+	return (*pSeed >> 8);
+}
+
+static void u0023_vcdiff__write_file(const SG_pathname* pPath, const SG_byte* pBuf, SG_uint32 len)
+{
+	FILE* fp = fopen(SG_pathname__sz(pPath), "wb");
+	fwrite(pBuf, 1, len, fp);
+	fclose(fp);
+}
+
+/* Make a new version of pSource out of the kinds of edits the decoder
+ * has to handle: copies from anywhere in the source, copies of what we
+ * just wrote (which overlap when they are close), runs and new data. */
+static SG_uint32 u0023_vcdiff__mutate(SG_uint32* pSeed, const SG_byte* pSource, SG_uint32 len_source, SG_byte* pTarget, SG_uint32 len_max)
+{
+	SG_uint32 len = 0;
+
+	while (len < len_max)
+	{
+		SG_uint32 n = 1 + u0023_vcdiff__random(pSeed) % 3000;
+		SG_uint32 i;
+
+		if (n > (len_max - len))
+		{
+			n = len_max - len;
+		}
+
+		switch (u0023_vcdiff__random(pSeed) % 5)
+		{
+		case 0:
+		case 1:
+			i = u0023_vcdiff__random(pSeed) % len_source;
+			if (n > (len_source - i))
+			{
+				n = len_source - i;
+			}
+			memcpy(pTarget + len, pSource + i, n);
+			break;
+		case 2:
+			if (!len)
+			{
+				n = 0;
+				break;
+			}
+			i = 1 + u0023_vcdiff__random(pSeed) % ((len < 64) ? len : 64);
+			for ( ; n; n--, len++)
+			{
+				pTarget[len] = pTarget[len - i];
+			}
+			break;
+		case 3:
+			memset(pTarget + len, (int) u0023_vcdiff__random(pSeed), n);
+			break;
+		default:
+			for (i=0; i<n; i++)
+			{
+				pTarget[len + i] = (SG_byte) u0023_vcdiff__random(pSeed);
+			}
+			break;
+		}
+
+		len += n;
+	}
+
+	return len;
+}
+
+/* Round-trip a pile of randomly edited files through both deltify
+ * methods, then make sure a damaged delta fails cleanly (or happens to
+ * still decode) rather than crashing the decoder. */
+void u0023_vcdiff__test_undeltify_fuzz(SG_context * pCtx)
+{
+	SG_pathname* pPath_version1 = NULL;
+	SG_pathname* pPath_version2 = NULL;
+	SG_pathname* pPathDelta = NULL;
+	SG_pathname* pPathBadDelta = NULL;
+	SG_pathname* pPathReconstructed = NULL;
+	SG_byte* pSource = NULL;
+	SG_byte* pTarget = NULL;
+	SG_byte* pDelta = NULL;
+	SG_uint32 seed = 4242;
+	SG_uint32 len_max = 400 * 1024;
+	SG_uint32 iter;
+	SG_uint32 count_damaged_ok = 0;
+	SG_uint32 count_damaged_err = 0;
+
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPath_version1)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPath_version2)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPathDelta)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPathBadDelta)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPathReconstructed)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, len_max, pSource)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, len_max, pTarget)  );
+
+	for (iter=0; iter<24; iter++)
+	{
+		SG_uint32 len_source = 1 + u0023_vcdiff__random(&seed) % len_max;
+		SG_uint32 len_target = u0023_vcdiff__random(&seed) % len_max;
+		SG_uint32 method = iter % 2;
+		SG_vcdiff_options options;
+		SG_uint64 len_delta = 0;
+		SG_uint32 k;
+		SG_bool b;
+		FILE* fp;
+
+		for (k=0; k<len_source; k++)
+		{
+			pSource[k] = (iter % 3) ? (SG_byte) u0023_vcdiff__random(&seed) : (SG_byte) "abcdefgh\n"[u0023_vcdiff__random(&seed) % 9];
+		}
+		len_target = u0023_vcdiff__mutate(&seed, pSource, len_source, pTarget, len_target);
+
+		u0023_vcdiff__write_file(pPath_version1, pSource, len_source);
+		u0023_vcdiff__write_file(pPath_version2, pTarget, len_target);
+
+		VERIFY_ERR_CHECK(  SG_vcdiff__options__init(pCtx, &options, method)  );
+		VERIFY_ERR_CHECK(  SG_vcdiff__deltify__files__options(pCtx, pPath_version1, pPath_version2, pPathDelta, &options)  );
+		VERIFY_ERR_CHECK(  SG_vcdiff__undeltify__files(pCtx, pPath_version1, pPathReconstructed, pPathDelta)  );
+
+		b = compare_files_are_identical(pPath_version2, pPathReconstructed);
+		VERIFYP_COND("match after deltify/undeltify", (b), ("iteration %d", iter));
+		SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPathReconstructed)  );
+
+		VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathDelta, &len_delta, NULL)  );
+		VERIFY_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32) len_delta, pDelta)  );
+		fp = fopen(SG_pathname__sz(pPathDelta), "rb");
+		VERIFY_COND("read delta", (len_delta == fread(pDelta, 1, (size_t) len_delta, fp)));
+		fclose(fp);
+
+		for (k=0; k<16; k++)
+		{
+			SG_uint32 len_bad = (SG_uint32) len_delta;
+			SG_uint32 count_changes = 1 + u0023_vcdiff__random(&seed) % 4;
+			SG_byte* pBad = NULL;
+
+			VERIFY_ERR_CHECK(  SG_allocN(pCtx, len_bad, pBad)  );
+			memcpy(pBad, pDelta, len_bad);
+			while (count_changes--)
+			{
+				pBad[u0023_vcdiff__random(&seed) % len_bad] ^= (SG_byte) (1 + u0023_vcdiff__random(&seed) % 255);
+			}
+			if (0 == (k % 5))
+			{
+				len_bad = u0023_vcdiff__random(&seed) % len_bad;
+			}
+			u0023_vcdiff__write_file(pPathBadDelta, pBad, len_bad);
+			SG_NULLFREE(pCtx, pBad);
+
+			SG_vcdiff__undeltify__files(pCtx, pPath_version1, pPathReconstructed, pPathBadDelta);
+			if (SG_context__has_err(pCtx))
+			{
+				SG_context__err_reset(pCtx);
+				count_damaged_err++;
+			}
+			else
+			{
+				count_damaged_ok++;
+			}
+			SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPathReconstructed)  );
+		}
+
+		SG_NULLFREE(pCtx, pDelta);
+	}
+
+	INFOP("undeltify_fuzz", ("damaged deltas: %d rejected, %d decoded", count_damaged_err, count_damaged_ok));
+
+fail:
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPath_version1)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPath_version2)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPathDelta)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPathBadDelta)  );
+
+	SG_NULLFREE(pCtx, pSource);
+	SG_NULLFREE(pCtx, pTarget);
+	SG_NULLFREE(pCtx, pDelta);
+	SG_PATHNAME_NULLFREE(pCtx, pPath_version1);
+	SG_PATHNAME_NULLFREE(pCtx, pPath_version2);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDelta);
+	SG_PATHNAME_NULLFREE(pCtx, pPathBadDelta);
+	SG_PATHNAME_NULLFREE(pCtx, pPathReconstructed);
+}
+
+/* How fast can we apply a delta?  This is what every fetch of a packed
+ * blob pays for, so keep an eye on the number. */
+void u0023_vcdiff__test_undeltify_throughput(SG_context * pCtx)
+{
+	SG_pathname* pPath_version1 = NULL;
+	SG_pathname* pPath_version2 = NULL;
+	SG_pathname* pPathDelta = NULL;
+	SG_pathname* pPathReconstructed = NULL;
+	SG_byte* pSource = NULL;
+	SG_byte* pTarget = NULL;
+	SG_uint32 seed = 777;
+	SG_uint32 len = 4 * 1024 * 1024;
+	SG_uint32 len_target = 0;
+	SG_uint32 count_reps = 10;
+	SG_uint32 i;
+	SG_int64 t1 = 0;
+	SG_int64 t2 = 0;
+	SG_bool b;
+
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPath_version1)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPath_version2)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPathDelta)  );
+	VERIFY_ERR_CHECK(  unittest__get_nonexistent_pathname(pCtx,&pPathReconstructed)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, len, pSource)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, len, pTarget)  );
+
+	for (i=0; i<len; i++)
+	{
+		pSource[i] = (SG_byte) u0023_vcdiff__random(&seed);
+	}
+	len_target = u0023_vcdiff__mutate(&seed, pSource, len, pTarget, len);
+
+	u0023_vcdiff__write_file(pPath_version1, pSource, len);
+	u0023_vcdiff__write_file(pPath_version2, pTarget, len_target);
+
+	VERIFY_ERR_CHECK(  SG_vcdiff__deltify__files(pCtx, pPath_version1, pPath_version2, pPathDelta)  );
+
+	VERIFY_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &t1)  );
+	for (i=0; i<count_reps; i++)
+	{
+		SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPathReconstructed)  );
+		VERIFY_ERR_CHECK(  SG_vcdiff__undeltify__files(pCtx, pPath_version1, pPathReconstructed, pPathDelta)  );
+	}
+	VERIFY_ERR_CHECK(  SG_time__get_milliseconds_since_1970_utc(pCtx, &t2)  );
+
+	b = compare_files_are_identical(pPath_version2, pPathReconstructed);
+	VERIFY_COND("match after deltify/undeltify", (b));
+
+	INFOP("undeltify_throughput", ("%d x %d bytes in %d ms (%d KB/ms)",
+								   count_reps, len_target, (int) (t2 - t1),
+								   (int) (((SG_uint64) count_reps * len_target / 1024) / ((t2 > t1) ? (t2 - t1) : 1))));
+
+fail:
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPath_version1)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPath_version2)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPathDelta)  );
+	SG_ERR_IGNORE(  SG_fsobj__remove__pathname(pCtx, pPathReconstructed)  );
+
+	SG_NULLFREE(pCtx, pSource);
+	SG_NULLFREE(pCtx, pTarget);
+	SG_PATHNAME_NULLFREE(pCtx, pPath_version1);
+	SG_PATHNAME_NULLFREE(pCtx, pPath_version2);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDelta);
+	SG_PATHNAME_NULLFREE(pCtx, pPathReconstructed);
+}
+
 TEST_MAIN(u0023_vcdiff)
 {
 	TEMPLATE_MAIN_START;
@@ -397,6 +734,9 @@ TEST_MAIN(u0023_vcdiff)
 	BEGIN_TEST(  u0023_vcdiff__test_deltify_add(pCtx)  );
 	BEGIN_TEST(  u0023_vcdiff__test_deltify_run(pCtx)  );
 	BEGIN_TEST(  u0023_vcdiff__test_deltify_to_zerolength(pCtx)  );
+	BEGIN_TEST(  u0023_vcdiff__test_deltify_whole_source(pCtx)  );
+	BEGIN_TEST(  u0023_vcdiff__test_undeltify_fuzz(pCtx)  );
+	BEGIN_TEST(  u0023_vcdiff__test_undeltify_throughput(pCtx)  );
     /* we don't support deltifying from a zero length file */
 	//BEGIN_TEST(  u0023_vcdiff__test_deltify_from_zerolength(pCtx)  );
 
@@ -382,6 +382,62 @@ int u0034_repo_treenode__verify_bogus_treenode_not_found(SG_context* pCtx,SG_rep
 
 //////////////////////////////////////////////////////////////////
 
+int u0034_repo_treenode__verify_cached_load(SG_context* pCtx, SG_repo * pRepo, const char * pszidHidTreenode)
+{
+	// loading the same treenode twice should give us the same (shared)
+	// memory-object from the repo's object cache.  each load is freed
+	// separately and the object must survive until the last one.
+
+	SG_treenode * pTreenode1 = NULL;
+	SG_treenode * pTreenode2 = NULL;
+	SG_objcache * pCache = NULL;
+	SG_vhash * pvhStats1 = NULL;
+	SG_vhash * pvhStats2 = NULL;
+	SG_int64 hits1 = 0;
+	SG_int64 hits2 = 0;
+	SG_uint32 count = 0;
+
+	VERIFY_ERR_CHECK(  SG_repo__get_objcache__ref(pCtx, pRepo, &pCache)  );
+	VERIFY_COND("objcache", (pCache != NULL));
+	if (!pCache)
+		return 1;
+
+	VERIFY_ERR_CHECK(  SG_treenode__load_from_repo(pCtx, pRepo, pszidHidTreenode, &pTreenode1)  );
+	VERIFY_ERR_CHECK(  SG_objcache__get_stats(pCtx, pCache, &pvhStats1)  );
+	VERIFY_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvhStats1, "hits", &hits1)  );
+
+	VERIFY_ERR_CHECK(  SG_treenode__load_from_repo(pCtx, pRepo, pszidHidTreenode, &pTreenode2)  );
+	VERIFY_ERR_CHECK(  SG_objcache__get_stats(pCtx, pCache, &pvhStats2)  );
+	VERIFY_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvhStats2, "hits", &hits2)  );
+
+	VERIFY_COND("shared treenode", (pTreenode1 == pTreenode2));
+	VERIFY_COND("cache hit", (hits2 == hits1 + 1));
+
+	// a shared treenode cannot be unfrozen.
+
+	VERIFY_ERR_CHECK_ERR_EQUALS_DISCARD(  SG_treenode__unfreeze(pCtx, pTreenode2),
+										  SG_ERR_INVALID_WHILE_FROZEN  );
+
+	SG_TREENODE_NULLFREE(pCtx, pTreenode1);
+	VERIFY_ERR_CHECK(  SG_treenode__count(pCtx, pTreenode2, &count)  );
+	VERIFY_COND("count", (count > 0));
+
+	// dropping the cache leaves our reference alone.
+
+	VERIFY_ERR_CHECK(  SG_objcache__clear(pCtx, pCache)  );
+	VERIFY_ERR_CHECK(  SG_treenode__count(pCtx, pTreenode2, &count)  );
+	VERIFY_COND("count", (count > 0));
+
+fail:
+	SG_TREENODE_NULLFREE(pCtx, pTreenode1);
+	SG_TREENODE_NULLFREE(pCtx, pTreenode2);
+	SG_VHASH_NULLFREE(pCtx, pvhStats1);
+	SG_VHASH_NULLFREE(pCtx, pvhStats2);
+	return 1;
+}
+
+//////////////////////////////////////////////////////////////////
+
 
 int u0034_repo_treenode__run(SG_context* pCtx)
 {
@@ -418,6 +474,8 @@ int u0034_repo_treenode__run(SG_context* pCtx)
 		u0034_repo_treenode__add_entry_to_list(pCtx, "$",pszidHidTreenodeRoot,pszidGidObjectRoot);
 		SG_NULLFREE(pCtx, pszidGidObjectRoot);
 
+		u0034_repo_treenode__verify_cached_load(pCtx, pRepo, pszidHidTreenodeRoot);
+
 		SG_NULLFREE(pCtx, pszidHidTreenodeRoot);
 	}
 
@@ -29,10 +29,15 @@ limitations under the License.
 
 //////////////////////////////////////////////////////////////////
 
-void u0037_dag__create_new_repo(SG_context * pCtx, SG_repo ** ppRepo)
+void u0037_dag__create_new_repo__ids(SG_context * pCtx,
+									 const char * psz_repo_id_given,
+									 const char * psz_admin_id_given,
+									 SG_repo ** ppRepo)
 {
 	// repo's are created on disk as <RepoContainerDirectory>/<RepoGID>/{blobs,...}
 	// we pass the current directory as RepoContainerDirectory.
+	// if the ids are not given, we make up new ones; if they are, the
+	// new repo is a (so far empty) clone of the one they came from.
 	// caller must free returned value.
 
 	SG_repo * pRepo = NULL;
@@ -42,8 +47,14 @@ void u0037_dag__create_new_repo(SG_context * pCtx, SG_repo ** ppRepo)
     char buf_admin_id[SG_GID_BUFFER_LENGTH];
 	char* pszRepoImpl = NULL;
 
-	VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, buf_repo_id, sizeof(buf_repo_id))  );
-	VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, buf_admin_id, sizeof(buf_admin_id))  );
+	if (psz_repo_id_given)
+		VERIFY_ERR_CHECK(  SG_strcpy(pCtx, buf_repo_id, sizeof(buf_repo_id), psz_repo_id_given)  );
+	else
+		VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, buf_repo_id, sizeof(buf_repo_id))  );
+	if (psz_admin_id_given)
+		VERIFY_ERR_CHECK(  SG_strcpy(pCtx, buf_admin_id, sizeof(buf_admin_id), psz_admin_id_given)  );
+	else
+		VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, buf_admin_id, sizeof(buf_admin_id))  );
 
 	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC(pCtx, &pPathnameRepoDir)  );
 	VERIFY_ERR_CHECK(  SG_pathname__set__from_cwd(pCtx, pPathnameRepoDir)  );
@@ -80,6 +91,11 @@ fail:
     SG_NULLFREE(pCtx, pszRepoImpl);
 }
 
+void u0037_dag__create_new_repo(SG_context * pCtx, SG_repo ** ppRepo)
+{
+	u0037_dag__create_new_repo__ids(pCtx, NULL, NULL, ppRepo);
+}
+
 void u0037_dag__create_graph(SG_context * pCtx,
 							SG_repo * pRepo,
 							SG_uint32 cGenerations,
@@ -221,6 +237,123 @@ fail:
 	return;
 }
 
+void u0037_dag__test_dagindex(SG_context * pCtx, SG_repo * pRepo)
+{
+	// the in-memory dag index must agree with the dag on disk,
+	// and must stay in sync when we store new dagnodes through
+	// the same repo handle.
+
+	const SG_dagindex * pIndex = NULL;
+	SG_rbtree * pIdsetLeaves = NULL;
+	SG_rbtree * prbDescLeaves = NULL;
+	SG_dagnode * pDagnodeIndex = NULL;
+	SG_dagnode * pDagnodeDisk = NULL;
+	SG_dagnode * pDagnodeNew = NULL;
+	SG_repo_tx_handle * pTx = NULL;
+	char * pHidNew = NULL;
+	char bufTid[SG_TID_MAX_BUFFER_LENGTH];
+	const char * pszHid = NULL;
+	const char * pszHidLeaf = NULL;
+	const SG_uint32 * aIds = NULL;
+	SG_uint32 count, countAfter, countChildren, k;
+	SG_uint32 nrLeaves = 0;
+	SG_uint32 nrAncestors = 0;
+	SG_uint32 iLeaf, iNew;
+	SG_int32 genLeaf;
+	SG_bool bEqual, bFound, bIsAncestor;
+
+	VERIFY_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, SG_DAGNUM__TESTING__NOTHING, NULL, &pIndex)  );
+	VERIFY_ERR_CHECK(  SG_dagindex__count(pCtx, pIndex, &count)  );
+	VERIFY_COND("dagindex count", (count == 300));
+
+	VERIFY_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, SG_DAGNUM__TESTING__NOTHING, &pIdsetLeaves)  );
+
+	for (k=0; k<count; k++)
+	{
+		VERIFY_ERR_CHECK(  SG_dagindex__get_hid_ref(pCtx, pIndex, k, &pszHid)  );
+
+		VERIFY_ERR_CHECK(  SG_dagindex__fetch_dagnode(pCtx, (void *)pIndex, pszHid, &pDagnodeIndex)  );
+		VERIFY_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pszHid, &pDagnodeDisk)  );
+		VERIFY_ERR_CHECK(  SG_dagnode__equal(pCtx, pDagnodeIndex, pDagnodeDisk, &bEqual)  );
+		VERIFY_COND_FAIL("dagindex dagnode", bEqual);
+		SG_DAGNODE_NULLFREE(pCtx, pDagnodeIndex);
+		SG_DAGNODE_NULLFREE(pCtx, pDagnodeDisk);
+
+		// a node without children is a leaf and vice versa.
+
+		VERIFY_ERR_CHECK(  SG_dagindex__get_children(pCtx, pIndex, k, &countChildren, &aIds)  );
+		VERIFY_ERR_CHECK(  SG_rbtree__find(pCtx, pIdsetLeaves, pszHid, &bFound, NULL)  );
+		VERIFY_COND_FAIL("dagindex leaf", (bFound == (countChildren == 0)));
+		if (bFound)
+		{
+			nrLeaves++;
+			pszHidLeaf = pszHid;
+		}
+	}
+	VERIFY_ERR_CHECK(  SG_rbtree__count(pCtx, pIdsetLeaves, &k)  );
+	VERIFY_COND("dagindex leaves", (nrLeaves == k));
+
+	// add a child of one of the leaves.  the index we already have
+	// should pick it up without being reloaded.
+
+	VERIFY_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHidLeaf, &bFound, &iLeaf)  );
+	VERIFY_ERR_CHECK(  SG_dagindex__get_generation(pCtx, pIndex, iLeaf, &genLeaf)  );
+
+	VERIFY_ERR_CHECK(  SG_tid__generate(pCtx, bufTid, sizeof(bufTid))  );
+	VERIFY_ERR_CHECK(  SG_repo__alloc_compute_hash__from_bytes(pCtx, pRepo, strlen(bufTid), (SG_byte *)bufTid, &pHidNew)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__alloc(pCtx, &pDagnodeNew, pHidNew, genLeaf + 1)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__add_parent(pCtx, pDagnodeNew, pszHidLeaf)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__freeze(pCtx, pDagnodeNew)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
+	VERIFY_ERR_CHECK(  SG_repo__store_dagnode(pCtx, pRepo, pTx, SG_DAGNUM__TESTING__NOTHING, pDagnodeNew)  );
+	pDagnodeNew = NULL;
+	VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__get_dagindex(pCtx, pRepo, SG_DAGNUM__TESTING__NOTHING, NULL, &pIndex)  );
+	VERIFY_ERR_CHECK(  SG_dagindex__count(pCtx, pIndex, &countAfter)  );
+	VERIFY_COND("dagindex count after store", (countAfter == count + 1));
+
+	VERIFY_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pHidNew, &bFound, &iNew)  );
+	VERIFY_COND_FAIL("dagindex new node", bFound);
+	VERIFY_ERR_CHECK(  SG_dagindex__lookup(pCtx, pIndex, pszHidLeaf, &bFound, &iLeaf)  );
+	VERIFY_ERR_CHECK(  SG_dagindex__get_children(pCtx, pIndex, iLeaf, &countChildren, &aIds)  );
+	VERIFY_COND("dagindex new child", ((countChildren == 1) && (aIds[0] == iNew)));
+
+	VERIFY_ERR_CHECK(  SG_dagindex__is_ancestor(pCtx, pIndex, iLeaf, iNew, &bIsAncestor)  );
+	VERIFY_COND("dagindex is_ancestor", bIsAncestor);
+	VERIFY_ERR_CHECK(  SG_dagindex__is_ancestor(pCtx, pIndex, iNew, iLeaf, &bIsAncestor)  );
+	VERIFY_COND("dagindex !is_ancestor", !bIsAncestor);
+
+	// the new node is a leaf, so it is among the descendant leaves of
+	// exactly its ancestors.  ask every node both ways; the walks share
+	// scratch space, so the answers must not depend on earlier walks.
+
+	for (k=0; k<countAfter; k++)
+	{
+		SG_bool bReaches = SG_FALSE;
+
+		VERIFY_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbDescLeaves)  );
+		VERIFY_ERR_CHECK(  SG_dagindex__find_descendant_leaves(pCtx, pIndex, k, 0, prbDescLeaves, NULL)  );
+		VERIFY_ERR_CHECK(  SG_rbtree__find(pCtx, prbDescLeaves, pHidNew, &bReaches, NULL)  );
+		SG_RBTREE_NULLFREE(pCtx, prbDescLeaves);
+
+		VERIFY_ERR_CHECK(  SG_dagindex__is_ancestor(pCtx, pIndex, k, iNew, &bIsAncestor)  );
+		VERIFYP_COND_FAIL("dagindex walks agree", (bIsAncestor == bReaches), ("node %d", k));
+		if (bIsAncestor)
+			nrAncestors++;
+	}
+	VERIFYP_COND("dagindex ancestors", (nrAncestors >= 2), ("ancestors %d", nrAncestors));
+
+fail:
+	SG_NULLFREE(pCtx, pHidNew);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnodeIndex);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnodeDisk);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnodeNew);
+	SG_RBTREE_NULLFREE(pCtx, pIdsetLeaves);
+	SG_RBTREE_NULLFREE(pCtx, prbDescLeaves);
+}
+
 void u0037_dag__test_sparse(SG_context * pCtx, SG_repo * pRepo)
 {
 	char bufTid[SG_TID_MAX_BUFFER_LENGTH];
@@ -379,6 +512,425 @@ fail:
 }
 
 
+//////////////////////////////////////////////////////////////////
+
+static SG_dagfrag__foreach_member_callback u0037_dag__collect_member_cb;
+
+static void u0037_dag__collect_member_cb(SG_context * pCtx,
+										 const SG_dagnode * pDagnode,
+										 SG_dagfrag_state qs,
+										 void * pVoidData)
+{
+	SG_rbtree * prbMembers = (SG_rbtree *)pVoidData;
+	const char * pszHid = NULL;
+
+	SG_UNUSED(qs);
+
+	VERIFY_ERR_CHECK(  SG_dagnode__get_id_ref(pCtx, pDagnode, &pszHid)  );
+	VERIFY_ERR_CHECK(  SG_rbtree__add(pCtx, prbMembers, pszHid)  );
+
+fail:
+	return;
+}
+
+static SG_dagfrag__foreach_end_fringe_callback u0037_dag__count_end_fringe_cb;
+
+static void u0037_dag__count_end_fringe_cb(SG_context * pCtx,
+										   const char * pszHid,
+										   void * pVoidData)
+{
+	SG_UNUSED(pCtx);
+	SG_UNUSED(pszHid);
+
+	*((SG_uint32 *)pVoidData) += 1;
+}
+
+void u0037_dag__test_large_frag(SG_context * pCtx, SG_repo * pRepo)
+{
+	// pack the whole dag into one fragment and paste it into a fresh
+	// clone of the repo.  this is the batched insert path (one pass
+	// over the members in a single TX).  then make sure every dagnode
+	// came across intact -- with the same generation and the same
+	// parents (which is every edge) -- and that the clone agrees about
+	// the leaves.
+
+	SG_repo * pRepoClone = NULL;
+	SG_repo_tx_handle * pTx = NULL;
+	SG_dagfrag * pFrag = NULL;
+	SG_rbtree * prbLeaves = NULL;
+	SG_rbtree * prbLeavesClone = NULL;
+	SG_rbtree * prbMembers = NULL;
+	SG_rbtree_iterator * pIter = NULL;
+	SG_dagnode * pDagnode = NULL;
+	SG_dagnode * pDagnodeClone = NULL;
+	char * psz_repo_id = NULL;
+	char * psz_admin_id = NULL;
+	const char * pszHid = NULL;
+	SG_uint32 nrMembers = 0;
+	SG_uint32 nrEndFringe = 0;
+	SG_uint32 nrChecked = 0;
+	SG_bool bFound = SG_FALSE;
+	SG_bool bEqual = SG_FALSE;
+
+	VERIFY_ERR_CHECK(  SG_repo__get_repo_id(pCtx, pRepo, &psz_repo_id)  );
+	VERIFY_ERR_CHECK(  SG_repo__get_admin_id(pCtx, pRepo, &psz_admin_id)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, SG_DAGNUM__TESTING__NOTHING, &prbLeaves)  );
+
+	// generations are absolute (see SG_dagfrag__load_from_repo__one()), so
+	// this is enough to reach all the way back to the root.
+
+	VERIFY_ERR_CHECK(  SG_dagfrag__alloc(pCtx, &pFrag, psz_repo_id, psz_admin_id, SG_DAGNUM__TESTING__NOTHING)  );
+	VERIFY_ERR_CHECK(  SG_dagfrag__load_from_repo__multi(pCtx, pFrag, pRepo, prbLeaves, 1000000)  );
+
+	VERIFY_ERR_CHECK(  SG_dagfrag__foreach_end_fringe(pCtx, pFrag, u0037_dag__count_end_fringe_cb, &nrEndFringe)  );
+	VERIFYP_COND("large frag", (nrEndFringe == 0), ("frag has %d end-fringe nodes; expected the whole dag", nrEndFringe));
+
+	VERIFY_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbMembers)  );
+	VERIFY_ERR_CHECK(  SG_dagfrag__foreach_member(pCtx, pFrag, u0037_dag__collect_member_cb, prbMembers)  );
+	VERIFY_ERR_CHECK(  SG_rbtree__count(pCtx, prbMembers, &nrMembers)  );
+	VERIFYP_COND("large frag", (nrMembers >= 300), ("frag has only %d members", nrMembers));
+
+	// give the clone the same ids, as a real clone would have.
+
+	VERIFY_ERR_CHECK(  u0037_dag__create_new_repo__ids(pCtx, psz_repo_id, psz_admin_id, &pRepoClone)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepoClone, &pTx)  );
+	VERIFY_ERR_CHECK(  SG_repo__store_dagfrag(pCtx, pRepoClone, pTx, pFrag)  );
+	pFrag = NULL;		// store_dagfrag took ownership
+	VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepoClone, &pTx)  );
+
+	VERIFY_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pIter, prbMembers, &bFound, &pszHid, NULL)  );
+	while (bFound)
+	{
+		VERIFY_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pszHid, &pDagnode)  );
+		VERIFY_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepoClone, pszHid, &pDagnodeClone)  );
+		VERIFY_ERR_CHECK(  SG_dagnode__equal(pCtx, pDagnode, pDagnodeClone, &bEqual)  );
+		VERIFYP_COND("large frag", (bEqual), ("dagnode [%s] differs in the clone", pszHid));
+		SG_DAGNODE_NULLFREE(pCtx, pDagnode);
+		SG_DAGNODE_NULLFREE(pCtx, pDagnodeClone);
+		nrChecked++;
+
+		VERIFY_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pIter, &bFound, &pszHid, NULL)  );
+	}
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	VERIFY_COND("large frag", (nrChecked == nrMembers));
+
+	VERIFY_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepoClone, SG_DAGNUM__TESTING__NOTHING, &prbLeavesClone)  );
+	VERIFY_ERR_CHECK(  SG_rbtree__compare__keys_only(pCtx, prbLeaves, prbLeavesClone, &bEqual, NULL, NULL, NULL)  );
+	VERIFY_COND("large frag leaves", (bEqual));
+
+	VERIFY_ERR_CHECK_DISCARD(  SG_repo__check_integrity(pCtx,pRepoClone,SG_REPO__CHECK_INTEGRITY__DAG_CONSISTENCY,SG_DAGNUM__TESTING__NOTHING,NULL,NULL)  );
+
+	/* fall through */
+
+fail:
+	if (pTx)
+		SG_ERR_IGNORE(  SG_repo__abort_tx(pCtx, pRepoClone, &pTx)  );
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pIter);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnode);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnodeClone);
+	SG_DAGFRAG_NULLFREE(pCtx, pFrag);
+	SG_RBTREE_NULLFREE(pCtx, prbLeaves);
+	SG_RBTREE_NULLFREE(pCtx, prbLeavesClone);
+	SG_RBTREE_NULLFREE(pCtx, prbMembers);
+	SG_NULLFREE(pCtx, psz_repo_id);
+	SG_NULLFREE(pCtx, psz_admin_id);
+	SG_REPO_NULLFREE(pCtx, pRepoClone);
+}
+
+//////////////////////////////////////////////////////////////////
+
+#define U0037_TRAIL_RUNGS		10
+#define U0037_TRAIL_PREFIX		30
+#define U0037_TRAIL_BRANCH		40
+#define U0037_TRAIL_TAIL		20
+
+static void u0037_dag__add_node(SG_context * pCtx,
+								SG_repo * pRepo,
+								const char ** apszParents,
+								SG_uint32 nrParents,
+								char ** ppszHid)
+{
+	// store a new dagnode with the given parents and the proper
+	// generation (1 + the largest parent generation).
+
+	char bufTid[SG_TID_MAX_BUFFER_LENGTH];
+	char * pszHid = NULL;
+	SG_dagnode * pDagnode = NULL;
+	SG_dagnode * pDagnodeParent = NULL;
+	SG_repo_tx_handle * pTx = NULL;
+	SG_int32 gen = 0;
+	SG_int32 genParent = 0;
+	SG_uint32 k;
+
+	for (k=0; k<nrParents; k++)
+	{
+		VERIFY_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, apszParents[k], &pDagnodeParent)  );
+		VERIFY_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pDagnodeParent, &genParent)  );
+		SG_DAGNODE_NULLFREE(pCtx, pDagnodeParent);
+		if (genParent > gen)
+			gen = genParent;
+	}
+
+	VERIFY_ERR_CHECK(  SG_tid__generate(pCtx, bufTid, sizeof(bufTid))  );
+	VERIFY_ERR_CHECK(  SG_repo__alloc_compute_hash__from_bytes(pCtx, pRepo, strlen(bufTid), (SG_byte *)bufTid, &pszHid)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__alloc(pCtx, &pDagnode, pszHid, gen + 1)  );
+	for (k=0; k<nrParents; k++)
+		VERIFY_ERR_CHECK(  SG_dagnode__add_parent(pCtx, pDagnode, apszParents[k])  );
+	VERIFY_ERR_CHECK(  SG_dagnode__freeze(pCtx, pDagnode)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
+	VERIFY_ERR_CHECK(  SG_repo__store_dagnode(pCtx, pRepo, pTx, SG_DAGNUM__TESTING__NOTHING, pDagnode)  );
+	pDagnode = NULL;
+	VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
+
+	*ppszHid = pszHid;
+	return;
+
+fail:
+	if (pTx)
+		SG_ERR_IGNORE(  SG_repo__abort_tx(pCtx, pRepo, &pTx)  );
+	SG_DAGNODE_NULLFREE(pCtx, pDagnode);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnodeParent);
+	SG_NULLFREE(pCtx, pszHid);
+}
+
+static void u0037_dag__walk_back__reference(SG_context * pCtx,
+											SG_repo * pRepo,
+											const char * pszHidCur,
+											const char * pszHidTo,
+											SG_int32 genTo,
+											SG_stringarray * psa,
+											SG_bool * pbFound)
+{
+	// the plain recursive walk that SG_changeset_debug__find_dag_trail()
+	// replaced.  it is exponential on merges but it is obviously right,
+	// so the new one must find exactly the same trail.
+
+	SG_dagnode * pDagnode = NULL;
+	const char ** apszParents = NULL;
+	SG_uint32 nrParents = 0;
+	SG_int32 gen = 0;
+	SG_bool bFound = SG_FALSE;
+	SG_uint32 k;
+
+	if (0 == strcmp(pszHidCur, pszHidTo))
+	{
+		*pbFound = SG_TRUE;
+		return;
+	}
+
+	VERIFY_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pszHidCur, &pDagnode)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pDagnode, &gen)  );
+	if (gen > genTo)
+	{
+		VERIFY_ERR_CHECK(  SG_dagnode__get_parents(pCtx, pDagnode, &nrParents, &apszParents)  );
+		for (k=0; k<nrParents; k++)
+		{
+			VERIFY_ERR_CHECK(  u0037_dag__walk_back__reference(pCtx, pRepo, apszParents[k], pszHidTo, genTo, psa, &bFound)  );
+			if (bFound)
+			{
+				VERIFY_ERR_CHECK(  SG_stringarray__add(pCtx, psa, pszHidCur)  );
+				break;
+			}
+		}
+	}
+
+	*pbFound = bFound;
+
+fail:
+	SG_NULLFREE(pCtx, apszParents);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnode);
+}
+
+static void u0037_dag__verify_trail(SG_context * pCtx,
+									SG_repo * pRepo,
+									const char * pszHidFrom,
+									const char * pszHidTo,
+									SG_uint32 * pnrExpanded)
+{
+	// find the trail both ways and make sure they agree.  if there is
+	// no trail, both must say so.
+
+	SG_stringarray * psaTrail = NULL;
+	SG_stringarray * psaReference = NULL;
+	SG_dagnode * pDagnodeTo = NULL;
+	SG_int32 genTo = 0;
+	SG_bool bFound = SG_FALSE;
+	SG_uint32 nrTrail = 0;
+	SG_uint32 nrReference = 0;
+	SG_uint32 k;
+
+	VERIFY_ERR_CHECK(  SG_repo__fetch_dagnode(pCtx, pRepo, pszHidTo, &pDagnodeTo)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pDagnodeTo, &genTo)  );
+	VERIFY_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psaReference, 10)  );
+	VERIFY_ERR_CHECK(  u0037_dag__walk_back__reference(pCtx, pRepo, pszHidFrom, pszHidTo, genTo, psaReference, &bFound)  );
+
+	if (!bFound)
+	{
+		SG_changeset_debug__find_dag_trail(pCtx, pRepo, pszHidFrom, pszHidTo, &psaTrail, pnrExpanded);
+		VERIFY_CTX_ERR_EQUALS("no trail", pCtx, SG_ERR_NOTIMPLEMENTED);
+		SG_context__err_reset(pCtx);
+		goto fail;
+	}
+	VERIFY_ERR_CHECK(  SG_changeset_debug__find_dag_trail(pCtx, pRepo, pszHidFrom, pszHidTo, &psaTrail, pnrExpanded)  );
+
+	VERIFY_ERR_CHECK(  SG_stringarray__count(pCtx, psaTrail, &nrTrail)  );
+	VERIFY_ERR_CHECK(  SG_stringarray__count(pCtx, psaReference, &nrReference)  );
+	VERIFYP_COND_FAIL("trail length", (nrTrail == nrReference),
+					  ("trail [%s]..[%s] has %d entries; expected %d", pszHidFrom, pszHidTo, nrTrail, nrReference));
+	for (k=0; k<nrTrail; k++)
+	{
+		const char * psz1 = NULL;
+		const char * psz2 = NULL;
+
+		VERIFY_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaTrail, k, &psz1)  );
+		VERIFY_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaReference, k, &psz2)  );
+		VERIFYP_COND_FAIL("trail", (0 == strcmp(psz1, psz2)),
+						  ("trail [%s]..[%s] differs at %d: [%s] vs [%s]", pszHidFrom, pszHidTo, k, psz1, psz2));
+	}
+
+fail:
+	SG_STRINGARRAY_NULLFREE(pCtx, psaTrail);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaReference);
+	SG_DAGNODE_NULLFREE(pCtx, pDagnodeTo);
+}
+
+void u0037_dag__test_trail(SG_context * pCtx)
+{
+	// the blob-list normalization in sg_changeset.c walks back from each
+	// parent to the LCA.  build a fresh dag that is all merges -- a
+	// ladder where each of Lk and Rk has all of Lk-1, Rk-1 and Sk-1 as
+	// parents, next to a plain chain S1..Sn:
+	//
+	//     R -- L1 == L2 == ... == Ln
+	//     |     \/    \/          (every rung is merged into both
+	//     |     /\    /\           sides of the rung above)
+	//     +--- R1 == R2 == ... == Rn
+	//     |          /     /
+	//     +--- S1 -- S2 -- ... -- Sn
+	//
+	// and check the trail against the old recursive walk between every
+	// pair of rungs.  the S chain is a dead end when looking for an L
+	// or R, so the walk has to back out of it over and over.
+	//
+	// then a shape which only the generation bound keeps cheap:
+	//
+	//     R -- P1 -- ... -- P30=TO -- C1 -- ... -- C20 -- FROM
+	//           \                                        /
+	//            B1 -- B2 -- ... ---------------- B40 --/
+	//
+	// the B chain is old history which never leads to TO.  only the
+	// part of it above TO's generation should ever be walked.
+
+	SG_repo * pRepo = NULL;
+	char * pszRoot = NULL;
+	char * aL[U0037_TRAIL_RUNGS + 1];
+	char * aR[U0037_TRAIL_RUNGS + 1];
+	char * aS[U0037_TRAIL_RUNGS + 1];
+	char * aP[U0037_TRAIL_PREFIX + 1];
+	char * aB[U0037_TRAIL_BRANCH + 1];
+	char * aC[U0037_TRAIL_TAIL + 1];
+	char * pszFrom = NULL;
+	const char * apszParents[3];
+	SG_uint32 nrExpanded = 0;
+	SG_uint32 k, j;
+
+	memset(aL, 0, sizeof(aL));
+	memset(aR, 0, sizeof(aR));
+	memset(aS, 0, sizeof(aS));
+	memset(aP, 0, sizeof(aP));
+	memset(aB, 0, sizeof(aB));
+	memset(aC, 0, sizeof(aC));
+
+	VERIFY_ERR_CHECK(  u0037_dag__create_new_repo(pCtx, &pRepo)  );
+	VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, NULL, 0, &pszRoot)  );
+
+	// the ladder.  rung 0 is the root.
+
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, pszRoot, &aL[0])  );
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, pszRoot, &aR[0])  );
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, pszRoot, &aS[0])  );
+	for (k=1; k<=U0037_TRAIL_RUNGS; k++)
+	{
+		apszParents[0] = aL[k-1];
+		apszParents[1] = aR[k-1];
+		apszParents[2] = aS[k-1];
+		VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, apszParents, ((k == 1) ? 1 : 3), &aL[k])  );
+		VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, apszParents, ((k == 1) ? 1 : 3), &aR[k])  );
+		VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, &apszParents[2], 1, &aS[k])  );
+	}
+
+	for (k=0; k<U0037_TRAIL_RUNGS; k++)
+	{
+		for (j=k+1; j<=U0037_TRAIL_RUNGS; j++)
+		{
+			VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, aL[j], aL[k], NULL)  );
+			VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, aR[j], aR[k], NULL)  );
+			VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, aL[j], aS[k], NULL)  );
+			VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, aS[j], aS[k], NULL)  );
+			if (k > 0)
+				VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, aS[j], aL[k], NULL)  );	// none
+		}
+	}
+
+	// the long way around.
+
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, pszRoot, &aP[0])  );
+	for (k=1; k<=U0037_TRAIL_PREFIX; k++)
+		VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, (const char **)&aP[k-1], 1, &aP[k])  );
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, aP[1], &aB[0])  );
+	for (k=1; k<=U0037_TRAIL_BRANCH; k++)
+		VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, (const char **)&aB[k-1], 1, &aB[k])  );
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, aP[U0037_TRAIL_PREFIX], &aC[0])  );
+	for (k=1; k<=U0037_TRAIL_TAIL; k++)
+		VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, (const char **)&aC[k-1], 1, &aC[k])  );
+	apszParents[0] = aB[U0037_TRAIL_BRANCH];
+	apszParents[1] = aC[U0037_TRAIL_TAIL];
+	VERIFY_ERR_CHECK(  u0037_dag__add_node(pCtx, pRepo, apszParents, 2, &pszFrom)  );
+
+	// B_k has generation k+2 and TO has generation PREFIX+1, so only
+	// B_k with k >= PREFIX may be walked: 11 of them, plus the 20 C's
+	// and FROM itself.  (whether B or C gets tried first depends on
+	// the HIDs.)
+
+	VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, pszFrom, aP[U0037_TRAIL_PREFIX], &nrExpanded)  );
+	VERIFYP_COND("trail bound", (nrExpanded >= 1 + U0037_TRAIL_TAIL),
+				 ("walked %d changesets", nrExpanded));
+	VERIFYP_COND("trail bound", (nrExpanded <= 1 + U0037_TRAIL_TAIL + (U0037_TRAIL_BRANCH - U0037_TRAIL_PREFIX + 1)),
+				 ("walked %d changesets", nrExpanded));
+
+	// and from the top of B, where there is no trail at all, exactly
+	// those 11 B's get walked before we give up.
+
+	VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, aB[U0037_TRAIL_BRANCH], aP[U0037_TRAIL_PREFIX], &nrExpanded)  );
+	VERIFYP_COND("trail bound", (nrExpanded == (U0037_TRAIL_BRANCH - U0037_TRAIL_PREFIX + 1)),
+				 ("walked %d changesets", nrExpanded));
+
+	// the bound never hides a real trail: TO's own parent is one
+	// generation below it and is still reached.
+
+	VERIFY_ERR_CHECK(  u0037_dag__verify_trail(pCtx, pRepo, pszFrom, aP[U0037_TRAIL_PREFIX - 1], NULL)  );
+
+fail:
+	for (k=0; k<=U0037_TRAIL_RUNGS; k++)
+	{
+		SG_NULLFREE(pCtx, aL[k]);
+		SG_NULLFREE(pCtx, aR[k]);
+		SG_NULLFREE(pCtx, aS[k]);
+	}
+	for (k=0; k<=U0037_TRAIL_PREFIX; k++)
+		SG_NULLFREE(pCtx, aP[k]);
+	for (k=0; k<=U0037_TRAIL_BRANCH; k++)
+		SG_NULLFREE(pCtx, aB[k]);
+	for (k=0; k<=U0037_TRAIL_TAIL; k++)
+		SG_NULLFREE(pCtx, aC[k]);
+	SG_NULLFREE(pCtx, pszFrom);
+	SG_NULLFREE(pCtx, pszRoot);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+}
+
 void u0037_dag__run(SG_context * pCtx)
 {
 	// run the main test.
@@ -397,6 +949,15 @@ void u0037_dag__run(SG_context * pCtx)
 
 	VERIFY_ERR_CHECK_DISCARD(  SG_repo__check_integrity(pCtx,pRepo,SG_REPO__CHECK_INTEGRITY__DAG_CONSISTENCY,SG_DAGNUM__TESTING__NOTHING,NULL,NULL)  );
 
+	// check the in-memory dag index against the dag on disk.
+
+	VERIFY_ERR_CHECK(  u0037_dag__test_dagindex(pCtx, pRepo)  );
+
+	// paste the whole dag into a fresh clone as one big fragment.
+	// (this has to happen before we try to make the dag sparse.)
+
+	VERIFY_ERR_CHECK(  u0037_dag__test_large_frag(pCtx, pRepo)  );
+
 	// test sparseness by adding random dagnodes to make dag sparse
 
 	VERIFY_ERR_CHECK(  u0037_dag__test_sparse(pCtx, pRepo)  );
@@ -410,6 +971,11 @@ void u0037_dag__run(SG_context * pCtx)
 
 	VERIFY_ERR_CHECK(  u0037_dag__do_frags(pCtx, pRepo)  );
 
+	// the trails the changeset blob-list normalization walks, on a
+	// separate dag that is mostly merges.
+
+	VERIFY_ERR_CHECK(  u0037_dag__test_trail(pCtx)  );
+
 fail:
 	SG_REPO_NULLFREE(pCtx, pRepo);
 }
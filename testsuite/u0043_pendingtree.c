@@ -26,6 +26,10 @@ limitations under the License.
 #include "unittests.h"
 #include "unittests_pendingtree.h"
 
+#if defined(MAC) || defined(LINUX)
+#include <sys/time.h>
+#endif
+
 //////////////////////////////////////////////////////////////////
 
 
@@ -2653,6 +2657,220 @@ fail:
 	return;
 }
 
+/**
+ * Like u0043_pendingtree__status_stats(), but also report how many of the
+ * directories the scan looked at were trusted from the directory cache.
+ */
+static void u0043_pendingtree__status_stats__dir_cache(SG_context * pCtx,
+													   const SG_pathname* pPathWorkingDir,
+													   SG_treediff2_debug__Stats * pStats,
+													   SG_uint32 * pNrDirValid,
+													   SG_uint32 * pNrDirQueries)
+{
+	SG_pendingtree* pPendingTree = NULL;
+	SG_treediff2 * pTreeDiff = NULL;
+
+	VERIFY_ERR_CHECK(  SG_PENDINGTREE__ALLOC(pCtx, pPathWorkingDir, SG_FALSE, &pPendingTree)  );
+	VERIFY_ERR_CHECK(  SG_pendingtree__diff(pCtx, pPendingTree, NULL, &pTreeDiff)  );
+	VERIFY_ERR_CHECK(  SG_treediff2_debug__compute_stats(pCtx, pTreeDiff, pStats)  );
+	VERIFY_ERR_CHECK(  SG_pendingtree_debug__get_dir_cache_stats(pCtx, pPendingTree, pNrDirValid, pNrDirQueries)  );
+
+fail:
+	SG_PENDINGTREE_NULLFREE(pCtx, pPendingTree);
+	SG_TREEDIFF2_NULLFREE(pCtx, pTreeDiff);
+}
+
+static void u0043_pendingtree__status_stats(SG_context * pCtx,
+											const SG_pathname* pPathWorkingDir,
+											SG_treediff2_debug__Stats * pStats)
+{
+	SG_ERR_CHECK_RETURN(  u0043_pendingtree__status_stats__dir_cache(pCtx, pPathWorkingDir, pStats, NULL, NULL)  );
+}
+
+#if defined(MAC) || defined(LINUX)
+/**
+ * Set the mtime of a directory well into the past, so that a scan right
+ * after this is out of the "grey area" and will trust the directory.
+ */
+static void u0043_pendingtree__backdate_dir(SG_context * pCtx, const SG_pathname * pPath)
+{
+	struct timeval tv[2];
+	SG_int64 iTimeNow;
+
+	SG_ERR_CHECK_RETURN(  SG_time__get_milliseconds_since_1970_utc(pCtx, &iTimeNow)  );
+	tv[0].tv_sec = (time_t)((iTimeNow / 1000) - 10);
+	tv[0].tv_usec = 0;
+	tv[1] = tv[0];
+
+	if (utimes(SG_pathname__sz(pPath), tv) != 0)
+		SG_ERR_THROW_RETURN(  SG_ERR_ERRNO(errno)  );
+}
+#endif
+
+/**
+ * Make sure that the directory cache doesn't hide changes.  A scan records
+ * the directories, then we change things inside them and see that status
+ * still notices.
+ */
+void u0043_pendingtree_test__dir_cache(SG_context * pCtx, SG_pathname* pPathTopDir)
+{
+	char bufName[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_pathname* pPathDir1 = NULL;
+	SG_pathname* pPathFile = NULL;
+	SG_treediff2_debug__Stats tdStats;
+	SG_uint32 nrDirValid = 0;
+	SG_uint32 nrDirQueries = 0;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, bufName)  );
+	INFO2("working directory",SG_pathname__sz(pPathWorkingDir));
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDir1, pPathWorkingDir, "d1")  );
+
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__cd__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathDir1)  );
+
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathWorkingDir, "ftop", 20)  );
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathDir1, "f1a", 20)  );
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathDir1, "f1b", 20)  );
+
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx, bufName, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__commit_all(pCtx, pPathWorkingDir,SG_TRUE)  );
+	VERIFY_WD_JSON_PENDING_CLEAN(pCtx, pPathWorkingDir);
+
+	/* Get out of the "grey area" so that the directory timestamps
+	 * recorded by the next scan will be trusted.  Where we can, push
+	 * the directory mtimes back rather than waiting for the clock. */
+#if defined(MAC) || defined(LINUX)
+	VERIFY_ERR_CHECK(  u0043_pendingtree__backdate_dir(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__backdate_dir(pCtx, pPathDir1)  );
+#else
+	SG_sleep_ms(2100);
+#endif
+	VERIFY_ERR_CHECK(  _ut_pt__scan(pCtx, pPathWorkingDir)  );
+	VERIFY_WD_JSON_PENDING_CLEAN(pCtx, pPathWorkingDir);
+
+	/* Both directories are trusted, so neither gets read. */
+	VERIFY_ERR_CHECK(  u0043_pendingtree__status_stats__dir_cache(pCtx, pPathWorkingDir, &tdStats, &nrDirValid, &nrDirQueries)  );
+	VERIFY_COND("dir_cache clean", (tdStats.nrTotalChanges == 0));
+	VERIFYP_COND("dir_cache clean", ((nrDirQueries >= 2) && (nrDirValid == nrDirQueries)),
+				 ("valid %d queries %d", nrDirValid, nrDirQueries));
+
+	/* Modifying a file doesn't change the directory. */
+	VERIFY_ERR_CHECK(  _ut_pt__append_to_file__numbers(pCtx, pPathDir1, "f1a", 4)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__status_stats__dir_cache(pCtx, pPathWorkingDir, &tdStats, &nrDirValid, &nrDirQueries)  );
+	VERIFY_COND("dir_cache modified", (tdStats.nrFileSymlinkModified == 1));
+	VERIFYP_COND("dir_cache modified", ((nrDirQueries >= 2) && (nrDirValid == nrDirQueries)),
+				 ("valid %d queries %d", nrDirValid, nrDirQueries));
+
+	/* Adding and removing files does, so d1 has to be read again. */
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathDir1, "f1c", 20)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__status_stats__dir_cache(pCtx, pPathWorkingDir, &tdStats, &nrDirValid, &nrDirQueries)  );
+	VERIFY_COND("dir_cache found", (tdStats.nrFound == 1));
+	VERIFYP_COND("dir_cache found", ((nrDirQueries >= 2) && (nrDirValid + 1 == nrDirQueries)),
+				 ("valid %d queries %d", nrDirValid, nrDirQueries));
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathFile, pPathDir1, "f1b")  );
+	VERIFY_ERR_CHECK(  SG_fsobj__remove__pathname(pCtx, pPathFile)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__status_stats__dir_cache(pCtx, pPathWorkingDir, &tdStats, &nrDirValid, &nrDirQueries)  );
+	VERIFY_COND("dir_cache lost", (tdStats.nrLost == 1));
+	VERIFYP_COND("dir_cache lost", ((nrDirQueries >= 2) && (nrDirValid + 1 == nrDirQueries)),
+				 ("valid %d queries %d", nrDirValid, nrDirQueries));
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDir1);
+	SG_PATHNAME_NULLFREE(pCtx, pPathFile);
+}
+
+void u0043_pendingtree_test__scan_many_dirs(SG_context * pCtx, SG_pathname* pPathTopDir)
+{
+	char bufName[SG_TID_MAX_BUFFER_LENGTH];
+	char bufEntry[100];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_pathname* pPathDir = NULL;
+	SG_pathname* pPathSubDir = NULL;
+	SG_pathname* pPathFile = NULL;
+	SG_treediff2_debug__Stats tdStats;
+	SG_uint32 i, j, k;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, bufName)  );
+	INFO2("working directory",SG_pathname__sz(pPathWorkingDir));
+
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__cd__pathname(pCtx, pPathWorkingDir)  );
+
+	/* Enough directories that a recursive scan reads them on more than one thread. */
+	for (i=0; i<8; i++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufEntry, sizeof(bufEntry), "d%u", i)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDir, pPathWorkingDir, bufEntry)  );
+		VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathDir)  );
+		for (j=0; j<3; j++)
+		{
+			VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufEntry, sizeof(bufEntry), "s%u", j)  );
+			VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathSubDir, pPathDir, bufEntry)  );
+			VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathSubDir)  );
+			for (k=0; k<5; k++)
+			{
+				VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufEntry, sizeof(bufEntry), "f%u", k)  );
+				VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathSubDir, bufEntry, 20)  );
+			}
+			SG_PATHNAME_NULLFREE(pCtx, pPathSubDir);
+		}
+		SG_PATHNAME_NULLFREE(pCtx, pPathDir);
+	}
+
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx, bufName, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__commit_all(pCtx, pPathWorkingDir,SG_TRUE)  );
+	VERIFY_WD_JSON_PENDING_CLEAN(pCtx, pPathWorkingDir);
+
+	VERIFY_ERR_CHECK(  u0043_pendingtree__status_stats(pCtx, pPathWorkingDir, &tdStats)  );
+	VERIFY_COND("scan_many_dirs clean", (tdStats.nrTotalChanges == 0));
+
+	/* Change, add and remove files all over the tree. */
+	for (i=0; i<8; i++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufEntry, sizeof(bufEntry), "d%u/s%u", i, i % 3)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathSubDir, pPathWorkingDir, bufEntry)  );
+		VERIFY_ERR_CHECK(  _ut_pt__append_to_file__numbers(pCtx, pPathSubDir, "f1", 4)  );
+		VERIFY_ERR_CHECK(  _ut_pt__append_to_file__numbers(pCtx, pPathSubDir, "f3", 4)  );
+		if (i % 2)
+			VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathSubDir, "fnew", 20)  );
+		if (i == 5)
+		{
+			VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathFile, pPathSubDir, "f4")  );
+			VERIFY_ERR_CHECK(  SG_fsobj__remove__pathname(pCtx, pPathFile)  );
+			SG_PATHNAME_NULLFREE(pCtx, pPathFile);
+		}
+		SG_PATHNAME_NULLFREE(pCtx, pPathSubDir);
+	}
+
+	VERIFY_ERR_CHECK(  u0043_pendingtree__status_stats(pCtx, pPathWorkingDir, &tdStats)  );
+	VERIFY_COND("scan_many_dirs modified", (tdStats.nrFileSymlinkModified == 16));
+	VERIFY_COND("scan_many_dirs found", (tdStats.nrFound == 4));
+	VERIFY_COND("scan_many_dirs lost", (tdStats.nrLost == 1));
+
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__commit_all(pCtx, pPathWorkingDir,SG_TRUE)  );
+	VERIFY_WD_JSON_PENDING_CLEAN(pCtx, pPathWorkingDir);
+
+	VERIFY_ERR_CHECK(  u0043_pendingtree__status_stats(pCtx, pPathWorkingDir, &tdStats)  );
+	VERIFY_COND("scan_many_dirs clean after commit", (tdStats.nrTotalChanges == 0));
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathSubDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathFile);
+}
+
 void u0043_pendingtree_test__status(SG_context * pCtx, SG_pathname* pPathTopDir)
 {
 	char bufName[SG_TID_MAX_BUFFER_LENGTH];
@@ -6143,6 +6361,224 @@ fail:
 
 //////////////////////////////////////////////////////////////////
 
+#define U0043_FP_NR_DIRS		3
+#define U0043_FP_NR_FILES		20		// per directory; more than the plan's fetch-ahead window
+
+/**
+ * Verify that <pPathDirA>/<pszName> and <pPathDirB>/<pszName> have
+ * exactly the same content.
+ */
+void u0043_pendingtree__verify_same_content(SG_context * pCtx,
+											const SG_pathname * pPathDirA,
+											const SG_pathname * pPathDirB,
+											const char * pszName)
+{
+	SG_pathname * pPathA = NULL;
+	SG_pathname * pPathB = NULL;
+	SG_file * pFileA = NULL;
+	SG_file * pFileB = NULL;
+	SG_byte * pBufA = NULL;
+	SG_byte * pBufB = NULL;
+	SG_uint64 lenA = 0;
+	SG_uint64 lenB = 0;
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathA, pPathDirA, pszName)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathB, pPathDirB, pszName)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathA, &lenA, NULL)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathB, &lenB, NULL)  );
+	VERIFYP_COND("same length", (lenA == lenB),
+				 ("[%s] is %d bytes in [%s] and %d bytes in [%s]", pszName,
+				  (SG_uint32)lenA, SG_pathname__sz(pPathDirA), (SG_uint32)lenB, SG_pathname__sz(pPathDirB)));
+	if ((lenA != lenB) || (lenA == 0))
+		goto fail;
+
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)lenA, pBufA)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)lenB, pBufB)  );
+	VERIFY_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathA, SG_FILE_RDONLY | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFileA)  );
+	VERIFY_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathB, SG_FILE_RDONLY | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFileB)  );
+	VERIFY_ERR_CHECK(  SG_file__read(pCtx, pFileA, (SG_uint32)lenA, pBufA, NULL)  );
+	VERIFY_ERR_CHECK(  SG_file__read(pCtx, pFileB, (SG_uint32)lenB, pBufB, NULL)  );
+	VERIFYP_COND("same content", (memcmp(pBufA, pBufB, (size_t)lenA) == 0),
+				 ("[%s] differs between [%s] and [%s]", pszName, SG_pathname__sz(pPathDirA), SG_pathname__sz(pPathDirB)));
+
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFileA);
+	SG_FILE_NULLCLOSE(pCtx, pFileB);
+	SG_NULLFREE(pCtx, pBufA);
+	SG_NULLFREE(pCtx, pBufB);
+	SG_PATHNAME_NULLFREE(pCtx, pPathA);
+	SG_PATHNAME_NULLFREE(pCtx, pPathB);
+}
+
+/**
+ * Checkout and update write their files on the fetch pool.  Use enough
+ * files to keep all of the workers busy (and to run past the fetch-ahead
+ * window of the update), give each file a different length so a file
+ * written with the wrong blob is caught, and check every byte.
+ *
+ * Then make a checkout fail part of the way through and make sure the
+ * error comes back and the file in the way is left alone.
+ */
+void u0043_pendingtree_test__fetch_pool(SG_context * pCtx, SG_pathname* pPathTopDir)
+{
+	char bufName[SG_TID_MAX_BUFFER_LENGTH];
+	char bufGetName[SG_TID_MAX_BUFFER_LENGTH];
+	char bufCSet_0[SG_HID_MAX_BUFFER_LENGTH];
+	char bufCSet_AfterUpdate[SG_HID_MAX_BUFFER_LENGTH];
+	char bufDir[32];
+	char bufFile[32];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_pathname* pPathGet = NULL;
+	SG_pathname* pPathGetFail = NULL;
+	SG_pathname* pPathDirWD = NULL;
+	SG_pathname* pPathDirGet = NULL;
+	SG_pathname* pPathFile = NULL;
+	SG_pendingtree* pPendingTree = NULL;
+	SG_uint64 len = 0;
+	SG_uint32 d, f;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, bufName)  );
+	INFO2("working directory",SG_pathname__sz(pPathWorkingDir));
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__cd__pathname(pCtx, pPathWorkingDir)  );
+
+	/* @/t00.txt ... and @/dN/fNN.txt, all of different lengths */
+	for (f=0; f<U0043_FP_NR_FILES; f++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "t%02d.txt", f)  );
+		VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathWorkingDir, bufFile, 500 + f)  );
+	}
+	for (d=0; d<U0043_FP_NR_DIRS; d++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufDir, sizeof(bufDir), "d%d", d)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDirWD, pPathWorkingDir, bufDir)  );
+		VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathDirWD)  );
+		for (f=0; f<U0043_FP_NR_FILES; f++)
+		{
+			VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "f%02d.txt", f)  );
+			VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathDirWD, bufFile, 10 + 40*d + f)  );
+		}
+		SG_PATHNAME_NULLFREE(pCtx, pPathDirWD);
+	}
+
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx, bufName, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__commit_all(pCtx, pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  _ut_pt__get_baseline(pCtx, pPathWorkingDir,bufCSet_0,sizeof(bufCSet_0))  );
+
+	//////////////////////////////////////////////////////////////////
+	// checkout CSET_0 somewhere else and compare every file.
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufGetName, sizeof(bufGetName), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathGet, pPathTopDir, bufGetName)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathGet)  );
+	VERIFY_ERR_CHECK(  unittests_workingdir__create_and_get(pCtx, bufName, pPathGet, SG_FALSE, NULL)  );
+
+	for (f=0; f<U0043_FP_NR_FILES; f++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "t%02d.txt", f)  );
+		VERIFY_ERR_CHECK(  u0043_pendingtree__verify_same_content(pCtx, pPathWorkingDir, pPathGet, bufFile)  );
+	}
+	for (d=0; d<U0043_FP_NR_DIRS; d++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufDir, sizeof(bufDir), "d%d", d)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDirWD, pPathWorkingDir, bufDir)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDirGet, pPathGet, bufDir)  );
+		for (f=0; f<U0043_FP_NR_FILES; f++)
+		{
+			VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "f%02d.txt", f)  );
+			VERIFY_ERR_CHECK(  u0043_pendingtree__verify_same_content(pCtx, pPathDirWD, pPathDirGet, bufFile)  );
+		}
+		SG_PATHNAME_NULLFREE(pCtx, pPathDirWD);
+		SG_PATHNAME_NULLFREE(pCtx, pPathDirGet);
+	}
+
+	//////////////////////////////////////////////////////////////////
+	// CSET_1: delete every file in d0 and d1 and change the ones at
+	// the top.  updating back to CSET_0 then has to get_file the
+	// deleted ones (through the pool) and alter_file the others.
+
+	for (d=0; d<2; d++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufDir, sizeof(bufDir), "d%d", d)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDirWD, pPathWorkingDir, bufDir)  );
+		for (f=0; f<U0043_FP_NR_FILES; f++)
+		{
+			VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "f%02d.txt", f)  );
+			VERIFY_ERR_CHECK(  _ut_pt__delete_file(pCtx, pPathDirWD, bufFile)  );
+		}
+		SG_PATHNAME_NULLFREE(pCtx, pPathDirWD);
+	}
+	for (f=0; f<U0043_FP_NR_FILES; f++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "t%02d.txt", f)  );
+		VERIFY_ERR_CHECK(  _ut_pt__append_to_file__numbers(pCtx, pPathWorkingDir, bufFile, 7)  );
+	}
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  u0043_pendingtree__commit_all(pCtx, pPathWorkingDir,SG_TRUE)  );
+
+	VERIFY_ERR_CHECK(  SG_PENDINGTREE__ALLOC(pCtx, pPathWorkingDir, SG_FALSE, &pPendingTree)  );
+	VERIFY_ERR_CHECK(  SG_pendingtree__update_baseline(pCtx, pPendingTree, bufCSet_0, SG_FALSE, SG_PT_ACTION__DO_IT)  );
+	SG_PENDINGTREE_NULLFREE(pCtx, pPendingTree);
+
+	VERIFY_ERR_CHECK(  _ut_pt__get_baseline(pCtx, pPathWorkingDir,bufCSet_AfterUpdate,sizeof(bufCSet_AfterUpdate))  );
+	VERIFY_COND("baseline after update", (strcmp(bufCSet_0,bufCSet_AfterUpdate) == 0));
+	VERIFY_WD_JSON_PENDING_CLEAN(pCtx, pPathWorkingDir);
+
+	// the update must look exactly like the checkout of the same cset.
+
+	for (f=0; f<U0043_FP_NR_FILES; f++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "t%02d.txt", f)  );
+		VERIFY_ERR_CHECK(  u0043_pendingtree__verify_same_content(pCtx, pPathWorkingDir, pPathGet, bufFile)  );
+	}
+	for (d=0; d<U0043_FP_NR_DIRS; d++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufDir, sizeof(bufDir), "d%d", d)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDirWD, pPathWorkingDir, bufDir)  );
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDirGet, pPathGet, bufDir)  );
+		for (f=0; f<U0043_FP_NR_FILES; f++)
+		{
+			VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufFile, sizeof(bufFile), "f%02d.txt", f)  );
+			VERIFY_ERR_CHECK(  u0043_pendingtree__verify_same_content(pCtx, pPathDirWD, pPathDirGet, bufFile)  );
+		}
+		SG_PATHNAME_NULLFREE(pCtx, pPathDirWD);
+		SG_PATHNAME_NULLFREE(pCtx, pPathDirGet);
+	}
+
+	//////////////////////////////////////////////////////////////////
+	// checkout into a directory where one of the files is already
+	// present.  the pool can't create it, so the checkout must fail
+	// and must not touch the file that was in the way.
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufGetName, sizeof(bufGetName), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathGetFail, pPathTopDir, bufGetName)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathGetFail)  );
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathGetFail, "t13.txt", 3)  );
+
+	VERIFY_ERR_CHECK_HAS_ERR_DISCARD(  unittests_workingdir__create_and_get(pCtx, bufName, pPathGetFail, SG_FALSE, NULL)  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathFile, pPathGetFail, "t13.txt")  );
+	VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathFile, &len, NULL)  );
+	VERIFYP_COND("file in the way was overwritten", (len == 6),
+				 ("length [%d]", (SG_uint32)len));
+
+fail:
+	SG_PENDINGTREE_NULLFREE(pCtx, pPendingTree);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathGet);
+	SG_PATHNAME_NULLFREE(pCtx, pPathGetFail);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDirWD);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDirGet);
+	SG_PATHNAME_NULLFREE(pCtx, pPathFile);
+}
+
+#undef U0043_FP_NR_DIRS
+#undef U0043_FP_NR_FILES
+
+//////////////////////////////////////////////////////////////////
+
 struct _u0043_pendingtree_text__ctm__data
 {
 	SG_int32				sum;
@@ -10267,6 +10703,8 @@ TEST_MAIN(u0043_pendingtree)
 	BEGIN_TEST(  u0043_pendingtree_test__add_but_no_file(pCtx, pPathTopDir)  );
 	BEGIN_TEST(  u0043_pendingtree_test__add_same_file_twice(pCtx, pPathTopDir)  );
 	BEGIN_TEST(  u0043_pendingtree_test__status(pCtx, pPathTopDir)  );
+	BEGIN_TEST(  u0043_pendingtree_test__dir_cache(pCtx, pPathTopDir)  );
+	BEGIN_TEST(  u0043_pendingtree_test__scan_many_dirs(pCtx, pPathTopDir)  );
 	BEGIN_TEST(  u0043_pendingtree_test__deep_rename_move_delete(pCtx, pPathTopDir)  );
 	BEGIN_TEST(  u0043_pendingtree_test__unsafe_remove_file(pCtx, pPathTopDir)  );
 
@@ -10314,6 +10752,7 @@ TEST_MAIN(u0043_pendingtree)
 	BEGIN_TEST(  u0043_pendingtree_test__partial_revert_conflict(pCtx, pPathTopDir, SG_TRUE)  );
 
 	BEGIN_TEST(  u0043_pendingtree_test__switch_baseline(pCtx, pPathTopDir)  );
+	BEGIN_TEST(  u0043_pendingtree_test__fetch_pool(pCtx, pPathTopDir)  );
 
 	BEGIN_TEST(  u0043_pendingtree_test__revert__implicit_nested_delete_with_moves_to_root(pCtx, pPathTopDir)  );
 #else
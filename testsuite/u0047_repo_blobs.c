@@ -479,6 +479,65 @@ void MyFn(create_zero_byte_blob)(SG_context* pCtx,
 	SG_NULLFREE(pCtx, pszHashMethod);
 }
 
+void MyFn(fetch_big_blob_by_span)(SG_context* pCtx,
+								   SG_repo* pRepo)
+{
+	// store a blob big enough for the fs2/fs3 data file to be mapped
+	// rather than read, and verify that fetching it by span gives back
+	// the same bytes.
+
+	SG_uint32 lenBuf1 = 300*1024;
+	SG_byte * pbuf1 = NULL;
+	SG_byte * pbuf2 = NULL;
+	SG_byte * pbufChunk = NULL;
+	char* pszidHidBlob1 = NULL;
+	SG_repo_tx_handle* pTx = NULL;
+	SG_repo_fetch_blob_handle* pFetchHandle = NULL;
+	SG_uint64 lenFull = 0;
+	SG_uint64 sofar = 0;
+	SG_bool b_done = SG_FALSE;
+	SG_uint32 seed = 12345;
+	SG_uint32 k;
+
+	VERIFY_ERR_CHECK_DISCARD(  SG_allocN(pCtx, lenBuf1, pbuf1)  );
+	VERIFY_ERR_CHECK_DISCARD(  SG_allocN(pCtx, lenBuf1, pbuf2)  );
+	VERIFY_ERR_CHECK_DISCARD(  SG_allocN(pCtx, SG_STREAMING_BUFFER_SIZE, pbufChunk)  );
+
+	// pseudo-random bytes so that zlib can't shrink them below the mapping threshold.
+	for (k=0; k<lenBuf1; k++)
+	{
+		seed = seed * 1103515245 + 12345;
+		pbuf1[k] = (SG_byte)(seed >> 16);
+	}
+
+	VERIFY_ERR_CHECK_DISCARD(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
+	VERIFY_ERR_CHECK_DISCARD(  SG_repo__store_blob_from_memory(pCtx, pRepo,pTx,NULL,SG_FALSE,pbuf1,lenBuf1,&pszidHidBlob1)  );
+	VERIFY_ERR_CHECK_DISCARD(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
+
+	VERIFY_ERR_CHECK_DISCARD(  SG_repo__fetch_blob__begin(pCtx, pRepo, pszidHidBlob1, SG_TRUE, NULL, NULL, NULL, NULL, &lenFull, &pFetchHandle)  );
+	VERIFY_COND("fetch_big_blob_by_span(len)", (lenFull == (SG_uint64)lenBuf1));
+	while (!b_done && (sofar < lenBuf1))
+	{
+		const SG_byte * p_span = NULL;
+		SG_uint32 got = 0;
+
+		VERIFY_ERR_CHECK_DISCARD(  SG_repo__fetch_blob__chunk__span(pCtx, pRepo, pFetchHandle, SG_STREAMING_BUFFER_SIZE, pbufChunk, &p_span, &got, &b_done)  );
+		if (got > (lenBuf1 - sofar))
+			break;
+		memcpy(pbuf2 + sofar, p_span, got);
+		sofar += got;
+	}
+	VERIFY_ERR_CHECK_DISCARD(  SG_repo__fetch_blob__end(pCtx, pRepo, &pFetchHandle)  );
+
+	VERIFY_COND("fetch_big_blob_by_span(sofar)", (sofar == (SG_uint64)lenBuf1));
+	VERIFY_COND("fetch_big_blob_by_span(memcmp)", (memcmp(pbuf1,pbuf2,lenBuf1)==0));
+
+	SG_NULLFREE(pCtx, pbuf1);
+	SG_NULLFREE(pCtx, pbuf2);
+	SG_NULLFREE(pCtx, pbufChunk);
+	SG_NULLFREE(pCtx, pszidHidBlob1);
+}
+
 //////////////////////////////////////////////////////////////////
 
 MyMain()
@@ -495,6 +554,7 @@ MyMain()
 	BEGIN_TEST(  MyFn(create_some_blobs_from_files)(pCtx, pRepo,pPathnameTempDir)  );
 
 	BEGIN_TEST(  MyFn(create_zero_byte_blob)(pCtx, pRepo)  );
+	BEGIN_TEST(  MyFn(fetch_big_blob_by_span)(pCtx, pRepo)  );
 
 	//////////////////////////////////////////////////////////////////
 	// TODO delete repo directory and everything we created under it.
@@ -369,6 +369,42 @@ fail:
 	return;
 }
 
+static void u0054_repo_encodings__read_file(
+	SG_context* pCtx,
+	SG_pathname* pPath,
+	const char* pszName,
+	SG_byte** ppBuf,
+	SG_uint64* pLen
+	)
+{
+	SG_pathname* pPathFile = NULL;
+	SG_file* pFile = NULL;
+	SG_byte* pBuf = NULL;
+	SG_uint64 len = 0;
+	SG_uint32 got = 0;
+	SG_uint64 sofar = 0;
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathFile, pPath, pszName)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathFile, &len, NULL)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)len + 1, pBuf)  );
+	VERIFY_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathFile, SG_FILE_RDONLY | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFile)  );
+	while (sofar < len)
+	{
+		VERIFY_ERR_CHECK(  SG_file__read(pCtx, pFile, (SG_uint32)(len - sofar), pBuf + sofar, &got)  );
+		sofar += got;
+	}
+	VERIFY_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+
+	*ppBuf = pBuf;
+	pBuf = NULL;
+	*pLen = len;
+
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+	SG_NULLFREE(pCtx, pBuf);
+	SG_PATHNAME_NULLFREE(pCtx, pPathFile);
+}
+
 static void u0054_repo_encodings__scan(
 	SG_context* pCtx,
 	const SG_pathname* pPathWorkingDir
@@ -410,6 +446,15 @@ static int u0054_repo_encodings_test__1(SG_context* pCtx,SG_pathname* pPathTopDi
 	SG_repo_tx_handle* pTx = NULL;
     SG_bool b_supports_change_blob_encoding = SG_FALSE;
     SG_bool b_supports_vacuum = SG_FALSE;
+    SG_byte* pBuf_1 = NULL;
+    SG_byte* pBuf_2 = NULL;
+    SG_byte* pBuf_orig = NULL;
+    SG_uint64 len_1 = 0;
+    SG_uint64 len_2 = 0;
+    SG_uint64 len_orig = 0;
+    SG_repo_pack_policy policy;
+    SG_vhash* pvh_chain_depths = NULL;
+    SG_bool b_deep = SG_FALSE;
 
 	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
 
@@ -452,26 +497,67 @@ static int u0054_repo_encodings_test__1(SG_context* pCtx,SG_pathname* pPathTopDi
     {
         // We want to make sure we test full->zlib and zlib->full regardless of the repo's compression policy...
         VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__ZLIB, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
+        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__ZLIB, NULL, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
         VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
         VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__FULL, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
+        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__FULL, NULL, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
         VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
         // ...so we run these tests twice.
         VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__ZLIB, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
+        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__ZLIB, NULL, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
         VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
         VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__FULL, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
+        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__FULL, NULL, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
         VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
 
         VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_2, SG_BLOBENCODING__VCDIFF, buf_hid_1, &blob_encoding, &psz_hid_vcdiff_reference, &len_encoded, &len_full)  );
+        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_2, SG_BLOBENCODING__VCDIFF, buf_hid_1, NULL, &blob_encoding, &psz_hid_vcdiff_reference, &len_encoded, &len_full)  );
         VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
         SG_NULLFREE(pCtx, psz_hid_vcdiff_reference);
 
+        // Fetch the delta twice from the same repo instance.  Both must
+        // give back what is in the working copy of the file.  (The cache
+        // hits themselves are checked in u0054_repo_encodings_test__refcache.)
+        VERIFY_ERR_CHECK(  u0054_repo_encodings__read_file(pCtx, pPathWorkingDir, "a", &pBuf_orig, &len_orig)  );
+        VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, buf_hid_2, &pBuf_1, &len_1)  );
+        VERIFY_COND("len", (len_1 == len_orig));
+        VERIFY_COND("content", ((len_1 == len_orig) && (0 == memcmp(pBuf_1, pBuf_orig, (size_t) len_1))));
+        VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, buf_hid_2, &pBuf_2, &len_2)  );
+        VERIFY_COND("len", (len_2 == len_orig));
+        VERIFY_COND("content", ((len_2 == len_orig) && (0 == memcmp(pBuf_2, pBuf_orig, (size_t) len_2))));
+        SG_NULLFREE(pCtx, pBuf_2);
+        SG_NULLFREE(pCtx, pBuf_orig);
+
+        // Run the whole-repo unpacker and packers over it.  The contents
+        // must survive all of them.
+        VERIFY_ERR_CHECK(  SG_repo__unpack(pCtx, pRepo, SG_BLOBENCODING__VCDIFF)  );
+        VERIFY_ERR_CHECK(  SG_repo__unpack(pCtx, pRepo, SG_BLOBENCODING__ZLIB)  );
+        VERIFY_ERR_CHECK(  SG_repo__pack__zlib(pCtx, pRepo)  );
+        VERIFY_ERR_CHECK(  SG_repo__pack__vcdiff(pCtx, pRepo)  );
+        VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, buf_hid_2, &pBuf_2, &len_2)  );
+        VERIFY_COND("len after pack", (len_1 == len_2));
+        VERIFY_COND("content after pack", (0 == memcmp(pBuf_1, pBuf_2, (size_t) len_1)));
+        SG_NULLFREE(pCtx, pBuf_2);
+
+        // Repack oldest-first with no chain deeper than 1.  That has to
+        // undo the newest-first deltas the default policy just made.
+        policy.max_chain_depth = 1;
+        policy.keyframe_interval = 0;
+        policy.b_reverse = SG_FALSE;
+        policy.vcdiff_method = SG_VCDIFF_METHOD__WINDOW;
+        VERIFY_ERR_CHECK(  SG_repo__pack__vcdiff__policy(pCtx, pRepo, &policy)  );
+        VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, &pvh_chain_depths)  );
+        VERIFY_ERR_CHECK(  SG_vhash__has(pCtx, pvh_chain_depths, "2", &b_deep)  );
+        VERIFY_COND("chain depth", (!b_deep));
+        SG_VHASH_NULLFREE(pCtx, pvh_chain_depths);
+        VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, buf_hid_2, &pBuf_2, &len_2)  );
+        VERIFY_COND("len after repack", (len_1 == len_2));
+        VERIFY_COND("content after repack", (0 == memcmp(pBuf_1, pBuf_2, (size_t) len_1)));
+        SG_NULLFREE(pCtx, pBuf_1);
+        SG_NULLFREE(pCtx, pBuf_2);
+
         VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
-        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__ZLIB, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
+        VERIFY_ERR_CHECK(  SG_repo__change_blob_encoding(pCtx, pRepo, pTx, buf_hid_1, SG_BLOBENCODING__ZLIB, NULL, NULL, &blob_encoding, NULL, &len_encoded, &len_full)  );
         VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
     }
 
@@ -502,6 +588,10 @@ static int u0054_repo_encodings_test__1(SG_context* pCtx,SG_pathname* pPathTopDi
 
 fail:
 	SG_VHASH_NULLFREE(pCtx, pvh);
+	SG_VHASH_NULLFREE(pCtx, pvh_chain_depths);
+	SG_NULLFREE(pCtx, pBuf_1);
+	SG_NULLFREE(pCtx, pBuf_2);
+	SG_NULLFREE(pCtx, pBuf_orig);
 
 	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
 	SG_PATHNAME_NULLFREE(pCtx, pPathFile);
@@ -510,6 +600,166 @@ fail:
 	return 0;
 }
 
+static void u0054_repo_encodings__verify_refcache(
+	SG_context* pCtx,
+	SG_repo* pRepo,
+	SG_int64 hits,
+	SG_int64 misses
+	)
+{
+	SG_vhash* pvhStats = NULL;
+	SG_int64 i64 = 0;
+
+	SG_repo__get_refcache_stats(pCtx, pRepo, &pvhStats);
+	if (SG_context__err_equals(pCtx, SG_ERR_NOTIMPLEMENTED))
+	{
+		SG_context__err_reset(pCtx);
+		return;		// this storage implementation doesn't cache references
+	}
+	if (!VERIFY_CTX_IS_OK("get_refcache_stats", pCtx))
+		goto fail;
+
+	VERIFY_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvhStats, "hits", &i64)  );
+	VERIFYP_COND("refcache hits", (i64 == hits), ("hits %d, expected %d", (SG_int32)i64, (SG_int32)hits));
+	VERIFY_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvhStats, "misses", &i64)  );
+	VERIFYP_COND("refcache misses", (i64 == misses), ("misses %d, expected %d", (SG_int32)i64, (SG_int32)misses));
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvhStats);
+}
+
+/**
+ * Store a blob as a VCDIFF against another one and fetch it repeatedly
+ * from one repo instance.  This works with the default storage (fs3),
+ * which can't change blob encodings after the fact, because we hand it
+ * the delta ourselves.
+ */
+static int u0054_repo_encodings_test__refcache(SG_context* pCtx,SG_pathname* pPathTopDir)
+{
+	char bufName[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_pathname* pPathV1 = NULL;
+	SG_pathname* pPathV2 = NULL;
+	SG_pathname* pPathDelta = NULL;
+	SG_repo* pRepo = NULL;
+	SG_repo_tx_handle* pTx = NULL;
+	SG_repo_store_blob_handle* pbh = NULL;
+	SG_byte* pBuf_v1 = NULL;
+	SG_byte* pBuf_v2 = NULL;
+	SG_byte* pBuf_delta = NULL;
+	SG_byte* pBuf = NULL;
+	SG_uint64 len_v1 = 0;
+	SG_uint64 len_v2 = 0;
+	SG_uint64 len_delta = 0;
+	SG_uint64 len = 0;
+	char* psz_hid_1 = NULL;
+	char* psz_hid_2 = NULL;
+	char* psz_hid_stored = NULL;
+	SG_uint32 k;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, bufName)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx, bufName, pPathWorkingDir)  );
+
+	/* make two versions of a file and a delta between them.  they stay
+	 * out of version control; we only use the bytes. */
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__create_file__numbers(pCtx, pPathWorkingDir, "v1", 2000)  );
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__create_file__numbers(pCtx, pPathWorkingDir, "v2", 2000)  );
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__append_to_file__numbers(pCtx, pPathWorkingDir, "v2", 10)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathV1, pPathWorkingDir, "v1")  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathV2, pPathWorkingDir, "v2")  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathDelta, pPathWorkingDir, "delta")  );
+	VERIFY_ERR_CHECK(  SG_vcdiff__deltify__files(pCtx, pPathV1, pPathV2, pPathDelta)  );
+
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__read_file(pCtx, pPathWorkingDir, "v1", &pBuf_v1, &len_v1)  );
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__read_file(pCtx, pPathWorkingDir, "v2", &pBuf_v2, &len_v2)  );
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__read_file(pCtx, pPathWorkingDir, "delta", &pBuf_delta, &len_delta)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, bufName, &pRepo)  );
+	VERIFY_ERR_CHECK(  SG_repo__alloc_compute_hash__from_bytes(pCtx, pRepo, (SG_uint32)len_v2, pBuf_v2, &psz_hid_2)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
+	VERIFY_ERR_CHECK(  SG_repo__store_blob_from_memory(pCtx, pRepo, pTx, NULL, SG_FALSE, pBuf_v1, (SG_uint32)len_v1, &psz_hid_1)  );
+	VERIFY_ERR_CHECK(  SG_repo__store_blob__begin(pCtx, pRepo, pTx, NULL, SG_BLOBENCODING__VCDIFF, psz_hid_1, len_v2, len_delta, psz_hid_2, &pbh)  );
+	VERIFY_ERR_CHECK(  SG_repo__store_blob__chunk(pCtx, pRepo, pbh, (SG_uint32)len_delta, pBuf_delta, NULL)  );
+	VERIFY_ERR_CHECK(  SG_repo__store_blob__end(pCtx, pRepo, pTx, &pbh, &psz_hid_stored)  );
+	VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
+	VERIFY_COND("stored hid", (0 == strcmp(psz_hid_stored, psz_hid_2)));
+
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__verify_refcache(pCtx, pRepo, 0, 0)  );
+
+	/* The first fetch has to rebuild the reference; every later one
+	 * should find it in the cache.  The content must match the file we
+	 * made the delta from every time. */
+	for (k=0; k<3; k++)
+	{
+		VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, psz_hid_2, &pBuf, &len)  );
+		VERIFYP_COND("len", (len == len_v2), ("fetch %d", k));
+		VERIFYP_COND("content", ((len == len_v2) && (0 == memcmp(pBuf, pBuf_v2, (size_t) len))), ("fetch %d", k));
+		SG_NULLFREE(pCtx, pBuf);
+
+		VERIFY_ERR_CHECK(  u0054_repo_encodings__verify_refcache(pCtx, pRepo, k, 1)  );
+	}
+
+	/* the reference itself is not a delta, so fetching it doesn't touch the cache. */
+	VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, psz_hid_1, &pBuf, &len)  );
+	VERIFY_COND("len v1", (len == len_v1));
+	VERIFY_COND("content v1", ((len == len_v1) && (0 == memcmp(pBuf, pBuf_v1, (size_t) len))));
+	SG_NULLFREE(pCtx, pBuf);
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__verify_refcache(pCtx, pRepo, 2, 1)  );
+
+	/* a new instance starts with an empty cache. */
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, bufName, &pRepo)  );
+	VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, psz_hid_2, &pBuf, &len)  );
+	VERIFY_COND("content reopened", ((len == len_v2) && (0 == memcmp(pBuf, pBuf_v2, (size_t) len))));
+	SG_NULLFREE(pCtx, pBuf);
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__verify_refcache(pCtx, pRepo, 0, 1)  );
+
+	/* after dropping the caches, the reference has to be rebuilt again. */
+	VERIFY_ERR_CHECK(  SG_repo__drop_caches(pCtx, pRepo)  );
+	VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pRepo, psz_hid_2, &pBuf, &len)  );
+	VERIFY_COND("content after drop", ((len == len_v2) && (0 == memcmp(pBuf, pBuf_v2, (size_t) len))));
+	SG_NULLFREE(pCtx, pBuf);
+	VERIFY_ERR_CHECK(  u0054_repo_encodings__verify_refcache(pCtx, pRepo, 0, 2)  );
+
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	SG_NULLFREE(pCtx, pBuf_v1);
+	SG_NULLFREE(pCtx, pBuf_v2);
+	SG_NULLFREE(pCtx, pBuf_delta);
+	SG_NULLFREE(pCtx, psz_hid_1);
+	SG_NULLFREE(pCtx, psz_hid_2);
+	SG_NULLFREE(pCtx, psz_hid_stored);
+	SG_PATHNAME_NULLFREE(pCtx, pPathV1);
+	SG_PATHNAME_NULLFREE(pCtx, pPathV2);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDelta);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+
+	return 1;
+
+fail:
+	if (pbh)
+		SG_ERR_IGNORE(  SG_repo__store_blob__abort(pCtx, pRepo, pTx, &pbh)  );
+	if (pTx)
+		SG_ERR_IGNORE(  SG_repo__abort_tx(pCtx, pRepo, &pTx)  );
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	SG_NULLFREE(pCtx, pBuf);
+	SG_NULLFREE(pCtx, pBuf_v1);
+	SG_NULLFREE(pCtx, pBuf_v2);
+	SG_NULLFREE(pCtx, pBuf_delta);
+	SG_NULLFREE(pCtx, psz_hid_1);
+	SG_NULLFREE(pCtx, psz_hid_2);
+	SG_NULLFREE(pCtx, psz_hid_stored);
+	SG_PATHNAME_NULLFREE(pCtx, pPathV1);
+	SG_PATHNAME_NULLFREE(pCtx, pPathV2);
+	SG_PATHNAME_NULLFREE(pCtx, pPathDelta);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+
+	return 0;
+}
+
 TEST_MAIN(u0054_repo_encodings)
 {
 	char bufTopDir[SG_TID_MAX_BUFFER_LENGTH];
@@ -522,6 +772,7 @@ TEST_MAIN(u0054_repo_encodings)
 	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathTopDir)  );
 
 	BEGIN_TEST(  u0054_repo_encodings_test__1(pCtx, pPathTopDir)  );
+	BEGIN_TEST(  u0054_repo_encodings_test__refcache(pCtx, pPathTopDir)  );
 
 	/* TODO rm -rf the top dir */
 
@@ -142,7 +142,7 @@ void MyFn(no_repo_tx)(SG_context * pCtx, SG_repo* pRepo)
     if (b_supports_change_blob_encoding)
     {
         VERIFY_ERR_CHECK_ERR_EQUALS_DISCARD(  SG_repo__change_blob_encoding(pCtx, pRepo, NULL, pszHidReturned, SG_BLOBENCODING__FULL, NULL,
-                                                                            NULL, NULL, NULL, NULL),
+                                                                            NULL, NULL, NULL, NULL, NULL),
                                               SG_ERR_INVALIDARG  );		// change_blob_encoding without repo tx didn't fail with INVALIDARG.
     }
 
@@ -249,7 +249,7 @@ void MyFn(abort_mid_blob)(SG_context * pCtx, SG_repo* pRepo)
 	SG_uint32 iLenWritten = 0;
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsBefore, NULL, &iCountZlibBlobsBefore, &iCountVcdBlobsBefore,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_ERR_CHECK(  MyFn(alloc_random_buffer)(pCtx, &pRandomBuf, &lenRandomBuf)  );
 	lenTotal = lenRandomBuf * 5;
@@ -269,7 +269,7 @@ void MyFn(abort_mid_blob)(SG_context * pCtx, SG_repo* pRepo)
 	SG_NULLFREE(pCtx, pRandomBuf);
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsAfter, NULL, &iCountZlibBlobsAfter, &iCountVcdBlobsAfter,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_COND("Full blob count mismatch", iCountFullBlobsBefore == iCountFullBlobsAfter);
 	VERIFY_COND("Zlib blob count mismatch", iCountZlibBlobsBefore == iCountZlibBlobsAfter);
@@ -303,7 +303,7 @@ void MyFn(commit_mid_blob)(SG_context * pCtx, SG_repo* pRepo)
 	SG_uint32 iLenWritten = 0;
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsBefore, NULL, &iCountZlibBlobsBefore, &iCountVcdBlobsBefore,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_ERR_CHECK(  MyFn(alloc_random_buffer)(pCtx, &pRandomBuf, &lenRandomBuf)  );
 	lenTotal = lenRandomBuf * 5;
@@ -327,7 +327,7 @@ void MyFn(commit_mid_blob)(SG_context * pCtx, SG_repo* pRepo)
 	SG_NULLFREE(pCtx, pRandomBuf);
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsAfter, NULL, &iCountZlibBlobsAfter, &iCountVcdBlobsAfter,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_COND("Full blob count mismatch", iCountFullBlobsBefore == iCountFullBlobsAfter);
 	VERIFY_COND("Zlib blob count mismatch", iCountZlibBlobsBefore == iCountZlibBlobsAfter);
@@ -366,7 +366,7 @@ void MyFn(eight_blobs_commit_masked)(SG_context * pCtx, SG_repo* pRepo, SG_uint8
 		countBlobsToAdd += mask & 1;
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsBefore, NULL, &iCountZlibBlobsBefore, &iCountVcdBlobsBefore,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
 
@@ -402,7 +402,7 @@ void MyFn(eight_blobs_commit_masked)(SG_context * pCtx, SG_repo* pRepo, SG_uint8
 	VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsAfter, NULL, &iCountZlibBlobsAfter, &iCountVcdBlobsAfter,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_COND("blob count mismatch", iCountFullBlobsBefore + iCountZlibBlobsBefore + iCountVcdBlobsBefore + countBlobsToAdd
 		== iCountFullBlobsAfter + iCountZlibBlobsAfter + iCountVcdBlobsAfter);
@@ -440,7 +440,7 @@ void MyFn(multiple_stores_fail)(SG_context * pCtx, SG_repo* pRepo)
 	SG_repo_store_blob_handle* pbh2;
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsBefore, NULL, &iCountZlibBlobsBefore, &iCountVcdBlobsBefore,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
 
@@ -454,7 +454,7 @@ void MyFn(multiple_stores_fail)(SG_context * pCtx, SG_repo* pRepo)
 	VERIFY_ERR_CHECK(  SG_repo__abort_tx(pCtx, pRepo, &pTx)  );
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsAfter, NULL, &iCountZlibBlobsAfter, &iCountVcdBlobsAfter,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_COND("Full blob count mismatch", iCountFullBlobsBefore == iCountFullBlobsAfter);
 	VERIFY_COND("Zlib blob count mismatch", iCountZlibBlobsBefore == iCountZlibBlobsAfter);
@@ -478,14 +478,14 @@ void MyFn(empty_tx)(SG_context * pCtx, SG_repo* pRepo)
 	SG_repo_tx_handle* pTx = NULL;
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsBefore, NULL, &iCountZlibBlobsBefore, &iCountVcdBlobsBefore,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	// Commit empty tx.
 	VERIFY_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &pTx)  );
 	VERIFY_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &pTx)  );
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsAfter, NULL, &iCountZlibBlobsAfter, &iCountVcdBlobsAfter,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_COND("Full blob count mismatch", iCountFullBlobsBefore == iCountFullBlobsAfter);
 	VERIFY_COND("Zlib blob count mismatch", iCountZlibBlobsBefore == iCountZlibBlobsAfter);
@@ -496,7 +496,7 @@ void MyFn(empty_tx)(SG_context * pCtx, SG_repo* pRepo)
 	VERIFY_ERR_CHECK(  SG_repo__abort_tx(pCtx, pRepo, &pTx)  );
 
 	VERIFY_ERR_CHECK(  SG_repo__get_blob_stats(pCtx, pRepo, &iCountFullBlobsAfter, NULL, &iCountZlibBlobsAfter, &iCountVcdBlobsAfter,
-		NULL, NULL, NULL, NULL, NULL, NULL)  );
+		NULL, NULL, NULL, NULL, NULL, NULL, NULL)  );
 
 	VERIFY_COND("Full blob count mismatch", iCountFullBlobsBefore == iCountFullBlobsAfter);
 	VERIFY_COND("Zlib blob count mismatch", iCountZlibBlobsBefore == iCountZlibBlobsAfter);
@@ -488,6 +488,528 @@ fail:
 	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
 }
 
+/**
+ * A fragball stream must produce exactly the bytes of the equivalent
+ * fragball file, and must know its length before it is read.
+ */
+void MyFn(test__fragball_stream)(SG_context* pCtx)
+{
+	char bufTopDir[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathTopDir = NULL;
+	char buf_repo_name[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_repo* pRepo = NULL;
+	SG_rbtree* prb_leaves = NULL;
+	SG_rbtree_iterator* pit = NULL;
+	SG_bool b = SG_FALSE;
+	const char* psz_hid = NULL;
+	SG_pathname* pPathFragball = NULL;
+	SG_fragball_stream* pfs = NULL;
+	SG_file* pFile = NULL;
+	SG_uint64 len_file = 0;
+	SG_uint64 len_stream = 0;
+	SG_byte* p_file = NULL;
+	SG_byte* p_stream = NULL;
+	SG_uint32 count_read = 0;
+	SG_bool b_done = SG_FALSE;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufTopDir, sizeof(bufTopDir), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__SZ(pCtx,&pPathTopDir,bufTopDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx,pPathTopDir)  );
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, buf_repo_name, sizeof(buf_repo_name), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, buf_repo_name)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo2(pCtx, buf_repo_name, pPathWorkingDir, NULL)  );
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, buf_repo_name, &pRepo)  );
+
+	VERIFY_ERR_CHECK(  MyFn(create_file__numbers)(pCtx, pPathWorkingDir, "aaa", 1000)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx, pPathWorkingDir, NULL)  );
+
+	/* the same leaves and changeset blobs, once as a file and once as a stream */
+	VERIFY_ERR_CHECK(  SG_repo__fetch_dag_leaves(pCtx, pRepo, SG_DAGNUM__VERSION_CONTROL, &prb_leaves)  );
+
+	VERIFY_ERR_CHECK(  SG_fragball__create(pCtx, pPathTopDir, &pPathFragball)  );
+	VERIFY_ERR_CHECK(  SG_fragball__append__dagnodes(pCtx, pPathFragball, pRepo, SG_DAGNUM__VERSION_CONTROL, prb_leaves)  );
+	VERIFY_ERR_CHECK(  SG_fragball_stream__alloc(pCtx, pRepo, &pfs)  );
+	VERIFY_ERR_CHECK(  SG_fragball_stream__add_dagnodes(pCtx, pfs, SG_DAGNUM__VERSION_CONTROL, prb_leaves)  );
+
+	VERIFY_ERR_CHECK(  SG_rbtree__iterator__first(pCtx, &pit, prb_leaves, &b, &psz_hid, NULL)  );
+	while (b)
+	{
+		VERIFY_ERR_CHECK(  SG_fragball__append__blob(pCtx, pPathFragball, pRepo, psz_hid)  );
+		VERIFY_ERR_CHECK(  SG_fragball_stream__add_blobs(pCtx, pfs, &psz_hid, 1)  );
+		VERIFY_ERR_CHECK(  SG_rbtree__iterator__next(pCtx, pit, &b, &psz_hid, NULL)  );
+	}
+
+	VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathFragball, &len_file, NULL)  );
+	VERIFY_ERR_CHECK(  SG_fragball_stream__get_length(pCtx, pfs, &len_stream)  );
+	VERIFY_COND_FAIL("stream length matches file", len_file == len_stream);
+
+	VERIFY_ERR_CHECK(  SG_alloc(pCtx, (SG_uint32) len_file, 1, &p_file)  );
+	VERIFY_ERR_CHECK(  SG_alloc(pCtx, (SG_uint32) len_file + 1, 1, &p_stream)  );
+
+	VERIFY_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathFragball, SG_FILE_RDONLY | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFile)  );
+	VERIFY_ERR_CHECK(  SG_file__read(pCtx, pFile, (SG_uint32) len_file, p_file, NULL)  );
+	VERIFY_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+
+	/* read the stream in small, odd-sized pieces so objects get split */
+	len_stream = 0;
+	while (!b_done)
+	{
+		VERIFY_COND_FAIL("stream not longer than promised", len_stream <= len_file);
+		VERIFY_ERR_CHECK(  SG_fragball_stream__read(pCtx, pfs, SG_MIN(7, (SG_uint32) (len_file + 1 - len_stream)), p_stream + len_stream, &count_read, &b_done)  );
+		len_stream += count_read;
+	}
+	VERIFY_COND_FAIL("stream read length matches file", len_file == len_stream);
+	VERIFY_COND_FAIL("stream bytes match file", 0 == memcmp(p_file, p_stream, (size_t) len_file));
+
+	/* Fall through to common cleanup */
+
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+	SG_NULLFREE(pCtx, p_file);
+	SG_NULLFREE(pCtx, p_stream);
+	SG_FRAGBALL_STREAM_NULLFREE(pCtx, pfs);
+	SG_FRAGBALL_NULLFREE(pCtx, pPathFragball);
+	SG_RBTREE_ITERATOR_NULLFREE(pCtx, pit);
+	SG_RBTREE_NULLFREE(pCtx, prb_leaves);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathTopDir);
+}
+
+/**
+ * The content of blob i in a numbered series: a line repeated a
+ * varying number of times, so the blobs are all different sizes.
+ */
+void MyFn(numbered_blob)(
+	SG_context* pCtx,
+	const char* pszPrefix,
+	SG_uint32 i,
+	SG_string** ppstr
+	)
+{
+	SG_string* pstr = NULL;
+	SG_uint32 k;
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
+	for (k=0; k<=(i % 50); k++)
+	{
+		SG_ERR_CHECK(  SG_string__append__format(pCtx, pstr, "%s %d line %d\n", pszPrefix, i, k)  );
+	}
+
+	*ppstr = pstr;
+	return;
+
+fail:
+	SG_STRING_NULLFREE(pCtx, pstr);
+}
+
+void MyFn(store_numbered_blobs)(
+	SG_context* pCtx,
+	SG_repo* pRepo,
+	const char* pszPrefix,
+	SG_uint32 count,
+	SG_stringarray** ppsaHids
+	)
+{
+	SG_repo_tx_handle* ptx = NULL;
+	SG_stringarray* psa = NULL;
+	SG_string* pstr = NULL;
+	char* pszHid = NULL;
+	SG_uint32 i;
+
+	SG_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psa, count)  );
+	SG_ERR_CHECK(  SG_repo__begin_tx(pCtx, pRepo, &ptx)  );
+	for (i=0; i<count; i++)
+	{
+		SG_ERR_CHECK(  MyFn(numbered_blob)(pCtx, pszPrefix, i, &pstr)  );
+		SG_ERR_CHECK(  SG_repo__store_blob_from_memory(pCtx, pRepo, ptx, NULL, SG_FALSE, (const SG_byte*) SG_string__sz(pstr), SG_string__length_in_bytes(pstr), &pszHid)  );
+		SG_ERR_CHECK(  SG_stringarray__add(pCtx, psa, pszHid)  );
+		SG_NULLFREE(pCtx, pszHid);
+		SG_STRING_NULLFREE(pCtx, pstr);
+	}
+	SG_ERR_CHECK(  SG_repo__commit_tx(pCtx, pRepo, &ptx)  );
+
+	*ppsaHids = psa;
+	return;
+
+fail:
+	if (ptx)
+		SG_ERR_IGNORE(  SG_repo__abort_tx(pCtx, pRepo, &ptx)  );
+	SG_NULLFREE(pCtx, pszHid);
+	SG_STRING_NULLFREE(pCtx, pstr);
+	SG_STRINGARRAY_NULLFREE(pCtx, psa);
+}
+
+/**
+ * Put the given blobs into a fragball in a new staging area for the
+ * other repo.  With bCorruptLast, the last byte of the fragball (the
+ * end of the last blob) is flipped after it has been slurped.
+ */
+void MyFn(stage_blobs)(
+	SG_context* pCtx,
+	SG_repo* pRepo,
+	const char* pszOtherRepoName,
+	const SG_stringarray* psaHids,
+	SG_bool bCorruptLast,
+	SG_staging** ppStaging
+	)
+{
+	SG_staging* pStaging = NULL;
+	char* pszStagingId = NULL;
+	const SG_pathname* pPathStaging = NULL;
+	SG_pathname* pPathFragball = NULL;
+	SG_string* pstrFragball = NULL;
+	SG_file* pFile = NULL;
+	SG_uint32 count = 0;
+	SG_uint32 i;
+
+	SG_ERR_CHECK(  SG_staging__create(pCtx, pszOtherRepoName, &pszStagingId, &pStaging)  );
+	SG_ERR_CHECK(  SG_staging__get_pathname(pCtx, pStaging, &pPathStaging)  );
+
+	SG_ERR_CHECK(  SG_fragball__create(pCtx, pPathStaging, &pPathFragball)  );
+	SG_ERR_CHECK(  SG_stringarray__count(pCtx, psaHids, &count)  );
+	for (i=0; i<count; i++)
+	{
+		const char* pszHid = NULL;
+
+		SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaHids, i, &pszHid)  );
+		SG_ERR_CHECK(  SG_fragball__append__blob(pCtx, pPathFragball, pRepo, pszHid)  );
+	}
+
+	SG_ERR_CHECK(  SG_pathname__get_last(pCtx, pPathFragball, &pstrFragball)  );
+	SG_ERR_CHECK(  SG_staging__slurp_fragball(pCtx, pStaging, SG_string__sz(pstrFragball))  );
+
+	if (bCorruptLast)
+	{
+		SG_uint64 len = 0;
+		SG_byte b = 0;
+
+		SG_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathFragball, &len, NULL)  );
+		SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathFragball, SG_FILE_RDWR | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFile)  );
+		SG_ERR_CHECK(  SG_file__seek(pCtx, pFile, len - 1)  );
+		SG_ERR_CHECK(  SG_file__read(pCtx, pFile, 1, &b, NULL)  );
+		b = (SG_byte) ~b;
+		SG_ERR_CHECK(  SG_file__seek(pCtx, pFile, len - 1)  );
+		SG_ERR_CHECK(  SG_file__write(pCtx, pFile, 1, &b, NULL)  );
+		SG_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+	}
+
+	*ppStaging = pStaging;
+	pStaging = NULL;
+
+	/* fall through */
+
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+	SG_STRING_NULLFREE(pCtx, pstrFragball);
+	SG_PATHNAME_NULLFREE(pCtx, pPathFragball);
+	SG_NULLFREE(pCtx, pszStagingId);
+	if (pStaging)
+		SG_ERR_IGNORE(  SG_staging__cleanup(pCtx, &pStaging)  );
+}
+
+/**
+ * Committing a staging area stores its blobs through a work queue.
+ * Commit a few hundred blobs of assorted sizes and check that every
+ * one arrived intact.  Then commit a fragball whose last blob has
+ * been damaged: the worker that verifies it must fail the whole
+ * commit, with the verification error rather than some other one,
+ * and none of that fragball's blobs may be left in the repo.
+ */
+void MyFn(test__staging_many_blobs)(SG_context* pCtx)
+{
+	char bufTopDir[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathTopDir = NULL;
+	char buf_repo_name[SG_TID_MAX_BUFFER_LENGTH];
+	char buf_clone_name[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_repo* pRepo = NULL;
+	SG_repo* pClone = NULL;
+	SG_stringarray* psaGood = NULL;
+	SG_stringarray* psaBad = NULL;
+	SG_staging* pStaging = NULL;
+	SG_string* pstr = NULL;
+	SG_byte* pBuf = NULL;
+	SG_uint64 len = 0;
+	SG_error err = SG_ERR_OK;
+	SG_uint32 count = 0;
+	SG_uint32 i;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufTopDir, sizeof(bufTopDir), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__SZ(pCtx,&pPathTopDir,bufTopDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx,pPathTopDir)  );
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, buf_repo_name, sizeof(buf_repo_name), 32)  );
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, buf_clone_name, sizeof(buf_clone_name), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, buf_repo_name)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo2(pCtx, buf_repo_name, pPathWorkingDir, NULL)  );
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, buf_repo_name, &pRepo)  );
+	VERIFY_ERR_CHECK(  SG_repo__create_empty_clone(pCtx, buf_repo_name, buf_clone_name)  );
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, buf_clone_name, &pClone)  );
+
+	/* many blobs, all good */
+	VERIFY_ERR_CHECK(  MyFn(store_numbered_blobs)(pCtx, pRepo, "good", 300, &psaGood)  );
+	VERIFY_ERR_CHECK(  MyFn(stage_blobs)(pCtx, pRepo, buf_clone_name, psaGood, SG_FALSE, &pStaging)  );
+	VERIFY_ERR_CHECK(  SG_staging__commit(pCtx, pStaging)  );
+	VERIFY_ERR_CHECK(  SG_staging__cleanup(pCtx, &pStaging)  );
+
+	VERIFY_ERR_CHECK(  SG_stringarray__count(pCtx, psaGood, &count)  );
+	for (i=0; i<count; i++)
+	{
+		const char* pszHid = NULL;
+
+		VERIFY_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaGood, i, &pszHid)  );
+		VERIFY_ERR_CHECK(  MyFn(numbered_blob)(pCtx, "good", i, &pstr)  );
+		VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pClone, pszHid, &pBuf, &len)  );
+		VERIFY_COND_FAIL("staged blob length", (len == SG_string__length_in_bytes(pstr)));
+		VERIFY_COND_FAIL("staged blob content", (0 == memcmp(pBuf, SG_string__sz(pstr), (size_t) len)));
+		SG_NULLFREE(pCtx, pBuf);
+		SG_STRING_NULLFREE(pCtx, pstr);
+	}
+
+	/* many blobs, the last one damaged */
+	VERIFY_ERR_CHECK(  MyFn(store_numbered_blobs)(pCtx, pRepo, "bad", 300, &psaBad)  );
+	VERIFY_ERR_CHECK(  MyFn(stage_blobs)(pCtx, pRepo, buf_clone_name, psaBad, SG_TRUE, &pStaging)  );
+	SG_staging__commit(pCtx, pStaging);
+	VERIFY_CTX_HAS_ERR("commit of a damaged blob fails", pCtx);
+	(void) SG_context__get_err(pCtx, &err);
+	SG_context__err_reset(pCtx);
+	VERIFY_COND_FAIL("commit fails verifying the damaged blob",
+					 ((SG_ERR_BLOB_NOT_VERIFIED_MISMATCH == err) || (__SG_ERR__ZLIB__ == SG_ERR_TYPE(err))));
+	VERIFY_ERR_CHECK(  SG_staging__cleanup(pCtx, &pStaging)  );
+
+	VERIFY_ERR_CHECK(  SG_stringarray__count(pCtx, psaBad, &count)  );
+	for (i=0; i<count; i++)
+	{
+		const char* pszHid = NULL;
+
+		VERIFY_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaBad, i, &pszHid)  );
+		VERIFY_ERR_CHECK_HAS_ERR_DISCARD(  SG_repo__fetch_blob_into_memory(pCtx, pClone, pszHid, &pBuf, &len)  );
+		SG_NULLFREE(pCtx, pBuf);
+	}
+
+	/* Fall through to common cleanup */
+
+fail:
+	if (pStaging)
+		SG_ERR_IGNORE(  SG_staging__cleanup(pCtx, &pStaging)  );
+	SG_NULLFREE(pCtx, pBuf);
+	SG_STRING_NULLFREE(pCtx, pstr);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaGood);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaBad);
+	SG_REPO_NULLFREE(pCtx, pClone);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathTopDir);
+}
+
+/**
+ * Read a fragball with the given blobs into memory.
+ */
+void MyFn(fragball_bytes)(
+	SG_context* pCtx,
+	SG_repo* pRepo,
+	const SG_pathname* pPathDir,
+	const SG_stringarray* psaHids,
+	SG_byte** ppBuf,
+	SG_uint32* pLen
+	)
+{
+	SG_pathname* pPathFragball = NULL;
+	SG_file* pFile = NULL;
+	SG_byte* pBuf = NULL;
+	SG_uint64 len = 0;
+	SG_uint32 count = 0;
+	SG_uint32 i;
+
+	SG_ERR_CHECK(  SG_fragball__create(pCtx, pPathDir, &pPathFragball)  );
+	SG_ERR_CHECK(  SG_stringarray__count(pCtx, psaHids, &count)  );
+	for (i=0; i<count; i++)
+	{
+		const char* pszHid = NULL;
+
+		SG_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaHids, i, &pszHid)  );
+		SG_ERR_CHECK(  SG_fragball__append__blob(pCtx, pPathFragball, pRepo, pszHid)  );
+	}
+
+	SG_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathFragball, &len, NULL)  );
+	SG_ERR_CHECK(  SG_alloc(pCtx, (SG_uint32) len, 1, &pBuf)  );
+	SG_ERR_CHECK(  SG_file__open__pathname(pCtx, pPathFragball, SG_FILE_RDONLY | SG_FILE_OPEN_EXISTING, SG_FSOBJ_PERMS__UNUSED, &pFile)  );
+	SG_ERR_CHECK(  SG_file__read(pCtx, pFile, (SG_uint32) len, pBuf, NULL)  );
+	SG_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+
+	*ppBuf = pBuf;
+	pBuf = NULL;
+	*pLen = (SG_uint32) len;
+
+	/* fall through */
+
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+	SG_NULLFREE(pCtx, pBuf);
+	SG_FRAGBALL_NULLFREE(pCtx, pPathFragball);
+}
+
+/**
+ * Write the first len bytes of a fragball into a staging writestream
+ * in odd-sized chunks.  The first chunk is 2 bytes, so the 4-byte
+ * length of the first object header arrives in two pieces.
+ */
+void MyFn(write_in_chunks)(
+	SG_context* pCtx,
+	SG_staging* pStaging,
+	SG_byte* pBuf,
+	SG_uint32 len
+	)
+{
+	static const SG_uint32 aSizes[] = { 2, 1, 3, 5, 7, 11, 13, 4093 };
+	SG_writestream* pstrm = NULL;
+	SG_uint32 offset = 0;
+	SG_uint32 k = 0;
+
+	SG_ERR_CHECK(  SG_staging__open_fragball_writestream(pCtx, pStaging, &pstrm)  );
+	while (offset < len)
+	{
+		SG_uint32 n = SG_MIN(aSizes[k++ % SG_NrElements(aSizes)], len - offset);
+
+		SG_ERR_CHECK(  SG_writestream__write(pCtx, pstrm, n, pBuf + offset, NULL)  );
+		offset += n;
+	}
+
+	SG_writestream__close(pCtx, pstrm);
+	pstrm = NULL;
+	SG_ERR_CHECK_CURRENT;
+
+	/* fall through */
+
+fail:
+	if (pstrm)
+		SG_ERR_IGNORE(  SG_writestream__close(pCtx, pstrm)  );
+}
+
+/**
+ * A fragball written into a staging writestream in pieces which split
+ * object headers (and their length prefixes) must stage the same as a
+ * slurped one.  A fragball which stops part way through a blob, or
+ * part way through a length prefix, must fail on close and leave
+ * nothing staged.
+ */
+void MyFn(test__staging_writestream)(SG_context* pCtx)
+{
+	char bufTopDir[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathTopDir = NULL;
+	char buf_repo_name[SG_TID_MAX_BUFFER_LENGTH];
+	char buf_clone_name[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_repo* pRepo = NULL;
+	SG_repo* pClone = NULL;
+	SG_stringarray* psaGood = NULL;
+	SG_stringarray* psaCut = NULL;
+	SG_staging* pStaging = NULL;
+	char* pszStagingId = NULL;
+	SG_string* pstr = NULL;
+	SG_byte* pFragball = NULL;
+	SG_uint32 lenFragball = 0;
+	SG_uint32 lenFirst = 0;
+	SG_byte* pBuf = NULL;
+	SG_uint64 len = 0;
+	SG_error err = SG_ERR_OK;
+	SG_uint32 count = 0;
+	SG_uint32 i, t;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufTopDir, sizeof(bufTopDir), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__SZ(pCtx,&pPathTopDir,bufTopDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx,pPathTopDir)  );
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, buf_repo_name, sizeof(buf_repo_name), 32)  );
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, buf_clone_name, sizeof(buf_clone_name), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, buf_repo_name)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo2(pCtx, buf_repo_name, pPathWorkingDir, NULL)  );
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, buf_repo_name, &pRepo)  );
+	VERIFY_ERR_CHECK(  SG_repo__create_empty_clone(pCtx, buf_repo_name, buf_clone_name)  );
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, buf_clone_name, &pClone)  );
+
+	/* the whole fragball, in pieces */
+	VERIFY_ERR_CHECK(  MyFn(store_numbered_blobs)(pCtx, pRepo, "chunked", 40, &psaGood)  );
+	VERIFY_ERR_CHECK(  MyFn(fragball_bytes)(pCtx, pRepo, pPathTopDir, psaGood, &pFragball, &lenFragball)  );
+
+	VERIFY_ERR_CHECK(  SG_staging__create(pCtx, buf_clone_name, &pszStagingId, &pStaging)  );
+	SG_NULLFREE(pCtx, pszStagingId);
+	VERIFY_ERR_CHECK(  MyFn(write_in_chunks)(pCtx, pStaging, pFragball, lenFragball)  );
+	VERIFY_ERR_CHECK(  SG_staging__commit(pCtx, pStaging)  );
+	VERIFY_ERR_CHECK(  SG_staging__cleanup(pCtx, &pStaging)  );
+	SG_NULLFREE(pCtx, pFragball);
+
+	VERIFY_ERR_CHECK(  SG_stringarray__count(pCtx, psaGood, &count)  );
+	for (i=0; i<count; i++)
+	{
+		const char* pszHid = NULL;
+
+		VERIFY_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaGood, i, &pszHid)  );
+		VERIFY_ERR_CHECK(  MyFn(numbered_blob)(pCtx, "chunked", i, &pstr)  );
+		VERIFY_ERR_CHECK(  SG_repo__fetch_blob_into_memory(pCtx, pClone, pszHid, &pBuf, &len)  );
+		VERIFY_COND_FAIL("streamed blob length", (len == SG_string__length_in_bytes(pstr)));
+		VERIFY_COND_FAIL("streamed blob content", (0 == memcmp(pBuf, SG_string__sz(pstr), (size_t) len)));
+		SG_NULLFREE(pCtx, pBuf);
+		SG_STRING_NULLFREE(pCtx, pstr);
+	}
+
+	/* truncated fragballs: once inside the last blob, once inside the
+	 * length prefix of the first blob's header (just after the version
+	 * header, whose length is the first 4 bytes). */
+	VERIFY_ERR_CHECK(  MyFn(store_numbered_blobs)(pCtx, pRepo, "cut", 10, &psaCut)  );
+	VERIFY_ERR_CHECK(  MyFn(fragball_bytes)(pCtx, pRepo, pPathTopDir, psaCut, &pFragball, &lenFragball)  );
+	lenFirst = 4 + ((pFragball[0] << 24) | (pFragball[1] << 16) | (pFragball[2] << 8) | pFragball[3]);
+
+	for (t=0; t<2; t++)
+	{
+		VERIFY_ERR_CHECK(  SG_staging__create(pCtx, buf_clone_name, &pszStagingId, &pStaging)  );
+		SG_NULLFREE(pCtx, pszStagingId);
+
+		MyFn(write_in_chunks)(pCtx, pStaging, pFragball, ((t == 0) ? (lenFragball - 3) : (lenFirst + 2)));
+		VERIFY_CTX_HAS_ERR("truncated fragball fails on close", pCtx);
+		(void) SG_context__get_err(pCtx, &err);
+		SG_context__err_reset(pCtx);
+		VERIFYP_COND("truncated fragball is an incomplete read", (SG_ERR_INCOMPLETEREAD == err), ("truncation %d", t));
+
+		/* nothing was recorded, so there is nothing to commit */
+		VERIFY_ERR_CHECK(  SG_staging__commit(pCtx, pStaging)  );
+		VERIFY_ERR_CHECK(  SG_staging__cleanup(pCtx, &pStaging)  );
+	}
+
+	VERIFY_ERR_CHECK(  SG_stringarray__count(pCtx, psaCut, &count)  );
+	for (i=0; i<count; i++)
+	{
+		const char* pszHid = NULL;
+
+		VERIFY_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaCut, i, &pszHid)  );
+		VERIFY_ERR_CHECK_HAS_ERR_DISCARD(  SG_repo__fetch_blob_into_memory(pCtx, pClone, pszHid, &pBuf, &len)  );
+		SG_NULLFREE(pCtx, pBuf);
+	}
+
+	/* Fall through to common cleanup */
+
+fail:
+	if (pStaging)
+		SG_ERR_IGNORE(  SG_staging__cleanup(pCtx, &pStaging)  );
+	SG_NULLFREE(pCtx, pszStagingId);
+	SG_NULLFREE(pCtx, pFragball);
+	SG_NULLFREE(pCtx, pBuf);
+	SG_STRING_NULLFREE(pCtx, pstr);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaGood);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaCut);
+	SG_REPO_NULLFREE(pCtx, pClone);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathTopDir);
+}
+
 MyMain()
 {
 	TEMPLATE_MAIN_START;
@@ -498,6 +1020,9 @@ MyMain()
 	VERIFY_ERR_CHECK(  MyFn(test__simple)(pCtx)  );
 	VERIFY_ERR_CHECK(  MyFn(test__long_dag)(pCtx)  );
 	VERIFY_ERR_CHECK(  MyFn(test__wide_dag)(pCtx)  );
+	VERIFY_ERR_CHECK(  MyFn(test__fragball_stream)(pCtx)  );
+	VERIFY_ERR_CHECK(  MyFn(test__staging_many_blobs)(pCtx)  );
+	VERIFY_ERR_CHECK(  MyFn(test__staging_writestream)(pCtx)  );
 
 	// Fall through to common cleanup.
 
@@ -46,6 +46,7 @@ limitations under the License.
 #define DO_500		1
 #define DO_600		1
 #define DO_700		1
+#define DO_800		1
 
 //////////////////////////////////////////////////////////////////
 // only bother with xattr tests on systems where it is configured (see cmake file)
@@ -1032,8 +1033,13 @@ static void MyFn(doCase_1)(SG_context * pCtx,
 						   struct MyDcl(row) Table_A[],  SG_uint32 nrRows_Table_A,
 						   struct MyDcl(row) Table_B[],  SG_uint32 nrRows_Table_B,
 						   struct MyDcl(row) Table_C[],  SG_uint32 nrRows_Table_C,
+						   SG_int32 nrExpectedAutoMerged,
+						   SG_int32 nrExpectedUnresolved,
 						   SG_bool bUseSwitchBaseline)
 {
+	// nrExpectedAutoMerged and nrExpectedUnresolved are only
+	// verified when they are >= 0.
+	//
 	//////////////////////////////////////////////////////////////////
 	// create various changesets to produce this graph:
 	//
@@ -1232,6 +1238,13 @@ static void MyFn(doCase_1)(SG_context * pCtx,
 				   pStats->nrFilesAutoMerged,
 				   nrUnresolvedIssues)  );
 
+	if (nrExpectedAutoMerged >= 0)
+		VERIFYP_COND("nrFilesAutoMerged", (pStats->nrFilesAutoMerged == (SG_uint32)nrExpectedAutoMerged),
+					  ("nrFilesAutoMerged [%d] expected [%d]", pStats->nrFilesAutoMerged, nrExpectedAutoMerged));
+	if (nrExpectedUnresolved >= 0)
+		VERIFYP_COND("nrUnresolvedIssues", (nrUnresolvedIssues == (SG_uint32)nrExpectedUnresolved),
+					  ("nrUnresolvedIssues [%d] expected [%d]", nrUnresolvedIssues, nrExpectedUnresolved));
+
 	VERIFY_ERR_CHECK(  SG_mrg__apply_merge(pCtx, pMrg)  );
 
 	VERIFY_ERR_CHECK(  SG_pendingtree__save(pCtx, pPendingTree)  );
@@ -1288,6 +1301,7 @@ static void MyFn(doCase)(SG_context * pCtx,
 								Table_A, nrRows_Table_A,
 								Table_B, nrRows_Table_B,
 								Table_C, nrRows_Table_C,
+								-1, -1,
 								bUseSwitchBaseline)  );
 
 	// swap B & C and run it again.
@@ -1301,6 +1315,7 @@ static void MyFn(doCase)(SG_context * pCtx,
 								Table_A, nrRows_Table_A,
 								Table_C, nrRows_Table_C,
 								Table_B, nrRows_Table_B,
+								-1, -1,
 								bUseSwitchBaseline)  );
 }
 
@@ -4201,6 +4216,95 @@ static void MyFn(test405_1)(SG_context * pCtx, const SG_pathname * pPathTopDir,
 				 bUseSwitchBaseline);
 }
 
+static void MyFn(test407  )(SG_context * pCtx, const SG_pathname * pPathTopDir, SG_bool bUseSwitchBaseline)
+{
+	// enough divergent edits that the auto-merges run on several threads.
+	// f00..f07 were edited at different ends of the file and should
+	// auto-merge; f08..f11 were appended to by both and diff3 should
+	// fail on them.  the failures must not stop the other merges and the
+	// counts must not depend on which thread finished first.
+	//////////////////////////////////////////////////////////////////
+	// table used to create CSET_A from CSET_I.
+
+	struct MyDcl(row) Table_A[] = {
+		ROW("dir_100",	NULL,		NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f00.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f01.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f02.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f03.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f04.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f05.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f06.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f07.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f08.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f09.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f10.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_100",	NULL,	"f11.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+	};
+
+	SG_uint32 nrRows_Table_A = SG_NrElements( Table_A );
+
+	//////////////////////////////////////////////////////////////////
+	// table used to create CSET_B from CSET_A.
+
+	struct MyDcl(row) Table_B[] = {
+		ROW("dir_100",	NULL,	"f00.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f01.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f02.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f03.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f04.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f05.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f06.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f07.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f08.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f09.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f10.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"f11.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+4,		NULL),		// append 4 lines
+		ROW("dir_100",	NULL,	"fB.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+	};
+
+	SG_uint32 nrRows_Table_B = SG_NrElements( Table_B );
+
+	//////////////////////////////////////////////////////////////////
+	// table used to create CSET_C from CSET_A.
+
+	struct MyDcl(row) Table_C[] = {
+		ROW("dir_100",	NULL,	"f00.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f01.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f02.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f03.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f04.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f05.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f06.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f07.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	-4,		NULL),		// prepend 4 lines
+		ROW("dir_100",	NULL,	"f08.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+8,		NULL),		// append 8 lines
+		ROW("dir_100",	NULL,	"f09.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+8,		NULL),		// append 8 lines
+		ROW("dir_100",	NULL,	"f10.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+8,		NULL),		// append 8 lines
+		ROW("dir_100",	NULL,	"f11.txt",	NULL,			(SG_DIFFSTATUS_FLAGS__MODIFIED),	+8,		NULL),		// append 8 lines
+		ROW("dir_100",	NULL,	"fC.txt",		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+	};
+
+	SG_uint32 nrRows_Table_C = SG_NrElements( Table_C );
+
+	//////////////////////////////////////////////////////////////////
+	// the edits are symmetric, so we expect the same answer with B and C swapped.
+
+	BEGIN_TEST(  MyFn(doCase_1)(pCtx,
+								pPathTopDir,
+								Table_A, nrRows_Table_A,
+								Table_B, nrRows_Table_B,
+								Table_C, nrRows_Table_C,
+								8, 4,
+								bUseSwitchBaseline)  );
+	BEGIN_TEST(  MyFn(doCase_1)(pCtx,
+								pPathTopDir,
+								Table_A, nrRows_Table_A,
+								Table_C, nrRows_Table_C,
+								Table_B, nrRows_Table_B,
+								8, 4,
+								bUseSwitchBaseline)  );
+}
+
 #if SYM
 static void MyFn(test406  )(SG_context * pCtx, const SG_pathname * pPathTopDir, SG_bool bUseSwitchBaseline)
 {
@@ -5066,10 +5170,402 @@ static void MyFn(test701)(SG_context * pCtx, const SG_pathname * pPathTopDir, SG
 //				 &csetStats,
 				 bUseSwitchBaseline);
 }
+
+static void MyFn(test702)(SG_context * pCtx, const SG_pathname * pPathTopDir, SG_bool bUseSwitchBaseline)
+{
+	// B adds "fB.txt" and changes "f.txt".  compute the merge of B into C,
+	// then create an unexpected "fB.txt" in the WD before applying it.  the
+	// content of the get_file step is fetched ahead into a temp file; moving
+	// that into place must fail rather than replace the file that is now in
+	// the way.
+
+	char bufName_repo[SG_TID_MAX_BUFFER_LENGTH];
+	char bufCSet_A[SG_HID_MAX_BUFFER_LENGTH];
+	char bufCSet_B[SG_HID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_pathname* pPathFile = NULL;
+	SG_pendingtree * pPendingTree = NULL;
+	SG_rbtree * prbCSetsToMerge = NULL;
+	SG_mrg * pMrg = NULL;
+	SG_uint32 nrUnresolvedIssues;
+	SG_uint64 len = 0;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName_repo, sizeof(bufName_repo), 6)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx,&pPathWorkingDir, pPathTopDir, "wd_1")  );
+	VERIFY_ERR_CHECK(  SG_pathname__append__from_sz(pCtx,pPathWorkingDir,bufName_repo)  );
+	INFO2("test702 working directory [1]", SG_pathname__sz(pPathWorkingDir));
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir_recursive__pathname(pCtx,pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx,bufName_repo, pPathWorkingDir)  );
+
+	VERIFY_ERR_CHECK(  MyFn(create_file__numbers)(pCtx, pPathWorkingDir, "f.txt", 20)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx,pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx,pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  _ut_pt__get_baseline(pCtx,pPathWorkingDir,bufCSet_A,sizeof(bufCSet_A))  );
+
+	VERIFY_ERR_CHECK(  MyFn(append_to_file__numbers)(pCtx, pPathWorkingDir, "f.txt", 5)  );
+	VERIFY_ERR_CHECK(  MyFn(create_file__numbers)(pCtx, pPathWorkingDir, "fB.txt", 30)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx,pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx,pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  _ut_pt__get_baseline(pCtx,pPathWorkingDir,bufCSet_B,sizeof(bufCSet_B))  );
+
+	if (bUseSwitchBaseline)
+	{
+		VERIFY_ERR_CHECK(  MyFn(switch_to_baseline)(pCtx,pPathWorkingDir,bufCSet_A)  );
+	}
+	else
+	{
+		SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx,&pPathWorkingDir, pPathTopDir, "wd_2")  );
+		SG_ERR_IGNORE(  SG_fsobj__mkdir_recursive__pathname(pCtx,pPathWorkingDir)  );
+		VERIFY_ERR_CHECK(  SG_pathname__append__from_sz(pCtx,pPathWorkingDir,bufName_repo)  );
+		INFO2("test702 working directory [2]", SG_pathname__sz(pPathWorkingDir));
+		VERIFY_ERR_CHECK(  unittests_workingdir__create_and_get(pCtx,bufName_repo,pPathWorkingDir,SG_TRUE,bufCSet_A)  );
+	}
+
+	VERIFY_ERR_CHECK(  MyFn(create_file__numbers)(pCtx, pPathWorkingDir, "fC.txt", 10)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx,pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx,pPathWorkingDir,SG_TRUE)  );
+
+	VERIFY_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbCSetsToMerge)  );
+	VERIFY_ERR_CHECK(  SG_rbtree__add(pCtx, prbCSetsToMerge, bufCSet_B)  );
+
+	VERIFY_ERR_CHECK(  SG_pendingtree__alloc(pCtx,pPathWorkingDir,SG_TRUE,&pPendingTree)  );
+	VERIFY_ERR_CHECK(  SG_MRG__ALLOC(pCtx,pPendingTree, SG_FALSE, &pMrg)  );
+	VERIFY_ERR_CHECK(  SG_mrg__compute_merge(pCtx, pMrg, prbCSetsToMerge, &nrUnresolvedIssues)  );
+	VERIFY_COND("nrUnresolvedIssues", (nrUnresolvedIssues == 0));
+
+	// put a 6 byte file in the way (3 lines of "%d\n").
+	VERIFY_ERR_CHECK(  MyFn(create_file__numbers)(pCtx, pPathWorkingDir, "fB.txt", 3)  );
+
+	VERIFY_ERR_CHECK_HAS_ERR_DISCARD(  SG_mrg__apply_merge(pCtx, pMrg)  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathFile, pPathWorkingDir, "fB.txt")  );
+	VERIFY_ERR_CHECK(  SG_fsobj__length__pathname(pCtx, pPathFile, &len, NULL)  );
+	VERIFYP_COND("file in the way was overwritten", (len == 6),
+				 ("length [%d]", (SG_uint32)len));
+
+fail:
+	SG_MRG_NULLFREE(pCtx, pMrg);
+	SG_RBTREE_NULLFREE(pCtx, prbCSetsToMerge);
+	SG_PENDINGTREE_NULLFREE(pCtx,pPendingTree);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathFile);
+}
 #endif//DO_700
 
 //////////////////////////////////////////////////////////////////
 
+#if DO_800
+/**
+ * Compute (but do not apply) the merge of the given CSET into the WD
+ * and return the things we want to compare between runs: the error
+ * (if the merge refused), the WD-PLAN as text, the number of unresolved
+ * issues, and the number of directories whose contents were not loaded.
+ */
+static void MyFn(compute_merge_summary)(SG_context * pCtx,
+										const SG_pathname * pPathWorkingDir,
+										const char * pszHidCSet_Other,
+										SG_bool bLoadEntireCSets,
+										SG_error * pErr,
+										SG_string ** ppStrPlan,
+										SG_uint32 * pNrUnresolved,
+										SG_uint32 * pNrDirsPruned)
+{
+	SG_pendingtree * pPendingTree = NULL;
+	SG_rbtree * prbCSetsToMerge = NULL;
+	SG_mrg * pMrg = NULL;
+	const SG_wd_plan * pPlan;
+	SG_error err;
+
+	*pErr = SG_ERR_OK;
+	*pNrUnresolved = 0;
+	*pNrDirsPruned = 0;
+
+	VERIFY_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbCSetsToMerge)  );
+	VERIFY_ERR_CHECK(  SG_rbtree__add(pCtx, prbCSetsToMerge, pszHidCSet_Other)  );
+	VERIFY_ERR_CHECK(  SG_pendingtree__alloc(pCtx, pPathWorkingDir, SG_TRUE, &pPendingTree)  );
+
+	// dirt in the WD may make the merge refuse to run.  that is a result
+	// that the caller wants to compare, so we don't treat it as a failure.
+
+	SG_MRG__ALLOC(pCtx, pPendingTree, SG_FALSE, &pMrg);
+	if (!SG_context__has_err(pCtx))
+		SG_mrg_debug__set_load_entire_csets(pCtx, pMrg, bLoadEntireCSets);
+	if (!SG_context__has_err(pCtx))
+		SG_mrg__compute_merge(pCtx, pMrg, prbCSetsToMerge, pNrUnresolved);
+	SG_context__get_err(pCtx, &err);
+	if (SG_IS_ERROR(err))
+	{
+		*pErr = err;
+		SG_context__err_reset(pCtx);
+	}
+	else
+	{
+		VERIFY_ERR_CHECK(  SG_mrg__get_wd_plan__ref(pCtx, pMrg, &pPlan)  );
+		VERIFY_ERR_CHECK(  SG_wd_plan__format__to_string(pCtx, pPlan, ppStrPlan)  );
+		VERIFY_ERR_CHECK(  SG_mrg_debug__get_nr_dirs_pruned(pCtx, pMrg, pNrDirsPruned)  );
+	}
+
+fail:
+	SG_MRG_NULLFREE(pCtx, pMrg);
+	SG_PENDINGTREE_NULLFREE(pCtx, pPendingTree);
+	SG_RBTREE_NULLFREE(pCtx, prbCSetsToMerge);
+}
+
+/**
+ * Build A, B, and C like doCase_1() does, create some FOUND items in
+ * C's WD, and then merge B into C twice: once skipping the contents of
+ * the directories that are identical in A, B, and C and once loading
+ * everything.  Both must give the same answer.  Then apply the merge
+ * and make sure that the given entries are in the WD.
+ *
+ * FOUND items that end in '/' are directories.
+ */
+static void MyFn(doCase_prune)(SG_context * pCtx,
+							   const SG_pathname * pPathTopDir,
+							   struct MyDcl(row) Table_A[],  SG_uint32 nrRows_Table_A,
+							   struct MyDcl(row) Table_B[],  SG_uint32 nrRows_Table_B,
+							   struct MyDcl(row) Table_C[],  SG_uint32 nrRows_Table_C,
+							   const char ** aszFound, SG_uint32 nrFound,
+							   SG_uint32 nrExpectedDirsPruned,
+							   const char ** aszExpected, SG_uint32 nrExpected,
+							   SG_bool bUseSwitchBaseline)
+{
+	char bufName_repo[SG_TID_MAX_BUFFER_LENGTH];
+	char bufCSet_A[SG_HID_MAX_BUFFER_LENGTH];
+	char bufCSet_B[SG_HID_MAX_BUFFER_LENGTH];
+	SG_pathname * pPathWorkingDir = NULL;
+	SG_pathname * pPath = NULL;
+	SG_pendingtree * pPendingTree = NULL;
+	SG_rbtree * prbCSetsToMerge = NULL;
+	SG_mrg * pMrg = NULL;
+	SG_file * pFile = NULL;
+	SG_string * pStrPlan_Pruned = NULL;
+	SG_string * pStrPlan_Entire = NULL;
+	SG_error err_Pruned, err_Entire;
+	SG_uint32 nrUnresolved_Pruned, nrUnresolved_Entire;
+	SG_uint32 nrDirsPruned_Pruned, nrDirsPruned_Entire;
+	SG_uint32 nrUnresolved;
+	SG_uint32 k;
+	SG_bool bExists;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName_repo, sizeof(bufName_repo), 6)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx,&pPathWorkingDir, pPathTopDir, "wd_1")  );
+	VERIFY_ERR_CHECK(  SG_pathname__append__from_sz(pCtx,pPathWorkingDir,bufName_repo)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir_recursive__pathname(pCtx,pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx,bufName_repo, pPathWorkingDir)  );
+
+	for (k=0; k < nrRows_Table_A; k++)
+		VERIFY_ERR_CHECK_DISCARD(  MyFn(process_row)(pCtx,"A",k,&Table_A[k],pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove_param(pCtx,pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx,pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  _ut_pt__get_baseline(pCtx,pPathWorkingDir,bufCSet_A,sizeof(bufCSet_A))  );
+
+	for (k=0; k < nrRows_Table_B; k++)
+		VERIFY_ERR_CHECK_DISCARD(  MyFn(process_row)(pCtx,"B",k,&Table_B[k],pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove_param(pCtx,pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx,pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  _ut_pt__get_baseline(pCtx,pPathWorkingDir,bufCSet_B,sizeof(bufCSet_B))  );
+
+	if (bUseSwitchBaseline)
+	{
+		VERIFY_ERR_CHECK(  MyFn(switch_to_baseline)(pCtx,pPathWorkingDir,bufCSet_A)  );
+	}
+	else
+	{
+		SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx,&pPathWorkingDir, pPathTopDir, "wd_2")  );
+		SG_ERR_IGNORE(  SG_fsobj__mkdir_recursive__pathname(pCtx,pPathWorkingDir)  );
+		VERIFY_ERR_CHECK(  SG_pathname__append__from_sz(pCtx,pPathWorkingDir,bufName_repo)  );
+		VERIFY_ERR_CHECK(  unittests_workingdir__create_and_get(pCtx,bufName_repo,pPathWorkingDir,SG_TRUE,bufCSet_A)  );
+	}
+
+	for (k=0; k < nrRows_Table_C; k++)
+		VERIFY_ERR_CHECK_DISCARD(  MyFn(process_row)(pCtx,"C",k,&Table_C[k],pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove_param(pCtx,pPathWorkingDir,SG_TRUE)  );
+	VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx,pPathWorkingDir,SG_TRUE)  );
+
+	// leave some trash in the WD.
+
+	for (k=0; k < nrFound; k++)
+	{
+		size_t len = strlen(aszFound[k]);
+
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPath, pPathWorkingDir, aszFound[k])  );
+		if (aszFound[k][len-1] == '/')
+		{
+			VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPath)  );
+		}
+		else
+		{
+			VERIFY_ERR_CHECK(  SG_file__open__pathname(pCtx, pPath, SG_FILE_CREATE_NEW | SG_FILE_RDWR, 0600, &pFile)  );
+			VERIFY_ERR_CHECK(  SG_file__write(pCtx, pFile, (SG_uint32)len, (const SG_byte *)aszFound[k], NULL)  );
+			VERIFY_ERR_CHECK(  SG_file__close(pCtx, &pFile)  );
+		}
+		SG_PATHNAME_NULLFREE(pCtx, pPath);
+	}
+
+	// the pruned and the complete merge must agree on everything.
+
+	VERIFY_ERR_CHECK(  MyFn(compute_merge_summary)(pCtx, pPathWorkingDir, bufCSet_B, SG_FALSE,
+												   &err_Pruned, &pStrPlan_Pruned, &nrUnresolved_Pruned, &nrDirsPruned_Pruned)  );
+	VERIFY_ERR_CHECK(  MyFn(compute_merge_summary)(pCtx, pPathWorkingDir, bufCSet_B, SG_TRUE,
+												   &err_Entire, &pStrPlan_Entire, &nrUnresolved_Entire, &nrDirsPruned_Entire)  );
+
+	VERIFYP_COND("doCase_prune", (err_Pruned == SG_ERR_OK),
+				 ("pruned merge failed [%d]", (int)err_Pruned));
+	VERIFYP_COND("doCase_prune", (err_Entire == SG_ERR_OK),
+				 ("complete merge failed [%d]", (int)err_Entire));
+	if (!pStrPlan_Pruned || !pStrPlan_Entire)
+		goto fail;
+
+	VERIFYP_COND("doCase_prune", (strcmp(SG_string__sz(pStrPlan_Pruned), SG_string__sz(pStrPlan_Entire)) == 0),
+				 ("plans differ:\npruned:\n%s\ncomplete:\n%s", SG_string__sz(pStrPlan_Pruned), SG_string__sz(pStrPlan_Entire)));
+	VERIFYP_COND("doCase_prune", (nrUnresolved_Pruned == nrUnresolved_Entire),
+				 ("nrUnresolved pruned [%d] complete [%d]", nrUnresolved_Pruned, nrUnresolved_Entire));
+	VERIFYP_COND("doCase_prune", (nrDirsPruned_Entire == 0),
+				 ("complete merge pruned [%d] directories", nrDirsPruned_Entire));
+	VERIFYP_COND("doCase_prune", (nrDirsPruned_Pruned == nrExpectedDirsPruned),
+				 ("nrDirsPruned [%d] expected [%d]", nrDirsPruned_Pruned, nrExpectedDirsPruned));
+
+	// apply the (pruned) merge and see that the WD has what we expect.
+
+	VERIFY_ERR_CHECK(  SG_RBTREE__ALLOC(pCtx, &prbCSetsToMerge)  );
+	VERIFY_ERR_CHECK(  SG_rbtree__add(pCtx, prbCSetsToMerge, bufCSet_B)  );
+	VERIFY_ERR_CHECK(  SG_pendingtree__alloc(pCtx, pPathWorkingDir, SG_TRUE, &pPendingTree)  );
+	VERIFY_ERR_CHECK(  SG_MRG__ALLOC(pCtx, pPendingTree, SG_FALSE, &pMrg)  );
+	VERIFY_ERR_CHECK(  SG_mrg__compute_merge(pCtx, pMrg, prbCSetsToMerge, &nrUnresolved)  );
+	VERIFY_ERR_CHECK(  SG_mrg__apply_merge(pCtx, pMrg)  );
+	VERIFY_ERR_CHECK(  SG_pendingtree__save(pCtx, pPendingTree)  );
+	SG_PENDINGTREE_NULLFREE(pCtx, pPendingTree);
+
+	for (k=0; k < nrExpected; k++)
+	{
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPath, pPathWorkingDir, aszExpected[k])  );
+		VERIFY_ERR_CHECK(  SG_fsobj__exists__pathname(pCtx, pPath, &bExists, NULL, NULL)  );
+		VERIFYP_COND("doCase_prune", (bExists), ("missing [%s] after merge", aszExpected[k]));
+		SG_PATHNAME_NULLFREE(pCtx, pPath);
+	}
+
+fail:
+	SG_FILE_NULLCLOSE(pCtx, pFile);
+	SG_STRING_NULLFREE(pCtx, pStrPlan_Pruned);
+	SG_STRING_NULLFREE(pCtx, pStrPlan_Entire);
+	SG_RBTREE_NULLFREE(pCtx, prbCSetsToMerge);
+	SG_PENDINGTREE_NULLFREE(pCtx, pPendingTree);
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	MyFn(cleanup_table)(pCtx,Table_A,nrRows_Table_A);
+	MyFn(cleanup_table)(pCtx,Table_B,nrRows_Table_B);
+	MyFn(cleanup_table)(pCtx,Table_C,nrRows_Table_C);
+	SG_MRG_NULLFREE(pCtx, pMrg);
+}
+
+// the tree that both of the pruning tests start with.
+
+#define PRUNE_TABLE_A																							\
+	ROW("dir_a",		NULL,	NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_a",		NULL,	"fa.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_a/sub",	NULL,	NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_a/sub",	NULL,	"fs.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_b",		NULL,	NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_b",		NULL,	"fb1.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_b",		NULL,	"fb2.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_c",		NULL,	NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_c",		NULL,	"fc.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_c/deep",	NULL,	NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_c/deep",	NULL,	"fd.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_d",		NULL,	NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_d",		NULL,	"fd1.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_e",		NULL,	NULL,		NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),		\
+	ROW("dir_e",		NULL,	"fe.txt",	NULL,		(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL)
+
+static void MyFn(test800)(SG_context * pCtx, const SG_pathname * pPathTopDir, SG_bool bUseSwitchBaseline)
+{
+	// moves and renames between directories that are pruned and ones that aren't.
+	//
+	// B renames dir_d (whose contents don't change) and moves dir_c/fc.txt into dir_b.
+	// C moves dir_c/deep (whose contents don't change) into dir_e.
+	//
+	// dir_b, dir_c, and dir_e change, so they get loaded.  dir_a is the same everywhere.
+	// dir_d only changed its name (in its parent), so it is pruned.  dir_c/deep is pruned
+	// even though it lives in a different directory in C.  dir_a/sub is never seen.
+
+	struct MyDcl(row) Table_A[] = { PRUNE_TABLE_A };
+	SG_uint32 nrRows_Table_A = SG_NrElements( Table_A );
+
+	struct MyDcl(row) Table_B[] = {
+		ROW("dir_b",		NULL,		"fb1.txt",	NULL,	(SG_DIFFSTATUS_FLAGS__MODIFIED),	5,		NULL),
+		ROW("dir_d",		"dir_d2",	NULL,		NULL,	(SG_DIFFSTATUS_FLAGS__RENAMED),		0,		NULL),
+		ROW("dir_c",		"dir_b",	"fc.txt",	NULL,	(SG_DIFFSTATUS_FLAGS__MOVED),		0,		NULL),
+	};
+	SG_uint32 nrRows_Table_B = SG_NrElements( Table_B );
+
+	struct MyDcl(row) Table_C[] = {
+		ROW("dir_e",		NULL,		"new.txt",	NULL,	(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+		ROW("dir_c/deep",	"dir_e",	NULL,		NULL,	(SG_DIFFSTATUS_FLAGS__MOVED),		0,		NULL),
+	};
+	SG_uint32 nrRows_Table_C = SG_NrElements( Table_C );
+
+	const char * aszExpected[] = { "dir_a/fa.txt", "dir_a/sub/fs.txt", "dir_b/fb1.txt", "dir_b/fc.txt",
+								   "dir_d2/fd1.txt", "dir_e/new.txt", "dir_e/deep/fd.txt" };
+
+	MyFn(doCase_prune)(pCtx,
+					   pPathTopDir,
+					   Table_A, nrRows_Table_A,
+					   Table_B, nrRows_Table_B,
+					   Table_C, nrRows_Table_C,
+					   NULL, 0,
+					   3,
+					   aszExpected, SG_NrElements(aszExpected),
+					   bUseSwitchBaseline);
+}
+
+static void MyFn(test801)(SG_context * pCtx, const SG_pathname * pPathTopDir, SG_bool bUseSwitchBaseline)
+{
+	// FOUND items in and beneath directories that are pruned.
+	//
+	// B and C only change dir_b and dir_e, so dir_a, dir_c, and dir_d are pruned.
+	// dir_a/found_a.txt has a pruned parent.  dir_c/deep/found_deep.txt and
+	// dir_a/sub/found_dir/ are buried deeper, so the merge has to load dir_c
+	// and dir_a to find their parents.  that leaves dir_a/sub, dir_c/deep, and
+	// dir_d pruned.
+
+	struct MyDcl(row) Table_A[] = { PRUNE_TABLE_A };
+	SG_uint32 nrRows_Table_A = SG_NrElements( Table_A );
+
+	struct MyDcl(row) Table_B[] = {
+		ROW("dir_b",		NULL,		"fb1.txt",	NULL,	(SG_DIFFSTATUS_FLAGS__MODIFIED),	5,		NULL),
+	};
+	SG_uint32 nrRows_Table_B = SG_NrElements( Table_B );
+
+	struct MyDcl(row) Table_C[] = {
+		ROW("dir_e",		NULL,		"new.txt",	NULL,	(SG_DIFFSTATUS_FLAGS__ADDED),		0,		NULL),
+	};
+	SG_uint32 nrRows_Table_C = SG_NrElements( Table_C );
+
+	const char * aszFound[] = { "dir_a/found_a.txt", "dir_c/deep/found_deep.txt",
+								"dir_a/sub/found_dir/", "dir_a/sub/found_dir/x.txt" };
+
+	const char * aszExpected[] = { "dir_a/found_a.txt", "dir_c/deep/found_deep.txt", "dir_a/sub/found_dir/x.txt",
+								   "dir_a/sub/fs.txt", "dir_b/fb1.txt", "dir_e/new.txt" };
+
+	MyFn(doCase_prune)(pCtx,
+					   pPathTopDir,
+					   Table_A, nrRows_Table_A,
+					   Table_B, nrRows_Table_B,
+					   Table_C, nrRows_Table_C,
+					   aszFound, SG_NrElements(aszFound),
+					   3,
+					   aszExpected, SG_NrElements(aszExpected),
+					   bUseSwitchBaseline);
+}
+
+#undef PRUNE_TABLE_A
+#endif//DO_800
+
+//////////////////////////////////////////////////////////////////
+
 static void MyFn(do_main)(SG_context * pCtx, const SG_pathname * pPathTopDir, SG_bool bUseSwitchBaseline)
 {
 	//////////////////////////////////////////////////////////////////
@@ -5196,6 +5692,7 @@ static void MyFn(do_main)(SG_context * pCtx, const SG_pathname * pPathTopDir, SG
 #endif
 	BEGIN_TEST(  MyFn(test405_0)(pCtx, pPathTopDir, bUseSwitchBaseline)  );
 	BEGIN_TEST(  MyFn(test405_1)(pCtx, pPathTopDir, bUseSwitchBaseline)  );
+	BEGIN_TEST(  MyFn(test407  )(pCtx, pPathTopDir, bUseSwitchBaseline)  );
 #if SYM
 	BEGIN_TEST(  MyFn(test406  )(pCtx, pPathTopDir, bUseSwitchBaseline)  );
 #endif
@@ -5238,10 +5735,21 @@ static void MyFn(do_main)(SG_context * pCtx, const SG_pathname * pPathTopDir, SG
 #if DO_700
 	BEGIN_TEST(  MyFn(test700  )(pCtx, pPathTopDir, bUseSwitchBaseline)  );
 	BEGIN_TEST(  MyFn(test701  )(pCtx, pPathTopDir, bUseSwitchBaseline)  );
+	BEGIN_TEST(  MyFn(test702  )(pCtx, pPathTopDir, bUseSwitchBaseline)  );
 
 #else
 	INFOP("DO_700",("Skipping test7*"));
 #endif//DO_700
+
+	//////////////////////////////////////////////////////////////////
+	// skipping the contents of directories that are the same in all of the csets.
+
+#if DO_800
+	BEGIN_TEST(  MyFn(test800  )(pCtx, pPathTopDir, bUseSwitchBaseline)  );
+	BEGIN_TEST(  MyFn(test801  )(pCtx, pPathTopDir, bUseSwitchBaseline)  );
+#else
+	INFOP("DO_800",("Skipping test8*"));
+#endif//DO_800
 }
 
 //////////////////////////////////////////////////////////////////
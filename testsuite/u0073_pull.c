@@ -528,6 +528,112 @@ fail:
 	SG_VARRAY_NULLFREE(pCtx, pvaZingMergeErr);
 }
 
+void MyFn(test__common_generation)(SG_context* pCtx)
+{
+	char bufTopDir[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathTopDir = NULL;
+
+	char buf_client_repo_name[SG_TID_MAX_BUFFER_LENGTH];
+	char buf_server_repo_name[SG_TID_MAX_BUFFER_LENGTH];
+	char buf_dagnum[SG_DAGNUM__BUF_MAX__DEC];
+	char buf_filename[7];
+	SG_pathname* pPathWorkingDir = NULL;
+	SG_repo* pClientRepo = NULL;
+	SG_repo* pServerRepo = NULL;
+	SG_client* pClient = NULL;
+	SG_dagnode* pdn = NULL;
+	SG_vhash* pvhStatus = NULL;
+	SG_vhash* pvhDags = NULL;
+	SG_vhash* pvhSamples = NULL;
+	SG_varray* pvaSamples = NULL;
+	SG_uint32 count_samples = 0;
+	SG_int32 genPulled = 0;
+	SG_int32 genServer = 0;
+	SG_int32 genCommon = 0;
+	SG_uint32 i;
+
+	SG_varray* pvaZingMergeLog = NULL;
+	SG_varray* pvaZingMergeErr = NULL;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufTopDir, sizeof(bufTopDir), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__SZ(pCtx,&pPathTopDir,bufTopDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx,pPathTopDir)  );
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, buf_client_repo_name, sizeof(buf_client_repo_name), 32)  );
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, buf_server_repo_name, sizeof(buf_server_repo_name), 32)  );
+
+	INFOP("test__common_generation", ("client repo: %s", buf_client_repo_name));
+	INFOP("test__common_generation", ("server repo: %s", buf_server_repo_name));
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, buf_server_repo_name)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo2(pCtx, buf_server_repo_name, pPathWorkingDir, NULL)  );
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, buf_server_repo_name, &pServerRepo)  );
+
+	VERIFY_ERR_CHECK(  SG_repo__create_empty_clone(pCtx, buf_server_repo_name, buf_client_repo_name)  );
+	VERIFY_ERR_CHECK(  SG_repo__open_repo_instance(pCtx, buf_client_repo_name, &pClientRepo)  );
+
+	/* a few changesets on the server, pulled to the client */
+	for (i = 0; i < 3; i++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, buf_filename, sizeof(buf_filename), "a%d", i)  );
+		VERIFY_ERR_CHECK(  MyFn(create_file__numbers)(pCtx, pPathWorkingDir, buf_filename, 10)  );
+		VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+		SG_DAGNODE_NULLFREE(pCtx, pdn);
+		VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx, pPathWorkingDir, &pdn)  );
+	}
+	VERIFY_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pdn, &genPulled)  );
+
+	VERIFY_ERR_CHECK(  SG_client__open(pCtx, buf_server_repo_name, NULL_CREDENTIAL, &pClient)  );
+	VERIFY_ERR_CHECK(  SG_pull__all(pCtx, buf_client_repo_name, pClient, &pvaZingMergeErr, &pvaZingMergeLog)  );
+	VERIFY_COND("", !pvaZingMergeErr);
+	SG_CLIENT_NULLFREE(pCtx, pClient);
+
+	/* more changesets on the server only */
+	for (i = 0; i < 5; i++)
+	{
+		VERIFY_ERR_CHECK(  SG_sprintf(pCtx, buf_filename, sizeof(buf_filename), "b%d", i)  );
+		VERIFY_ERR_CHECK(  MyFn(create_file__numbers)(pCtx, pPathWorkingDir, buf_filename, 10)  );
+		VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+		SG_DAGNODE_NULLFREE(pCtx, pdn);
+		VERIFY_ERR_CHECK(  MyFn(commit_all)(pCtx, pPathWorkingDir, &pdn)  );
+	}
+	VERIFY_ERR_CHECK(  SG_dagnode__get_generation(pCtx, pdn, &genServer)  );
+
+	/* have the server sample its version control dag */
+	VERIFY_ERR_CHECK(  SG_dagnum__to_sz__decimal(pCtx, SG_DAGNUM__VERSION_CONTROL, buf_dagnum, sizeof(buf_dagnum))  );
+	VERIFY_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhStatus)  );
+	VERIFY_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhDags)  );
+	VERIFY_ERR_CHECK(  SG_vhash__add__null(pCtx, pvhDags, buf_dagnum)  );
+	VERIFY_ERR_CHECK(  SG_vhash__add__vhash(pCtx, pvhStatus, SG_SYNC_STATUS_KEY__DAGS, &pvhDags)  );
+	VERIFY_ERR_CHECK(  SG_sync__add_dag_samples_to_status(pCtx, pServerRepo, pvhStatus)  );
+
+	VERIFY_ERR_CHECK(  SG_vhash__get__vhash(pCtx, pvhStatus, SG_SYNC_STATUS_KEY__SAMPLES, &pvhSamples)  );
+	VERIFY_ERR_CHECK(  SG_vhash__get__varray(pCtx, pvhSamples, buf_dagnum, &pvaSamples)  );
+	VERIFY_ERR_CHECK(  SG_varray__count(pCtx, pvaSamples, &count_samples)  );
+	VERIFY_COND("samples", (count_samples > 0));
+
+	/* the server has every sample; the client has only the ones it pulled */
+	VERIFY_ERR_CHECK(  SG_sync__get_common_generation(pCtx, pServerRepo, pvhStatus, buf_dagnum, &genCommon)  );
+	VERIFY_COND("server common generation", (genCommon == genServer));
+	VERIFY_ERR_CHECK(  SG_sync__get_common_generation(pCtx, pClientRepo, pvhStatus, buf_dagnum, &genCommon)  );
+	VERIFY_COND("client common generation", (genCommon > 0) && (genCommon <= genPulled));
+
+	/* Fall through to common cleanup */
+
+fail:
+	SG_CLIENT_NULLFREE(pCtx, pClient);
+	SG_REPO_NULLFREE(pCtx, pServerRepo);
+	SG_REPO_NULLFREE(pCtx, pClientRepo);
+	SG_DAGNODE_NULLFREE(pCtx, pdn);
+	SG_VHASH_NULLFREE(pCtx, pvhStatus);
+	SG_VHASH_NULLFREE(pCtx, pvhDags);
+	SG_PATHNAME_NULLFREE(pCtx, pPathTopDir);
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_VARRAY_NULLFREE(pCtx, pvaZingMergeLog);
+	SG_VARRAY_NULLFREE(pCtx, pvaZingMergeErr);
+}
+
 MyMain()
 {
 	TEMPLATE_MAIN_START;
@@ -538,6 +644,7 @@ MyMain()
 	VERIFY_ERR_CHECK(  MyFn(test__simple)(pCtx)  );
  	VERIFY_ERR_CHECK(  MyFn(test__long_dag)(pCtx)  );
  	VERIFY_ERR_CHECK(  MyFn(test__wide_dag)(pCtx)  );
+	VERIFY_ERR_CHECK(  MyFn(test__common_generation)(pCtx)  );
 
 	// Fall through to common cleanup.
 
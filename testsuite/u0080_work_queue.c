@@ -0,0 +1,380 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <sg.h>
+#include "unittests.h"
+
+//////////////////////////////////////////////////////////////////
+// we define a little trick here to prefix all global symbols (type,
+// structures, functions) with our test name.  this allows all of
+// the tests in the suite to be #include'd into one meta-test (without
+// name collisions) when we do a GCOV run.
+
+#define MyMain()				TEST_MAIN(u0080_work_queue)
+#define MyDcl(name)				u0080_work_queue__##name
+#define MyFn(name)				u0080_work_queue__##name
+
+#define MY_NR_ITEMS			500
+#define MY_NR_THREADS		4
+#define MY_BAD_ITEM			37
+
+typedef struct
+{
+	SG_uint32 in;
+	SG_uint32 out;
+	SG_uint32 kThread;
+	SG_bool bRan;
+} MyDcl(item);
+
+typedef struct
+{
+	SG_mutex mtx;
+	SG_uint32 nrRan;
+	SG_bool bFailOne;
+} MyDcl(data);
+
+static void MyFn(cb)(SG_context* pCtx, SG_uint32 kThread, void* pVoidData, void* pVoidItem)
+{
+	MyDcl(data)* pData = (MyDcl(data)*) pVoidData;
+	MyDcl(item)* pItem = (MyDcl(item)*) pVoidItem;
+	volatile SG_uint32 spin = 0;
+
+	if (pData->bFailOne && (MY_BAD_ITEM == pItem->in))
+		SG_ERR_THROW2_RETURN(  SG_ERR_INVALIDARG, (pCtx, "item %d is bad", pItem->in)  );
+
+	// make some items slow, so the workers finish out of order.
+	// (not SG_sleep_ms(), which sleeps whole seconds on unix.)
+	if ((pItem->in % 7) == 0)
+		while (spin < 100000)
+			spin++;
+
+	pItem->out = pItem->in * 2;
+	pItem->kThread = kThread;
+	pItem->bRan = SG_TRUE;
+
+	SG_mutex__lock(&pData->mtx);
+	pData->nrRan++;
+	SG_mutex__unlock(&pData->mtx);
+}
+
+typedef struct
+{
+	SG_work_queue* pQueue;
+	MyDcl(item)* aItems;
+	SG_mutex mtx;
+	SG_uint32 nrRan;
+} MyDcl(tree);
+
+/**
+ * Item n adds items 2n+1 and 2n+2, the way a directory walk adds the
+ * subdirectories it finds.
+ */
+static void MyFn(tree_cb)(SG_context* pCtx, SG_uint32 kThread, void* pVoidData, void* pVoidItem)
+{
+	MyDcl(tree)* pTree = (MyDcl(tree)*) pVoidData;
+	MyDcl(item)* pItem = (MyDcl(item)*) pVoidItem;
+	SG_uint32 k;
+
+	SG_UNUSED(kThread);
+
+	pItem->bRan = SG_TRUE;
+	SG_mutex__lock(&pTree->mtx);
+	pTree->nrRan++;
+	SG_mutex__unlock(&pTree->mtx);
+
+	for (k = 2*pItem->in + 1; (k <= 2*pItem->in + 2) && (k < MY_NR_ITEMS); k++)
+	{
+		pTree->aItems[k].in = k;
+		SG_ERR_CHECK_RETURN(  SG_work_queue__add(pCtx, pTree->pQueue, &pTree->aItems[k])  );
+	}
+}
+
+/**
+ * Add every item and finish, keeping at most nrAhead outstanding
+ * (with COLLECT) and checking that they come back in order.
+ */
+static void MyFn(run)(SG_context* pCtx,
+					  SG_uint32 nrMaxThreads,
+					  SG_uint32 nrMaxPending,
+					  SG_work_queue_flags flags,
+					  SG_uint32 nrAhead,
+					  MyDcl(data)* pData,
+					  MyDcl(item)* aItems)
+{
+	SG_work_queue* pQueue = NULL;
+	SG_uint32 nrThreads = 0;
+	SG_uint32 iNext = 0;
+	SG_uint32 i;
+	void* pDone = NULL;
+
+	SG_ERR_CHECK(  SG_work_queue__alloc(pCtx, nrMaxThreads, nrMaxPending, flags, MyFn(cb), pData, &pQueue)  );
+	SG_ERR_CHECK(  SG_work_queue__get_thread_count(pCtx, pQueue, &nrThreads)  );
+	VERIFY_COND("thread count", (nrThreads <= nrMaxThreads) && (nrThreads != 1));
+
+	for (i=0; i<MY_NR_ITEMS; i++)
+	{
+		aItems[i].in = i;
+		SG_ERR_CHECK(  SG_work_queue__add(pCtx, pQueue, &aItems[i])  );
+
+		if (flags & SG_WORK_QUEUE_FLAGS__COLLECT)
+		{
+			while (i + 1 - iNext > nrAhead)
+			{
+				SG_ERR_CHECK(  SG_work_queue__next_done(pCtx, pQueue, &pDone)  );
+				VERIFY_COND("collected in order", pDone == &aItems[iNext]);
+				VERIFY_COND("collected item is done", aItems[iNext].bRan);
+				iNext++;
+			}
+		}
+	}
+
+	SG_ERR_CHECK(  SG_work_queue__finish(pCtx, pQueue)  );
+
+	if (flags & SG_WORK_QUEUE_FLAGS__COLLECT)
+	{
+		while (1)
+		{
+			SG_ERR_CHECK(  SG_work_queue__next_done(pCtx, pQueue, &pDone)  );
+			if (!pDone)
+				break;
+			VERIFY_COND("collected in order", pDone == &aItems[iNext]);
+			iNext++;
+		}
+		VERIFY_COND("collected everything", (MY_NR_ITEMS == iNext));
+	}
+
+	for (i=0; i<MY_NR_ITEMS; i++)
+	{
+		VERIFY_COND("item ran", aItems[i].bRan);
+		VERIFY_COND("item result", (aItems[i].out == 2 * i));
+		VERIFY_COND("item thread", (aItems[i].kThread < SG_MAX(nrThreads, 1)));
+	}
+
+	/* fall through */
+
+fail:
+	SG_WORK_QUEUE_NULLFREE(pCtx, pQueue);
+}
+
+void MyFn(test__every_item_runs)(SG_context* pCtx)
+{
+	MyDcl(data) data;
+	MyDcl(item)* aItems = NULL;
+
+	memset(&data, 0, sizeof(data));
+	SG_mutex__init(&data.mtx);
+
+	// no limit on the queue, not collected
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, aItems)  );
+	VERIFY_ERR_CHECK(  MyFn(run)(pCtx, MY_NR_THREADS, 0, SG_WORK_QUEUE_FLAGS__NONE, 0, &data, aItems)  );
+	VERIFY_COND("every item ran once", (MY_NR_ITEMS == data.nrRan));
+	SG_NULLFREE(pCtx, aItems);
+
+	// adds block while 2 items are waiting
+	data.nrRan = 0;
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, aItems)  );
+	VERIFY_ERR_CHECK(  MyFn(run)(pCtx, MY_NR_THREADS, 2, SG_WORK_QUEUE_FLAGS__NONE, 0, &data, aItems)  );
+	VERIFY_COND("every item ran once", (MY_NR_ITEMS == data.nrRan));
+
+fail:
+	SG_NULLFREE(pCtx, aItems);
+	SG_mutex__destroy(&data.mtx);
+}
+
+void MyFn(test__collect_in_order)(SG_context* pCtx)
+{
+	MyDcl(data) data;
+	MyDcl(item)* aItems = NULL;
+
+	memset(&data, 0, sizeof(data));
+	SG_mutex__init(&data.mtx);
+
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, aItems)  );
+	VERIFY_ERR_CHECK(  MyFn(run)(pCtx, MY_NR_THREADS, 3, SG_WORK_QUEUE_FLAGS__COLLECT, 16, &data, aItems)  );
+	VERIFY_COND("every item ran once", (MY_NR_ITEMS == data.nrRan));
+	SG_NULLFREE(pCtx, aItems);
+
+	// everything outstanding until the end
+	data.nrRan = 0;
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, aItems)  );
+	VERIFY_ERR_CHECK(  MyFn(run)(pCtx, MY_NR_THREADS, 0, SG_WORK_QUEUE_FLAGS__COLLECT, MY_NR_ITEMS, &data, aItems)  );
+	VERIFY_COND("every item ran once", (MY_NR_ITEMS == data.nrRan));
+
+fail:
+	SG_NULLFREE(pCtx, aItems);
+	SG_mutex__destroy(&data.mtx);
+}
+
+void MyFn(test__no_threads)(SG_context* pCtx)
+{
+	MyDcl(data) data;
+	MyDcl(item)* aItems = NULL;
+
+	memset(&data, 0, sizeof(data));
+	SG_mutex__init(&data.mtx);
+
+	// one thread is no better than the caller's, so the work is done inline
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, aItems)  );
+	VERIFY_ERR_CHECK(  MyFn(run)(pCtx, 1, 0, SG_WORK_QUEUE_FLAGS__COLLECT, 5, &data, aItems)  );
+	VERIFY_COND("every item ran once", (MY_NR_ITEMS == data.nrRan));
+
+fail:
+	SG_NULLFREE(pCtx, aItems);
+	SG_mutex__destroy(&data.mtx);
+}
+
+/**
+ * A worker's error must reach the caller with its description and
+ * the stack trace from the worker, not just the error code.
+ */
+void MyFn(test__worker_error)(SG_context* pCtx)
+{
+	MyDcl(data) data;
+	MyDcl(item)* aItems = NULL;
+	SG_work_queue_flags aFlags[2] = { SG_WORK_QUEUE_FLAGS__NONE, SG_WORK_QUEUE_FLAGS__COLLECT };
+	SG_uint32 aMaxThreads[2] = { MY_NR_THREADS, 0 };
+	SG_uint32 f, t;
+
+	memset(&data, 0, sizeof(data));
+	SG_mutex__init(&data.mtx);
+	data.bFailOne = SG_TRUE;
+
+	for (t=0; t<2; t++)
+	{
+		for (f=0; f<2; f++)
+		{
+			const char* pszDescription = NULL;
+			SG_string* pstrErr = NULL;
+
+			VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, aItems)  );
+
+			MyFn(run)(pCtx, aMaxThreads[t], 4, aFlags[f], 8, &data, aItems);
+			VERIFY_CTX_ERR_EQUALS("worker error comes back", pCtx, SG_ERR_INVALIDARG);
+
+			SG_context__err_get_description(pCtx, &pszDescription);
+			VERIFY_COND("worker error description comes back",
+						(pszDescription && (0 == strcmp(pszDescription, "item 37 is bad"))));
+
+			// the trace must start where the worker threw, not where the queue rethrew.
+			SG_context__err_to_string(pCtx, &pstrErr);
+			SG_context__err_reset(pCtx);
+			VERIFY_COND("worker stack frame comes back", pstrErr != NULL);
+			if (pstrErr)
+			{
+				const char* pszWorker = strstr(SG_string__sz(pstrErr), "u0080_work_queue.c");
+				const char* pszQueue = strstr(SG_string__sz(pstrErr), "sg_work_queue.c");
+
+				VERIFY_COND("worker stack frame comes back", (pszWorker && pszQueue && (pszWorker < pszQueue)));
+			}
+			SG_STRING_NULLFREE(pCtx, pstrErr);
+
+			VERIFY_COND("bad item did not run", !aItems[MY_BAD_ITEM].bRan);
+			SG_NULLFREE(pCtx, aItems);
+		}
+	}
+
+fail:
+	SG_NULLFREE(pCtx, aItems);
+	SG_mutex__destroy(&data.mtx);
+}
+
+/**
+ * SG_work_queue__wait() returns once the items the callback added are
+ * done too, and the queue can still be used after it.
+ */
+void MyFn(test__callback_adds)(SG_context* pCtx)
+{
+	MyDcl(tree) tree;
+	SG_uint32 aMaxThreads[2] = { MY_NR_THREADS, 0 };
+	SG_uint32 t, i;
+
+	memset(&tree, 0, sizeof(tree));
+	SG_mutex__init(&tree.mtx);
+
+	for (t=0; t<2; t++)
+	{
+		tree.nrRan = 0;
+		VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, tree.aItems)  );
+		VERIFY_ERR_CHECK(  SG_work_queue__alloc(pCtx, aMaxThreads[t], 0, SG_WORK_QUEUE_FLAGS__NONE, MyFn(tree_cb), &tree, &tree.pQueue)  );
+
+		VERIFY_ERR_CHECK(  SG_work_queue__add(pCtx, tree.pQueue, &tree.aItems[0])  );
+		VERIFY_ERR_CHECK(  SG_work_queue__wait(pCtx, tree.pQueue)  );
+		VERIFY_COND("every item ran once", (MY_NR_ITEMS == tree.nrRan));
+		for (i=0; i<MY_NR_ITEMS; i++)
+			VERIFY_COND("item ran", tree.aItems[i].bRan);
+
+		// again, on the same workers
+		VERIFY_ERR_CHECK(  SG_work_queue__add(pCtx, tree.pQueue, &tree.aItems[0])  );
+		VERIFY_ERR_CHECK(  SG_work_queue__wait(pCtx, tree.pQueue)  );
+		VERIFY_COND("every item ran twice", (2 * MY_NR_ITEMS == tree.nrRan));
+
+		VERIFY_ERR_CHECK(  SG_work_queue__finish(pCtx, tree.pQueue)  );
+		SG_WORK_QUEUE_NULLFREE(pCtx, tree.pQueue);
+		SG_NULLFREE(pCtx, tree.aItems);
+	}
+
+fail:
+	SG_WORK_QUEUE_NULLFREE(pCtx, tree.pQueue);
+	SG_NULLFREE(pCtx, tree.aItems);
+	SG_mutex__destroy(&tree.mtx);
+}
+
+/**
+ * Freeing a queue that was never finished abandons what is left.
+ */
+void MyFn(test__free_without_finish)(SG_context* pCtx)
+{
+	MyDcl(data) data;
+	MyDcl(item)* aItems = NULL;
+	SG_work_queue* pQueue = NULL;
+	SG_uint32 i;
+
+	memset(&data, 0, sizeof(data));
+	SG_mutex__init(&data.mtx);
+
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_NR_ITEMS, aItems)  );
+	VERIFY_ERR_CHECK(  SG_work_queue__alloc(pCtx, MY_NR_THREADS, 0, SG_WORK_QUEUE_FLAGS__COLLECT, MyFn(cb), &data, &pQueue)  );
+	for (i=0; i<MY_NR_ITEMS; i++)
+	{
+		aItems[i].in = i;
+		VERIFY_ERR_CHECK(  SG_work_queue__add(pCtx, pQueue, &aItems[i])  );
+	}
+	SG_WORK_QUEUE_NULLFREE(pCtx, pQueue);
+	VERIFY_COND("no more than every item ran", (data.nrRan <= MY_NR_ITEMS));
+
+fail:
+	SG_WORK_QUEUE_NULLFREE(pCtx, pQueue);
+	SG_NULLFREE(pCtx, aItems);
+	SG_mutex__destroy(&data.mtx);
+}
+
+MyMain()
+{
+	TEMPLATE_MAIN_START;
+
+	BEGIN_TEST(  MyFn(test__every_item_runs)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__collect_in_order)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__no_threads)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__worker_error)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__free_without_finish)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__callback_adds)(pCtx)  );
+
+	TEMPLATE_MAIN_END;
+}
+
+#undef MyMain
+#undef MyDcl
+#undef MyFn
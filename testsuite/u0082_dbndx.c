@@ -0,0 +1,879 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file u0082_dbndx.c
+ *
+ * @details Check that a query answered from the typed record tables
+ * gives the same answer as the same query answered from db_pairs.
+ *
+ * A crit which has "rectype == x" in its top-level && chain goes to
+ * the typed table.  Hiding that clause inside an || which says the
+ * same thing twice sends the same query down the old path, so we can
+ * run every where and sort both ways and compare the lists.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg.h>
+#include "unittests.h"
+
+//////////////////////////////////////////////////////////////////
+// we define a little trick here to prefix all global symbols (type,
+// structures, functions) with our test name.  this allows all of
+// the tests in the suite to be #include'd into one meta-test (without
+// name collisions) when we do a GCOV run.
+
+#define MyMain()				TEST_MAIN(u0082_dbndx)
+#define MyDcl(name)				u0082_dbndx__##name
+#define MyFn(name)				u0082_dbndx__##name
+
+//////////////////////////////////////////////////////////////////
+
+#define MY_NEW_CRIT		"[[\"rectype\",\"==\",\"item\"],\"&&\",%s]"
+#define MY_OLD_CRIT		"[[[\"rectype\",\"==\",\"item\"],\"||\",[\"rectype\",\"==\",\"item\"]],\"&&\",%s]"
+
+#define MY_TEMPLATE														\
+	"{"																	\
+	"  \"version\" : 1,"												\
+	"  \"rectypes\" : {"												\
+	"    \"item\" : {"													\
+	"      \"fields\" : {"												\
+	"        \"k\" : { \"datatype\" : \"int\" },"						\
+	"        \"n\" : { \"datatype\" : \"int\", \"index\" : true },"		\
+	"        \"s\" : { \"datatype\" : \"string\" },"					\
+	"        \"b\" : { \"datatype\" : \"bool\" }"						\
+	"      }"															\
+	"    },"															\
+	"    \"other\" : {"													\
+	"      \"fields\" : {"												\
+	"        \"n\" : { \"datatype\" : \"int\" }"						\
+	"      }"															\
+	"    }"																\
+	"  }"																\
+	"}"
+
+// items 0..29 go in the first changeset.  the second one deletes
+// 1..3, changes n on 4 to 100 and adds 30..39.
+#define MY_NR_ITEMS_1		30
+#define MY_NR_ITEMS_2		40
+#define MY_K_CHANGED		4
+
+// check_branches builds a trunk, one long branch off it (long enough
+// to get its own interval snapshot in the dbndx) and two short ones.
+#define MY_BR_TRUNK			70
+#define MY_BR_LONG			66
+#define MY_BR_SHORT			4
+#define MY_BR_COMMITS		(MY_BR_TRUNK + MY_BR_LONG + 2 * MY_BR_SHORT)
+
+static const char * MyDcl(aStrings)[] = { "alpha", "bravo", "charlie", "delta" };
+
+/**
+ * The expected counts are for the first and second states.  Fields are
+ * left out of some records (see set_item), so every clause on n, s and
+ * b has records which don't have the field at all.
+ */
+struct MyDcl(where)
+{
+	const char *	pszWhere;
+	SG_uint32		nrExpected[2];
+};
+
+static struct MyDcl(where) MyDcl(aWheres)[] =
+{
+	{ "[\"n\",\"<\",0]",																	{  9, 10 } },
+	{ "[\"n\",\">\",3]",																	{  9, 13 } },
+	{ "[\"n\",\"<=\",2]",																	{ 15, 18 } },
+	{ "[\"n\",\">=\",8]",																	{  2,  4 } },
+	{ "[\"n\",\"!=\",1]",																	{ 24, 30 } },
+	{ "[\"n\",\"!=\",100]",																	{ 26, 31 } },
+	{ "[\"n\",\"==\",5]",																	{  1,  2 } },
+	{ "[\"s\",\"==\",\"bravo\"]",															{  6,  7 } },
+	{ "[\"b\",\"==\",1]",																	{  5,  7 } },
+	{ "[\"s\",\"in\",[\"alpha\",\"delta\"]]",												{ 12, 15 } },
+	{ "[\"s\",\"exists\",\"\"]",															{ 24, 29 } },
+	{ "[\"zz\",\"==\",\"x\"]",																{  0,  0 } },
+	{ "[[\"n\",\">\",0],\"&&\",[\"s\",\"==\",\"charlie\"]]",								{  2,  3 } },
+	{ "[[\"n\",\"<\",0],\"||\",[\"s\",\"==\",\"alpha\"]]",									{ 13, 16 } },
+	{ "[[[\"n\",\">=\",0],\"&&\",[\"n\",\"<=\",4]],\"||\",[[\"b\",\"==\",0],\"&&\",[\"s\",\"exists\",\"\"]]]",	{ 16, 16 } },
+};
+
+static const char * MyDcl(aSorts)[] =
+{
+	"[{\"name\":\"k\",\"type\":\"numeric\"}]",
+	"[{\"name\":\"n\",\"dir\":\"desc\",\"type\":\"numeric\"},{\"name\":\"k\",\"type\":\"numeric\"}]",
+	"[{\"name\":\"s\"},{\"name\":\"b\",\"dir\":\"desc\",\"type\":\"numeric\"},{\"name\":\"k\",\"dir\":\"desc\",\"type\":\"numeric\"}]",
+	"[{\"name\":\"zz\"},{\"name\":\"k\",\"type\":\"numeric\"}]",
+};
+
+//////////////////////////////////////////////////////////////////
+
+static void MyFn(create_repo)(SG_context * pCtx, SG_repo ** ppRepo)
+{
+	SG_repo * pRepo = NULL;
+	SG_pathname * pPathnameRepoDir = NULL;
+	SG_vhash * pvhPartialDescriptor = NULL;
+	char buf_repo_id[SG_GID_BUFFER_LENGTH];
+	char buf_admin_id[SG_GID_BUFFER_LENGTH];
+	char * pszRepoImpl = NULL;
+
+	VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, buf_repo_id, sizeof(buf_repo_id))  );
+	VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, buf_admin_id, sizeof(buf_admin_id))  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC(pCtx, &pPathnameRepoDir)  );
+	VERIFY_ERR_CHECK(  SG_pathname__set__from_cwd(pCtx, pPathnameRepoDir)  );
+
+	VERIFY_ERR_CHECK(  SG_VHASH__ALLOC(pCtx, &pvhPartialDescriptor)  );
+	VERIFY_ERR_CHECK_DISCARD(  SG_localsettings__get__sz(pCtx, SG_LOCALSETTING__NEWREPO_DRIVER, NULL, &pszRepoImpl, NULL)  );
+	VERIFY_ERR_CHECK_DISCARD(  SG_vhash__add__string__sz(pCtx, pvhPartialDescriptor, SG_RIDESC_KEY__STORAGE, pszRepoImpl)  );
+	VERIFY_ERR_CHECK(  SG_vhash__add__string__sz(pCtx, pvhPartialDescriptor, SG_RIDESC_FSLOCAL__PATH_PARENT_DIR, SG_pathname__sz(pPathnameRepoDir))  );
+	VERIFY_ERR_CHECK(  SG_repo__create_repo_instance(pCtx, pvhPartialDescriptor, SG_TRUE, NULL, buf_repo_id, buf_admin_id, &pRepo)  );
+	VERIFY_ERR_CHECK(  sg_zing__init_new_repo(pCtx, pRepo)  );
+	VERIFY_ERR_CHECK(  SG_user__create(pCtx, pRepo, "debug@sourcegear.com")  );
+
+	*ppRepo = pRepo;
+	pRepo = NULL;
+
+fail:
+	SG_REPO_NULLFREE(pCtx, pRepo);
+	SG_VHASH_NULLFREE(pCtx, pvhPartialDescriptor);
+	SG_PATHNAME_NULLFREE(pCtx, pPathnameRepoDir);
+	SG_NULLFREE(pCtx, pszRepoImpl);
+}
+
+static void MyFn(set_field__int)(SG_context * pCtx, SG_zingtemplate * pzt, SG_zingrecord * prec, const char * pszRectype, const char * pszField, SG_int64 v)
+{
+	SG_zingfieldattributes * pzfa = NULL;
+
+	VERIFY_ERR_CHECK(  SG_zingtemplate__get_field_attributes(pCtx, pzt, pszRectype, pszField, &pzfa)  );
+	VERIFY_ERR_CHECK(  SG_zingrecord__set_field__int(pCtx, prec, pzfa, v)  );
+
+fail:
+	return;
+}
+
+/**
+ * k is always there.  n is missing when i%9==0, s when i%5==0, and
+ * b is only set on the even ones.
+ */
+static void MyFn(set_item)(SG_context * pCtx, SG_zingtemplate * pzt, SG_zingrecord * prec, SG_uint32 i)
+{
+	SG_zingfieldattributes * pzfa = NULL;
+
+	VERIFY_ERR_CHECK(  MyFn(set_field__int)(pCtx, pzt, prec, "item", "k", (SG_int64)i)  );
+
+	if (i % 9)
+		VERIFY_ERR_CHECK(  MyFn(set_field__int)(pCtx, pzt, prec, "item", "n", (SG_int64)((i * 7) % 13) - 4)  );
+
+	if (i % 5)
+	{
+		VERIFY_ERR_CHECK(  SG_zingtemplate__get_field_attributes(pCtx, pzt, "item", "s", &pzfa)  );
+		VERIFY_ERR_CHECK(  SG_zingrecord__set_field__string(pCtx, prec, pzfa, MyDcl(aStrings)[i % 4])  );
+	}
+
+	if ((i % 2) == 0)
+	{
+		VERIFY_ERR_CHECK(  SG_zingtemplate__get_field_attributes(pCtx, pzt, "item", "b", &pzfa)  );
+		VERIFY_ERR_CHECK(  SG_zingrecord__set_field__bool(pCtx, prec, pzfa, ((i % 3) == 0))  );
+	}
+
+fail:
+	return;
+}
+
+/**
+ * Commit a changeset in TESTING_DB.  The first one (no parent) stores
+ * the template and items [0,MY_NR_ITEMS_1) plus a few records of
+ * another rectype.  The second one does the deletes and the change
+ * and adds the rest of the items.  aRecids[i] is the recid of item i.
+ */
+static void MyFn(commit)(SG_context * pCtx, SG_repo * pRepo, const char * pszParent, char ** aRecids, char ** ppszCsid)
+{
+	SG_zingtx * pztx = NULL;
+	SG_zingtemplate * pzt = NULL;
+	SG_zingrecord * prec = NULL;
+	SG_vhash * pvhTemplate = NULL;
+	SG_changeset * pcs = NULL;
+	SG_dagnode * pdn = NULL;
+	const char * pszRecid = NULL;
+	SG_uint32 i, iFirst, iLimit;
+	SG_audit q;
+
+	VERIFY_ERR_CHECK(  SG_audit__init(pCtx, &q, pRepo, SG_AUDIT__WHEN__NOW, SG_AUDIT__WHO__FROM_SETTINGS)  );
+	VERIFY_ERR_CHECK(  SG_zing__begin_tx(pCtx, pRepo, SG_DAGNUM__TESTING__DB, q.who_szUserId, pszParent, &pztx)  );
+
+	if (pszParent)
+	{
+		VERIFY_ERR_CHECK(  SG_zingtx__add_parent(pCtx, pztx, pszParent)  );
+		VERIFY_ERR_CHECK(  SG_zingtx__get_template(pCtx, pztx, &pzt)  );
+
+		for (i=1; i<MY_K_CHANGED; i++)
+			VERIFY_ERR_CHECK(  SG_zingtx__delete_record(pCtx, pztx, aRecids[i])  );
+
+		VERIFY_ERR_CHECK(  SG_zingtx__get_record(pCtx, pztx, aRecids[MY_K_CHANGED], &prec)  );
+		VERIFY_ERR_CHECK(  MyFn(set_field__int)(pCtx, pzt, prec, "item", "n", 100)  );
+
+		iFirst = MY_NR_ITEMS_1;
+		iLimit = MY_NR_ITEMS_2;
+	}
+	else
+	{
+		VERIFY_ERR_CHECK(  SG_VHASH__ALLOC__FROM_JSON(pCtx, &pvhTemplate, MY_TEMPLATE)  );
+		VERIFY_ERR_CHECK(  SG_zingtx__store_template(pCtx, pztx, &pvhTemplate)  );
+		VERIFY_ERR_CHECK(  SG_zingtx__get_template(pCtx, pztx, &pzt)  );
+
+		for (i=0; i<3; i++)
+		{
+			VERIFY_ERR_CHECK(  SG_zingtx__create_new_record(pCtx, pztx, "other", &prec)  );
+			VERIFY_ERR_CHECK(  MyFn(set_field__int)(pCtx, pzt, prec, "other", "n", (SG_int64)i)  );
+		}
+
+		iFirst = 0;
+		iLimit = MY_NR_ITEMS_1;
+	}
+
+	for (i=iFirst; i<iLimit; i++)
+	{
+		VERIFY_ERR_CHECK(  SG_zingtx__create_new_record(pCtx, pztx, "item", &prec)  );
+		VERIFY_ERR_CHECK(  MyFn(set_item)(pCtx, pzt, prec, i)  );
+		VERIFY_ERR_CHECK(  SG_zingrecord__get_recid(pCtx, prec, &pszRecid)  );
+		VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, pszRecid, &aRecids[i])  );
+	}
+
+	VERIFY_ERR_CHECK(  SG_zing__commit_tx(pCtx, q.when_int64, &pztx, &pcs, &pdn, NULL)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__get_id(pCtx, pdn, ppszCsid)  );
+
+fail:
+	if (pztx)
+		SG_ERR_IGNORE(  SG_zing__abort_tx(pCtx, &pztx)  );
+	SG_VHASH_NULLFREE(pCtx, pvhTemplate);
+	SG_CHANGESET_NULLFREE(pCtx, pcs);
+	SG_DAGNODE_NULLFREE(pCtx, pdn);
+}
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * There is no varray-from-json, so wrap the array in a vhash.  The
+ * varray belongs to the vhash.
+ */
+static void MyFn(parse)(SG_context * pCtx, const char * pszFormat, const char * pszArg, SG_vhash ** ppvh, SG_varray ** ppva)
+{
+	SG_string * pstr = NULL;
+	SG_string * pstrJson = NULL;
+
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstr)  );
+	VERIFY_ERR_CHECK(  SG_string__sprintf(pCtx, pstr, pszFormat, pszArg)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrJson)  );
+	VERIFY_ERR_CHECK(  SG_string__sprintf(pCtx, pstrJson, "{\"a\":%s}", SG_string__sz(pstr))  );
+	VERIFY_ERR_CHECK(  SG_VHASH__ALLOC__FROM_JSON(pCtx, ppvh, SG_string__sz(pstrJson))  );
+	VERIFY_ERR_CHECK(  SG_vhash__get__varray(pCtx, *ppvh, "a", ppva)  );
+
+fail:
+	SG_STRING_NULLFREE(pCtx, pstr);
+	SG_STRING_NULLFREE(pCtx, pstrJson);
+}
+
+/**
+ * Reduce a list of sliced records to the list of their k values.
+ */
+static void MyFn(get_keys)(SG_context * pCtx, const SG_varray * pvaResults, SG_varray ** ppvaKeys)
+{
+	SG_varray * pvaKeys = NULL;
+	SG_uint32 k, count = 0;
+
+	VERIFY_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaKeys)  );
+	if (pvaResults)
+	{
+		VERIFY_ERR_CHECK(  SG_varray__count(pCtx, pvaResults, &count)  );
+		for (k=0; k<count; k++)
+		{
+			SG_vhash * pvh = NULL;
+			const char * pszK = NULL;
+
+			VERIFY_ERR_CHECK(  SG_varray__get__vhash(pCtx, pvaResults, k, &pvh)  );
+			VERIFY_ERR_CHECK(  SG_vhash__get__sz(pCtx, pvh, "k", &pszK)  );
+			VERIFY_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaKeys, pszK)  );
+		}
+	}
+
+	*ppvaKeys = pvaKeys;
+	pvaKeys = NULL;
+
+fail:
+	SG_VARRAY_NULLFREE(pCtx, pvaKeys);
+}
+
+/**
+ * Run one query and return the k of each record, in order.  With
+ * pPathNdx we open that dbndx ourselves; otherwise we go through the
+ * repo.  pszFormat is MY_NEW_CRIT or MY_OLD_CRIT.
+ */
+static void MyFn(query)(SG_context * pCtx,
+						SG_repo * pRepo,
+						const SG_pathname * pPathNdx,
+						const char * pszCsid,
+						const char * pszFormat,
+						const char * pszWhere,
+						const char * pszSort,
+						SG_varray ** ppvaKeys)
+{
+	SG_vhash * pvhCrit = NULL;
+	SG_varray * pvaCrit = NULL;
+	SG_vhash * pvhSort = NULL;
+	SG_varray * pvaSort = NULL;
+	SG_stringarray * psaFields = NULL;
+	SG_varray * pvaResults = NULL;
+	SG_repo_qresult * pqr = NULL;
+	SG_dbndx * pndx = NULL;
+	SG_dbndx_qresult * pndx_qr = NULL;
+	SG_pathname * pPath = NULL;
+	SG_uint32 count = 0;
+
+	VERIFY_ERR_CHECK(  MyFn(parse)(pCtx, pszFormat, pszWhere, &pvhCrit, &pvaCrit)  );
+	if (pszSort)
+		VERIFY_ERR_CHECK(  MyFn(parse)(pCtx, "%s", pszSort, &pvhSort, &pvaSort)  );
+
+	VERIFY_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psaFields, 1)  );
+	VERIFY_ERR_CHECK(  SG_stringarray__add(pCtx, psaFields, "k")  );
+	VERIFY_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaResults)  );
+
+	if (pPathNdx)
+	{
+		// the dbndx owns the path we give it
+		VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pPath, pPathNdx)  );
+		VERIFY_ERR_CHECK(  SG_dbndx__open(pCtx, pRepo, SG_DAGNUM__TESTING__DB, pPath, SG_TRUE, &pndx)  );
+		pPath = NULL;
+		SG_ERR_CHECK(  SG_dbndx__query(pCtx, &pndx, pszCsid, pvaCrit, pvaSort, psaFields, &pndx_qr)  );
+		if (pndx_qr)
+		{
+			VERIFY_ERR_CHECK(  SG_dbndx_qresult__get__multiple(pCtx, pndx_qr, -1, &count, pvaResults)  );
+			VERIFY_ERR_CHECK(  SG_dbndx_qresult__done(pCtx, &pndx_qr)  );
+		}
+	}
+	else
+	{
+		SG_ERR_CHECK(  SG_repo__dbndx__query(pCtx, pRepo, SG_DAGNUM__TESTING__DB, pszCsid, pvaCrit, pvaSort, psaFields, &pqr)  );
+		if (pqr)
+		{
+			VERIFY_ERR_CHECK(  SG_repo__qresult__get__multiple(pCtx, pRepo, pqr, -1, &count, pvaResults)  );
+			VERIFY_ERR_CHECK(  SG_repo__qresult__done(pCtx, pRepo, &pqr)  );
+		}
+	}
+
+	VERIFY_ERR_CHECK(  MyFn(get_keys)(pCtx, pvaResults, ppvaKeys)  );
+
+fail:
+	if (pqr)
+		SG_ERR_IGNORE(  SG_repo__qresult__done(pCtx, pRepo, &pqr)  );
+	if (pndx_qr)
+		SG_ERR_IGNORE(  SG_dbndx_qresult__done(pCtx, &pndx_qr)  );
+	SG_DBNDX_NULLFREE(pCtx, pndx);
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+	SG_VARRAY_NULLFREE(pCtx, pvaResults);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaFields);
+	SG_VHASH_NULLFREE(pCtx, pvhSort);
+	SG_VHASH_NULLFREE(pCtx, pvhCrit);
+}
+
+static void MyFn(verify_same)(SG_context * pCtx, const char * pszLabel, const SG_varray * pvaExpected, const SG_varray * pvaGot)
+{
+	SG_string * pstrExpected = NULL;
+	SG_string * pstrGot = NULL;
+	SG_bool bEqual = SG_FALSE;
+
+	VERIFY_ERR_CHECK(  SG_varray__equal(pCtx, pvaExpected, pvaGot, &bEqual)  );
+	if (!bEqual)
+	{
+		VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrExpected)  );
+		VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrGot)  );
+		VERIFY_ERR_CHECK(  SG_varray__to_json(pCtx, pvaExpected, pstrExpected)  );
+		VERIFY_ERR_CHECK(  SG_varray__to_json(pCtx, pvaGot, pstrGot)  );
+	}
+	VERIFYP_COND(pszLabel, bEqual, ("expected %s, got %s",
+									SG_string__sz(pstrExpected), SG_string__sz(pstrGot)));
+
+fail:
+	SG_STRING_NULLFREE(pCtx, pstrExpected);
+	SG_STRING_NULLFREE(pCtx, pstrGot);
+}
+
+/**
+ * Every where with every sort, both ways, in state iState.
+ */
+static void MyFn(compare_all)(SG_context * pCtx,
+							  SG_repo * pRepo,
+							  const SG_pathname * pPathNdx,
+							  const char * pszCsid,
+							  SG_uint32 iState)
+{
+	SG_varray * pvaOld = NULL;
+	SG_varray * pvaNew = NULL;
+	SG_uint32 w, s, count;
+
+	for (w=0; w<SG_NrElements(MyDcl(aWheres)); w++)
+	{
+		const char * pszWhere = MyDcl(aWheres)[w].pszWhere;
+
+		for (s=0; s<SG_NrElements(MyDcl(aSorts)); s++)
+		{
+			VERIFY_ERR_CHECK(  MyFn(query)(pCtx, pRepo, pPathNdx, pszCsid, MY_OLD_CRIT, pszWhere, MyDcl(aSorts)[s], &pvaOld)  );
+			VERIFY_ERR_CHECK(  MyFn(query)(pCtx, pRepo, pPathNdx, pszCsid, MY_NEW_CRIT, pszWhere, MyDcl(aSorts)[s], &pvaNew)  );
+
+			VERIFY_ERR_CHECK(  SG_varray__count(pCtx, pvaOld, &count)  );
+			VERIFYP_COND("compare_all", (count == MyDcl(aWheres)[w].nrExpected[iState]),
+						 ("state %d: %s: expected %d, got %d",
+						  iState, pszWhere, MyDcl(aWheres)[w].nrExpected[iState], count));
+			VERIFY_ERR_CHECK(  MyFn(verify_same)(pCtx, pszWhere, pvaOld, pvaNew)  );
+
+			SG_VARRAY_NULLFREE(pCtx, pvaOld);
+			SG_VARRAY_NULLFREE(pCtx, pvaNew);
+		}
+	}
+
+fail:
+	SG_VARRAY_NULLFREE(pCtx, pvaOld);
+	SG_VARRAY_NULLFREE(pCtx, pvaNew);
+}
+
+/**
+ * zing applies limit and skip to the sorted list from the typed table.
+ * Each page must be the matching slice of the full list from db_pairs.
+ */
+static void MyFn(check_limits)(SG_context * pCtx, SG_repo * pRepo, const char * pszCsid)
+{
+	static const SG_int32 aPages[][2] = { { 5, 0 }, { 5, 5 }, { 5, 20 }, { 1, 21 }, { 100, 3 } };
+	SG_varray * pvaAll = NULL;
+	SG_varray * pvaExpected = NULL;
+	SG_varray * pvaPage = NULL;
+	SG_varray * pvaKeys = NULL;
+	SG_stringarray * psaFields = NULL;
+	SG_uint32 p, k, count = 0;
+
+	VERIFY_ERR_CHECK(  MyFn(query)(pCtx, pRepo, NULL, pszCsid, MY_OLD_CRIT, "[\"n\",\">=\",0]",
+								   "[{\"name\":\"n\",\"dir\":\"desc\",\"type\":\"numeric\"},{\"name\":\"k\",\"dir\":\"asc\",\"type\":\"numeric\"}]",
+								   &pvaAll)  );
+	VERIFY_ERR_CHECK(  SG_varray__count(pCtx, pvaAll, &count)  );
+	VERIFYP_COND("check_limits", (count == 22), ("expected 22, got %d", count));
+
+	VERIFY_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psaFields, 1)  );
+	VERIFY_ERR_CHECK(  SG_stringarray__add(pCtx, psaFields, "k")  );
+
+	for (p=0; p<SG_NrElements(aPages); p++)
+	{
+		SG_uint32 limit = (SG_uint32)aPages[p][0];
+		SG_uint32 skip = (SG_uint32)aPages[p][1];
+
+		VERIFY_ERR_CHECK(  SG_zing__query(pCtx, pRepo, SG_DAGNUM__TESTING__DB, pszCsid, "item", "n >= 0", "n #DESC, k #ASC",
+										  aPages[p][0], aPages[p][1], psaFields, &pvaPage)  );
+		VERIFY_ERR_CHECK(  MyFn(get_keys)(pCtx, pvaPage, &pvaKeys)  );
+
+		VERIFY_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaExpected)  );
+		for (k=skip; (k < count) && (k < skip + limit); k++)
+		{
+			const char * pszK = NULL;
+
+			VERIFY_ERR_CHECK(  SG_varray__get__sz(pCtx, pvaAll, k, &pszK)  );
+			VERIFY_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaExpected, pszK)  );
+		}
+
+		VERIFY_ERR_CHECK(  MyFn(verify_same)(pCtx, "check_limits", pvaExpected, pvaKeys)  );
+
+		SG_VARRAY_NULLFREE(pCtx, pvaExpected);
+		SG_VARRAY_NULLFREE(pCtx, pvaKeys);
+		SG_VARRAY_NULLFREE(pCtx, pvaPage);
+	}
+
+fail:
+	SG_VARRAY_NULLFREE(pCtx, pvaAll);
+	SG_VARRAY_NULLFREE(pCtx, pvaExpected);
+	SG_VARRAY_NULLFREE(pCtx, pvaKeys);
+	SG_VARRAY_NULLFREE(pCtx, pvaPage);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaFields);
+}
+
+/**
+ * A bad operator, or == with something other than an int or a string,
+ * is an error on both paths rather than an empty result.
+ */
+static void MyFn(check_invalid_crit)(SG_context * pCtx, SG_repo * pRepo, const char * pszCsid)
+{
+	static const char * aBad[] = { "[\"n\",\"~\",1]", "[\"n\",\"==\",1.5]" };
+	SG_varray * pvaKeys = NULL;
+	SG_uint32 k;
+
+	for (k=0; k<SG_NrElements(aBad); k++)
+	{
+		VERIFY_ERR_CHECK_ERR_EQUALS_DISCARD(  MyFn(query)(pCtx, pRepo, NULL, pszCsid, MY_OLD_CRIT, aBad[k], NULL, &pvaKeys),
+											  SG_ERR_INVALID_DBCRITERIA  );
+		SG_VARRAY_NULLFREE(pCtx, pvaKeys);
+		VERIFY_ERR_CHECK_ERR_EQUALS_DISCARD(  MyFn(query)(pCtx, pRepo, NULL, pszCsid, MY_NEW_CRIT, aBad[k], NULL, &pvaKeys),
+											  SG_ERR_INVALID_DBCRITERIA  );
+		SG_VARRAY_NULLFREE(pCtx, pvaKeys);
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * Build a dbndx, take the typed tables out of it so it looks like one
+ * from before they existed, and check that it still answers (from
+ * db_pairs) when opened query-only and gets migrated, with the same
+ * answers, when opened for writing.
+ */
+static void MyFn(check_migration)(SG_context * pCtx, SG_repo * pRepo, const char * pszCsid1, const char * pszCsid2)
+{
+	SG_pathname * pPathNdx = NULL;
+	SG_pathname * pPath = NULL;
+	SG_dbndx * pndx = NULL;
+	SG_stringarray * psaCsids = NULL;
+	sqlite3 * psql = NULL;
+	sqlite3_stmt * pStmt = NULL;
+	SG_stringarray * psaTables = NULL;
+	SG_uint32 k, count = 0;
+	SG_int32 nrTables = 0;
+	char bufName[SG_GID_BUFFER_LENGTH];
+	int rc;
+
+	VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, bufName, sizeof(bufName))  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC(pCtx, &pPathNdx)  );
+	VERIFY_ERR_CHECK(  SG_pathname__set__from_cwd(pCtx, pPathNdx)  );
+	VERIFY_ERR_CHECK(  SG_pathname__append__from_sz(pCtx, pPathNdx, bufName)  );
+
+	VERIFY_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psaCsids, 2)  );
+	VERIFY_ERR_CHECK(  SG_stringarray__add(pCtx, psaCsids, pszCsid1)  );
+	VERIFY_ERR_CHECK(  SG_stringarray__add(pCtx, psaCsids, pszCsid2)  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pPath, pPathNdx)  );
+	VERIFY_ERR_CHECK(  SG_dbndx__open(pCtx, pRepo, SG_DAGNUM__TESTING__DB, pPath, SG_FALSE, &pndx)  );
+	pPath = NULL;
+	VERIFY_ERR_CHECK(  SG_dbndx__update__multiple(pCtx, pndx, psaCsids)  );
+	SG_DBNDX_NULLFREE(pCtx, pndx);
+
+	// drop zrt_tables, zrt_columns and every zrt_N
+
+	VERIFY_ERR_CHECK(  sg_sqlite__open__pathname(pCtx, pPathNdx, &psql)  );
+	VERIFY_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psaTables, 10)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare(pCtx, psql, &pStmt, "SELECT name FROM sqlite_master WHERE type='table' AND name LIKE 'zrt_%%'")  );
+	while ((rc = sqlite3_step(pStmt)) == SQLITE_ROW)
+		VERIFY_ERR_CHECK(  SG_stringarray__add(pCtx, psaTables, (const char *)sqlite3_column_text(pStmt, 0))  );
+	VERIFY_COND("check_migration", (rc == SQLITE_DONE));
+	VERIFY_ERR_CHECK(  sg_sqlite__finalize(pCtx, pStmt)  );
+	pStmt = NULL;
+
+	VERIFY_ERR_CHECK(  SG_stringarray__count(pCtx, psaTables, &count)  );
+	VERIFYP_COND("check_migration", (count >= 4), ("expected zrt_tables, zrt_columns and two zrt_N, got %d tables", count));
+	for (k=0; k<count; k++)
+	{
+		const char * pszTable = NULL;
+
+		VERIFY_ERR_CHECK(  SG_stringarray__get_nth(pCtx, psaTables, k, &pszTable)  );
+		VERIFY_ERR_CHECK(  sg_sqlite__exec__va(pCtx, psql, "DROP TABLE %s", pszTable)  );
+	}
+	VERIFY_ERR_CHECK(  sg_sqlite__close(pCtx, psql)  );
+	psql = NULL;
+
+	// query-only can't migrate, so this is all db_pairs.  but then
+	// so is the other half of compare_all.
+
+	VERIFY_ERR_CHECK(  MyFn(compare_all)(pCtx, pRepo, pPathNdx, pszCsid1, 0)  );
+	VERIFY_ERR_CHECK(  MyFn(compare_all)(pCtx, pRepo, pPathNdx, pszCsid2, 1)  );
+
+	// opening it for writing fills the typed tables from db_pairs
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pPath, pPathNdx)  );
+	VERIFY_ERR_CHECK(  SG_dbndx__open(pCtx, pRepo, SG_DAGNUM__TESTING__DB, pPath, SG_FALSE, &pndx)  );
+	pPath = NULL;
+	SG_DBNDX_NULLFREE(pCtx, pndx);
+
+	VERIFY_ERR_CHECK(  sg_sqlite__open__pathname(pCtx, pPathNdx, &psql)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__exec__va__int32(pCtx, psql, &nrTables, "SELECT COUNT(*) FROM zrt_tables")  );
+	VERIFYP_COND("check_migration", (nrTables == 2), ("expected 2 rectypes in zrt_tables, got %d", nrTables));
+	VERIFY_ERR_CHECK(  sg_sqlite__close(pCtx, psql)  );
+	psql = NULL;
+
+	VERIFY_ERR_CHECK(  MyFn(compare_all)(pCtx, pRepo, pPathNdx, pszCsid1, 0)  );
+	VERIFY_ERR_CHECK(  MyFn(compare_all)(pCtx, pRepo, pPathNdx, pszCsid2, 1)  );
+
+fail:
+	if (pStmt)
+		SG_ERR_IGNORE(  sg_sqlite__finalize(pCtx, pStmt)  );
+	if (psql)
+		SG_ERR_IGNORE(  sg_sqlite__close(pCtx, psql)  );
+	SG_DBNDX_NULLFREE(pCtx, pndx);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaTables);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaCsids);
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+	SG_PATHNAME_NULLFREE(pCtx, pPathNdx);
+}
+
+/**
+ * One changeset of check_branches.  Commit iNew adds the item with
+ * k = iNew and, every third commit, deletes the lowest k still in its
+ * parent.  aLive has a row of MY_BR_COMMITS flags for each commit
+ * saying which k are in it; that's the full replay we check the
+ * dbndx against.
+ */
+static void MyFn(branch_commit)(SG_context * pCtx,
+								SG_repo * pRepo,
+								SG_int32 iParent,
+								SG_uint32 iNew,
+								char ** aCsids,
+								char ** aRecids,
+								SG_bool * aLive)
+{
+	SG_zingtx * pztx = NULL;
+	SG_zingtemplate * pzt = NULL;
+	SG_zingrecord * prec = NULL;
+	SG_vhash * pvhTemplate = NULL;
+	SG_changeset * pcs = NULL;
+	SG_dagnode * pdn = NULL;
+	const char * pszRecid = NULL;
+	const char * pszParent = ((iParent < 0) ? NULL : aCsids[iParent]);
+	SG_bool * pLive = &aLive[iNew * MY_BR_COMMITS];
+	SG_uint32 k;
+	SG_audit q;
+
+	VERIFY_ERR_CHECK(  SG_audit__init(pCtx, &q, pRepo, SG_AUDIT__WHEN__NOW, SG_AUDIT__WHO__FROM_SETTINGS)  );
+	VERIFY_ERR_CHECK(  SG_zing__begin_tx(pCtx, pRepo, SG_DAGNUM__TESTING__DB, q.who_szUserId, pszParent, &pztx)  );
+
+	if (pszParent)
+	{
+		VERIFY_ERR_CHECK(  SG_zingtx__add_parent(pCtx, pztx, pszParent)  );
+		memcpy(pLive, &aLive[iParent * MY_BR_COMMITS], MY_BR_COMMITS * sizeof(SG_bool));
+
+		if ((iNew % 3) == 0)
+		{
+			for (k=0; k<MY_BR_COMMITS; k++)
+				if (pLive[k])
+					break;
+			if (k < MY_BR_COMMITS)
+			{
+				VERIFY_ERR_CHECK(  SG_zingtx__delete_record(pCtx, pztx, aRecids[k])  );
+				pLive[k] = SG_FALSE;
+			}
+		}
+	}
+	else
+	{
+		VERIFY_ERR_CHECK(  SG_VHASH__ALLOC__FROM_JSON(pCtx, &pvhTemplate, MY_TEMPLATE)  );
+		VERIFY_ERR_CHECK(  SG_zingtx__store_template(pCtx, pztx, &pvhTemplate)  );
+	}
+	VERIFY_ERR_CHECK(  SG_zingtx__get_template(pCtx, pztx, &pzt)  );
+
+	VERIFY_ERR_CHECK(  SG_zingtx__create_new_record(pCtx, pztx, "item", &prec)  );
+	VERIFY_ERR_CHECK(  MyFn(set_field__int)(pCtx, pzt, prec, "item", "k", (SG_int64)iNew)  );
+	VERIFY_ERR_CHECK(  SG_zingrecord__get_recid(pCtx, prec, &pszRecid)  );
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, pszRecid, &aRecids[iNew])  );
+	pLive[iNew] = SG_TRUE;
+
+	VERIFY_ERR_CHECK(  SG_zing__commit_tx(pCtx, q.when_int64, &pztx, &pcs, &pdn, NULL)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__get_id(pCtx, pdn, &aCsids[iNew])  );
+
+fail:
+	if (pztx)
+		SG_ERR_IGNORE(  SG_zing__abort_tx(pCtx, &pztx)  );
+	SG_VHASH_NULLFREE(pCtx, pvhTemplate);
+	SG_CHANGESET_NULLFREE(pCtx, pcs);
+	SG_DAGNODE_NULLFREE(pCtx, pdn);
+}
+
+/**
+ * The repo's dbndx is updated one changeset at a time as we commit, so
+ * its states for the branches are built from whatever snapshot is
+ * nearest, interval or leaf.  Every state must match the full replay,
+ * and must match a fresh dbndx given the whole dag in one update.
+ */
+static void MyFn(check_branches)(SG_context * pCtx)
+{
+	SG_repo * pRepo = NULL;
+	SG_pathname * pPathNdx = NULL;
+	SG_pathname * pPath = NULL;
+	SG_dbndx * pndx = NULL;
+	SG_stringarray * psaCsids = NULL;
+	SG_varray * pvaExpected = NULL;
+	SG_varray * pvaGot = NULL;
+	char * aCsids[MY_BR_COMMITS];
+	char * aRecids[MY_BR_COMMITS];
+	SG_bool * aLive = NULL;
+	SG_int32 iTrunkTip, iLongTip, iTrunkFork, iLongFork, iTip;
+	SG_uint32 nrCommits = 0;
+	SG_uint32 nrLong = 0;
+	SG_uint32 i, j, k;
+	char bufName[SG_GID_BUFFER_LENGTH];
+	char bufK[20];
+
+	memset(aCsids, 0, sizeof(aCsids));
+	memset(aRecids, 0, sizeof(aRecids));
+
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, MY_BR_COMMITS * MY_BR_COMMITS, aLive)  );
+	VERIFY_ERR_CHECK(  MyFn(create_repo)(pCtx, &pRepo)  );
+
+	// the trunk and the long branch take turns, so neither one's
+	// changesets are all together in the dbndx.
+
+	VERIFY_ERR_CHECK(  MyFn(branch_commit)(pCtx, pRepo, -1, nrCommits, aCsids, aRecids, aLive)  );
+	iTrunkTip = (SG_int32)nrCommits++;
+	iTrunkFork = -1;
+	iLongTip = -1;
+	iLongFork = -1;
+	for (i=1; i<MY_BR_TRUNK; i++)
+	{
+		VERIFY_ERR_CHECK(  MyFn(branch_commit)(pCtx, pRepo, iTrunkTip, nrCommits, aCsids, aRecids, aLive)  );
+		iTrunkTip = (SG_int32)nrCommits++;
+		if (i == 2)
+			iLongTip = iTrunkTip;
+		if (i == 40)
+			iTrunkFork = iTrunkTip;
+
+		if ((i > 2) && (nrLong < MY_BR_LONG))
+		{
+			VERIFY_ERR_CHECK(  MyFn(branch_commit)(pCtx, pRepo, iLongTip, nrCommits, aCsids, aRecids, aLive)  );
+			iLongTip = (SG_int32)nrCommits++;
+			if (++nrLong == 30)
+				iLongFork = iLongTip;
+		}
+	}
+
+	iTip = iTrunkFork;
+	for (j=0; j<MY_BR_SHORT; j++)
+	{
+		VERIFY_ERR_CHECK(  MyFn(branch_commit)(pCtx, pRepo, iTip, nrCommits, aCsids, aRecids, aLive)  );
+		iTip = (SG_int32)nrCommits++;
+	}
+	iTip = iLongFork;
+	for (j=0; j<MY_BR_SHORT; j++)
+	{
+		VERIFY_ERR_CHECK(  MyFn(branch_commit)(pCtx, pRepo, iTip, nrCommits, aCsids, aRecids, aLive)  );
+		iTip = (SG_int32)nrCommits++;
+	}
+	VERIFYP_COND("check_branches", (nrCommits == MY_BR_COMMITS), ("expected %d commits, made %d", MY_BR_COMMITS, nrCommits));
+
+	// a second dbndx which sees every changeset in one update
+
+	VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, bufName, sizeof(bufName))  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC(pCtx, &pPathNdx)  );
+	VERIFY_ERR_CHECK(  SG_pathname__set__from_cwd(pCtx, pPathNdx)  );
+	VERIFY_ERR_CHECK(  SG_pathname__append__from_sz(pCtx, pPathNdx, bufName)  );
+
+	VERIFY_ERR_CHECK(  SG_STRINGARRAY__ALLOC(pCtx, &psaCsids, nrCommits)  );
+	for (i=0; i<nrCommits; i++)
+		VERIFY_ERR_CHECK(  SG_stringarray__add(pCtx, psaCsids, aCsids[i])  );
+
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__COPY(pCtx, &pPath, pPathNdx)  );
+	VERIFY_ERR_CHECK(  SG_dbndx__open(pCtx, pRepo, SG_DAGNUM__TESTING__DB, pPath, SG_FALSE, &pndx)  );
+	pPath = NULL;
+	VERIFY_ERR_CHECK(  SG_dbndx__update__multiple(pCtx, pndx, psaCsids)  );
+	SG_DBNDX_NULLFREE(pCtx, pndx);
+
+	for (i=0; i<nrCommits; i++)
+	{
+		VERIFY_ERR_CHECK(  SG_VARRAY__ALLOC(pCtx, &pvaExpected)  );
+		for (k=0; k<MY_BR_COMMITS; k++)
+		{
+			if (aLive[i * MY_BR_COMMITS + k])
+			{
+				VERIFY_ERR_CHECK(  SG_sprintf(pCtx, bufK, sizeof(bufK), "%d", k)  );
+				VERIFY_ERR_CHECK(  SG_varray__append__string__sz(pCtx, pvaExpected, bufK)  );
+			}
+		}
+
+		VERIFY_ERR_CHECK(  MyFn(query)(pCtx, pRepo, NULL, aCsids[i], MY_NEW_CRIT, "[\"k\",\">=\",0]", MyDcl(aSorts)[0], &pvaGot)  );
+		VERIFY_ERR_CHECK(  MyFn(verify_same)(pCtx, aCsids[i], pvaExpected, pvaGot)  );
+		SG_VARRAY_NULLFREE(pCtx, pvaGot);
+
+		VERIFY_ERR_CHECK(  MyFn(query)(pCtx, pRepo, NULL, aCsids[i], MY_OLD_CRIT, "[\"k\",\">=\",0]", MyDcl(aSorts)[0], &pvaGot)  );
+		VERIFY_ERR_CHECK(  MyFn(verify_same)(pCtx, aCsids[i], pvaExpected, pvaGot)  );
+		SG_VARRAY_NULLFREE(pCtx, pvaGot);
+
+		VERIFY_ERR_CHECK(  MyFn(query)(pCtx, pRepo, pPathNdx, aCsids[i], MY_NEW_CRIT, "[\"k\",\">=\",0]", MyDcl(aSorts)[0], &pvaGot)  );
+		VERIFY_ERR_CHECK(  MyFn(verify_same)(pCtx, aCsids[i], pvaExpected, pvaGot)  );
+		SG_VARRAY_NULLFREE(pCtx, pvaGot);
+
+		SG_VARRAY_NULLFREE(pCtx, pvaExpected);
+	}
+
+fail:
+	for (i=0; i<MY_BR_COMMITS; i++)
+	{
+		SG_NULLFREE(pCtx, aCsids[i]);
+		SG_NULLFREE(pCtx, aRecids[i]);
+	}
+	SG_NULLFREE(pCtx, aLive);
+	SG_VARRAY_NULLFREE(pCtx, pvaExpected);
+	SG_VARRAY_NULLFREE(pCtx, pvaGot);
+	SG_STRINGARRAY_NULLFREE(pCtx, psaCsids);
+	SG_DBNDX_NULLFREE(pCtx, pndx);
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+	SG_PATHNAME_NULLFREE(pCtx, pPathNdx);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+}
+
+//////////////////////////////////////////////////////////////////
+
+static void MyFn(run)(SG_context * pCtx)
+{
+	SG_repo * pRepo = NULL;
+	char * aRecids[MY_NR_ITEMS_2];
+	char * pszCsid1 = NULL;
+	char * pszCsid2 = NULL;
+	SG_uint32 k;
+
+	memset(aRecids, 0, sizeof(aRecids));
+
+	VERIFY_ERR_CHECK(  MyFn(create_repo)(pCtx, &pRepo)  );
+	VERIFY_ERR_CHECK(  MyFn(commit)(pCtx, pRepo, NULL, aRecids, &pszCsid1)  );
+	VERIFY_ERR_CHECK(  MyFn(commit)(pCtx, pRepo, pszCsid1, aRecids, &pszCsid2)  );
+
+	VERIFY_ERR_CHECK(  MyFn(compare_all)(pCtx, pRepo, NULL, pszCsid1, 0)  );
+	VERIFY_ERR_CHECK(  MyFn(compare_all)(pCtx, pRepo, NULL, pszCsid2, 1)  );
+	VERIFY_ERR_CHECK(  MyFn(check_limits)(pCtx, pRepo, pszCsid2)  );
+	VERIFY_ERR_CHECK(  MyFn(check_invalid_crit)(pCtx, pRepo, pszCsid2)  );
+	VERIFY_ERR_CHECK(  MyFn(check_migration)(pCtx, pRepo, pszCsid1, pszCsid2)  );
+
+fail:
+	for (k=0; k<MY_NR_ITEMS_2; k++)
+		SG_NULLFREE(pCtx, aRecids[k]);
+	SG_NULLFREE(pCtx, pszCsid1);
+	SG_NULLFREE(pCtx, pszCsid2);
+	SG_REPO_NULLFREE(pCtx, pRepo);
+}
+
+MyMain()
+{
+	TEMPLATE_MAIN_START;
+
+	BEGIN_TEST(  MyFn(run)(pCtx)  );
+	BEGIN_TEST(  MyFn(check_branches)(pCtx)  );
+
+	TEMPLATE_MAIN_END;
+}
+
+#undef MY_NEW_CRIT
+#undef MY_OLD_CRIT
+#undef MY_TEMPLATE
+#undef MY_NR_ITEMS_1
+#undef MY_NR_ITEMS_2
+#undef MY_K_CHANGED
+#undef MY_BR_TRUNK
+#undef MY_BR_LONG
+#undef MY_BR_SHORT
+#undef MY_BR_COMMITS
+#undef MyMain
+#undef MyDcl
+#undef MyFn
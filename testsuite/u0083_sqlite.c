@@ -0,0 +1,274 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file u0083_sqlite.c
+ *
+ * @details Tests for the prepared statement cache in sg_sqlite.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg.h>
+#include "unittests.h"
+
+//////////////////////////////////////////////////////////////////
+// we define a little trick here to prefix all global symbols (type,
+// structures, functions) with our test name.  this allows all of
+// the tests in the suite to be #include'd into one meta-test (without
+// name collisions) when we do a GCOV run.
+
+#define MyMain()				TEST_MAIN(u0083_sqlite)
+#define MyDcl(name)				u0083_sqlite__##name
+#define MyFn(name)				u0083_sqlite__##name
+
+#define MY_SQL_SELECT		"SELECT ?"
+
+//////////////////////////////////////////////////////////////////
+
+/**
+ * The number of statements sqlite has prepared on the connection,
+ * whether we have them out or the cache does.
+ */
+static SG_uint32 MyFn(count_stmts)(sqlite3 * psql)
+{
+	sqlite3_stmt * pStmt = NULL;
+	SG_uint32 count = 0;
+
+	while ((pStmt = sqlite3_next_stmt(psql, pStmt)) != NULL)
+		count++;
+
+	return count;
+}
+
+static void MyFn(open_db)(SG_context * pCtx, SG_pathname ** ppPath, sqlite3 ** ppsql)
+{
+	SG_pathname * pPath = NULL;
+	char bufName[SG_GID_BUFFER_LENGTH];
+
+	VERIFY_ERR_CHECK(  SG_gid__generate(pCtx, bufName, sizeof(bufName))  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC(pCtx, &pPath)  );
+	VERIFY_ERR_CHECK(  SG_pathname__set__from_cwd(pCtx, pPath)  );
+	VERIFY_ERR_CHECK(  SG_pathname__append__from_sz(pCtx, pPath, bufName)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__create__pathname(pCtx, pPath, ppsql)  );
+
+	*ppPath = pPath;
+	pPath = NULL;
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+}
+
+/**
+ * Asking again for a released statement gets the same one back, reset
+ * and with its bindings cleared.
+ */
+static void MyFn(test__hit)(SG_context * pCtx)
+{
+	SG_pathname * pPath = NULL;
+	sqlite3 * psql = NULL;
+	sg_sqlite__stmt_cache * pCache = NULL;
+	sqlite3_stmt * pStmt = NULL;
+	sqlite3_stmt * pStmtFirst = NULL;
+
+	VERIFY_ERR_CHECK(  MyFn(open_db)(pCtx, &pPath, &psql)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pCache)  );
+
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt, MY_SQL_SELECT)  );
+	pStmtFirst = pStmt;
+	VERIFY_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 1, 7)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_ROW)  );
+	VERIFY_COND("bound value", (7 == sqlite3_column_int(pStmt, 0)));
+	// released part way through, before SQLITE_DONE
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
+	VERIFY_COND("release clears the pointer", (pStmt == NULL));
+
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt, MY_SQL_SELECT)  );
+	VERIFY_COND("second prepare is a hit", (pStmt == pStmtFirst));
+	VERIFY_COND("one statement", (1 == MyFn(count_stmts)(psql)));
+	VERIFY_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_ROW)  );
+	VERIFY_COND("bindings were cleared", (SQLITE_NULL == sqlite3_column_type(pStmt, 0)));
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
+
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pCache);
+	VERIFY_ERR_CHECK(  sg_sqlite__close(pCtx, psql)  );
+	psql = NULL;
+
+fail:
+	if (pStmt)
+		SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pCache);
+	if (psql)
+		SG_ERR_IGNORE(  sg_sqlite__close(pCtx, psql)  );
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+}
+
+/**
+ * Asking for a statement which is already out (a nested query) gets a
+ * second copy.  Once both are released, both are hits.
+ */
+static void MyFn(test__in_use)(SG_context * pCtx)
+{
+	SG_pathname * pPath = NULL;
+	sqlite3 * psql = NULL;
+	sg_sqlite__stmt_cache * pCache = NULL;
+	sqlite3_stmt * pStmt1 = NULL;
+	sqlite3_stmt * pStmt2 = NULL;
+	sqlite3_stmt * pStmtA = NULL;
+	sqlite3_stmt * pStmtB = NULL;
+
+	VERIFY_ERR_CHECK(  MyFn(open_db)(pCtx, &pPath, &psql)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pCache)  );
+
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt1, MY_SQL_SELECT)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt2, MY_SQL_SELECT)  );
+	VERIFY_COND("statement in use is not handed out twice", (pStmt1 != pStmt2));
+	VERIFY_COND("two statements", (2 == MyFn(count_stmts)(psql)));
+
+	// both can be used at once
+	VERIFY_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt1, 1, 1)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt2, 1, 2)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt1, SQLITE_ROW)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt2, SQLITE_ROW)  );
+	VERIFY_COND("first copy", (1 == sqlite3_column_int(pStmt1, 0)));
+	VERIFY_COND("second copy", (2 == sqlite3_column_int(pStmt2, 0)));
+
+	pStmtA = pStmt1;
+	pStmtB = pStmt2;
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt2)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt1)  );
+	VERIFY_COND("released statements stay prepared", (2 == MyFn(count_stmts)(psql)));
+
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt1, MY_SQL_SELECT)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt2, MY_SQL_SELECT)  );
+	VERIFY_COND("both are hits",
+				(((pStmt1 == pStmtA) && (pStmt2 == pStmtB)) || ((pStmt1 == pStmtB) && (pStmt2 == pStmtA))));
+	VERIFY_COND("still two statements", (2 == MyFn(count_stmts)(psql)));
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt1)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt2)  );
+
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pCache);
+	VERIFY_ERR_CHECK(  sg_sqlite__close(pCtx, psql)  );
+	psql = NULL;
+
+fail:
+	if (pStmt1)
+		SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt1)  );
+	if (pStmt2)
+		SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt2)  );
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pCache);
+	if (psql)
+		SG_ERR_IGNORE(  sg_sqlite__close(pCtx, psql)  );
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+}
+
+static int MyFn(commit_hook)(void * pArg)
+{
+	SG_UNUSED(pArg);
+	return 0;
+}
+
+/**
+ * Freeing the cache finalizes its statements, so the connection can
+ * be closed (sqlite3_close() would fail with SQLITE_BUSY otherwise).
+ * A commit hook set on the connection has nothing to do with the cache.
+ */
+static void MyFn(test__free)(SG_context * pCtx)
+{
+	SG_pathname * pPath = NULL;
+	sqlite3 * psql = NULL;
+	sg_sqlite__stmt_cache * pCache = NULL;
+	sqlite3_stmt * pStmt = NULL;
+	sqlite3_stmt * pStmtFirst = NULL;
+
+	VERIFY_ERR_CHECK(  MyFn(open_db)(pCtx, &pPath, &psql)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__stmt_cache__alloc(pCtx, &pCache)  );
+
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt, MY_SQL_SELECT)  );
+	pStmtFirst = pStmt;
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
+
+	(void) sqlite3_commit_hook(psql, MyFn(commit_hook), NULL);
+
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, pCache, &pStmt, MY_SQL_SELECT)  );
+	VERIFY_COND("cache survives another commit hook", (pStmt == pStmtFirst));
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
+	VERIFY_COND("cached statement", (1 == MyFn(count_stmts)(psql)));
+
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pCache);
+	VERIFY_COND("free finalizes", (0 == MyFn(count_stmts)(psql)));
+
+	VERIFY_ERR_CHECK(  sg_sqlite__close(pCtx, psql)  );
+	psql = NULL;
+
+fail:
+	if (pStmt)
+		SG_ERR_IGNORE(  sg_sqlite__release(pCtx, pCache, &pStmt)  );
+	SG_SQLITE_STMT_CACHE_NULLFREE(pCtx, pCache);
+	if (psql)
+		SG_ERR_IGNORE(  sg_sqlite__close(pCtx, psql)  );
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+}
+
+/**
+ * With no cache, the statement is prepared as usual and finalized
+ * when it is released.
+ */
+static void MyFn(test__no_cache)(SG_context * pCtx)
+{
+	SG_pathname * pPath = NULL;
+	sqlite3 * psql = NULL;
+	sqlite3_stmt * pStmt = NULL;
+
+	VERIFY_ERR_CHECK(  MyFn(open_db)(pCtx, &pPath, &psql)  );
+
+	VERIFY_ERR_CHECK(  sg_sqlite__prepare__cached(pCtx, psql, NULL, &pStmt, MY_SQL_SELECT)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__bind_int(pCtx, pStmt, 1, 7)  );
+	VERIFY_ERR_CHECK(  sg_sqlite__step(pCtx, pStmt, SQLITE_ROW)  );
+	VERIFY_COND("bound value", (7 == sqlite3_column_int(pStmt, 0)));
+	VERIFY_ERR_CHECK(  sg_sqlite__release(pCtx, NULL, &pStmt)  );
+	VERIFY_COND("release clears the pointer", (pStmt == NULL));
+	VERIFY_COND("release finalizes", (0 == MyFn(count_stmts)(psql)));
+
+	VERIFY_ERR_CHECK(  sg_sqlite__close(pCtx, psql)  );
+	psql = NULL;
+
+fail:
+	if (pStmt)
+		SG_ERR_IGNORE(  sg_sqlite__release(pCtx, NULL, &pStmt)  );
+	if (psql)
+		SG_ERR_IGNORE(  sg_sqlite__close(pCtx, psql)  );
+	SG_PATHNAME_NULLFREE(pCtx, pPath);
+}
+
+MyMain()
+{
+	TEMPLATE_MAIN_START;
+
+	BEGIN_TEST(  MyFn(test__hit)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__in_use)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__free)(pCtx)  );
+	BEGIN_TEST(  MyFn(test__no_cache)(pCtx)  );
+
+	TEMPLATE_MAIN_END;
+}
+
+#undef MY_SQL_SELECT
+#undef MyMain
+#undef MyDcl
+#undef MyFn
@@ -0,0 +1,511 @@
+/*
+Copyright 2010 SourceGear, LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ *
+ * @file u0084_uridispatch.c
+ *
+ * @details Tests for ETags and If-None-Match on the history page, for
+ * keeping the cached activity stream up to date and for the repo handle
+ * pool, made through SG_uridispatch just as the web server would.
+ *
+ */
+
+//////////////////////////////////////////////////////////////////
+
+#include <sg.h>
+#include "unittests.h"
+#include "unittests_pendingtree.h"
+
+//////////////////////////////////////////////////////////////////
+// we define a little trick here to prefix all global symbols (type,
+// structures, functions) with our test name.  this allows all of
+// the tests in the suite to be #include'd into one meta-test (without
+// name collisions) when we do a GCOV run.
+
+#define MyMain()				TEST_MAIN(u0084_uridispatch)
+#define MyDcl(name)				u0084_uridispatch__##name
+#define MyFn(name)				u0084_uridispatch__##name
+
+//////////////////////////////////////////////////////////////////
+
+static void MyFn(do_commit)(SG_context * pCtx,
+							const SG_pathname * pPathWorkingDir,
+							char ** ppszCsid)
+{
+	SG_pendingtree* pPendingTree = NULL;
+	SG_repo* pRepo = NULL;
+	SG_dagnode* pdn = NULL;
+	const char* pszCsid = NULL;
+	SG_audit q;
+
+	VERIFY_ERR_CHECK(  SG_PENDINGTREE__ALLOC(pCtx, pPathWorkingDir, SG_FALSE, &pPendingTree)  );
+	VERIFY_ERR_CHECK(  SG_pendingtree__get_repo(pCtx, pPendingTree, &pRepo)  );
+	VERIFY_ERR_CHECK(  SG_audit__init(pCtx,&q,pRepo,SG_AUDIT__WHEN__NOW, SG_AUDIT__WHO__FROM_SETTINGS)  );
+	VERIFY_ERR_CHECK(  unittests_pendingtree__commit(pCtx, pPendingTree, &q, NULL, 0, NULL, NULL, 0, NULL, 0, NULL, 0, &pdn)  );
+	VERIFY_ERR_CHECK(  SG_dagnode__get_id_ref(pCtx, pdn, &pszCsid)  );
+	VERIFY_ERR_CHECK(  SG_STRDUP(pCtx, pszCsid, ppszCsid)  );
+
+fail:
+	SG_DAGNODE_NULLFREE(pCtx, pdn);
+	SG_PENDINGTREE_NULLFREE(pCtx, pPendingTree);
+}
+
+/**
+ * GET /repos/<name>/<page> as JSON and return the status line, the
+ * ETag header (with its quotes, as sent, or empty if there wasn't one)
+ * and the body.
+ */
+static void MyFn(get_page)(SG_context * pCtx,
+						   const char * pszRepoName,
+						   const char * pszPage,
+						   const char * pszQueryString,
+						   const char * pszIfNoneMatch,
+						   SG_string * pstrStatus,
+						   SG_string * pstrETag,
+						   SG_string * pstrBody)
+{
+	SG_string * pstrUri = NULL;
+	void * pResponseHandle = NULL;
+	const char * pszStatus = NULL;
+	char ** ppHeaders = NULL;
+	SG_uint32 nHeaders = 0;
+	SG_uint32 k;
+
+	SG_ERR_CHECK(  SG_string__clear(pCtx, pstrStatus)  );
+	SG_ERR_CHECK(  SG_string__clear(pCtx, pstrETag)  );
+	SG_ERR_CHECK(  SG_string__clear(pCtx, pstrBody)  );
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrUri)  );
+	SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstrUri, "/repos/%s/%s", pszRepoName, pszPage)  );
+
+	SG_uridispatch__request(SG_string__sz(pstrUri), pszQueryString, "GET", SG_FALSE, "localhost",
+							"application/json", "u0084", NULL, NULL, pszIfNoneMatch,
+							&pResponseHandle);
+	SG_uridispatch__get_response_headers(&pResponseHandle, &pszStatus, &ppHeaders, &nHeaders);
+
+	// the status is one of the SG_HTTP_STATUS_ constants, so it
+	// outlives the response handle.
+	SG_ERR_CHECK(  SG_string__set__sz(pCtx, pstrStatus, pszStatus)  );
+	for (k=0; k<nHeaders; k++)
+	{
+		if (strncmp(ppHeaders[k], "ETag: ", 6) == 0)
+			SG_ERR_CHECK(  SG_string__set__sz(pCtx, pstrETag, ppHeaders[k] + 6)  );
+	}
+
+	while (pResponseHandle)
+	{
+		SG_byte buf[1024];
+		SG_uint32 lenGot = 0;
+
+		SG_uridispatch__chunk_response_body(&pResponseHandle, buf, sizeof(buf), &lenGot);
+		if (lenGot > 0)
+			SG_ERR_CHECK(  SG_string__append__buf_len(pCtx, pstrBody, buf, lenGot)  );
+	}
+
+fail:
+	if (pResponseHandle)
+		SG_uridispatch__abort_response(&pResponseHandle);
+	if (ppHeaders)
+	{
+		for (k=0; k<nHeaders; k++)
+			SG_free__no_ctx(ppHeaders[k]);
+		SG_free__no_ctx(ppHeaders);
+	}
+	SG_STRING_NULLFREE(pCtx, pstrUri);
+}
+
+static void MyFn(get_history)(SG_context * pCtx,
+							  const char * pszRepoName,
+							  const char * pszQueryString,
+							  const char * pszIfNoneMatch,
+							  SG_string * pstrStatus,
+							  SG_string * pstrETag,
+							  SG_string * pstrBody)
+{
+	SG_ERR_CHECK_RETURN(  MyFn(get_page)(pCtx, pszRepoName, "history", pszQueryString, pszIfNoneMatch, pstrStatus, pstrETag, pstrBody)  );
+}
+
+static void MyFn(get_pool_stat)(SG_context * pCtx, const char * pszKey, SG_int64 * pValue)
+{
+	SG_vhash * pvhStats = NULL;
+
+	SG_ERR_CHECK(  SG_uridispatch_debug__get_repo_pool_stats(pCtx, &pvhStats)  );
+	SG_ERR_CHECK(  SG_vhash__get__int64(pCtx, pvhStats, pszKey, pValue)  );
+
+fail:
+	SG_VHASH_NULLFREE(pCtx, pvhStats);
+}
+
+/**
+ * Start a fragball POST to /repos/<name>/sync with a message body that
+ * we never send, so the request holds on to its repo handle until it is
+ * aborted.  If the request is turned down right away, return the status
+ * instead of a request handle.
+ */
+static void MyFn(begin_sync_post)(SG_context * pCtx,
+								  const char * pszRepoName,
+								  void ** ppRequestHandle,
+								  SG_string * pstrStatus)
+{
+	SG_string * pstrUri = NULL;
+	void * pResponseHandle = NULL;
+	const char * pszStatus = NULL;
+	char ** ppHeaders = NULL;
+	SG_uint32 nHeaders = 0;
+	SG_uint32 k;
+
+	SG_ERR_CHECK(  SG_string__clear(pCtx, pstrStatus)  );
+
+	SG_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrUri)  );
+	SG_ERR_CHECK(  SG_string__sprintf(pCtx, pstrUri, "/repos/%s/sync", pszRepoName)  );
+
+	SG_uridispatch__begin_request(SG_string__sz(pstrUri), NULL, "POST", SG_FALSE, "localhost",
+								  "application/fragball", "u0084", 10, NULL, NULL, NULL,
+								  ppRequestHandle, &pResponseHandle);
+	if (pResponseHandle)
+	{
+		SG_uridispatch__get_response_headers(&pResponseHandle, &pszStatus, &ppHeaders, &nHeaders);
+		SG_ERR_CHECK(  SG_string__set__sz(pCtx, pstrStatus, pszStatus)  );
+	}
+
+fail:
+	if (pResponseHandle)
+		SG_uridispatch__abort_response(&pResponseHandle);
+	if (ppHeaders)
+	{
+		for (k=0; k<nHeaders; k++)
+			SG_free__no_ctx(ppHeaders[k]);
+		SG_free__no_ctx(ppHeaders);
+	}
+	SG_STRING_NULLFREE(pCtx, pstrUri);
+}
+
+//////////////////////////////////////////////////////////////////
+
+static void MyFn(test__history_etag)(SG_context * pCtx, SG_pathname * pPathTopDir)
+{
+	char bufName[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname * pPathWorkingDir = NULL;
+	SG_string * pstrStatus = NULL;
+	SG_string * pstrETag = NULL;
+	SG_string * pstrBody = NULL;
+	SG_string * pstrETag1 = NULL;
+	SG_string * pstrBody1 = NULL;
+	SG_string * pstrIfNoneMatch = NULL;
+	char * pszCsid1 = NULL;
+	char * pszCsid2 = NULL;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, bufName)  );
+	INFO2("working directory",SG_pathname__sz(pPathWorkingDir));
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__cd__pathname(pCtx, pPathWorkingDir)  );
+
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx, bufName, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathWorkingDir, "f1", 20)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  MyFn(do_commit)(pCtx, pPathWorkingDir, &pszCsid1)  );
+
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrStatus)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrETag)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrBody)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrIfNoneMatch)  );
+
+	// No If-None-Match: the whole page, with an ETag.
+
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, NULL, pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("first get", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("first get etag", (SG_string__length_in_bytes(pstrETag) > 2));
+	VERIFY_COND("first get body", (strstr(SG_string__sz(pstrBody), pszCsid1) != NULL));
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC__COPY(pCtx, &pstrETag1, pstrETag)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC__COPY(pCtx, &pstrBody1, pstrBody)  );
+
+	// A matching tag gets a 304 with no body.
+
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, SG_string__sz(pstrETag1), pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("match", (strcmp(SG_string__sz(pstrStatus), "304 Not Modified") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("match etag", (strcmp(SG_string__sz(pstrETag), SG_string__sz(pstrETag1)) == 0));
+	VERIFY_COND("match body", (SG_string__length_in_bytes(pstrBody) == 0));
+
+	// So does a list with the tag in it somewhere, weak or not.
+
+	VERIFY_ERR_CHECK(  SG_string__sprintf(pCtx, pstrIfNoneMatch, "\"bogus\", W/%s", SG_string__sz(pstrETag1))  );
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, SG_string__sz(pstrIfNoneMatch), pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("match list", (strcmp(SG_string__sz(pstrStatus), "304 Not Modified") == 0), ("status %s", SG_string__sz(pstrStatus)));
+
+	// A tag that doesn't match gets the whole page again (from the
+	// response cache this time), the same as the first one.
+
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, "\"bogus\"", pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("mismatch", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("mismatch etag", (strcmp(SG_string__sz(pstrETag), SG_string__sz(pstrETag1)) == 0));
+	VERIFY_COND("mismatch body", (strcmp(SG_string__sz(pstrBody), SG_string__sz(pstrBody1)) == 0));
+
+	// A different query is a different page, so the tag doesn't carry over.
+
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, "max=1", SG_string__sz(pstrETag1), pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("other query", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("other query etag", (strcmp(SG_string__sz(pstrETag), SG_string__sz(pstrETag1)) != 0));
+
+	// Once the repo changes, the old tag is stale: the page is recomputed
+	// rather than taken from the cache, and gets a new tag.
+
+	VERIFY_ERR_CHECK(  _ut_pt__append_to_file__numbers(pCtx, pPathWorkingDir, "f1", 4)  );
+	VERIFY_ERR_CHECK(  MyFn(do_commit)(pCtx, pPathWorkingDir, &pszCsid2)  );
+
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, SG_string__sz(pstrETag1), pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("changed", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("changed etag", (SG_string__length_in_bytes(pstrETag) > 2));
+	VERIFY_COND("changed etag", (strcmp(SG_string__sz(pstrETag), SG_string__sz(pstrETag1)) != 0));
+	VERIFY_COND("changed body", (strstr(SG_string__sz(pstrBody), pszCsid2) != NULL));
+	VERIFY_COND("changed body", (strstr(SG_string__sz(pstrBody), pszCsid1) != NULL));
+
+	VERIFY_ERR_CHECK(  SG_string__set__string(pCtx, pstrIfNoneMatch, pstrETag)  );
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, SG_string__sz(pstrIfNoneMatch), pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("changed match", (strcmp(SG_string__sz(pstrStatus), "304 Not Modified") == 0), ("status %s", SG_string__sz(pstrStatus)));
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_STRING_NULLFREE(pCtx, pstrStatus);
+	SG_STRING_NULLFREE(pCtx, pstrETag);
+	SG_STRING_NULLFREE(pCtx, pstrBody);
+	SG_STRING_NULLFREE(pCtx, pstrETag1);
+	SG_STRING_NULLFREE(pCtx, pstrBody1);
+	SG_STRING_NULLFREE(pCtx, pstrIfNoneMatch);
+	SG_NULLFREE(pCtx, pszCsid1);
+	SG_NULLFREE(pCtx, pszCsid2);
+}
+
+/**
+ * The activity stream is remembered in the response cache along with the
+ * leaves it was computed from.  After new commits, only the changesets
+ * between the new leaves and the old ones are looked up; the rest of the
+ * history comes from the cache entry.
+ */
+static void MyFn(test__activity_incremental)(SG_context * pCtx, SG_pathname * pPathTopDir)
+{
+	char bufName[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname * pPathWorkingDir = NULL;
+	SG_string * pstrStatus = NULL;
+	SG_string * pstrETag = NULL;
+	SG_string * pstrBody = NULL;
+	SG_string * pstrETag1 = NULL;
+	char * pszCsid1 = NULL;
+	char * pszCsid2 = NULL;
+	char * pszCsid3 = NULL;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, bufName)  );
+	INFO2("working directory",SG_pathname__sz(pPathWorkingDir));
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__cd__pathname(pCtx, pPathWorkingDir)  );
+
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx, bufName, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathWorkingDir, "f1", 20)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  MyFn(do_commit)(pCtx, pPathWorkingDir, &pszCsid1)  );
+
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrStatus)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrETag)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrBody)  );
+
+	// The first request computes the whole stream and caches it.
+
+	VERIFY_ERR_CHECK(  MyFn(get_page)(pCtx, bufName, "activity", NULL, NULL, pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("first get", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("first get etag", (SG_string__length_in_bytes(pstrETag) > 2));
+	VERIFYP_COND("first get body", (strstr(SG_string__sz(pstrBody), pszCsid1) != NULL), ("body %s", SG_string__sz(pstrBody)));
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC__COPY(pCtx, &pstrETag1, pstrETag)  );
+
+	// Two commits on top of the leaf the cache entry was computed from.
+	// The next request has to walk back from the new leaf through both
+	// of them to the old one.
+
+	VERIFY_ERR_CHECK(  _ut_pt__append_to_file__numbers(pCtx, pPathWorkingDir, "f1", 4)  );
+	VERIFY_ERR_CHECK(  MyFn(do_commit)(pCtx, pPathWorkingDir, &pszCsid2)  );
+	VERIFY_ERR_CHECK(  _ut_pt__append_to_file__numbers(pCtx, pPathWorkingDir, "f1", 4)  );
+	VERIFY_ERR_CHECK(  MyFn(do_commit)(pCtx, pPathWorkingDir, &pszCsid3)  );
+
+	VERIFY_ERR_CHECK(  MyFn(get_page)(pCtx, bufName, "activity", NULL, SG_string__sz(pstrETag1), pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("after commits", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("after commits etag", (strcmp(SG_string__sz(pstrETag), SG_string__sz(pstrETag1)) != 0));
+	VERIFYP_COND("newest commit", (strstr(SG_string__sz(pstrBody), pszCsid3) != NULL), ("body %s", SG_string__sz(pstrBody)));
+	VERIFYP_COND("commit in between", (strstr(SG_string__sz(pstrBody), pszCsid2) != NULL), ("body %s", SG_string__sz(pstrBody)));
+	VERIFYP_COND("commit from the cache", (strstr(SG_string__sz(pstrBody), pszCsid1) != NULL), ("body %s", SG_string__sz(pstrBody)));
+
+	// With nothing new, the updated entry is served as is.
+
+	VERIFY_ERR_CHECK(  SG_string__set__string(pCtx, pstrETag1, pstrETag)  );
+	VERIFY_ERR_CHECK(  MyFn(get_page)(pCtx, bufName, "activity", NULL, "\"bogus\"", pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("unchanged", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_COND("unchanged etag", (strcmp(SG_string__sz(pstrETag), SG_string__sz(pstrETag1)) == 0));
+	VERIFYP_COND("unchanged body", (strstr(SG_string__sz(pstrBody), pszCsid3) != NULL), ("body %s", SG_string__sz(pstrBody)));
+	VERIFYP_COND("unchanged body", (strstr(SG_string__sz(pstrBody), pszCsid1) != NULL), ("body %s", SG_string__sz(pstrBody)));
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_STRING_NULLFREE(pCtx, pstrStatus);
+	SG_STRING_NULLFREE(pCtx, pstrETag);
+	SG_STRING_NULLFREE(pCtx, pstrBody);
+	SG_STRING_NULLFREE(pCtx, pstrETag1);
+	SG_NULLFREE(pCtx, pszCsid1);
+	SG_NULLFREE(pCtx, pszCsid2);
+	SG_NULLFREE(pCtx, pszCsid3);
+}
+
+/**
+ * Handles go back in the pool after a request that worked, are closed
+ * after one that was aborted, and only so many can be out at once.
+ */
+static void MyFn(test__repo_pool)(SG_context * pCtx, SG_pathname * pPathTopDir)
+{
+	char bufName[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname * pPathWorkingDir = NULL;
+	SG_string * pstrStatus = NULL;
+	SG_string * pstrETag = NULL;
+	SG_string * pstrBody = NULL;
+	char * pszCsid = NULL;
+	void * pRequestHandle = NULL;
+	void ** apRequestHandles = NULL;
+	SG_int64 hits = 0, misses = 0, discarded = 0, busy = 0, idle = 0;
+	SG_int64 i64 = 0;
+	SG_int64 maxBorrowed = 0;
+	SG_uint32 countRequests = 0;
+	SG_uint32 k;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2(pCtx, bufName, sizeof(bufName), 32)  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__PATHNAME_SZ(pCtx, &pPathWorkingDir, pPathTopDir, bufName)  );
+	INFO2("working directory",SG_pathname__sz(pPathWorkingDir));
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__cd__pathname(pCtx, pPathWorkingDir)  );
+
+	VERIFY_ERR_CHECK(  _ut_pt__new_repo(pCtx, bufName, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  _ut_pt__create_file__numbers(pCtx, pPathWorkingDir, "f1", 20)  );
+	VERIFY_ERR_CHECK(  _ut_pt__addremove(pCtx, pPathWorkingDir)  );
+	VERIFY_ERR_CHECK(  MyFn(do_commit)(pCtx, pPathWorkingDir, &pszCsid)  );
+
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrStatus)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrETag)  );
+	VERIFY_ERR_CHECK(  SG_STRING__ALLOC(pCtx, &pstrBody)  );
+
+	// After a request that worked, its handle is back in the pool...
+
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, NULL, pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("first get", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "borrowed", &i64)  );
+	VERIFYP_COND("borrowed after get", (i64 == 0), ("borrowed %d", (SG_int32)i64));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "idle", &idle)  );
+	VERIFY_COND("idle after get", (idle > 0));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "hits", &hits)  );
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "misses", &misses)  );
+
+	// ...and the next request for the same repo gets it.
+
+	VERIFY_ERR_CHECK(  MyFn(get_history)(pCtx, bufName, NULL, NULL, pstrStatus, pstrETag, pstrBody)  );
+	VERIFYP_COND("second get", (strcmp(SG_string__sz(pstrStatus), "200 OK") == 0), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "hits", &i64)  );
+	VERIFYP_COND("hit", (i64 > hits), ("hits %d, before %d", (SG_int32)i64, (SG_int32)hits));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "misses", &i64)  );
+	VERIFYP_COND("no miss", (i64 == misses), ("misses %d, before %d", (SG_int32)i64, (SG_int32)misses));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "idle", &idle)  );
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "discarded", &discarded)  );
+
+	// A request that is aborted doesn't give its handle back.
+
+	VERIFY_ERR_CHECK(  MyFn(begin_sync_post)(pCtx, bufName, &pRequestHandle, pstrStatus)  );
+	VERIFYP_COND_FAIL("begin post", (pRequestHandle != NULL), ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "borrowed", &i64)  );
+	VERIFYP_COND("borrowed during post", (i64 == 1), ("borrowed %d", (SG_int32)i64));
+
+	SG_uridispatch__abort_request(&pRequestHandle);
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "borrowed", &i64)  );
+	VERIFYP_COND("borrowed after abort", (i64 == 0), ("borrowed %d", (SG_int32)i64));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "discarded", &i64)  );
+	VERIFYP_COND("discarded after abort", (i64 == discarded + 1), ("discarded %d, before %d", (SG_int32)i64, (SG_int32)discarded));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "idle", &i64)  );
+	VERIFYP_COND("idle after abort", (i64 == idle - 1), ("idle %d, before %d", (SG_int32)i64, (SG_int32)idle));
+
+	// Only so many handles can be out at once; past that the server is busy.
+
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "max_borrowed", &maxBorrowed)  );
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "busy", &busy)  );
+	VERIFY_ERR_CHECK(  SG_allocN(pCtx, (SG_uint32)maxBorrowed, apRequestHandles)  );
+	for (countRequests=0; countRequests<(SG_uint32)maxBorrowed; countRequests++)
+	{
+		VERIFY_ERR_CHECK(  MyFn(begin_sync_post)(pCtx, bufName, &apRequestHandles[countRequests], pstrStatus)  );
+		VERIFYP_COND_FAIL("begin post", (apRequestHandles[countRequests] != NULL),
+						  ("request %d, status %s", countRequests, SG_string__sz(pstrStatus)));
+	}
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "borrowed", &i64)  );
+	VERIFYP_COND("borrowed at cap", (i64 == maxBorrowed), ("borrowed %d", (SG_int32)i64));
+
+	VERIFY_ERR_CHECK(  MyFn(begin_sync_post)(pCtx, bufName, &pRequestHandle, pstrStatus)  );
+	VERIFY_COND("over cap", (pRequestHandle == NULL));
+	VERIFYP_COND("over cap status", (strcmp(SG_string__sz(pstrStatus), "503 Service Unavailable") == 0),
+				 ("status %s", SG_string__sz(pstrStatus)));
+	VERIFY_ERR_CHECK(  MyFn(get_pool_stat)(pCtx, "busy", &i64)  );
+	VERIFYP_COND("busy", (i64 == busy + 1), ("busy %d, before %d", (SG_int32)i64, (SG_int32)busy));
+
+fail:
+	if (pRequestHandle)
+		SG_uridispatch__abort_request(&pRequestHandle);
+	if (apRequestHandles)
+	{
+		for (k=0; k<countRequests; k++)
+			SG_uridispatch__abort_request(&apRequestHandles[k]);
+		SG_NULLFREE(pCtx, apRequestHandles);
+	}
+	if (!SG_context__has_err(pCtx))
+	{
+		VERIFY_ERR_CHECK_DISCARD(  MyFn(get_pool_stat)(pCtx, "borrowed", &i64)  );
+		VERIFYP_COND("borrowed at end", (i64 == 0), ("borrowed %d", (SG_int32)i64));
+	}
+	SG_PATHNAME_NULLFREE(pCtx, pPathWorkingDir);
+	SG_STRING_NULLFREE(pCtx, pstrStatus);
+	SG_STRING_NULLFREE(pCtx, pstrETag);
+	SG_STRING_NULLFREE(pCtx, pstrBody);
+	SG_NULLFREE(pCtx, pszCsid);
+}
+
+//////////////////////////////////////////////////////////////////
+
+TEST_MAIN(u0084_uridispatch)
+{
+	char bufTopDir[SG_TID_MAX_BUFFER_LENGTH];
+	SG_pathname* pPathTopDir = NULL;
+
+	TEMPLATE_MAIN_START;
+
+	VERIFY_ERR_CHECK(  SG_tid__generate2__suffix(pCtx, bufTopDir, sizeof(bufTopDir), 32, "u0084")  );
+	VERIFY_ERR_CHECK(  SG_PATHNAME__ALLOC__SZ(pCtx, &pPathTopDir,bufTopDir)  );
+	VERIFY_ERR_CHECK(  SG_fsobj__mkdir__pathname(pCtx, pPathTopDir)  );
+
+	BEGIN_TEST(  MyFn(test__history_etag)(pCtx, pPathTopDir)  );
+	BEGIN_TEST(  MyFn(test__activity_incremental)(pCtx, pPathTopDir)  );
+	BEGIN_TEST(  MyFn(test__repo_pool)(pCtx, pPathTopDir)  );
+
+	/* TODO rm -rf the top dir */
+
+fail:
+	SG_PATHNAME_NULLFREE(pCtx, pPathTopDir);
+
+	TEMPLATE_MAIN_END;
+}
+
+#undef MyMain
+#undef MyDcl
+#undef MyFn